@@ -21,15 +21,18 @@ import com.google.caliper.Runner;
 import com.google.caliper.SimpleBenchmark;
 import java.io.ByteArrayInputStream;
 import java.io.ByteArrayOutputStream;
+import java.io.File;
 import java.io.FileInputStream;
 import java.io.IOException;
 import java.lang.reflect.Constructor;
+import java.nio.ByteBuffer;
 import java.util.Arrays;
 import java.util.List;
 import javax.xml.parsers.DocumentBuilder;
 import javax.xml.parsers.DocumentBuilderFactory;
 import javax.xml.parsers.SAXParser;
 import javax.xml.parsers.SAXParserFactory;
+import org.apache.harmony.xml.ExpatReader;
 import org.w3c.dom.Document;
 import org.w3c.dom.Node;
 import org.xml.sax.Attributes;
@@ -41,6 +44,7 @@ public class XmlParseBenchmark extends SimpleBenchmark {
 
     @Param String xmlFile;
     ByteArrayInputStream inputStream;
+    ByteBuffer directBuffer;
 
     static List<String> xmlFileValues = Arrays.asList(
             "/etc/apns-conf.xml",
@@ -58,6 +62,9 @@ public class XmlParseBenchmark extends SimpleBenchmark {
         byte[] xmlBytes = getXmlBytes();
         inputStream = new ByteArrayInputStream(xmlBytes);
         inputStream.mark(xmlBytes.length);
+        directBuffer = ByteBuffer.allocateDirect(xmlBytes.length);
+        directBuffer.put(xmlBytes);
+        directBuffer.flip();
 
         SAXParserFactory saxParserFactory = SAXParserFactory.newInstance();
         saxParser = saxParserFactory.newSAXParser();
@@ -93,6 +100,31 @@ public class XmlParseBenchmark extends SimpleBenchmark {
         return elementCount;
     }
 
+    public int timeSaxDirectBuffer(int reps) throws IOException, SAXException {
+        int elementCount = 0;
+        for (int i = 0; i < reps; i++) {
+            ExpatReader reader = new ExpatReader();
+            ElementCounterSaxHandler elementCounterSaxHandler = new ElementCounterSaxHandler();
+            reader.setContentHandler(elementCounterSaxHandler);
+            reader.parse(directBuffer, null);
+            elementCount += elementCounterSaxHandler.elementCount;
+        }
+        return elementCount;
+    }
+
+    public int timeSaxMappedFile(int reps) throws IOException, SAXException {
+        int elementCount = 0;
+        File file = new File(xmlFile);
+        for (int i = 0; i < reps; i++) {
+            ExpatReader reader = new ExpatReader();
+            ElementCounterSaxHandler elementCounterSaxHandler = new ElementCounterSaxHandler();
+            reader.setContentHandler(elementCounterSaxHandler);
+            reader.parse(file, null);
+            elementCount += elementCounterSaxHandler.elementCount;
+        }
+        return elementCount;
+    }
+
     private static class ElementCounterSaxHandler extends DefaultHandler {
         int elementCount = 0;
         @Override public void startElement(String uri, String localName,
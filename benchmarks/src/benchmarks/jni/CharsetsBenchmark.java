@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package benchmarks.jni;
+
+import com.google.caliper.Param;
+import com.google.caliper.SimpleBenchmark;
+import java.nio.charset.Charsets;
+
+/**
+ * Measures the native transcoding kernels behind String's fast paths for ASCII, ISO-8859-1 and
+ * UTF-8, called directly so the Charset lookup isn't part of the measurement.
+ */
+public class CharsetsBenchmark extends SimpleBenchmark {
+    @Param({ "1", "16", "256", "4096", "65536" })
+    private int length;
+
+    /** Whether the text is all ASCII, or mixes in two- and three-byte UTF-8 sequences. */
+    @Param({ "false", "true" })
+    private boolean nonAscii;
+
+    private char[] chars;
+    private byte[] asciiBytes;
+    private char[] decoded;
+
+    @Override protected void setUp() throws Exception {
+        chars = new char[length];
+        for (int i = 0; i < length; ++i) {
+            if (nonAscii && i % 4 == 0) {
+                // U+00E9, U+10E9 and U+20E9 in turn: two- and three-byte UTF-8 sequences.
+                chars[i] = (char) (0xe9 + (i % 3) * 0x1000);
+            } else {
+                chars[i] = (char) ('a' + (i % 26));
+            }
+        }
+        asciiBytes = Charsets.toAsciiBytes(chars, 0, length);
+        decoded = new char[length];
+    }
+
+    public void time_toUtf8Bytes(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            Charsets.toUtf8Bytes(chars, 0, length);
+        }
+    }
+
+    public void time_utf8Length(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            Charsets.utf8Length(chars, 0, length);
+        }
+    }
+
+    public void time_toIsoLatin1Bytes(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            Charsets.toIsoLatin1Bytes(chars, 0, length);
+        }
+    }
+
+    public void time_asciiBytesToChars(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            Charsets.asciiBytesToChars(asciiBytes, 0, length, decoded);
+        }
+    }
+}
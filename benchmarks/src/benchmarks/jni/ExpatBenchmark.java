@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package benchmarks.jni;
+
+import com.google.caliper.Param;
+import com.google.caliper.SimpleBenchmark;
+import java.io.ByteArrayInputStream;
+import java.nio.ByteBuffer;
+import org.apache.harmony.xml.ExpatReader;
+import org.xml.sax.InputSource;
+import org.xml.sax.helpers.DefaultHandler;
+
+/**
+ * Measures Expat parsing and the callbacks it makes into Java per element, which is where the
+ * parser interns element and attribute names.
+ */
+public class ExpatBenchmark extends SimpleBenchmark {
+    @Param({ "16", "1024", "65536" })
+    private int elementCount;
+
+    /** How many different element and attribute names the document uses. */
+    @Param({ "1", "64" })
+    private int distinctNames;
+
+    private byte[] document;
+    private ByteBuffer directDocument;
+    private ExpatReader reader;
+
+    @Override protected void setUp() throws Exception {
+        StringBuilder xml = new StringBuilder("<root>");
+        for (int i = 0; i < elementCount; ++i) {
+            int name = i % distinctNames;
+            xml.append("<element").append(name)
+                    .append(" attribute").append(name).append("='").append(i).append("'/>");
+        }
+        xml.append("</root>");
+        document = xml.toString().getBytes("UTF-8");
+        directDocument = ByteBuffer.allocateDirect(document.length);
+        directDocument.put(document).flip();
+        reader = new ExpatReader();
+        reader.setContentHandler(new DefaultHandler());
+    }
+
+    public void time_parseStream(int reps) throws Exception {
+        for (int i = 0; i < reps; ++i) {
+            reader.parse(new InputSource(new ByteArrayInputStream(document)));
+        }
+    }
+
+    public void time_parseDirectBuffer(int reps) throws Exception {
+        for (int i = 0; i < reps; ++i) {
+            reader.parse(directDocument, "UTF-8");
+        }
+    }
+}
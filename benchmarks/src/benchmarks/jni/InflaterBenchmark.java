@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package benchmarks.jni;
+
+import com.google.caliper.Param;
+import com.google.caliper.SimpleBenchmark;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.InputStream;
+import java.util.Random;
+import java.util.zip.Deflater;
+import java.util.zip.Inflater;
+import java.util.zip.ZipEntry;
+import java.util.zip.ZipFile;
+import java.util.zip.ZipOutputStream;
+
+/**
+ * Measures zlib inflation through both of Inflater's inputs: a byte[] passed to setInput, and
+ * the file descriptor ZipFile hands to setFileInputImpl so that native code reads the
+ * compressed bytes itself.
+ */
+public class InflaterBenchmark extends SimpleBenchmark {
+    @Param({ "1024", "65536", "1048576" })
+    private int size;
+
+    private byte[] compressed;
+    private int compressedLength;
+    private byte[] output;
+    private File zip;
+    private ZipFile zipFile;
+    private ZipEntry entry;
+
+    @Override protected void setUp() throws Exception {
+        // Text-like data, which compresses about as well as class files and resources do.
+        byte[] data = new byte[size];
+        Random random = new Random(0);
+        for (int i = 0; i < size; ++i) {
+            data[i] = (byte) ('a' + random.nextInt(8));
+        }
+
+        Deflater deflater = new Deflater();
+        deflater.setInput(data);
+        deflater.finish();
+        compressed = new byte[size + 1024];
+        compressedLength = deflater.deflate(compressed);
+        deflater.end();
+        output = new byte[size];
+
+        zip = File.createTempFile("InflaterBenchmark", ".zip");
+        ZipOutputStream out = new ZipOutputStream(new FileOutputStream(zip));
+        out.putNextEntry(new ZipEntry("data"));
+        out.write(data);
+        out.closeEntry();
+        out.close();
+        zipFile = new ZipFile(zip);
+        entry = zipFile.getEntry("data");
+    }
+
+    @Override protected void tearDown() throws Exception {
+        zipFile.close();
+        zip.delete();
+    }
+
+    public void time_setInput(int reps) throws Exception {
+        Inflater inflater = new Inflater();
+        for (int i = 0; i < reps; ++i) {
+            inflater.reset();
+            inflater.setInput(compressed, 0, compressedLength);
+            inflater.inflate(output);
+        }
+        inflater.end();
+    }
+
+    public void time_zipEntry(int reps) throws Exception {
+        for (int i = 0; i < reps; ++i) {
+            InputStream in = zipFile.getInputStream(entry);
+            while (in.read(output) != -1) {
+            }
+            in.close();
+        }
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package benchmarks.jni;
+
+import benchmarks.regression.CharsetBenchmark;
+import benchmarks.regression.StringToRealBenchmark;
+import com.google.caliper.Runner;
+import com.google.caliper.SimpleBenchmark;
+import java.io.File;
+import java.util.Arrays;
+import java.util.List;
+
+/**
+ * Runs every benchmark of libjavacore's and libjavacrypto's JNI boundaries and kernels, saving
+ * caliper's JSON results for each to a file of its own, so that releases can be compared
+ * function by function.
+ *
+ * <p>Usage: {@code JniBenchmarks <output directory> [caliper arguments...]}.
+ */
+public class JniBenchmarks {
+    private static final List<Class<? extends SimpleBenchmark>> BENCHMARKS =
+            Arrays.<Class<? extends SimpleBenchmark>>asList(
+            CharsetBenchmark.class,
+            CharsetsBenchmark.class,
+            ExpatBenchmark.class,
+            InflaterBenchmark.class,
+            MemoryBenchmark.class,
+            NativeBNBenchmark.class,
+            PosixBenchmark.class,
+            SslWriteBenchmark.class,
+            StringToRealBenchmark.class);
+
+    public static void main(String[] args) throws Exception {
+        if (args.length < 1) {
+            System.err.println("usage: JniBenchmarks <output directory> [caliper arguments...]");
+            System.exit(1);
+        }
+        File outputDirectory = new File(args[0]);
+        outputDirectory.mkdirs();
+        for (Class<? extends SimpleBenchmark> benchmark : BENCHMARKS) {
+            String[] caliperArgs = new String[args.length + 1];
+            caliperArgs[0] = "--saveResults";
+            caliperArgs[1] = new File(outputDirectory, benchmark.getSimpleName() + ".json")
+                    .getPath();
+            System.arraycopy(args, 1, caliperArgs, 2, args.length - 1);
+            Runner.main(benchmark, caliperArgs);
+        }
+    }
+}
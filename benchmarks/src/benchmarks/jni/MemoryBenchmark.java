@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package benchmarks.jni;
+
+import com.google.caliper.Param;
+import com.google.caliper.SimpleBenchmark;
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
+import libcore.io.Memory;
+
+/**
+ * Measures Memory's bulk copies between Java arrays and native memory, with and without the
+ * byte swapping that non-native byte order needs.
+ */
+public class MemoryBenchmark extends SimpleBenchmark {
+    @Param({ "16", "1024", "65536" })
+    private int count;
+
+    @Param({ "false", "true" })
+    private boolean swap;
+
+    private ByteBuffer buffer;
+    private long address;
+    private int[] ints;
+    private long[] longs;
+    private short[] shorts;
+
+    @Override protected void setUp() throws Exception {
+        buffer = ByteBuffer.allocateDirect(count * 8);
+        address = NioUtils.unsafeAddress(buffer);
+        ints = new int[count];
+        longs = new long[count];
+        shorts = new short[count];
+    }
+
+    public void time_peekIntArray(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            Memory.peekIntArray(address, ints, 0, count, swap);
+        }
+    }
+
+    public void time_pokeIntArray(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            Memory.pokeIntArray(address, ints, 0, count, swap);
+        }
+    }
+
+    public void time_peekLongArray(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            Memory.peekLongArray(address, longs, 0, count, swap);
+        }
+    }
+
+    public void time_pokeShortArray(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            Memory.pokeShortArray(address, shorts, 0, count, swap);
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package benchmarks.jni;
+
+import com.google.caliper.Param;
+import com.google.caliper.SimpleBenchmark;
+import java.math.BigInteger;
+import java.util.Random;
+
+/**
+ * Measures BigInteger's OpenSSL-backed operations across operand sizes, from values that fit in
+ * a word, where the JNI call dominates, to RSA-sized ones, where the arithmetic does.
+ */
+public class NativeBNBenchmark extends SimpleBenchmark {
+    @Param({ "64", "1024", "4096" })
+    private int bits;
+
+    private BigInteger x;
+    private BigInteger y;
+    private BigInteger modulus;
+    private BigInteger exponent;
+
+    @Override protected void setUp() throws Exception {
+        Random random = new Random(0);
+        x = new BigInteger(bits, random);
+        y = new BigInteger(bits, random).setBit(0);
+        modulus = new BigInteger(bits, random).setBit(bits - 1).setBit(0);
+        exponent = BigInteger.valueOf(65537);
+    }
+
+    public void time_add(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            x.add(y);
+        }
+    }
+
+    public void time_multiply(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            x.multiply(y);
+        }
+    }
+
+    public void time_mod(int reps) {
+        BigInteger product = x.multiply(y);
+        for (int i = 0; i < reps; ++i) {
+            product.mod(modulus);
+        }
+    }
+
+    public void time_modPow(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            x.modPow(exponent, modulus);
+        }
+    }
+
+    public void time_toString(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            x.toString();
+        }
+    }
+}
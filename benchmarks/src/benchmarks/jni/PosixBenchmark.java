@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package benchmarks.jni;
+
+import com.google.caliper.Param;
+import com.google.caliper.SimpleBenchmark;
+import java.io.FileDescriptor;
+import libcore.io.IoUtils;
+import libcore.io.Libcore;
+import libcore.io.StructPollfd;
+
+import static libcore.io.OsConstants.POLLIN;
+
+/**
+ * Measures marshalling across the Posix JNI boundary: poll's array of StructPollfd, and the
+ * byte[] reads and writes of a pipe.
+ */
+public class PosixBenchmark extends SimpleBenchmark {
+    @Param({ "1", "16", "256" })
+    private int fdCount;
+
+    @Param({ "1", "64", "4096" })
+    private int byteCount;
+
+    private FileDescriptor[][] pipes;
+    private StructPollfd[] pollFds;
+    private byte[] buffer;
+
+    @Override protected void setUp() throws Exception {
+        pipes = new FileDescriptor[fdCount][];
+        pollFds = new StructPollfd[fdCount];
+        for (int i = 0; i < fdCount; ++i) {
+            pipes[i] = Libcore.os.pipe();
+            pollFds[i] = new StructPollfd();
+            pollFds[i].fd = pipes[i][0];
+            pollFds[i].events = (short) POLLIN;
+        }
+        buffer = new byte[byteCount];
+    }
+
+    @Override protected void tearDown() throws Exception {
+        for (FileDescriptor[] pipe : pipes) {
+            IoUtils.closeQuietly(pipe[0]);
+            IoUtils.closeQuietly(pipe[1]);
+        }
+    }
+
+    public void time_poll(int reps) throws Exception {
+        for (int i = 0; i < reps; ++i) {
+            Libcore.os.poll(pollFds, 0);
+        }
+    }
+
+    public void time_writeAndRead(int reps) throws Exception {
+        FileDescriptor readFd = pipes[0][0];
+        FileDescriptor writeFd = pipes[0][1];
+        for (int i = 0; i < reps; ++i) {
+            Libcore.os.write(writeFd, buffer, 0, byteCount);
+            int remaining = byteCount;
+            while (remaining > 0) {
+                remaining -= Libcore.os.read(readFd, buffer, 0, remaining);
+            }
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package benchmarks.jni;
+
+import com.google.caliper.Param;
+import com.google.caliper.SimpleBenchmark;
+import java.io.InputStream;
+import java.io.OutputStream;
+import libcore.javax.net.ssl.TestSSLSocketPair;
+
+/**
+ * Measures SSL_write over a loopback connection, with a thread on the other end that reads
+ * everything sent, so the cost is encryption and the JNI crossing rather than the network.
+ */
+public class SslWriteBenchmark extends SimpleBenchmark {
+    @Param({ "16", "1024", "16384" })
+    private int size;
+
+    private TestSSLSocketPair pair;
+    private Thread drainer;
+    private byte[] buffer;
+
+    @Override protected void setUp() throws Exception {
+        pair = TestSSLSocketPair.create();
+        buffer = new byte[size];
+        final InputStream in = pair.server.getInputStream();
+        drainer = new Thread(new Runnable() {
+            public void run() {
+                byte[] sink = new byte[16384];
+                try {
+                    while (in.read(sink) != -1) {
+                    }
+                } catch (Exception ignored) {
+                    // The benchmark closed the connection.
+                }
+            }
+        });
+        drainer.start();
+    }
+
+    @Override protected void tearDown() throws Exception {
+        pair.close();
+        drainer.join();
+    }
+
+    public void time_write(int reps) throws Exception {
+        OutputStream out = pair.client.getOutputStream();
+        for (int i = 0; i < reps; ++i) {
+            out.write(buffer);
+        }
+    }
+}
@@ -26,6 +26,9 @@ public class RealToStringBenchmark extends SimpleBenchmark {
     private static final float MEDIUM = -123.45e8f;
     private static final float LARGE  = -123.45e36f;
 
+    private static final double SMALL_DOUBLE = 0.0012345678901234;
+    private static final double LARGE_DOUBLE = 1.2345678901234567e123;
+
     public void timeFloat_toString_NaN(int reps) {
         for (int rep = 0; rep < reps; ++rep) {
             Float.toString(Float.NaN);
@@ -74,6 +77,25 @@ public class RealToStringBenchmark extends SimpleBenchmark {
         }
     }
 
+    public void timeDouble_toString_small(int reps) {
+        for (int rep = 0; rep < reps; ++rep) {
+            Double.toString(SMALL_DOUBLE);
+        }
+    }
+
+    public void timeDouble_toString_large(int reps) {
+        for (int rep = 0; rep < reps; ++rep) {
+            Double.toString(LARGE_DOUBLE);
+        }
+    }
+
+    public void timeDouble_toChars_large(int reps) {
+        char[] chars = new char[24];
+        for (int rep = 0; rep < reps; ++rep) {
+            Double.toChars(LARGE_DOUBLE, chars, 0);
+        }
+    }
+
     public void timeStringBuilder_small(int reps) {
         for (int rep = 0; rep < reps; ++rep) {
             new StringBuilder().append(SMALL);
@@ -57,4 +57,16 @@ public class StringSplitBenchmark extends SimpleBenchmark {
             "this,is,a,harder,example".split("[,]");
         }
     }
+
+    public void timeStringSplitWhitespace(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            "this is  a\tsimple   example".split("\\s+");
+        }
+    }
+
+    public void timeStringSplitAlternation(int reps) {
+        for (int i = 0; i < reps; ++i) {
+            "this and a simple or example".split(" and | or ");
+        }
+    }
 }
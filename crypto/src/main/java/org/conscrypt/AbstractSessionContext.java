@@ -43,6 +43,8 @@ abstract class AbstractSessionContext implements SSLSessionContext {
 
     final long sslCtxNativePointer = NativeCrypto.SSL_CTX_new();
 
+    volatile boolean verifiedChainCacheEnabled;
+
     /** Identifies OpenSSL sessions. */
     static final int OPEN_SSL = 1;
 
@@ -60,6 +62,17 @@ abstract class AbstractSessionContext implements SSLSessionContext {
         }
     };
 
+    /**
+     * Accepts a peer certificate chain that the trust manager accepted in the last
+     * {@code timeoutSeconds} without asking it again. Only use this if the trust manager's
+     * decision depends on nothing but the chain, the authentication type and, for clients, the
+     * host, and if an answer that old is still good. Can only be called once.
+     */
+    public void enableVerifiedChainCache(int timeoutSeconds) {
+        NativeCrypto.SSL_CTX_set_verified_chain_cache(sslCtxNativePointer, timeoutSeconds);
+        verifiedChainCacheEnabled = true;
+    }
+
     /**
      * Constructs a new session context.
      *
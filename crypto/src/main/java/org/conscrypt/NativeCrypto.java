@@ -20,6 +20,7 @@ import java.io.FileDescriptor;
 import java.io.IOException;
 import java.io.OutputStream;
 import java.net.SocketTimeoutException;
+import java.nio.ByteBuffer;
 import java.security.MessageDigest;
 import java.security.NoSuchAlgorithmException;
 import java.security.SignatureException;
@@ -60,6 +61,14 @@ public final class NativeCrypto {
 
     private native static void clinit();
 
+    /**
+     * Returns how many times each of OpenSSL's locks has had to wait for another thread, indexed
+     * by lock number. {@link #CRYPTO_get_lock_name} names them.
+     */
+    public static native long[] get_lock_contention_counts();
+
+    public static native String CRYPTO_get_lock_name(int n);
+
     // --- ENGINE functions ----------------------------------------------------
     public static native void ENGINE_load_dynamic();
 
@@ -262,6 +271,13 @@ public final class NativeCrypto {
 
     public static native void EVP_DigestUpdate(long ctx, byte[] buffer, int offset, int length);
 
+    /**
+     * Like {@link #EVP_DigestUpdate}, but reads {@code length} bytes from the direct buffer
+     * {@code buffer} starting at absolute index {@code offset}.
+     */
+    public static native void EVP_DigestUpdate_direct(long ctx, ByteBuffer buffer, int offset,
+            int length);
+
     public static native int EVP_DigestFinal(long ctx, byte[] hash, int offset);
 
     // --- MAC handling functions ----------------------------------------------
@@ -297,16 +313,52 @@ public final class NativeCrypto {
     public static native void EVP_CipherInit_ex(long ctx, long evpCipher, byte[] key, byte[] iv,
             boolean encrypting);
 
+    /**
+     * {@code in} and {@code out} may be the same array, and the ranges may overlap.
+     */
     public static native int EVP_CipherUpdate(long ctx, byte[] out, int outOffset, byte[] in,
             int inOffset, int inLength);
 
+    /**
+     * Like {@link #EVP_CipherUpdate}, but with direct buffers and absolute indexes into them.
+     */
+    public static native int EVP_CipherUpdate_direct(long ctx, ByteBuffer out, int outOffset,
+            ByteBuffer in, int inOffset, int inLength);
+
     public static native int EVP_CipherFinal_ex(long ctx, byte[] out, int outOffset)
             throws BadPaddingException, IllegalBlockSizeException;
 
+    public static native int EVP_CipherFinal_ex_direct(long ctx, ByteBuffer out, int outOffset)
+            throws BadPaddingException, IllegalBlockSizeException;
+
+    /**
+     * Encrypts {@code in} with the AEAD cipher {@code evpCipher} (such as "aes-128-gcm") in a
+     * single call, writing the ciphertext followed by a {@code tagLength}-byte tag to
+     * {@code out}. {@code ad} is the additional authenticated data, or null. Returns the number
+     * of bytes written.
+     */
+    public static native int EVP_aead_seal(long evpCipher, byte[] key, byte[] nonce, byte[] ad,
+            byte[] in, int inOffset, int inLength, byte[] out, int outOffset, int tagLength);
+
+    /**
+     * Reverses {@link #EVP_aead_seal}, writing the plaintext to {@code out}. Throws
+     * {@code BadPaddingException} if the tag doesn't match.
+     */
+    public static native int EVP_aead_open(long evpCipher, byte[] key, byte[] nonce, byte[] ad,
+            byte[] in, int inOffset, int inLength, byte[] out, int outOffset, int tagLength)
+            throws BadPaddingException;
+
     public static native int EVP_CIPHER_iv_length(long evpCipher);
 
     public static native long EVP_CIPHER_CTX_new();
 
+    /**
+     * Returns a context that was last used with {@code evpCipher} and freed with
+     * {@link #EVP_CIPHER_CTX_free}, or a new one. Passing the same cipher to
+     * {@link #EVP_CipherInit_ex} then reuses its cipher state.
+     */
+    public static native long EVP_CIPHER_CTX_new_pooled(long evpCipher);
+
     public static native int EVP_CIPHER_CTX_block_size(long ctx);
 
     public static native int get_EVP_CIPHER_CTX_buf_len(long ctx);
@@ -317,6 +369,11 @@ public final class NativeCrypto {
 
     public static native void EVP_CIPHER_CTX_cleanup(long ctx);
 
+    /**
+     * Frees {@code ctx}, or wipes it and keeps it for {@link #EVP_CIPHER_CTX_new_pooled}.
+     */
+    public static native void EVP_CIPHER_CTX_free(long ctx);
+
     // --- RAND seeding --------------------------------------------------------
 
     public static final int RAND_SEED_LENGTH_IN_BYTES = 1024;
@@ -550,6 +607,20 @@ public final class NativeCrypto {
 
     public static native long create_BIO_OutputStream(OutputStream os);
 
+    /**
+     * Returns a BIO that reads the rest of the regular file open on {@code fd} without calling
+     * back into Java, or 0 if {@code fd} isn't a regular file or is already at its end. Freeing
+     * the BIO leaves {@code fd} positioned after whatever was read from it.
+     */
+    public static native long create_BIO_fd(FileDescriptor fd) throws IOException;
+
+    /**
+     * Returns a BIO that reads {@code length} bytes of the direct buffer {@code buffer} starting
+     * at {@code offset}, without calling back into Java. The buffer's contents mustn't change
+     * until the BIO is freed, and its position isn't changed.
+     */
+    public static native long create_BIO_direct(ByteBuffer buffer, int offset, int length);
+
     public static native int BIO_read(long bioRef, byte[] buffer);
 
     public static native void BIO_write(long bioRef, byte[] buffer, int offset, int length)
@@ -768,6 +839,24 @@ public final class NativeCrypto {
 
     public static native void SSL_CTX_set_session_id_context(long ssl_ctx, byte[] sid_ctx);
 
+    /**
+     * Backs {@code ssl_ctx}'s server session cache with a native cache of up to
+     * {@code maxSessions} sessions, each kept at most {@code timeoutSeconds} (or the session's
+     * own timeout if that's 0). If {@code path} is non-null the cache is in that file, and
+     * shared with any other process using it; otherwise it's in anonymous shared memory,
+     * shared with processes forked afterwards.
+     */
+    public static native void SSL_CTX_set_shared_session_cache(long ssl_ctx, String path,
+            int maxSessions, int timeoutSeconds) throws IOException;
+
+    /**
+     * Makes {@code ssl_ctx} remember, for {@code timeoutSeconds}, the peer chains that
+     * {@link SSLHandshakeCallbacks#verifyCertificateChain} accepted, and accept them again
+     * without calling it. Clients only use the cache once
+     * {@link #SSL_set_verified_chain_cache_host} has said which host they verify against.
+     */
+    public static native void SSL_CTX_set_verified_chain_cache(long ssl_ctx, int timeoutSeconds);
+
     public static native long SSL_new(long ssl_ctx) throws SSLException;
 
     public static native void SSL_enable_tls_channel_id(long ssl) throws SSLException;
@@ -931,6 +1020,13 @@ public final class NativeCrypto {
             throws SSLException;
     public static native String SSL_get_servername(long sslNativePointer);
 
+    /**
+     * Sets the host, which may be null, that a client's certificate verification depends on,
+     * for {@link #SSL_CTX_set_verified_chain_cache}.
+     */
+    public static native void SSL_set_verified_chain_cache_host(long sslNativePointer,
+            String host);
+
     /**
      * Enables NPN for all SSL connections in the context.
      *
@@ -1015,6 +1111,29 @@ public final class NativeCrypto {
                                         byte[] b, int off, int len, int writeTimeoutMillis)
         throws IOException;
 
+    /**
+     * Reads into the direct buffer {@code dst} at {@code off}, like {@link #SSL_read}, but copies
+     * every record that has already arrived rather than at most one.
+     * @return -1 if error or the end of the stream is reached.
+     */
+    public static native int SSL_read_direct(long sslNativePointer,
+                                             FileDescriptor fd,
+                                             SSLHandshakeCallbacks shc,
+                                             ByteBuffer dst, int off, int len,
+                                             int readTimeoutMillis)
+        throws IOException;
+
+    /**
+     * Writes {@code lens[i]} bytes of {@code buffers[i]} from {@code offs[i]} for each
+     * {@code i}, packing them into as few records as possible.
+     */
+    public static native void SSL_write_gathered(long sslNativePointer,
+                                                 FileDescriptor fd,
+                                                 SSLHandshakeCallbacks shc,
+                                                 byte[][] buffers, int[] offs, int[] lens,
+                                                 int writeTimeoutMillis)
+        throws IOException;
+
     public static native void SSL_interrupt(long sslNativePointer);
     public static native void SSL_shutdown(long sslNativePointer,
                                            FileDescriptor fd,
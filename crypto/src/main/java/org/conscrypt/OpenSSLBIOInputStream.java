@@ -16,6 +16,7 @@
 
 package org.conscrypt;
 
+import java.io.FileInputStream;
 import java.io.FilterInputStream;
 import java.io.IOException;
 import java.io.InputStream;
@@ -38,6 +39,27 @@ public class OpenSSLBIOInputStream extends FilterInputStream {
         return ctx;
     }
 
+    /**
+     * Returns a BIO reading from {@code is}, to be freed with {@link NativeCrypto#BIO_free}. A
+     * plain {@code FileInputStream} over a regular file is read by native code without calls back
+     * into Java, and left positioned after whatever was read; other streams are read through an
+     * {@code OpenSSLBIOInputStream}.
+     */
+    public static long createBio(InputStream is) {
+        // Subclasses might override read, so only FileInputStream itself can be bypassed.
+        if (is != null && is.getClass() == FileInputStream.class) {
+            try {
+                long bio = NativeCrypto.create_BIO_fd(((FileInputStream) is).getFD());
+                if (bio != 0) {
+                    return bio;
+                }
+            } catch (IOException ignored) {
+                // The stream will run into the same problem and report it.
+            }
+        }
+        return new OpenSSLBIOInputStream(is).getBioContext();
+    }
+
     /**
      * Similar to a {@code readLine} method, but matches what OpenSSL expects
      * from a {@code BIO_gets} method.
@@ -17,6 +17,7 @@
 package org.conscrypt;
 
 import java.io.IOException;
+import java.nio.ByteBuffer;
 import java.security.AlgorithmParameters;
 import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
@@ -68,10 +69,18 @@ public abstract class OpenSSLCipher extends CipherSpi {
     }
 
     /**
-     * Native pointer for the OpenSSL EVP_CIPHER context.
+     * Native pointer for the OpenSSL EVP_CIPHER context. This is taken from the native pool of
+     * contexts for the cipher on the first {@code init}.
      */
-    private OpenSSLCipherContext cipherCtx = new OpenSSLCipherContext(
-            NativeCrypto.EVP_CIPHER_CTX_new());
+    private OpenSSLCipherContext cipherCtx;
+
+    /**
+     * The EVP_CIPHER, key and direction of the last successful {@code init}. Initializing again
+     * with all three unchanged only sets the IV, keeping the expanded key.
+     */
+    private long initializedCipherType;
+    private byte[] initializedKey;
+    private boolean initializedEncrypting;
 
     /**
      * The current cipher mode.
@@ -195,7 +204,7 @@ public abstract class OpenSSLCipher extends CipherSpi {
      * right at the block size, it will add another block for the padding.
      */
     private int getOutputSize(int inputLen) {
-        if (modeBlockSize == 1) {
+        if (modeBlockSize == 1 || cipherCtx == null) {
             return inputLen;
         } else {
             final int buffered = NativeCrypto.get_EVP_CIPHER_CTX_buf_len(cipherCtx.getContext());
@@ -277,7 +286,21 @@ public abstract class OpenSSLCipher extends CipherSpi {
 
         this.iv = iv;
 
-        if (supportsVariableSizeKey()) {
+        if (cipherCtx == null) {
+            cipherCtx = new OpenSSLCipherContext(NativeCrypto.EVP_CIPHER_CTX_new_pooled(
+                    cipherType));
+        }
+
+        // ARC4, the only variable-size key cipher, keeps its stream state in the key schedule,
+        // so it has to be rekeyed to start again.
+        final boolean sameKey = cipherType == initializedCipherType
+                && encrypting == initializedEncrypting
+                && !supportsVariableSizeKey()
+                && keysEqual(encodedKey, initializedKey);
+        initializedKey = null;
+        if (sameKey) {
+            NativeCrypto.EVP_CipherInit_ex(cipherCtx.getContext(), 0, null, iv, encrypting);
+        } else if (supportsVariableSizeKey()) {
             NativeCrypto.EVP_CipherInit_ex(cipherCtx.getContext(), cipherType, null, null,
                     encrypting);
             NativeCrypto.EVP_CIPHER_CTX_set_key_length(cipherCtx.getContext(), encodedKey.length);
@@ -292,6 +315,24 @@ public abstract class OpenSSLCipher extends CipherSpi {
                 padding == Padding.PKCS5PADDING);
         modeBlockSize = NativeCrypto.EVP_CIPHER_CTX_block_size(cipherCtx.getContext());
         calledUpdate = false;
+
+        initializedCipherType = cipherType;
+        initializedKey = encodedKey;
+        initializedEncrypting = encrypting;
+    }
+
+    /**
+     * Compares keys in time that depends only on their lengths.
+     */
+    private static boolean keysEqual(byte[] a, byte[] b) {
+        if (a == null || b == null || a.length != b.length) {
+            return false;
+        }
+        int difference = 0;
+        for (int i = 0; i < a.length; i++) {
+            difference |= a[i] ^ b[i];
+        }
+        return difference == 0;
     }
 
     @Override
@@ -384,6 +425,60 @@ public abstract class OpenSSLCipher extends CipherSpi {
         return updateInternal(input, inputOffset, inputLen, output, outputOffset, maximumLen);
     }
 
+    /**
+     * Direct buffers are handed straight to OpenSSL rather than copied through arrays.
+     */
+    @Override
+    protected int engineUpdate(ByteBuffer input, ByteBuffer output) throws ShortBufferException {
+        if (input == null || output == null || !input.isDirect() || !output.isDirect()) {
+            return super.engineUpdate(input, output);
+        }
+        return updateDirect(input, output, getOutputSize(input.remaining()));
+    }
+
+    private int updateDirect(ByteBuffer input, ByteBuffer output, int maximumLen)
+            throws ShortBufferException {
+        if (output.isReadOnly()) {
+            throw new IllegalArgumentException("output buffer is read-only");
+        }
+        if (output.remaining() < maximumLen) {
+            throw new ShortBufferException("output buffer too small during update: "
+                    + output.remaining() + " < " + maximumLen);
+        }
+        final int inputLen = input.remaining();
+        final int bytesWritten = NativeCrypto.EVP_CipherUpdate_direct(cipherCtx.getContext(),
+                output, output.position(), input, input.position(), inputLen);
+        input.position(input.position() + inputLen);
+        output.position(output.position() + bytesWritten);
+        calledUpdate = true;
+        return bytesWritten;
+    }
+
+    @Override
+    protected int engineDoFinal(ByteBuffer input, ByteBuffer output) throws ShortBufferException,
+            IllegalBlockSizeException, BadPaddingException {
+        if (input == null || output == null || !input.isDirect() || !output.isDirect()) {
+            return super.engineDoFinal(input, output);
+        }
+        int maximumLen = getOutputSize(input.remaining());
+        if (output.remaining() < maximumLen) {
+            // Part of the output may be padding that won't be written, but we can't tell yet.
+            return super.engineDoFinal(input, output);
+        }
+        int bytesWritten = 0;
+        if (input.hasRemaining()) {
+            bytesWritten = updateDirect(input, output, maximumLen);
+        }
+        if (!encrypting && !calledUpdate) {
+            return 0;
+        }
+        final int finalBytes = NativeCrypto.EVP_CipherFinal_ex_direct(cipherCtx.getContext(),
+                output, output.position());
+        output.position(output.position() + finalBytes);
+        reset();
+        return bytesWritten + finalBytes;
+    }
+
     /**
      * Reset this Cipher instance state to process a new chunk of data.
      */
@@ -16,6 +16,7 @@
 
 package org.conscrypt;
 
+import java.nio.ByteBuffer;
 import java.security.MessageDigest;
 import java.security.NoSuchAlgorithmException;
 
@@ -76,6 +77,18 @@ public class OpenSSLMessageDigestJDK extends MessageDigest implements Cloneable
         NativeCrypto.EVP_DigestUpdate(getCtx(), input, offset, len);
     }
 
+    @Override
+    protected void engineUpdate(ByteBuffer input) {
+        if (!input.isDirect()) {
+            super.engineUpdate(input);
+            return;
+        }
+        final int position = input.position();
+        final int len = input.remaining();
+        NativeCrypto.EVP_DigestUpdate_direct(getCtx(), input, position, len);
+        input.position(position + len);
+    }
+
     @Override
     protected byte[] engineDigest() {
         byte[] result = new byte[size];
@@ -25,6 +25,8 @@ import java.io.OutputStream;
 import java.net.InetAddress;
 import java.net.Socket;
 import java.net.SocketException;
+import java.nio.ByteBuffer;
+import java.nio.ReadOnlyBufferException;
 import java.security.InvalidKeyException;
 import java.security.PrivateKey;
 import java.security.SecureRandom;
@@ -267,9 +269,10 @@ public class OpenSSLSocketImpl
 
         final boolean client = sslParameters.getUseClientMode();
 
-        final long sslCtxNativePointer = (client) ?
-            sslParameters.getClientSessionContext().sslCtxNativePointer :
-            sslParameters.getServerSessionContext().sslCtxNativePointer;
+        final AbstractSessionContext sessionContext = (client) ?
+            sslParameters.getClientSessionContext() :
+            sslParameters.getServerSessionContext();
+        final long sslCtxNativePointer = sessionContext.sslCtxNativePointer;
 
         this.sslNativePointer = 0;
         boolean exception = true;
@@ -317,6 +320,10 @@ public class OpenSSLSocketImpl
             if (hostname != null) {
                 NativeCrypto.SSL_set_tlsext_host_name(sslNativePointer, hostname);
             }
+            if (client && sessionContext.verifiedChainCacheEnabled) {
+                // This is the host verifyCertificateChain passes to the trust manager.
+                NativeCrypto.SSL_set_verified_chain_cache_host(sslNativePointer, wrappedHost);
+            }
 
             boolean enableSessionCreation = sslParameters.getEnableSessionCreation();
             if (!enableSessionCreation) {
@@ -647,6 +654,64 @@ public class OpenSSLSocketImpl
         }
     }
 
+    /**
+     * Reads from this socket into {@code dst}, which must be a direct buffer, starting at its
+     * position. Like {@link InputStream#read(byte[])} this waits for at least one byte, but it
+     * then takes every record that has already arrived, where the input stream takes at most
+     * one per call. Returns the number of bytes read, or -1 at the end of the stream.
+     */
+    public int read(ByteBuffer dst) throws IOException {
+        startHandshake();
+        BlockGuard.getThreadPolicy().onNetwork();
+        if (!dst.isDirect()) {
+            throw new IllegalArgumentException("dst is not direct");
+        }
+        if (dst.isReadOnly()) {
+            throw new ReadOnlyBufferException();
+        }
+        synchronized (readLock) {
+            checkOpen();
+            int position = dst.position();
+            int byteCount = dst.remaining();
+            if (byteCount == 0) {
+                return 0;
+            }
+            int result = NativeCrypto.SSL_read_direct(sslNativePointer,
+                    socket.getFileDescriptor$(), this, dst, position, byteCount, getSoTimeout());
+            if (result > 0) {
+                dst.position(position + result);
+            }
+            return result;
+        }
+    }
+
+    /**
+     * Writes {@code byteCounts[i]} bytes of {@code buffers[i]} starting at {@code offsets[i]},
+     * for each {@code i}, as one stream of data. Small buffers are packed together into
+     * full-size TLS records, where writing them to the output stream one at a time would send a
+     * record for each.
+     */
+    public void write(byte[][] buffers, int[] offsets, int[] byteCounts) throws IOException {
+        startHandshake();
+        BlockGuard.getThreadPolicy().onNetwork();
+        if (offsets.length != buffers.length || byteCounts.length != buffers.length) {
+            throw new IllegalArgumentException("buffers.length=" + buffers.length
+                    + "; offsets.length=" + offsets.length
+                    + "; byteCounts.length=" + byteCounts.length);
+        }
+        buffers = buffers.clone();
+        offsets = offsets.clone();
+        byteCounts = byteCounts.clone();
+        for (int i = 0; i < buffers.length; i++) {
+            Arrays.checkOffsetAndCount(buffers[i].length, offsets[i], byteCounts[i]);
+        }
+        synchronized (writeLock) {
+            checkOpen();
+            NativeCrypto.SSL_write_gathered(sslNativePointer, socket.getFileDescriptor$(), this,
+                    buffers, offsets, byteCounts, writeTimeoutMilliseconds);
+        }
+    }
+
     /**
      * This inner class provides input data stream functionality
      * for the OpenSSL native implementation. It is used to
@@ -52,10 +52,10 @@ public class OpenSSLX509CRL extends X509CRL {
     }
 
     public static OpenSSLX509CRL fromX509DerInputStream(InputStream is) throws ParsingException {
-        final OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(is);
+        final long bio = OpenSSLBIOInputStream.createBio(is);
 
         try {
-            final long crlCtx = NativeCrypto.d2i_X509_CRL_bio(bis.getBioContext());
+            final long crlCtx = NativeCrypto.d2i_X509_CRL_bio(bio);
             if (crlCtx == 0) {
                 return null;
             }
@@ -63,21 +63,21 @@ public class OpenSSLX509CRL extends X509CRL {
         } catch (Exception e) {
             throw new ParsingException(e);
         } finally {
-            NativeCrypto.BIO_free(bis.getBioContext());
+            NativeCrypto.BIO_free(bio);
         }
     }
 
     public static List<OpenSSLX509CRL> fromPkcs7DerInputStream(InputStream is)
             throws ParsingException {
-        OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(is);
+        final long bio = OpenSSLBIOInputStream.createBio(is);
 
         final long[] certRefs;
         try {
-            certRefs = NativeCrypto.d2i_PKCS7_bio(bis.getBioContext(), NativeCrypto.PKCS7_CRLS);
+            certRefs = NativeCrypto.d2i_PKCS7_bio(bio, NativeCrypto.PKCS7_CRLS);
         } catch (Exception e) {
             throw new ParsingException(e);
         } finally {
-            NativeCrypto.BIO_free(bis.getBioContext());
+            NativeCrypto.BIO_free(bio);
         }
 
         final List<OpenSSLX509CRL> certs = new ArrayList<OpenSSLX509CRL>(certRefs.length);
@@ -91,10 +91,10 @@ public class OpenSSLX509CRL extends X509CRL {
     }
 
     public static OpenSSLX509CRL fromX509PemInputStream(InputStream is) throws ParsingException {
-        final OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(is);
+        final long bio = OpenSSLBIOInputStream.createBio(is);
 
         try {
-            final long crlCtx = NativeCrypto.PEM_read_bio_X509_CRL(bis.getBioContext());
+            final long crlCtx = NativeCrypto.PEM_read_bio_X509_CRL(bio);
             if (crlCtx == 0) {
                 return null;
             }
@@ -102,22 +102,22 @@ public class OpenSSLX509CRL extends X509CRL {
         } catch (Exception e) {
             throw new ParsingException(e);
         } finally {
-            NativeCrypto.BIO_free(bis.getBioContext());
+            NativeCrypto.BIO_free(bio);
         }
     }
 
     public static List<OpenSSLX509CRL> fromPkcs7PemInputStream(InputStream is)
             throws ParsingException {
-        OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(is);
+        final long bio = OpenSSLBIOInputStream.createBio(is);
 
         final long[] certRefs;
         try {
-            certRefs = NativeCrypto.PEM_read_bio_PKCS7(bis.getBioContext(),
+            certRefs = NativeCrypto.PEM_read_bio_PKCS7(bio,
                     NativeCrypto.PKCS7_CRLS);
         } catch (Exception e) {
             throw new ParsingException(e);
         } finally {
-            NativeCrypto.BIO_free(bis.getBioContext());
+            NativeCrypto.BIO_free(bio);
         }
 
         final List<OpenSSLX509CRL> certs = new ArrayList<OpenSSLX509CRL>(certRefs.length);
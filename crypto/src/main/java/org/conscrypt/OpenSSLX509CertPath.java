@@ -134,7 +134,7 @@ public class OpenSSLX509CertPath extends CertPath {
     }
 
     private static CertPath fromPkiPathEncoding(InputStream inStream) throws CertificateException {
-        OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(inStream);
+        final long bio = OpenSSLBIOInputStream.createBio(inStream);
 
         final boolean markable = inStream.markSupported();
         if (markable) {
@@ -143,7 +143,7 @@ public class OpenSSLX509CertPath extends CertPath {
 
         final long[] certRefs;
         try {
-            certRefs = NativeCrypto.ASN1_seq_unpack_X509_bio(bis.getBioContext());
+            certRefs = NativeCrypto.ASN1_seq_unpack_X509_bio(bio);
         } catch (Exception e) {
             if (markable) {
                 try {
@@ -153,7 +153,7 @@ public class OpenSSLX509CertPath extends CertPath {
             }
             throw new CertificateException(e);
         } finally {
-            NativeCrypto.BIO_free(bis.getBioContext());
+            NativeCrypto.BIO_free(bio);
         }
 
         if (certRefs == null) {
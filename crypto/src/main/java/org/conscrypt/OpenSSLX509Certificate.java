@@ -59,10 +59,10 @@ public class OpenSSLX509Certificate extends X509Certificate {
     public static OpenSSLX509Certificate fromX509DerInputStream(InputStream is)
             throws ParsingException {
         @SuppressWarnings("resource")
-        final OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(is);
+        final long bio = OpenSSLBIOInputStream.createBio(is);
 
         try {
-            final long certCtx = NativeCrypto.d2i_X509_bio(bis.getBioContext());
+            final long certCtx = NativeCrypto.d2i_X509_bio(bio);
             if (certCtx == 0) {
                 return null;
             }
@@ -70,7 +70,7 @@ public class OpenSSLX509Certificate extends X509Certificate {
         } catch (Exception e) {
             throw new ParsingException(e);
         } finally {
-            NativeCrypto.BIO_free(bis.getBioContext());
+            NativeCrypto.BIO_free(bio);
         }
     }
 
@@ -85,15 +85,15 @@ public class OpenSSLX509Certificate extends X509Certificate {
     public static List<OpenSSLX509Certificate> fromPkcs7DerInputStream(InputStream is)
             throws ParsingException {
         @SuppressWarnings("resource")
-        OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(is);
+        final long bio = OpenSSLBIOInputStream.createBio(is);
 
         final long[] certRefs;
         try {
-            certRefs = NativeCrypto.d2i_PKCS7_bio(bis.getBioContext(), NativeCrypto.PKCS7_CERTS);
+            certRefs = NativeCrypto.d2i_PKCS7_bio(bio, NativeCrypto.PKCS7_CERTS);
         } catch (Exception e) {
             throw new ParsingException(e);
         } finally {
-            NativeCrypto.BIO_free(bis.getBioContext());
+            NativeCrypto.BIO_free(bio);
         }
 
         if (certRefs == null) {
@@ -114,10 +114,10 @@ public class OpenSSLX509Certificate extends X509Certificate {
     public static OpenSSLX509Certificate fromX509PemInputStream(InputStream is)
             throws ParsingException {
         @SuppressWarnings("resource")
-        final OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(is);
+        final long bio = OpenSSLBIOInputStream.createBio(is);
 
         try {
-            final long certCtx = NativeCrypto.PEM_read_bio_X509(bis.getBioContext());
+            final long certCtx = NativeCrypto.PEM_read_bio_X509(bio);
             if (certCtx == 0L) {
                 return null;
             }
@@ -125,23 +125,23 @@ public class OpenSSLX509Certificate extends X509Certificate {
         } catch (Exception e) {
             throw new ParsingException(e);
         } finally {
-            NativeCrypto.BIO_free(bis.getBioContext());
+            NativeCrypto.BIO_free(bio);
         }
     }
 
     public static List<OpenSSLX509Certificate> fromPkcs7PemInputStream(InputStream is)
             throws ParsingException {
         @SuppressWarnings("resource")
-        OpenSSLBIOInputStream bis = new OpenSSLBIOInputStream(is);
+        final long bio = OpenSSLBIOInputStream.createBio(is);
 
         final long[] certRefs;
         try {
-            certRefs = NativeCrypto.PEM_read_bio_PKCS7(bis.getBioContext(),
+            certRefs = NativeCrypto.PEM_read_bio_PKCS7(bio,
                     NativeCrypto.PKCS7_CERTS);
         } catch (Exception e) {
             throw new ParsingException(e);
         } finally {
-            NativeCrypto.BIO_free(bis.getBioContext());
+            NativeCrypto.BIO_free(bio);
         }
 
         final List<OpenSSLX509Certificate> certs = new ArrayList<OpenSSLX509Certificate>(
@@ -16,6 +16,7 @@
 
 package org.conscrypt;
 
+import java.io.FileInputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.PushbackInputStream;
@@ -54,6 +55,42 @@ public class OpenSSLX509CertificateFactory extends CertificateFactorySpi {
         }
     }
 
+    /**
+     * Returns a stream that {@link #peek} works on and that reads what {@code inStream} would.
+     * A plain {@code FileInputStream} is returned as is, which lets the parsers read the file
+     * natively; anything else gets a {@code PushbackInputStream}.
+     */
+    private static InputStream toPeekable(InputStream inStream) {
+        if (inStream.getClass() == FileInputStream.class) {
+            try {
+                // Only a stream that can be rewound can be peeked at without pushing back.
+                ((FileInputStream) inStream).getChannel().position();
+                return inStream;
+            } catch (IOException ignored) {
+            }
+        }
+        return new PushbackInputStream(inStream, PUSHBACK_SIZE);
+    }
+
+    /**
+     * Reads up to {@code buffer.length} bytes from a stream returned by {@link #toPeekable}
+     * without consuming them, returning how many were read or -1 at the end of the stream.
+     */
+    private static int peek(InputStream in, byte[] buffer) throws IOException {
+        if (in instanceof PushbackInputStream) {
+            final int len = in.read(buffer);
+            if (len > 0) {
+                ((PushbackInputStream) in).unread(buffer, 0, len);
+            }
+            return len;
+        }
+        final FileInputStream fis = (FileInputStream) in;
+        final long position = fis.getChannel().position();
+        final int len = fis.read(buffer);
+        fis.getChannel().position(position);
+        return len;
+    }
+
     /**
      * The code for X509 Certificates and CRL is pretty much the same. We use
      * this abstract class to share the code between them. This makes it ugly,
@@ -70,16 +107,15 @@ public class OpenSSLX509CertificateFactory extends CertificateFactorySpi {
                 inStream.mark(PKCS7_MARKER.length);
             }
 
-            final PushbackInputStream pbis = new PushbackInputStream(inStream, PUSHBACK_SIZE);
+            final InputStream pbis = toPeekable(inStream);
             try {
                 final byte[] buffer = new byte[PKCS7_MARKER.length];
 
-                final int len = pbis.read(buffer);
+                final int len = peek(pbis, buffer);
                 if (len < 0) {
                     /* No need to reset here. The stream was empty or EOF. */
                     throw new ParsingException("inStream is empty");
                 }
-                pbis.unread(buffer, 0, len);
 
                 if (buffer[0] == '-') {
                     if (len == PKCS7_MARKER.length && Arrays.equals(PKCS7_MARKER, buffer)) {
@@ -133,16 +169,15 @@ public class OpenSSLX509CertificateFactory extends CertificateFactorySpi {
             }
 
             /* Attempt to see if this is a PKCS#7 bag. */
-            final PushbackInputStream pbis = new PushbackInputStream(inStream, PUSHBACK_SIZE);
+            final InputStream pbis = toPeekable(inStream);
             try {
                 final byte[] buffer = new byte[PKCS7_MARKER.length];
 
-                final int len = pbis.read(buffer);
+                final int len = peek(pbis, buffer);
                 if (len < 0) {
                     /* No need to reset here. The stream was empty or EOF. */
                     throw new ParsingException("inStream is empty");
                 }
-                pbis.unread(buffer, 0, len);
 
                 if (len == PKCS7_MARKER.length && Arrays.equals(PKCS7_MARKER, buffer)) {
                     return fromPkcs7PemInputStream(pbis);
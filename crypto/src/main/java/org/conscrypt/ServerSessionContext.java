@@ -16,6 +16,7 @@
 
 package org.conscrypt;
 
+import java.io.IOException;
 import javax.net.ssl.SSLSession;
 
 /**
@@ -49,6 +50,19 @@ public class ServerSessionContext extends AbstractSessionContext {
         this.persistentCache = persistentCache;
     }
 
+    /**
+     * Lets OpenSSL resume sessions from a native cache of up to {@code maxSessions} sessions,
+     * without calling into Java. Each session is kept at most {@code timeoutSeconds}, or for its
+     * own lifetime if that's 0. If {@code path} is non-null, the cache is in that file and is
+     * shared with every process that uses the same file; if it's null, the cache is shared with
+     * the processes this one forks afterwards. Can only be called once.
+     */
+    public void setSharedNativeCache(String path, int maxSessions, int timeoutSeconds)
+            throws IOException {
+        NativeCrypto.SSL_CTX_set_shared_session_cache(sslCtxNativePointer, path, maxSessions,
+                timeoutSeconds);
+    }
+
     protected void sessionRemoved(SSLSession session) {}
 
     @Override
@@ -16,7 +16,6 @@
 
 package org.conscrypt;
 
-import java.io.BufferedInputStream;
 import java.io.File;
 import java.io.FileInputStream;
 import java.io.FileOutputStream;
@@ -171,7 +170,8 @@ public final class TrustedCertificateStore {
         }
         InputStream is = null;
         try {
-            is = new BufferedInputStream(new FileInputStream(file));
+            // Unbuffered, so the certificate factory can read the file natively.
+            is = new FileInputStream(file);
             return (X509Certificate) CERT_FACTORY.generateCertificate(is);
         } catch (IOException e) {
             return null;
@@ -30,7 +30,15 @@
 #include <algorithm>
 #include <arpa/inet.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stddef.h>
+#include <sys/eventfd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 #include <vector>
 
@@ -43,6 +51,7 @@
 #include <openssl/evp.h>
 #include <openssl/rand.h>
 #include <openssl/rsa.h>
+#include <openssl/sha.h>
 #include <openssl/ssl.h>
 #include <openssl/x509v3.h>
 
@@ -51,9 +60,11 @@
 #include "JNIHelp.h"
 #include "JniConstants.h"
 #include "JniException.h"
+#include "NativeCounters.h"
 #include "NetFd.h"
 #include "ScopedLocalRef.h"
 #include "ScopedPrimitiveArray.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedUtfChars.h"
 #include "UniquePtr.h"
 
@@ -865,6 +876,86 @@ static X509* X509_dup_nocopy(X509* x509) {
     return x509;
 }
 
+/**
+ * Certificates parsed by d2i_X509 and PEM_read_bio_X509, keyed by the SHA-256 of their DER.
+ * Every handshake's chain brings the same few CA and intermediate certificates, so rather than
+ * parse them again we hand out another reference to the X509 from the first time. Nothing
+ * modifies an X509 once it's parsed, and X509_check_purpose fills in the lazily computed
+ * extension fields before one is shared.
+ *
+ * The cache is set-associative: a digest can only be in the X509_INTERN_WAYS entries of the
+ * set its first bytes pick, and a miss replaces the least recently used of those.
+ */
+#define X509_INTERN_SETS 64
+#define X509_INTERN_WAYS 4
+
+struct X509InternEntry {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    X509* x509;
+    uint64_t lastUse;
+};
+
+static pthread_mutex_t gX509InternMutex = PTHREAD_MUTEX_INITIALIZER;
+static X509InternEntry gX509InternCache[X509_INTERN_SETS][X509_INTERN_WAYS];
+static uint64_t gX509InternClock;
+
+static X509InternEntry* x509InternSet(const unsigned char* digest) {
+    uint32_t index;
+    memcpy(&index, digest, sizeof(index));
+    return gX509InternCache[index % X509_INTERN_SETS];
+}
+
+/**
+ * Returns a new reference to the interned certificate with DER digest, or NULL.
+ */
+static X509* x509InternLookup(const unsigned char* digest) {
+    ScopedPthreadMutexLock lock(&gX509InternMutex);
+    X509InternEntry* set = x509InternSet(digest);
+    for (size_t i = 0; i < X509_INTERN_WAYS; ++i) {
+        if (set[i].x509 != NULL && memcmp(set[i].digest, digest, SHA256_DIGEST_LENGTH) == 0) {
+            set[i].lastUse = ++gX509InternClock;
+            return X509_dup_nocopy(set[i].x509);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Interns the newly parsed x509, whose DER has the given digest, taking ownership of it.
+ * Returns the certificate to use, which is a reference to an existing one if another thread
+ * got there first.
+ */
+static X509* x509Intern(const unsigned char* digest, X509* x509) {
+    X509_check_purpose(x509, -1, 0);
+    X509* evicted = NULL;
+    {
+        ScopedPthreadMutexLock lock(&gX509InternMutex);
+        X509InternEntry* set = x509InternSet(digest);
+        X509InternEntry* victim = &set[0];
+        for (size_t i = 0; i < X509_INTERN_WAYS; ++i) {
+            if (set[i].x509 != NULL
+                    && memcmp(set[i].digest, digest, SHA256_DIGEST_LENGTH) == 0) {
+                set[i].lastUse = ++gX509InternClock;
+                X509* existing = X509_dup_nocopy(set[i].x509);
+                X509_free(x509);
+                return existing;
+            }
+            if (set[i].lastUse < victim->lastUse) {
+                victim = &set[i];
+            }
+        }
+        evicted = victim->x509;
+        memcpy(victim->digest, digest, SHA256_DIGEST_LENGTH);
+        victim->x509 = X509_dup_nocopy(x509);
+        victim->lastUse = ++gX509InternClock;
+    }
+    // Freeing can take X509's lock, so isn't done under ours.
+    if (evicted != NULL) {
+        X509_free(evicted);
+    }
+    return x509;
+}
+
 /**
  * BIO for InputStream
  */
@@ -1086,6 +1177,179 @@ static BIO_METHOD stream_bio_method = {
         NULL, /* no bio_callback_ctrl */
 };
 
+/**
+ * BIO reading the rest of a regular file, or a direct ByteBuffer. Unlike the stream BIO, reading
+ * never calls back into Java, so CRLs and trust store certificates can be parsed entirely in
+ * native code.
+ *
+ * A file is read with pread(2) a chunk at a time, only as far as the BIO's reader gets. The
+ * certificate factory makes a new BIO for each certificate in a PEM bundle, so reading the whole
+ * rest of the file up front would make a bundle cost time quadratic in its size. Files aren't
+ * mapped, because a file truncated while it's mapped would fault the reader.
+ */
+struct BIO_Region {
+    // A direct buffer's contents. Unused for a file, which is read into 'chunk' instead.
+    const char* data;
+    // How much there is to read: for a file, its length when the BIO was made, and then
+    // however far it turned out to go if it has since shrunk.
+    size_t length;
+    size_t position;
+
+    // The descriptor the file is read from, which is left positioned after whatever the BIO's
+    // reader consumed, as if it had been read through the stream. -1 for a direct buffer.
+    int fd;
+    off_t fdStart;
+    // Holds the chunkLength bytes of the file starting chunkStart bytes after fdStart.
+    char* chunk;
+    size_t chunkStart;
+    size_t chunkLength;
+
+    // Set for a direct buffer, to keep it from being collected while it's read.
+    jobject buffer;
+};
+
+static const size_t BIO_REGION_CHUNK_SIZE = 16 * 1024;
+
+static BIO_Region* bio_region_new() {
+    BIO_Region* region = new BIO_Region;
+    memset(region, 0, sizeof(*region));
+    region->fd = -1;
+    return region;
+}
+
+static int bio_region_create(BIO *b) {
+    b->init = 1;
+    b->num = 0;
+    b->ptr = NULL;
+    b->flags = 0;
+    return 1;
+}
+
+static int bio_region_destroy(BIO *b) {
+    if (b == NULL) {
+        return 0;
+    }
+
+    BIO_Region* region = static_cast<BIO_Region*>(b->ptr);
+    if (region != NULL) {
+        if (region->fd != -1) {
+            lseek(region->fd, region->fdStart + region->position, SEEK_SET);
+        }
+        free(region->chunk);
+        if (region->buffer != NULL) {
+            JNIEnv* env;
+            if (gJavaVM->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_OK) {
+                env->DeleteGlobalRef(region->buffer);
+            }
+        }
+        delete region;
+        b->ptr = NULL;
+    }
+
+    b->init = 0;
+    b->flags = 0;
+    return 1;
+}
+
+// Points 'available' bytes, at least one, at what's next to read. Returns NULL at the end, or
+// if a file can't be read.
+static const char* bio_region_peek(BIO_Region* region, size_t& available) {
+    if (region->position == region->length) {
+        return NULL;
+    }
+    if (region->fd == -1) {
+        available = region->length - region->position;
+        return region->data + region->position;
+    }
+    if (region->position < region->chunkStart ||
+            region->position >= region->chunkStart + region->chunkLength) {
+        size_t wanted = std::min(BIO_REGION_CHUNK_SIZE, region->length - region->position);
+        ssize_t rc = TEMP_FAILURE_RETRY(pread(region->fd, region->chunk, wanted,
+                                              region->fdStart + region->position));
+        if (rc <= 0) {
+            // The file has shrunk since the BIO was made, or is unreadable: either way, stop.
+            region->length = region->position;
+            region->chunkLength = 0;
+            return NULL;
+        }
+        region->chunkStart = region->position;
+        region->chunkLength = rc;
+    }
+    size_t offset = region->position - region->chunkStart;
+    available = region->chunkLength - offset;
+    return region->chunk + offset;
+}
+
+static int bio_region_read(BIO *b, char *buf, int len) {
+    BIO_Region* region = static_cast<BIO_Region*>(b->ptr);
+    size_t count = 0;
+    const char* start;
+    size_t available;
+    while (count < static_cast<size_t>(std::max(len, 0)) &&
+            (start = bio_region_peek(region, available)) != NULL) {
+        size_t n = std::min(available, len - count);
+        memcpy(buf + count, start, n);
+        region->position += n;
+        count += n;
+    }
+    return count;
+}
+
+static int bio_region_gets(BIO *b, char *buf, int len) {
+    BIO_Region* region = static_cast<BIO_Region*>(b->ptr);
+    if (len <= 0) {
+        return 0;
+    }
+    // Like a memory BIO, this returns up to len - 1 bytes, up to and including a newline.
+    size_t count = 0;
+    const char* start;
+    size_t available;
+    while (count < static_cast<size_t>(len - 1) &&
+            (start = bio_region_peek(region, available)) != NULL) {
+        size_t n = std::min(available, len - 1 - count);
+        const char* newline = static_cast<const char*>(memchr(start, '\n', n));
+        if (newline != NULL) {
+            n = newline - start + 1;
+        }
+        memcpy(buf + count, start, n);
+        region->position += n;
+        count += n;
+        if (newline != NULL) {
+            break;
+        }
+    }
+    buf[count] = '\0';
+    return count;
+}
+
+static long bio_region_ctrl(BIO *b, int cmd, long, void *) {
+    BIO_Region* region = static_cast<BIO_Region*>(b->ptr);
+
+    switch (cmd) {
+    case BIO_CTRL_EOF:
+        return (region->position == region->length) ? 1 : 0;
+    case BIO_CTRL_PENDING:
+        return region->length - region->position;
+    case BIO_CTRL_FLUSH:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static BIO_METHOD region_bio_method = {
+        ( 101 | 0x0400 ), /* source/sink BIO */
+        "file/direct buffer BIO",
+        NULL, /* no bio_write */
+        bio_region_read, /* bio_read */
+        NULL, /* no bio_puts */
+        bio_region_gets, /* bio_gets */
+        bio_region_ctrl, /* bio_ctrl */
+        bio_region_create, /* bio_create */
+        bio_region_destroy, /* bio_free */
+        NULL, /* no bio_callback_ctrl */
+};
+
 /**
  * Copied from libnativehelper NetworkUtilites.cpp
  */
@@ -1120,13 +1384,34 @@ static bool setBlocking(int fd, bool blocking) {
 #define THROW_SOCKETTIMEOUTEXCEPTION (-3)
 #define THROWN_EXCEPTION (-4)
 
-static MUTEX_TYPE* mutex_buf = NULL;
+/*
+ * OpenSSL says whether it wants each lock for reading (CRYPTO_READ) or for writing, so they're
+ * rwlocks: concurrent handshakes can share read-mostly state like the X509 store. Each lock
+ * counts how many acquisitions had to wait for another thread; only the slow path touches the
+ * count, so it doesn't add contention of its own. Each lock is on its own cache line.
+ */
+struct OpenSslLock {
+    pthread_rwlock_t rwlock;
+    uint64_t contentions;
+} __attribute__((aligned(64)));
+
+static OpenSslLock gOpenSslLocks[CRYPTO_NUM_LOCKS];
+static bool gOpenSslLocksInitialized = false;
 
 static void locking_function(int mode, int n, const char*, int) {
-    if (mode & CRYPTO_LOCK) {
-        MUTEX_LOCK(mutex_buf[n]);
+    OpenSslLock& lock = gOpenSslLocks[n];
+    if (!(mode & CRYPTO_LOCK)) {
+        pthread_rwlock_unlock(&lock.rwlock);
+    } else if (mode & CRYPTO_READ) {
+        if (pthread_rwlock_tryrdlock(&lock.rwlock) != 0) {
+            __atomic_add_fetch(&lock.contentions, 1, __ATOMIC_RELAXED);
+            pthread_rwlock_rdlock(&lock.rwlock);
+        }
     } else {
-        MUTEX_UNLOCK(mutex_buf[n]);
+        if (pthread_rwlock_trywrlock(&lock.rwlock) != 0) {
+            __atomic_add_fetch(&lock.contentions, 1, __ATOMIC_RELAXED);
+            pthread_rwlock_wrlock(&lock.rwlock);
+        }
     }
 }
 
@@ -1135,14 +1420,15 @@ static unsigned long id_function(void) {
 }
 
 int THREAD_setup(void) {
-    mutex_buf = new MUTEX_TYPE[CRYPTO_num_locks()];
-    if (!mutex_buf) {
+    if (CRYPTO_num_locks() > CRYPTO_NUM_LOCKS) {
         return 0;
     }
 
     for (int i = 0; i < CRYPTO_num_locks(); ++i) {
-        MUTEX_SETUP(mutex_buf[i]);
+        pthread_rwlock_init(&gOpenSslLocks[i].rwlock, NULL);
+        gOpenSslLocks[i].contentions = 0;
     }
+    gOpenSslLocksInitialized = true;
 
     CRYPTO_set_id_callback(id_function);
     CRYPTO_set_locking_callback(locking_function);
@@ -1151,7 +1437,7 @@ int THREAD_setup(void) {
 }
 
 int THREAD_cleanup(void) {
-    if (!mutex_buf) {
+    if (!gOpenSslLocksInitialized) {
         return 0;
     }
 
@@ -1159,15 +1445,42 @@ int THREAD_cleanup(void) {
     CRYPTO_set_locking_callback(NULL);
 
     for (int i = 0; i < CRYPTO_num_locks( ); i++) {
-        MUTEX_CLEANUP(mutex_buf[i]);
+        pthread_rwlock_destroy(&gOpenSslLocks[i].rwlock);
     }
-
-    free(mutex_buf);
-    mutex_buf = NULL;
+    gOpenSslLocksInitialized = false;
 
     return 1;
 }
 
+/**
+ * Returns how many times each of OpenSSL's locks has had to wait for another thread, indexed
+ * by lock number.
+ */
+static jlongArray NativeCrypto_get_lock_contention_counts(JNIEnv* env, jclass) {
+    int count = CRYPTO_num_locks();
+    jlongArray result = env->NewLongArray(count);
+    if (result == NULL) {
+        return NULL;
+    }
+    ScopedLongArrayRW counts(env, result);
+    if (counts.get() == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < count; ++i) {
+        counts[i] = __atomic_load_n(&gOpenSslLocks[i].contentions, __ATOMIC_RELAXED);
+    }
+    return result;
+}
+
+static jstring NativeCrypto_CRYPTO_get_lock_name(JNIEnv* env, jclass, jint n) {
+    JNI_TRACE("CRYPTO_get_lock_name(%d)", n);
+    if (n < 0 || n >= CRYPTO_num_locks()) {
+        jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException", "no lock %d", n);
+        return NULL;
+    }
+    return env->NewStringUTF(CRYPTO_get_lock_name(n));
+}
+
 /**
  * Initialization phase for every OpenSSL job: Loads the Error strings, the
  * crypto algorithms and reset the OpenSSL library
@@ -2891,6 +3204,70 @@ static jint NativeCrypto_ECDH_compute_key(JNIEnv* env, jclass,
     return outputLength;
 }
 
+/**
+ * Keeps a few finished contexts for each of the algorithms they were last used with, so that
+ * code that makes a short-lived MessageDigest or Cipher per request doesn't allocate a context
+ * and its algorithm state every time. A context taken for the same algorithm keeps its
+ * algorithm-specific buffer: EVP_DigestInit_ex and EVP_MD_CTX_copy_ex reuse md_data when the
+ * digest is unchanged, and NativeCrypto_EVP_CipherInit_ex keeps cipher_data likewise.
+ */
+static const size_t kContextPoolAlgorithms = 16;
+static const size_t kContextPoolDepth = 8;
+
+struct ContextPool {
+    pthread_mutex_t mutex;
+    struct Entry {
+        const void* algorithm;
+        size_t count;
+        void* contexts[kContextPoolDepth];
+    } entries[kContextPoolAlgorithms];
+};
+
+static ContextPool gMdCtxPool = { PTHREAD_MUTEX_INITIALIZER, {} };
+static ContextPool gCipherCtxPool = { PTHREAD_MUTEX_INITIALIZER, {} };
+
+/**
+ * Returns a pooled context last used with algorithm, or NULL if there isn't one.
+ */
+static void* contextPoolTake(ContextPool* pool, const void* algorithm) {
+    ScopedPthreadMutexLock lock(&pool->mutex);
+    for (size_t i = 0; i < kContextPoolAlgorithms; ++i) {
+        ContextPool::Entry& entry = pool->entries[i];
+        if (entry.algorithm == algorithm && entry.count > 0) {
+            return entry.contexts[--entry.count];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Adds ctx to the pool for algorithm. Returns false, and the caller must free ctx, if that
+ * algorithm's list is full or there's no room for another algorithm.
+ */
+static bool contextPoolPut(ContextPool* pool, const void* algorithm, void* ctx) {
+    ScopedPthreadMutexLock lock(&pool->mutex);
+    ContextPool::Entry* unused = NULL;
+    for (size_t i = 0; i < kContextPoolAlgorithms; ++i) {
+        ContextPool::Entry& entry = pool->entries[i];
+        if (entry.algorithm == algorithm) {
+            if (entry.count == kContextPoolDepth) {
+                return false;
+            }
+            entry.contexts[entry.count++] = ctx;
+            return true;
+        }
+        if (unused == NULL && entry.count == 0) {
+            unused = &entry;
+        }
+    }
+    if (unused == NULL) {
+        return false;
+    }
+    unused->algorithm = algorithm;
+    unused->contexts[unused->count++] = ctx;
+    return true;
+}
+
 static jlong NativeCrypto_EVP_MD_CTX_create(JNIEnv* env, jclass) {
     JNI_TRACE("EVP_MD_CTX_create()");
 
@@ -2931,13 +3308,16 @@ static jlong NativeCrypto_EVP_MD_CTX_copy(JNIEnv* env, jclass, jlong ctxRef) {
         return 0;
     }
 
-    EVP_MD_CTX* copy = EVP_MD_CTX_create();
+    EVP_MD_CTX* copy = reinterpret_cast<EVP_MD_CTX*>(
+            contextPoolTake(&gMdCtxPool, EVP_MD_CTX_md(ctx)));
     if (copy == NULL) {
-        jniThrowOutOfMemory(env, "Unable to allocate copy of EVP_MD_CTX");
-        return 0;
+        copy = EVP_MD_CTX_create();
+        if (copy == NULL) {
+            jniThrowOutOfMemory(env, "Unable to allocate copy of EVP_MD_CTX");
+            return 0;
+        }
     }
 
-    EVP_MD_CTX_init(copy);
     int result = EVP_MD_CTX_copy_ex(copy, ctx);
     if (result == 0) {
         EVP_MD_CTX_destroy(copy);
@@ -2968,13 +3348,16 @@ static jint NativeCrypto_EVP_DigestFinal(JNIEnv* env, jclass, jlong ctxRef,
         return -1;
     }
     unsigned int bytesWritten = -1;
-    int ok = EVP_DigestFinal(ctx,
-                             reinterpret_cast<unsigned char*>(hashBytes.get() + offset),
-                             &bytesWritten);
+    int ok = EVP_DigestFinal_ex(ctx,
+                                reinterpret_cast<unsigned char*>(hashBytes.get() + offset),
+                                &bytesWritten);
     if (ok == 0) {
         throwExceptionIfNecessary(env, "NativeCrypto_EVP_DigestFinal");
     }
-    EVP_MD_CTX_destroy(ctx);
+    // EVP_DigestFinal_ex has wiped the digest state, so a plain digest context can be reused.
+    if (ok == 0 || ctx->pctx != NULL || !contextPoolPut(&gMdCtxPool, EVP_MD_CTX_md(ctx), ctx)) {
+        EVP_MD_CTX_destroy(ctx);
+    }
 
     JNI_TRACE("NativeCrypto_EVP_DigestFinal(%p, %p, %d) => %d", ctx, hash, offset, bytesWritten);
     return bytesWritten;
@@ -2992,14 +3375,18 @@ static jlong NativeCrypto_EVP_DigestInit(JNIEnv* env, jclass, jlong evpMdRef) {
         return 0;
     }
 
-    Unique_EVP_MD_CTX ctx(EVP_MD_CTX_create());
+    Unique_EVP_MD_CTX ctx(reinterpret_cast<EVP_MD_CTX*>(contextPoolTake(&gMdCtxPool, evp_md)));
     if (ctx.get() == NULL) {
-        jniThrowOutOfMemory(env, "Unable to allocate EVP_MD_CTX");
-        return 0;
+        ctx.reset(EVP_MD_CTX_create());
+        if (ctx.get() == NULL) {
+            jniThrowOutOfMemory(env, "Unable to allocate EVP_MD_CTX");
+            return 0;
+        }
     }
     JNI_TRACE("NativeCrypto_EVP_DigestInit ctx=%p", ctx.get());
 
-    int ok = EVP_DigestInit(ctx.get(), evp_md);
+    // Unlike EVP_DigestInit, this doesn't reset the context, so a pooled one keeps md_data.
+    int ok = EVP_DigestInit_ex(ctx.get(), evp_md, NULL);
     if (ok == 0) {
         bool exception = throwExceptionIfNecessary(env, "NativeCrypto_EVP_DigestInit");
         if (exception) {
@@ -3100,6 +3487,49 @@ static void NativeCrypto_EVP_DigestUpdate(JNIEnv* env, jclass, jlong ctxRef,
     }
 }
 
+/**
+ * Returns the address of byte offset in the direct buffer, after checking that length bytes
+ * from there are inside it. Throws and returns NULL otherwise.
+ */
+static unsigned char* directBufferRange(JNIEnv* env, jobject buffer, jint offset, jlong length) {
+    if (buffer == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return NULL;
+    }
+    unsigned char* address = reinterpret_cast<unsigned char*>(env->GetDirectBufferAddress(buffer));
+    if (address == NULL) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "buffer is not direct");
+        return NULL;
+    }
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (offset < 0 || length < 0 || offset + length > capacity) {
+        jniThrowException(env, "java/lang/IndexOutOfBoundsException", NULL);
+        return NULL;
+    }
+    return address + offset;
+}
+
+/*
+ * public static native void EVP_DigestUpdate_direct(long, ByteBuffer, int, int)
+ */
+static void NativeCrypto_EVP_DigestUpdate_direct(JNIEnv* env, jclass, jlong ctxRef,
+                                                 jobject buffer, jint offset, jint length) {
+    EVP_MD_CTX* ctx = reinterpret_cast<EVP_MD_CTX*>(ctxRef);
+    JNI_TRACE("NativeCrypto_EVP_DigestUpdate_direct(%p, %p, %d, %d)", ctx, buffer, offset, length);
+
+    if (ctx == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return;
+    }
+    const unsigned char* in = directBufferRange(env, buffer, offset, length);
+    if (in == NULL) {
+        return;
+    }
+    if (!EVP_DigestUpdate(ctx, in, length)) {
+        throwExceptionIfNecessary(env, "NativeCrypto_EVP_DigestUpdate_direct");
+    }
+}
+
 static void NativeCrypto_EVP_DigestSignInit(JNIEnv* env, jclass, jlong evpMdCtxRef,
         const jlong evpMdRef, jlong pkeyRef) {
     EVP_MD_CTX* mdCtx = reinterpret_cast<EVP_MD_CTX*>(evpMdCtxRef);
@@ -3466,6 +3896,14 @@ static void NativeCrypto_EVP_CipherInit_ex(JNIEnv* env, jclass, jlong ctxRef, jl
         memcpy(ivPtr.get(), ivBytes.get(), ivBytes.size());
     }
 
+    // Setting the cipher again frees and reallocates cipher_data; when it's the cipher the
+    // context already has, only the key and IV need setting. That isn't so for ciphers with
+    // their own init ctrl, or a key length that may have been changed.
+    if (evpCipher != NULL && evpCipher == EVP_CIPHER_CTX_cipher(ctx)
+            && !(EVP_CIPHER_flags(evpCipher) & (EVP_CIPH_CTRL_INIT | EVP_CIPH_VARIABLE_LENGTH))) {
+        evpCipher = NULL;
+    }
+
     if (!EVP_CipherInit_ex(ctx, evpCipher, NULL, keyPtr.get(), ivPtr.get(), encrypting ? 1 : 0)) {
         throwExceptionIfNecessary(env, "EVP_CipherInit_ex");
         JNI_TRACE("EVP_CipherInit_ex => error initializing cipher");
@@ -3476,6 +3914,26 @@ static void NativeCrypto_EVP_CipherInit_ex(JNIEnv* env, jclass, jlong ctxRef, jl
             encrypting ? 1 : 0);
 }
 
+/**
+ * EVP_CipherUpdate, but safe if in and out overlap. Updating exactly in place is fine when the
+ * context has no partial block or held-back final block, since then OpenSSL writes each block
+ * of out only after reading the same block of in; otherwise overlapping input is copied first.
+ */
+static int cipherUpdate(EVP_CIPHER_CTX* ctx, unsigned char* out, int* outl,
+                        const unsigned char* in, int inLength) {
+    uintptr_t inStart = reinterpret_cast<uintptr_t>(in);
+    uintptr_t outStart = reinterpret_cast<uintptr_t>(out);
+    size_t maxOutLength = inLength + EVP_CIPHER_CTX_block_size(ctx);
+    bool overlapping = inStart < outStart + maxOutLength && outStart < inStart + inLength;
+    UniquePtr<unsigned char[]> copy;
+    if (overlapping && !(in == out && ctx->buf_len == 0 && !ctx->final_used)) {
+        copy.reset(new unsigned char[inLength]);
+        memcpy(copy.get(), in, inLength);
+        in = copy.get();
+    }
+    return EVP_CipherUpdate(ctx, out, outl, in, inLength);
+}
+
 /*
  *  public static native int EVP_CipherUpdate(int ctx, byte[] out, int outOffset, byte[] in,
  *          int inOffset);
@@ -3491,6 +3949,30 @@ static jint NativeCrypto_EVP_CipherUpdate(JNIEnv* env, jclass, jlong ctxRef, jby
         return 0;
     }
 
+    if (inArray != NULL && env->IsSameObject(inArray, outArray)) {
+        // In place: pin the array once, read-write.
+        ScopedByteArrayRW bytes(env, outArray);
+        if (bytes.get() == NULL) {
+            return 0;
+        }
+        if (inOffset < 0 || outOffset < 0 || inLength < 0
+                || size_t(inOffset + inLength) > bytes.size()
+                || size_t(outOffset + inLength) > bytes.size()) {
+            jniThrowException(env, "java/lang/IndexOutOfBoundsException", NULL);
+            return 0;
+        }
+        unsigned char* base = reinterpret_cast<unsigned char*>(bytes.get());
+        int outl;
+        if (!cipherUpdate(ctx, base + outOffset, &outl, base + inOffset, inLength)) {
+            throwExceptionIfNecessary(env, "EVP_CipherUpdate");
+            JNI_TRACE("ctx=%p EVP_CipherUpdate => threw error", ctx);
+            return 0;
+        }
+        JNI_TRACE("EVP_CipherUpdate(%p, %p, %d, in place, %d) => %d", ctx, outArray, outOffset,
+                inOffset, outl);
+        return outl;
+    }
+
     ScopedByteArrayRO inBytes(env, inArray);
     if (inBytes.get() == NULL) {
         return 0;
@@ -3520,7 +4002,7 @@ static jint NativeCrypto_EVP_CipherUpdate(JNIEnv* env, jclass, jlong ctxRef, jby
     const unsigned char* in = reinterpret_cast<const unsigned char*>(inBytes.get());
 
     int outl;
-    if (!EVP_CipherUpdate(ctx, out + outOffset, &outl, in + inOffset, inLength)) {
+    if (!cipherUpdate(ctx, out + outOffset, &outl, in + inOffset, inLength)) {
         throwExceptionIfNecessary(env, "EVP_CipherUpdate");
         JNI_TRACE("ctx=%p EVP_CipherUpdate => threw error", ctx);
         return 0;
@@ -3560,80 +4042,331 @@ static jint NativeCrypto_EVP_CipherFinal_ex(JNIEnv* env, jclass, jlong ctxRef, j
     return outl;
 }
 
-static jint NativeCrypto_EVP_CIPHER_iv_length(JNIEnv* env, jclass, jlong evpCipherRef) {
-    const EVP_CIPHER* evpCipher = reinterpret_cast<const EVP_CIPHER*>(evpCipherRef);
-    JNI_TRACE("EVP_CIPHER_iv_length(%p)", evpCipher);
+/*
+ *  public static native int EVP_CipherUpdate_direct(long ctx, ByteBuffer out, int outOffset,
+ *          ByteBuffer in, int inOffset, int inLength);
+ */
+static jint NativeCrypto_EVP_CipherUpdate_direct(JNIEnv* env, jclass, jlong ctxRef,
+        jobject outBuffer, jint outOffset, jobject inBuffer, jint inOffset, jint inLength) {
+    EVP_CIPHER_CTX* ctx = reinterpret_cast<EVP_CIPHER_CTX*>(ctxRef);
+    JNI_TRACE("EVP_CipherUpdate_direct(%p, %p, %d, %p, %d, %d)", ctx, outBuffer, outOffset,
+            inBuffer, inOffset, inLength);
 
-    if (evpCipher == NULL) {
-        jniThrowNullPointerException(env, "evpCipher == null");
-        JNI_TRACE("EVP_CIPHER_iv_length => evpCipher == null");
+    if (ctx == NULL) {
+        jniThrowNullPointerException(env, "ctx == null");
+        JNI_TRACE("ctx=%p EVP_CipherUpdate_direct => ctx == null", ctx);
+        return 0;
+    }
+    const unsigned char* in = directBufferRange(env, inBuffer, inOffset, inLength);
+    if (in == NULL) {
+        return 0;
+    }
+    // As for arrays, the caller makes sure there's room for any buffered partial block too.
+    unsigned char* out = directBufferRange(env, outBuffer, outOffset, inLength);
+    if (out == NULL) {
         return 0;
     }
 
-    const int ivLength = EVP_CIPHER_iv_length(evpCipher);
-    JNI_TRACE("EVP_CIPHER_iv_length(%p) => %d", evpCipher, ivLength);
-    return ivLength;
-}
-
-static jlong NativeCrypto_EVP_CIPHER_CTX_new(JNIEnv* env, jclass) {
-    JNI_TRACE("EVP_CIPHER_CTX_new()");
-
-    Unique_EVP_CIPHER_CTX ctx(EVP_CIPHER_CTX_new());
-    if (ctx.get() == NULL) {
-        jniThrowOutOfMemory(env, "Unable to allocate cipher context");
-        JNI_TRACE("EVP_CipherInit_ex => context allocation error");
+    int outl;
+    if (!cipherUpdate(ctx, out, &outl, in, inLength)) {
+        throwExceptionIfNecessary(env, "EVP_CipherUpdate_direct");
+        JNI_TRACE("ctx=%p EVP_CipherUpdate_direct => threw error", ctx);
         return 0;
     }
 
-    JNI_TRACE("EVP_CIPHER_CTX_new() => %p", ctx.get());
-    return reinterpret_cast<uintptr_t>(ctx.release());
+    JNI_TRACE("EVP_CipherUpdate_direct(%p, %p, %d, %p, %d) => %d", ctx, outBuffer, outOffset,
+            inBuffer, inOffset, outl);
+    return outl;
 }
 
-static jint NativeCrypto_EVP_CIPHER_CTX_block_size(JNIEnv* env, jclass, jlong ctxRef) {
+static jint NativeCrypto_EVP_CipherFinal_ex_direct(JNIEnv* env, jclass, jlong ctxRef,
+        jobject outBuffer, jint outOffset) {
     EVP_CIPHER_CTX* ctx = reinterpret_cast<EVP_CIPHER_CTX*>(ctxRef);
-    JNI_TRACE("EVP_CIPHER_CTX_block_size(%p)", ctx);
+    JNI_TRACE("EVP_CipherFinal_ex_direct(%p, %p, %d)", ctx, outBuffer, outOffset);
 
     if (ctx == NULL) {
         jniThrowNullPointerException(env, "ctx == null");
-        JNI_TRACE("ctx=%p EVP_CIPHER_CTX_block_size => ctx == null", ctx);
+        JNI_TRACE("ctx=%p EVP_CipherFinal_ex_direct => ctx == null", ctx);
+        return 0;
+    }
+    unsigned char* out = directBufferRange(env, outBuffer, outOffset, 0);
+    if (out == NULL) {
         return 0;
     }
 
-    int blockSize = EVP_CIPHER_CTX_block_size(ctx);
-    JNI_TRACE("EVP_CIPHER_CTX_block_size(%p) => %d", ctx, blockSize);
-    return blockSize;
-}
-
-static jint NativeCrypto_get_EVP_CIPHER_CTX_buf_len(JNIEnv* env, jclass, jlong ctxRef) {
-    EVP_CIPHER_CTX* ctx = reinterpret_cast<EVP_CIPHER_CTX*>(ctxRef);
-    JNI_TRACE("get_EVP_CIPHER_CTX_buf_len(%p)", ctx);
-
-    if (ctx == NULL) {
-        jniThrowNullPointerException(env, "ctx == null");
-        JNI_TRACE("ctx=%p get_EVP_CIPHER_CTX_buf_len => ctx == null", ctx);
+    // The final block may be shorter than a block, so there needn't be room for a whole one.
+    size_t room = env->GetDirectBufferCapacity(outBuffer) - outOffset;
+    unsigned char lastBlock[EVP_MAX_BLOCK_LENGTH];
+    bool useLastBlock = room < size_t(EVP_CIPHER_CTX_block_size(ctx));
+    int outl;
+    if (!EVP_CipherFinal_ex(ctx, useLastBlock ? lastBlock : out, &outl)) {
+        throwExceptionIfNecessary(env, "EVP_CipherFinal_ex_direct");
+        JNI_TRACE("ctx=%p EVP_CipherFinal_ex_direct => threw error", ctx);
         return 0;
     }
+    if (useLastBlock) {
+        if (size_t(outl) > room) {
+            jniThrowException(env, "java/lang/IndexOutOfBoundsException", NULL);
+            return 0;
+        }
+        memcpy(out, lastBlock, outl);
+    }
 
-    int buf_len = ctx->buf_len;
-    JNI_TRACE("get_EVP_CIPHER_CTX_buf_len(%p) => %d", ctx, buf_len);
-    return buf_len;
+    JNI_TRACE("EVP_CipherFinal_ex_direct(%p, %p, %d) => %d", ctx, outBuffer, outOffset, outl);
+    return outl;
 }
 
-static void NativeCrypto_EVP_CIPHER_CTX_set_padding(JNIEnv* env, jclass, jlong ctxRef, jboolean enablePaddingBool) {
-    EVP_CIPHER_CTX* ctx = reinterpret_cast<EVP_CIPHER_CTX*>(ctxRef);
-    jint enablePadding = enablePaddingBool ? 1 : 0;
-    JNI_TRACE("EVP_CIPHER_CTX_set_padding(%p, %d)", ctx, enablePadding);
+/**
+ * Seals (encrypting) or opens (decrypting) a whole message with an AEAD cipher such as
+ * aes-128-gcm, in one call with a context on the stack. Sealing writes the ciphertext followed
+ * by a tagLength-byte tag; opening expects that layout and fails with BadPaddingException if
+ * the tag doesn't match. in and out may be the same array.
+ */
+static jint aeadCrypt(JNIEnv* env, bool sealing, jlong evpCipherRef, jbyteArray keyArray,
+        jbyteArray nonceArray, jbyteArray adArray, jbyteArray inArray, jint inOffset,
+        jint inLength, jbyteArray outArray, jint outOffset, jint tagLength) {
+    const EVP_CIPHER* evpCipher = reinterpret_cast<const EVP_CIPHER*>(evpCipherRef);
+    const char* name = sealing ? "EVP_aead_seal" : "EVP_aead_open";
+    JNI_TRACE("%s(%p, %p, %p, %p, %p, %d, %d, %p, %d, %d)", name, evpCipher, keyArray, nonceArray,
+            adArray, inArray, inOffset, inLength, outArray, outOffset, tagLength);
 
-    if (ctx == NULL) {
-        jniThrowNullPointerException(env, "ctx == null");
-        JNI_TRACE("ctx=%p EVP_CIPHER_CTX_set_padding => ctx == null", ctx);
-        return;
+    if (evpCipher == NULL || keyArray == NULL || nonceArray == NULL || inArray == NULL
+            || outArray == NULL) {
+        jniThrowNullPointerException(env, NULL);
+        return 0;
+    }
+    if (tagLength < 1 || tagLength > 16 || (!sealing && inLength < tagLength)) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "bad tag length");
+        return 0;
+    }
+    ScopedByteArrayRO key(env, keyArray);
+    if (key.get() == NULL) {
+        return 0;
+    }
+    ScopedByteArrayRO nonce(env, nonceArray);
+    if (nonce.get() == NULL) {
+        return 0;
+    }
+    UniquePtr<ScopedByteArrayRO> ad;
+    if (adArray != NULL) {
+        ad.reset(new ScopedByteArrayRO(env, adArray));
+        if (ad->get() == NULL) {
+            return 0;
+        }
+    }
+    ScopedByteArrayRW outBytes(env, outArray);
+    if (outBytes.get() == NULL) {
+        return 0;
+    }
+    UniquePtr<ScopedByteArrayRO> inBytes;
+    const jbyte* inBase;
+    size_t inSize;
+    if (env->IsSameObject(inArray, outArray)) {
+        inBase = outBytes.get();
+        inSize = outBytes.size();
+    } else {
+        inBytes.reset(new ScopedByteArrayRO(env, inArray));
+        if (inBytes->get() == NULL) {
+            return 0;
+        }
+        inBase = inBytes->get();
+        inSize = inBytes->size();
+    }
+    int textLength = sealing ? inLength : inLength - tagLength;
+    int outLength = sealing ? inLength + tagLength : textLength;
+    if (inOffset < 0 || inLength < 0 || outOffset < 0 || size_t(inOffset + inLength) > inSize
+            || size_t(outOffset + outLength) > outBytes.size()) {
+        jniThrowException(env, "java/lang/IndexOutOfBoundsException", NULL);
+        return 0;
+    }
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(inBase + inOffset);
+    unsigned char* out = reinterpret_cast<unsigned char*>(outBytes.get() + outOffset);
+
+    // The tag is at the end of the input, which decrypting in place may overwrite.
+    unsigned char tag[16];
+    if (!sealing) {
+        memcpy(tag, in + textLength, tagLength);
+    }
+
+    EVP_CIPHER_CTX ctx;
+    EVP_CIPHER_CTX_init(&ctx);
+    int outl;
+    int finall;
+    bool ok = EVP_CipherInit_ex(&ctx, evpCipher, NULL, NULL, NULL, sealing ? 1 : 0)
+            && EVP_CIPHER_CTX_ctrl(&ctx, EVP_CTRL_GCM_SET_IVLEN, nonce.size(), NULL)
+            && EVP_CipherInit_ex(&ctx, NULL, NULL,
+                    reinterpret_cast<const unsigned char*>(key.get()),
+                    reinterpret_cast<const unsigned char*>(nonce.get()), -1)
+            && (ad.get() == NULL || ad->size() == 0
+                || EVP_CipherUpdate(&ctx, NULL, &outl,
+                        reinterpret_cast<const unsigned char*>(ad->get()), ad->size()))
+            && (sealing || EVP_CIPHER_CTX_ctrl(&ctx, EVP_CTRL_GCM_SET_TAG, tagLength, tag))
+            && cipherUpdate(&ctx, out, &outl, in, textLength);
+    // Opening only fails in the final step if the tag doesn't match.
+    bool tagMismatch = false;
+    if (ok) {
+        tagMismatch = !EVP_CipherFinal_ex(&ctx, out + outl, &finall);
+        ok = !tagMismatch;
+    }
+    if (ok && sealing) {
+        ok = EVP_CIPHER_CTX_ctrl(&ctx, EVP_CTRL_GCM_GET_TAG, tagLength, out + outl + finall);
+    }
+    EVP_CIPHER_CTX_cleanup(&ctx);
+
+    if (!ok) {
+        if (!throwExceptionIfNecessary(env, name)) {
+            if (tagMismatch && !sealing) {
+                throwBadPaddingException(env, "tag mismatch");
+            } else {
+                jniThrowRuntimeException(env, name);
+            }
+        }
+        if (!sealing) {
+            // Don't leave unauthenticated plaintext behind.
+            memset(out, 0, textLength);
+        }
+        JNI_TRACE("%s => threw error", name);
+        return 0;
+    }
+    JNI_TRACE("%s => %d", name, outLength);
+    return outLength;
+}
+
+static jint NativeCrypto_EVP_aead_seal(JNIEnv* env, jclass, jlong evpCipherRef,
+        jbyteArray keyArray, jbyteArray nonceArray, jbyteArray adArray, jbyteArray inArray,
+        jint inOffset, jint inLength, jbyteArray outArray, jint outOffset, jint tagLength) {
+    return aeadCrypt(env, true, evpCipherRef, keyArray, nonceArray, adArray, inArray, inOffset,
+            inLength, outArray, outOffset, tagLength);
+}
+
+static jint NativeCrypto_EVP_aead_open(JNIEnv* env, jclass, jlong evpCipherRef,
+        jbyteArray keyArray, jbyteArray nonceArray, jbyteArray adArray, jbyteArray inArray,
+        jint inOffset, jint inLength, jbyteArray outArray, jint outOffset, jint tagLength) {
+    return aeadCrypt(env, false, evpCipherRef, keyArray, nonceArray, adArray, inArray, inOffset,
+            inLength, outArray, outOffset, tagLength);
+}
+
+static jint NativeCrypto_EVP_CIPHER_iv_length(JNIEnv* env, jclass, jlong evpCipherRef) {
+    const EVP_CIPHER* evpCipher = reinterpret_cast<const EVP_CIPHER*>(evpCipherRef);
+    JNI_TRACE("EVP_CIPHER_iv_length(%p)", evpCipher);
+
+    if (evpCipher == NULL) {
+        jniThrowNullPointerException(env, "evpCipher == null");
+        JNI_TRACE("EVP_CIPHER_iv_length => evpCipher == null");
+        return 0;
+    }
+
+    const int ivLength = EVP_CIPHER_iv_length(evpCipher);
+    JNI_TRACE("EVP_CIPHER_iv_length(%p) => %d", evpCipher, ivLength);
+    return ivLength;
+}
+
+static jlong NativeCrypto_EVP_CIPHER_CTX_new(JNIEnv* env, jclass) {
+    JNI_TRACE("EVP_CIPHER_CTX_new()");
+
+    Unique_EVP_CIPHER_CTX ctx(EVP_CIPHER_CTX_new());
+    if (ctx.get() == NULL) {
+        jniThrowOutOfMemory(env, "Unable to allocate cipher context");
+        JNI_TRACE("EVP_CipherInit_ex => context allocation error");
+        return 0;
+    }
+
+    JNI_TRACE("EVP_CIPHER_CTX_new() => %p", ctx.get());
+    return reinterpret_cast<uintptr_t>(ctx.release());
+}
+
+/**
+ * Like EVP_CIPHER_CTX_new, but returns a context last used with evpCipher from the pool if
+ * there is one.
+ */
+static jlong NativeCrypto_EVP_CIPHER_CTX_new_pooled(JNIEnv* env, jclass, jlong evpCipherRef) {
+    const EVP_CIPHER* evpCipher = reinterpret_cast<const EVP_CIPHER*>(evpCipherRef);
+    JNI_TRACE("EVP_CIPHER_CTX_new_pooled(%p)", evpCipher);
+
+    EVP_CIPHER_CTX* ctx = reinterpret_cast<EVP_CIPHER_CTX*>(
+            contextPoolTake(&gCipherCtxPool, evpCipher));
+    if (ctx == NULL) {
+        return NativeCrypto_EVP_CIPHER_CTX_new(env, NULL);
+    }
+
+    JNI_TRACE("EVP_CIPHER_CTX_new_pooled(%p) => %p", evpCipher, ctx);
+    return reinterpret_cast<uintptr_t>(ctx);
+}
+
+/**
+ * Frees ctx, or wipes its key and data and keeps it for EVP_CIPHER_CTX_new_pooled.
+ */
+static void NativeCrypto_EVP_CIPHER_CTX_free(JNIEnv*, jclass, jlong ctxRef) {
+    EVP_CIPHER_CTX* ctx = reinterpret_cast<EVP_CIPHER_CTX*>(ctxRef);
+    JNI_TRACE("EVP_CIPHER_CTX_free(%p)", ctx);
+
+    if (ctx == NULL) {
+        return;
+    }
+    // Ciphers with a custom copy keep pointers into cipher_data, so those aren't wiped and kept.
+    const EVP_CIPHER* cipher = EVP_CIPHER_CTX_cipher(ctx);
+    if (cipher != NULL && !(EVP_CIPHER_flags(cipher) & EVP_CIPH_CUSTOM_COPY)) {
+        if (ctx->cipher_data != NULL) {
+            OPENSSL_cleanse(ctx->cipher_data, cipher->ctx_size);
+        }
+        OPENSSL_cleanse(ctx->oiv, sizeof(ctx->oiv));
+        OPENSSL_cleanse(ctx->iv, sizeof(ctx->iv));
+        OPENSSL_cleanse(ctx->buf, sizeof(ctx->buf));
+        OPENSSL_cleanse(ctx->final, sizeof(ctx->final));
+        ctx->buf_len = 0;
+        ctx->final_used = 0;
+        if (contextPoolPut(&gCipherCtxPool, cipher, ctx)) {
+            return;
+        }
+    }
+    EVP_CIPHER_CTX_free(ctx);
+}
+
+static jint NativeCrypto_EVP_CIPHER_CTX_block_size(JNIEnv* env, jclass, jlong ctxRef) {
+    EVP_CIPHER_CTX* ctx = reinterpret_cast<EVP_CIPHER_CTX*>(ctxRef);
+    JNI_TRACE("EVP_CIPHER_CTX_block_size(%p)", ctx);
+
+    if (ctx == NULL) {
+        jniThrowNullPointerException(env, "ctx == null");
+        JNI_TRACE("ctx=%p EVP_CIPHER_CTX_block_size => ctx == null", ctx);
+        return 0;
+    }
+
+    int blockSize = EVP_CIPHER_CTX_block_size(ctx);
+    JNI_TRACE("EVP_CIPHER_CTX_block_size(%p) => %d", ctx, blockSize);
+    return blockSize;
+}
+
+static jint NativeCrypto_get_EVP_CIPHER_CTX_buf_len(JNIEnv* env, jclass, jlong ctxRef) {
+    EVP_CIPHER_CTX* ctx = reinterpret_cast<EVP_CIPHER_CTX*>(ctxRef);
+    JNI_TRACE("get_EVP_CIPHER_CTX_buf_len(%p)", ctx);
+
+    if (ctx == NULL) {
+        jniThrowNullPointerException(env, "ctx == null");
+        JNI_TRACE("ctx=%p get_EVP_CIPHER_CTX_buf_len => ctx == null", ctx);
+        return 0;
+    }
+
+    int buf_len = ctx->buf_len;
+    JNI_TRACE("get_EVP_CIPHER_CTX_buf_len(%p) => %d", ctx, buf_len);
+    return buf_len;
+}
+
+static void NativeCrypto_EVP_CIPHER_CTX_set_padding(JNIEnv* env, jclass, jlong ctxRef, jboolean enablePaddingBool) {
+    EVP_CIPHER_CTX* ctx = reinterpret_cast<EVP_CIPHER_CTX*>(ctxRef);
+    jint enablePadding = enablePaddingBool ? 1 : 0;
+    JNI_TRACE("EVP_CIPHER_CTX_set_padding(%p, %d)", ctx, enablePadding);
+
+    if (ctx == NULL) {
+        jniThrowNullPointerException(env, "ctx == null");
+        JNI_TRACE("ctx=%p EVP_CIPHER_CTX_set_padding => ctx == null", ctx);
+        return;
     }
 
-    EVP_CIPHER_CTX_set_padding(ctx, enablePadding); // Not void, but always returns 1.
-    JNI_TRACE("EVP_CIPHER_CTX_set_padding(%p, %d) => success", ctx, enablePadding);
-}
-
+    EVP_CIPHER_CTX_set_padding(ctx, enablePadding); // Not void, but always returns 1.
+    JNI_TRACE("EVP_CIPHER_CTX_set_padding(%p, %d) => success", ctx, enablePadding);
+}
+
 static void NativeCrypto_EVP_CIPHER_CTX_set_key_length(JNIEnv* env, jclass, jlong ctxRef,
         jint keySizeBits) {
     EVP_CIPHER_CTX* ctx = reinterpret_cast<EVP_CIPHER_CTX*>(ctxRef);
@@ -3667,6 +4400,71 @@ static void NativeCrypto_EVP_CIPHER_CTX_cleanup(JNIEnv* env, jclass, jlong ctxRe
     JNI_TRACE("EVP_CIPHER_CTX_cleanup(%p) => success", ctx);
 }
 
+/*
+ * Small random requests, like nonces and tokens, are served from a buffer per thread that's
+ * refilled from RAND_bytes a page at a time, so that they neither take the RNG's lock nor pin
+ * the Java array. Bytes are wiped from the buffer as they're handed out. Seeding the RNG, or
+ * forking, bumps a generation count that makes every thread discard what it has buffered: a
+ * child mustn't hand out the same bytes as its parent, and bytes asked for after a reseed
+ * should come from the reseeded RNG.
+ */
+static const size_t RAND_BUFFER_SIZE = 4096;
+static const size_t RAND_BUFFERED_MAX = 64;
+
+struct RandBuffer {
+    unsigned char bytes[RAND_BUFFER_SIZE];
+    // The unused bytes are the last available of bytes.
+    size_t available;
+    unsigned generation;
+};
+
+static pthread_once_t gRandBufferOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t gRandBufferKey;
+static unsigned gRandGeneration;
+
+static void randBufferInvalidate() {
+    __atomic_add_fetch(&gRandGeneration, 1, __ATOMIC_RELEASE);
+}
+
+static void randBufferFree(void* ptr) {
+    RandBuffer* buffer = static_cast<RandBuffer*>(ptr);
+    OPENSSL_cleanse(buffer, sizeof(*buffer));
+    delete buffer;
+}
+
+static void randBufferInit() {
+    pthread_key_create(&gRandBufferKey, randBufferFree);
+    pthread_atfork(NULL, NULL, randBufferInvalidate);
+}
+
+static bool randBufferedBytes(unsigned char* out, size_t length) {
+    pthread_once(&gRandBufferOnce, randBufferInit);
+    RandBuffer* buffer = static_cast<RandBuffer*>(pthread_getspecific(gRandBufferKey));
+    if (buffer == NULL) {
+        buffer = new RandBuffer;
+        buffer->available = 0;
+        buffer->generation = 0;
+        pthread_setspecific(gRandBufferKey, buffer);
+    }
+
+    unsigned generation = __atomic_load_n(&gRandGeneration, __ATOMIC_ACQUIRE);
+    if (buffer->generation != generation || buffer->available < length) {
+        if (RAND_bytes(buffer->bytes, sizeof(buffer->bytes)) <= 0) {
+            OPENSSL_cleanse(buffer->bytes, sizeof(buffer->bytes));
+            buffer->available = 0;
+            return false;
+        }
+        buffer->available = sizeof(buffer->bytes);
+        buffer->generation = generation;
+    }
+
+    unsigned char* start = buffer->bytes + sizeof(buffer->bytes) - buffer->available;
+    memcpy(out, start, length);
+    OPENSSL_cleanse(start, length);
+    buffer->available -= length;
+    return true;
+}
+
 /**
  * public static native void RAND_seed(byte[]);
  */
@@ -3677,6 +4475,7 @@ static void NativeCrypto_RAND_seed(JNIEnv* env, jclass, jbyteArray seed) {
         return;
     }
     RAND_seed(randseed.get(), randseed.size());
+    randBufferInvalidate();
 }
 
 static jint NativeCrypto_RAND_load_file(JNIEnv* env, jclass, jstring filename, jlong max_bytes) {
@@ -3686,6 +4485,7 @@ static jint NativeCrypto_RAND_load_file(JNIEnv* env, jclass, jstring filename, j
         return -1;
     }
     int result = RAND_load_file(file.c_str(), max_bytes);
+    randBufferInvalidate();
     JNI_TRACE("NativeCrypto_RAND_load_file file=%s => %d", file.c_str(), result);
     return result;
 }
@@ -3693,6 +4493,24 @@ static jint NativeCrypto_RAND_load_file(JNIEnv* env, jclass, jstring filename, j
 static void NativeCrypto_RAND_bytes(JNIEnv* env, jclass, jbyteArray output) {
     JNI_TRACE("NativeCrypto_RAND_bytes(%p)", output);
 
+    if (output == NULL) {
+        jniThrowNullPointerException(env, "output == null");
+        return;
+    }
+    jsize length = env->GetArrayLength(output);
+    if (static_cast<size_t>(length) <= RAND_BUFFERED_MAX) {
+        unsigned char bytes[RAND_BUFFERED_MAX];
+        if (!randBufferedBytes(bytes, length)) {
+            throwExceptionIfNecessary(env, "NativeCrypto_RAND_bytes");
+            JNI_TRACE("NativeCrypto_RAND_bytes(%p) => threw error", output);
+            return;
+        }
+        env->SetByteArrayRegion(output, 0, length, reinterpret_cast<jbyte*>(bytes));
+        OPENSSL_cleanse(bytes, length);
+        JNI_TRACE("NativeCrypto_RAND_bytes(%p) => buffered", output);
+        return;
+    }
+
     ScopedByteArrayRW outputBytes(env, output);
     if (outputBytes.get() == NULL) {
         return;
@@ -3801,6 +4619,81 @@ static jlong NativeCrypto_create_BIO_OutputStream(JNIEnv* env, jclass, jobject s
     return static_cast<jlong>(reinterpret_cast<uintptr_t>(bio.release()));
 }
 
+/*
+ * public static native long create_BIO_fd(FileDescriptor fd)
+ */
+static jlong NativeCrypto_create_BIO_fd(JNIEnv* env, jclass, jobject fileDescriptor) {
+    JNI_TRACE("create_BIO_fd(%p)", fileDescriptor);
+
+    if (fileDescriptor == NULL) {
+        jniThrowNullPointerException(env, "fd == null");
+        return 0;
+    }
+    int fd = jniGetFDFromFileDescriptor(env, fileDescriptor);
+
+    // Anything but a regular file is left to the stream BIO, which reads only what it needs.
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+        JNI_TRACE("create_BIO_fd(%p) => not a regular file", fileDescriptor);
+        return 0;
+    }
+    off_t start = lseek(fd, 0, SEEK_CUR);
+    if (start == -1 || start >= st.st_size || st.st_size - start > INT_MAX) {
+        JNI_TRACE("create_BIO_fd(%p) => nothing to read", fileDescriptor);
+        return 0;
+    }
+    size_t length = st.st_size - start;
+
+    UniquePtr<BIO_Region> region(bio_region_new());
+    region->chunk = static_cast<char*>(malloc(std::min(length, BIO_REGION_CHUNK_SIZE)));
+    if (region->chunk == NULL) {
+        jniThrowOutOfMemory(env, "Unable to allocate file buffer");
+        return 0;
+    }
+    region->length = length;
+    region->fd = fd;
+    region->fdStart = start;
+
+    Unique_BIO bio(BIO_new(&region_bio_method));
+    if (bio.get() == NULL) {
+        jniThrowOutOfMemory(env, "Unable to allocate BIO");
+        return 0;
+    }
+    bio->ptr = region.release();
+
+    JNI_TRACE("create_BIO_fd(%p) => %p", fileDescriptor, bio.get());
+    return static_cast<jlong>(reinterpret_cast<uintptr_t>(bio.release()));
+}
+
+/*
+ * public static native long create_BIO_direct(ByteBuffer buffer, int offset, int length)
+ */
+static jlong NativeCrypto_create_BIO_direct(JNIEnv* env, jclass, jobject buffer, jint offset,
+                                            jint length) {
+    JNI_TRACE("create_BIO_direct(%p, %d, %d)", buffer, offset, length);
+
+    const unsigned char* data = directBufferRange(env, buffer, offset, length);
+    if (data == NULL) {
+        JNI_TRACE("create_BIO_direct(%p, %d, %d) => bad buffer", buffer, offset, length);
+        return 0;
+    }
+
+    UniquePtr<BIO_Region> region(bio_region_new());
+    region->data = reinterpret_cast<const char*>(data);
+    region->length = length;
+
+    Unique_BIO bio(BIO_new(&region_bio_method));
+    if (bio.get() == NULL) {
+        jniThrowOutOfMemory(env, "Unable to allocate BIO");
+        return 0;
+    }
+    region->buffer = env->NewGlobalRef(buffer);
+    bio->ptr = region.release();
+
+    JNI_TRACE("create_BIO_direct(%p, %d, %d) => %p", buffer, offset, length, bio.get());
+    return static_cast<jlong>(reinterpret_cast<uintptr_t>(bio.release()));
+}
+
 static int NativeCrypto_BIO_read(JNIEnv* env, jclass, jlong bioRef, jbyteArray outputJavaBytes) {
     BIO* bio = reinterpret_cast<BIO*>(static_cast<uintptr_t>(bioRef));
     JNI_TRACE("BIO_read(%p, %p)", bio, outputJavaBytes);
@@ -4767,7 +5660,21 @@ static jlong NativeCrypto_d2i_X509_bio(JNIEnv* env, jclass, jlong bioRef) {
 }
 
 static jlong NativeCrypto_d2i_X509(JNIEnv* env, jclass, jbyteArray certBytes) {
-    X509* x = ByteArrayToASN1<X509, d2i_X509>(env, certBytes);
+    ScopedByteArrayRO bytes(env, certBytes);
+    if (bytes.get() == NULL) {
+        JNI_TRACE("d2i_X509(%p) => using byte array failed", certBytes);
+        return 0;
+    }
+    const unsigned char* der = reinterpret_cast<const unsigned char*>(bytes.get());
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(der, bytes.size(), digest);
+    X509* x = x509InternLookup(digest);
+    if (x == NULL) {
+        x = d2i_X509(NULL, &der, bytes.size());
+        if (x != NULL) {
+            x = x509Intern(digest, x);
+        }
+    }
     return reinterpret_cast<uintptr_t>(x);
 }
 
@@ -4812,7 +5719,23 @@ static jlong PEM_ASN1Object_to_jlong(JNIEnv* env, jlong bioRef) {
 
 static jlong NativeCrypto_PEM_read_bio_X509(JNIEnv* env, jclass, jlong bioRef) {
     JNI_TRACE("PEM_read_bio_X509(0x%llx)", bioRef);
-    return PEM_ASN1Object_to_jlong<X509, PEM_read_bio_X509>(env, bioRef);
+    X509* x = reinterpret_cast<X509*>(
+            PEM_ASN1Object_to_jlong<X509, PEM_read_bio_X509>(env, bioRef));
+    if (x == NULL) {
+        return 0;
+    }
+    // PEM has to be parsed to find the DER, but the parsed certificate is still shared.
+    unsigned char* der = NULL;
+    int derLength = i2d_X509(x, &der);
+    if (derLength > 0) {
+        unsigned char digest[SHA256_DIGEST_LENGTH];
+        SHA256(der, derLength, digest);
+        OPENSSL_free(der);
+        x = x509Intern(digest, x);
+    } else {
+        freeOpenSslErrorState();
+    }
+    return reinterpret_cast<uintptr_t>(x);
 }
 
 static jlong NativeCrypto_PEM_read_bio_X509_CRL(JNIEnv* env, jclass, jlong bioRef) {
@@ -5509,24 +6432,24 @@ static jobjectArray getPrincipalBytes(JNIEnv* env, const STACK_OF(X509_NAME)* na
  * the Java layer ensures that no more threads will enter the native code at the
  * same time.
  *
- * (3) The pipe is used primarily as a means of cancelling a blocking select()
- * when we want to close the connection (aka "emergency button"). It is also
- * necessary for dealing with a possible race condition situation: There might
- * be cases where both threads see an SSL_ERROR_WANT_READ or
- * SSL_ERROR_WANT_WRITE. Both will enter a select() with the proper argument.
- * If one leaves the select() successfully before the other enters it, the
- * "success" event is already consumed and the second thread will be blocked,
- * possibly forever (depending on network conditions).
+ * (3) The emergency eventfd is used primarily as a means of cancelling a
+ * blocking poll() when we want to close the connection (aka "emergency
+ * button"). It is also necessary for dealing with a possible race condition
+ * situation: There might be cases where both threads see an
+ * SSL_ERROR_WANT_READ or SSL_ERROR_WANT_WRITE. Both will enter a poll() with
+ * the proper argument. If one leaves the poll() successfully before the other
+ * enters it, the "success" event is already consumed and the second thread
+ * will be blocked, possibly forever (depending on network conditions).
  *
  * The idea for solving the problem looks like this: Whenever a thread is
  * successful in moving around data on the network, and it knows there is
- * another thread stuck in a select(), it will write a byte to the pipe, waking
- * up the other thread. A thread that returned from select(), on the other hand,
- * knows whether it's been woken up by the pipe. If so, it will consume the
- * byte, and the original state of affairs has been restored.
+ * another thread stuck in a poll(), it will add a token to the eventfd, waking
+ * up the other thread. A thread that returned from poll(), on the other hand,
+ * knows whether it's been woken up by the eventfd. If so, it will consume the
+ * token, and the original state of affairs has been restored.
  *
- * The pipe may seem like a bit of overhead, but it fits in nicely with the
- * other file descriptors of the select(), so there's only one condition to wait
+ * The eventfd may seem like a bit of overhead, but it fits in nicely with the
+ * other file descriptor of the poll(), so there's only one condition to wait
  * for.
  *
  * (4) Finally, a mutex is needed to make sure that at most one thread is in
@@ -5576,7 +6499,7 @@ class AppData {
   public:
     volatile int aliveAndKicking;
     int waitingThreads;
-    int fdsEmergency[2];
+    int fdEmergency;
     MUTEX_TYPE mutex;
     JNIEnv* env;
     jobject sslHandshakeCallbacks;
@@ -5596,11 +6519,14 @@ class AppData {
   public:
     static AppData* create() {
         UniquePtr<AppData> appData(new AppData());
-        if (pipe(appData.get()->fdsEmergency) == -1) {
-            ALOGE("AppData::create pipe(2) failed: %s", strerror(errno));
+        // A semaphore-mode eventfd behaves like the pipe this used to be, a token per
+        // sslNotify, for one fd rather than two.
+        appData.get()->fdEmergency = eventfd(0, EFD_SEMAPHORE);
+        if (appData.get()->fdEmergency == -1) {
+            ALOGE("AppData::create eventfd(2) failed: %s", strerror(errno));
             return NULL;
         }
-        if (!setBlocking(appData.get()->fdsEmergency[0], false)) {
+        if (!setBlocking(appData.get()->fdEmergency, false)) {
             ALOGE("AppData::create fcntl(2) failed: %s", strerror(errno));
             return NULL;
         }
@@ -5613,11 +6539,8 @@ class AppData {
 
     ~AppData() {
         aliveAndKicking = 0;
-        if (fdsEmergency[0] != -1) {
-            close(fdsEmergency[0]);
-        }
-        if (fdsEmergency[1] != -1) {
-            close(fdsEmergency[1]);
+        if (fdEmergency != -1) {
+            close(fdEmergency);
         }
         clearCallbackState();
         MUTEX_CLEANUP(mutex);
@@ -5627,6 +6550,7 @@ class AppData {
     AppData() :
             aliveAndKicking(1),
             waitingThreads(0),
+            fdEmergency(-1),
             env(NULL),
             sslHandshakeCallbacks(NULL),
             npnProtocolsArray(NULL),
@@ -5637,8 +6561,6 @@ class AppData {
             alpnProtocolsLength(-1),
             ephemeralRsa(NULL),
             ephemeralEc(NULL) {
-        fdsEmergency[0] = -1;
-        fdsEmergency[1] = -1;
     }
 
   public:
@@ -5721,22 +6643,20 @@ class AppData {
  * @param type Either SSL_ERROR_WANT_READ or SSL_ERROR_WANT_WRITE
  * @param fdObject The FileDescriptor, since appData->fileDescriptor should be NULL
  * @param appData The application data structure with mutex info etc.
- * @param timeout_millis The timeout value for select call, with the special value
+ * @param timeout_millis The timeout value for poll call, with the special value
  *                0 meaning no timeout at all (wait indefinitely). Note: This is
  *                the Java semantics of the timeout value, not the usual
- *                select() semantics.
- * @return The result of the inner select() call,
+ *                poll() semantics.
+ * @return The result of the inner poll() call,
  * THROW_SOCKETEXCEPTION if a SocketException was thrown, -1 on
  * additional errors
  */
 static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData, int timeout_millis) {
     // This loop is an expanded version of the NET_FAILURE_RETRY
-    // macro. It cannot simply be used in this case because select
-    // cannot be restarted without recreating the fd_sets and timeout
-    // structure.
+    // macro. It cannot simply be used in this case because we need to
+    // check whether the socket was closed before each retry.
     int result;
-    fd_set rfds;
-    fd_set wfds;
+    pollfd fds[2];
     do {
         NetFd fd(env, fdObject);
         if (fd.isClosed()) {
@@ -5747,32 +6667,31 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
         JNI_TRACE("sslSelect type=%s fd=%d appData=%p timeout_millis=%d",
                   (type == SSL_ERROR_WANT_READ) ? "READ" : "WRITE", intFd, appData, timeout_millis);
 
-        FD_ZERO(&rfds);
-        FD_ZERO(&wfds);
-
-        if (type == SSL_ERROR_WANT_READ) {
-            FD_SET(intFd, &rfds);
-        } else {
-            FD_SET(intFd, &wfds);
+        // Unlike select(), poll() doesn't care how large the fds are.
+        fds[0].fd = intFd;
+        fds[0].events = (type == SSL_ERROR_WANT_READ) ? POLLIN : POLLOUT;
+        fds[0].revents = 0;
+        fds[1].fd = appData->fdEmergency;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+
+        // poll's errno is taken before the monitor and trace scope close, since ending the
+        // trace writes to the trace_marker file.
+        int savedErrno;
+        {
+            ScopedNativeTrace trace("sslSelect");
+            AsynchronousSocketCloseMonitor monitor(intFd);
+            result = poll(fds, 2, (timeout_millis > 0) ? timeout_millis : -1);
+            savedErrno = errno;
         }
-
-        FD_SET(appData->fdsEmergency[0], &rfds);
-
-        int maxFd = (intFd > appData->fdsEmergency[0]) ? intFd : appData->fdsEmergency[0];
-
-        // Build a struct for the timeout data if we actually want a timeout.
-        timeval tv;
-        timeval* ptv;
-        if (timeout_millis > 0) {
-            tv.tv_sec = timeout_millis / 1000;
-            tv.tv_usec = (timeout_millis % 1000) * 1000;
-            ptv = &tv;
-        } else {
-            ptv = NULL;
+        // A wakeup is spurious if a signal or another thread's sslNotify ended the wait before
+        // the socket itself was ready. Decide before counting, which mustn't disturb errno.
+        bool spurious = (result == -1) ? (savedErrno == EINTR) : (result > 0 && fds[0].revents == 0);
+        nativeCounterAdd(COUNTER_SSL_SELECT_WAKEUPS, 1);
+        if (spurious) {
+            nativeCounterAdd(COUNTER_SSL_SELECT_SPURIOUS_WAKEUPS, 1);
         }
-
-        AsynchronousSocketCloseMonitor monitor(intFd);
-        result = select(maxFd + 1, &rfds, &wfds, NULL, ptv);
+        errno = savedErrno;
         JNI_TRACE("sslSelect %s fd=%d appData=%p timeout_millis=%d => %d",
                   (type == SSL_ERROR_WANT_READ) ? "READ" : "WRITE",
                   fd.get(), appData, timeout_millis, result);
@@ -5792,17 +6711,17 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
     }
 
     if (result > 0) {
-        // We have been woken up by a token in the emergency pipe. We
-        // can't be sure the token is still in the pipe at this point
+        // We have been woken up by a token in the emergency eventfd. We
+        // can't be sure the token is still there at this point
         // because it could have already been read by the thread that
         // originally wrote it if it entered sslSelect and acquired
         // the mutex before we did. Thus we cannot safely read from
-        // the pipe in a blocking way (so we make the pipe
-        // non-blocking at creation).
-        if (FD_ISSET(appData->fdsEmergency[0], &rfds)) {
-            char token;
+        // the eventfd in a blocking way (so we make it non-blocking
+        // at creation). In semaphore mode each read takes one token.
+        if ((fds[1].revents & POLLIN) != 0) {
+            uint64_t token;
             do {
-                read(appData->fdsEmergency[0], &token, 1);
+                read(appData->fdEmergency, &token, sizeof(token));
             } while (errno == EINTR);
         }
     }
@@ -5817,21 +6736,21 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
 }
 
 /**
- * Helper function that wakes up a thread blocked in select(), in case there is
+ * Helper function that wakes up a thread blocked in poll(), in case there is
  * one. Is being called by sslRead() and sslWrite() as well as by JNI glue
  * before closing the connection.
  *
  * @param data The application data structure with mutex info etc.
  */
 static void sslNotify(AppData* appData) {
-    // Write a byte to the emergency pipe, so a concurrent select() can return.
+    // Add a token to the emergency eventfd, so a concurrent poll() can return.
     // Note we have to restore the errno of the original system call, since the
     // caller relies on it for generating error messages.
     int errnoBackup = errno;
-    char token = '*';
+    uint64_t token = 1;
     do {
         errno = 0;
-        write(appData->fdsEmergency[1], &token, 1);
+        write(appData->fdEmergency, &token, sizeof(token));
     } while (errno == EINTR);
     errno = errnoBackup;
 }
@@ -5841,38 +6760,193 @@ static AppData* toAppData(const SSL* ssl) {
 }
 
 /**
- * Verify the X509 certificate via SSL_CTX_set_cert_verify_callback
+ * Chains that an SSL_CTX's verifyCertificateChain upcall accepted recently, so that handshakes
+ * presenting the same chain within timeoutSeconds skip the upcall, and the encoding and
+ * parsing of the chain it needs. Only successes are remembered.
+ *
+ * An entry's key is the SHA-256 of everything the Java side's decision depends on: whether
+ * we're the client, the authentication method, the peer host a client verifies against (set by
+ * SSL_set_verified_chain_cache_host), and the DER of each certificate. A client without a host
+ * set never uses the cache.
  */
-static int cert_verify_callback(X509_STORE_CTX* x509_store_ctx, void* arg __attribute__ ((unused)))
-{
-    /* Get the correct index to the SSLobject stored into X509_STORE_CTX. */
-    SSL* ssl = reinterpret_cast<SSL*>(X509_STORE_CTX_get_ex_data(x509_store_ctx,
-            SSL_get_ex_data_X509_STORE_CTX_idx()));
-    JNI_TRACE("ssl=%p cert_verify_callback x509_store_ctx=%p arg=%p", ssl, x509_store_ctx, arg);
+#define VERIFIED_CHAIN_CACHE_SIZE 64
 
-    AppData* appData = toAppData(ssl);
-    JNIEnv* env = appData->env;
-    if (env == NULL) {
-        ALOGE("AppData->env missing in cert_verify_callback");
-        JNI_TRACE("ssl=%p cert_verify_callback => 0", ssl);
-        return 0;
+class VerifiedChainCache {
+public:
+    explicit VerifiedChainCache(int timeoutSeconds) : timeoutSeconds_(timeoutSeconds) {
+        pthread_mutex_init(&mutex_, NULL);
+        memset(entries_, 0, sizeof(entries_));
     }
-    jobject sslHandshakeCallbacks = appData->sslHandshakeCallbacks;
 
-    jclass cls = env->GetObjectClass(sslHandshakeCallbacks);
-    jmethodID methodID
-        = env->GetMethodID(cls, "verifyCertificateChain", "([[BLjava/lang/String;)V");
+    ~VerifiedChainCache() {
+        pthread_mutex_destroy(&mutex_);
+    }
 
-    jobjectArray objectArray = getCertificateBytes(env, x509_store_ctx->untrusted);
+    bool contains(const unsigned char* digest) {
+        int64_t now = nowSeconds();
+        ScopedPthreadMutexLock lock(&mutex_);
+        for (size_t i = 0; i < VERIFIED_CHAIN_CACHE_SIZE; ++i) {
+            if (entries_[i].expires > now
+                    && memcmp(entries_[i].digest, digest, SHA256_DIGEST_LENGTH) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
 
-    const char* authMethod = SSL_authentication_method(ssl);
-    JNI_TRACE("ssl=%p cert_verify_callback calling verifyCertificateChain authMethod=%s",
-              ssl, authMethod);
-    jstring authMethodString = env->NewStringUTF(authMethod);
-    env->CallVoidMethod(sslHandshakeCallbacks, methodID, objectArray, authMethodString);
+    void add(const unsigned char* digest) {
+        int64_t now = nowSeconds();
+        ScopedPthreadMutexLock lock(&mutex_);
+        // Replace the entry for this chain, or else the one that expires soonest.
+        Entry* victim = &entries_[0];
+        for (size_t i = 0; i < VERIFIED_CHAIN_CACHE_SIZE; ++i) {
+            if (memcmp(entries_[i].digest, digest, SHA256_DIGEST_LENGTH) == 0) {
+                victim = &entries_[i];
+                break;
+            }
+            if (entries_[i].expires < victim->expires) {
+                victim = &entries_[i];
+            }
+        }
+        memcpy(victim->digest, digest, SHA256_DIGEST_LENGTH);
+        victim->expires = now + timeoutSeconds_;
+    }
 
-    int result = (env->ExceptionCheck()) ? 0 : 1;
-    JNI_TRACE("ssl=%p cert_verify_callback => %d", ssl, result);
+    /**
+     * Computes the key for ssl's peer chain. Returns false if this handshake mustn't use the
+     * cache.
+     */
+    static bool digestChain(SSL* ssl, STACK_OF(X509)* chain, const char* authMethod,
+                            unsigned char* digest) {
+        const char* host = reinterpret_cast<const char*>(SSL_get_ex_data(ssl, sslHostIndex()));
+        bool client = !ssl->server;
+        if (chain == NULL || (client && host == NULL)) {
+            return false;
+        }
+        SHA256_CTX sha;
+        SHA256_Init(&sha);
+        SHA256_Update(&sha, client ? "C" : "S", 1);
+        SHA256_Update(&sha, authMethod, strlen(authMethod) + 1);
+        if (client) {
+            SHA256_Update(&sha, host, strlen(host) + 1);
+        }
+        for (int i = 0; i < sk_X509_num(chain); ++i) {
+            unsigned char* der = NULL;
+            int derLength = i2d_X509(sk_X509_value(chain, i), &der);
+            if (derLength <= 0) {
+                freeOpenSslErrorState();
+                return false;
+            }
+            uint32_t length = htonl(derLength);
+            SHA256_Update(&sha, &length, sizeof(length));
+            SHA256_Update(&sha, der, derLength);
+            OPENSSL_free(der);
+        }
+        SHA256_Final(digest, &sha);
+        return true;
+    }
+
+    static int sslCtxIndex() {
+        pthread_once(&gIndexesOnce, initIndexes);
+        return gSslCtxIndex;
+    }
+
+    static int sslHostIndex() {
+        pthread_once(&gIndexesOnce, initIndexes);
+        return gSslHostIndex;
+    }
+
+private:
+    struct Entry {
+        unsigned char digest[SHA256_DIGEST_LENGTH];
+        int64_t expires;
+    };
+
+    pthread_mutex_t mutex_;
+    int timeoutSeconds_;
+    Entry entries_[VERIFIED_CHAIN_CACHE_SIZE];
+
+    static pthread_once_t gIndexesOnce;
+    static int gSslCtxIndex;
+    static int gSslHostIndex;
+
+    static void freeHost(void*, void* host, CRYPTO_EX_DATA*, int, long, void*) {
+        free(host);
+    }
+
+    // SSLs hold references to their SSL_CTX, so the cache goes when the context is destroyed.
+    static void freeCache(void*, void* cache, CRYPTO_EX_DATA*, int, long, void*) {
+        delete reinterpret_cast<VerifiedChainCache*>(cache);
+    }
+
+    static void initIndexes() {
+        gSslCtxIndex = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, freeCache);
+        gSslHostIndex = SSL_get_ex_new_index(0, NULL, NULL, NULL, freeHost);
+    }
+
+    static int64_t nowSeconds() {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec;
+    }
+};
+
+pthread_once_t VerifiedChainCache::gIndexesOnce = PTHREAD_ONCE_INIT;
+int VerifiedChainCache::gSslCtxIndex;
+int VerifiedChainCache::gSslHostIndex;
+
+static VerifiedChainCache* toVerifiedChainCache(SSL_CTX* ssl_ctx) {
+    return reinterpret_cast<VerifiedChainCache*>(
+            SSL_CTX_get_ex_data(ssl_ctx, VerifiedChainCache::sslCtxIndex()));
+}
+
+/**
+ * Verify the X509 certificate via SSL_CTX_set_cert_verify_callback
+ */
+static int cert_verify_callback(X509_STORE_CTX* x509_store_ctx, void* arg __attribute__ ((unused)))
+{
+    /* Get the correct index to the SSLobject stored into X509_STORE_CTX. */
+    SSL* ssl = reinterpret_cast<SSL*>(X509_STORE_CTX_get_ex_data(x509_store_ctx,
+            SSL_get_ex_data_X509_STORE_CTX_idx()));
+    JNI_TRACE("ssl=%p cert_verify_callback x509_store_ctx=%p arg=%p", ssl, x509_store_ctx, arg);
+
+    AppData* appData = toAppData(ssl);
+    JNIEnv* env = appData->env;
+    if (env == NULL) {
+        ALOGE("AppData->env missing in cert_verify_callback");
+        JNI_TRACE("ssl=%p cert_verify_callback => 0", ssl);
+        return 0;
+    }
+    jobject sslHandshakeCallbacks = appData->sslHandshakeCallbacks;
+    const char* authMethod = SSL_authentication_method(ssl);
+
+    VerifiedChainCache* cache = toVerifiedChainCache(SSL_get_SSL_CTX(ssl));
+    unsigned char chainDigest[SHA256_DIGEST_LENGTH];
+    if (cache != NULL && !VerifiedChainCache::digestChain(ssl, x509_store_ctx->untrusted,
+                                                          authMethod, chainDigest)) {
+        cache = NULL;
+    }
+    if (cache != NULL && cache->contains(chainDigest)) {
+        JNI_TRACE("ssl=%p cert_verify_callback => 1 (verified chain cache)", ssl);
+        return 1;
+    }
+
+    jclass cls = env->GetObjectClass(sslHandshakeCallbacks);
+    jmethodID methodID
+        = env->GetMethodID(cls, "verifyCertificateChain", "([[BLjava/lang/String;)V");
+
+    jobjectArray objectArray = getCertificateBytes(env, x509_store_ctx->untrusted);
+
+    JNI_TRACE("ssl=%p cert_verify_callback calling verifyCertificateChain authMethod=%s",
+              ssl, authMethod);
+    jstring authMethodString = env->NewStringUTF(authMethod);
+    env->CallVoidMethod(sslHandshakeCallbacks, methodID, objectArray, authMethodString);
+
+    int result = (env->ExceptionCheck()) ? 0 : 1;
+    if (result == 1 && cache != NULL) {
+        cache->add(chainDigest);
+    }
+    JNI_TRACE("ssl=%p cert_verify_callback => %d", ssl, result);
     return result;
 }
 
@@ -6162,6 +7236,431 @@ static jlong NativeCrypto_SSL_CTX_new(JNIEnv* env, jclass) {
     return (jlong) sslCtx.release();
 }
 
+/*
+ * A server session cache outside OpenSSL's, in memory that can be shared: an anonymous shared
+ * mapping, which worker processes forked after it's set up share, or a file that unrelated
+ * processes can map. It backs OpenSSL's internal cache through the new/get/remove session
+ * callbacks, so sessions that another process created, or that OpenSSL evicted, can still be
+ * resumed without a full handshake or a trip through Java.
+ *
+ * Sessions are stored as DER, since SSL_SESSION pointers mean nothing to other processes. The
+ * cache is split into shards of SESSION_CACHE_SHARD_SLOTS slots, each with its own
+ * process-shared mutex; a session ID's hash picks its shard. A shard evicts an expired slot if
+ * it has one, and otherwise its least recently used.
+ *
+ * The file starts with a header giving its shape. A process opening a file another process
+ * set up uses that shape, whatever it asked for. A process that dies holding a shard's lock
+ * leaves the shard locked, so delete the file if a worker crashes in the middle of a handshake.
+ */
+static const uint32_t SESSION_CACHE_MAGIC = 0x53534331; // "SSC1"
+static const uint32_t SESSION_CACHE_SHARD_SLOTS = 32;
+static const size_t SESSION_CACHE_MAX_DER_LENGTH = 1984;
+
+struct SessionCacheHeader {
+    uint32_t magic;
+    uint32_t slotSize;
+    uint32_t shardCount;
+    uint32_t timeoutSeconds;
+} __attribute__((aligned(64)));
+
+struct SessionCacheShard {
+    pthread_mutex_t mutex;
+    uint64_t clock;
+} __attribute__((aligned(64)));
+
+struct SessionCacheSlot {
+    uint32_t idHash;
+    uint32_t idLength; // 0 if the slot is free.
+    uint8_t id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+    int64_t expires;
+    uint64_t lastUse;
+    uint32_t derLength;
+    uint8_t der[SESSION_CACHE_MAX_DER_LENGTH];
+};
+
+class SessionCache {
+  public:
+    /**
+     * Maps a cache for up to maxSessions sessions, each kept for at most timeoutSeconds. If
+     * path is NULL the cache is anonymous. Returns NULL with errno set on failure.
+     */
+    static SessionCache* create(const char* path, int maxSessions, int timeoutSeconds) {
+        uint32_t shardCount = (maxSessions + SESSION_CACHE_SHARD_SLOTS - 1) /
+                SESSION_CACHE_SHARD_SLOTS;
+        if (shardCount == 0) {
+            shardCount = 1;
+        }
+        if (path == NULL) {
+            size_t size = regionSize(shardCount);
+            void* region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                                -1, 0);
+            if (region == MAP_FAILED) {
+                return NULL;
+            }
+            initialize(region, shardCount, timeoutSeconds);
+            return new SessionCache(region, size);
+        }
+
+        int fd = TEMP_FAILURE_RETRY(open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600));
+        if (fd == -1) {
+            return NULL;
+        }
+        // Hold an exclusive lock while we look at the header, so two processes don't both
+        // initialize the file.
+        if (TEMP_FAILURE_RETRY(flock(fd, LOCK_EX)) == -1) {
+            int savedErrno = errno;
+            close(fd);
+            errno = savedErrno;
+            return NULL;
+        }
+        SessionCacheHeader header;
+        memset(&header, 0, sizeof(header));
+        bool existing = (TEMP_FAILURE_RETRY(pread(fd, &header, sizeof(header), 0))
+                == static_cast<ssize_t>(sizeof(header)))
+                && header.magic == SESSION_CACHE_MAGIC
+                && header.slotSize == sizeof(SessionCacheSlot)
+                && header.shardCount > 0;
+        if (existing) {
+            shardCount = header.shardCount;
+        }
+        size_t size = regionSize(shardCount);
+        void* region = MAP_FAILED;
+        struct stat sb;
+        if (fstat(fd, &sb) != -1
+                && (static_cast<size_t>(sb.st_size) >= size || ftruncate(fd, size) != -1)) {
+            region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        int savedErrno = errno;
+        if (region != MAP_FAILED && !existing) {
+            // Whatever a file we don't recognize holds, start again from zeroes, since
+            // initialize only sets up the header and the locks. Clearing it rather than
+            // truncating it means a process still mapping an old layout doesn't fault.
+            memset(region, 0, size);
+            initialize(region, shardCount, timeoutSeconds);
+        }
+        // The mapping keeps the open file alive, and with it the lock, so unlock explicitly.
+        flock(fd, LOCK_UN);
+        close(fd);
+        if (region == MAP_FAILED) {
+            errno = savedErrno;
+            return NULL;
+        }
+        return new SessionCache(region, size);
+    }
+
+    ~SessionCache() {
+        munmap(header, size);
+    }
+
+    /** The SSL_CTX ex_data index of a context's SessionCache, which it deletes on its free. */
+    static int sslCtxIndex() {
+        pthread_once(&gIndexOnce, initIndex);
+        return gSslCtxIndex;
+    }
+
+    /** Stores session, replacing any session with its ID. */
+    void put(SSL_SESSION* session) {
+        unsigned int idLength;
+        const unsigned char* id = SSL_SESSION_get_id(session, &idLength);
+        int derLength = i2d_SSL_SESSION(session, NULL);
+        if (idLength == 0 || idLength > SSL_MAX_SSL_SESSION_ID_LENGTH
+                || derLength <= 0 || static_cast<size_t>(derLength) > SESSION_CACHE_MAX_DER_LENGTH) {
+            return;
+        }
+        uint8_t der[SESSION_CACHE_MAX_DER_LENGTH];
+        unsigned char* cursor = der;
+        i2d_SSL_SESSION(session, &cursor);
+
+        int64_t now = time(NULL);
+        int64_t expires = SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session);
+        if (header->timeoutSeconds > 0 && now + header->timeoutSeconds < expires) {
+            expires = now + header->timeoutSeconds;
+        }
+        uint32_t hash = hashId(id, idLength);
+        SessionCacheShard* shard = shardFor(hash);
+        ScopedPthreadMutexLock lock(&shard->mutex);
+        SessionCacheSlot* slot = find(shard, hash, id, idLength);
+        if (slot == NULL) {
+            slot = victim(shard, now);
+        }
+        slot->idHash = hash;
+        slot->idLength = idLength;
+        memcpy(slot->id, id, idLength);
+        slot->expires = expires;
+        slot->lastUse = ++shard->clock;
+        slot->derLength = derLength;
+        memcpy(slot->der, der, derLength);
+    }
+
+    /** Returns a new SSL_SESSION for the given ID, or NULL. */
+    SSL_SESSION* get(const unsigned char* id, size_t idLength) {
+        if (idLength == 0 || idLength > SSL_MAX_SSL_SESSION_ID_LENGTH) {
+            return NULL;
+        }
+        uint8_t der[SESSION_CACHE_MAX_DER_LENGTH];
+        size_t derLength;
+        uint32_t hash = hashId(id, idLength);
+        SessionCacheShard* shard = shardFor(hash);
+        {
+            ScopedPthreadMutexLock lock(&shard->mutex);
+            SessionCacheSlot* slot = find(shard, hash, id, idLength);
+            if (slot == NULL) {
+                return NULL;
+            }
+            if (slot->expires <= time(NULL)) {
+                slot->idLength = 0;
+                return NULL;
+            }
+            derLength = slot->derLength;
+            if (derLength > SESSION_CACHE_MAX_DER_LENGTH) {
+                // Other processes can write the file, so don't trust what's in it.
+                slot->idLength = 0;
+                return NULL;
+            }
+            slot->lastUse = ++shard->clock;
+            memcpy(der, slot->der, derLength);
+        }
+        const unsigned char* cursor = der;
+        return d2i_SSL_SESSION(NULL, &cursor, derLength);
+    }
+
+    /** Forgets the session with the given ID. */
+    void remove(const unsigned char* id, size_t idLength) {
+        if (idLength == 0 || idLength > SSL_MAX_SSL_SESSION_ID_LENGTH) {
+            return;
+        }
+        uint32_t hash = hashId(id, idLength);
+        SessionCacheShard* shard = shardFor(hash);
+        ScopedPthreadMutexLock lock(&shard->mutex);
+        SessionCacheSlot* slot = find(shard, hash, id, idLength);
+        if (slot != NULL) {
+            slot->idLength = 0;
+        }
+    }
+
+  private:
+    SessionCacheHeader* header;
+    size_t size;
+    SessionCacheShard* shards;
+    SessionCacheSlot* slots;
+
+    static pthread_once_t gIndexOnce;
+    static int gSslCtxIndex;
+
+    // SSL_CTX_free flushes the context's sessions before it frees its ex_data, so the
+    // callbacks can't see a deleted cache.
+    static void freeSessionCache(void*, void* cache, CRYPTO_EX_DATA*, int, long, void*) {
+        delete reinterpret_cast<SessionCache*>(cache);
+    }
+
+    static void initIndex() {
+        gSslCtxIndex = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, freeSessionCache);
+    }
+
+    SessionCache(void* region, size_t size) :
+            header(reinterpret_cast<SessionCacheHeader*>(region)),
+            size(size),
+            shards(reinterpret_cast<SessionCacheShard*>(header + 1)),
+            slots(reinterpret_cast<SessionCacheSlot*>(shards + header->shardCount)) {
+    }
+
+    static size_t regionSize(uint32_t shardCount) {
+        return sizeof(SessionCacheHeader) + shardCount * sizeof(SessionCacheShard)
+                + shardCount * SESSION_CACHE_SHARD_SLOTS * sizeof(SessionCacheSlot);
+    }
+
+    // Expects zeroed memory: a new anonymous mapping, or a file region create has cleared.
+    static void initialize(void* region, uint32_t shardCount, int timeoutSeconds) {
+        SessionCacheHeader* header = reinterpret_cast<SessionCacheHeader*>(region);
+        SessionCacheShard* shards = reinterpret_cast<SessionCacheShard*>(header + 1);
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        for (uint32_t i = 0; i < shardCount; ++i) {
+            pthread_mutex_init(&shards[i].mutex, &attr);
+        }
+        pthread_mutexattr_destroy(&attr);
+        header->slotSize = sizeof(SessionCacheSlot);
+        header->shardCount = shardCount;
+        header->timeoutSeconds = (timeoutSeconds > 0) ? timeoutSeconds : 0;
+        __atomic_store_n(&header->magic, SESSION_CACHE_MAGIC, __ATOMIC_RELEASE);
+    }
+
+    // FNV-1a. Session IDs are random, so this only has to mix in every byte.
+    static uint32_t hashId(const unsigned char* id, size_t idLength) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < idLength; ++i) {
+            hash = (hash ^ id[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    SessionCacheShard* shardFor(uint32_t hash) {
+        return &shards[hash % header->shardCount];
+    }
+
+    SessionCacheSlot* shardSlots(SessionCacheShard* shard) {
+        return &slots[(shard - shards) * SESSION_CACHE_SHARD_SLOTS];
+    }
+
+    SessionCacheSlot* find(SessionCacheShard* shard, uint32_t hash, const unsigned char* id,
+                           size_t idLength) {
+        SessionCacheSlot* slot = shardSlots(shard);
+        for (uint32_t i = 0; i < SESSION_CACHE_SHARD_SLOTS; ++i, ++slot) {
+            // Callers never pass an idLength over SSL_MAX_SSL_SESSION_ID_LENGTH, so this also
+            // skips slots whose idLength is out of range.
+            if (slot->idHash == hash && slot->idLength == idLength
+                    && idLength <= SSL_MAX_SSL_SESSION_ID_LENGTH
+                    && memcmp(slot->id, id, idLength) == 0) {
+                return slot;
+            }
+        }
+        return NULL;
+    }
+
+    // Returns a free slot, else an expired one, else the least recently used.
+    SessionCacheSlot* victim(SessionCacheShard* shard, int64_t now) {
+        SessionCacheSlot* slot = shardSlots(shard);
+        SessionCacheSlot* oldest = slot;
+        for (uint32_t i = 0; i < SESSION_CACHE_SHARD_SLOTS; ++i, ++slot) {
+            if (slot->idLength == 0 || slot->expires <= now) {
+                return slot;
+            }
+            if (slot->lastUse < oldest->lastUse) {
+                oldest = slot;
+            }
+        }
+        return oldest;
+    }
+};
+
+pthread_once_t SessionCache::gIndexOnce = PTHREAD_ONCE_INIT;
+int SessionCache::gSslCtxIndex;
+
+static SessionCache* toSessionCache(SSL_CTX* ssl_ctx) {
+    return reinterpret_cast<SessionCache*>(
+            SSL_CTX_get_ex_data(ssl_ctx, SessionCache::sslCtxIndex()));
+}
+
+static int session_cache_new_cb(SSL* ssl, SSL_SESSION* session) {
+    toSessionCache(SSL_get_SSL_CTX(ssl))->put(session);
+    // We keep a copy, not a reference.
+    return 0;
+}
+
+static SSL_SESSION* session_cache_get_cb(SSL* ssl, unsigned char* id, int idLength, int* copy) {
+    // The session is new, so OpenSSL can have our reference.
+    *copy = 0;
+    return toSessionCache(SSL_get_SSL_CTX(ssl))->get(id, idLength);
+}
+
+static void session_cache_remove_cb(SSL_CTX* ssl_ctx, SSL_SESSION* session) {
+    unsigned int idLength;
+    const unsigned char* id = SSL_SESSION_get_id(session, &idLength);
+    toSessionCache(ssl_ctx)->remove(id, idLength);
+}
+
+/**
+ * Backs ssl_ctx's server session cache with a SessionCache, in the file at javaPath or, if
+ * that's null, in anonymous shared memory.
+ */
+static void NativeCrypto_SSL_CTX_set_shared_session_cache(JNIEnv* env, jclass,
+        jlong ssl_ctx_address, jstring javaPath, jint maxSessions, jint timeoutSeconds)
+{
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_shared_session_cache path=%p max=%d "
+              "timeout=%d", ssl_ctx, javaPath, maxSessions, timeoutSeconds);
+    if (ssl_ctx == NULL) {
+        return;
+    }
+    if (maxSessions <= 0) {
+        jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException",
+                             "maxSessions <= 0: %d", maxSessions);
+        return;
+    }
+    if (toSessionCache(ssl_ctx) != NULL) {
+        jniThrowException(env, "java/lang/IllegalStateException",
+                          "SSL_CTX already has a shared session cache");
+        return;
+    }
+    SessionCache* cache;
+    if (javaPath == NULL) {
+        cache = SessionCache::create(NULL, maxSessions, timeoutSeconds);
+    } else {
+        ScopedUtfChars path(env, javaPath);
+        if (path.c_str() == NULL) {
+            return;
+        }
+        cache = SessionCache::create(path.c_str(), maxSessions, timeoutSeconds);
+    }
+    if (cache == NULL) {
+        jniThrowIOException(env, errno);
+        return;
+    }
+    SSL_CTX_set_ex_data(ssl_ctx, SessionCache::sslCtxIndex(), cache);
+    SSL_CTX_sess_set_new_cb(ssl_ctx, session_cache_new_cb);
+    SSL_CTX_sess_set_get_cb(ssl_ctx, session_cache_get_cb);
+    SSL_CTX_sess_set_remove_cb(ssl_ctx, session_cache_remove_cb);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_shared_session_cache => %p", ssl_ctx, cache);
+}
+
+/**
+ * public static native void SSL_CTX_set_verified_chain_cache(long ssl_ctx, int timeoutSeconds);
+ */
+static void NativeCrypto_SSL_CTX_set_verified_chain_cache(JNIEnv* env, jclass,
+        jlong ssl_ctx_address, jint timeoutSeconds)
+{
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_verified_chain_cache timeoutSeconds=%d",
+              ssl_ctx, timeoutSeconds);
+    if (ssl_ctx == NULL) {
+        return;
+    }
+    if (timeoutSeconds <= 0) {
+        jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException",
+                             "timeoutSeconds <= 0: %d", timeoutSeconds);
+        return;
+    }
+    if (toVerifiedChainCache(ssl_ctx) != NULL) {
+        jniThrowException(env, "java/lang/IllegalStateException",
+                          "SSL_CTX already has a verified chain cache");
+        return;
+    }
+    SSL_CTX_set_ex_data(ssl_ctx, VerifiedChainCache::sslCtxIndex(),
+                        new VerifiedChainCache(timeoutSeconds));
+}
+
+/**
+ * public static native void SSL_set_verified_chain_cache_host(long ssl, String host);
+ */
+static void NativeCrypto_SSL_set_verified_chain_cache_host(JNIEnv* env, jclass,
+        jlong ssl_address, jstring hostJava)
+{
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_verified_chain_cache_host host=%p", ssl, hostJava);
+    if (ssl == NULL) {
+        return;
+    }
+    // A null host is a host too, as far as the trust manager is concerned.
+    char* host;
+    if (hostJava == NULL) {
+        host = strdup("");
+    } else {
+        ScopedUtfChars hostChars(env, hostJava);
+        if (hostChars.c_str() == NULL) {
+            return;
+        }
+        host = strdup(hostChars.c_str());
+    }
+    if (host == NULL) {
+        jniThrowOutOfMemory(env, "Unable to copy host");
+        return;
+    }
+    int index = VerifiedChainCache::sslHostIndex();
+    free(SSL_get_ex_data(ssl, index));
+    SSL_set_ex_data(ssl, index, host);
+}
+
 /**
  * public static native void SSL_CTX_free(int ssl_ctx)
  */
@@ -6173,6 +7672,12 @@ static void NativeCrypto_SSL_CTX_free(JNIEnv* env,
     if (ssl_ctx == NULL) {
         return;
     }
+    if (toSessionCache(ssl_ctx) != NULL) {
+        // When the last SSL using it is freed, the context removes every session from its
+        // internal cache, which mustn't empty a cache other processes may be using. The
+        // SessionCache itself is deleted with the context's ex_data.
+        SSL_CTX_sess_set_remove_cb(ssl_ctx, NULL);
+    }
     SSL_CTX_free(ssl_ctx);
 }
 
@@ -7064,7 +8569,7 @@ static jlong NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_addres
 
     /*
      * Make socket non-blocking, so SSL_connect SSL_read() and SSL_write() don't hang
-     * forever and we can use select() to find out if the socket is ready.
+     * forever and we can use poll() to find out if the socket is ready.
      */
     if (!setBlocking(fd.get(), false)) {
         throwSSLExceptionStr(env, "Unable to make socket non blocking");
@@ -7712,6 +9217,205 @@ static void NativeCrypto_SSL_write(JNIEnv* env, jclass, jlong ssl_address, jobje
     }
 }
 
+/**
+ * Copies as many bytes as were already decrypted, or already read from the socket, into buf
+ * without waiting for the socket. Returns how many bytes it copied. Errors are left for the next
+ * sslRead to report.
+ */
+static int sslReadBuffered(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, char* buf,
+                           jint len) {
+    AppData* appData = toAppData(ssl);
+    int count = 0;
+    while (len > 0 && appData->aliveAndKicking
+            && (SSL_pending(ssl) > 0 || ssl->s3->rbuf.left > 0)) {
+        if (MUTEX_LOCK(appData->mutex) == -1) {
+            break;
+        }
+        if (!appData->setCallbackState(env, shc, fdObject, NULL, NULL)) {
+            MUTEX_UNLOCK(appData->mutex);
+            return THROWN_EXCEPTION;
+        }
+        int result = SSL_read(ssl, buf, len);
+        appData->clearCallbackState();
+        if (env->ExceptionCheck()) {
+            SSL_clear(ssl);
+            MUTEX_UNLOCK(appData->mutex);
+            JNI_TRACE("ssl=%p sslReadBuffered => THROWN_EXCEPTION", ssl);
+            return THROWN_EXCEPTION;
+        }
+        if (result <= 0) {
+            freeOpenSslErrorState();
+        } else if (appData->waitingThreads > 0) {
+            sslNotify(appData);
+        }
+        MUTEX_UNLOCK(appData->mutex);
+        if (result <= 0) {
+            break;
+        }
+        buf += result;
+        len -= result;
+        count += result;
+    }
+    JNI_TRACE("ssl=%p sslReadBuffered => %d", ssl, count);
+    return count;
+}
+
+/**
+ * Reads into the direct ByteBuffer dst at offset, waiting for at least one byte like SSL_read,
+ * and then copying every record that has already arrived rather than one per call. Read-ahead
+ * is on for the duration of the call, so OpenSSL reads as much as the socket has rather than one
+ * record at a time, and then goes back to what it was.
+ */
+static jint NativeCrypto_SSL_read_direct(JNIEnv* env, jclass, jlong ssl_address,
+                                         jobject fdObject, jobject shc, jobject dst, jint offset,
+                                         jint len, jint read_timeout_millis)
+{
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_read_direct fd=%p shc=%p dst=%p offset=%d len=%d "
+              "read_timeout_millis=%d", ssl, fdObject, shc, dst, offset, len, read_timeout_millis);
+    if (ssl == NULL) {
+        return 0;
+    }
+    if (fdObject == NULL) {
+        jniThrowNullPointerException(env, "fd == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_read_direct => fd == null", ssl);
+        return 0;
+    }
+    if (shc == NULL) {
+        jniThrowNullPointerException(env, "sslHandshakeCallbacks == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_read_direct => sslHandshakeCallbacks == null", ssl);
+        return 0;
+    }
+    char* address = reinterpret_cast<char*>(env->GetDirectBufferAddress(dst));
+    if (address == NULL) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "dst is not direct");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_read_direct => dst is not direct", ssl);
+        return 0;
+    }
+    int previousReadAhead = SSL_get_read_ahead(ssl);
+    SSL_set_read_ahead(ssl, 1);
+
+    int returnCode = 0;
+    int sslErrorCode = SSL_ERROR_NONE;
+    int ret = sslRead(env, ssl, fdObject, shc, address + offset, len, &returnCode,
+                      &sslErrorCode, read_timeout_millis);
+    if (ret > 0 && ret < len) {
+        int more = sslReadBuffered(env, ssl, fdObject, shc, address + offset + ret, len - ret);
+        ret = (more == THROWN_EXCEPTION) ? THROWN_EXCEPTION : ret + more;
+    }
+    // Turning read-ahead off again loses nothing: bytes it already pulled past the records
+    // returned here stay in OpenSSL's read buffer, which the next SSL_read consumes first.
+    SSL_set_read_ahead(ssl, previousReadAhead);
+
+    int result;
+    switch (ret) {
+        case THROW_SSLEXCEPTION:
+            throwSSLExceptionWithSslErrors(env, ssl, sslErrorCode, "Read error");
+            result = -1;
+            break;
+        case THROW_SOCKETTIMEOUTEXCEPTION:
+            throwSocketTimeoutException(env, "Read timed out");
+            result = -1;
+            break;
+        case THROWN_EXCEPTION:
+            result = -1;
+            break;
+        default:
+            result = ret;
+            break;
+    }
+
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_read_direct => %d", ssl, result);
+    return result;
+}
+
+/**
+ * Writes lengths[i] bytes of buffers[i] starting at offsets[i], for each i, packing them into
+ * full-size TLS records where a separate SSL_write per buffer would send a record each. Buffers
+ * at least a record long are written in place rather than copied.
+ */
+static void NativeCrypto_SSL_write_gathered(JNIEnv* env, jclass, jlong ssl_address,
+                                            jobject fdObject, jobject shc, jobjectArray buffers,
+                                            jintArray offsets, jintArray lengths,
+                                            jint write_timeout_millis)
+{
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_write_gathered fd=%p shc=%p buffers=%p "
+              "write_timeout_millis=%d", ssl, fdObject, shc, buffers, write_timeout_millis);
+    if (ssl == NULL) {
+        return;
+    }
+    if (fdObject == NULL) {
+        jniThrowNullPointerException(env, "fd == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_write_gathered => fd == null", ssl);
+        return;
+    }
+    if (shc == NULL) {
+        jniThrowNullPointerException(env, "sslHandshakeCallbacks == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_write_gathered => sslHandshakeCallbacks == null",
+                  ssl);
+        return;
+    }
+    ScopedIntArrayRO offsetInts(env, offsets);
+    if (offsetInts.get() == NULL) {
+        return;
+    }
+    ScopedIntArrayRO lengthInts(env, lengths);
+    if (lengthInts.get() == NULL) {
+        return;
+    }
+
+    char record[SSL3_RT_MAX_PLAIN_LENGTH];
+    size_t recordLength = 0;
+    int returnCode = 0;
+    int sslErrorCode = SSL_ERROR_NONE;
+    int ret = 0;
+    jsize bufferCount = env->GetArrayLength(buffers);
+    for (jsize i = 0; i < bufferCount && ret >= 0; ++i) {
+        ScopedLocalRef<jbyteArray> buffer(env,
+                reinterpret_cast<jbyteArray>(env->GetObjectArrayElement(buffers, i)));
+        ScopedByteArrayRO bytes(env, buffer.get());
+        if (bytes.get() == NULL) {
+            JNI_TRACE("ssl=%p NativeCrypto_SSL_write_gathered => threw exception", ssl);
+            return;
+        }
+        const char* data = reinterpret_cast<const char*>(bytes.get() + offsetInts[i]);
+        size_t length = lengthInts[i];
+        while (length > 0 && ret >= 0) {
+            if (recordLength == 0 && length >= sizeof(record)) {
+                ret = sslWrite(env, ssl, fdObject, shc, data, length, &returnCode,
+                               &sslErrorCode, write_timeout_millis);
+                break;
+            }
+            size_t chunk = std::min(length, sizeof(record) - recordLength);
+            memcpy(record + recordLength, data, chunk);
+            recordLength += chunk;
+            data += chunk;
+            length -= chunk;
+            if (recordLength == sizeof(record)) {
+                ret = sslWrite(env, ssl, fdObject, shc, record, recordLength, &returnCode,
+                               &sslErrorCode, write_timeout_millis);
+                recordLength = 0;
+            }
+        }
+    }
+    if (recordLength > 0 && ret >= 0) {
+        ret = sslWrite(env, ssl, fdObject, shc, record, recordLength, &returnCode,
+                       &sslErrorCode, write_timeout_millis);
+    }
+
+    switch (ret) {
+        case THROW_SSLEXCEPTION:
+            throwSSLExceptionWithSslErrors(env, ssl, sslErrorCode, "Write error");
+            break;
+        case THROW_SOCKETTIMEOUTEXCEPTION:
+            throwSocketTimeoutException(env, "Write timed out");
+            break;
+        default:
+            break;
+    }
+}
+
 /**
  * Interrupt any pending I/O before closing the socket.
  */
@@ -7725,7 +9429,7 @@ static void NativeCrypto_SSL_interrupt(
 
     /*
      * Mark the connection as quasi-dead, then send something to the emergency
-     * file descriptor, so any blocking select() calls are woken up.
+     * file descriptor, so any blocking poll() calls are woken up.
      */
     AppData* appData = toAppData(ssl);
     if (appData != NULL) {
@@ -7973,6 +9677,8 @@ static jlong NativeCrypto_ERR_peek_last_error(JNIEnv*, jclass) {
 #define SSL_CALLBACKS "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeCrypto$SSLHandshakeCallbacks;"
 static JNINativeMethod sNativeCryptoMethods[] = {
     NATIVE_METHOD(NativeCrypto, clinit, "()V"),
+    NATIVE_METHOD(NativeCrypto, get_lock_contention_counts, "()[J"),
+    NATIVE_METHOD(NativeCrypto, CRYPTO_get_lock_name, "(I)Ljava/lang/String;"),
     NATIVE_METHOD(NativeCrypto, ENGINE_load_dynamic, "()V"),
     NATIVE_METHOD(NativeCrypto, ENGINE_by_id, "(Ljava/lang/String;)J"),
     NATIVE_METHOD(NativeCrypto, ENGINE_add, "(J)I"),
@@ -8041,6 +9747,7 @@ static JNINativeMethod sNativeCryptoMethods[] = {
     NATIVE_METHOD(NativeCrypto, EVP_MD_block_size, "(J)I"),
     NATIVE_METHOD(NativeCrypto, EVP_MD_size, "(J)I"),
     NATIVE_METHOD(NativeCrypto, EVP_DigestUpdate, "(J[BII)V"),
+    NATIVE_METHOD(NativeCrypto, EVP_DigestUpdate_direct, "(JLjava/nio/ByteBuffer;II)V"),
     NATIVE_METHOD(NativeCrypto, EVP_SignInit, "(Ljava/lang/String;)J"),
     NATIVE_METHOD(NativeCrypto, EVP_SignUpdate, "(J[BII)V"),
     NATIVE_METHOD(NativeCrypto, EVP_SignFinal, "(J[BIJ)I"),
@@ -8053,14 +9760,20 @@ static JNINativeMethod sNativeCryptoMethods[] = {
     NATIVE_METHOD(NativeCrypto, EVP_get_cipherbyname, "(Ljava/lang/String;)J"),
     NATIVE_METHOD(NativeCrypto, EVP_CipherInit_ex, "(JJ[B[BZ)V"),
     NATIVE_METHOD(NativeCrypto, EVP_CipherUpdate, "(J[BI[BII)I"),
+    NATIVE_METHOD(NativeCrypto, EVP_CipherUpdate_direct, "(JLjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;II)I"),
     NATIVE_METHOD(NativeCrypto, EVP_CipherFinal_ex, "(J[BI)I"),
+    NATIVE_METHOD(NativeCrypto, EVP_CipherFinal_ex_direct, "(JLjava/nio/ByteBuffer;I)I"),
+    NATIVE_METHOD(NativeCrypto, EVP_aead_seal, "(J[B[B[B[BII[BII)I"),
+    NATIVE_METHOD(NativeCrypto, EVP_aead_open, "(J[B[B[B[BII[BII)I"),
     NATIVE_METHOD(NativeCrypto, EVP_CIPHER_iv_length, "(J)I"),
     NATIVE_METHOD(NativeCrypto, EVP_CIPHER_CTX_new, "()J"),
+    NATIVE_METHOD(NativeCrypto, EVP_CIPHER_CTX_new_pooled, "(J)J"),
     NATIVE_METHOD(NativeCrypto, EVP_CIPHER_CTX_block_size, "(J)I"),
     NATIVE_METHOD(NativeCrypto, get_EVP_CIPHER_CTX_buf_len, "(J)I"),
     NATIVE_METHOD(NativeCrypto, EVP_CIPHER_CTX_set_padding, "(JZ)V"),
     NATIVE_METHOD(NativeCrypto, EVP_CIPHER_CTX_set_key_length, "(JI)V"),
     NATIVE_METHOD(NativeCrypto, EVP_CIPHER_CTX_cleanup, "(J)V"),
+    NATIVE_METHOD(NativeCrypto, EVP_CIPHER_CTX_free, "(J)V"),
     NATIVE_METHOD(NativeCrypto, RAND_seed, "([B)V"),
     NATIVE_METHOD(NativeCrypto, RAND_load_file, "(Ljava/lang/String;J)I"),
     NATIVE_METHOD(NativeCrypto, RAND_bytes, "([B)V"),
@@ -8069,6 +9782,8 @@ static JNINativeMethod sNativeCryptoMethods[] = {
     NATIVE_METHOD(NativeCrypto, OBJ_txt2nid_oid, "(Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(NativeCrypto, create_BIO_InputStream, ("(L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/OpenSSLBIOInputStream;)J")),
     NATIVE_METHOD(NativeCrypto, create_BIO_OutputStream, "(Ljava/io/OutputStream;)J"),
+    NATIVE_METHOD(NativeCrypto, create_BIO_fd, "(Ljava/io/FileDescriptor;)J"),
+    NATIVE_METHOD(NativeCrypto, create_BIO_direct, "(Ljava/nio/ByteBuffer;II)J"),
     NATIVE_METHOD(NativeCrypto, BIO_read, "(J[B)I"),
     NATIVE_METHOD(NativeCrypto, BIO_write, "(J[BII)V"),
     NATIVE_METHOD(NativeCrypto, BIO_free, "(J)V"),
@@ -8143,6 +9858,8 @@ static JNINativeMethod sNativeCryptoMethods[] = {
     NATIVE_METHOD(NativeCrypto, SSL_CTX_new, "()J"),
     NATIVE_METHOD(NativeCrypto, SSL_CTX_free, "(J)V"),
     NATIVE_METHOD(NativeCrypto, SSL_CTX_set_session_id_context, "(J[B)V"),
+    NATIVE_METHOD(NativeCrypto, SSL_CTX_set_shared_session_cache, "(JLjava/lang/String;II)V"),
+    NATIVE_METHOD(NativeCrypto, SSL_CTX_set_verified_chain_cache, "(JI)V"),
     NATIVE_METHOD(NativeCrypto, SSL_new, "(J)J"),
     NATIVE_METHOD(NativeCrypto, SSL_enable_tls_channel_id, "(J)V"),
     NATIVE_METHOD(NativeCrypto, SSL_get_tls_channel_id, "(J)[B"),
@@ -8162,13 +9879,16 @@ static JNINativeMethod sNativeCryptoMethods[] = {
     NATIVE_METHOD(NativeCrypto, SSL_set_session, "(JJ)V"),
     NATIVE_METHOD(NativeCrypto, SSL_set_session_creation_enabled, "(JZ)V"),
     NATIVE_METHOD(NativeCrypto, SSL_set_tlsext_host_name, "(JLjava/lang/String;)V"),
+    NATIVE_METHOD(NativeCrypto, SSL_set_verified_chain_cache_host, "(JLjava/lang/String;)V"),
     NATIVE_METHOD(NativeCrypto, SSL_get_servername, "(J)Ljava/lang/String;"),
     NATIVE_METHOD(NativeCrypto, SSL_do_handshake, "(J" FILE_DESCRIPTOR SSL_CALLBACKS "IZ[B[B)I"),
     NATIVE_METHOD(NativeCrypto, SSL_renegotiate, "(J)V"),
     NATIVE_METHOD(NativeCrypto, SSL_get_certificate, "(J)[[B"),
     NATIVE_METHOD(NativeCrypto, SSL_get_peer_cert_chain, "(J)[[B"),
     NATIVE_METHOD(NativeCrypto, SSL_read, "(J" FILE_DESCRIPTOR SSL_CALLBACKS "[BIII)I"),
+    NATIVE_METHOD(NativeCrypto, SSL_read_direct, "(J" FILE_DESCRIPTOR SSL_CALLBACKS "Ljava/nio/ByteBuffer;III)I"),
     NATIVE_METHOD(NativeCrypto, SSL_write, "(J" FILE_DESCRIPTOR SSL_CALLBACKS "[BIII)V"),
+    NATIVE_METHOD(NativeCrypto, SSL_write_gathered, "(J" FILE_DESCRIPTOR SSL_CALLBACKS "[[B[I[II)V"),
     NATIVE_METHOD(NativeCrypto, SSL_interrupt, "(J)V"),
     NATIVE_METHOD(NativeCrypto, SSL_shutdown, "(J" FILE_DESCRIPTOR SSL_CALLBACKS ")V"),
     NATIVE_METHOD(NativeCrypto, SSL_free, "(J)V"),
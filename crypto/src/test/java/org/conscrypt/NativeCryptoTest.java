@@ -19,12 +19,16 @@ package org.conscrypt;
 import dalvik.system.BaseDexClassLoader;
 import java.io.ByteArrayInputStream;
 import java.io.ByteArrayOutputStream;
+import java.io.File;
 import java.io.FileDescriptor;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
 import java.io.IOException;
 import java.math.BigInteger;
 import java.net.ServerSocket;
 import java.net.Socket;
 import java.net.SocketTimeoutException;
+import java.nio.ByteBuffer;
 import java.security.KeyPair;
 import java.security.KeyPairGenerator;
 import java.security.KeyStore;
@@ -38,13 +42,16 @@ import java.security.interfaces.RSAPublicKey;
 import java.security.spec.ECPrivateKeySpec;
 import java.util.ArrayList;
 import java.util.Arrays;
+import java.util.HashSet;
 import java.util.List;
+import java.util.Set;
 import java.util.concurrent.Callable;
 import java.util.concurrent.ExecutionException;
 import java.util.concurrent.ExecutorService;
 import java.util.concurrent.Executors;
 import java.util.concurrent.Future;
 import java.util.concurrent.TimeUnit;
+import javax.crypto.BadPaddingException;
 import javax.net.ssl.SSLException;
 import javax.net.ssl.SSLProtocolException;
 import javax.security.auth.x500.X500Principal;
@@ -254,6 +261,20 @@ public class NativeCryptoTest extends TestCase {
         }
     }
 
+    public void test_get_lock_contention_counts() throws Exception {
+        long[] counts = NativeCrypto.get_lock_contention_counts();
+        assertTrue(counts.length > 0);
+        for (int i = 0; i < counts.length; i++) {
+            assertTrue(counts[i] >= 0);
+            assertNotNull(NativeCrypto.CRYPTO_get_lock_name(i));
+        }
+        try {
+            NativeCrypto.CRYPTO_get_lock_name(counts.length);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+
     public void test_SSL_CTX_new() throws Exception {
         long c = NativeCrypto.SSL_CTX_new();
         assertTrue(c != NULL);
@@ -295,6 +316,182 @@ public class NativeCryptoTest extends TestCase {
         NativeCrypto.SSL_CTX_free(c);
     }
 
+    public void test_SSL_CTX_set_shared_session_cache() throws Exception {
+        long c = NativeCrypto.SSL_CTX_new();
+        NativeCrypto.SSL_CTX_set_shared_session_cache(c, null, 100, 0);
+        try {
+            NativeCrypto.SSL_CTX_set_shared_session_cache(c, null, 100, 0);
+            fail();
+        } catch (IllegalStateException expected) {
+        }
+        NativeCrypto.SSL_CTX_free(c);
+
+        File file = File.createTempFile("NativeCryptoTest", ".sessions");
+        try {
+            c = NativeCrypto.SSL_CTX_new();
+            NativeCrypto.SSL_CTX_set_shared_session_cache(c, file.getPath(), 100, 60);
+            long size = file.length();
+            assertTrue(size > 0);
+            NativeCrypto.SSL_CTX_free(c);
+
+            // A second user of the file gets the same cache, whatever size it asks for.
+            c = NativeCrypto.SSL_CTX_new();
+            NativeCrypto.SSL_CTX_set_shared_session_cache(c, file.getPath(), 10000, 60);
+            assertEquals(size, file.length());
+            NativeCrypto.SSL_CTX_free(c);
+        } finally {
+            file.delete();
+        }
+
+        c = NativeCrypto.SSL_CTX_new();
+        try {
+            NativeCrypto.SSL_CTX_set_shared_session_cache(c, null, 0, 0);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+        NativeCrypto.SSL_CTX_free(c);
+    }
+
+    public void test_SSL_CTX_set_shared_session_cache_resume() throws Exception {
+        File file = File.createTempFile("NativeCryptoTest", ".sessions");
+        long clientContext = NativeCrypto.SSL_CTX_new();
+        long[] serverContexts = new long[3];
+        try {
+            for (int i = 0; i < serverContexts.length; i++) {
+                serverContexts[i] = NativeCrypto.SSL_CTX_new();
+                NativeCrypto.SSL_CTX_set_shared_session_cache(serverContexts[i], file.getPath(),
+                                                              100, 2);
+            }
+            long first = handshakeForSession(clientContext, NULL, serverContexts[0]);
+
+            // The second server has never seen the session, so can only resume it from the file.
+            long resumed = handshakeForSession(clientContext, first, serverContexts[1]);
+            assertEqualSessions(first, resumed);
+            NativeCrypto.SSL_SESSION_free(resumed);
+
+            // Once the cache's timeout has passed, a third server has to start a new session.
+            Thread.sleep(3000);
+            long expired = handshakeForSession(clientContext, first, serverContexts[2]);
+            assertFalse(Arrays.equals(NativeCrypto.SSL_SESSION_session_id(first),
+                                      NativeCrypto.SSL_SESSION_session_id(expired)));
+            NativeCrypto.SSL_SESSION_free(expired);
+            NativeCrypto.SSL_SESSION_free(first);
+        } finally {
+            for (long serverContext : serverContexts) {
+                if (serverContext != NULL) {
+                    NativeCrypto.SSL_CTX_free(serverContext);
+                }
+            }
+            NativeCrypto.SSL_CTX_free(clientContext);
+            file.delete();
+        }
+    }
+
+    /**
+     * Handshakes a client using clientContext, offering clientSession unless it's NULL, with a
+     * server using serverContext. Returns the client's session, which the caller must free.
+     */
+    private static long handshakeForSession(final long clientContext, final long clientSession,
+                                            final long serverContext) throws Exception {
+        final ServerSocket listener = new ServerSocket(0);
+        final long[] session = new long[] { NULL };
+        Hooks cHooks = new Hooks() {
+            @Override
+            public long getContext() throws SSLException {
+                return clientContext;
+            }
+            @Override
+            public long beforeHandshake(long c) throws SSLException {
+                long s = super.beforeHandshake(c);
+                if (clientSession != NULL) {
+                    NativeCrypto.SSL_set_session(s, clientSession);
+                }
+                return s;
+            }
+            @Override
+            public void afterHandshake(long sessionArg, long s, long c,
+                                       Socket sock, FileDescriptor fd,
+                                       SSLHandshakeCallbacks callback)
+                    throws Exception {
+                super.afterHandshake(NULL, s, NULL, sock, fd, callback);
+                session[0] = sessionArg;
+            }
+        };
+        Hooks sHooks = new ServerHooks(getServerPrivateKey(), getServerCertificates()) {
+            @Override
+            public long getContext() throws SSLException {
+                return serverContext;
+            }
+            @Override
+            public void afterHandshake(long sessionArg, long s, long c,
+                                       Socket sock, FileDescriptor fd,
+                                       SSLHandshakeCallbacks callback)
+                    throws Exception {
+                super.afterHandshake(sessionArg, s, NULL, sock, fd, callback);
+            }
+        };
+        Future<TestSSLHandshakeCallbacks> client
+                = handshake(listener, 0, true, cHooks, null, null);
+        Future<TestSSLHandshakeCallbacks> server
+                = handshake(listener, 0, false, sHooks, null, null);
+        client.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+        server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+        listener.close();
+        return session[0];
+    }
+
+    public void test_SSL_CTX_set_verified_chain_cache() throws Exception {
+        final long clientContext = NativeCrypto.SSL_CTX_new();
+        try {
+            NativeCrypto.SSL_CTX_set_verified_chain_cache(clientContext, 60);
+            try {
+                NativeCrypto.SSL_CTX_set_verified_chain_cache(clientContext, 60);
+                fail();
+            } catch (IllegalStateException expected) {
+            }
+
+            // The second handshake's chain was accepted by the first. The third client hasn't
+            // said what host it verifies against, so mustn't use the cache.
+            for (int i = 0; i < 3; i++) {
+                final boolean setHost = (i < 2);
+                final ServerSocket listener = new ServerSocket(0);
+                Hooks cHooks = new Hooks() {
+                    @Override
+                    public long getContext() throws SSLException {
+                        return clientContext;
+                    }
+                    @Override
+                    public long beforeHandshake(long context) throws SSLException {
+                        long s = super.beforeHandshake(context);
+                        if (setHost) {
+                            NativeCrypto.SSL_set_verified_chain_cache_host(s, "example.com");
+                        }
+                        return s;
+                    }
+                    @Override
+                    public void afterHandshake(long session, long ssl, long context,
+                                               Socket socket, FileDescriptor fd,
+                                               SSLHandshakeCallbacks callback)
+                            throws Exception {
+                        super.afterHandshake(session, ssl, NULL, socket, fd, callback);
+                    }
+                };
+                Hooks sHooks = new ServerHooks(getServerPrivateKey(), getServerCertificates());
+                Future<TestSSLHandshakeCallbacks> client
+                        = handshake(listener, 0, true, cHooks, null, null);
+                Future<TestSSLHandshakeCallbacks> server
+                        = handshake(listener, 0, false, sHooks, null, null);
+                TestSSLHandshakeCallbacks clientCallback
+                        = client.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+                server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+                assertEquals("handshake " + i, i != 1, clientCallback.verifyCertificateChainCalled);
+                assertTrue(clientCallback.handshakeCompletedCalled);
+            }
+        } finally {
+            NativeCrypto.SSL_CTX_free(clientContext);
+        }
+    }
+
     public void test_SSL_new() throws Exception {
         long c = NativeCrypto.SSL_CTX_new();
         long s = NativeCrypto.SSL_new(c);
@@ -1770,6 +1967,72 @@ public class NativeCryptoTest extends TestCase {
         // positively tested by test_SSL_read
     }
 
+    public void test_SSL_write_gathered_and_SSL_read_direct() throws Exception {
+        // Some small buffers, and one more than a record long.
+        final byte[][] buffers = { BYTES, BYTES, new byte[20000], BYTES };
+        for (int i = 0; i < buffers[2].length; i++) {
+            buffers[2][i] = (byte) i;
+        }
+        final int[] offsets = { 0, 1, 0, 2 };
+        final int[] lengths = { BYTES.length, BYTES.length - 1, buffers[2].length, 3 };
+        final ByteArrayOutputStream expected = new ByteArrayOutputStream();
+        for (int i = 0; i < buffers.length; i++) {
+            expected.write(buffers[i], offsets[i], lengths[i]);
+        }
+
+        final ServerSocket listener = new ServerSocket(0);
+        Hooks cHooks = new Hooks() {
+            @Override
+            public void afterHandshake(long session, long s, long c,
+                                       Socket sock, FileDescriptor fd,
+                                       SSLHandshakeCallbacks callback)
+                    throws Exception {
+                ByteBuffer in = ByteBuffer.allocateDirect(expected.size() + 1);
+                while (in.position() < expected.size()) {
+                    int position = in.position();
+                    int count = NativeCrypto.SSL_read_direct(s, fd, callback, in, position,
+                            in.remaining(), 0);
+                    assertTrue(count > 0);
+                    in.position(position + count);
+                }
+                assertEquals(expected.size(), in.position());
+                byte[] actual = new byte[expected.size()];
+                in.flip();
+                in.get(actual);
+                assertTrue(Arrays.equals(expected.toByteArray(), actual));
+                super.afterHandshake(session, s, c, sock, fd, callback);
+            }
+        };
+        Hooks sHooks = new ServerHooks(getServerPrivateKey(), getServerCertificates()) {
+            @Override
+            public void afterHandshake(long session, long s, long c,
+                                       Socket sock, FileDescriptor fd,
+                                       SSLHandshakeCallbacks callback)
+                    throws Exception {
+                NativeCrypto.SSL_write_gathered(s, fd, callback, buffers, offsets, lengths, 0);
+                super.afterHandshake(session, s, c, sock, fd, callback);
+            }
+        };
+        Future<TestSSLHandshakeCallbacks> client = handshake(listener, 0, true, cHooks, null,
+                null);
+        Future<TestSSLHandshakeCallbacks> server = handshake(listener, 0, false, sHooks, null,
+                null);
+        client.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+        server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+    }
+
+    public void test_SSL_read_direct_heap_buffer() throws Exception {
+        long c = NativeCrypto.SSL_CTX_new();
+        long s = NativeCrypto.SSL_new(c);
+        try {
+            NativeCrypto.SSL_read_direct(s, INVALID_FD, DUMMY_CB, ByteBuffer.allocate(1), 0, 1, 0);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+        NativeCrypto.SSL_free(s);
+        NativeCrypto.SSL_CTX_free(c);
+    }
+
     public void test_SSL_interrupt() throws Exception {
         // SSL_interrupt is a rare case that tolerates a null SSL argument
         NativeCrypto.SSL_interrupt(NULL);
@@ -2040,6 +2303,21 @@ public class NativeCryptoTest extends TestCase {
         // positive testing by test_i2d_SSL_SESSION
     }
 
+    public void test_d2i_X509_interns_certificates() throws Exception {
+        byte[] der = getServerCertificates()[0];
+        long first = NativeCrypto.d2i_X509(der);
+        long second = NativeCrypto.d2i_X509(der.clone());
+        assertTrue(first != NULL);
+        assertEquals(first, second);
+        NativeCrypto.X509_free(first);
+        NativeCrypto.X509_free(second);
+
+        // The cache keeps its own reference.
+        long third = NativeCrypto.d2i_X509(der);
+        assertEquals(Arrays.toString(der), Arrays.toString(NativeCrypto.i2d_X509(third)));
+        NativeCrypto.X509_free(third);
+    }
+
     public void test_X509_NAME_hashes() {
         // ensure these hash functions are stable over time since the
         // /system/etc/security/cacerts CA filenames have to be
@@ -2156,6 +2434,22 @@ public class NativeCryptoTest extends TestCase {
                 + "and probably indicates an error.", isZero);
     }
 
+    public void test_RAND_bytes_small_requests() throws Exception {
+        // Enough requests to use up several of the per-thread buffers, with a reseed in the middle.
+        Set<String> seen = new HashSet<String>();
+        for (int i = 0; i < 1000; i++) {
+            if (i == 500) {
+                NativeCrypto.RAND_seed(new byte[16]);
+            }
+            byte[] output = new byte[(i % 16) + 8];
+            NativeCrypto.RAND_bytes(output);
+            assertTrue(seen.add(Arrays.toString(output)));
+        }
+
+        byte[] empty = new byte[0];
+        NativeCrypto.RAND_bytes(empty);
+    }
+
     public void test_RAND_bytes_Null_Failure() throws Exception {
         byte[] output = null;
         try {
@@ -2564,6 +2858,185 @@ public class NativeCryptoTest extends TestCase {
         }
     }
 
+    private static byte[] cbcEncrypt(byte[] plaintext) throws Exception {
+        final long ctx = NativeCrypto.EVP_CIPHER_CTX_new();
+        try {
+            final long evpCipher = NativeCrypto.EVP_get_cipherbyname("aes-128-cbc");
+            NativeCrypto.EVP_CipherInit_ex(ctx, evpCipher, AES_128_KEY, new byte[16], true);
+            byte[] out = new byte[plaintext.length + 16];
+            int n = NativeCrypto.EVP_CipherUpdate(ctx, out, 0, plaintext, 0, plaintext.length);
+            n += NativeCrypto.EVP_CipherFinal_ex(ctx, out, n);
+            return Arrays.copyOf(out, n);
+        } finally {
+            NativeCrypto.EVP_CIPHER_CTX_cleanup(ctx);
+        }
+    }
+
+    public void test_EVP_CipherUpdate_in_place() throws Exception {
+        final byte[] plaintext = new byte[100];
+        for (int i = 0; i < plaintext.length; i++) {
+            plaintext[i] = (byte) i;
+        }
+        final byte[] expected = cbcEncrypt(plaintext);
+
+        final long ctx = NativeCrypto.EVP_CIPHER_CTX_new();
+        try {
+            final long evpCipher = NativeCrypto.EVP_get_cipherbyname("aes-128-cbc");
+            NativeCrypto.EVP_CipherInit_ex(ctx, evpCipher, AES_128_KEY, new byte[16], true);
+            byte[] buffer = Arrays.copyOf(plaintext, expected.length);
+            // An odd split leaves a partial block buffered, so the second update overlaps
+            // differently from the first.
+            int n = NativeCrypto.EVP_CipherUpdate(ctx, buffer, 0, buffer, 0, 37);
+            n += NativeCrypto.EVP_CipherUpdate(ctx, buffer, n, buffer, 37, 63);
+            n += NativeCrypto.EVP_CipherFinal_ex(ctx, buffer, n);
+            assertEquals(expected.length, n);
+            assertEquals(Arrays.toString(expected), Arrays.toString(buffer));
+        } finally {
+            NativeCrypto.EVP_CIPHER_CTX_cleanup(ctx);
+        }
+    }
+
+    public void test_EVP_CipherUpdate_direct() throws Exception {
+        final byte[] plaintext = new byte[100];
+        for (int i = 0; i < plaintext.length; i++) {
+            plaintext[i] = (byte) i;
+        }
+        final byte[] ciphertext = cbcEncrypt(plaintext);
+
+        final long ctx = NativeCrypto.EVP_CIPHER_CTX_new();
+        try {
+            final long evpCipher = NativeCrypto.EVP_get_cipherbyname("aes-128-cbc");
+            NativeCrypto.EVP_CipherInit_ex(ctx, evpCipher, AES_128_KEY, new byte[16], true);
+            ByteBuffer in = ByteBuffer.allocateDirect(plaintext.length + 3);
+            in.position(3);
+            in.put(plaintext);
+            ByteBuffer out = ByteBuffer.allocateDirect(ciphertext.length + 1);
+            int n = NativeCrypto.EVP_CipherUpdate_direct(ctx, out, 1, in, 3, plaintext.length);
+            n += NativeCrypto.EVP_CipherFinal_ex_direct(ctx, out, 1 + n);
+            assertEquals(ciphertext.length, n);
+            byte[] actual = new byte[n];
+            out.position(1);
+            out.get(actual);
+            assertEquals(Arrays.toString(ciphertext), Arrays.toString(actual));
+
+            try {
+                NativeCrypto.EVP_CipherUpdate_direct(ctx, out, 0, in, 4, plaintext.length);
+                fail();
+            } catch (IndexOutOfBoundsException expected) {
+            }
+            try {
+                NativeCrypto.EVP_CipherUpdate_direct(ctx, out, 0, ByteBuffer.allocate(16), 0, 16);
+                fail();
+            } catch (IllegalArgumentException expected) {
+            }
+        } finally {
+            NativeCrypto.EVP_CIPHER_CTX_cleanup(ctx);
+        }
+    }
+
+    public void test_EVP_DigestUpdate_direct() throws Exception {
+        final long evpMd = NativeCrypto.EVP_get_digestbyname("sha256");
+        final byte[] data = new byte[] { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+        long ctx = NativeCrypto.EVP_DigestInit(evpMd);
+        NativeCrypto.EVP_DigestUpdate(ctx, data, 2, 5);
+        byte[] expected = new byte[32];
+        NativeCrypto.EVP_DigestFinal(ctx, expected, 0);
+
+        ByteBuffer buffer = ByteBuffer.allocateDirect(data.length);
+        buffer.put(data);
+        ctx = NativeCrypto.EVP_DigestInit(evpMd);
+        NativeCrypto.EVP_DigestUpdate_direct(ctx, buffer, 2, 5);
+        byte[] actual = new byte[32];
+        NativeCrypto.EVP_DigestFinal(ctx, actual, 0);
+        assertEquals(Arrays.toString(expected), Arrays.toString(actual));
+    }
+
+    public void test_EVP_aead_seal_and_open() throws Exception {
+        final long evpCipher = NativeCrypto.EVP_get_cipherbyname("aes-128-gcm");
+        final byte[] nonce = new byte[12];
+        final byte[] ad = new byte[] { 1, 2, 3 };
+        final byte[] plaintext = "hello, world".getBytes("UTF-8");
+
+        byte[] sealed = new byte[plaintext.length + 16];
+        assertEquals(sealed.length, NativeCrypto.EVP_aead_seal(evpCipher, AES_128_KEY, nonce, ad,
+                plaintext, 0, plaintext.length, sealed, 0, 16));
+        assertFalse(Arrays.equals(plaintext, Arrays.copyOf(sealed, plaintext.length)));
+
+        // Opening in place.
+        byte[] buffer = sealed.clone();
+        assertEquals(plaintext.length, NativeCrypto.EVP_aead_open(evpCipher, AES_128_KEY, nonce,
+                ad, buffer, 0, buffer.length, buffer, 0, 16));
+        assertEquals(Arrays.toString(plaintext),
+                Arrays.toString(Arrays.copyOf(buffer, plaintext.length)));
+
+        byte[] opened = new byte[plaintext.length];
+        try {
+            NativeCrypto.EVP_aead_open(evpCipher, AES_128_KEY, nonce, null, sealed, 0,
+                    sealed.length, opened, 0, 16);
+            fail("opened with the wrong additional data");
+        } catch (BadPaddingException expected) {
+        }
+        sealed[sealed.length - 1] ^= 1;
+        try {
+            NativeCrypto.EVP_aead_open(evpCipher, AES_128_KEY, nonce, ad, sealed, 0,
+                    sealed.length, opened, 0, 16);
+            fail("opened with a bad tag");
+        } catch (BadPaddingException expected) {
+        }
+        assertEquals(Arrays.toString(new byte[plaintext.length]), Arrays.toString(opened));
+    }
+
+    public void test_EVP_CIPHER_CTX_new_pooled() throws Exception {
+        final long evpCipher = NativeCrypto.EVP_get_cipherbyname("aes-128-cbc");
+        final byte[] plaintext = new byte[32];
+        final byte[] expected = cbcEncrypt(plaintext);
+
+        // Contexts handed back are wiped, and work again once given a key.
+        for (int i = 0; i < 20; i++) {
+            final long ctx = NativeCrypto.EVP_CIPHER_CTX_new_pooled(evpCipher);
+            assertTrue(ctx != NULL);
+            try {
+                NativeCrypto.EVP_CipherInit_ex(ctx, evpCipher, AES_128_KEY, new byte[16], true);
+                byte[] out = new byte[expected.length];
+                int n = NativeCrypto.EVP_CipherUpdate(ctx, out, 0, plaintext, 0,
+                        plaintext.length);
+                n += NativeCrypto.EVP_CipherFinal_ex(ctx, out, n);
+                assertEquals(expected.length, n);
+                assertEquals(Arrays.toString(expected), Arrays.toString(out));
+            } finally {
+                NativeCrypto.EVP_CIPHER_CTX_free(ctx);
+            }
+        }
+
+        // A pooled context can be used with another cipher.
+        final long ctx = NativeCrypto.EVP_CIPHER_CTX_new_pooled(evpCipher);
+        try {
+            NativeCrypto.EVP_CipherInit_ex(ctx, NativeCrypto.EVP_get_cipherbyname("aes-128-ecb"),
+                    AES_128_KEY, null, true);
+            assertEquals(16, NativeCrypto.EVP_CIPHER_CTX_block_size(ctx));
+        } finally {
+            NativeCrypto.EVP_CIPHER_CTX_free(ctx);
+        }
+        NativeCrypto.EVP_CIPHER_CTX_free(NULL);
+    }
+
+    public void test_EVP_DigestInit_reuses_contexts() throws Exception {
+        final long evpMd = NativeCrypto.EVP_get_digestbyname("sha256");
+        final byte[] data = new byte[] { 1, 2, 3 };
+        byte[] expected = null;
+        for (int i = 0; i < 20; i++) {
+            long ctx = NativeCrypto.EVP_DigestInit(evpMd);
+            NativeCrypto.EVP_DigestUpdate(ctx, data, 0, data.length);
+            byte[] digest = new byte[32];
+            NativeCrypto.EVP_DigestFinal(ctx, digest, 0);
+            if (expected == null) {
+                expected = digest;
+            }
+            assertEquals(Arrays.toString(expected), Arrays.toString(digest));
+        }
+    }
+
     public void test_EVP_CIPHER_iv_length() throws Exception {
         long aes128ecb = NativeCrypto.EVP_get_cipherbyname("aes-128-ecb");
         assertEquals(0, NativeCrypto.EVP_CIPHER_iv_length(aes128ecb));
@@ -2612,6 +3085,71 @@ public class NativeCryptoTest extends TestCase {
 
     }
 
+    public void test_create_BIO_fd() throws Exception {
+        byte[] der = getServerCertificates()[0];
+        File file = File.createTempFile("NativeCryptoTest", ".der");
+        FileOutputStream os = new FileOutputStream(file);
+        try {
+            os.write(der);
+            os.write(der);
+        } finally {
+            os.close();
+        }
+
+        FileInputStream is = new FileInputStream(file);
+        try {
+            for (int i = 1; i <= 2; ++i) {
+                long ctx = NativeCrypto.create_BIO_fd(is.getFD());
+                assertTrue(ctx != NULL);
+                try {
+                    long x509 = NativeCrypto.d2i_X509_bio(ctx);
+                    assertEquals(Arrays.toString(der),
+                            Arrays.toString(NativeCrypto.i2d_X509(x509)));
+                    NativeCrypto.X509_free(x509);
+                } finally {
+                    NativeCrypto.BIO_free(ctx);
+                }
+                // The descriptor has moved past just the certificate that was read.
+                assertEquals(i * der.length, is.getChannel().position());
+            }
+            assertEquals(NULL, NativeCrypto.create_BIO_fd(is.getFD()));
+        } finally {
+            is.close();
+            file.delete();
+        }
+
+        try {
+            NativeCrypto.create_BIO_fd(null);
+            fail();
+        } catch (NullPointerException expected) {
+        }
+    }
+
+    public void test_create_BIO_direct() throws Exception {
+        ByteBuffer buffer = ByteBuffer.allocateDirect(8);
+        buffer.put("TestTest".getBytes());
+
+        long ctx = NativeCrypto.create_BIO_direct(buffer, 2, 5);
+        try {
+            byte[] output = new byte[1024];
+            int numRead = NativeCrypto.BIO_read(ctx, output);
+            assertEquals("stTes", new String(output, 0, numRead));
+        } finally {
+            NativeCrypto.BIO_free(ctx);
+        }
+
+        try {
+            NativeCrypto.create_BIO_direct(buffer, 4, 5);
+            fail();
+        } catch (IndexOutOfBoundsException expected) {
+        }
+        try {
+            NativeCrypto.create_BIO_direct(ByteBuffer.allocate(8), 0, 8);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+
     public void test_create_BIO_OutputStream() throws Exception {
         byte[] actual = "Test".getBytes();
         ByteArrayOutputStream os = new ByteArrayOutputStream();
@@ -347,4 +347,10 @@ public final class Unsafe {
      * The class' <clinit> will be run, if necessary.
      */
     public native Object allocateInstance(Class<?> c);
+
+    /**
+     * Allocates {@code count} instances of the given class without running their
+     * constructors, in a single native call. The class' <clinit> will be run, if necessary.
+     */
+    public native Object[] allocateInstances(Class<?> c, int count);
 }
@@ -421,6 +421,13 @@ public class File implements Serializable, Comparable<File> {
     private static native String realpath(String path);
     private static native String readlink(String path);
 
+    /**
+     * Discards the cached resolutions of directories that {@link #getCanonicalPath} keeps.
+     * Stale entries are detected and ignored anyway; this just frees the memory.
+     * @hide
+     */
+    public static native void clearRealpathCache();
+
     /**
      * Returns a new file created using the canonical path of this file.
      * Equivalent to {@code new File(this.getCanonicalPath())}.
@@ -749,6 +756,123 @@ public class File implements Serializable, Comparable<File> {
 
     private static native String[] listImpl(String path);
 
+    /**
+     * Returns the entries in the directory represented by this file along with their types
+     * and, if {@code withStats} is true, their mode, length and modification time, or
+     * {@code null} if this file is not a directory. The directory is read with one large
+     * read per batch of entries, and the metadata (if requested) is collected in the same pass,
+     * so a tree walk doesn't need a {@code stat(2)} per entry.
+     *
+     * @hide
+     */
+    public Listing listEntries(boolean withStats) {
+        Object[] result = listEntriesImpl(path, withStats);
+        if (result == null) {
+            return null;
+        }
+        return new Listing(this, (String[]) result[0], (byte[]) result[1], (long[]) result[2]);
+    }
+
+    private static native Object[] listEntriesImpl(String path, boolean withStats);
+
+    /**
+     * The entries of a directory, as returned by {@link File#listEntries}. Entry types come
+     * from the file system and may be {@link #TYPE_UNKNOWN}; the accessors fall back to
+     * {@code stat(2)} when they need to.
+     *
+     * @hide
+     */
+    public static final class Listing {
+        public static final byte TYPE_UNKNOWN = 0;
+        public static final byte TYPE_FIFO = 1;
+        public static final byte TYPE_CHARACTER_DEVICE = 2;
+        public static final byte TYPE_DIRECTORY = 4;
+        public static final byte TYPE_BLOCK_DEVICE = 6;
+        public static final byte TYPE_REGULAR = 8;
+        public static final byte TYPE_SYMLINK = 10;
+        public static final byte TYPE_SOCKET = 12;
+
+        private final File directory;
+        private final String[] names;
+        private final byte[] types;
+        // Three per entry: mode, size and modification time, or null if not requested.
+        private final long[] stats;
+
+        private Listing(File directory, String[] names, byte[] types, long[] stats) {
+            this.directory = directory;
+            this.names = names;
+            this.types = types;
+            this.stats = stats;
+        }
+
+        public int size() {
+            return names.length;
+        }
+
+        public String getName(int i) {
+            return names[i];
+        }
+
+        public File getFile(int i) {
+            return new File(directory, names[i]);
+        }
+
+        /**
+         * Returns the type recorded in the directory for entry {@code i}. Symbolic links are
+         * reported as {@link #TYPE_SYMLINK}, not as the type of their target.
+         */
+        public byte getType(int i) {
+            return types[i];
+        }
+
+        /** Returns true if metadata was collected along with the names. */
+        public boolean hasStats() {
+            return stats != null;
+        }
+
+        /**
+         * Returns the {@code st_mode} of entry {@code i}, following symbolic links, or 0 if the
+         * entry couldn't be examined. Only valid if {@link #hasStats}.
+         */
+        public int getMode(int i) {
+            return (int) stats[3 * i];
+        }
+
+        /** Equivalent to {@code getFile(i).isDirectory()}. */
+        public boolean isDirectory(int i) {
+            if (stats != null) {
+                return S_ISDIR(getMode(i));
+            }
+            byte type = types[i];
+            if (type == TYPE_UNKNOWN || type == TYPE_SYMLINK) {
+                return getFile(i).isDirectory();
+            }
+            return type == TYPE_DIRECTORY;
+        }
+
+        /** Equivalent to {@code getFile(i).isFile()}. */
+        public boolean isFile(int i) {
+            if (stats != null) {
+                return S_ISREG(getMode(i));
+            }
+            byte type = types[i];
+            if (type == TYPE_UNKNOWN || type == TYPE_SYMLINK) {
+                return getFile(i).isFile();
+            }
+            return type == TYPE_REGULAR;
+        }
+
+        /** Equivalent to {@code getFile(i).length()}. */
+        public long length(int i) {
+            return (stats != null) ? stats[3 * i + 1] : getFile(i).length();
+        }
+
+        /** Equivalent to {@code getFile(i).lastModified()}. */
+        public long lastModified(int i) {
+            return (stats != null) ? stats[3 * i + 2] : getFile(i).lastModified();
+        }
+    }
+
     /**
      * Gets a list of the files in the directory represented by this file. This
      * list is then filtered through a FilenameFilter and the names of files
@@ -18,6 +18,8 @@
 package java.lang;
 
 import java.io.Serializable;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.util.Arrays;
 
 /**
@@ -518,6 +520,69 @@ public final class Character implements Serializable, Comparable<Character> {
             DIRECTIONALITY_POP_DIRECTIONAL_FORMAT,
             DIRECTIONALITY_NONSPACING_MARK, DIRECTIONALITY_BOUNDARY_NEUTRAL };
 
+    /**
+     * Two-stage property table for the BMP, built by ICU on first use. See
+     * java_lang_Character.cpp for the layout. The BMP paths below use this instead of a JNI call
+     * per char; supplementary code points still go to ICU.
+     */
+    private static final class BmpProperties {
+        private static final int VERSION = 1;
+        private static final int SHIFT = 6;
+        private static final int MASK = (1 << SHIFT) - 1;
+
+        private static final int TYPE_MASK = 0x1f;
+        private static final int DIRECTIONALITY_SHIFT = 5;
+        private static final int MIRRORED = 1 << 10;
+        private static final int IDENTIFIER_IGNORABLE = 1 << 11;
+        private static final int UNICODE_IDENTIFIER_START = 1 << 12;
+        private static final int UNICODE_IDENTIFIER_PART = 1 << 13;
+        private static final int ALPHABETIC = 1 << 14;
+        private static final int IDEOGRAPHIC = 1 << 15;
+
+        // The native table as a read-only direct buffer, for callers that want to do their own
+        // lookups without JNI.
+        private static final ByteBuffer TABLE;
+        // Java copies of the two stages; reading a direct buffer a char at a time would cost
+        // as much as the JNI calls the table is meant to avoid.
+        private static final char[] BLOCKS;
+        private static final char[] PROPERTIES;
+
+        static {
+            ByteBuffer table = getBmpPropertiesImpl().order(ByteOrder.nativeOrder());
+            if (table.getInt(0) != VERSION) {
+                throw new AssertionError("unexpected BMP property table version " + table.getInt(0));
+            }
+            BLOCKS = new char[table.getInt(8)];
+            PROPERTIES = new char[table.getInt(12)];
+            table.position(16);
+            table.asCharBuffer().get(BLOCKS).get(PROPERTIES);
+            table.position(0);
+            TABLE = table.asReadOnlyBuffer().order(ByteOrder.nativeOrder());
+        }
+
+        static int get(int ch) {
+            return PROPERTIES[BLOCKS[ch >> SHIFT] + (ch & MASK)];
+        }
+
+        // Returns ICU's general category, which (unlike getType) doesn't skip 17.
+        static int icuType(int ch) {
+            return get(ch) & TYPE_MASK;
+        }
+    }
+
+    /**
+     * Returns a read-only direct buffer holding the BMP character property table used by this
+     * class. The layout is documented in java_lang_Character.cpp and starts with a version number
+     * and ICU's Unicode version; the buffer is in native byte order.
+     *
+     * @hide
+     */
+    public static ByteBuffer getBmpPropertiesTable() {
+        return BmpProperties.TABLE.duplicate().order(ByteOrder.nativeOrder());
+    }
+
+    private static native ByteBuffer getBmpPropertiesImpl();
+
     /*
      * Represents a subset of the Unicode character set.
      */
@@ -2503,7 +2568,7 @@ public final class Character implements Serializable, Comparable<Character> {
      * @return the Unicode category of {@code codePoint}.
      */
     public static int getType(int codePoint) {
-        int type = getTypeImpl(codePoint);
+        int type = isBmpCodePoint(codePoint) ? BmpProperties.icuType(codePoint) : getTypeImpl(codePoint);
         // The type values returned by ICU are not RI-compatible. The RI skips the value 17.
         if (type <= Character.FORMAT) {
             return type;
@@ -2532,11 +2597,19 @@ public final class Character implements Serializable, Comparable<Character> {
      * @return the Unicode directionality of {@code codePoint}.
      */
     public static byte getDirectionality(int codePoint) {
-        if (getType(codePoint) == Character.UNASSIGNED) {
-            return Character.DIRECTIONALITY_UNDEFINED;
+        byte directionality;
+        if (isBmpCodePoint(codePoint)) {
+            int properties = BmpProperties.get(codePoint);
+            if ((properties & BmpProperties.TYPE_MASK) == Character.UNASSIGNED) {
+                return Character.DIRECTIONALITY_UNDEFINED;
+            }
+            directionality = (byte) ((properties >> BmpProperties.DIRECTIONALITY_SHIFT) & 0x1f);
+        } else {
+            if (getType(codePoint) == Character.UNASSIGNED) {
+                return Character.DIRECTIONALITY_UNDEFINED;
+            }
+            directionality = getDirectionalityImpl(codePoint);
         }
-
-        byte directionality = getDirectionalityImpl(codePoint);
         if (directionality == -1) {
             return -1;
         }
@@ -2566,6 +2639,9 @@ public final class Character implements Serializable, Comparable<Character> {
      *         otherwise.
      */
     public static boolean isMirrored(int codePoint) {
+        if (isBmpCodePoint(codePoint)) {
+            return (BmpProperties.get(codePoint) & BmpProperties.MIRRORED) != 0;
+        }
         return isMirroredImpl(codePoint);
     }
 
@@ -2599,7 +2675,14 @@ public final class Character implements Serializable, Comparable<Character> {
      * if it is in any of the Lu, Ll, Lt, Lm, Lo, Nl, or Other_Alphabetic categories.
      * @since 1.7
      */
-    public static native boolean isAlphabetic(int codePoint);
+    public static boolean isAlphabetic(int codePoint) {
+        if (isBmpCodePoint(codePoint)) {
+            return (BmpProperties.get(codePoint) & BmpProperties.ALPHABETIC) != 0;
+        }
+        return isAlphabeticImpl(codePoint);
+    }
+
+    private static native boolean isAlphabeticImpl(int codePoint);
 
     /**
      * Returns true if the given code point is in the Basic Multilingual Plane (BMP).
@@ -2620,7 +2703,7 @@ public final class Character implements Serializable, Comparable<Character> {
      *         not {@code UNASSIGNED}; {@code false} otherwise.
      */
     public static boolean isDefined(char c) {
-        return isDefinedImpl(c);
+        return isDefined((int) c);
     }
 
     /**
@@ -2633,6 +2716,10 @@ public final class Character implements Serializable, Comparable<Character> {
      *         not {@code UNASSIGNED}; {@code false} otherwise.
      */
     public static boolean isDefined(int codePoint) {
+        if (isBmpCodePoint(codePoint)) {
+            int type = BmpProperties.icuType(codePoint);
+            return type != UNASSIGNED;
+        }
         return isDefinedImpl(codePoint);
     }
 
@@ -2666,6 +2753,10 @@ public final class Character implements Serializable, Comparable<Character> {
         if (codePoint < 1632) {
             return false;
         }
+        if (isBmpCodePoint(codePoint)) {
+            int type = BmpProperties.icuType(codePoint);
+            return type == DECIMAL_DIGIT_NUMBER;
+        }
         return isDigitImpl(codePoint);
     }
 
@@ -2687,7 +2778,14 @@ public final class Character implements Serializable, Comparable<Character> {
      * Returns true if the given code point is a CJKV ideographic character.
      * @since 1.7
      */
-    public static native boolean isIdeographic(int codePoint);
+    public static boolean isIdeographic(int codePoint) {
+        if (isBmpCodePoint(codePoint)) {
+            return (BmpProperties.get(codePoint) & BmpProperties.IDEOGRAPHIC) != 0;
+        }
+        return isIdeographicImpl(codePoint);
+    }
+
+    private static native boolean isIdeographicImpl(int codePoint);
 
     /**
      * Indicates whether the specified code point is ignorable in a Java or
@@ -2704,6 +2802,9 @@ public final class Character implements Serializable, Comparable<Character> {
             return (codePoint >= 0 && codePoint <= 8) || (codePoint >= 0xe && codePoint <= 0x1b) ||
                     (codePoint >= 0x7f && codePoint <= 0x9f) || (codePoint == 0xad);
         }
+        if (isBmpCodePoint(codePoint)) {
+            return (BmpProperties.get(codePoint) & BmpProperties.IDENTIFIER_IGNORABLE) != 0;
+        }
         return isIdentifierIgnorableImpl(codePoint);
     }
 
@@ -2860,6 +2961,10 @@ public final class Character implements Serializable, Comparable<Character> {
         if (codePoint < 128) {
             return false;
         }
+        if (isBmpCodePoint(codePoint)) {
+            int type = BmpProperties.icuType(codePoint);
+            return type >= UPPERCASE_LETTER && type <= OTHER_LETTER;
+        }
         return isLetterImpl(codePoint);
     }
 
@@ -2896,6 +3001,10 @@ public final class Character implements Serializable, Comparable<Character> {
         if (codePoint < 128) {
             return false;
         }
+        if (isBmpCodePoint(codePoint)) {
+            int type = BmpProperties.icuType(codePoint);
+            return (type >= UPPERCASE_LETTER && type <= OTHER_LETTER) || type == DECIMAL_DIGIT_NUMBER;
+        }
         return isLetterOrDigitImpl(codePoint);
     }
 
@@ -2929,6 +3038,10 @@ public final class Character implements Serializable, Comparable<Character> {
         if (codePoint < 128) {
             return false;
         }
+        if (isBmpCodePoint(codePoint)) {
+            int type = BmpProperties.icuType(codePoint);
+            return type == LOWERCASE_LETTER;
+        }
         return isLowerCaseImpl(codePoint);
     }
 
@@ -2993,7 +3106,7 @@ public final class Character implements Serializable, Comparable<Character> {
      *         otherwise.
      */
     public static boolean isTitleCase(char c) {
-        return isTitleCaseImpl(c);
+        return isTitleCase((int) c);
     }
 
     /**
@@ -3005,6 +3118,10 @@ public final class Character implements Serializable, Comparable<Character> {
      *         {@code false} otherwise.
      */
     public static boolean isTitleCase(int codePoint) {
+        if (isBmpCodePoint(codePoint)) {
+            int type = BmpProperties.icuType(codePoint);
+            return type == TITLECASE_LETTER;
+        }
         return isTitleCaseImpl(codePoint);
     }
 
@@ -3020,7 +3137,7 @@ public final class Character implements Serializable, Comparable<Character> {
      *         identifier; {@code false} otherwise.
      */
     public static boolean isUnicodeIdentifierPart(char c) {
-        return isUnicodeIdentifierPartImpl(c);
+        return isUnicodeIdentifierPart((int) c);
     }
 
     /**
@@ -3033,6 +3150,9 @@ public final class Character implements Serializable, Comparable<Character> {
      *         identifier; {@code false} otherwise.
      */
     public static boolean isUnicodeIdentifierPart(int codePoint) {
+        if (isBmpCodePoint(codePoint)) {
+            return (BmpProperties.get(codePoint) & BmpProperties.UNICODE_IDENTIFIER_PART) != 0;
+        }
         return isUnicodeIdentifierPartImpl(codePoint);
     }
 
@@ -3048,7 +3168,7 @@ public final class Character implements Serializable, Comparable<Character> {
      *         Unicode identifier; {@code false} otherwise.
      */
     public static boolean isUnicodeIdentifierStart(char c) {
-        return isUnicodeIdentifierStartImpl(c);
+        return isUnicodeIdentifierStart((int) c);
     }
 
     /**
@@ -3061,6 +3181,9 @@ public final class Character implements Serializable, Comparable<Character> {
      *         a Unicode identifier; {@code false} otherwise.
      */
     public static boolean isUnicodeIdentifierStart(int codePoint) {
+        if (isBmpCodePoint(codePoint)) {
+            return (BmpProperties.get(codePoint) & BmpProperties.UNICODE_IDENTIFIER_START) != 0;
+        }
         return isUnicodeIdentifierStartImpl(codePoint);
     }
 
@@ -3094,6 +3217,10 @@ public final class Character implements Serializable, Comparable<Character> {
         if (codePoint < 128) {
             return false;
         }
+        if (isBmpCodePoint(codePoint)) {
+            int type = BmpProperties.icuType(codePoint);
+            return type == UPPERCASE_LETTER;
+        }
         return isUpperCaseImpl(codePoint);
     }
 
@@ -295,6 +295,45 @@ public final class Double extends Number implements Comparable<Double> {
         return StringToReal.parseDouble(string);
     }
 
+    /**
+     * Parses {@code byteCount} ASCII bytes starting at {@code offset} as a double, like
+     * {@link #parseDouble(String)} but without creating a {@code String} for plain decimal numbers.
+     *
+     * @throws NumberFormatException
+     *             if the bytes can't be parsed as a double value.
+     * @hide
+     */
+    public static double parseDouble(byte[] bytes, int offset, int byteCount) throws NumberFormatException {
+        return StringToReal.parseDouble(bytes, offset, byteCount);
+    }
+
+    /**
+     * Parses the {@code delimiter}-separated fields of {@code byteCount} ASCII bytes starting at
+     * {@code offset} into {@code dst} starting at {@code dstOffset}, and returns the number of
+     * fields. Each field is parsed as by {@link #parseDouble(String)}, but plain decimal numbers
+     * are parsed in batches without creating any objects. No bytes means no fields.
+     *
+     * @throws NumberFormatException
+     *             if a field can't be parsed as a double value.
+     * @throws ArrayIndexOutOfBoundsException
+     *             if {@code dst} has no room for all the fields.
+     * @hide
+     */
+    public static int parseDoubles(byte[] bytes, int offset, int byteCount, char delimiter,
+            double[] dst, int dstOffset) throws NumberFormatException {
+        return StringToReal.parseDoubles(bytes, offset, byteCount, delimiter, dst, dstOffset);
+    }
+
+    /**
+     * Like {@link #parseDoubles(byte[], int, int, char, double[], int)}, for chars.
+     *
+     * @hide
+     */
+    public static int parseDoubles(char[] chars, int offset, int charCount, char delimiter,
+            double[] dst, int dstOffset) throws NumberFormatException {
+        return StringToReal.parseDoubles(chars, offset, charCount, delimiter, dst, dstOffset);
+    }
+
     @Override
     public short shortValue() {
         return (short) value;
@@ -317,6 +356,45 @@ public final class Double extends Number implements Comparable<Double> {
         return RealToString.getInstance().doubleToString(d);
     }
 
+    /**
+     * Writes {@link #toString(double) toString(d)} to {@code dst} starting at {@code offset},
+     * without creating a {@code String}. Returns the number of chars written, which is at most 24.
+     *
+     * @throws ArrayIndexOutOfBoundsException
+     *             if the result doesn't fit in {@code dst} after {@code offset}.
+     * @hide
+     */
+    public static int toChars(double d, char[] dst, int offset) {
+        return RealToString.doubleToChars(d, dst, offset);
+    }
+
+    /**
+     * Writes {@link #toString(double) toString(d)} to {@code dst} as ASCII bytes starting at
+     * {@code offset}. Returns the number of bytes written, which is at most 24.
+     *
+     * @throws ArrayIndexOutOfBoundsException
+     *             if the result doesn't fit in {@code dst} after {@code offset}.
+     * @hide
+     */
+    public static int toBytes(double d, byte[] dst, int offset) {
+        return RealToString.doubleToBytes(d, dst, offset);
+    }
+
+    /**
+     * Writes {@code toString} of each of the {@code count} doubles starting at {@code offset}
+     * to {@code dst} as ASCII bytes starting at {@code dstOffset}, separated by the ASCII
+     * {@code delimiter}. Returns the number of bytes written, which is at most
+     * {@code 25 * count}.
+     *
+     * @throws ArrayIndexOutOfBoundsException
+     *             if the result doesn't fit in {@code dst} after {@code dstOffset}.
+     * @hide
+     */
+    public static int toBytes(double[] src, int offset, int count, char delimiter, byte[] dst,
+            int dstOffset) {
+        return RealToString.doublesToBytes(src, offset, count, delimiter, dst, dstOffset);
+    }
+
     /**
      * Parses the specified string as a double value.
      *
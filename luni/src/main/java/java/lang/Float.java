@@ -300,6 +300,18 @@ public final class Float extends Number implements Comparable<Float> {
         return StringToReal.parseFloat(string);
     }
 
+    /**
+     * Parses {@code byteCount} ASCII bytes starting at {@code offset} as a float, like
+     * {@link #parseFloat(String)} but without creating a {@code String} for plain decimal numbers.
+     *
+     * @throws NumberFormatException
+     *             if the bytes can't be parsed as a float value.
+     * @hide
+     */
+    public static float parseFloat(byte[] bytes, int offset, int byteCount) throws NumberFormatException {
+        return StringToReal.parseFloat(bytes, offset, byteCount);
+    }
+
     @Override
     public short shortValue() {
         return (short) value;
@@ -322,6 +334,30 @@ public final class Float extends Number implements Comparable<Float> {
         return RealToString.getInstance().floatToString(f);
     }
 
+    /**
+     * Writes {@link #toString(float) toString(f)} to {@code dst} starting at {@code offset},
+     * without creating a {@code String}. Returns the number of chars written, which is at most 24.
+     *
+     * @throws ArrayIndexOutOfBoundsException
+     *             if the result doesn't fit in {@code dst} after {@code offset}.
+     * @hide
+     */
+    public static int toChars(float f, char[] dst, int offset) {
+        return RealToString.floatToChars(f, dst, offset);
+    }
+
+    /**
+     * Writes {@link #toString(float) toString(f)} to {@code dst} as ASCII bytes starting at
+     * {@code offset}. Returns the number of bytes written, which is at most 24.
+     *
+     * @throws ArrayIndexOutOfBoundsException
+     *             if the result doesn't fit in {@code dst} after {@code offset}.
+     * @hide
+     */
+    public static int toBytes(float f, byte[] dst, int offset) {
+        return RealToString.floatToBytes(f, dst, offset);
+    }
+
     /**
      * Parses the specified string as a float value.
      *
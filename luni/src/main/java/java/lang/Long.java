@@ -318,6 +318,34 @@ public final class Long extends Number implements Comparable<Long> {
         return parseLong(string, 10);
     }
 
+    /**
+     * Parses the {@code delimiter}-separated fields of {@code byteCount} ASCII bytes starting at
+     * {@code offset} into {@code dst} starting at {@code dstOffset}, and returns the number of
+     * fields. Each field is trimmed and then parsed as by {@link #parseLong(String)}, but plain
+     * decimal numbers are parsed in batches without creating any objects. No bytes means no
+     * fields.
+     *
+     * @throws NumberFormatException
+     *             if a field can't be parsed as a long value.
+     * @throws ArrayIndexOutOfBoundsException
+     *             if {@code dst} has no room for all the fields.
+     * @hide
+     */
+    public static int parseLongs(byte[] bytes, int offset, int byteCount, char delimiter,
+            long[] dst, int dstOffset) throws NumberFormatException {
+        return StringToReal.parseLongs(bytes, offset, byteCount, delimiter, dst, dstOffset);
+    }
+
+    /**
+     * Like {@link #parseLongs(byte[], int, int, char, long[], int)}, for chars.
+     *
+     * @hide
+     */
+    public static int parseLongs(char[] chars, int offset, int charCount, char delimiter,
+            long[] dst, int dstOffset) throws NumberFormatException {
+        return StringToReal.parseLongs(chars, offset, charCount, delimiter, dst, dstOffset);
+    }
+
     /**
      * Parses the specified string as a signed long value using the specified
      * radix. The ASCII character \u002d ('-') is recognized as the minus sign.
@@ -17,7 +17,7 @@
 
 package java.lang;
 
-import libcore.math.MathUtils;
+import java.util.Arrays;
 
 final class RealToString {
     private static final ThreadLocal<RealToString> INSTANCE = new ThreadLocal<RealToString>() {
@@ -26,19 +26,12 @@ final class RealToString {
         }
     };
 
-    private static final double invLogOfTenBaseTwo = Math.log(2.0) / Math.log(10.0);
-
-    private int firstK;
-
     /**
-     * An array of decimal digits, filled by longDigitGenerator or bigIntDigitGenerator.
+     * The longest string doubleToString or floatToString can return: "-2.2250738585072014E-308".
      */
-    private final int[] digits = new int[64];
+    static final int MAX_CHARS = 24;
 
-    /**
-     * Number of valid entries in 'digits'.
-     */
-    private int digitCount;
+    private final char[] chars = new char[MAX_CHARS];
 
     private RealToString() {
     }
@@ -47,274 +40,64 @@ final class RealToString {
         return INSTANCE.get();
     }
 
-    private static String resultOrSideEffect(AbstractStringBuilder sb, String s) {
-        if (sb != null) {
-            sb.append0(s);
-            return null;
-        }
-        return s;
-    }
-
     public String doubleToString(double d) {
-        return convertDouble(null, d);
+        return new String(chars, 0, doubleToChars(d, chars, 0));
     }
 
     public void appendDouble(AbstractStringBuilder sb, double d) {
-        convertDouble(sb, d);
-    }
-
-    private String convertDouble(AbstractStringBuilder sb, double inputNumber) {
-        long inputNumberBits = Double.doubleToRawLongBits(inputNumber);
-        boolean positive = (inputNumberBits & Double.SIGN_MASK) == 0;
-        int e = (int) ((inputNumberBits & Double.EXPONENT_MASK) >> Double.MANTISSA_BITS);
-        long f = inputNumberBits & Double.MANTISSA_MASK;
-        boolean mantissaIsZero = f == 0;
-
-        String quickResult = null;
-        if (e == 2047) {
-            if (mantissaIsZero) {
-                quickResult = positive ? "Infinity" : "-Infinity";
-            } else {
-                quickResult = "NaN";
-            }
-        } else if (e == 0) {
-            if (mantissaIsZero) {
-                quickResult = positive ? "0.0" : "-0.0";
-            } else if (f == 1) {
-                // special case to increase precision even though 2 * Double.MIN_VALUE is 1.0e-323
-                quickResult = positive ? "4.9E-324" : "-4.9E-324";
-            }
-        }
-        if (quickResult != null) {
-            return resultOrSideEffect(sb, quickResult);
-        }
-
-        int p = Double.EXPONENT_BIAS + Double.MANTISSA_BITS; // the power offset (precision)
-        int pow;
-        int numBits = Double.MANTISSA_BITS;
-        if (e == 0) {
-            pow = 1 - p; // a denormalized number
-            long ff = f;
-            while ((ff & 0x0010000000000000L) == 0) {
-                ff = ff << 1;
-                numBits--;
-            }
-        } else {
-            // 0 < e < 2047
-            // a "normalized" number
-            f = f | 0x0010000000000000L;
-            pow = e - p;
-        }
-
-        firstK = digitCount = 0;
-        if (-59 < pow && pow < 6 || (pow == -59 && !mantissaIsZero)) {
-            longDigitGenerator(f, pow, e == 0, mantissaIsZero, numBits);
-        } else {
-            bigIntDigitGenerator(f, pow, e == 0, numBits);
-        }
-        AbstractStringBuilder dst = (sb != null) ? sb : new StringBuilder(26);
-        if (inputNumber >= 1e7D || inputNumber <= -1e7D
-                || (inputNumber > -1e-3D && inputNumber < 1e-3D)) {
-            freeFormatExponential(dst, positive);
-        } else {
-            freeFormat(dst, positive);
-        }
-        return (sb != null) ? null : dst.toString();
+        sb.append0(chars, 0, doubleToChars(d, chars, 0));
     }
 
     public String floatToString(float f) {
-        return convertFloat(null, f);
+        return new String(chars, 0, floatToChars(f, chars, 0));
     }
 
     public void appendFloat(AbstractStringBuilder sb, float f) {
-        convertFloat(sb, f);
+        sb.append0(chars, 0, floatToChars(f, chars, 0));
     }
 
-    public String convertFloat(AbstractStringBuilder sb, float inputNumber) {
-        int inputNumberBits = Float.floatToRawIntBits(inputNumber);
-        boolean positive = (inputNumberBits & Float.SIGN_MASK) == 0;
-        int e = (inputNumberBits & Float.EXPONENT_MASK) >> Float.MANTISSA_BITS;
-        int f = inputNumberBits & Float.MANTISSA_MASK;
-        boolean mantissaIsZero = f == 0;
-
-        String quickResult = null;
-        if (e == 255) {
-            if (mantissaIsZero) {
-                quickResult = positive ? "Infinity" : "-Infinity";
-            } else {
-                quickResult = "NaN";
-            }
-        } else if (e == 0 && mantissaIsZero) {
-            quickResult = positive ? "0.0" : "-0.0";
-        }
-        if (quickResult != null) {
-            return resultOrSideEffect(sb, quickResult);
-        }
-
-        int p = Float.EXPONENT_BIAS + Float.MANTISSA_BITS; // the power offset (precision)
-        int pow;
-        int numBits = Float.MANTISSA_BITS;
-        if (e == 0) {
-            pow = 1 - p; // a denormalized number
-            if (f < 8) { // want more precision with smallest values
-                f = f << 2;
-                pow -= 2;
-            }
-            int ff = f;
-            while ((ff & 0x00800000) == 0) {
-                ff = ff << 1;
-                numBits--;
-            }
-        } else {
-            // 0 < e < 255
-            // a "normalized" number
-            f = f | 0x00800000;
-            pow = e - p;
-        }
-
-        firstK = digitCount = 0;
-        if (-59 < pow && pow < 35 || (pow == -59 && !mantissaIsZero)) {
-            longDigitGenerator(f, pow, e == 0, mantissaIsZero, numBits);
-        } else {
-            bigIntDigitGenerator(f, pow, e == 0, numBits);
-        }
-        AbstractStringBuilder dst = (sb != null) ? sb : new StringBuilder(26);
-        if (inputNumber >= 1e7f || inputNumber <= -1e7f
-                || (inputNumber > -1e-3f && inputNumber < 1e-3f)) {
-            freeFormatExponential(dst, positive);
-        } else {
-            freeFormat(dst, positive);
-        }
-        return (sb != null) ? null : dst.toString();
-    }
+    /**
+     * Writes {@code Double.toString(d)} to {@code dst} starting at {@code offset}, and returns
+     * the number of chars written.
+     *
+     * @throws ArrayIndexOutOfBoundsException
+     *             if the result doesn't fit; at most {@link #MAX_CHARS} are needed.
+     */
+    static native int doubleToChars(double d, char[] dst, int offset);
 
-    private void freeFormatExponential(AbstractStringBuilder sb, boolean positive) {
-        int digitIndex = 0;
-        if (!positive) {
-            sb.append0('-');
-        }
-        sb.append0((char) ('0' + digits[digitIndex++]));
-        sb.append0('.');
+    /**
+     * Writes {@code Double.toString(d)} to {@code dst} as ASCII bytes starting at
+     * {@code offset}, and returns the number of bytes written.
+     */
+    static native int doubleToBytes(double d, byte[] dst, int offset);
 
-        int k = firstK;
-        int exponent = k;
-        while (true) {
-            k--;
-            if (digitIndex >= digitCount) {
-                break;
-            }
-            sb.append0((char) ('0' + digits[digitIndex++]));
-        }
+    /**
+     * Writes {@code Float.toString(f)} to {@code dst} starting at {@code offset}, and returns
+     * the number of chars written.
+     */
+    static native int floatToChars(float f, char[] dst, int offset);
 
-        if (k == exponent - 1) {
-            sb.append0('0');
-        }
-        sb.append0('E');
-        IntegralToString.appendInt(sb, exponent);
-    }
+    /**
+     * Writes {@code Float.toString(f)} to {@code dst} as ASCII bytes starting at
+     * {@code offset}, and returns the number of bytes written.
+     */
+    static native int floatToBytes(float f, byte[] dst, int offset);
 
-    private void freeFormat(AbstractStringBuilder sb, boolean positive) {
-        int digitIndex = 0;
-        if (!positive) {
-            sb.append0('-');
-        }
-        int k = firstK;
-        if (k < 0) {
-            sb.append0('0');
-            sb.append0('.');
-            for (int i = k + 1; i < 0; ++i) {
-                sb.append0('0');
-            }
-        }
-        int U = digits[digitIndex++];
-        do {
-            if (U != -1) {
-                sb.append0((char) ('0' + U));
-            } else if (k >= -1) {
-                sb.append0('0');
-            }
-            if (k == 0) {
-                sb.append0('.');
-            }
-            k--;
-            U = digitIndex < digitCount ? digits[digitIndex++] : -1;
-        } while (U != -1 || k >= -1);
+    /**
+     * Writes the doubles in {@code src[offset, offset + count)} to {@code dst} as ASCII bytes
+     * starting at {@code dstOffset}, separated by {@code delimiter}, and returns the number of
+     * bytes written. At most {@code count * (MAX_CHARS + 1)} bytes are needed.
+     */
+    static int doublesToBytes(double[] src, int offset, int count, char delimiter, byte[] dst,
+            int dstOffset) {
+        Arrays.checkOffsetAndCount(src.length, offset, count);
+        Arrays.checkOffsetAndCount(dst.length, dstOffset, 0);
+        if (delimiter > 0x7f) {
+            throw new IllegalArgumentException("Non-ASCII delimiter: " + (int) delimiter);
+        }
+        return doublesToBytesImpl(src, offset, count, delimiter, dst, dstOffset);
     }
 
-    private native void bigIntDigitGenerator(long f, int e, boolean isDenormalized, int p);
-
-    private void longDigitGenerator(long f, int e, boolean isDenormalized,
-            boolean mantissaIsZero, int p) {
-        long R, S, M;
-        if (e >= 0) {
-            M = 1l << e;
-            if (!mantissaIsZero) {
-                R = f << (e + 1);
-                S = 2;
-            } else {
-                R = f << (e + 2);
-                S = 4;
-            }
-        } else {
-            M = 1;
-            if (isDenormalized || !mantissaIsZero) {
-                R = f << 1;
-                S = 1l << (1 - e);
-            } else {
-                R = f << 2;
-                S = 1l << (2 - e);
-            }
-        }
-
-        int k = (int) Math.ceil((e + p - 1) * invLogOfTenBaseTwo - 1e-10);
-
-        if (k > 0) {
-            S = S * MathUtils.LONG_POWERS_OF_TEN[k];
-        } else if (k < 0) {
-            long scale = MathUtils.LONG_POWERS_OF_TEN[-k];
-            R = R * scale;
-            M = M == 1 ? scale : M * scale;
-        }
-
-        if (R + M > S) { // was M_plus
-            firstK = k;
-        } else {
-            firstK = k - 1;
-            R = R * 10;
-            M = M * 10;
-        }
-
-        boolean low, high;
-        int U;
-        while (true) {
-            // Set U to floor(R/S) and R to the remainder, using *unsigned* 64-bit division
-            U = 0;
-            for (int i = 3; i >= 0; i--) {
-                long remainder = R - (S << i);
-                if (remainder >= 0) {
-                    R = remainder;
-                    U += 1 << i;
-                }
-            }
-
-            low = R < M; // was M_minus
-            high = R + M > S; // was M_plus
-
-            if (low || high) {
-                break;
-            }
-            R = R * 10;
-            M = M * 10;
-            digits[digitCount++] = U;
-        }
-        if (low && !high) {
-            digits[digitCount++] = U;
-        } else if (high && !low) {
-            digits[digitCount++] = U + 1;
-        } else if ((R << 1) < S) {
-            digits[digitCount++] = U;
-        } else {
-            digits[digitCount++] = U + 1;
-        }
-    }
+    private static native int doublesToBytesImpl(double[] src, int offset, int count,
+            char delimiter, byte[] dst, int dstOffset);
 }
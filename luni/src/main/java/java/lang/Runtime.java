@@ -286,6 +286,9 @@ public class Runtime {
                     runFinalization();
                 }
 
+                // Don't lose anything still queued for the log.
+                System.flushLog();
+
                 // Get out of here finally...
                 nativeExit(code);
             }
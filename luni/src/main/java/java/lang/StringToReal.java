@@ -17,6 +17,9 @@
 
 package java.lang;
 
+import java.nio.charset.StandardCharsets;
+import java.util.Arrays;
+
 /**
  * Used to parse a string and return either a single or double precision
  * floating point number.
@@ -59,6 +62,33 @@ final class StringToReal {
      */
     private static native float parseFltImpl(String s, int e);
 
+    /**
+     * Returns the closest double value to the plain decimal number in the given ASCII bytes,
+     * or Double.longBitsToDouble(-1) if the bytes need the general String-based parsing.
+     */
+    private static native double parseDblBytesImpl(byte[] bytes, int offset, int byteCount);
+
+    /**
+     * Returns the closest float value to the plain decimal number in the given ASCII bytes,
+     * or Float.intBitsToFloat(-1) if the bytes need the general String-based parsing.
+     */
+    private static native float parseFltBytesImpl(byte[] bytes, int offset, int byteCount);
+
+    /*
+     * The batch parsers fill dst from dstOffset with the fields of src[offset, end) separated
+     * by 'delimiter', and return how many there were. Plain decimals are parsed natively; any
+     * other field is handed to parseDouble(String) or parseTrimmedLong without letting go of
+     * src and dst.
+     */
+    private static native int parseDoublesBytesImpl(byte[] src, int offset, int end,
+            char delimiter, double[] dst, int dstOffset);
+    private static native int parseDoublesCharsImpl(char[] src, int offset, int end,
+            char delimiter, double[] dst, int dstOffset);
+    private static native int parseLongsBytesImpl(byte[] src, int offset, int end,
+            char delimiter, long[] dst, int dstOffset);
+    private static native int parseLongsCharsImpl(char[] src, int offset, int end,
+            char delimiter, long[] dst, int dstOffset);
+
     private static NumberFormatException invalidReal(String s, boolean isDouble) {
         throw new NumberFormatException("Invalid " + (isDouble ? "double" : "float") + ": \"" + s + "\"");
     }
@@ -311,4 +341,91 @@ final class StringToReal {
         }
         return info.negative ? -result : result;
     }
+
+    /**
+     * Equivalent to parseDouble(new String(bytes, offset, byteCount)) for ASCII bytes, but
+     * plain decimal numbers are parsed without creating any objects.
+     */
+    public static double parseDouble(byte[] bytes, int offset, int byteCount) {
+        Arrays.checkOffsetAndCount(bytes.length, offset, byteCount);
+        double result = parseDblBytesImpl(bytes, offset, byteCount);
+        if (Double.doubleToRawLongBits(result) == 0xffffffffffffffffL) {
+            return parseDouble(new String(bytes, offset, byteCount, StandardCharsets.ISO_8859_1));
+        }
+        return result;
+    }
+
+    /**
+     * Equivalent to parseFloat(new String(bytes, offset, byteCount)) for ASCII bytes, but
+     * plain decimal numbers are parsed without creating any objects.
+     */
+    public static float parseFloat(byte[] bytes, int offset, int byteCount) {
+        Arrays.checkOffsetAndCount(bytes.length, offset, byteCount);
+        float result = parseFltBytesImpl(bytes, offset, byteCount);
+        if (Float.floatToRawIntBits(result) == 0xffffffff) {
+            return parseFloat(new String(bytes, offset, byteCount, StandardCharsets.ISO_8859_1));
+        }
+        return result;
+    }
+
+    /**
+     * Parses the fields of bytes[offset, offset + byteCount) separated by 'delimiter' into dst
+     * starting at dstOffset, and returns how many there were. Each field is parsed as by
+     * parseDouble(String), but plain decimals are parsed natively. An empty range holds no
+     * fields.
+     */
+    public static int parseDoubles(byte[] bytes, int offset, int byteCount, char delimiter,
+            double[] dst, int dstOffset) {
+        Arrays.checkOffsetAndCount(bytes.length, offset, byteCount);
+        Arrays.checkOffsetAndCount(dst.length, dstOffset, 0);
+        if (byteCount == 0) {
+            return 0;
+        }
+        return parseDoublesBytesImpl(bytes, offset, offset + byteCount, delimiter, dst, dstOffset);
+    }
+
+    /**
+     * Like parseDoubles(byte[], int, int, char, double[], int), for chars.
+     */
+    public static int parseDoubles(char[] chars, int offset, int charCount, char delimiter,
+            double[] dst, int dstOffset) {
+        Arrays.checkOffsetAndCount(chars.length, offset, charCount);
+        Arrays.checkOffsetAndCount(dst.length, dstOffset, 0);
+        if (charCount == 0) {
+            return 0;
+        }
+        return parseDoublesCharsImpl(chars, offset, offset + charCount, delimiter, dst, dstOffset);
+    }
+
+    /**
+     * Like parseDoubles(byte[], int, int, char, double[], int), but each field is parsed as by
+     * Long.parseLong after trimming it.
+     */
+    public static int parseLongs(byte[] bytes, int offset, int byteCount, char delimiter,
+            long[] dst, int dstOffset) {
+        Arrays.checkOffsetAndCount(bytes.length, offset, byteCount);
+        Arrays.checkOffsetAndCount(dst.length, dstOffset, 0);
+        if (byteCount == 0) {
+            return 0;
+        }
+        return parseLongsBytesImpl(bytes, offset, offset + byteCount, delimiter, dst, dstOffset);
+    }
+
+    /**
+     * Like parseLongs(byte[], int, int, char, long[], int), for chars.
+     */
+    public static int parseLongs(char[] chars, int offset, int charCount, char delimiter,
+            long[] dst, int dstOffset) {
+        Arrays.checkOffsetAndCount(chars.length, offset, charCount);
+        Arrays.checkOffsetAndCount(dst.length, dstOffset, 0);
+        if (charCount == 0) {
+            return 0;
+        }
+        return parseLongsCharsImpl(chars, offset, offset + charCount, delimiter, dst, dstOffset);
+    }
+
+    // Called from native code for the long fields the fast path leaves alone.
+    private static long parseTrimmedLong(String s) {
+        return Long.parseLong(s.trim());
+    }
 }
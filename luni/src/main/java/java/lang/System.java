@@ -568,6 +568,29 @@ public final class System {
         log('W', message, th);
     }
 
+    /**
+     * Waits until everything logged through {@link #logE}, {@link #logI} and {@link #logW} so far
+     * has been written to the log. Messages are queued and written by a background thread, so
+     * they can be lost if the process exits without calling this.
+     *
+     * @hide internal use only
+     */
+    public static native void flushLog();
+
+    /**
+     * Returns how many messages logged through {@link #logE}, {@link #logI} and {@link #logW}
+     * have been dropped because the queue was full.
+     *
+     * @hide internal use only
+     */
+    public static native long getDroppedLogCount();
+
+    /*
+     * Stops or restarts the thread that writes queued log messages, so that tests can fill the
+     * queue. Pausing writes out everything queued so far. Not API: tests reach it by reflection.
+     */
+    private static native void setLogWriterPaused(boolean paused);
+
     private static native void log(char type, String message, Throwable th);
 
     /**
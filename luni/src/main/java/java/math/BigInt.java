@@ -203,6 +203,22 @@ final class BigInt {
         return NativeBN.bn2litEndInts(this.bignum);
     }
 
+    /**
+     * Copies the big-endian magnitude into dst at offset if it fits, returning its length
+     * in bytes either way.
+     */
+    int bigEndianMagnitude(byte[] dst, int offset) {
+        return NativeBN.BN_bn2binInto(this.bignum, dst, offset);
+    }
+
+    /**
+     * Copies the little-endian int magnitude into dst at offset if it fits, returning its
+     * length in ints either way. Zero has no ints.
+     */
+    int littleEndianIntsMagnitude(int[] dst, int offset) {
+        return NativeBN.bn2litEndIntsInto(this.bignum, dst, offset);
+    }
+
     int sign() {
         return NativeBN.sign(this.bignum);
     }
@@ -329,6 +345,19 @@ final class BigInt {
     }
 
 
+    // (a * b + c) mod m in a single call.
+    static BigInt multiplyAddMod(BigInt a, BigInt b, BigInt c, BigInt m) {
+        BigInt r = newBigInt();
+        int[] ops = {
+            NativeBN.OP_MUL, 0, 1, 2, 0,
+            NativeBN.OP_ADD, 0, 0, 3, 0,
+            NativeBN.OP_NNMOD, 0, 0, 0, 4,
+        };
+        long[] registers = { r.bignum, a.bignum, b.bignum, c.bignum, m.bignum };
+        NativeBN.runOps(ops, ops.length / NativeBN.OPS_PER_OP, registers);
+        return r;
+    }
+
     static BigInt modInverse(BigInt a, BigInt m) {
         BigInt r = newBigInt();
         NativeBN.BN_mod_inverse(r.bignum, a.bignum, m.bignum);
@@ -345,4 +374,49 @@ final class BigInt {
     boolean isPrime(int certainty) {
         return NativeBN.BN_is_prime_ex(bignum, certainty, 0);
     }
+
+    static int batchThreadCount(int count) {
+        return Math.min(count, Runtime.getRuntime().availableProcessors());
+    }
+
+    private static long[] handles(BigInt[] a) {
+        long[] result = new long[a.length];
+        for (int i = 0; i < a.length; ++i) {
+            result[i] = a[i].bignum;
+        }
+        return result;
+    }
+
+    /**
+     * Computes r[i] = a[i] ^ p[i] mod m[i] for every i, spread over the available
+     * processors. Returns each item's NativeBN.BATCH_ status.
+     */
+    static int[] modExpBatch(BigInt[] r, BigInt[] a, BigInt[] p, BigInt[] m) {
+        for (int i = 0; i < r.length; ++i) {
+            r[i] = newBigInt();
+        }
+        return NativeBN.BN_mod_exp_batch(handles(r), handles(a), handles(p), handles(m),
+                batchThreadCount(r.length));
+    }
+
+    /**
+     * Sets results[i] to whether a[i] is probably prime, spread over the available
+     * processors. Returns each item's NativeBN.BATCH_ status.
+     */
+    static int[] isPrimeBatch(BigInt[] a, int certainty, boolean[] results) {
+        return NativeBN.BN_is_prime_ex_batch(handles(a), certainty, results,
+                batchThreadCount(a.length));
+    }
+
+    /**
+     * Fills r with new primes of exactly bitLength bits, spread over the available
+     * processors. Returns each item's NativeBN.BATCH_ status.
+     */
+    static int[] generatePrimeDefaultBatch(BigInt[] r, int bitLength) {
+        for (int i = 0; i < r.length; ++i) {
+            r[i] = newBigInt();
+        }
+        return NativeBN.BN_generate_prime_ex_batch(handles(r), bitLength, false,
+                batchThreadCount(r.length));
+    }
 }
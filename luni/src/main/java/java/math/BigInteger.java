@@ -21,6 +21,7 @@ import java.io.IOException;
 import java.io.ObjectInputStream;
 import java.io.ObjectOutputStream;
 import java.io.Serializable;
+import java.util.Arrays;
 import java.util.Random;
 
 /**
@@ -382,6 +383,38 @@ public class BigInteger extends Number
         return twosComplement();
     }
 
+    /**
+     * Copies the big-endian magnitude of this {@code BigInteger} into {@code dst}
+     * starting at {@code offset}, if it fits. Returns the number of bytes in the
+     * magnitude either way, so a caller can reuse one array and only grow it
+     * when the result is larger than the room left. Zero has no bytes.
+     *
+     * @throws ArrayIndexOutOfBoundsException if {@code offset} is out of bounds.
+     * @hide
+     */
+    public int getMagnitude(byte[] dst, int offset) {
+        if (dst == null) {
+            throw new NullPointerException("dst == null");
+        }
+        return getBigInt().bigEndianMagnitude(dst, offset);
+    }
+
+    /**
+     * Copies the magnitude of this {@code BigInteger} into {@code dst} starting at
+     * {@code offset} as little-endian 32-bit words, if it fits. Returns the number
+     * of ints in the magnitude either way, as {@link #getMagnitude(byte[], int)}
+     * does. Zero has no ints.
+     *
+     * @throws ArrayIndexOutOfBoundsException if {@code offset} is out of bounds.
+     * @hide
+     */
+    public int getMagnitude(int[] dst, int offset) {
+        if (dst == null) {
+            throw new NullPointerException("dst == null");
+        }
+        return getBigInt().littleEndianIntsMagnitude(dst, offset);
+    }
+
     /**
      * Returns a {@code BigInteger} whose value is the absolute value of {@code
      * this}.
@@ -997,6 +1030,64 @@ public class BigInteger extends Number
         return new BigInteger(BigInt.modExp(base.getBigInt(), exponent.getBigInt(), modulus.getBigInt()));
     }
 
+    /**
+     * Returns {@code bases[i].modPow(exponents[i], moduli[i])} for every {@code i},
+     * computing the items in parallel. An item for which {@code modPow} would throw
+     * {@code ArithmeticException} is null instead.
+     *
+     * @throws NullPointerException if any array or element is null.
+     * @throws IllegalArgumentException if the arrays' lengths differ.
+     * @hide
+     */
+    public static BigInteger[] modPow(BigInteger[] bases, BigInteger[] exponents,
+            BigInteger[] moduli) {
+        int count = bases.length;
+        if (exponents.length != count || moduli.length != count) {
+            throw new IllegalArgumentException("bases.length=" + count
+                    + "; exponents.length=" + exponents.length
+                    + "; moduli.length=" + moduli.length);
+        }
+        BigInteger[] results = new BigInteger[count];
+        int[] indexes = new int[count];
+        BigInt[] a = new BigInt[count];
+        BigInt[] p = new BigInt[count];
+        BigInt[] m = new BigInt[count];
+        int n = 0;
+        for (int i = 0; i < count; ++i) {
+            BigInteger modulus = moduli[i];
+            if (modulus.signum() <= 0) {
+                continue;
+            }
+            int exponentSignum = exponents[i].signum();
+            if (exponentSignum == 0) { // OpenSSL gets this case wrong; http://b/8574367.
+                results[i] = ONE.mod(modulus);
+                continue;
+            }
+            BigInteger base = bases[i];
+            if (exponentSignum < 0) {
+                try {
+                    base = base.modInverse(modulus);
+                } catch (ArithmeticException notInvertible) {
+                    continue;
+                }
+            }
+            indexes[n] = i;
+            a[n] = base.getBigInt();
+            p[n] = exponents[i].getBigInt();
+            m[n] = modulus.getBigInt();
+            ++n;
+        }
+        BigInt[] r = new BigInt[n];
+        int[] status = BigInt.modExpBatch(r, Arrays.copyOf(a, n), Arrays.copyOf(p, n),
+                Arrays.copyOf(m, n));
+        for (int j = 0; j < n; ++j) {
+            if (status[j] == NativeBN.BATCH_OK) {
+                results[indexes[j]] = new BigInteger(r[j]);
+            }
+        }
+        return results;
+    }
+
     /**
      * Returns a {@code BigInteger} whose value is {@code this mod m}. The
      * modulus {@code m} must be positive. The result is guaranteed to be in the
@@ -1016,6 +1107,22 @@ public class BigInteger extends Number
         return new BigInteger(BigInt.modulus(getBigInt(), m.getBigInt()));
     }
 
+    /**
+     * Returns {@code (this * multiplicand + addend) mod m}, computed without
+     * creating the intermediate {@code BigInteger}s.
+     *
+     * @throws NullPointerException if any argument is null.
+     * @throws ArithmeticException if {@code m <= 0}.
+     * @hide
+     */
+    public BigInteger multiplyAddMod(BigInteger multiplicand, BigInteger addend, BigInteger m) {
+        if (m.signum() <= 0) {
+            throw new ArithmeticException("m.signum() <= 0");
+        }
+        return new BigInteger(BigInt.multiplyAddMod(getBigInt(), multiplicand.getBigInt(),
+                addend.getBigInt(), m.getBigInt()));
+    }
+
     /**
      * Tests whether this {@code BigInteger} is probably prime. If {@code true}
      * is returned, then this is prime with a probability greater than
@@ -1034,6 +1141,27 @@ public class BigInteger extends Number
         return getBigInt().isPrime(certainty);
     }
 
+    /**
+     * Returns {@code values[i].isProbablePrime(certainty)} for every {@code i},
+     * testing the values in parallel.
+     *
+     * @throws NullPointerException if {@code values} or any element is null.
+     * @hide
+     */
+    public static boolean[] isProbablePrime(BigInteger[] values, int certainty) {
+        boolean[] results = new boolean[values.length];
+        if (certainty <= 0) {
+            Arrays.fill(results, true);
+            return results;
+        }
+        BigInt[] a = new BigInt[values.length];
+        for (int i = 0; i < values.length; ++i) {
+            a[i] = values[i].getBigInt();
+        }
+        checkBatchStatus(BigInt.isPrimeBatch(a, certainty, results));
+        return results;
+    }
+
     /**
      * Returns the smallest integer x > {@code this} which is probably prime as
      * a {@code BigInteger} instance. The probability that the returned {@code
@@ -1062,8 +1190,51 @@ public class BigInteger extends Number
         return new BigInteger(bitLength, 100, random);
     }
 
+    /**
+     * Returns {@code count} new probable primes of exactly {@code bitLength} bits,
+     * generated in parallel. The probability that each is composite doesn't exceed
+     * 2<sup>-100</sup>, as for {@link #probablePrime}.
+     *
+     * @throws ArithmeticException if {@code bitLength < 2}.
+     * @throws IllegalArgumentException if {@code count < 0}.
+     * @hide
+     */
+    public static BigInteger[] probablePrimes(int bitLength, int count) {
+        if (bitLength < 2) {
+            throw new ArithmeticException("bitLength < 2: " + bitLength);
+        }
+        if (count < 0) {
+            throw new IllegalArgumentException("count < 0: " + count);
+        }
+        BigInteger[] results = new BigInteger[count];
+        if (bitLength < 16) {
+            // OpenSSL bottoms out at 16 bits, and short primes are cheap anyway.
+            Random random = new Random();
+            for (int i = 0; i < count; ++i) {
+                results[i] = new BigInteger(bitLength, 100, random);
+            }
+            return results;
+        }
+        BigInt[] primes = new BigInt[count];
+        checkBatchStatus(BigInt.generatePrimeDefaultBatch(primes, bitLength));
+        for (int i = 0; i < count; ++i) {
+            results[i] = new BigInteger(primes[i]);
+        }
+        return results;
+    }
+
     /* Private Methods */
 
+    private static void checkBatchStatus(int[] status) {
+        for (int s : status) {
+            if (s == NativeBN.BATCH_OUT_OF_MEMORY) {
+                throw new OutOfMemoryError();
+            } else if (s != NativeBN.BATCH_OK) {
+                throw new ArithmeticException("batch operation failed: " + s);
+            }
+        }
+    }
+
     /**
      * Returns the two's complement representation of this BigInteger in a byte
      * array.
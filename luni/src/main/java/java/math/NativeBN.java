@@ -64,6 +64,11 @@ final class NativeBN {
 
     public static native int[] bn2litEndInts(long a);
 
+    public static native int BN_bn2binInto(long a, byte[] dst, int offset);
+    public static native int bn2litEndIntsInto(long a, int[] dst, int offset);
+    // Like BN_bn2bin and bn2litEndInts, but copy into dst at offset if the magnitude fits.
+    // Return the length of the magnitude either way, so the caller can retry with a larger array.
+
     public static native int sign(long a);
     // Returns -1, 0, 1 AND NOT boolean.
     // #define BN_is_negative(a) ((a)->neg != 0)
@@ -119,6 +124,22 @@ final class NativeBN {
     // BIGNUM * BN_mod_inverse(BIGNUM *ret, const BIGNUM *a, const BIGNUM *n, BN_CTX *ctx);
 
 
+    // Opcodes for runOps. Each op is five ints: the opcode, then the register
+    // indexes of r, a, b and m. Operands an op doesn't use are ignored.
+    static final int OP_ADD = 0;     // r = a + b
+    static final int OP_SUB = 1;     // r = a - b
+    static final int OP_MUL = 2;     // r = a * b
+    static final int OP_NNMOD = 3;   // r = a mod m
+    static final int OP_MOD_ADD = 4; // r = (a + b) mod m
+    static final int OP_MOD_SUB = 5; // r = (a - b) mod m
+    static final int OP_MOD_MUL = 6; // r = (a * b) mod m
+    static final int OP_MOD_EXP = 7; // r = a ^ b mod m
+    static final int OPS_PER_OP = 5;
+
+    public static native void runOps(int[] ops, int opCount, long[] registers);
+    // Runs the first opCount ops in ops on the BIGNUMs in registers, stopping at the first
+    // that fails. Registers may be reused as both source and destination.
+
     public static native void BN_generate_prime_ex(long ret, int bits, boolean safe,
                                                    long add, long rem, long cb);
     // int BN_generate_prime_ex(BIGNUM *ret, int bits, int safe,
@@ -127,4 +148,26 @@ final class NativeBN {
     public static native boolean BN_is_prime_ex(long p, int nchecks, long cb);
     // int BN_is_prime_ex(const BIGNUM *p, int nchecks, BN_CTX *ctx, BN_GENCB *cb);
 
+    // Per-item status codes returned by the batch operations.
+    static final int BATCH_OK = 0;
+    static final int BATCH_DIV_BY_ZERO = 1;
+    static final int BATCH_NO_INVERSE = 2;
+    static final int BATCH_OUT_OF_MEMORY = 3;
+    static final int BATCH_FAILED = 4;
+
+    // The batch operations run each item of their arrays on up to threadCount
+    // threads, the calling thread included, and return each item's status.
+
+    public static native int[] BN_mod_exp_batch(long[] r, long[] a, long[] p, long[] m,
+                                                int threadCount);
+    // r[i] = a[i] ^ p[i] mod m[i]
+
+    public static native int[] BN_is_prime_ex_batch(long[] p, int nchecks, boolean[] results,
+                                                    int threadCount);
+    // results[i] = BN_is_prime_ex(p[i], nchecks)
+
+    public static native int[] BN_generate_prime_ex_batch(long[] ret, int bits, boolean safe,
+                                                          int threadCount);
+    // Each ret[i] is a new prime of exactly 'bits' bits.
+
 }
@@ -36,6 +36,10 @@ final class IoVec {
     private final int[] offsets;
     private final int[] byteCounts;
 
+    // Non-null if every buffer is direct, in which case we pass native addresses instead of
+    // having each buffer pinned separately.
+    private long[] addresses;
+
     private final Direction direction;
 
     IoVec(ByteBuffer[] byteBuffers, int offset, int bufferCount, Direction direction) {
@@ -50,6 +54,7 @@ final class IoVec {
 
     int init() {
         int totalRemaining = 0;
+        boolean allDirect = true;
         for (int i = 0; i < bufferCount; ++i) {
             ByteBuffer b = byteBuffers[i + offset];
             if (direction == Direction.READV) {
@@ -62,23 +67,34 @@ final class IoVec {
             } else {
                 ioBuffers[i] = NioUtils.unsafeArray(b);
                 offsets[i] = NioUtils.unsafeArrayOffset(b) + b.position();
+                allDirect = false;
             }
             byteCounts[i] = remaining;
             totalRemaining += remaining;
         }
+        if (allDirect) {
+            addresses = new long[bufferCount];
+            for (int i = 0; i < bufferCount; ++i) {
+                addresses[i] = byteBuffers[i + offset].effectiveDirectAddress + offsets[i];
+            }
+        }
         return totalRemaining;
     }
 
     int doTransfer(FileDescriptor fd) throws IOException {
         try {
             if (direction == Direction.READV) {
-                int result = Libcore.os.readv(fd, ioBuffers, offsets, byteCounts);
+                int result = (addresses != null)
+                        ? Libcore.os.readv(fd, addresses, byteCounts)
+                        : Libcore.os.readv(fd, ioBuffers, offsets, byteCounts);
                 if (result == 0) {
                     result = -1;
                 }
                 return result;
             } else {
-                return Libcore.os.writev(fd, ioBuffers, offsets, byteCounts);
+                return (addresses != null)
+                        ? Libcore.os.writev(fd, addresses, byteCounts)
+                        : Libcore.os.writev(fd, ioBuffers, offsets, byteCounts);
             }
         } catch (ErrnoException errnoException) {
             throw errnoException.rethrowAsIOException();
@@ -62,4 +62,20 @@ public final class NioUtils {
     public static int unsafeArrayOffset(ByteBuffer b) {
         return ((ByteArrayBuffer) b).arrayOffset;
     }
+
+    /**
+     * Exposes the native address of the start of a direct ByteBuffer's content (ignoring its
+     * position), so callers can skip JNI's GetDirectBufferAddress. Returns 0 for a heap buffer.
+     */
+    public static long unsafeAddress(ByteBuffer b) {
+        return b.effectiveDirectAddress;
+    }
+
+    /**
+     * Like {@link #unsafeAddress(ByteBuffer)}, for any kind of buffer, including views of direct
+     * ByteBuffers.
+     */
+    public static long unsafeAddress(Buffer b) {
+        return b.effectiveDirectAddress;
+    }
 }
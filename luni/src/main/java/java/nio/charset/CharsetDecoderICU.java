@@ -16,6 +16,7 @@ package java.nio.charset;
 
 import java.nio.ByteBuffer;
 import java.nio.CharBuffer;
+import java.nio.NioUtils;
 import libcore.icu.ICU;
 import libcore.icu.NativeConverter;
 import libcore.util.EmptyArray;
@@ -39,6 +40,9 @@ final class CharsetDecoderICU extends CharsetDecoder {
     private byte[] input = null;
     private char[] output= null;
 
+    /* the native address of a direct input buffer, used instead of input */
+    private long inputAddress = 0;
+
     private byte[] allocatedInput = null;
     private char[] allocatedOutput = null;
 
@@ -93,6 +97,7 @@ final class CharsetDecoderICU extends CharsetDecoder {
         data[INVALID_BYTES] = 0;
         output = null;
         input = null;
+        inputAddress = 0;
         allocatedInput = null;
         allocatedOutput = null;
         inEnd = 0;
@@ -109,7 +114,7 @@ final class CharsetDecoderICU extends CharsetDecoder {
             data[OUTPUT_OFFSET] = getArray(out);
             data[INVALID_BYTES] = 0; // Make sure we don't see earlier errors.
 
-            int error = NativeConverter.decode(converterHandle, input, inEnd, output, outEnd, data, true);
+            int error = decode(true);
             if (ICU.U_FAILURE(error)) {
                 if (error == ICU.U_BUFFER_OVERFLOW_ERROR) {
                     return CoderResult.OVERFLOW;
@@ -135,7 +140,7 @@ final class CharsetDecoderICU extends CharsetDecoder {
         data[OUTPUT_OFFSET]= getArray(out);
 
         try {
-            int error = NativeConverter.decode(converterHandle, input, inEnd, output, outEnd, data, false);
+            int error = decode(false);
             if (ICU.U_FAILURE(error)) {
                 if (error == ICU.U_BUFFER_OVERFLOW_ERROR) {
                     return CoderResult.OVERFLOW;
@@ -155,6 +160,13 @@ final class CharsetDecoderICU extends CharsetDecoder {
         }
     }
 
+    private int decode(boolean flush) {
+        if (inputAddress != 0) {
+            return NativeConverter.decodeAddress(converterHandle, inputAddress, inEnd, output, outEnd, data, flush);
+        }
+        return NativeConverter.decode(converterHandle, input, inEnd, output, outEnd, data, flush);
+    }
+
     @Override protected void finalize() throws Throwable {
         try {
             NativeConverter.closeConverter(converterHandle);
@@ -185,6 +197,11 @@ final class CharsetDecoderICU extends CharsetDecoder {
             input = in.array();
             inEnd = in.arrayOffset() + in.limit();
             return in.arrayOffset() + in.position();
+        } else if (in.isDirect() && NioUtils.unsafeAddress(in) != 0) {
+            // Decode straight from native memory.
+            inputAddress = NioUtils.unsafeAddress(in);
+            inEnd = in.limit();
+            return in.position();
         } else {
             inEnd = in.remaining();
             if (allocatedInput == null || inEnd > allocatedInput.length) {
@@ -214,5 +231,6 @@ final class CharsetDecoderICU extends CharsetDecoder {
         in.position(in.position() + data[INPUT_OFFSET]);
         // release reference to input array, which may not be ours
         input = null;
+        inputAddress = 0;
     }
 }
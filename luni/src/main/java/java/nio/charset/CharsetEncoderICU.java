@@ -16,6 +16,7 @@ package java.nio.charset;
 
 import java.nio.ByteBuffer;
 import java.nio.CharBuffer;
+import java.nio.NioUtils;
 import java.util.HashMap;
 import java.util.Map;
 import libcore.icu.ICU;
@@ -54,6 +55,9 @@ final class CharsetEncoderICU extends CharsetEncoder {
     private char[] input = null;
     private byte[] output = null;
 
+    /* the native address of a direct output buffer, used instead of output */
+    private long outputAddress = 0;
+
     private char[] allocatedInput = null;
     private byte[] allocatedOutput = null;
 
@@ -120,6 +124,7 @@ final class CharsetEncoderICU extends CharsetEncoder {
         data[OUTPUT_OFFSET] = 0;
         data[INVALID_CHARS] = 0;
         output = null;
+        outputAddress = 0;
         input = null;
         allocatedInput = null;
         allocatedOutput = null;
@@ -137,7 +142,7 @@ final class CharsetEncoderICU extends CharsetEncoder {
             data[OUTPUT_OFFSET] = getArray(out);
             data[INVALID_CHARS] = 0; // Make sure we don't see earlier errors.
 
-            int error = NativeConverter.encode(converterHandle, input, inEnd, output, outEnd, data, true);
+            int error = encode(true);
             if (ICU.U_FAILURE(error)) {
                 if (error == ICU.U_BUFFER_OVERFLOW_ERROR) {
                     return CoderResult.OVERFLOW;
@@ -164,7 +169,7 @@ final class CharsetEncoderICU extends CharsetEncoder {
         data[INVALID_CHARS] = 0; // Make sure we don't see earlier errors.
 
         try {
-            int error = NativeConverter.encode(converterHandle, input, inEnd, output, outEnd, data, false);
+            int error = encode(false);
             if (ICU.U_FAILURE(error)) {
                 if (error == ICU.U_BUFFER_OVERFLOW_ERROR) {
                     return CoderResult.OVERFLOW;
@@ -184,6 +189,13 @@ final class CharsetEncoderICU extends CharsetEncoder {
         }
     }
 
+    private int encode(boolean flush) {
+        if (outputAddress != 0) {
+            return NativeConverter.encodeAddress(converterHandle, input, inEnd, outputAddress, outEnd, data, flush);
+        }
+        return NativeConverter.encode(converterHandle, input, inEnd, output, outEnd, data, flush);
+    }
+
     @Override protected void finalize() throws Throwable {
         try {
             NativeConverter.closeConverter(converterHandle);
@@ -198,6 +210,11 @@ final class CharsetEncoderICU extends CharsetEncoder {
             output = out.array();
             outEnd = out.arrayOffset() + out.limit();
             return out.arrayOffset() + out.position();
+        } else if (out.isDirect() && !out.isReadOnly() && NioUtils.unsafeAddress(out) != 0) {
+            // Encode straight into native memory.
+            outputAddress = NioUtils.unsafeAddress(out);
+            outEnd = out.limit();
+            return out.position();
         } else {
             outEnd = out.remaining();
             if (allocatedOutput == null || outEnd > allocatedOutput.length) {
@@ -232,11 +249,14 @@ final class CharsetEncoderICU extends CharsetEncoder {
     private void setPosition(ByteBuffer out) {
         if (out.hasArray()) {
             out.position(out.position() + data[OUTPUT_OFFSET] - out.arrayOffset());
+        } else if (outputAddress != 0) {
+            out.position(out.position() + data[OUTPUT_OFFSET]);
         } else {
             out.put(output, 0, data[OUTPUT_OFFSET]);
         }
         // release reference to output array, which may not be ours
         output = null;
+        outputAddress = 0;
     }
 
     private void setPosition(CharBuffer in) {
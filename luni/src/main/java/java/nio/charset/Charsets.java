@@ -16,6 +16,12 @@
 
 package java.nio.charset;
 
+import java.nio.BufferOverflowException;
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
+import java.nio.ReadOnlyBufferException;
+import java.util.Arrays;
+
 /**
  * Various special-case charset conversions (for performance).
  *
@@ -40,6 +46,63 @@ public final class Charsets {
      */
     public static native byte[] toUtf8Bytes(char[] chars, int offset, int length);
 
+    /**
+     * Returns the number of bytes {@link #toUtf8Bytes} would return for the given characters.
+     */
+    public static int utf8Length(char[] chars, int offset, int length) {
+        Arrays.checkOffsetAndCount(chars.length, offset, length);
+        return utf8LengthImpl(chars, offset, length);
+    }
+
+    private static native int utf8LengthImpl(char[] chars, int offset, int length);
+
+    /**
+     * Encodes the given characters as UTF-8 into {@code dst} starting at {@code dstOffset},
+     * returning the number of bytes written. Throws ArrayIndexOutOfBoundsException if they
+     * don't fit; use {@link #utf8Length} to size {@code dst}.
+     */
+    public static int encodeUtf8(char[] chars, int offset, int length, byte[] dst, int dstOffset) {
+        Arrays.checkOffsetAndCount(chars.length, offset, length);
+        Arrays.checkOffsetAndCount(dst.length, dstOffset, 0);
+        int byteCount = encodeUtf8Bytes(chars, offset, length, dst, dstOffset, dst.length - dstOffset);
+        if (byteCount == -1) {
+            throw new ArrayIndexOutOfBoundsException("need " + utf8Length(chars, offset, length) +
+                    " bytes at offset " + dstOffset + "; dst.length=" + dst.length);
+        }
+        return byteCount;
+    }
+
+    /**
+     * Encodes the given characters as UTF-8 into the remaining space of {@code dst}, advancing
+     * its position and returning the number of bytes written. Direct buffers are written
+     * through their native address. Throws BufferOverflowException, leaving {@code dst}
+     * unchanged, if the bytes don't fit.
+     */
+    public static int encodeUtf8(char[] chars, int offset, int length, ByteBuffer dst) {
+        Arrays.checkOffsetAndCount(chars.length, offset, length);
+        if (dst.isReadOnly()) {
+            throw new ReadOnlyBufferException();
+        }
+        int position = dst.position();
+        int byteCount;
+        if (dst.isDirect()) {
+            long address = NioUtils.unsafeAddress(dst) + position;
+            byteCount = encodeUtf8Address(chars, offset, length, address, dst.remaining());
+        } else {
+            byte[] array = NioUtils.unsafeArray(dst);
+            int arrayOffset = NioUtils.unsafeArrayOffset(dst) + position;
+            byteCount = encodeUtf8Bytes(chars, offset, length, array, arrayOffset, dst.remaining());
+        }
+        if (byteCount == -1) {
+            throw new BufferOverflowException();
+        }
+        dst.position(position + byteCount);
+        return byteCount;
+    }
+
+    private static native int encodeUtf8Bytes(char[] chars, int offset, int length, byte[] dst, int dstOffset, int capacity);
+    private static native int encodeUtf8Address(char[] chars, int offset, int length, long address, int capacity);
+
     /**
      * Returns a new byte array containing the bytes corresponding to the given characters,
      * encoded in UTF-16BE. All characters are representable in UTF-16BE.
@@ -75,6 +138,30 @@ public final class Charsets {
      */
     public static native void isoLatin1BytesToChars(byte[] bytes, int offset, int length, char[] chars);
 
+    /**
+     * Decodes the given UTF-8 bytes into {@code chars}, starting at index 0, and returns the
+     * number of chars written. {@code chars} must have room for {@code length} chars, which is
+     * always enough.
+     *
+     * <p>Unlike the lenient decoder in {@code String}, this one validates its input strictly:
+     * overlong forms, encoded surrogates and values above U+10FFFF are malformed. Each maximal
+     * malformed subsequence is replaced by U+FFFD. If {@code firstMalformed} is non-null, its
+     * first element is set to the index (relative to {@code offset}) of the first malformed
+     * byte, or -1 if the input was well-formed.
+     */
+    public static int utf8BytesToChars(byte[] bytes, int offset, int length, char[] chars, int[] firstMalformed) {
+        Arrays.checkOffsetAndCount(bytes.length, offset, length);
+        if (chars.length < length) {
+            throw new ArrayIndexOutOfBoundsException("chars.length=" + chars.length + " < length=" + length);
+        }
+        if (firstMalformed != null && firstMalformed.length == 0) {
+            throw new ArrayIndexOutOfBoundsException("firstMalformed.length == 0");
+        }
+        return utf8BytesToCharsImpl(bytes, offset, length, chars, firstMalformed);
+    }
+
+    private static native int utf8BytesToCharsImpl(byte[] bytes, int offset, int length, char[] chars, int[] firstMalformed);
+
     private Charsets() {
     }
 }
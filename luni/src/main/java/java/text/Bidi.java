@@ -58,33 +58,6 @@ public final class Bidi {
      */
     public static final int DIRECTION_RIGHT_TO_LEFT = 1;
 
-    /**
-     * TODO: if we care about performance, we might just want to use an int[] instead of a Run[].
-     */
-    static class Run {
-        private final int start;
-        private final int limit;
-        private final int level;
-
-        public Run(int start, int limit, int level) {
-            this.start = start;
-            this.limit = limit;
-            this.level = level;
-        }
-
-        public int getLevel() {
-            return level;
-        }
-
-        public int getLimit() {
-            return limit;
-        }
-
-        public int getStart() {
-            return start;
-        }
-    }
-
     /**
      * Creates a {@code Bidi} object from the {@code
      * AttributedCharacterIterator} of a paragraph text. The RUN_DIRECTION
@@ -281,7 +254,11 @@ public final class Bidi {
             if (paragraphLength > 0) {
                 Bidi temp = new Bidi(text, textStart, null, 0, paragraphLength, flags);
                 realEmbeddings = new byte[paragraphLength];
-                System.arraycopy(temp.offsetLevel, 0, realEmbeddings, 0, paragraphLength);
+                if (temp.offsetLevel != null) {
+                    System.arraycopy(temp.offsetLevel, 0, realEmbeddings, 0, paragraphLength);
+                } else {
+                    Arrays.fill(realEmbeddings, (byte) temp.baseLevel);
+                }
                 for (int i = 0; i < paragraphLength; i++) {
                     byte e = embeddings[i];
                     if (e < 0) {
@@ -322,25 +299,14 @@ public final class Bidi {
     private void readBidiInfo(long pBidi) {
         length = ubidi_getLength(pBidi);
 
+        // Null if every char is at the base level.
         offsetLevel = (length == 0) ? null : ubidi_getLevels(pBidi);
 
         baseLevel = ubidi_getParaLevel(pBidi);
 
-        int runCount = ubidi_countRuns(pBidi);
-        if (runCount == 0) {
-            unidirectional = true;
-            runs = null;
-        } else if (runCount < 0) {
-            runs = null;
-        } else {
-            runs = ubidi_getRuns(pBidi);
-
-            // Simplified case for one run which has the base level
-            if (runCount == 1 && runs[0].getLevel() == baseLevel) {
-                unidirectional = true;
-                runs = null;
-            }
-        }
+        // Null for no text, or one run which has the base level.
+        runs = ubidi_getRuns(pBidi);
+        unidirectional = (runs == null);
 
         direction = ubidi_getDirection(pBidi);
     }
@@ -351,7 +317,8 @@ public final class Bidi {
 
     private byte[] offsetLevel;
 
-    private Run[] runs;
+    // The runs' start, limit and level, three ints per run.
+    private int[] runs;
 
     private int direction;
 
@@ -391,7 +358,7 @@ public final class Bidi {
         Arrays.fill(text, 'a');
         byte[] embeddings = new byte[this.length];
         for (int i = 0; i < embeddings.length; i++) {
-            embeddings[i] = (byte) -this.offsetLevel[i];
+            embeddings[i] = (byte) -getLevelAt(i);
         }
 
         int dir = this.baseIsLeftToRight()
@@ -445,11 +412,10 @@ public final class Bidi {
      * @return the level.
      */
     public int getLevelAt(int offset) {
-        try {
-            return offsetLevel[offset] & ~UBIDI_LEVEL_OVERRIDE;
-        } catch (RuntimeException e) {
+        if (offsetLevel == null || offset < 0 || offset >= offsetLevel.length) {
             return baseLevel;
         }
+        return offsetLevel[offset] & ~UBIDI_LEVEL_OVERRIDE;
     }
 
     /**
@@ -458,7 +424,7 @@ public final class Bidi {
      * @return the number of runs, at least 1.
      */
     public int getRunCount() {
-        return unidirectional ? 1 : runs.length;
+        return unidirectional ? 1 : runs.length / 3;
     }
 
     /**
@@ -469,7 +435,7 @@ public final class Bidi {
      * @return the level of the run.
      */
     public int getRunLevel(int run) {
-        return unidirectional ? baseLevel : runs[run].getLevel();
+        return unidirectional ? baseLevel : runs[3 * run + 2];
     }
 
     /**
@@ -480,7 +446,7 @@ public final class Bidi {
      * @return the limit offset of the run.
      */
     public int getRunLimit(int run) {
-        return unidirectional ? length : runs[run].getLimit();
+        return unidirectional ? length : runs[3 * run + 1];
     }
 
     /**
@@ -491,7 +457,7 @@ public final class Bidi {
      * @return the start offset of the run.
      */
     public int getRunStart(int run) {
-        return unidirectional ? 0 : runs[run].getStart();
+        return unidirectional ? 0 : runs[3 * run];
     }
 
     /**
@@ -619,7 +585,6 @@ public final class Bidi {
     private static native int ubidi_getLength(final long pBiDi);
     private static native byte ubidi_getParaLevel(final long pBiDi);
     private static native byte[] ubidi_getLevels(long pBiDi);
-    private static native int ubidi_countRuns(long pBiDi);
-    private static native Bidi.Run[] ubidi_getRuns(long pBidi);
+    private static native int[] ubidi_getRuns(long pBidi);
     private static native int[] ubidi_reorderVisual(byte[] levels, int length);
 }
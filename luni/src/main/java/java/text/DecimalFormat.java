@@ -674,14 +674,14 @@ public class DecimalFormat extends NumberFormat {
                 setRoundingMode(RoundingMode.UNNECESSARY);
             }
         }
-        buffer.append(ndf.formatDouble(value, position));
+        ndf.formatDouble(value, position, buffer);
         return buffer;
     }
 
     @Override
     public StringBuffer format(long value, StringBuffer buffer, FieldPosition position) {
         checkBufferAndFieldPosition(buffer, position);
-        buffer.append(ndf.formatLong(value, position));
+        ndf.formatLong(value, position, buffer);
         return buffer;
     }
 
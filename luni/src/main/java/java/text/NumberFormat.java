@@ -208,7 +208,8 @@ public abstract class NumberFormat extends Format {
      * @return the formatted string.
      */
     public final String format(double value) {
-        return format(value, new StringBuffer(), new FieldPosition(0))
+        // Nobody sees the field position, so don't ask for one.
+        return format(value, new StringBuffer(), new FieldPosition(-1))
                 .toString();
     }
 
@@ -241,7 +242,8 @@ public abstract class NumberFormat extends Format {
      * @return the formatted string.
      */
     public final String format(long value) {
-        return format(value, new StringBuffer(), new FieldPosition(0))
+        // Nobody sees the field position, so don't ask for one.
+        return format(value, new StringBuffer(), new FieldPosition(-1))
                 .toString();
     }
 
@@ -405,6 +405,16 @@ public class RuleBasedCollator extends Collator {
         return icuColl.getCollationKey(source);
     }
 
+    /**
+     * Returns the collation keys of all of {@code sources}, much more cheaply than calling
+     * {@link #getCollationKey} for each. A null source has a null key.
+     *
+     * @hide
+     */
+    public CollationKey[] getCollationKeys(String[] sources) {
+        return icuColl.getCollationKeys(sources);
+    }
+
     @Override
     public int hashCode() {
         return icuColl.getRules().hashCode();
@@ -202,10 +202,19 @@ public final class Matcher implements MatchResult {
             throw new IndexOutOfBoundsException();
         }
 
-        this.input = input.toString();
+        String newInput = input.toString();
+        boolean sameInput = (newInput == this.input);
+        this.input = newInput;
         this.regionStart = start;
         this.regionEnd = end;
-        resetForInput();
+        if (sameInput) {
+            // The native matcher already has a copy of this input; just reset it.
+            synchronized (this) {
+                setRegionImpl(address, regionStart, regionEnd);
+            }
+        } else {
+            resetForInput();
+        }
 
         matchFound = false;
         appendPos = 0;
@@ -387,7 +396,7 @@ public final class Matcher implements MatchResult {
         }
 
         synchronized (this) {
-            matchFound = findImpl(address, input, start, matchOffsets);
+            matchFound = findImpl(address, start, matchOffsets);
         }
         return matchFound;
     }
@@ -402,11 +411,26 @@ public final class Matcher implements MatchResult {
      */
     public boolean find() {
         synchronized (this) {
-            matchFound = findNextImpl(address, input, matchOffsets);
+            matchFound = findNextImpl(address, matchOffsets);
         }
         return matchFound;
     }
 
+    /**
+     * Resets this matcher and returns the start and end of the next {@code maxCount}
+     * occurrences of the {@link Pattern} in the region, as pairs of offsets in a single
+     * array. A negative {@code maxCount} returns all occurrences. This is equivalent to,
+     * but much cheaper than, calling {@link #find()} in a loop. Afterwards there's no
+     * current match, and a following {@code find()} continues after the last returned
+     * occurrence.
+     */
+    int[] findAll(int maxCount) {
+        reset();
+        synchronized (this) {
+            return findAllImpl(address, maxCount);
+        }
+    }
+
     /**
      * Tries to match the {@link Pattern}, starting from the beginning of the
      * region (or the beginning of the input, if no region has been set).
@@ -416,7 +440,7 @@ public final class Matcher implements MatchResult {
      */
     public boolean lookingAt() {
         synchronized (this) {
-            matchFound = lookingAtImpl(address, input, matchOffsets);
+            matchFound = lookingAtImpl(address, matchOffsets);
         }
         return matchFound;
     }
@@ -430,7 +454,7 @@ public final class Matcher implements MatchResult {
      */
     public boolean matches() {
         synchronized (this) {
-            matchFound = matchesImpl(address, input, matchOffsets);
+            matchFound = matchesImpl(address, matchOffsets);
         }
         return matchFound;
     }
@@ -667,15 +691,17 @@ public final class Matcher implements MatchResult {
     }
 
     private static native void closeImpl(long addr);
-    private static native boolean findImpl(long addr, String s, int startIndex, int[] offsets);
-    private static native boolean findNextImpl(long addr, String s, int[] offsets);
+    private static native int[] findAllImpl(long addr, int maxCount);
+    private static native boolean findImpl(long addr, int startIndex, int[] offsets);
+    private static native boolean findNextImpl(long addr, int[] offsets);
     private static native int groupCountImpl(long addr);
     private static native boolean hitEndImpl(long addr);
-    private static native boolean lookingAtImpl(long addr, String s, int[] offsets);
-    private static native boolean matchesImpl(long addr, String s, int[] offsets);
+    private static native boolean lookingAtImpl(long addr, int[] offsets);
+    private static native boolean matchesImpl(long addr, int[] offsets);
     private static native long openImpl(long patternAddr);
     private static native boolean requireEndImpl(long addr);
     private static native void setInputImpl(long addr, String s, int start, int end);
+    private static native void setRegionImpl(long addr, int start, int end);
     private static native void useAnchoringBoundsImpl(long addr, boolean value);
     private static native void useTransparentBoundsImpl(long addr, boolean value);
 }
@@ -456,6 +456,17 @@ public final class Pattern implements Serializable {
         compile();
     }
 
+    /**
+     * Returns counters for the native cache of compiled patterns shared by all
+     * {@code Pattern}s: hits, misses, evictions and the number of cached patterns.
+     *
+     * @hide
+     */
+    public static long[] getCacheCounters() {
+        return getCacheCountersImpl();
+    }
+
     private static native void closeImpl(long addr);
     private static native long compileImpl(String regex, int flags);
+    private static native long[] getCacheCountersImpl();
 }
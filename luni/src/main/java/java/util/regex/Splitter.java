@@ -116,10 +116,11 @@ public class Splitter {
         // Collect text preceding each occurrence of the separator, while there's enough space.
         ArrayList<String> list = new ArrayList<String>();
         Matcher matcher = new Matcher(pattern, input);
+        int[] offsets = matcher.findAll(limit > 0 ? limit - 1 : -1);
         int begin = 0;
-        while (list.size() + 1 != limit && matcher.find()) {
-            list.add(input.substring(begin, matcher.start()));
-            begin = matcher.end();
+        for (int i = 0; i < offsets.length; i += 2) {
+            list.add(input.substring(begin, offsets[i]));
+            begin = offsets[i + 1];
         }
         return finishSplit(list, input, begin, limit);
     }
@@ -17,7 +17,10 @@
 
 package java.util.zip;
 
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
 import java.util.Arrays;
+import libcore.util.LazyNatives;
 
 /**
  * The Adler-32 class is used to compute the {@code Adler32} checksum from a set
@@ -25,6 +28,9 @@ import java.util.Arrays;
  * Refer to RFC 1950 for the specification.
  */
 public class Adler32 implements Checksum {
+    static {
+        LazyNatives.register("zip");
+    }
 
     private long adler = 1;
 
@@ -52,7 +58,10 @@ public class Adler32 implements Checksum {
      *            the byte to update checksum with.
      */
     public void update(int i) {
-        adler = updateByteImpl(i, adler);
+        // Cheaper than a native call for a single byte.
+        long s1 = ((adler & 0xffff) + (i & 0xff)) % 65521;
+        long s2 = (((adler >>> 16) & 0xffff) + s1) % 65521;
+        adler = (s2 << 16) | s1;
     }
 
     /**
@@ -74,7 +83,38 @@ public class Adler32 implements Checksum {
         adler = updateImpl(buf, offset, byteCount, adler);
     }
 
+    /**
+     * Updates this checksum with the bytes between {@code buffer}'s position and limit, and
+     * advances its position to its limit. Direct buffers are checksummed in place.
+     *
+     * @hide
+     */
+    public void update(ByteBuffer buffer) {
+        int byteCount = buffer.remaining();
+        if (byteCount == 0) {
+            return;
+        }
+        if (buffer.isDirect()) {
+            adler = updateAddressImpl(NioUtils.unsafeAddress(buffer) + buffer.position(), byteCount, adler);
+        } else if (buffer.hasArray()) {
+            update(buffer.array(), buffer.arrayOffset() + buffer.position(), byteCount);
+        } else {
+            byte[] bytes = new byte[byteCount];
+            buffer.duplicate().get(bytes);
+            update(bytes);
+        }
+        buffer.position(buffer.limit());
+    }
+
+    /**
+     * Returns the Adler-32 of the concatenation of two byte sequences, given the Adler-32 of
+     * each and the length of the second.
+     *
+     * @hide
+     */
+    public static native long combine(long adler1, long adler2, long byteCount2);
+
     private native long updateImpl(byte[] buf, int offset, int byteCount, long adler1);
 
-    private native long updateByteImpl(int val, long adler1);
+    private static native long updateAddressImpl(long address, int byteCount, long adler1);
 }
@@ -17,13 +17,31 @@
 
 package java.util.zip;
 
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
 import java.util.Arrays;
+import libcore.util.LazyNatives;
 
 /**
  * The CRC32 class is used to compute a CRC32 checksum from data provided as
  * input value. See also {@link Adler32} which is almost as good, but cheaper.
  */
 public class CRC32 implements Checksum {
+    static {
+        LazyNatives.register("zip");
+    }
+
+    // For single bytes, a table lookup in Java is much cheaper than a native call.
+    private static final int[] TABLE = new int[256];
+    static {
+        for (int i = 0; i < 256; ++i) {
+            int c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = ((c & 1) != 0) ? (0xedb88320 ^ (c >>> 1)) : (c >>> 1);
+            }
+            TABLE[i] = c;
+        }
+    }
 
     private long crc = 0L;
 
@@ -53,7 +71,9 @@ public class CRC32 implements Checksum {
      *            represents the byte to update the checksum.
      */
     public void update(int val) {
-        crc = updateByteImpl((byte) val, crc);
+        int c = ~((int) crc);
+        c = TABLE[(c ^ val) & 0xff] ^ (c >>> 8);
+        crc = (~c) & 0xffffffffL;
     }
 
     /**
@@ -76,7 +96,40 @@ public class CRC32 implements Checksum {
         crc = updateImpl(buf, offset, byteCount, crc);
     }
 
+    /**
+     * Updates this checksum with the bytes between {@code buffer}'s position and limit, and
+     * advances its position to its limit. Direct buffers are checksummed in place.
+     *
+     * @hide
+     */
+    public void update(ByteBuffer buffer) {
+        int byteCount = buffer.remaining();
+        if (byteCount == 0) {
+            return;
+        }
+        if (buffer.isDirect()) {
+            tbytes += byteCount;
+            crc = updateAddressImpl(NioUtils.unsafeAddress(buffer) + buffer.position(), byteCount, crc);
+        } else if (buffer.hasArray()) {
+            update(buffer.array(), buffer.arrayOffset() + buffer.position(), byteCount);
+        } else {
+            byte[] bytes = new byte[byteCount];
+            buffer.duplicate().get(bytes);
+            update(bytes);
+        }
+        buffer.position(buffer.limit());
+    }
+
+    /**
+     * Returns the CRC32 of the concatenation of two byte sequences, given the CRC32 of each and
+     * the length of the second. This lets chunks be checksummed independently (on different
+     * threads, say) and the results merged.
+     *
+     * @hide
+     */
+    public static native long combine(long crc1, long crc2, long byteCount2);
+
     private native long updateImpl(byte[] buf, int offset, int byteCount, long crc1);
 
-    private native long updateByteImpl(byte val, long crc1);
+    private static native long updateAddressImpl(long address, int byteCount, long crc1);
 }
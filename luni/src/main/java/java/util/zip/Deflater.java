@@ -20,6 +20,7 @@ package java.util.zip;
 import dalvik.system.CloseGuard;
 import java.util.Arrays;
 import libcore.util.EmptyArray;
+import libcore.util.LazyNatives;
 
 /**
  * This class compresses data using the <i>DEFLATE</i> algorithm (see <a
@@ -58,6 +59,9 @@ import libcore.util.EmptyArray;
  * performs some compression, but with minimal speed overhead.
  */
 public class Deflater {
+    static {
+        LazyNatives.register("zip");
+    }
 
     /**
      * This <a href="#compression_level">compression level</a> gives the best compression,
@@ -243,6 +247,38 @@ public class Deflater {
 
     private native int deflateImpl(byte[] buf, int offset, int byteCount, long handle, int flushParm);
 
+    /**
+     * Like {@link #deflate(byte[], int, int)}, but writes to the {@code byteCount} bytes of
+     * native memory at {@code address}, such as a direct ByteBuffer's.
+     *
+     * @hide
+     */
+    public synchronized int deflateAddress(long address, int byteCount) {
+        return deflateAddressImpl(address, byteCount, flushParm);
+    }
+
+    /**
+     * Like {@link #deflate(byte[], int, int, int)}, but writes to native memory.
+     *
+     * @hide
+     */
+    public synchronized int deflateAddress(long address, int byteCount, int flush) {
+        if (flush != NO_FLUSH && flush != SYNC_FLUSH && flush != FULL_FLUSH) {
+            throw new IllegalArgumentException("Bad flush value: " + flush);
+        }
+        return deflateAddressImpl(address, byteCount, flush);
+    }
+
+    private synchronized int deflateAddressImpl(long address, int byteCount, int flush) {
+        checkOpen();
+        if (inputBuffer == null) {
+            setInput(EmptyArray.BYTE);
+        }
+        return deflateAddressImpl(address, byteCount, streamHandle, flush);
+    }
+
+    private native int deflateAddressImpl(long address, int byteCount, long handle, int flushParm);
+
     /**
      * Frees all resources held onto by this deflating algorithm. Any unused
      * input or output is discarded. This method should be called explicitly in
@@ -413,6 +449,26 @@ public class Deflater {
 
     private native void setInputImpl(byte[] buf, int offset, int byteCount, long handle);
 
+    /**
+     * Sets the input to the {@code byteCount} bytes of native memory at {@code address}, which
+     * must stay valid until they've all been consumed or the input is replaced.
+     *
+     * @hide
+     */
+    public synchronized void setAddressInput(long address, int byteCount) {
+        checkOpen();
+        inLength = byteCount;
+        inRead = 0;
+        if (inputBuffer == null) {
+            setLevelsImpl(compressLevel, strategy, streamHandle);
+        }
+        // We don't own the input, but inputBuffer also records that input has been set.
+        inputBuffer = EmptyArray.BYTE;
+        setAddressInputImpl(address, byteCount, streamHandle);
+    }
+
+    private native void setAddressInputImpl(long address, int byteCount, long handle);
+
     /**
      * Sets the given <a href="#compression_level">compression level</a>
      * to be used when compressing data. This value must be set
@@ -20,6 +20,7 @@ package java.util.zip;
 import dalvik.system.CloseGuard;
 import java.io.FileDescriptor;
 import java.util.Arrays;
+import libcore.util.LazyNatives;
 
 /**
  * This class decompresses data that was compressed using the <i>DEFLATE</i>
@@ -49,6 +50,9 @@ import java.util.Arrays;
  * but this is probably another sign you'd be better off using {@link InflaterInputStream}.
  */
 public class Inflater {
+    static {
+        LazyNatives.register("zip");
+    }
 
     private int inLength;
 
@@ -234,6 +238,30 @@ public class Inflater {
 
     private native int inflateImpl(byte[] buf, int offset, int byteCount, long handle);
 
+    /**
+     * Like {@link #inflate(byte[], int, int)}, but writes to the {@code byteCount} bytes of native
+     * memory at {@code address}, such as a direct ByteBuffer's.
+     *
+     * @hide
+     */
+    public synchronized int inflateAddress(long address, int byteCount) throws DataFormatException {
+        checkOpen();
+
+        if (needsInput()) {
+            return 0;
+        }
+
+        boolean neededDict = needsDictionary;
+        needsDictionary = false;
+        int result = inflateAddressImpl(address, byteCount, streamHandle);
+        if (needsDictionary && neededDict) {
+            throw new DataFormatException("Needs dictionary");
+        }
+        return result;
+    }
+
+    private native int inflateAddressImpl(long address, int byteCount, long handle);
+
     /**
      * Returns true if the input bytes were compressed with a preset
      * dictionary. This method should be called if the first call to {@link #inflate} returns 0,
@@ -318,6 +346,21 @@ public class Inflater {
 
     private native int setFileInputImpl(FileDescriptor fd, long offset, int byteCount, long handle);
 
+    /**
+     * Sets the current input to the {@code byteCount} bytes of native memory at {@code address},
+     * which must stay valid until they've all been consumed or the input is replaced.
+     *
+     * @hide
+     */
+    public synchronized void setAddressInput(long address, int byteCount) {
+        checkOpen();
+        inRead = 0;
+        inLength = byteCount;
+        setAddressInputImpl(address, byteCount, streamHandle);
+    }
+
+    private native void setAddressInputImpl(long address, int byteCount, long handle);
+
     private void checkOpen() {
         if (streamHandle == -1) {
             throw new IllegalStateException("attempt to use Inflater after calling end");
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package java.util.zip;
+
+import dalvik.system.CloseGuard;
+import java.util.Arrays;
+import libcore.util.EmptyArray;
+import libcore.util.LazyNatives;
+
+/**
+ * Compresses data on several threads at once, producing a single ordinary zlib or gzip stream.
+ * Input is split into 128KiB blocks that are deflated independently (each primed with the
+ * preceding 32KiB of input, so the compression ratio is close to {@link Deflater}'s), and the
+ * results are stitched together with a combined checksum.
+ *
+ * <p>Each call to {@link #deflate} compresses all of its input before returning, so pass large
+ * chunks: a chunk of less than two blocks keeps only one thread busy. Call {@link #finish} to
+ * get the end of the stream.
+ *
+ * @hide
+ */
+public final class ParallelDeflater {
+    static {
+        LazyNatives.register("zip");
+    }
+
+    private final CloseGuard guard = CloseGuard.get();
+
+    private long streamHandle;
+
+    private boolean finished;
+
+    /**
+     * Creates a deflater that uses up to {@code threadCount} threads (including the calling
+     * thread) to compress at the given level, writing a gzip stream if {@code gzip} is true and
+     * a zlib stream otherwise. More threads than there are processors don't help, so that's
+     * as many as are used.
+     */
+    public ParallelDeflater(int level, boolean gzip, int threadCount) {
+        if (level < Deflater.DEFAULT_COMPRESSION || level > Deflater.BEST_COMPRESSION) {
+            throw new IllegalArgumentException("Bad level: " + level);
+        }
+        if (threadCount < 1) {
+            throw new IllegalArgumentException("threadCount < 1: " + threadCount);
+        }
+        threadCount = Math.min(threadCount, Runtime.getRuntime().availableProcessors());
+        streamHandle = createStream(level, gzip, threadCount);
+        guard.open("end");
+    }
+
+    /**
+     * Compresses the given bytes, returning the compressed bytes that follow what's been
+     * returned so far. The first call's result starts with the stream header.
+     */
+    public synchronized byte[] deflate(byte[] buf, int offset, int byteCount) {
+        checkNotFinished();
+        Arrays.checkOffsetAndCount(buf.length, offset, byteCount);
+        return deflateImpl(buf, offset, byteCount, false, streamHandle);
+    }
+
+    /**
+     * Ends the stream, returning its last compressed bytes, including the trailer.
+     */
+    public synchronized byte[] finish() {
+        checkNotFinished();
+        finished = true;
+        return deflateImpl(EmptyArray.BYTE, 0, 0, true, streamHandle);
+    }
+
+    /**
+     * Returns the checksum of the input so far: a CRC-32 for gzip streams, an Adler-32 for zlib
+     * streams.
+     */
+    public synchronized int getChecksum() {
+        checkOpen();
+        return getChecksumImpl(streamHandle);
+    }
+
+    /** Returns the total number of uncompressed bytes passed in so far. */
+    public synchronized long getBytesRead() {
+        checkOpen();
+        return getTotalInImpl(streamHandle);
+    }
+
+    /** Returns the total number of compressed bytes returned so far. */
+    public synchronized long getBytesWritten() {
+        checkOpen();
+        return getTotalOutImpl(streamHandle);
+    }
+
+    /**
+     * Frees the native resources. After this call, other methods throw IllegalStateException.
+     */
+    public synchronized void end() {
+        guard.close();
+        if (streamHandle != 0) {
+            endImpl(streamHandle);
+            streamHandle = 0;
+        }
+    }
+
+    @Override protected void finalize() {
+        try {
+            if (guard != null) {
+                guard.warnIfOpen();
+            }
+            end();
+        } finally {
+            try {
+                super.finalize();
+            } catch (Throwable t) {
+                throw new AssertionError(t);
+            }
+        }
+    }
+
+    private void checkOpen() {
+        if (streamHandle == 0) {
+            throw new IllegalStateException("attempt to use ParallelDeflater after calling end");
+        }
+    }
+
+    private void checkNotFinished() {
+        checkOpen();
+        if (finished) {
+            throw new IllegalStateException("attempt to use ParallelDeflater after calling finish");
+        }
+    }
+
+    private static native long createStream(int level, boolean gzip, int threadCount);
+    private static native byte[] deflateImpl(byte[] buf, int offset, int byteCount, boolean last, long handle);
+    private static native void endImpl(long handle);
+    private static native int getChecksumImpl(long handle);
+    private static native long getTotalInImpl(long handle);
+    private static native long getTotalOutImpl(long handle);
+}
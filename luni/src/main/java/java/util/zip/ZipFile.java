@@ -31,8 +31,11 @@ import java.util.Enumeration;
 import java.util.Iterator;
 import java.util.LinkedHashMap;
 import libcore.io.BufferIterator;
+import libcore.io.ErrnoException;
 import libcore.io.HeapBufferIterator;
+import libcore.io.Libcore;
 import libcore.io.Streams;
+import static libcore.io.OsConstants.*;
 
 /**
  * This class provides random read access to a zip file. You pay more to read
@@ -94,12 +97,24 @@ public class ZipFile implements Closeable, ZipConstants {
      */
     public static final int OPEN_DELETE = 4;
 
+    /**
+     * Map the whole zip file into memory, and inflate entries straight from the mapping rather
+     * than reading them into a separate buffer first. Falls back to reading if the file can't
+     * be mapped. The mapping outlives {@link #close} until the {@code ZipFile} and all its
+     * streams are garbage collected.
+     *
+     * @hide
+     */
+    public static final int OPEN_MMAP = 8;
+
     private final String filename;
 
     private File fileToDeleteOnClose;
 
     private RandomAccessFile raf;
 
+    private MappedArchive mappedArchive;
+
     private final LinkedHashMap<String, ZipEntry> entries = new LinkedHashMap<String, ZipEntry>();
 
     private String comment;
@@ -135,7 +150,7 @@ public class ZipFile implements Closeable, ZipConstants {
      */
     public ZipFile(File file, int mode) throws IOException {
         filename = file.getPath();
-        if (mode != OPEN_READ && mode != (OPEN_READ | OPEN_DELETE)) {
+        if ((mode & OPEN_READ) == 0 || (mode & ~(OPEN_READ | OPEN_DELETE | OPEN_MMAP)) != 0) {
             throw new IllegalArgumentException("Bad mode: " + mode);
         }
 
@@ -149,6 +164,9 @@ public class ZipFile implements Closeable, ZipConstants {
         raf = new RandomAccessFile(filename, "r");
 
         readCentralDir();
+        if ((mode & OPEN_MMAP) != 0) {
+            mappedArchive = MappedArchive.mmap(raf);
+        }
         guard.open("close");
     }
 
@@ -275,7 +293,7 @@ public class ZipFile implements Closeable, ZipConstants {
             // We don't know the entry data's start position. All we have is the
             // position of the entry's local header.
             // http://www.pkware.com/documents/casestudies/APPNOTE.TXT
-            RAFStream rafStream = new RAFStream(localRaf, entry.localHeaderRelOffset);
+            RAFStream rafStream = new RAFStream(localRaf, entry.localHeaderRelOffset, mappedArchive);
             DataInputStream is = new DataInputStream(rafStream);
 
             final int localMagic = Integer.reverseBytes(is.readInt());
@@ -407,7 +425,7 @@ public class ZipFile implements Closeable, ZipConstants {
         // We have to do this now (from the constructor) rather than lazily because the
         // public API doesn't allow us to throw IOException except from the constructor
         // or from getInputStream.
-        RAFStream rafStream = new RAFStream(raf, centralDirOffset);
+        RAFStream rafStream = new RAFStream(raf, centralDirOffset, null);
         BufferedInputStream bufferedStream = new BufferedInputStream(rafStream, 4096);
         byte[] hdrBuf = new byte[CENHDR]; // Reuse the same buffer for each entry.
         for (int i = 0; i < numEntries; ++i) {
@@ -437,11 +455,13 @@ public class ZipFile implements Closeable, ZipConstants {
      */
     static class RAFStream extends InputStream {
         private final RandomAccessFile sharedRaf;
+        private final MappedArchive mappedArchive;
         private long endOffset;
         private long offset;
 
-        public RAFStream(RandomAccessFile raf, long initialOffset) throws IOException {
+        public RAFStream(RandomAccessFile raf, long initialOffset, MappedArchive mappedArchive) throws IOException {
             sharedRaf = raf;
+            this.mappedArchive = mappedArchive;
             offset = initialOffset;
             endOffset = raf.length();
         }
@@ -480,6 +500,16 @@ public class ZipFile implements Closeable, ZipConstants {
         }
 
         public int fill(Inflater inflater, int nativeEndBufSize) throws IOException {
+            if (mappedArchive != null) {
+                // Hand the inflater all the remaining compressed data at once.
+                long end = Math.min(endOffset, mappedArchive.size);
+                if (offset < end) {
+                    int len = (int) Math.min(end - offset, Integer.MAX_VALUE);
+                    inflater.setAddressInput(mappedArchive.address + offset, len);
+                    skip(len);
+                    return len;
+                }
+            }
             synchronized (sharedRaf) {
                 int len = Math.min((int) (endOffset - offset), nativeEndBufSize);
                 int cnt = inflater.setFileInput(sharedRaf.getFD(), offset, nativeEndBufSize);
@@ -491,6 +521,39 @@ public class ZipFile implements Closeable, ZipConstants {
         }
     }
 
+    /**
+     * A read-only mapping of a whole zip file, shared by all the streams returned by
+     * {@link #getInputStream}. Inflaters point straight into the mapping, so we can't unmap it
+     * until nothing can reach it.
+     */
+    static final class MappedArchive {
+        final long address;
+        final long size;
+
+        private MappedArchive(long address, long size) {
+            this.address = address;
+            this.size = size;
+        }
+
+        static MappedArchive mmap(RandomAccessFile raf) throws IOException {
+            long size = raf.length();
+            try {
+                return new MappedArchive(Libcore.os.mmap(0L, size, PROT_READ, MAP_SHARED, raf.getFD(), 0), size);
+            } catch (ErrnoException e) {
+                // Fall back to reading.
+                return null;
+            }
+        }
+
+        @Override protected void finalize() throws Throwable {
+            try {
+                Libcore.os.munmap(address, size);
+            } finally {
+                super.finalize();
+            }
+        }
+    }
+
     static class ZipInflaterInputStream extends InflaterInputStream {
         private final ZipEntry entry;
         private long bytesRead = 0;
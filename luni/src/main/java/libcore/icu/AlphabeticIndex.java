@@ -17,11 +17,16 @@
 package libcore.icu;
 
 import java.util.Locale;
+import libcore.util.BasicLruCache;
+import libcore.util.LazyNatives;
 
 /**
  * Exposes icu4c's AlphabeticIndex.
  */
 public final class AlphabeticIndex {
+  static {
+    LazyNatives.register("icu");
+  }
 
   /**
    * Exposes icu4c's ImmutableIndex (new to icu 51). This exposes a read-only,
@@ -60,6 +65,14 @@ public final class AlphabeticIndex {
       return getBucketIndex(peer, s);
     }
 
+    /**
+     * Returns the index of the bucket in which each element of 'strings' should appear,
+     * or -1 for null elements, in one native call.
+     */
+    public int[] getBucketIndices(String[] strings) {
+      return getBucketIndices(peer, strings);
+    }
+
     /**
      * Returns the label for the bucket at the given index (as returned by getBucketIndex).
      */
@@ -67,11 +80,44 @@ public final class AlphabeticIndex {
       return getBucketLabel(peer, index);
     }
 
+    private static native void destroy(long peer);
     private static native int getBucketCount(long peer);
     private static native int getBucketIndex(long peer, String s);
+    private static native int[] getBucketIndices(long peer, String[] strings);
     private static native String getBucketLabel(long peer, int index);
   }
 
+  // ImmutableIndex is thread-safe, so one can be shared by everyone who wants the same
+  // labels. Building one means collating every label, so it's worth keeping a few.
+  private static final BasicLruCache<String, ImmutableIndex> CACHED_IMMUTABLE_INDEXES =
+      new BasicLruCache<String, ImmutableIndex>(4);
+
+  /**
+   * Returns a shared ImmutableIndex that collates as 'locales[0]' and has the labels of all
+   * of 'locales', with at most 'maxLabelCount' labels.
+   */
+  public static ImmutableIndex getImmutableIndex(int maxLabelCount, Locale... locales) {
+    if (locales.length == 0) {
+      throw new IllegalArgumentException("locales.length == 0");
+    }
+    StringBuilder key = new StringBuilder();
+    key.append(maxLabelCount);
+    for (Locale locale : locales) {
+      key.append(',').append(locale);
+    }
+    String keyString = key.toString();
+    ImmutableIndex result = CACHED_IMMUTABLE_INDEXES.get(keyString);
+    if (result == null) {
+      AlphabeticIndex index = new AlphabeticIndex(locales[0]).setMaxLabelCount(maxLabelCount);
+      for (int i = 1; i < locales.length; ++i) {
+        index.addLabels(locales[i]);
+      }
+      result = index.getImmutableIndex();
+      CACHED_IMMUTABLE_INDEXES.put(keyString, result);
+    }
+    return result;
+  }
+
   private long peer;
 
   /**
@@ -144,6 +190,14 @@ public final class AlphabeticIndex {
     return getBucketIndex(peer, s);
   }
 
+  /**
+   * Returns the index of the bucket in which each element of 'strings' should appear,
+   * or -1 for null elements, in one native call.
+   */
+  public synchronized int[] getBucketIndices(String[] strings) {
+    return getBucketIndices(peer, strings);
+  }
+
   /**
    * Returns the label for the bucket at the given index (as returned by getBucketIndex).
    */
@@ -166,6 +220,7 @@ public final class AlphabeticIndex {
   private static native void addLabelRange(long peer, int codePointStart, int codePointEnd);
   private static native int getBucketCount(long peer);
   private static native int getBucketIndex(long peer, String s);
+  private static native int[] getBucketIndices(long peer, String[] strings);
   private static native String getBucketLabel(long peer, int index);
   private static native long buildImmutableIndex(long peer);
 }
@@ -20,11 +20,15 @@ import java.util.Calendar;
 import java.util.Locale;
 import java.util.TimeZone;
 import libcore.util.BasicLruCache;
+import libcore.util.LazyNatives;
 
 /**
  * Exposes icu4c's DateIntervalFormat.
  */
 public final class DateIntervalFormat {
+  static {
+    LazyNatives.register("icu");
+  }
 
   // These are all public API in DateUtils. There are others, but they're either for use with
   // other methods (like FORMAT_ABBREV_RELATIVE), don't internationalize (like FORMAT_CAP_AMPM),
@@ -19,14 +19,29 @@ package libcore.icu;
 import java.util.LinkedHashSet;
 import java.util.Locale;
 import libcore.util.BasicLruCache;
+import libcore.util.LazyNatives;
 
 /**
  * Makes ICU data accessible to Java.
  */
 public final class ICU {
+  static {
+    LazyNatives.register("icu");
+  }
+
   private static final BasicLruCache<String, String> CACHED_PATTERNS =
       new BasicLruCache<String, String>(8);
 
+  // Formatting code asks for these over and over for the same few locales and currencies.
+  private static final BasicLruCache<String, String> CACHED_LIKELY_SUBTAGS =
+      new BasicLruCache<String, String>(32);
+  private static final BasicLruCache<String, String> CACHED_SCRIPTS =
+      new BasicLruCache<String, String>(32);
+  private static final BasicLruCache<String, String> CACHED_CURRENCY_CODES =
+      new BasicLruCache<String, String>(32);
+  private static final BasicLruCache<String, Integer> CACHED_CURRENCY_FRACTION_DIGITS =
+      new BasicLruCache<String, Integer>(32);
+
   private static Locale[] availableLocalesCache;
 
   private static String[] isoCountries;
@@ -197,9 +212,22 @@ public final class ICU {
 
   // --- Case mapping.
 
+  // These return 's' itself if nothing changes.
   public static native String toLowerCase(String s, String localeName);
   public static native String toUpperCase(String s, String localeName);
 
+  /**
+   * Replaces each non-null element of 'strings' with its lowercase form, sharing the locale
+   * lookup between them. Elements that don't change are left as the same instance.
+   */
+  public static native void toLowerCaseAll(String[] strings, String localeName);
+
+  /**
+   * Replaces each non-null element of 'strings' with its uppercase form, sharing the locale
+   * lookup between them. Elements that don't change are left as the same instance.
+   */
+  public static native void toUpperCaseAll(String[] strings, String localeName);
+
   // --- Errors.
 
   // Just the subset of error codes needed by CharsetDecoderICU/CharsetEncoderICU.
@@ -222,10 +250,31 @@ public final class ICU {
   private static native String[] getAvailableLocalesNative();
   private static native String[] getAvailableNumberFormatLocalesNative();
 
+  public static String getCurrencyCode(String countryCode) {
+    String result = CACHED_CURRENCY_CODES.get(countryCode);
+    if (result == null) {
+      result = getCurrencyCodeNative(countryCode);
+      // Countries with no current currency get null, which isn't worth caching.
+      if (result != null) {
+        CACHED_CURRENCY_CODES.put(countryCode, result);
+      }
+    }
+    return result;
+  }
+
+  public static int getCurrencyFractionDigits(String currencyCode) {
+    Integer result = CACHED_CURRENCY_FRACTION_DIGITS.get(currencyCode);
+    if (result == null) {
+      result = getCurrencyFractionDigitsNative(currencyCode);
+      CACHED_CURRENCY_FRACTION_DIGITS.put(currencyCode, result);
+    }
+    return result;
+  }
+
   public static native String[] getAvailableCurrencyCodes();
-  public static native String getCurrencyCode(String countryCode);
+  private static native String getCurrencyCodeNative(String countryCode);
   public static native String getCurrencyDisplayName(String locale, String currencyCode);
-  public static native int getCurrencyFractionDigits(String currencyCode);
+  private static native int getCurrencyFractionDigitsNative(String currencyCode);
   public static native String getCurrencySymbol(String locale, String currencyCode);
 
   public static native String getDisplayCountryNative(String countryCode, String locale);
@@ -235,8 +284,28 @@ public final class ICU {
   public static native String getISO3CountryNative(String locale);
   public static native String getISO3LanguageNative(String locale);
 
-  public static native String addLikelySubtags(String locale);
-  public static native String getScript(String locale);
+  public static String addLikelySubtags(String locale) {
+    String result = CACHED_LIKELY_SUBTAGS.get(locale);
+    if (result == null) {
+      result = addLikelySubtagsNative(locale);
+      CACHED_LIKELY_SUBTAGS.put(locale, result);
+    }
+    return result;
+  }
+
+  public static String getScript(String locale) {
+    String result = CACHED_SCRIPTS.get(locale);
+    if (result == null) {
+      result = getScriptNative(locale);
+      if (result != null) {
+        CACHED_SCRIPTS.put(locale, result);
+      }
+    }
+    return result;
+  }
+
+  private static native String addLikelySubtagsNative(String locale);
+  private static native String getScriptNative(String locale);
 
   private static native String[] getISOLanguagesNative();
   private static native String[] getISOCountriesNative();
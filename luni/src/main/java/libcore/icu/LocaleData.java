@@ -20,6 +20,7 @@ import java.text.DateFormat;
 import java.util.Arrays;
 import java.util.HashMap;
 import java.util.Locale;
+import java.util.concurrent.atomic.AtomicInteger;
 import libcore.util.Objects;
 
 /**
@@ -137,6 +138,32 @@ public final class LocaleData {
         }
     }
 
+    /**
+     * Loads the data for each of {@code locales} into the cache on background threads, so that
+     * later calls to {@link #get} don't have to wait for ICU. Returns without waiting for the
+     * threads, which are daemons. A locale that can't be loaded is skipped here, and will fail
+     * again when {@link #get} is called for it.
+     */
+    public static void preload(final Locale[] locales) {
+        final AtomicInteger next = new AtomicInteger();
+        Runnable loader = new Runnable() {
+            @Override public void run() {
+                for (int i; (i = next.getAndIncrement()) < locales.length; ) {
+                    try {
+                        get(locales[i]);
+                    } catch (Throwable ignored) {
+                    }
+                }
+            }
+        };
+        int threadCount = Math.min(locales.length, Runtime.getRuntime().availableProcessors());
+        for (int i = 0; i < threadCount; ++i) {
+            Thread thread = new Thread(loader, "LocaleData preload " + i);
+            thread.setDaemon(true);
+            thread.start();
+        }
+    }
+
     @Override public String toString() {
         return Objects.toString(this);
     }
@@ -18,9 +18,15 @@ package libcore.icu;
 
 import java.text.CharacterIterator;
 import java.text.StringCharacterIterator;
+import java.util.HashMap;
 import java.util.Locale;
+import libcore.util.LazyNatives;
 
 public final class NativeBreakIterator implements Cloneable {
+    static {
+        LazyNatives.register("icu");
+    }
+
     // Acceptable values for the 'type' field.
     private static final int BI_CHAR_INSTANCE = 1;
     private static final int BI_WORD_INSTANCE = 2;
@@ -157,6 +163,64 @@ public final class NativeBreakIterator implements Cloneable {
         return new NativeBreakIterator(getWordInstanceImpl(where.toString()), BI_WORD_INSTANCE);
     }
 
+    /**
+     * Returns every word boundary in 'text', from 0 to text.length(), using the word rules
+     * for 'where'. If 'withRuleStatus' is true, the array instead holds pairs of a boundary
+     * and the rule status of the text before it, one of ICU's UBRK_WORD_* tags (0 for
+     * spaces and punctuation, 100 and up for numbers, 200 and up for letters, and so on).
+     *
+     * This makes one native call per text rather than one per boundary, and it is safe to
+     * call from any number of threads at once: each thread gets its own clone of the
+     * iterator for the locale.
+     */
+    public static int[] getWordBoundaries(Locale where, String text, boolean withRuleStatus) {
+        return threadInstance(BI_WORD_INSTANCE, where).getBoundaries(text, withRuleStatus);
+    }
+
+    /**
+     * Like getWordBoundaries, but for line-break opportunities. The rule status is 0 for a
+     * soft break and 100 for a hard (mandatory) break.
+     */
+    public static int[] getLineBoundaries(Locale where, String text, boolean withRuleStatus) {
+        return threadInstance(BI_LINE_INSTANCE, where).getBoundaries(text, withRuleStatus);
+    }
+
+    private int[] getBoundaries(String text, boolean withRuleStatus) {
+        // Thread instances are never shared or given text, so there's no need to lock.
+        return getBoundariesImpl(this.address, text, withRuleStatus);
+    }
+
+    // One iterator per type and locale, only ever cloned, so threads don't each pay for
+    // loading the rules.
+    private static final HashMap<String, NativeBreakIterator> PROTOTYPES =
+            new HashMap<String, NativeBreakIterator>();
+
+    private static final ThreadLocal<HashMap<String, NativeBreakIterator>> THREAD_INSTANCES =
+            new ThreadLocal<HashMap<String, NativeBreakIterator>>() {
+        @Override protected HashMap<String, NativeBreakIterator> initialValue() {
+            return new HashMap<String, NativeBreakIterator>();
+        }
+    };
+
+    private static NativeBreakIterator threadInstance(int type, Locale where) {
+        String key = type + where.toString();
+        HashMap<String, NativeBreakIterator> instances = THREAD_INSTANCES.get();
+        NativeBreakIterator result = instances.get(key);
+        if (result == null) {
+            NativeBreakIterator prototype;
+            synchronized (PROTOTYPES) {
+                prototype = PROTOTYPES.get(key);
+                if (prototype == null) {
+                    prototype = (type == BI_WORD_INSTANCE) ? getWordInstance(where) : getLineInstance(where);
+                    PROTOTYPES.put(key, prototype);
+                }
+            }
+            result = (NativeBreakIterator) prototype.clone();
+            instances.put(key, result);
+        }
+        return result;
+    }
+
     private static native long getCharacterInstanceImpl(String locale);
     private static native long getWordInstanceImpl(String locale);
     private static native long getLineInstanceImpl(String locale);
@@ -174,4 +238,5 @@ public final class NativeBreakIterator implements Cloneable {
     private static synchronized native int firstImpl(long address, String text);
     private static synchronized native int followingImpl(long address, String text, int offset);
     private static synchronized native int lastImpl(long address, String text);
+    private static native int[] getBoundariesImpl(long address, String text, boolean withRuleStatus);
 }
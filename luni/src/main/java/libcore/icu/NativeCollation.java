@@ -10,12 +10,18 @@
 
 package libcore.icu;
 
+import libcore.util.LazyNatives;
+
 /**
 * Package static class for declaring all native methods for collation use.
 * @author syn wee quek
 * @internal ICU 2.4
 */
 public final class NativeCollation {
+    static {
+        LazyNatives.register("icu");
+    }
+
     private NativeCollation() {
     }
 
@@ -26,6 +32,7 @@ public final class NativeCollation {
     public static native int getCollationElementIterator(long address, String source);
     public static native String getRules(long address);
     public static native byte[] getSortKey(long address, String source);
+    public static native byte[] getSortKeys(long address, String[] sources, int[] offsets, int maxKeyLength);
     public static native long openCollator(String locale);
     public static native long openCollatorFromRules(String rules, int normalizationMode, int collationStrength);
     public static native long safeClone(long address);
@@ -13,14 +13,50 @@ import java.nio.charset.Charset;
 import java.nio.charset.CharsetDecoder;
 import java.nio.charset.CharsetEncoder;
 import java.nio.charset.CodingErrorAction;
+import libcore.util.LazyNatives;
 
 public final class NativeConverter {
+    static {
+        LazyNatives.register("icu");
+    }
+
     public static native int decode(long converterHandle, byte[] input, int inEnd,
             char[] output, int outEnd, int[] data, boolean flush);
 
     public static native int encode(long converterHandle, char[] input, int inEnd,
             byte[] output, int outEnd, int[] data, boolean flush);
 
+    /**
+     * Like {@link #decode}, but reads from the native memory at {@code input}, such as a direct
+     * or mapped ByteBuffer's, without copying it to the Java heap first.
+     */
+    public static native int decodeAddress(long converterHandle, long input, int inEnd,
+            char[] output, int outEnd, int[] data, boolean flush);
+
+    /**
+     * Like {@link #encode}, but writes to the native memory at {@code output}.
+     */
+    public static native int encodeAddress(long converterHandle, char[] input, int inEnd,
+            long output, int outEnd, int[] data, boolean flush);
+
+    /**
+     * Decodes a chain of native buffers as if they were one contiguous input, stopping at the
+     * first error or when {@code output} is full. A character split across buffers is decoded
+     * correctly. On input, {@code data[0]} is the offset into the first buffer; on output, it's
+     * the total number of bytes consumed across the chain. {@code flush} applies to the end of
+     * the last buffer.
+     */
+    public static native int decodeAddresses(long converterHandle, long[] inputs, int[] inputByteCounts,
+            char[] output, int outEnd, int[] data, boolean flush);
+
+    /**
+     * Encodes into a chain of native buffers, moving on to the next buffer whenever one fills.
+     * On input, {@code data[1]} is the offset into the first buffer; on output, it's the total
+     * number of bytes written across the chain.
+     */
+    public static native int encodeAddresses(long converterHandle, char[] input, int inEnd,
+            long[] outputs, int[] outputByteCounts, int[] data, boolean flush);
+
     public static native long openConverter(String charsetName);
     public static native void closeConverter(long converterHandle);
 
@@ -28,8 +28,13 @@ import java.text.NumberFormat;
 import java.text.ParsePosition;
 import java.util.Currency;
 import java.util.NoSuchElementException;
+import libcore.util.LazyNatives;
 
 public final class NativeDecimalFormat implements Cloneable {
+    static {
+        LazyNatives.register("icu");
+    }
+
     /**
      * Constants corresponding to the native type UNumberFormatSymbol, for setSymbol.
      */
@@ -266,6 +271,71 @@ public final class NativeDecimalFormat implements Cloneable {
         return result;
     }
 
+    /**
+     * Formats {@code value} into {@code dst} starting at {@code offset}, and returns the length
+     * of the result. If the result doesn't fit, nothing is written and the caller should retry
+     * with room for the returned length.
+     */
+    public int formatLong(long value, char[] dst, int offset) {
+        return formatLongInto(this.address, value, dst, offset);
+    }
+
+    /**
+     * Formats {@code value} into {@code dst} starting at {@code offset}, like
+     * {@link #formatLong(long, char[], int)}.
+     */
+    public int formatDouble(double value, char[] dst, int offset) {
+        return formatDoubleInto(this.address, value, dst, offset);
+    }
+
+    /**
+     * Appends {@code value} formatted to {@code buffer}, filling in {@code field}. If there's
+     * no field to fill in, this formats via a per-thread buffer rather than a new char[].
+     */
+    public void formatLong(long value, FieldPosition field, StringBuffer buffer) {
+        if (FieldPositionIterator.forFieldPosition(field) != null) {
+            buffer.append(formatLong(value, field));
+            return;
+        }
+        char[] chars = FORMAT_BUFFER.get();
+        int length = formatLongInto(this.address, value, chars, 0);
+        if (length > chars.length) {
+            chars = growFormatBuffer(length);
+            formatLongInto(this.address, value, chars, 0);
+        }
+        buffer.append(chars, 0, length);
+    }
+
+    /**
+     * Appends {@code value} formatted to {@code buffer}, like
+     * {@link #formatLong(long, FieldPosition, StringBuffer)}.
+     */
+    public void formatDouble(double value, FieldPosition field, StringBuffer buffer) {
+        if (FieldPositionIterator.forFieldPosition(field) != null) {
+            buffer.append(formatDouble(value, field));
+            return;
+        }
+        char[] chars = FORMAT_BUFFER.get();
+        int length = formatDoubleInto(this.address, value, chars, 0);
+        if (length > chars.length) {
+            chars = growFormatBuffer(length);
+            formatDoubleInto(this.address, value, chars, 0);
+        }
+        buffer.append(chars, 0, length);
+    }
+
+    private static final ThreadLocal<char[]> FORMAT_BUFFER = new ThreadLocal<char[]>() {
+        @Override protected char[] initialValue() {
+            return new char[64];
+        }
+    };
+
+    private static char[] growFormatBuffer(int length) {
+        char[] chars = new char[length];
+        FORMAT_BUFFER.set(chars);
+        return chars;
+    }
+
     public void applyLocalizedPattern(String pattern) {
         applyPattern(this.address, true, pattern);
         lastPattern = null;
@@ -625,6 +695,8 @@ public final class NativeDecimalFormat implements Cloneable {
     private static native void close(long addr);
     private static native char[] formatLong(long addr, long value, FieldPositionIterator iter);
     private static native char[] formatDouble(long addr, double value, FieldPositionIterator iter);
+    private static native int formatDoubleInto(long addr, double value, char[] dst, int offset);
+    private static native int formatLongInto(long addr, long value, char[] dst, int offset);
     private static native char[] formatDigitList(long addr, String value, FieldPositionIterator iter);
     private static native int getAttribute(long addr, int symbol);
     private static native String getTextAttribute(long addr, int symbol);
@@ -16,7 +16,18 @@
 
 package libcore.icu;
 
+import libcore.util.BasicLruCache;
+import libcore.util.LazyNatives;
+
 public final class NativeIDN {
+    static {
+        LazyNatives.register("icu");
+    }
+
+    // Recent conversions of hostnames that needed ICU, keyed by direction, flags and input.
+    private static final BasicLruCache<String, String> CACHED_CONVERSIONS =
+            new BasicLruCache<String, String>(64);
+
     public static String toASCII(String s, int flags) {
         return convert(s, flags, true);
     }
@@ -36,7 +47,53 @@ public final class NativeIDN {
         if (s == null) {
             throw new NullPointerException("s == null");
         }
-        return convertImpl(s, flags, toAscii);
+        if (isPlainHostname(s, !toAscii)) {
+            return s;
+        }
+        String key = (toAscii ? "A" : "U") + flags + ":" + s;
+        String result = CACHED_CONVERSIONS.get(key);
+        if (result == null) {
+            // Failures throw, so only successful conversions are cached.
+            result = convertImpl(s, flags, toAscii);
+            CACHED_CONVERSIONS.put(key, result);
+        }
+        return result;
+    }
+
+    /**
+     * Returns true if ICU would return 's' unchanged whatever the flags: a non-empty sequence
+     * of labels of 1 to 63 ASCII letters, digits and hyphens that don't start or end with a
+     * hyphen, optionally followed by a single trailing dot. If 'rejectAce' is true, labels
+     * starting with the "xn--" ACE prefix don't count, because toUnicode decodes them.
+     */
+    private static boolean isPlainHostname(String s, boolean rejectAce) {
+        int length = s.length();
+        // ICU's output buffer holds 256 chars; leave anything longer to ICU to reject.
+        if (length == 0 || length >= 256) {
+            return false;
+        }
+        int labelStart = 0;
+        for (int i = 0; i <= length; ++i) {
+            char ch = (i < length) ? s.charAt(i) : '.';
+            if (ch == '.') {
+                int labelLength = i - labelStart;
+                if (labelLength == 0) {
+                    // Only the root label after a trailing dot may be empty.
+                    return i == length && labelStart == length && length > 1;
+                }
+                if (labelLength > 63 || s.charAt(labelStart) == '-' || s.charAt(i - 1) == '-') {
+                    return false;
+                }
+                if (rejectAce && labelLength >= 4 && s.regionMatches(true, labelStart, "xn--", 0, 4)) {
+                    return false;
+                }
+                labelStart = i + 1;
+            } else if (!((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+                    (ch >= '0' && ch <= '9') || ch == '-')) {
+                return false;
+            }
+        }
+        return true;
     }
     private static native String convertImpl(String s, int flags, boolean toAscii);
 
@@ -17,16 +17,33 @@
 package libcore.icu;
 
 import java.text.Normalizer.Form;
+import libcore.util.LazyNatives;
 
 public final class NativeNormalizer {
+    static {
+        LazyNatives.register("icu");
+    }
+
     public static boolean isNormalized(CharSequence src, Form form) {
         return isNormalizedImpl(src.toString(), toUNormalizationMode(form));
     }
 
+    /**
+     * Returns 'src' normalized to 'form'. If 'src' is a String that's already normalized,
+     * that same String is returned.
+     */
     public static String normalize(CharSequence src, Form form) {
         return normalizeImpl(src.toString(), toUNormalizationMode(form));
     }
 
+    /**
+     * Replaces each non-null element of 'strings' with its 'form' normalization, leaving
+     * elements that are already normalized as the same instance.
+     */
+    public static void normalizeAll(String[] strings, Form form) {
+        normalizeAllImpl(strings, toUNormalizationMode(form));
+    }
+
     private static int toUNormalizationMode(Form form) {
         // Translates Java enum constants to ICU int constants.
         // See UNormalizationMode in "unicode/unorm.h". Stable API since ICU 2.0.
@@ -41,6 +58,8 @@ public final class NativeNormalizer {
 
     private static native String normalizeImpl(String src, int form);
 
+    private static native void normalizeAllImpl(String[] strings, int form);
+
     private static native boolean isNormalizedImpl(String src, int form);
 
     private NativeNormalizer() {}
@@ -13,6 +13,7 @@ package libcore.icu;
 import java.text.CharacterIterator;
 import java.text.CollationKey;
 import java.text.ParseException;
+import java.util.Arrays;
 import java.util.Locale;
 
 public final class RuleBasedCollatorICU implements Cloneable {
@@ -102,6 +103,36 @@ public final class RuleBasedCollatorICU implements Cloneable {
         return new CollationKeyICU(source, key);
     }
 
+    /**
+     * Returns the collation keys of all of {@code sources}, computed in a single native call.
+     * As with {@link #getCollationKey}, a null source has a null key.
+     */
+    public CollationKey[] getCollationKeys(String[] sources) {
+        int[] offsets = new int[sources.length + 1];
+        byte[] keys = NativeCollation.getSortKeys(address, sources, offsets, 0);
+        CollationKey[] result = new CollationKey[sources.length];
+        for (int i = 0; i < sources.length; ++i) {
+            if (offsets[i] != offsets[i + 1]) {
+                result[i] = new CollationKeyICU(sources[i],
+                        Arrays.copyOfRange(keys, offsets[i], offsets[i + 1]));
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Returns the sort keys of all of {@code sources} packed one after another. The key of
+     * {@code sources[i]} is bytes {@code [offsets[i], offsets[i + 1])}, so {@code offsets}
+     * must have room for {@code sources.length + 1} ints. Keys compare as unsigned bytes.
+     *
+     * <p>If {@code maxKeyLength > 0}, each key is cut short after that many bytes, which is
+     * much cheaper for long strings. Comparing such prefixes gives the right order for strings
+     * whose prefixes differ; strings whose prefixes are equal need a full {@link #compare}.
+     */
+    public byte[] getSortKeys(String[] sources, int[] offsets, int maxKeyLength) {
+        return NativeCollation.getSortKeys(address, sources, offsets, maxKeyLength);
+    }
+
     public String getRules() {
         return NativeCollation.getRules(address);
     }
@@ -23,12 +23,17 @@ import java.util.HashMap;
 import java.util.Locale;
 import java.util.TimeZone;
 import libcore.util.BasicLruCache;
+import libcore.util.LazyNatives;
 import libcore.util.ZoneInfoDB;
 
 /**
  * Provides access to ICU's time zone name data.
  */
 public final class TimeZoneNames {
+    static {
+        LazyNatives.register("icu");
+    }
+
     private static final String[] availableTimeZoneIds = TimeZone.getAvailableIDs();
 
     /*
@@ -41,6 +46,12 @@ public final class TimeZoneNames {
     public static final int SHORT_NAME_DST = 4;
     public static final int NAME_COUNT = 5;
 
+    /**
+     * The directory in which to keep each locale's zone names between process starts, or unset
+     * (the default) for no on-disk cache. It must be writable by the process.
+     */
+    public static final String CACHE_DIR_PROPERTY = "libcore.icu.TimeZoneNames.cacheDir";
+
     private static final ZoneStringsCache cachedZoneStrings = new ZoneStringsCache();
     static {
         // Ensure that we pull in the zone strings for the root locale, en_US, and the
@@ -74,7 +85,7 @@ public final class TimeZoneNames {
             }
 
             long nativeStart = System.currentTimeMillis();
-            fillZoneStrings(locale.toString(), result);
+            fillZoneStrings(locale.toString(), result, cachePath(locale));
             long nativeEnd = System.currentTimeMillis();
 
             internStrings(result);
@@ -104,6 +115,20 @@ public final class TimeZoneNames {
         }
     }
 
+    /**
+     * Returns the file the native code should use to cache the names for 'locale' across
+     * process starts, or null if there's no cache directory. The cache is only valid for the
+     * ICU data that wrote it, so the versions are part of the name.
+     */
+    private static String cachePath(Locale locale) {
+        String cacheDir = System.getProperty(CACHE_DIR_PROPERTY);
+        if (cacheDir == null || cacheDir.isEmpty()) {
+            return null;
+        }
+        return cacheDir + "/tznames-" + ICU.getIcuVersion() + "-" + ICU.getCldrVersion() +
+                "-" + locale + ".dat";
+    }
+
     private static final Comparator<String[]> ZONE_STRINGS_COMPARATOR = new Comparator<String[]>() {
         public int compare(String[] lhs, String[] rhs) {
             return lhs[OLSON_NAME].compareTo(rhs[OLSON_NAME]);
@@ -162,5 +187,5 @@ public final class TimeZoneNames {
         return ids.toArray(new String[ids.size()]);
     }
 
-    private static native void fillZoneStrings(String locale, String[][] result);
+    private static native void fillZoneStrings(String locale, String[][] result, String cachePath);
 }
@@ -16,14 +16,29 @@
 
 package libcore.icu;
 
+import java.util.HashMap;
+import libcore.util.LazyNatives;
+
 /**
  * Exposes icu4c's Transliterator.
  */
 public final class Transliterator {
+  static {
+    LazyNatives.register("icu");
+  }
+
   private long peer;
 
+  private static final ThreadLocal<HashMap<String, Transliterator>> THREAD_INSTANCES =
+      new ThreadLocal<HashMap<String, Transliterator>>() {
+    @Override protected HashMap<String, Transliterator> initialValue() {
+      return new HashMap<String, Transliterator>();
+    }
+  };
+
   /**
-   * Creates a new Transliterator for the given id.
+   * Creates a new Transliterator for the given id. Instances are cheap to create after the
+   * first for an id, because they're cloned from a shared, already-compiled native instance.
    */
   public Transliterator(String id) {
     peer = create(id);
@@ -38,19 +53,42 @@ public final class Transliterator {
     }
   }
 
+  /**
+   * Returns this thread's Transliterator for 'id', creating it on first use. A Transliterator
+   * must not be used by more than one thread at once, so don't hand the result to another.
+   */
+  public static Transliterator getThreadInstance(String id) {
+    HashMap<String, Transliterator> instances = THREAD_INSTANCES.get();
+    Transliterator result = instances.get(id);
+    if (result == null) {
+      result = new Transliterator(id);
+      instances.put(id, result);
+    }
+    return result;
+  }
+
   /**
    * Returns the ids of all known transliterators.
    */
   public static native String[] getAvailableIDs();
 
   /**
-   * Transliterates the specified string.
+   * Transliterates the specified string. If nothing changes, 's' itself is returned.
    */
   public String transliterate(String s) {
     return transliterate(peer, s);
   }
 
+  /**
+   * Replaces each non-null element of 'strings' with its transliteration, in one native call.
+   * Elements that don't change are left as the same instance.
+   */
+  public void transliterate(String[] strings) {
+    transliterateAll(peer, strings);
+  }
+
   private static native long create(String id);
   private static native void destroy(long peer);
   private static native String transliterate(long peer, String s);
+  private static native void transliterateAll(long peer, String[] strings);
 }
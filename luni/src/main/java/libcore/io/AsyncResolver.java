@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+import java.io.FileDescriptor;
+import java.net.InetAddress;
+import java.net.SocketException;
+import java.util.concurrent.CancellationException;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.Future;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.TimeoutException;
+
+/**
+ * Resolves host names with getaddrinfo(3) on a small pool of native threads, so that callers can
+ * start lookups without blocking and collect the answers later. An {@code AF_UNSPEC} lookup runs
+ * its IPv6 and IPv4 queries in parallel. Concurrent lookups of the same name with the same hints
+ * share one query, and answers -- including "no such host" -- are cached. getaddrinfo(3) doesn't
+ * report DNS TTLs, so cache entries have fixed lifetimes; see {@link #setCacheTtls}.
+ *
+ * <p>A getaddrinfo(3) call can't be interrupted once it has started, but waiting for one can
+ * be: cancelling a {@link Lookup}, or closing the socket passed to {@link Lookup#await}, wakes
+ * its waiters, and a query nobody is waiting for any more is dropped if it hasn't started.
+ *
+ * @hide
+ */
+public final class AsyncResolver {
+    private AsyncResolver() {
+    }
+
+    /**
+     * Starts resolving {@code node}. Only the {@code ai_flags}, {@code ai_family},
+     * {@code ai_socktype} and {@code ai_protocol} fields of {@code hints} are used.
+     */
+    public static Lookup lookup(String node, StructAddrinfo hints) {
+        if (node == null) {
+            throw new NullPointerException("node == null");
+        }
+        return new Lookup(lookupImpl(node, hints.ai_flags, hints.ai_family, hints.ai_socktype, hints.ai_protocol));
+    }
+
+    /** Forgets all cached answers. Lookups in flight are unaffected. */
+    public static native void clearCache();
+
+    /**
+     * Sets how long answers are cached: successful ones for {@code positiveMillis}, and ones
+     * saying the name doesn't exist for {@code negativeMillis}. Failures that may be transient
+     * are never cached. Both default to 2s, like {@link InetAddress}'s cache.
+     */
+    public static native void setCacheTtls(long positiveMillis, long negativeMillis);
+
+    /**
+     * A lookup started by {@link AsyncResolver#lookup}. Any number of threads may wait for it.
+     */
+    public static final class Lookup implements Future<InetAddress[]> {
+        // The native lookup, or 0 once we've collected its answer and nobody's waiting on it.
+        private long handle;
+        // The number of threads in awaitImpl, which mustn't have the handle released under them.
+        private int waiterCount;
+
+        private boolean finished;
+        private boolean cancelled;
+        private InetAddress[] addresses;
+        private GaiException failure;
+
+        private Lookup(long handle) {
+            this.handle = handle;
+        }
+
+        public synchronized boolean cancel(boolean mayInterruptIfRunning) {
+            if (finished || !cancelImpl(handle)) {
+                return false;
+            }
+            collect();
+            return true;
+        }
+
+        public synchronized boolean isCancelled() {
+            return cancelled;
+        }
+
+        public synchronized boolean isDone() {
+            collect();
+            return finished;
+        }
+
+        /**
+         * Waits for the answer. The wait can't be interrupted with {@link Thread#interrupt}; use
+         * {@link #cancel} or {@link #await} instead.
+         */
+        public InetAddress[] get() throws InterruptedException, ExecutionException {
+            try {
+                return get(-1);
+            } catch (TimeoutException e) {
+                throw new AssertionError(e);
+            }
+        }
+
+        public InetAddress[] get(long timeout, TimeUnit unit) throws InterruptedException, ExecutionException, TimeoutException {
+            return get((int) Math.max(0, Math.min(unit.toMillis(timeout), Integer.MAX_VALUE)));
+        }
+
+        private InetAddress[] get(int timeoutMs) throws InterruptedException, ExecutionException, TimeoutException {
+            if (Thread.interrupted()) {
+                throw new InterruptedException();
+            }
+            try {
+                return await(null, timeoutMs);
+            } catch (GaiException e) {
+                throw new ExecutionException(e);
+            } catch (SocketException e) {
+                throw new AssertionError(e);
+            }
+        }
+
+        /**
+         * Waits up to {@code timeoutMs} (forever if negative) for the answer, which is returned
+         * as {@link Os#getaddrinfo} would. If {@code fd} is non-null and another thread closes it
+         * with {@link IoBridge#closeSocket}, the lookup is cancelled and this throws a
+         * SocketException, as a thread blocked reading the socket would.
+         *
+         * @throws GaiException if the name couldn't be resolved.
+         * @throws CancellationException if the lookup was cancelled.
+         */
+        public InetAddress[] await(FileDescriptor fd, int timeoutMs) throws SocketException, TimeoutException {
+            long waitHandle;
+            synchronized (this) {
+                collect();
+                waitHandle = finished ? 0 : handle;
+                if (waitHandle != 0) {
+                    ++waiterCount;
+                }
+            }
+            if (waitHandle != 0) {
+                boolean done;
+                try {
+                    done = awaitImpl(waitHandle, fd, timeoutMs);
+                } finally {
+                    synchronized (this) {
+                        --waiterCount;
+                        collect();
+                    }
+                }
+                if (!done) {
+                    throw new TimeoutException();
+                }
+            }
+            return answer();
+        }
+
+        /** Copies the answer out of the native lookup if it's ready, releasing it if we can. */
+        private void collect() {
+            if (!finished && handle != 0 && isDoneImpl(handle)) {
+                try {
+                    addresses = resultImpl(handle);
+                    cancelled = (addresses == null);
+                } catch (GaiException e) {
+                    failure = e;
+                }
+                finished = true;
+            }
+            if (finished && waiterCount == 0 && handle != 0) {
+                releaseImpl(handle);
+                handle = 0;
+            }
+        }
+
+        private synchronized InetAddress[] answer() {
+            if (cancelled) {
+                throw new CancellationException();
+            } else if (failure != null) {
+                throw failure;
+            }
+            return addresses.clone();
+        }
+
+        @Override protected void finalize() throws Throwable {
+            try {
+                synchronized (this) {
+                    if (handle != 0) {
+                        releaseImpl(handle);
+                        handle = 0;
+                    }
+                }
+            } finally {
+                super.finalize();
+            }
+        }
+    }
+
+    private static native long lookupImpl(String node, int flags, int family, int socktype, int protocol);
+    private static native boolean isDoneImpl(long handle);
+    private static native boolean cancelImpl(long handle);
+    private static native boolean awaitImpl(long handle, FileDescriptor fd, int timeoutMs) throws SocketException;
+    private static native InetAddress[] resultImpl(long handle) throws GaiException;
+    private static native void releaseImpl(long handle);
+}
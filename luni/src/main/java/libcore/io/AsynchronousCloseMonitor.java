@@ -19,8 +19,21 @@ package libcore.io;
 import java.io.FileDescriptor;
 
 public final class AsynchronousCloseMonitor {
+    /** Index of the number of blocking calls that have been monitored. */
+    public static final int COUNTER_MONITORS = 0;
+    /** Index of the number of registry lock acquisitions that had to wait for another thread. */
+    public static final int COUNTER_CONTENDED = 1;
+    /** Index of the number of threads woken by {@link #signalBlockedThreads}. */
+    public static final int COUNTER_SIGNALS = 2;
+
     private AsynchronousCloseMonitor() {
     }
 
     public static native void signalBlockedThreads(FileDescriptor fd);
+
+    /**
+     * Returns a snapshot of the blocked-thread registry's cumulative counters, indexed by the
+     * {@code COUNTER_} constants above.
+     */
+    public static native long[] getCounters();
 }
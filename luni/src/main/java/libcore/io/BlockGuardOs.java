@@ -23,6 +23,7 @@ import java.net.InetAddress;
 import java.net.InetSocketAddress;
 import java.net.SocketException;
 import java.nio.ByteBuffer;
+import libcore.util.MutableLong;
 import static libcore.io.OsConstants.*;
 
 /**
@@ -75,6 +76,15 @@ public class BlockGuardOs extends ForwardingOs {
         os.close(fd);
     }
 
+    private boolean isRegularFile(FileDescriptor fd) {
+        try {
+            return S_ISREG(os.fstat(fd).st_mode);
+        } catch (ErrnoException e) {
+            // Let the call itself report the bad fd.
+            return false;
+        }
+    }
+
     private static boolean isLingerSocket(FileDescriptor fd) throws ErrnoException {
         StructLinger linger = Libcore.os.getsockoptLinger(fd, SOL_SOCKET, SO_LINGER);
         return linger.isOn() && linger.l_linger > 0;
@@ -85,8 +95,22 @@ public class BlockGuardOs extends ForwardingOs {
         os.connect(fd, address, port);
     }
 
+    @Override public long copy_file_range(FileDescriptor fdIn, MutableLong inOffset, FileDescriptor fdOut, MutableLong outOffset, long byteCount, int flags) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onReadFromDisk();
+        BlockGuard.getThreadPolicy().onWriteToDisk();
+        return os.copy_file_range(fdIn, inOffset, fdOut, outOffset, byteCount, flags);
+    }
+
     // TODO: Untag newFd when needed for dup2(FileDescriptor oldFd, int newFd)
 
+    @Override public int epoll_wait(FileDescriptor epfd, ByteBuffer events, int timeoutMs) throws ErrnoException {
+        // As with poll, a zero timeout returns immediately and shouldn't be subject to BlockGuard.
+        if (timeoutMs != 0) {
+            BlockGuard.getThreadPolicy().onNetwork();
+        }
+        return os.epoll_wait(epfd, events, timeoutMs);
+    }
+
     @Override public void fdatasync(FileDescriptor fd) throws ErrnoException {
         BlockGuard.getThreadPolicy().onWriteToDisk();
         os.fdatasync(fd);
@@ -129,6 +153,21 @@ public class BlockGuardOs extends ForwardingOs {
         return os.pread(fd, bytes, byteOffset, byteCount, offset);
     }
 
+    @Override public int pread(FileDescriptor fd, long address, int byteCount, long offset) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onReadFromDisk();
+        return os.pread(fd, address, byteCount, offset);
+    }
+
+    @Override public int preadv(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts, long offset) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onReadFromDisk();
+        return os.preadv(fd, buffers, offsets, byteCounts, offset);
+    }
+
+    @Override public int preadv(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onReadFromDisk();
+        return os.preadv(fd, addresses, byteCounts, offset);
+    }
+
     @Override public int pwrite(FileDescriptor fd, ByteBuffer buffer, long offset) throws ErrnoException {
         BlockGuard.getThreadPolicy().onWriteToDisk();
         return os.pwrite(fd, buffer, offset);
@@ -139,6 +178,21 @@ public class BlockGuardOs extends ForwardingOs {
         return os.pwrite(fd, bytes, byteOffset, byteCount, offset);
     }
 
+    @Override public int pwrite(FileDescriptor fd, long address, int byteCount, long offset) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onWriteToDisk();
+        return os.pwrite(fd, address, byteCount, offset);
+    }
+
+    @Override public int pwritev(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts, long offset) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onWriteToDisk();
+        return os.pwritev(fd, buffers, offsets, byteCounts, offset);
+    }
+
+    @Override public int pwritev(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onWriteToDisk();
+        return os.pwritev(fd, addresses, byteCounts, offset);
+    }
+
     @Override public int read(FileDescriptor fd, ByteBuffer buffer) throws ErrnoException {
         BlockGuard.getThreadPolicy().onReadFromDisk();
         return os.read(fd, buffer);
@@ -149,11 +203,26 @@ public class BlockGuardOs extends ForwardingOs {
         return os.read(fd, bytes, byteOffset, byteCount);
     }
 
+    @Override public int read(FileDescriptor fd, long address, int byteCount) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onReadFromDisk();
+        return os.read(fd, address, byteCount);
+    }
+
+    @Override public void readahead(FileDescriptor fd, long offset, long byteCount) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onReadFromDisk();
+        os.readahead(fd, offset, byteCount);
+    }
+
     @Override public int readv(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts) throws ErrnoException {
         BlockGuard.getThreadPolicy().onReadFromDisk();
         return os.readv(fd, buffers, offsets, byteCounts);
     }
 
+    @Override public int readv(FileDescriptor fd, long[] addresses, int[] byteCounts) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onReadFromDisk();
+        return os.readv(fd, addresses, byteCounts);
+    }
+
     @Override public int recvfrom(FileDescriptor fd, ByteBuffer buffer, int flags, InetSocketAddress srcAddress) throws ErrnoException, SocketException {
         BlockGuard.getThreadPolicy().onNetwork();
         return os.recvfrom(fd, buffer, flags, srcAddress);
@@ -164,6 +233,19 @@ public class BlockGuardOs extends ForwardingOs {
         return os.recvfrom(fd, bytes, byteOffset, byteCount, flags, srcAddress);
     }
 
+    @Override public int recvmmsg(FileDescriptor fd, byte[] bytes, int byteOffset, int slotByteCount, int messageCount, int flags, InetSocketAddress[] srcAddresses, int[] results) throws ErrnoException, SocketException {
+        BlockGuard.getThreadPolicy().onNetwork();
+        return os.recvmmsg(fd, bytes, byteOffset, slotByteCount, messageCount, flags, srcAddresses, results);
+    }
+
+    @Override public int sendmmsg(FileDescriptor fd, byte[] bytes, int[] byteOffsets, int[] byteCounts, int messageCount, int flags, InetAddress[] inetAddresses, int[] ports) throws ErrnoException, SocketException {
+        // As with sendto, we permit datagrams without hostname lookups.
+        if (inetAddresses != null) {
+            BlockGuard.getThreadPolicy().onNetwork();
+        }
+        return os.sendmmsg(fd, bytes, byteOffsets, byteCounts, messageCount, flags, inetAddresses, ports);
+    }
+
     @Override public int sendto(FileDescriptor fd, ByteBuffer buffer, int flags, InetAddress inetAddress, int port) throws ErrnoException, SocketException {
         BlockGuard.getThreadPolicy().onNetwork();
         return os.sendto(fd, buffer, flags, inetAddress, port);
@@ -187,6 +269,17 @@ public class BlockGuardOs extends ForwardingOs {
         tagSocket(fd2);
     }
 
+    @Override public long splice(FileDescriptor fdIn, MutableLong inOffset, FileDescriptor fdOut, MutableLong outOffset, long byteCount, int flags) throws ErrnoException, SocketException {
+        // One end is a pipe. Only the other end, if it's a regular file, touches the disk.
+        if (isRegularFile(fdIn)) {
+            BlockGuard.getThreadPolicy().onReadFromDisk();
+        }
+        if (isRegularFile(fdOut)) {
+            BlockGuard.getThreadPolicy().onWriteToDisk();
+        }
+        return os.splice(fdIn, inOffset, fdOut, outOffset, byteCount, flags);
+    }
+
     @Override public int write(FileDescriptor fd, ByteBuffer buffer) throws ErrnoException {
         BlockGuard.getThreadPolicy().onWriteToDisk();
         return os.write(fd, buffer);
@@ -197,8 +290,18 @@ public class BlockGuardOs extends ForwardingOs {
         return os.write(fd, bytes, byteOffset, byteCount);
     }
 
+    @Override public int write(FileDescriptor fd, long address, int byteCount) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onWriteToDisk();
+        return os.write(fd, address, byteCount);
+    }
+
     @Override public int writev(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts) throws ErrnoException {
         BlockGuard.getThreadPolicy().onWriteToDisk();
         return os.writev(fd, buffers, offsets, byteCounts);
     }
+
+    @Override public int writev(FileDescriptor fd, long[] addresses, int[] byteCounts) throws ErrnoException {
+        BlockGuard.getThreadPolicy().onWriteToDisk();
+        return os.writev(fd, addresses, byteCounts);
+    }
 }
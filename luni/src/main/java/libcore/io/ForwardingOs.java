@@ -42,9 +42,13 @@ public class ForwardingOs implements Os {
     public void chown(String path, int uid, int gid) throws ErrnoException { os.chown(path, uid, gid); }
     public void close(FileDescriptor fd) throws ErrnoException { os.close(fd); }
     public void connect(FileDescriptor fd, InetAddress address, int port) throws ErrnoException, SocketException { os.connect(fd, address, port); }
+    public long copy_file_range(FileDescriptor fdIn, MutableLong inOffset, FileDescriptor fdOut, MutableLong outOffset, long byteCount, int flags) throws ErrnoException { return os.copy_file_range(fdIn, inOffset, fdOut, outOffset, byteCount, flags); }
     public FileDescriptor dup(FileDescriptor oldFd) throws ErrnoException { return os.dup(oldFd); }
     public FileDescriptor dup2(FileDescriptor oldFd, int newFd) throws ErrnoException { return os.dup2(oldFd, newFd); }
     public String[] environ() { return os.environ(); }
+    public FileDescriptor epoll_create(int flags) throws ErrnoException { return os.epoll_create(flags); }
+    public void epoll_ctl(FileDescriptor epfd, int op, FileDescriptor fd, int events, long data) throws ErrnoException { os.epoll_ctl(epfd, op, fd, events, data); }
+    public int epoll_wait(FileDescriptor epfd, ByteBuffer events, int timeoutMs) throws ErrnoException { return os.epoll_wait(epfd, events, timeoutMs); }
     public void execv(String filename, String[] argv) throws ErrnoException { os.execv(filename, argv); }
     public void execve(String filename, String[] argv, String[] envp) throws ErrnoException { os.execve(filename, argv, envp); }
     public void fchmod(FileDescriptor fd, int mode) throws ErrnoException { os.fchmod(fd, mode); }
@@ -88,6 +92,7 @@ public class ForwardingOs implements Os {
     public void listen(FileDescriptor fd, int backlog) throws ErrnoException { os.listen(fd, backlog); }
     public long lseek(FileDescriptor fd, long offset, int whence) throws ErrnoException { return os.lseek(fd, offset, whence); }
     public StructStat lstat(String path) throws ErrnoException { return os.lstat(path); }
+    public void madvise(long address, long byteCount, int advice) throws ErrnoException { os.madvise(address, byteCount, advice); }
     public void mincore(long address, long byteCount, byte[] vector) throws ErrnoException { os.mincore(address, byteCount, vector); }
     public void mkdir(String path, int mode) throws ErrnoException { os.mkdir(path, mode); }
     public void mlock(long address, long byteCount) throws ErrnoException { os.mlock(address, byteCount); }
@@ -98,17 +103,29 @@ public class ForwardingOs implements Os {
     public FileDescriptor open(String path, int flags, int mode) throws ErrnoException { return os.open(path, flags, mode); }
     public FileDescriptor[] pipe() throws ErrnoException { return os.pipe(); }
     public int poll(StructPollfd[] fds, int timeoutMs) throws ErrnoException { return os.poll(fds, timeoutMs); }
+    public void posix_fadvise(FileDescriptor fd, long offset, long length, int advice) throws ErrnoException { os.posix_fadvise(fd, offset, length, advice); }
     public int pread(FileDescriptor fd, ByteBuffer buffer, long offset) throws ErrnoException { return os.pread(fd, buffer, offset); }
     public int pread(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount, long offset) throws ErrnoException { return os.pread(fd, bytes, byteOffset, byteCount, offset); }
+    public int pread(FileDescriptor fd, long address, int byteCount, long offset) throws ErrnoException { return os.pread(fd, address, byteCount, offset); }
+    public int preadv(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts, long offset) throws ErrnoException { return os.preadv(fd, buffers, offsets, byteCounts, offset); }
+    public int preadv(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset) throws ErrnoException { return os.preadv(fd, addresses, byteCounts, offset); }
     public int pwrite(FileDescriptor fd, ByteBuffer buffer, long offset) throws ErrnoException { return os.pwrite(fd, buffer, offset); }
     public int pwrite(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount, long offset) throws ErrnoException { return os.pwrite(fd, bytes, byteOffset, byteCount, offset); }
+    public int pwrite(FileDescriptor fd, long address, int byteCount, long offset) throws ErrnoException { return os.pwrite(fd, address, byteCount, offset); }
+    public int pwritev(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts, long offset) throws ErrnoException { return os.pwritev(fd, buffers, offsets, byteCounts, offset); }
+    public int pwritev(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset) throws ErrnoException { return os.pwritev(fd, addresses, byteCounts, offset); }
     public int read(FileDescriptor fd, ByteBuffer buffer) throws ErrnoException { return os.read(fd, buffer); }
     public int read(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount) throws ErrnoException { return os.read(fd, bytes, byteOffset, byteCount); }
+    public int read(FileDescriptor fd, long address, int byteCount) throws ErrnoException { return os.read(fd, address, byteCount); }
+    public void readahead(FileDescriptor fd, long offset, long byteCount) throws ErrnoException { os.readahead(fd, offset, byteCount); }
     public int readv(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts) throws ErrnoException { return os.readv(fd, buffers, offsets, byteCounts); }
+    public int readv(FileDescriptor fd, long[] addresses, int[] byteCounts) throws ErrnoException { return os.readv(fd, addresses, byteCounts); }
     public int recvfrom(FileDescriptor fd, ByteBuffer buffer, int flags, InetSocketAddress srcAddress) throws ErrnoException, SocketException { return os.recvfrom(fd, buffer, flags, srcAddress); }
     public int recvfrom(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount, int flags, InetSocketAddress srcAddress) throws ErrnoException, SocketException { return os.recvfrom(fd, bytes, byteOffset, byteCount, flags, srcAddress); }
+    public int recvmmsg(FileDescriptor fd, byte[] bytes, int byteOffset, int slotByteCount, int messageCount, int flags, InetSocketAddress[] srcAddresses, int[] results) throws ErrnoException, SocketException { return os.recvmmsg(fd, bytes, byteOffset, slotByteCount, messageCount, flags, srcAddresses, results); }
     public void remove(String path) throws ErrnoException { os.remove(path); }
     public void rename(String oldPath, String newPath) throws ErrnoException { os.rename(oldPath, newPath); }
+    public int sendmmsg(FileDescriptor fd, byte[] bytes, int[] byteOffsets, int[] byteCounts, int messageCount, int flags, InetAddress[] inetAddresses, int[] ports) throws ErrnoException, SocketException { return os.sendmmsg(fd, bytes, byteOffsets, byteCounts, messageCount, flags, inetAddresses, ports); }
     public long sendfile(FileDescriptor outFd, FileDescriptor inFd, MutableLong inOffset, long byteCount) throws ErrnoException { return os.sendfile(outFd, inFd, inOffset, byteCount); }
     public int sendto(FileDescriptor fd, ByteBuffer buffer, int flags, InetAddress inetAddress, int port) throws ErrnoException, SocketException { return os.sendto(fd, buffer, flags, inetAddress, port); }
     public int sendto(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount, int flags, InetAddress inetAddress, int port) throws ErrnoException, SocketException { return os.sendto(fd, bytes, byteOffset, byteCount, flags, inetAddress, port); }
@@ -128,7 +145,9 @@ public class ForwardingOs implements Os {
     public void shutdown(FileDescriptor fd, int how) throws ErrnoException { os.shutdown(fd, how); }
     public FileDescriptor socket(int domain, int type, int protocol) throws ErrnoException { return os.socket(domain, type, protocol); }
     public void socketpair(int domain, int type, int protocol, FileDescriptor fd1, FileDescriptor fd2) throws ErrnoException { os.socketpair(domain, type, protocol, fd1, fd2); }
+    public long splice(FileDescriptor fdIn, MutableLong inOffset, FileDescriptor fdOut, MutableLong outOffset, long byteCount, int flags) throws ErrnoException, SocketException { return os.splice(fdIn, inOffset, fdOut, outOffset, byteCount, flags); }
     public StructStat stat(String path) throws ErrnoException { return os.stat(path); }
+    public int stat(FileDescriptor dirFd, String[] paths, boolean followLinks, int fields, long[] values, int[] errnos) { return os.stat(dirFd, paths, followLinks, fields, values, errnos); }
     public StructStatVfs statvfs(String path) throws ErrnoException { return os.statvfs(path); }
     public String strerror(int errno) { return os.strerror(errno); }
     public String strsignal(int signal) { return os.strsignal(signal); }
@@ -136,11 +155,14 @@ public class ForwardingOs implements Os {
     public long sysconf(int name) { return os.sysconf(name); }
     public void tcdrain(FileDescriptor fd) throws ErrnoException { os.tcdrain(fd); }
     public void tcsendbreak(FileDescriptor fd, int duration) throws ErrnoException { os.tcsendbreak(fd, duration); }
+    public long tee(FileDescriptor fdIn, FileDescriptor fdOut, long byteCount, int flags) throws ErrnoException { return os.tee(fdIn, fdOut, byteCount, flags); }
     public int umask(int mask) { return os.umask(mask); }
     public StructUtsname uname() { return os.uname(); }
     public void unsetenv(String name) throws ErrnoException { os.unsetenv(name); }
     public int waitpid(int pid, MutableInt status, int options) throws ErrnoException { return os.waitpid(pid, status, options); }
     public int write(FileDescriptor fd, ByteBuffer buffer) throws ErrnoException { return os.write(fd, buffer); }
     public int write(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount) throws ErrnoException { return os.write(fd, bytes, byteOffset, byteCount); }
+    public int write(FileDescriptor fd, long address, int byteCount) throws ErrnoException { return os.write(fd, address, byteCount); }
     public int writev(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts) throws ErrnoException { return os.writev(fd, buffers, offsets, byteCounts); }
+    public int writev(FileDescriptor fd, long[] addresses, int[] byteCounts) throws ErrnoException { return os.writev(fd, addresses, byteCounts); }
 }
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+import dalvik.system.CloseGuard;
+import java.io.Closeable;
+import java.io.FileDescriptor;
+import java.net.InetAddress;
+
+/**
+ * An asynchronous I/O engine built on Linux's io_uring. Operations are queued with the
+ * {@code prepare} methods, handed to the kernel in a batch by {@link #submit}, and their results
+ * collected in a batch by {@link #harvest}. Each operation carries a caller-chosen {@code long}
+ * that's reported back with its result, which is the return value of the equivalent system call
+ * or a negated errno value.
+ *
+ * <p>Because the kernel accesses memory after the preparing call returns, buffers are passed as
+ * native addresses (see {@link java.nio.NioUtils#unsafeAddress}) and must stay valid until the
+ * operation's result has been harvested.
+ *
+ * <p>If another thread closes a file descriptor with operations in flight, a thread blocked in
+ * {@link #submit} wakes up and cancels them, and they complete with {@code -ECANCELED}.
+ *
+ * <p>Not thread-safe. Throws an ErrnoException with {@code ENOSYS} on kernels without io_uring.
+ *
+ * @hide
+ */
+public final class IoUring implements Closeable {
+    private final CloseGuard guard = CloseGuard.get();
+
+    private long ringHandle;
+
+    /**
+     * Creates a ring with room for at least {@code entries} queued operations. At most that many
+     * operations can be in flight at once; beyond that, the {@code prepare} methods throw an
+     * ErrnoException with {@code EBUSY} until results are harvested.
+     */
+    public IoUring(int entries) throws ErrnoException {
+        ringHandle = create(entries);
+        guard.open("close");
+    }
+
+    /**
+     * Queues a read of up to {@code byteCount} bytes into the native memory at {@code address}.
+     * {@code offset} is the file position to read from; use 0 for sockets and pipes.
+     */
+    public void prepareRead(FileDescriptor fd, long address, int byteCount, long offset, long userData) throws ErrnoException {
+        prepareReadImpl(checkOpen(), fd, address, byteCount, offset, userData);
+    }
+
+    /** Queues a write of {@code byteCount} bytes from the native memory at {@code address}. */
+    public void prepareWrite(FileDescriptor fd, long address, int byteCount, long offset, long userData) throws ErrnoException {
+        prepareWriteImpl(checkOpen(), fd, address, byteCount, offset, userData);
+    }
+
+    /** Queues a scattering read into the given native buffers. */
+    public void prepareReadv(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset, long userData) throws ErrnoException {
+        checkVector(addresses, byteCounts);
+        prepareReadvImpl(checkOpen(), fd, addresses, byteCounts, offset, userData);
+    }
+
+    /** Queues a gathering write from the given native buffers. */
+    public void prepareWritev(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset, long userData) throws ErrnoException {
+        checkVector(addresses, byteCounts);
+        prepareWritevImpl(checkOpen(), fd, addresses, byteCounts, offset, userData);
+    }
+
+    /** Queues an accept on a listening socket. The result is the accepted socket's fd. */
+    public void prepareAccept(FileDescriptor fd, long userData) throws ErrnoException {
+        prepareAcceptImpl(checkOpen(), fd, userData);
+    }
+
+    /** Queues a connect of the socket {@code fd} to {@code address} and {@code port}. */
+    public void prepareConnect(FileDescriptor fd, InetAddress address, int port, long userData) throws ErrnoException {
+        prepareConnectImpl(checkOpen(), fd, address, port, userData);
+    }
+
+    /** Queues an {@code fsync}, or an {@code fdatasync} if {@code dataOnly} is true. */
+    public void prepareFsync(FileDescriptor fd, boolean dataOnly, long userData) throws ErrnoException {
+        prepareFsyncImpl(checkOpen(), fd, dataOnly, userData);
+    }
+
+    /**
+     * Queues a cancellation of the in-flight operation with the given {@code userData}. Returns
+     * false if there's no such operation. A cancelled operation still reports a result, usually
+     * {@code -ECANCELED}.
+     */
+    public boolean cancel(long userData) throws ErrnoException {
+        return cancelImpl(checkOpen(), userData);
+    }
+
+    /**
+     * Hands all queued operations to the kernel and, if {@code minCompletions} is positive, waits
+     * until at least that many results are available. Returns the number of operations
+     * submitted. The wait ends early if operations are cancelled because their file descriptor
+     * was closed.
+     */
+    public int submit(int minCompletions) throws ErrnoException {
+        return submitImpl(checkOpen(), minCompletions);
+    }
+
+    /**
+     * Copies available results into {@code userData} and {@code results} without blocking,
+     * returning the number copied.
+     */
+    public int harvest(long[] userData, int[] results) {
+        return harvestImpl(checkOpen(), userData, results);
+    }
+
+    /**
+     * Releases the ring. The kernel cancels any operations still in flight.
+     */
+    @Override public synchronized void close() {
+        guard.close();
+        if (ringHandle != 0) {
+            destroy(ringHandle);
+            ringHandle = 0;
+        }
+    }
+
+    @Override protected void finalize() throws Throwable {
+        try {
+            if (guard != null) {
+                guard.warnIfOpen();
+            }
+            close();
+        } finally {
+            super.finalize();
+        }
+    }
+
+    private long checkOpen() {
+        if (ringHandle == 0) {
+            throw new IllegalStateException("IoUring was closed");
+        }
+        return ringHandle;
+    }
+
+    private static void checkVector(long[] addresses, int[] byteCounts) {
+        if (addresses.length != byteCounts.length) {
+            throw new IllegalArgumentException("addresses.length=" + addresses.length + " byteCounts.length=" + byteCounts.length);
+        }
+    }
+
+    private static native long create(int entries) throws ErrnoException;
+    private static native void destroy(long ringHandle);
+    private static native void prepareReadImpl(long ringHandle, FileDescriptor fd, long address, int byteCount, long offset, long userData) throws ErrnoException;
+    private static native void prepareWriteImpl(long ringHandle, FileDescriptor fd, long address, int byteCount, long offset, long userData) throws ErrnoException;
+    private static native void prepareReadvImpl(long ringHandle, FileDescriptor fd, long[] addresses, int[] byteCounts, long offset, long userData) throws ErrnoException;
+    private static native void prepareWritevImpl(long ringHandle, FileDescriptor fd, long[] addresses, int[] byteCounts, long offset, long userData) throws ErrnoException;
+    private static native void prepareAcceptImpl(long ringHandle, FileDescriptor fd, long userData) throws ErrnoException;
+    private static native void prepareConnectImpl(long ringHandle, FileDescriptor fd, InetAddress address, int port, long userData) throws ErrnoException;
+    private static native void prepareFsyncImpl(long ringHandle, FileDescriptor fd, boolean dataOnly, long userData) throws ErrnoException;
+    private static native boolean cancelImpl(long ringHandle, long userData) throws ErrnoException;
+    private static native int submitImpl(long ringHandle, int minCompletions) throws ErrnoException;
+    private static native int harvestImpl(long ringHandle, long[] userData, int[] results);
+}
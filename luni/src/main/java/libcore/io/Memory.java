@@ -175,4 +175,12 @@ public final class Memory {
     public static native void pokeIntArray(long address, int[] src, int offset, int count, boolean swap);
     public static native void pokeLongArray(long address, long[] src, int offset, int count, boolean swap);
     public static native void pokeShortArray(long address, short[] src, int offset, int count, boolean swap);
+
+    /**
+     * Faults in the pages of the mapping at {@code address} that the {@code byteCount} bytes
+     * there fall in, so later reads don't take page faults. Blocks until any file data has been
+     * read in. Where the kernel can't do this for us, we read a byte from each page, which
+     * raises SIGBUS if part of the range is beyond the end of a truncated file.
+     */
+    public static native void prefault(long address, long byteCount) throws ErrnoException;
 }
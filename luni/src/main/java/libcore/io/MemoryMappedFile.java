@@ -33,6 +33,9 @@ import static libcore.io.OsConstants.*;
  * {@link BufferIterator} over the mapped data.
  */
 public final class MemoryMappedFile implements AutoCloseable {
+    // prefault splits the mapping between threads at multiples of this.
+    private static final long PREFAULT_ALIGNMENT = 1024 * 1024;
+
     private long address;
     private final long size;
 
@@ -70,6 +73,90 @@ public final class MemoryMappedFile implements AutoCloseable {
         }
     }
 
+    /**
+     * Passes {@code advice}, one of the {@code MADV_} constants, to madvise(2) for the whole
+     * mapping. {@code MADV_SEQUENTIAL} or {@code MADV_RANDOM} tune readahead to the expected
+     * access pattern, and {@code MADV_HUGEPAGE} asks for the mapping to be backed by huge pages
+     * where the kernel supports that for this kind of file.
+     */
+    public synchronized void advise(int advice) throws ErrnoException {
+        checkNotClosed();
+        Libcore.os.madvise(address, size, advice);
+    }
+
+    /**
+     * Faults in the whole mapping using {@code threadCount} threads, the calling thread among
+     * them, each taking a contiguous share, and returns when they're all done. Call this from a
+     * background thread to warm the mapping before it's needed. The mapping can't be closed
+     * until this returns.
+     */
+    public synchronized void prefault(int threadCount) throws ErrnoException {
+        if (threadCount < 1) {
+            throw new IllegalArgumentException("threadCount < 1: " + threadCount);
+        }
+        checkNotClosed();
+        // Split at megabyte boundaries so that no two threads fault in the same page, and small
+        // files don't get more threads than they can use.
+        long chunkSize = (size / threadCount + PREFAULT_ALIGNMENT - 1) & -PREFAULT_ALIGNMENT;
+        if (chunkSize == 0 || chunkSize >= size) {
+            Memory.prefault(address, size);
+            return;
+        }
+        final ErrnoException[] failure = new ErrnoException[1];
+        Thread[] threads = new Thread[(int) ((size - 1) / chunkSize)];
+        for (int i = 0; i < threads.length; ++i) {
+            final long chunkAddress = address + (i + 1) * chunkSize;
+            final long chunkByteCount = Math.min(chunkSize, size - (i + 1) * chunkSize);
+            threads[i] = new Thread("MemoryMappedFile prefault") {
+                @Override public void run() {
+                    try {
+                        Memory.prefault(chunkAddress, chunkByteCount);
+                    } catch (ErrnoException e) {
+                        synchronized (failure) {
+                            failure[0] = e;
+                        }
+                    }
+                }
+            };
+            threads[i].start();
+        }
+        ErrnoException callerFailure = null;
+        try {
+            Memory.prefault(address, chunkSize);
+        } catch (ErrnoException e) {
+            callerFailure = e;
+        }
+        // The threads must finish before we give up the lock and let someone unmap the file.
+        boolean interrupted = false;
+        for (Thread thread : threads) {
+            while (true) {
+                try {
+                    thread.join();
+                    break;
+                } catch (InterruptedException e) {
+                    interrupted = true;
+                }
+            }
+        }
+        if (interrupted) {
+            Thread.currentThread().interrupt();
+        }
+        if (callerFailure != null) {
+            throw callerFailure;
+        }
+        synchronized (failure) {
+            if (failure[0] != null) {
+                throw failure[0];
+            }
+        }
+    }
+
+    private void checkNotClosed() {
+        if (address == 0) {
+            throw new IllegalStateException("MemoryMappedFile has been closed");
+        }
+    }
+
     /**
      * Returns a new iterator that treats the mapped data as big-endian.
      */
@@ -33,9 +33,19 @@ public interface Os {
     public void chown(String path, int uid, int gid) throws ErrnoException;
     public void close(FileDescriptor fd) throws ErrnoException;
     public void connect(FileDescriptor fd, InetAddress address, int port) throws ErrnoException, SocketException;
+    public long copy_file_range(FileDescriptor fdIn, MutableLong inOffset, FileDescriptor fdOut, MutableLong outOffset, long byteCount, int flags) throws ErrnoException;
     public FileDescriptor dup(FileDescriptor oldFd) throws ErrnoException;
     public FileDescriptor dup2(FileDescriptor oldFd, int newFd) throws ErrnoException;
     public String[] environ();
+    public FileDescriptor epoll_create(int flags) throws ErrnoException;
+    public void epoll_ctl(FileDescriptor epfd, int op, FileDescriptor fd, int events, long data) throws ErrnoException;
+    /**
+     * Waits for events on {@code epfd}, writing one {@link SizeOf#EPOLL_EVENT}-byte record per
+     * ready fd starting at the buffer's position: the native-order int event mask at offset 0
+     * and the native-order long data passed to {@link #epoll_ctl} at offset 8. The buffer's
+     * position is not changed. Returns the number of records written.
+     */
+    public int epoll_wait(FileDescriptor epfd, ByteBuffer events, int timeoutMs) throws ErrnoException;
     public void execv(String filename, String[] argv) throws ErrnoException;
     public void execve(String filename, String[] argv, String[] envp) throws ErrnoException;
     public void fchmod(FileDescriptor fd, int mode) throws ErrnoException;
@@ -80,6 +90,8 @@ public interface Os {
     public void listen(FileDescriptor fd, int backlog) throws ErrnoException;
     public long lseek(FileDescriptor fd, long offset, int whence) throws ErrnoException;
     public StructStat lstat(String path) throws ErrnoException;
+    /** Like {@code madvise(2)}; {@code advice} is one of the {@code MADV_} constants. */
+    public void madvise(long address, long byteCount, int advice) throws ErrnoException;
     public void mincore(long address, long byteCount, byte[] vector) throws ErrnoException;
     public void mkdir(String path, int mode) throws ErrnoException;
     public void mlock(long address, long byteCount) throws ErrnoException;
@@ -91,19 +103,55 @@ public interface Os {
     public FileDescriptor[] pipe() throws ErrnoException;
     /* TODO: if we used the non-standard ppoll(2) behind the scenes, we could take a long timeout. */
     public int poll(StructPollfd[] fds, int timeoutMs) throws ErrnoException;
+    /** Like {@code posix_fadvise(2)}; {@code advice} is one of the {@code POSIX_FADV_} constants. */
+    public void posix_fadvise(FileDescriptor fd, long offset, long length, int advice) throws ErrnoException;
     public int pread(FileDescriptor fd, ByteBuffer buffer, long offset) throws ErrnoException;
     public int pread(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount, long offset) throws ErrnoException;
+    /** Like {@code pread(2)}, reading directly to the native memory at {@code address}. */
+    public int pread(FileDescriptor fd, long address, int byteCount, long offset) throws ErrnoException;
+    public int preadv(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts, long offset) throws ErrnoException;
+    /** Like {@code preadv(2)}, reading into the native memory at each of {@code addresses}. */
+    public int preadv(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset) throws ErrnoException;
     public int pwrite(FileDescriptor fd, ByteBuffer buffer, long offset) throws ErrnoException;
     public int pwrite(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount, long offset) throws ErrnoException;
+    /** Like {@code pwrite(2)}, writing directly from the native memory at {@code address}. */
+    public int pwrite(FileDescriptor fd, long address, int byteCount, long offset) throws ErrnoException;
+    public int pwritev(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts, long offset) throws ErrnoException;
+    /** Like {@code pwritev(2)}, writing from the native memory at each of {@code addresses}. */
+    public int pwritev(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset) throws ErrnoException;
     public int read(FileDescriptor fd, ByteBuffer buffer) throws ErrnoException;
     public int read(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount) throws ErrnoException;
+    /** Like {@code read(2)}, reading directly to the native memory at {@code address}. */
+    public int read(FileDescriptor fd, long address, int byteCount) throws ErrnoException;
+    /** Like Linux's {@code readahead(2)}: starts reading the given range into the page cache. */
+    public void readahead(FileDescriptor fd, long offset, long byteCount) throws ErrnoException;
     public int readv(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts) throws ErrnoException;
+    /** Like {@code readv(2)}, reading into the native memory at each of {@code addresses}. */
+    public int readv(FileDescriptor fd, long[] addresses, int[] byteCounts) throws ErrnoException;
     public int recvfrom(FileDescriptor fd, ByteBuffer buffer, int flags, InetSocketAddress srcAddress) throws ErrnoException, SocketException;
     public int recvfrom(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount, int flags, InetSocketAddress srcAddress) throws ErrnoException, SocketException;
+    /**
+     * Receives up to {@code messageCount} datagrams in one call. Datagram {@code i} is written to
+     * the {@code slotByteCount} bytes starting at {@code byteOffset + i * slotByteCount}, its
+     * sender (if {@code srcAddresses} is non-null) to {@code srcAddresses[i]}, its length to
+     * {@code results[2 * i]} and its {@code MSG_} flags (such as {@code MSG_TRUNC}) to
+     * {@code results[2 * i + 1]}. Returns the number of datagrams received.
+     *
+     * <p>On a blocking socket, this waits until all {@code messageCount} datagrams have arrived
+     * unless {@code flags} includes {@code MSG_WAITFORONE}, which makes it return as soon as it
+     * has at least one.
+     */
+    public int recvmmsg(FileDescriptor fd, byte[] bytes, int byteOffset, int slotByteCount, int messageCount, int flags, InetSocketAddress[] srcAddresses, int[] results) throws ErrnoException, SocketException;
     public void remove(String path) throws ErrnoException;
     public void rename(String oldPath, String newPath) throws ErrnoException;
     public int sendto(FileDescriptor fd, ByteBuffer buffer, int flags, InetAddress inetAddress, int port) throws ErrnoException, SocketException;
     public int sendto(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount, int flags, InetAddress inetAddress, int port) throws ErrnoException, SocketException;
+    /**
+     * Sends up to {@code messageCount} datagrams in one call, datagram {@code i} being the
+     * {@code byteCounts[i]} bytes at {@code byteOffsets[i]}. If {@code inetAddresses} is null the
+     * socket must be connected. Returns the number of datagrams sent.
+     */
+    public int sendmmsg(FileDescriptor fd, byte[] bytes, int[] byteOffsets, int[] byteCounts, int messageCount, int flags, InetAddress[] inetAddresses, int[] ports) throws ErrnoException, SocketException;
     public long sendfile(FileDescriptor outFd, FileDescriptor inFd, MutableLong inOffset, long byteCount) throws ErrnoException;
     public void setegid(int egid) throws ErrnoException;
     public void setenv(String name, String value, boolean overwrite) throws ErrnoException;
@@ -121,7 +169,17 @@ public interface Os {
     public void shutdown(FileDescriptor fd, int how) throws ErrnoException;
     public FileDescriptor socket(int domain, int type, int protocol) throws ErrnoException;
     public void socketpair(int domain, int type, int protocol, FileDescriptor fd1, FileDescriptor fd2) throws ErrnoException;
+    /** At least one of {@code fdIn} and {@code fdOut} must be a pipe. See {@link SplicePipe}. */
+    public long splice(FileDescriptor fdIn, MutableLong inOffset, FileDescriptor fdOut, MutableLong outOffset, long byteCount, int flags) throws ErrnoException, SocketException;
     public StructStat stat(String path) throws ErrnoException;
+    /**
+     * Stats each of {@code paths}, relative to {@code dirFd} (or the current directory if null)
+     * as fstatat(2) would. For each path, writes {@code Integer.bitCount(fields)} longs to
+     * {@code values} -- the {@code StructStat.FIELD_*} fields selected by {@code fields}, in bit
+     * order, or zeros on failure -- and 0 or the failure's errno to {@code errnos}. Returns the
+     * number of paths successfully stat'ed.
+     */
+    public int stat(FileDescriptor dirFd, String[] paths, boolean followLinks, int fields, long[] values, int[] errnos);
     public StructStatVfs statvfs(String path) throws ErrnoException;
     public String strerror(int errno);
     public String strsignal(int signal);
@@ -129,11 +187,16 @@ public interface Os {
     public long sysconf(int name);
     public void tcdrain(FileDescriptor fd) throws ErrnoException;
     public void tcsendbreak(FileDescriptor fd, int duration) throws ErrnoException;
+    public long tee(FileDescriptor fdIn, FileDescriptor fdOut, long byteCount, int flags) throws ErrnoException;
     public int umask(int mask);
     public StructUtsname uname();
     public void unsetenv(String name) throws ErrnoException;
     public int waitpid(int pid, MutableInt status, int options) throws ErrnoException;
     public int write(FileDescriptor fd, ByteBuffer buffer) throws ErrnoException;
     public int write(FileDescriptor fd, byte[] bytes, int byteOffset, int byteCount) throws ErrnoException;
+    /** Like {@code write(2)}, writing directly from the native memory at {@code address}. */
+    public int write(FileDescriptor fd, long address, int byteCount) throws ErrnoException;
     public int writev(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts) throws ErrnoException;
+    /** Like {@code writev(2)}, writing from the native memory at each of {@code addresses}. */
+    public int writev(FileDescriptor fd, long[] addresses, int[] byteCounts) throws ErrnoException;
 }
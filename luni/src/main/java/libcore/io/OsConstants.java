@@ -160,6 +160,18 @@ public final class OsConstants {
     public static final int EOVERFLOW = placeholder();
     public static final int EPERM = placeholder();
     public static final int EPIPE = placeholder();
+    public static final int EPOLLERR = placeholder();
+    public static final int EPOLLET = placeholder();
+    public static final int EPOLLHUP = placeholder();
+    public static final int EPOLLIN = placeholder();
+    public static final int EPOLLONESHOT = placeholder();
+    public static final int EPOLLOUT = placeholder();
+    public static final int EPOLLPRI = placeholder();
+    public static final int EPOLLRDHUP = placeholder();
+    public static final int EPOLL_CLOEXEC = placeholder();
+    public static final int EPOLL_CTL_ADD = placeholder();
+    public static final int EPOLL_CTL_DEL = placeholder();
+    public static final int EPOLL_CTL_MOD = placeholder();
     public static final int EPROTO = placeholder();
     public static final int EPROTONOSUPPORT = placeholder();
     public static final int EPROTOTYPE = placeholder();
@@ -235,7 +247,16 @@ public final class OsConstants {
     public static final int IP_MULTICAST_TTL = placeholder();
     public static final int IP_TOS = placeholder();
     public static final int IP_TTL = placeholder();
+    public static final int MADV_DONTNEED = placeholder();
+    public static final int MADV_HUGEPAGE = placeholder();
+    public static final int MADV_NOHUGEPAGE = placeholder();
+    public static final int MADV_NORMAL = placeholder();
+    public static final int MADV_RANDOM = placeholder();
+    public static final int MADV_SEQUENTIAL = placeholder();
+    public static final int MADV_WILLNEED = placeholder();
     public static final int MAP_FIXED = placeholder();
+    public static final int MAP_HUGETLB = placeholder();
+    public static final int MAP_POPULATE = placeholder();
     public static final int MAP_PRIVATE = placeholder();
     public static final int MAP_SHARED = placeholder();
     public static final int MCAST_JOIN_GROUP = placeholder();
@@ -249,6 +270,7 @@ public final class OsConstants {
     public static final int MSG_PEEK = placeholder();
     public static final int MSG_TRUNC = placeholder();
     public static final int MSG_WAITALL = placeholder();
+    public static final int MSG_WAITFORONE = placeholder();
     public static final int MS_ASYNC = placeholder();
     public static final int MS_INVALIDATE = placeholder();
     public static final int MS_SYNC = placeholder();
@@ -279,6 +301,12 @@ public final class OsConstants {
     public static final int POLLRDNORM = placeholder();
     public static final int POLLWRBAND = placeholder();
     public static final int POLLWRNORM = placeholder();
+    public static final int POSIX_FADV_DONTNEED = placeholder();
+    public static final int POSIX_FADV_NOREUSE = placeholder();
+    public static final int POSIX_FADV_NORMAL = placeholder();
+    public static final int POSIX_FADV_RANDOM = placeholder();
+    public static final int POSIX_FADV_SEQUENTIAL = placeholder();
+    public static final int POSIX_FADV_WILLNEED = placeholder();
     public static final int PROT_EXEC = placeholder();
     public static final int PROT_NONE = placeholder();
     public static final int PROT_READ = placeholder();
@@ -350,6 +378,9 @@ public final class OsConstants {
     public static final int SO_SNDLOWAT = placeholder();
     public static final int SO_SNDTIMEO = placeholder();
     public static final int SO_TYPE = placeholder();
+    public static final int SPLICE_F_MORE = placeholder();
+    public static final int SPLICE_F_MOVE = placeholder();
+    public static final int SPLICE_F_NONBLOCK = placeholder();
     public static final int STDERR_FILENO = placeholder();
     public static final int STDIN_FILENO = placeholder();
     public static final int STDOUT_FILENO = placeholder();
@@ -23,6 +23,7 @@ import java.net.SocketAddress;
 import java.net.SocketException;
 import java.nio.ByteBuffer;
 import java.nio.NioUtils;
+import java.util.Arrays;
 import libcore.util.MutableInt;
 import libcore.util.MutableLong;
 
@@ -36,9 +37,21 @@ public final class Posix implements Os {
     public native void chown(String path, int uid, int gid) throws ErrnoException;
     public native void close(FileDescriptor fd) throws ErrnoException;
     public native void connect(FileDescriptor fd, InetAddress address, int port) throws ErrnoException, SocketException;
+    public native long copy_file_range(FileDescriptor fdIn, MutableLong inOffset, FileDescriptor fdOut, MutableLong outOffset, long byteCount, int flags) throws ErrnoException;
     public native FileDescriptor dup(FileDescriptor oldFd) throws ErrnoException;
     public native FileDescriptor dup2(FileDescriptor oldFd, int newFd) throws ErrnoException;
     public native String[] environ();
+    public native FileDescriptor epoll_create(int flags) throws ErrnoException;
+    public native void epoll_ctl(FileDescriptor epfd, int op, FileDescriptor fd, int events, long data) throws ErrnoException;
+    public int epoll_wait(FileDescriptor epfd, ByteBuffer events, int timeoutMs) throws ErrnoException {
+        int maxEvents = events.remaining() / SizeOf.EPOLL_EVENT;
+        if (events.isDirect()) {
+            return epoll_waitBytes(epfd, events, events.position(), maxEvents, timeoutMs);
+        } else {
+            return epoll_waitBytes(epfd, NioUtils.unsafeArray(events), NioUtils.unsafeArrayOffset(events) + events.position(), maxEvents, timeoutMs);
+        }
+    }
+    private native int epoll_waitBytes(FileDescriptor epfd, Object buffer, int byteOffset, int maxEvents, int timeoutMs) throws ErrnoException;
     public native void execv(String filename, String[] argv) throws ErrnoException;
     public native void execve(String filename, String[] argv, String[] envp) throws ErrnoException;
     public native void fchmod(FileDescriptor fd, int mode) throws ErrnoException;
@@ -82,6 +95,7 @@ public final class Posix implements Os {
     public native void listen(FileDescriptor fd, int backlog) throws ErrnoException;
     public native long lseek(FileDescriptor fd, long offset, int whence) throws ErrnoException;
     public native StructStat lstat(String path) throws ErrnoException;
+    public native void madvise(long address, long byteCount, int advice) throws ErrnoException;
     public native void mincore(long address, long byteCount, byte[] vector) throws ErrnoException;
     public native void mkdir(String path, int mode) throws ErrnoException;
     public native void mlock(long address, long byteCount) throws ErrnoException;
@@ -92,9 +106,10 @@ public final class Posix implements Os {
     public native FileDescriptor open(String path, int flags, int mode) throws ErrnoException;
     public native FileDescriptor[] pipe() throws ErrnoException;
     public native int poll(StructPollfd[] fds, int timeoutMs) throws ErrnoException;
+    public native void posix_fadvise(FileDescriptor fd, long offset, long length, int advice) throws ErrnoException;
     public int pread(FileDescriptor fd, ByteBuffer buffer, long offset) throws ErrnoException {
         if (buffer.isDirect()) {
-            return preadBytes(fd, buffer, buffer.position(), buffer.remaining(), offset);
+            return preadAddress(fd, NioUtils.unsafeAddress(buffer) + buffer.position(), buffer.remaining(), offset);
         } else {
             return preadBytes(fd, NioUtils.unsafeArray(buffer), NioUtils.unsafeArrayOffset(buffer) + buffer.position(), buffer.remaining(), offset);
         }
@@ -104,9 +119,18 @@ public final class Posix implements Os {
         return preadBytes(fd, bytes, byteOffset, byteCount, offset);
     }
     private native int preadBytes(FileDescriptor fd, Object buffer, int bufferOffset, int byteCount, long offset) throws ErrnoException;
+    public int pread(FileDescriptor fd, long address, int byteCount, long offset) throws ErrnoException {
+        return preadAddress(fd, address, byteCount, offset);
+    }
+    private native int preadAddress(FileDescriptor fd, long address, int byteCount, long offset) throws ErrnoException;
+    public native int preadv(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts, long offset) throws ErrnoException;
+    public int preadv(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset) throws ErrnoException {
+        return preadvAddresses(fd, addresses, byteCounts, offset);
+    }
+    private native int preadvAddresses(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset) throws ErrnoException;
     public int pwrite(FileDescriptor fd, ByteBuffer buffer, long offset) throws ErrnoException {
         if (buffer.isDirect()) {
-            return pwriteBytes(fd, buffer, buffer.position(), buffer.remaining(), offset);
+            return pwriteAddress(fd, NioUtils.unsafeAddress(buffer) + buffer.position(), buffer.remaining(), offset);
         } else {
             return pwriteBytes(fd, NioUtils.unsafeArray(buffer), NioUtils.unsafeArrayOffset(buffer) + buffer.position(), buffer.remaining(), offset);
         }
@@ -116,9 +140,18 @@ public final class Posix implements Os {
         return pwriteBytes(fd, bytes, byteOffset, byteCount, offset);
     }
     private native int pwriteBytes(FileDescriptor fd, Object buffer, int bufferOffset, int byteCount, long offset) throws ErrnoException;
+    public int pwrite(FileDescriptor fd, long address, int byteCount, long offset) throws ErrnoException {
+        return pwriteAddress(fd, address, byteCount, offset);
+    }
+    private native int pwriteAddress(FileDescriptor fd, long address, int byteCount, long offset) throws ErrnoException;
+    public native int pwritev(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts, long offset) throws ErrnoException;
+    public int pwritev(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset) throws ErrnoException {
+        return pwritevAddresses(fd, addresses, byteCounts, offset);
+    }
+    private native int pwritevAddresses(FileDescriptor fd, long[] addresses, int[] byteCounts, long offset) throws ErrnoException;
     public int read(FileDescriptor fd, ByteBuffer buffer) throws ErrnoException {
         if (buffer.isDirect()) {
-            return readBytes(fd, buffer, buffer.position(), buffer.remaining());
+            return readAddress(fd, NioUtils.unsafeAddress(buffer) + buffer.position(), buffer.remaining());
         } else {
             return readBytes(fd, NioUtils.unsafeArray(buffer), NioUtils.unsafeArrayOffset(buffer) + buffer.position(), buffer.remaining());
         }
@@ -128,7 +161,16 @@ public final class Posix implements Os {
         return readBytes(fd, bytes, byteOffset, byteCount);
     }
     private native int readBytes(FileDescriptor fd, Object buffer, int offset, int byteCount) throws ErrnoException;
+    public int read(FileDescriptor fd, long address, int byteCount) throws ErrnoException {
+        return readAddress(fd, address, byteCount);
+    }
+    private native int readAddress(FileDescriptor fd, long address, int byteCount) throws ErrnoException;
+    public native void readahead(FileDescriptor fd, long offset, long byteCount) throws ErrnoException;
     public native int readv(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts) throws ErrnoException;
+    public int readv(FileDescriptor fd, long[] addresses, int[] byteCounts) throws ErrnoException {
+        return readvAddresses(fd, addresses, byteCounts);
+    }
+    private native int readvAddresses(FileDescriptor fd, long[] addresses, int[] byteCounts) throws ErrnoException;
     public int recvfrom(FileDescriptor fd, ByteBuffer buffer, int flags, InetSocketAddress srcAddress) throws ErrnoException, SocketException {
         if (buffer.isDirect()) {
             return recvfromBytes(fd, buffer, buffer.position(), buffer.remaining(), flags, srcAddress);
@@ -141,8 +183,38 @@ public final class Posix implements Os {
         return recvfromBytes(fd, bytes, byteOffset, byteCount, flags, srcAddress);
     }
     private native int recvfromBytes(FileDescriptor fd, Object buffer, int byteOffset, int byteCount, int flags, InetSocketAddress srcAddress) throws ErrnoException, SocketException;
+    public int recvmmsg(FileDescriptor fd, byte[] bytes, int byteOffset, int slotByteCount, int messageCount, int flags, InetSocketAddress[] srcAddresses, int[] results) throws ErrnoException, SocketException {
+        if (slotByteCount <= 0 || messageCount < 0 || (long) slotByteCount * messageCount > Integer.MAX_VALUE) {
+            throw new IllegalArgumentException("slotByteCount=" + slotByteCount + " messageCount=" + messageCount);
+        }
+        Arrays.checkOffsetAndCount(bytes.length, byteOffset, slotByteCount * messageCount);
+        if (results.length < 2 * messageCount || (srcAddresses != null && srcAddresses.length < messageCount)) {
+            throw new IllegalArgumentException("results or srcAddresses too short for " + messageCount + " messages");
+        }
+        if (messageCount == 0) {
+            return 0;
+        }
+        return recvmmsgBytes(fd, bytes, byteOffset, slotByteCount, messageCount, flags, srcAddresses, results);
+    }
+    private native int recvmmsgBytes(FileDescriptor fd, Object buffer, int byteOffset, int slotByteCount, int messageCount, int flags, InetSocketAddress[] srcAddresses, int[] results) throws ErrnoException, SocketException;
     public native void remove(String path) throws ErrnoException;
     public native void rename(String oldPath, String newPath) throws ErrnoException;
+    public int sendmmsg(FileDescriptor fd, byte[] bytes, int[] byteOffsets, int[] byteCounts, int messageCount, int flags, InetAddress[] inetAddresses, int[] ports) throws ErrnoException, SocketException {
+        if (messageCount < 0 || byteOffsets.length < messageCount || byteCounts.length < messageCount) {
+            throw new IllegalArgumentException("byteOffsets or byteCounts too short for " + messageCount + " messages");
+        }
+        if (inetAddresses != null && (inetAddresses.length < messageCount || ports.length < messageCount)) {
+            throw new IllegalArgumentException("inetAddresses or ports too short for " + messageCount + " messages");
+        }
+        for (int i = 0; i < messageCount; ++i) {
+            Arrays.checkOffsetAndCount(bytes.length, byteOffsets[i], byteCounts[i]);
+        }
+        if (messageCount == 0) {
+            return 0;
+        }
+        return sendmmsgBytes(fd, bytes, byteOffsets, byteCounts, messageCount, flags, inetAddresses, ports);
+    }
+    private native int sendmmsgBytes(FileDescriptor fd, Object buffer, int[] byteOffsets, int[] byteCounts, int messageCount, int flags, InetAddress[] inetAddresses, int[] ports) throws ErrnoException, SocketException;
     public native long sendfile(FileDescriptor outFd, FileDescriptor inFd, MutableLong inOffset, long byteCount) throws ErrnoException;
     public int sendto(FileDescriptor fd, ByteBuffer buffer, int flags, InetAddress inetAddress, int port) throws ErrnoException, SocketException {
         if (buffer.isDirect()) {
@@ -172,7 +244,17 @@ public final class Posix implements Os {
     public native void shutdown(FileDescriptor fd, int how) throws ErrnoException;
     public native FileDescriptor socket(int domain, int type, int protocol) throws ErrnoException;
     public native void socketpair(int domain, int type, int protocol, FileDescriptor fd1, FileDescriptor fd2) throws ErrnoException;
+    public native long splice(FileDescriptor fdIn, MutableLong inOffset, FileDescriptor fdOut, MutableLong outOffset, long byteCount, int flags) throws ErrnoException, SocketException;
     public native StructStat stat(String path) throws ErrnoException;
+    public int stat(FileDescriptor dirFd, String[] paths, boolean followLinks, int fields, long[] values, int[] errnos) {
+        int valueCount = Integer.bitCount(fields & StructStat.FIELD_ALL);
+        if (errnos.length < paths.length || (long) valueCount * paths.length > values.length) {
+            throw new ArrayIndexOutOfBoundsException("paths.length=" + paths.length +
+                    "; values.length=" + values.length + "; errnos.length=" + errnos.length);
+        }
+        return statMany(dirFd, paths, followLinks, fields, values, errnos);
+    }
+    private native int statMany(FileDescriptor dirFd, String[] paths, boolean followLinks, int fields, long[] values, int[] errnos);
     public native StructStatVfs statvfs(String path) throws ErrnoException;
     public native String strerror(int errno);
     public native String strsignal(int signal);
@@ -180,6 +262,7 @@ public final class Posix implements Os {
     public native long sysconf(int name);
     public native void tcdrain(FileDescriptor fd) throws ErrnoException;
     public native void tcsendbreak(FileDescriptor fd, int duration) throws ErrnoException;
+    public native long tee(FileDescriptor fdIn, FileDescriptor fdOut, long byteCount, int flags) throws ErrnoException;
     public int umask(int mask) {
         if ((mask & 0777) != mask) {
             throw new IllegalArgumentException("Invalid umask: " + mask);
@@ -192,7 +275,7 @@ public final class Posix implements Os {
     public native int waitpid(int pid, MutableInt status, int options) throws ErrnoException;
     public int write(FileDescriptor fd, ByteBuffer buffer) throws ErrnoException {
         if (buffer.isDirect()) {
-            return writeBytes(fd, buffer, buffer.position(), buffer.remaining());
+            return writeAddress(fd, NioUtils.unsafeAddress(buffer) + buffer.position(), buffer.remaining());
         } else {
             return writeBytes(fd, NioUtils.unsafeArray(buffer), NioUtils.unsafeArrayOffset(buffer) + buffer.position(), buffer.remaining());
         }
@@ -202,5 +285,13 @@ public final class Posix implements Os {
         return writeBytes(fd, bytes, byteOffset, byteCount);
     }
     private native int writeBytes(FileDescriptor fd, Object buffer, int offset, int byteCount) throws ErrnoException;
+    public int write(FileDescriptor fd, long address, int byteCount) throws ErrnoException {
+        return writeAddress(fd, address, byteCount);
+    }
+    private native int writeAddress(FileDescriptor fd, long address, int byteCount) throws ErrnoException;
     public native int writev(FileDescriptor fd, Object[] buffers, int[] offsets, int[] byteCounts) throws ErrnoException;
+    public int writev(FileDescriptor fd, long[] addresses, int[] byteCounts) throws ErrnoException {
+        return writevAddresses(fd, addresses, byteCounts);
+    }
+    private native int writevAddresses(FileDescriptor fd, long[] addresses, int[] byteCounts) throws ErrnoException;
 }
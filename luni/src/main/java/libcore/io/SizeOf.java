@@ -19,6 +19,8 @@ package libcore.io;
 public final class SizeOf {
     public static final int CHAR = 2;
     public static final int DOUBLE = 8;
+    /** The size of each record written by {@link Os#epoll_wait}. */
+    public static final int EPOLL_EVENT = 16;
     public static final int FLOAT = 4;
     public static final int INT = 4;
     public static final int LONG = 8;
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+import dalvik.system.CloseGuard;
+import java.io.Closeable;
+import java.io.FileDescriptor;
+import java.net.SocketException;
+import static libcore.io.OsConstants.*;
+
+/**
+ * Relays bytes between two arbitrary file descriptors without copying them through the Java
+ * heap. splice(2) requires one end of each transfer to be a pipe, so this keeps a private pipe
+ * open across transfers: bytes are spliced from the source into the pipe, and from the pipe to
+ * the destination.
+ *
+ * Bytes that couldn't be written to the destination (because it's non-blocking and full, say)
+ * stay in the pipe and are written first on the next call to {@link #transfer}. Not thread-safe.
+ *
+ * @hide
+ */
+public final class SplicePipe implements Closeable {
+    private final FileDescriptor readFd;
+    private final FileDescriptor writeFd;
+    private final CloseGuard guard = CloseGuard.get();
+
+    /** The number of bytes spliced into the pipe but not yet out of it. */
+    private long pending;
+
+    public SplicePipe() throws ErrnoException {
+        FileDescriptor[] fds = Libcore.os.pipe();
+        readFd = fds[0];
+        writeFd = fds[1];
+        guard.open("close");
+    }
+
+    /**
+     * Moves up to {@code byteCount} bytes from {@code in} to {@code out}, returning the number
+     * of bytes written to {@code out}, or -1 if {@code in} is at end of file and nothing is
+     * pending.
+     */
+    public long transfer(FileDescriptor in, FileDescriptor out, long byteCount) throws ErrnoException, SocketException {
+        if (pending == 0) {
+            long byteCountIn = Libcore.os.splice(in, null, writeFd, null, byteCount, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (byteCountIn == 0) {
+                return -1;
+            }
+            pending = byteCountIn;
+        }
+        long byteCountOut = Libcore.os.splice(readFd, null, out, null, pending, SPLICE_F_MOVE | SPLICE_F_MORE);
+        pending -= byteCountOut;
+        return byteCountOut;
+    }
+
+    /** Returns the number of bytes read from a source but not yet written to a destination. */
+    public long pending() {
+        return pending;
+    }
+
+    @Override public void close() {
+        guard.close();
+        IoUtils.closeQuietly(readFd);
+        IoUtils.closeQuietly(writeFd);
+    }
+
+    @Override protected void finalize() throws Throwable {
+        try {
+            if (guard != null) {
+                guard.warnIfOpen();
+            }
+            close();
+        } finally {
+            super.finalize();
+        }
+    }
+}
@@ -22,6 +22,26 @@ package libcore.io;
  * <a href="http://www.opengroup.org/onlinepubs/000095399/basedefs/sys/stat.h.html">&lt;stat.h&gt;</a>
  */
 public final class StructStat {
+    /**
+     * Field selection bits for {@link Os#stat(java.io.FileDescriptor, String[], boolean, int, long[], int[])},
+     * which writes the selected fields in this order.
+     * @hide
+     */
+    public static final int FIELD_DEV = 1 << 0;
+    /** @hide */ public static final int FIELD_INO = 1 << 1;
+    /** @hide */ public static final int FIELD_MODE = 1 << 2;
+    /** @hide */ public static final int FIELD_NLINK = 1 << 3;
+    /** @hide */ public static final int FIELD_UID = 1 << 4;
+    /** @hide */ public static final int FIELD_GID = 1 << 5;
+    /** @hide */ public static final int FIELD_RDEV = 1 << 6;
+    /** @hide */ public static final int FIELD_SIZE = 1 << 7;
+    /** @hide */ public static final int FIELD_ATIME = 1 << 8;
+    /** @hide */ public static final int FIELD_MTIME = 1 << 9;
+    /** @hide */ public static final int FIELD_CTIME = 1 << 10;
+    /** @hide */ public static final int FIELD_BLKSIZE = 1 << 11;
+    /** @hide */ public static final int FIELD_BLOCKS = 1 << 12;
+    /** @hide */ public static final int FIELD_ALL = (1 << 13) - 1;
+
     /** Device ID of device containing file. */
     public final long st_dev; /*dev_t*/
 
@@ -23,6 +23,7 @@ import java.io.IOException;
 import java.net.SocketException;
 import java.util.Arrays;
 import libcore.io.IoBridge;
+import libcore.util.LazyNatives;
 
 /**
  * This class allows raw L2 packets to be sent and received via the
@@ -32,6 +33,10 @@ import libcore.io.IoBridge;
  * @hide
  */
 public class RawSocket implements Closeable {
+    static {
+        LazyNatives.register("rawsocket");
+    }
+
     /**
      * Ethernet IP protocol type, part of the L2 header of IP packets.
      */
@@ -50,6 +55,12 @@ public class RawSocket implements Closeable {
         int offset, int byteCount);
     private static native int recvPacket(FileDescriptor fd, byte[] packet,
         int offset, int byteCount, int destPort, int timeoutMillis);
+    private static native int sendPackets(FileDescriptor fd,
+        String interfaceName, short protocolType, byte[] destMac, byte[] packets,
+        int[] offsets, int[] byteCounts, int packetCount);
+    private static native int recvPackets(FileDescriptor fd, byte[] packets,
+        int offset, int slotByteCount, int packetCount, int destPort,
+        int timeoutMillis, int[] results);
 
     private final FileDescriptor fd;
     private final String mInterfaceName;
@@ -120,6 +131,81 @@ public class RawSocket implements Closeable {
             offset, byteCount);
     }
 
+    /**
+     * Reads up to {@code packetCount} raw packets with a single system
+     * call. Packet {@code i} is written to the {@code slotByteCount} bytes
+     * starting at {@code offset + i * slotByteCount}; its length goes in
+     * {@code results[2 * i]} (0 if it was rejected by the {@code destPort}
+     * filter, as for {@link #read}) and its {@code MSG_} flags in
+     * {@code results[2 * i + 1]}, where {@code MSG_TRUNC} signals a packet
+     * larger than its slot. Returns the number of slots filled, or 0 on timeout.
+     */
+    public int readPackets(byte[] packets, int offset, int slotByteCount,
+        int packetCount, int destPort, int timeoutMillis, int[] results) {
+        if (packets == null) {
+            throw new NullPointerException("packets == null");
+        }
+
+        if (results == null) {
+            throw new NullPointerException("results == null");
+        }
+
+        if (slotByteCount <= 0 || packetCount <= 0
+            || (long) slotByteCount * packetCount > Integer.MAX_VALUE) {
+            throw new IllegalArgumentException("slotByteCount=" + slotByteCount
+                + " packetCount=" + packetCount);
+        }
+
+        Arrays.checkOffsetAndCount(packets.length, offset, slotByteCount * packetCount);
+
+        if (results.length < 2 * packetCount) {
+            throw new IllegalArgumentException("results too short: " + results.length);
+        }
+
+        if (destPort > 65535) {
+            throw new IllegalArgumentException("Port out of range: "
+                + destPort);
+        }
+
+        return recvPackets(fd, packets, offset, slotByteCount, packetCount,
+            destPort, timeoutMillis, results);
+    }
+
+    /**
+     * Writes {@code packetCount} raw packets to the desired interface
+     * with a single system call, as if by calling {@link #write} for the
+     * {@code byteCounts[i]} bytes at {@code offsets[i]} of each. Returns
+     * the number of packets sent.
+     */
+    public int writePackets(byte[] destMac, byte[] packets, int[] offsets,
+        int[] byteCounts, int packetCount) {
+        if (destMac == null) {
+            throw new NullPointerException("destMac == null");
+        }
+
+        if (packets == null) {
+            throw new NullPointerException("packets == null");
+        }
+
+        if (destMac.length != 6) {
+            throw new IllegalArgumentException("MAC length must be 6: "
+                + destMac.length);
+        }
+
+        if (packetCount <= 0 || offsets.length < packetCount
+            || byteCounts.length < packetCount) {
+            throw new IllegalArgumentException("packetCount out of range: "
+                + packetCount);
+        }
+
+        for (int i = 0; i < packetCount; ++i) {
+            Arrays.checkOffsetAndCount(packets.length, offsets[i], byteCounts[i]);
+        }
+
+        return sendPackets(fd, mInterfaceName, mProtocolType, destMac, packets,
+            offsets, byteCounts, packetCount);
+    }
+
     /**
      * Closes the socket.  After this method is invoked, subsequent
      * read/write operations will fail.
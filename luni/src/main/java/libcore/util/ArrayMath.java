@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+import java.nio.Buffer;
+import java.nio.BufferOverflowException;
+import java.nio.BufferUnderflowException;
+import java.nio.ByteOrder;
+import java.nio.DoubleBuffer;
+import java.nio.FloatBuffer;
+import java.nio.NioUtils;
+import java.nio.ReadOnlyBufferException;
+import java.util.Arrays;
+
+/**
+ * Applies one of {@link Math}'s functions to every element of an array or direct buffer, in a
+ * single native call rather than one per element.
+ *
+ * <p>{@link #EXP} and {@link #LOG} use their own kernels, which are within 1 ulp of the
+ * correctly rounded result, as {@link Math#exp} and {@link Math#log} are documented to be, but
+ * needn't give the same answers. {@link #SQRT} is correctly rounded, and so matches
+ * {@link Math#sqrt} exactly. {@link #SIN} and {@link #COS} give exactly what {@link Math#sin}
+ * and {@link Math#cos} would. The float versions compute in double and round the result, so
+ * they're within 1 ulp too. {@link #applyStrict} matches {@link StrictMath} bit for bit.
+ *
+ * <p>The source and destination may be the same elements, for an in-place update, but mustn't
+ * otherwise overlap.
+ *
+ * @hide
+ */
+public final class ArrayMath {
+    private ArrayMath() {
+    }
+
+    // Keep these in sync with libcore_util_ArrayMath.cpp.
+    public static final int EXP = 0;
+    public static final int LOG = 1;
+    public static final int SQRT = 2;
+    public static final int SIN = 3;
+    public static final int COS = 4;
+
+    /**
+     * Sets {@code dst[dstOffset + i]} to {@code function(src[srcOffset + i])} for each {@code i}
+     * below {@code count}.
+     */
+    public static void apply(int function, double[] src, int srcOffset, double[] dst,
+            int dstOffset, int count) {
+        checkArrays(function, src.length, srcOffset, dst.length, dstOffset, count, src == dst);
+        applyDoubles(function, false, src, srcOffset, dst, dstOffset, count);
+    }
+
+    /**
+     * Like {@link #apply(int, double[], int, double[], int, int)}, but as {@link StrictMath}
+     * would.
+     */
+    public static void applyStrict(int function, double[] src, int srcOffset, double[] dst,
+            int dstOffset, int count) {
+        checkArrays(function, src.length, srcOffset, dst.length, dstOffset, count, src == dst);
+        applyDoubles(function, true, src, srcOffset, dst, dstOffset, count);
+    }
+
+    /**
+     * Sets {@code dst[dstOffset + i]} to {@code (float) function(src[srcOffset + i])} for each
+     * {@code i} below {@code count}.
+     */
+    public static void apply(int function, float[] src, int srcOffset, float[] dst,
+            int dstOffset, int count) {
+        checkArrays(function, src.length, srcOffset, dst.length, dstOffset, count, src == dst);
+        applyFloats(function, src, srcOffset, dst, dstOffset, count);
+    }
+
+    /**
+     * Applies {@code function} to {@code count} elements of {@code src} starting at its position,
+     * storing the results in {@code dst} starting at its position. Both buffers must be direct
+     * and in native byte order. Neither buffer's position is changed.
+     */
+    public static void apply(int function, DoubleBuffer src, DoubleBuffer dst, int count) {
+        applyToBuffers(function, false, src, dst, count, 8);
+    }
+
+    /**
+     * Like {@link #apply(int, DoubleBuffer, DoubleBuffer, int)}, but as {@link StrictMath}
+     * would.
+     */
+    public static void applyStrict(int function, DoubleBuffer src, DoubleBuffer dst, int count) {
+        applyToBuffers(function, true, src, dst, count, 8);
+    }
+
+    /** Like {@link #apply(int, DoubleBuffer, DoubleBuffer, int)}, but for floats. */
+    public static void apply(int function, FloatBuffer src, FloatBuffer dst, int count) {
+        applyToBuffers(function, false, src, dst, count, 4);
+    }
+
+    private static void checkFunction(int function) {
+        if (function < EXP || function > COS) {
+            throw new IllegalArgumentException("unknown function " + function);
+        }
+    }
+
+    private static void checkArrays(int function, int srcLength, int srcOffset, int dstLength,
+            int dstOffset, int count, boolean sameArray) {
+        checkFunction(function);
+        Arrays.checkOffsetAndCount(srcLength, srcOffset, count);
+        Arrays.checkOffsetAndCount(dstLength, dstOffset, count);
+        if (sameArray && srcOffset != dstOffset && overlap(srcOffset, dstOffset, count)) {
+            throw new IllegalArgumentException("src and dst overlap");
+        }
+    }
+
+    private static boolean overlap(long src, long dst, long length) {
+        return src < dst + length && dst < src + length;
+    }
+
+    private static void applyToBuffers(int function, boolean strict, Buffer src, Buffer dst,
+            int count, int elementSize) {
+        checkFunction(function);
+        boolean floats = (elementSize == 4);
+        if (!src.isDirect() || !dst.isDirect()) {
+            throw new IllegalArgumentException("buffers must be direct");
+        }
+        ByteOrder srcOrder = floats ? ((FloatBuffer) src).order() : ((DoubleBuffer) src).order();
+        ByteOrder dstOrder = floats ? ((FloatBuffer) dst).order() : ((DoubleBuffer) dst).order();
+        if (srcOrder != ByteOrder.nativeOrder() || dstOrder != ByteOrder.nativeOrder()) {
+            throw new IllegalArgumentException("buffers must be in native byte order");
+        }
+        if (dst.isReadOnly()) {
+            throw new ReadOnlyBufferException();
+        }
+        if (count < 0) {
+            throw new IllegalArgumentException("count < 0: " + count);
+        }
+        if (count > src.remaining()) {
+            throw new BufferUnderflowException();
+        }
+        if (count > dst.remaining()) {
+            throw new BufferOverflowException();
+        }
+        long srcAddress = NioUtils.unsafeAddress(src) + (long) src.position() * elementSize;
+        long dstAddress = NioUtils.unsafeAddress(dst) + (long) dst.position() * elementSize;
+        long byteCount = (long) count * elementSize;
+        if (srcAddress != dstAddress && overlap(srcAddress, dstAddress, byteCount)) {
+            throw new IllegalArgumentException("src and dst overlap");
+        }
+        applyDirect(function, strict, floats, srcAddress, dstAddress, count);
+    }
+
+    private static native void applyDoubles(int function, boolean strict, double[] src,
+            int srcOffset, double[] dst, int dstOffset, int count);
+    private static native void applyFloats(int function, float[] src, int srcOffset, float[] dst,
+            int dstOffset, int count);
+    private static native void applyDirect(int function, boolean strict, boolean floats,
+            long srcAddress, long dstAddress, int count);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+/**
+ * Cheaper clocks than {@link System#currentTimeMillis} and {@link System#nanoTime}, for code
+ * that takes so many timestamps that their cost matters more than their precision.
+ *
+ * <ul>
+ * <li>The coarse clocks read the kernel's coarse clocks, which only advance once per
+ * scheduler tick (typically 1-10ms) but don't need to read the hardware.
+ * <li>The cycle counter reads the CPU's constant-rate counter where there is one, at
+ * {@link #getCycleCounterFrequency} ticks per second.
+ * <li>The ticker clocks don't call native code at all: once {@link #startTicker} has been
+ * called, a native thread stores the time in fields of this class every period, and reading them
+ * is a volatile field access.
+ * </ul>
+ *
+ * @hide
+ */
+public final class Clocks {
+    private Clocks() {
+    }
+
+    // Written by the native ticker thread; 0 while it isn't running.
+    private static volatile long tickerMillis;
+    private static volatile long tickerNanos;
+
+    /** Like {@link System#currentTimeMillis}, but only as fine as the kernel's tick. */
+    public static native long coarseCurrentTimeMillis();
+
+    /** Like {@link System#nanoTime}, but only as fine as the kernel's tick. */
+    public static native long coarseNanoTime();
+
+    /**
+     * Returns the CPU's cycle counter: the TSC on x86 CPUs whose TSC runs at a constant rate, and
+     * the generic timer's virtual count on arm64. Elsewhere this returns {@link System#nanoTime}.
+     * Only intervals are meaningful.
+     */
+    public static native long readCycleCounter();
+
+    /**
+     * Returns how many times per second {@link #readCycleCounter} ticks. On x86 the first call
+     * measures this, which takes about 20ms.
+     */
+    public static native long getCycleCounterFrequency();
+
+    /**
+     * Starts updating the values returned by {@link #tickerCurrentTimeMillis} and
+     * {@link #tickerNanoTime} every {@code periodMs} milliseconds, if that isn't already
+     * happening.
+     */
+    public static synchronized void startTicker(int periodMs) {
+        if (periodMs < 1 || periodMs > 1000) {
+            throw new IllegalArgumentException("periodMs out of range: " + periodMs);
+        }
+        startTickerImpl(periodMs);
+    }
+
+    /** Stops the ticker. The ticker clocks fall back to the system clocks. */
+    public static synchronized void stopTicker() {
+        stopTickerImpl();
+        tickerMillis = 0;
+        tickerNanos = 0;
+    }
+
+    /**
+     * Returns {@link System#currentTimeMillis} as of the ticker's last update, or the current
+     * value if the ticker isn't running.
+     */
+    public static long tickerCurrentTimeMillis() {
+        long millis = tickerMillis;
+        return (millis != 0) ? millis : System.currentTimeMillis();
+    }
+
+    /**
+     * Returns {@link System#nanoTime} as of the ticker's last update, or the current value if the
+     * ticker isn't running.
+     */
+    public static long tickerNanoTime() {
+        long nanos = tickerNanos;
+        return (nanos != 0) ? nanos : System.nanoTime();
+    }
+
+    private static native void startTickerImpl(int periodMs);
+    private static native void stopTickerImpl();
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+/**
+ * Registers the native methods of optional subsystems on demand. Registering a class's natives
+ * means loading the class, so doing it for everything when libjavacore loads makes processes
+ * that never touch ICU, XML or zip files pay for them at startup. Instead, each class in a
+ * group calls {@link #register} from its static initializer.
+ *
+ * <p>Setting {@code LIBCORE_EAGER_JNI} in the environment registers every group at load time.
+ *
+ * @hide
+ */
+public final class LazyNatives {
+    private LazyNatives() {
+    }
+
+    /**
+     * Registers the natives of every class in {@code group}, unless that's already been done.
+     * Cheap after the first call.
+     */
+    public static native void register(String group);
+
+    /**
+     * Returns the names of the groups. The first, "eager", is the classes registered when the
+     * library is loaded.
+     */
+    public static native String[] getGroupNames();
+
+    /**
+     * Returns how long registering each group took, in nanoseconds, or -1 for groups that haven't
+     * been registered yet. Indexed like {@link #getGroupNames}.
+     */
+    public static native long[] getRegistrationNanos();
+}
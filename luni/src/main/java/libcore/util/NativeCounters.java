@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+/**
+ * Counters and histograms kept by libcore's native code on its hot paths: system calls
+ * retried after EINTR, SSL socket wakeups, bytes through zlib, and time spent blocked in
+ * interruptible socket calls. Updating them is cheap enough to leave on all the time. Each
+ * thread counts into slots of its own, so {@link #getSnapshot} doesn't stop anyone counting.
+ *
+ * <p>{@link #setTracingEnabled} additionally brackets the same steps with systrace markers.
+ *
+ * @hide
+ */
+public final class NativeCounters {
+    private NativeCounters() {
+    }
+
+    // Keep these in sync with NativeCounters.h.
+    /** Posix system calls retried because they failed with EINTR. */
+    public static final int COUNTER_EINTR_RETRIES = 0;
+    /** Times an SSL socket's wait for readiness woke up. */
+    public static final int COUNTER_SSL_SELECT_WAKEUPS = 1;
+    /** Wakeups counted by {@link #COUNTER_SSL_SELECT_WAKEUPS} that found the socket not ready. */
+    public static final int COUNTER_SSL_SELECT_SPURIOUS_WAKEUPS = 2;
+    /** Bytes of compressed input consumed by {@link java.util.zip.Inflater}s. */
+    public static final int COUNTER_INFLATER_BYTES_IN = 3;
+    /** Bytes of uncompressed output produced by {@link java.util.zip.Inflater}s. */
+    public static final int COUNTER_INFLATER_BYTES_OUT = 4;
+    /** Bytes of uncompressed input consumed by {@link java.util.zip.Deflater}s. */
+    public static final int COUNTER_DEFLATER_BYTES_IN = 5;
+    /** Bytes of compressed output produced by {@link java.util.zip.Deflater}s. */
+    public static final int COUNTER_DEFLATER_BYTES_OUT = 6;
+    public static final int COUNTER_COUNT = 7;
+
+    /** Microseconds spent blocked in socket calls that another thread's close can interrupt. */
+    public static final int HISTOGRAM_BLOCKED_MICROS = 0;
+    public static final int HISTOGRAM_COUNT = 1;
+
+    /**
+     * Each histogram has this many buckets. Bucket 0 counts zeros, and bucket {@code i} counts
+     * values from {@code 2^(i-1)} up to {@code 2^i}. The last bucket also counts everything
+     * bigger.
+     */
+    public static final int HISTOGRAM_BUCKET_COUNT = 32;
+
+    /** Returns where {@code bucket} of {@code histogram} is in a {@link #getSnapshot} result. */
+    public static int histogramIndex(int histogram, int bucket) {
+        return COUNTER_COUNT + histogram * HISTOGRAM_BUCKET_COUNT + bucket;
+    }
+
+    /**
+     * Returns the totals since the process started, summed over all threads: the
+     * {@link #COUNTER_COUNT} counters, indexed by the {@code COUNTER_} constants, followed by
+     * the histograms' buckets, indexed by {@link #histogramIndex}. Counts are only approximately
+     * simultaneous with each other, since threads keep counting while the snapshot is taken.
+     */
+    public static native long[] getSnapshot();
+
+    /**
+     * Starts or stops writing systrace markers for the counted steps. Returns whether tracing is
+     * now on, which it can't be if the kernel's trace_marker file can't be opened.
+     */
+    public static native boolean setTracingEnabled(boolean enabled);
+}
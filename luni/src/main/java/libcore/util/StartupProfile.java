@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+/**
+ * Reports the steps libjavacore's native code timed while starting up: JNI_OnLoad itself, each
+ * class's native registration (including {@link LazyNatives} groups registered later), mapping
+ * the ICU data, AsynchronousSocketCloseMonitor setup, and opening ICU services such as
+ * collators, converters and break iterators. Only the first few hundred events, from the first
+ * ten seconds after the library loads, are kept; see {@link #getDroppedEventCount}.
+ *
+ * <p>Events are recorded when they end, so nested steps come before the steps containing them.
+ * Events are only ever appended, so {@link #getEventNames} and {@link #getEvents} agree on every
+ * index they have in common even if more events are recorded between the two calls.
+ *
+ * @hide
+ */
+public final class StartupProfile {
+    private StartupProfile() {
+    }
+
+    /** The CLOCK_MONOTONIC time at which the event started, in nanoseconds. */
+    public static final int FIELD_START_NANOS = 0;
+    /** How long the event took, in nanoseconds. */
+    public static final int FIELD_DURATION_NANOS = 1;
+    /**
+     * The change in the number of bytes malloc(3) had handed out. This is process-wide, so it
+     * includes other threads' allocations during the event, and can be negative.
+     */
+    public static final int FIELD_ALLOCATED_BYTES = 2;
+    /** The id of the thread that recorded the event. */
+    public static final int FIELD_TID = 3;
+    /** The number of fields per event in {@link #getEvents}. */
+    public static final int FIELD_COUNT = 4;
+
+    /** Returns the name of each recorded event, in the order they were recorded. */
+    public static native String[] getEventNames();
+
+    /**
+     * Returns the recorded events, packed {@link #FIELD_COUNT} longs each: the fields of event
+     * {@code i} start at {@code i * FIELD_COUNT}.
+     */
+    public static native long[] getEvents();
+
+    /**
+     * Returns how many events weren't recorded because the table was already full or startup
+     * was over.
+     */
+    public static native int getDroppedEventCount();
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.apache.harmony.xml;
+
+import org.xml.sax.Attributes;
+
+/**
+ * The attributes of a start element event delivered in batch mode. Reads
+ * straight from the batch's event, name and text arrays, so it's only valid
+ * during the startElement call it's passed to.
+ *
+ * @see ExpatParser#handleEvents
+ */
+final class BufferedAttributes implements Attributes {
+
+    /** Number of ints per attribute: uri, localName, qName, value offset and value length. */
+    static final int FIELD_COUNT = 5;
+
+    /**
+     * Since we don't do validation, pretty much everything is CDATA type.
+     */
+    private static final String CDATA = "CDATA";
+
+    private int[] events;
+    private int offset;
+    private int length;
+    private String[] names;
+    private char[] text;
+
+    void reset(int[] events, int offset, int length, String[] names, char[] text) {
+        this.events = events;
+        this.offset = offset;
+        this.length = length;
+        this.names = names;
+        this.text = text;
+    }
+
+    void clear() {
+        reset(null, 0, 0, null, null);
+    }
+
+    public int getLength() {
+        return length;
+    }
+
+    public String getURI(int index) {
+        return (index < 0 || index >= length) ? null : name(index, 0);
+    }
+
+    public String getLocalName(int index) {
+        return (index < 0 || index >= length) ? null : name(index, 1);
+    }
+
+    public String getQName(int index) {
+        return (index < 0 || index >= length) ? null : name(index, 2);
+    }
+
+    public String getType(int index) {
+        return (index < 0 || index >= length) ? null : CDATA;
+    }
+
+    public String getValue(int index) {
+        if (index < 0 || index >= length) {
+            return null;
+        }
+        int field = offset + index * FIELD_COUNT;
+        return new String(text, events[field + 3], events[field + 4]);
+    }
+
+    public int getIndex(String uri, String localName) {
+        if (uri == null) {
+            throw new NullPointerException("uri == null");
+        }
+        if (localName == null) {
+            throw new NullPointerException("localName == null");
+        }
+        // Our names are interned, so names given as literals match by identity.
+        for (int i = 0; i < length; i++) {
+            if (name(i, 1) == localName && name(i, 0) == uri) {
+                return i;
+            }
+        }
+        for (int i = 0; i < length; i++) {
+            if (name(i, 1).equals(localName) && name(i, 0).equals(uri)) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    public int getIndex(String qName) {
+        if (qName == null) {
+            throw new NullPointerException("qName == null");
+        }
+        for (int i = 0; i < length; i++) {
+            if (name(i, 2) == qName) {
+                return i;
+            }
+        }
+        for (int i = 0; i < length; i++) {
+            if (name(i, 2).equals(qName)) {
+                return i;
+            }
+        }
+        // Like ExpatAttributes, a name without a prefix also matches a
+        // prefixed attribute's local name.
+        if (qName.indexOf(':') == -1) {
+            for (int i = 0; i < length; i++) {
+                if (name(i, 1).equals(qName)) {
+                    return i;
+                }
+            }
+        }
+        return -1;
+    }
+
+    public String getType(String uri, String localName) {
+        return getIndex(uri, localName) == -1 ? null : CDATA;
+    }
+
+    public String getType(String qName) {
+        return getIndex(qName) == -1 ? null : CDATA;
+    }
+
+    public String getValue(String uri, String localName) {
+        int index = getIndex(uri, localName);
+        return index == -1 ? null : getValue(index);
+    }
+
+    public String getValue(String qName) {
+        int index = getIndex(qName);
+        return index == -1 ? null : getValue(index);
+    }
+
+    private String name(int index, int field) {
+        return names[events[offset + index * FIELD_COUNT + field]];
+    }
+}
@@ -16,12 +16,17 @@
 
 package org.apache.harmony.xml;
 
+import java.util.Arrays;
+import libcore.util.LazyNatives;
 import org.xml.sax.Attributes;
 
 /**
  * Wraps native attribute array.
  */
 abstract class ExpatAttributes implements Attributes {
+    static {
+        LazyNatives.register("expat");
+    }
 
     /**
      * Since we don't do validation, pretty much everything is CDATA type.
@@ -45,23 +50,49 @@ abstract class ExpatAttributes implements Attributes {
      */
     public abstract long getPointer();
 
+    /**
+     * Interned names and values of the attributes, fetched from native code
+     * the first time they're needed. Attribute lookups by name compare against
+     * these, so repeated lookups don't cross JNI or copy strings.
+     */
+    private String[] qNames;
+    private String[] uris;
+    private String[] localNames;
+    private String[] values;
+    private boolean haveQNames;
+    private boolean haveNames;
+    private boolean haveValues;
+
+    /**
+     * Forgets cached names and values. Called when the underlying attribute
+     * array changes; the arrays themselves are kept for reuse.
+     */
+    void clearCache() {
+        haveQNames = false;
+        haveNames = false;
+        if (haveValues) {
+            Arrays.fill(values, null);
+            haveValues = false;
+        }
+    }
+
     public String getURI(int index) {
         if (index < 0 || index >= getLength()) {
             return null;
         }
-        return getURI(getParserPointer(), getPointer(), index);
+        return uris()[index];
     }
 
     public String getLocalName(int index) {
         return (index < 0 || index >= getLength())
                 ? null
-                : getLocalName(getParserPointer(), getPointer(), index);
+                : localNames()[index];
     }
 
     public String getQName(int index) {
         return (index < 0 || index >= getLength())
                 ? null
-                : getQName(getParserPointer(), getPointer(), index);
+                : qNames()[index];
     }
 
     public String getType(int index) {
@@ -69,9 +100,20 @@ abstract class ExpatAttributes implements Attributes {
     }
 
     public String getValue(int index) {
-        return (index < 0 || index >= getLength())
-                ? null
-                : getValueByIndex(getPointer(), index);
+        if (index < 0 || index >= getLength()) {
+            return null;
+        }
+        int length = getLength();
+        if (values == null || values.length < length) {
+            values = new String[length];
+        }
+        String value = values[index];
+        if (value == null) {
+            value = getValueByIndex(getPointer(), index);
+            values[index] = value;
+            haveValues = true;
+        }
+        return value;
     }
 
     public int getIndex(String uri, String localName) {
@@ -81,22 +123,56 @@ abstract class ExpatAttributes implements Attributes {
         if (localName == null) {
             throw new NullPointerException("localName == null");
         }
-        long pointer = getPointer();
-        if (pointer == 0) {
+        int length = getLength();
+        if (length == 0) {
             return -1;
         }
-        return getIndex(pointer, uri, localName);
+        String[] localNames = localNames();
+        String[] uris = this.uris;
+        // Our names are interned, so names given as literals match by identity.
+        for (int i = 0; i < length; i++) {
+            if (localNames[i] == localName && uris[i] == uri) {
+                return i;
+            }
+        }
+        for (int i = 0; i < length; i++) {
+            if (localNames[i].equals(localName) && uris[i].equals(uri)) {
+                return i;
+            }
+        }
+        return -1;
     }
 
     public int getIndex(String qName) {
         if (qName == null) {
             throw new NullPointerException("qName == null");
         }
-        long pointer = getPointer();
-        if (pointer == 0) {
+        int length = getLength();
+        if (length == 0) {
             return -1;
         }
-        return getIndexForQName(pointer, qName);
+        String[] qNames = qNames();
+        for (int i = 0; i < length; i++) {
+            if (qNames[i] == qName) {
+                return i;
+            }
+        }
+        for (int i = 0; i < length; i++) {
+            if (qNames[i].equals(qName)) {
+                return i;
+            }
+        }
+        // For compatibility, a name without a prefix also matches a prefixed
+        // attribute's local name.
+        if (qName.indexOf(':') == -1) {
+            String[] localNames = localNames();
+            for (int i = 0; i < length; i++) {
+                if (localNames[i].equals(qName)) {
+                    return i;
+                }
+            }
+        }
+        return -1;
     }
 
     public String getType(String uri, String localName) {
@@ -114,37 +190,49 @@ abstract class ExpatAttributes implements Attributes {
     }
 
     public String getValue(String uri, String localName) {
-        if (uri == null) {
-            throw new NullPointerException("uri == null");
-        }
-        if (localName == null) {
-            throw new NullPointerException("localName == null");
-        }
-        long pointer = getPointer();
-        if (pointer == 0) {
-            return null;
-        }
-        return getValue(pointer, uri, localName);
+        int index = getIndex(uri, localName);
+        return index == -1 ? null : getValue(index);
     }
 
     public String getValue(String qName) {
-        if (qName == null) {
-            throw new NullPointerException("qName == null");
+        int index = getIndex(qName);
+        return index == -1 ? null : getValue(index);
+    }
+
+    private String[] qNames() {
+        if (!haveQNames) {
+            int length = getLength();
+            if (qNames == null || qNames.length < length) {
+                qNames = new String[length];
+            }
+            getQNames(getParserPointer(), getPointer(), qNames, length);
+            haveQNames = true;
         }
-        long pointer = getPointer();
-        if (pointer == 0) {
-            return null;
+        return qNames;
+    }
+
+    private String[] localNames() {
+        if (!haveNames) {
+            int length = getLength();
+            if (localNames == null || localNames.length < length) {
+                uris = new String[length];
+                localNames = new String[length];
+            }
+            getNames(getParserPointer(), getPointer(), uris, localNames, length);
+            haveNames = true;
         }
-        return getValueForQName(pointer, qName);
+        return localNames;
+    }
+
+    private String[] uris() {
+        localNames();
+        return uris;
     }
 
-    private static native String getURI(long pointer, long attributePointer, int index);
-    private static native String getLocalName(long pointer, long attributePointer, int index);
-    private static native String getQName(long pointer, long attributePointer, int index);
+    private static native void getQNames(long pointer, long attributePointer, String[] qNames,
+            int count);
+    private static native void getNames(long pointer, long attributePointer, String[] uris,
+            String[] localNames, int count);
     private static native String getValueByIndex(long attributePointer, int index);
-    private static native int getIndex(long attributePointer, String uri, String localName);
-    private static native int getIndexForQName(long attributePointer, String qName);
-    private static native String getValue(long attributePointer, String uri, String localName);
-    private static native String getValueForQName(long attributePointer, String qName);
     protected native void freeAttributes(long pointer);
 }
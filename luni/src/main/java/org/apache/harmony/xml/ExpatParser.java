@@ -23,6 +23,7 @@ import java.net.URI;
 import java.net.URL;
 import java.net.URLConnection;
 import libcore.io.IoUtils;
+import libcore.util.LazyNatives;
 import org.xml.sax.Attributes;
 import org.xml.sax.ContentHandler;
 import org.xml.sax.DTDHandler;
@@ -40,6 +41,9 @@ import org.xml.sax.ext.LexicalHandler;
  * @see org.apache.harmony.xml.ExpatReader
  */
 class ExpatParser {
+    static {
+        LazyNatives.register("expat");
+    }
 
     private static final int BUFFER_SIZE = 8096; // in bytes
 
@@ -61,6 +65,18 @@ class ExpatParser {
 
     private final ExpatAttributes attributes = new CurrentAttributes();
 
+    private final BufferedAttributes bufferedAttributes = new BufferedAttributes();
+
+    /*
+     * Event types for handleEvents. Keep in sync with
+     * org_apache_harmony_xml_ExpatParser.cpp.
+     */
+    private static final int EVENT_START_ELEMENT = 1;
+    private static final int EVENT_END_ELEMENT = 2;
+    private static final int EVENT_TEXT = 3;
+    private static final int EVENT_START_NAMESPACE = 4;
+    private static final int EVENT_END_NAMESPACE = 5;
+
     private static final String OUTSIDE_START_ELEMENT
             = "Attributes can only be used within the scope of startElement().";
 
@@ -77,7 +93,8 @@ class ExpatParser {
      * Constructs a new parser with the specified encoding.
      */
     /*package*/ ExpatParser(String encoding, ExpatReader xmlReader,
-            boolean processNamespaces, String publicId, String systemId) {
+            boolean processNamespaces, boolean sharedInterning, boolean batchEvents,
+            String publicId, String systemId) {
         this.publicId = publicId;
         this.systemId = systemId;
 
@@ -93,7 +110,9 @@ class ExpatParser {
         this.encoding = encoding == null ? DEFAULT_ENCODING : encoding;
         this.pointer = initialize(
             this.encoding,
-            processNamespaces
+            processNamespaces,
+            sharedInterning,
+            batchEvents
         );
     }
 
@@ -112,9 +131,14 @@ class ExpatParser {
     /**
      * Initializes native resources.
      *
+     * @param sharedInterning true to intern names in the table shared by all
+     *  parsers, which outlives this one
+     * @param batchEvents true to receive element, text and namespace events
+     *  in batches through {@link #handleEvents}
      * @return the pointer to the native parser
      */
-    private native long initialize(String encoding, boolean namespacesEnabled);
+    private native long initialize(String encoding, boolean namespacesEnabled,
+            boolean sharedInterning, boolean batchEvents);
 
     /**
      * Called at the start of an element.
@@ -130,8 +154,9 @@ class ExpatParser {
      */
     /*package*/ void startElement(String uri, String localName, String qName,
             int attributePointer, int attributeCount) throws SAXException {
-        ContentHandler contentHandler = xmlReader.contentHandler;
-        if (contentHandler == null) {
+        if (xmlReader.contentHandler == null) {
+            // Still call through so that EntityParser can count elements.
+            startElement(uri, localName, qName, ClonedAttributes.EMPTY);
             return;
         }
 
@@ -139,9 +164,9 @@ class ExpatParser {
             inStartElement = true;
             this.attributePointer = attributePointer;
             this.attributeCount = attributeCount;
+            attributes.clearCache();
 
-            contentHandler.startElement(
-                    uri, localName, qName, this.attributes);
+            startElement(uri, localName, qName, this.attributes);
         } finally {
             inStartElement = false;
             this.attributeCount = -1;
@@ -149,6 +174,14 @@ class ExpatParser {
         }
     }
 
+    /*package*/ void startElement(String uri, String localName, String qName,
+            Attributes attributes) throws SAXException {
+        ContentHandler contentHandler = xmlReader.contentHandler;
+        if (contentHandler != null) {
+            contentHandler.startElement(uri, localName, qName, attributes);
+        }
+    }
+
     /*package*/ void endElement(String uri, String localName, String qName)
             throws SAXException {
         ContentHandler contentHandler = xmlReader.contentHandler;
@@ -164,6 +197,58 @@ class ExpatParser {
         }
     }
 
+    /**
+     * Called in batch mode with the element, text and namespace events
+     * collected since the last call. The names of elements, attributes and
+     * prefixes are indexes into {@code names}; text and attribute values are
+     * ranges of {@code text}.
+     *
+     * @param events encoded events, see org_apache_harmony_xml_ExpatParser.cpp
+     * @param length number of ints of {@code events} to handle
+     * @param names interned names, shared by all calls for this document
+     * @param text characters of this batch's text and attribute values
+     */
+    /*package*/ void handleEvents(int[] events, int length, String[] names, char[] text)
+            throws SAXException {
+        int i = 0;
+        while (i < length) {
+            switch (events[i]) {
+            case EVENT_START_ELEMENT:
+                int attributeCount = events[i + 4];
+                bufferedAttributes.reset(events, i + 5, attributeCount, names, text);
+                try {
+                    startElement(names[events[i + 1]], names[events[i + 2]],
+                            names[events[i + 3]], bufferedAttributes);
+                } finally {
+                    bufferedAttributes.clear();
+                }
+                i += 5 + attributeCount * BufferedAttributes.FIELD_COUNT;
+                break;
+            case EVENT_END_ELEMENT:
+                endElement(names[events[i + 1]], names[events[i + 2]], names[events[i + 3]]);
+                i += 4;
+                break;
+            case EVENT_TEXT:
+                ContentHandler contentHandler = xmlReader.contentHandler;
+                if (contentHandler != null) {
+                    contentHandler.characters(text, events[i + 1], events[i + 2]);
+                }
+                i += 3;
+                break;
+            case EVENT_START_NAMESPACE:
+                startNamespace(names[events[i + 1]], names[events[i + 2]]);
+                i += 3;
+                break;
+            case EVENT_END_NAMESPACE:
+                endNamespace(names[events[i + 1]]);
+                i += 2;
+                break;
+            default:
+                throw new AssertionError("Unknown event " + events[i]);
+            }
+        }
+    }
+
     /*package*/ void comment(char[] text, int length) throws SAXException {
         LexicalHandler lexicalHandler = xmlReader.lexicalHandler;
         if (lexicalHandler != null) {
@@ -465,6 +550,26 @@ class ExpatParser {
     private native void appendBytes(long pointer, byte[] xml, int offset,
             int length) throws SAXException, ExpatException;
 
+    private native void appendAddress(long pointer, long address, long byteCount,
+            boolean isFinal) throws SAXException, ExpatException;
+
+    /**
+     * Parses a whole XML document held in native memory, such as a direct
+     * buffer or a mapped file. The memory must stay valid until this returns.
+     *
+     * @param address of the first byte of the document
+     * @param byteCount the length of the document
+     */
+    /*package*/ void parseDocument(long address, long byteCount) throws SAXException {
+        startDocument();
+        try {
+            appendAddress(this.pointer, address, byteCount, true);
+        } catch (ExpatException e) {
+            throw new ParseException(e.getMessage(), this.locator);
+        }
+        endDocument();
+    }
+
     /**
      * Parses an XML document from the given input stream.
      */
@@ -567,6 +672,12 @@ class ExpatParser {
      */
     private static native void releaseParser(long pointer);
 
+    /**
+     * Returns the shared intern table's hit count, miss count and size, in
+     * that order.
+     */
+    /*package*/ static native long[] getSharedInternCounters();
+
     /**
      * Initialize static resources.
      */
@@ -772,14 +883,13 @@ class ExpatParser {
 
         @Override
         void startElement(String uri, String localName, String qName,
-                int attributePointer, int attributeCount) throws SAXException {
+                Attributes attributes) throws SAXException {
             /*
              * Skip topmost element generated by our workaround in
              * {@link #handleExternalEntity}.
              */
             if (depth++ > 0) {
-                super.startElement(uri, localName, qName, attributePointer,
-                        attributeCount);
+                super.startElement(uri, localName, qName, attributes);
             }
         }
 
@@ -16,10 +16,17 @@
 
 package org.apache.harmony.xml;
 
+import java.io.ByteArrayInputStream;
+import java.io.File;
 import java.io.IOException;
 import java.io.InputStream;
+import java.io.RandomAccessFile;
 import java.io.Reader;
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
+import libcore.io.ErrnoException;
 import libcore.io.IoUtils;
+import libcore.io.Libcore;
 import org.xml.sax.ContentHandler;
 import org.xml.sax.DTDHandler;
 import org.xml.sax.EntityResolver;
@@ -31,6 +38,9 @@ import org.xml.sax.SAXNotSupportedException;
 import org.xml.sax.XMLReader;
 import org.xml.sax.ext.LexicalHandler;
 
+import static libcore.io.OsConstants.MAP_SHARED;
+import static libcore.io.OsConstants.PROT_READ;
+
 /**
  * SAX wrapper around Expat. Interns strings. Does not support validation.
  * Does not support {@link DTDHandler}.
@@ -48,6 +58,8 @@ public class ExpatReader implements XMLReader {
 
     private boolean processNamespaces = true;
     private boolean processNamespacePrefixes = false;
+    private boolean sharedInterning = false;
+    private boolean batchEvents = false;
 
     private static final String LEXICAL_HANDLER_PROPERTY
             = "http://xml.org/sax/properties/lexical-handler";
@@ -246,7 +258,75 @@ public class ExpatReader implements XMLReader {
         this.processNamespaces = processNamespaces;
     }
 
-    public void parse(InputSource input) throws IOException, SAXException {
+    /**
+     * Returns true if this SAX parser interns names in the table shared by all
+     * parsers.
+     *
+     * @see #setSharedInterningEnabled(boolean)
+     * @hide
+     */
+    public boolean isSharedInterningEnabled() {
+        return sharedInterning;
+    }
+
+    /**
+     * Enables or disables the shared intern table. Set to false by default.
+     * Normally each parse builds its own table of element and attribute names
+     * and discards it at the end. With this enabled, names are looked up in a
+     * bounded table shared by all parsers and kept for the life of the
+     * process, which saves repeating that work when parsing many documents
+     * with the same vocabulary. Names beyond the table's capacity are interned
+     * per parse as usual.
+     *
+     * @see #getSharedInternCounters()
+     * @hide
+     */
+    public void setSharedInterningEnabled(boolean sharedInterning) {
+        this.sharedInterning = sharedInterning;
+    }
+
+    /**
+     * Returns the shared intern table's hit count, miss count and number of
+     * names, in that order. Each parse consults the shared table at most
+     * once per distinct name.
+     *
+     * @hide
+     */
+    public static long[] getSharedInternCounters() {
+        return ExpatParser.getSharedInternCounters();
+    }
+
+    /**
+     * Returns true if this SAX parser delivers events in batches.
+     *
+     * @see #setEventBatchingEnabled(boolean)
+     * @hide
+     */
+    public boolean isEventBatchingEnabled() {
+        return batchEvents;
+    }
+
+    /**
+     * Enables or disables event batching. Set to false by default. Normally
+     * every SAX event is a separate call from native code. With batching
+     * enabled, element, character and prefix mapping events are queued in
+     * native code and passed up many at a time, which is much cheaper for
+     * documents with many small elements. Other events flush the queue first,
+     * so handlers still see events in document order, but a {@link
+     * org.xml.sax.Locator} reports the position at which the batch was
+     * delivered rather than that of each event.
+     *
+     * @hide
+     */
+    public void setEventBatchingEnabled(boolean batchEvents) {
+        this.batchEvents = batchEvents;
+    }
+
+    /**
+     * Throws if the enabled features can't be honored together. Every public
+     * parse method calls this before reading any input.
+     */
+    private void checkFeatures() throws SAXNotSupportedException {
         if (processNamespacePrefixes && processNamespaces) {
             /*
              * Expat has XML_SetReturnNSTriplet, but that still doesn't
@@ -259,6 +339,10 @@ public class ExpatReader implements XMLReader {
                     "feature is not supported while the 'namespaces' " +
                     "feature is enabled.");
         }
+    }
+
+    public void parse(InputSource input) throws IOException, SAXException {
+        checkFeatures();
 
         // Try the character stream.
         Reader reader = input.getCharacterStream();
@@ -303,6 +387,8 @@ public class ExpatReader implements XMLReader {
                 ExpatParser.CHARACTER_ENCODING,
                 this,
                 processNamespaces,
+                sharedInterning,
+                batchEvents,
                 publicId,
                 systemId
         );
@@ -312,11 +398,79 @@ public class ExpatReader implements XMLReader {
     private void parse(InputStream in, String charsetName, String publicId, String systemId)
             throws IOException, SAXException {
         ExpatParser parser =
-            new ExpatParser(charsetName, this, processNamespaces, publicId, systemId);
+            new ExpatParser(charsetName, this, processNamespaces, sharedInterning, batchEvents,
+                    publicId, systemId);
         parser.parseDocument(in);
     }
 
     public void parse(String systemId) throws IOException, SAXException {
         parse(new InputSource(systemId));
     }
+
+    /**
+     * Parses the remaining bytes of {@code buffer} as an XML document in the
+     * given encoding, or UTF-8 if {@code encoding} is null. Direct buffers are
+     * parsed in place, without copying. The buffer's position is not changed.
+     *
+     * @hide
+     */
+    public void parse(ByteBuffer buffer, String encoding) throws IOException, SAXException {
+        checkFeatures();
+        ExpatParser parser = new ExpatParser(encoding, this, processNamespaces, sharedInterning,
+                batchEvents, null, null);
+        long address = buffer.isDirect() ? NioUtils.unsafeAddress(buffer) : 0;
+        if (address != 0) {
+            parser.parseDocument(address + buffer.position(), buffer.remaining());
+        } else {
+            byte[] bytes;
+            int offset;
+            if (buffer.hasArray()) {
+                bytes = buffer.array();
+                offset = buffer.arrayOffset() + buffer.position();
+            } else {
+                bytes = new byte[buffer.remaining()];
+                offset = 0;
+                buffer.duplicate().get(bytes);
+            }
+            parser.parseDocument(new ByteArrayInputStream(bytes, offset, buffer.remaining()));
+        }
+    }
+
+    /**
+     * Parses {@code file} as an XML document in the given encoding, or UTF-8
+     * if {@code encoding} is null. The file is mapped into memory and parsed
+     * in place, rather than read through a buffer.
+     *
+     * @hide
+     */
+    public void parse(File file, String encoding) throws IOException, SAXException {
+        checkFeatures();
+        RandomAccessFile raf = new RandomAccessFile(file, "r");
+        try {
+            long size = raf.length();
+            if (size == 0) {
+                // There's nothing to map, but let Expat report the error.
+                parse(ByteBuffer.allocate(0), encoding);
+                return;
+            }
+            long address;
+            try {
+                address = Libcore.os.mmap(0L, size, PROT_READ, MAP_SHARED, raf.getFD(), 0);
+            } catch (ErrnoException errnoException) {
+                throw errnoException.rethrowAsIOException();
+            }
+            try {
+                ExpatParser parser = new ExpatParser(encoding, this, processNamespaces,
+                        sharedInterning, batchEvents, null, file.toURI().toString());
+                parser.parseDocument(address, size);
+            } finally {
+                try {
+                    Libcore.os.munmap(address, size);
+                } catch (ErrnoException ignored) {
+                }
+            }
+        } finally {
+            raf.close();
+        }
+    }
 }
@@ -17,6 +17,7 @@
 #define LOG_TAG "AsynchronousSocketCloseMonitor"
 
 #include "AsynchronousSocketCloseMonitor.h"
+#include "NativeCounters.h"
 #include "cutils/log.h"
 
 #include <errno.h>
@@ -24,15 +25,50 @@
 #include <string.h>
 
 /**
- * We use an intrusive doubly-linked list to keep track of blocked threads.
+ * We use intrusive doubly-linked lists to keep track of blocked threads.
  * This gives us O(1) insertion and removal, and means we don't need to do any allocation.
  * (The objects themselves are stack-allocated.)
- * Waking potentially-blocked threads when a socket is closed is O(n) in the total number of
- * blocked threads (not the number of threads actually blocked on the socket in question).
- * For now at least, this seems like a good compromise for Android.
+ * The lists are sharded by fd, so waking potentially-blocked threads when a socket is closed
+ * is O(n) in the number of threads blocked on fds in the same bucket rather than in the total
+ * number of blocked threads, and unrelated sockets don't contend on the same mutex.
  */
-static pthread_mutex_t blockedThreadListMutex = PTHREAD_MUTEX_INITIALIZER;
-static AsynchronousSocketCloseMonitor* blockedThreadList = NULL;
+struct BlockedThreadBucket {
+    pthread_mutex_t mutex;
+    AsynchronousSocketCloseMonitor* list;
+    uint64_t counters[AsynchronousSocketCloseMonitor::COUNTER_COUNT];
+};
+
+// A power of two, so bucketFor is a mask. Consecutive fds land in different buckets.
+static const size_t BLOCKED_THREAD_BUCKET_COUNT = 64;
+static BlockedThreadBucket blockedThreadBuckets[BLOCKED_THREAD_BUCKET_COUNT];
+
+static BlockedThreadBucket& bucketFor(int fd) {
+    return blockedThreadBuckets[static_cast<unsigned>(fd) & (BLOCKED_THREAD_BUCKET_COUNT - 1)];
+}
+
+/**
+ * Like ScopedPthreadMutexLock, but counts how often we had to wait for the bucket's lock.
+ */
+class ScopedBucketLock {
+public:
+    explicit ScopedBucketLock(BlockedThreadBucket& bucket) : mBucket(bucket) {
+        if (pthread_mutex_trylock(&mBucket.mutex) != 0) {
+            pthread_mutex_lock(&mBucket.mutex);
+            ++mBucket.counters[AsynchronousSocketCloseMonitor::COUNTER_CONTENDED];
+        }
+    }
+
+    ~ScopedBucketLock() {
+        pthread_mutex_unlock(&mBucket.mutex);
+    }
+
+private:
+    BlockedThreadBucket& mBucket;
+
+    // Disallow copy and assignment.
+    ScopedBucketLock(const ScopedBucketLock&);
+    void operator=(const ScopedBucketLock&);
+};
 
 /**
  * The specific signal chosen here is arbitrary.
@@ -48,6 +84,10 @@ static void blockedThreadSignalHandler(int /*signal*/) {
 }
 
 void AsynchronousSocketCloseMonitor::init() {
+    for (size_t i = 0; i < BLOCKED_THREAD_BUCKET_COUNT; ++i) {
+        pthread_mutex_init(&blockedThreadBuckets[i].mutex, NULL);
+    }
+
     // Ensure that the signal we send interrupts system calls but doesn't kill threads.
     // Using sigaction(2) lets us ensure that the SA_RESTART flag is not set.
     // (The whole reason we're sending this signal is to unblock system calls!)
@@ -62,38 +102,61 @@ void AsynchronousSocketCloseMonitor::init() {
 }
 
 void AsynchronousSocketCloseMonitor::signalBlockedThreads(int fd) {
-    ScopedPthreadMutexLock lock(&blockedThreadListMutex);
-    for (AsynchronousSocketCloseMonitor* it = blockedThreadList; it != NULL; it = it->mNext) {
+    BlockedThreadBucket& bucket = bucketFor(fd);
+    ScopedBucketLock lock(bucket);
+    for (AsynchronousSocketCloseMonitor* it = bucket.list; it != NULL; it = it->mNext) {
         if (it->mFd == fd) {
             pthread_kill(it->mThread, BLOCKED_THREAD_SIGNAL);
+            ++bucket.counters[COUNTER_SIGNALS];
             // Keep going, because there may be more than one thread...
         }
     }
 }
 
-AsynchronousSocketCloseMonitor::AsynchronousSocketCloseMonitor(int fd) {
-    ScopedPthreadMutexLock lock(&blockedThreadListMutex);
+void AsynchronousSocketCloseMonitor::getCounters(uint64_t* counters) {
+    memset(counters, 0, COUNTER_COUNT * sizeof(uint64_t));
+    for (size_t i = 0; i < BLOCKED_THREAD_BUCKET_COUNT; ++i) {
+        BlockedThreadBucket& bucket = blockedThreadBuckets[i];
+        ScopedPthreadMutexLock lock(&bucket.mutex);
+        for (size_t j = 0; j < COUNTER_COUNT; ++j) {
+            counters[j] += bucket.counters[j];
+        }
+    }
+}
+
+AsynchronousSocketCloseMonitor::AsynchronousSocketCloseMonitor(int fd)
+        : mStartNanos(nativeCountersNanos()) {
+    BlockedThreadBucket& bucket = bucketFor(fd);
+    ScopedBucketLock lock(bucket);
     // Who are we, and what are we waiting for?
     mThread = pthread_self();
     mFd = fd;
     // Insert ourselves at the head of the intrusive doubly-linked list...
     mPrev = NULL;
-    mNext = blockedThreadList;
+    mNext = bucket.list;
     if (mNext != NULL) {
         mNext->mPrev = this;
     }
-    blockedThreadList = this;
+    bucket.list = this;
+    ++bucket.counters[COUNTER_MONITORS];
 }
 
 AsynchronousSocketCloseMonitor::~AsynchronousSocketCloseMonitor() {
-    ScopedPthreadMutexLock lock(&blockedThreadListMutex);
-    // Unlink ourselves from the intrusive doubly-linked list...
-    if (mNext != NULL) {
-        mNext->mPrev = mPrev;
-    }
-    if (mPrev == NULL) {
-        blockedThreadList = mNext;
-    } else {
-        mPrev->mNext = mNext;
+    // Callers check errno from the blocked call after this runs.
+    int savedErrno = errno;
+    {
+        BlockedThreadBucket& bucket = bucketFor(mFd);
+        ScopedBucketLock lock(bucket);
+        // Unlink ourselves from the intrusive doubly-linked list...
+        if (mNext != NULL) {
+            mNext->mPrev = mPrev;
+        }
+        if (mPrev == NULL) {
+            bucket.list = mNext;
+        } else {
+            mPrev->mNext = mNext;
+        }
     }
+    nativeHistogramRecord(HISTOGRAM_BLOCKED_MICROS, (nativeCountersNanos() - mStartNanos) / 1000);
+    errno = savedErrno;
 }
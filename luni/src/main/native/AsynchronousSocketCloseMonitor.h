@@ -19,6 +19,7 @@
 
 #include "ScopedPthreadMutexLock.h"
 #include <pthread.h>
+#include <stdint.h>
 
 /**
  * AsynchronousSocketCloseMonitor helps implement Java's asynchronous Socket.close semantics.
@@ -36,6 +37,10 @@
  * To interrupt all threads currently blocked on file descriptor 'fd', call signalBlockedThreads:
  *
  *   AsynchronousSocketCloseMonitor::signalBlockedThreads(fd);
+ *
+ * Blocked threads are kept in a fixed number of buckets hashed by fd, each with its own lock,
+ * so both registration and signalBlockedThreads only contend with threads whose fds share a
+ * bucket. getCounters reports how often that contention actually happened.
  */
 class AsynchronousSocketCloseMonitor {
 public:
@@ -46,11 +51,26 @@ public:
 
     static void signalBlockedThreads(int fd);
 
+    enum Counter {
+        // The number of blocking calls that have been monitored.
+        COUNTER_MONITORS,
+        // The number of registry lock acquisitions that had to wait for another thread.
+        COUNTER_CONTENDED,
+        // The number of threads woken by signalBlockedThreads.
+        COUNTER_SIGNALS,
+        COUNTER_COUNT
+    };
+
+    // Sums each Counter across the registry into 'counters', which must have COUNTER_COUNT slots.
+    static void getCounters(uint64_t* counters);
+
 private:
     AsynchronousSocketCloseMonitor* mPrev;
     AsynchronousSocketCloseMonitor* mNext;
     pthread_t mThread;
     int mFd;
+    // When the blocking call started, for NativeCounters' HISTOGRAM_BLOCKED_MICROS.
+    int64_t mStartNanos;
 
     // Disallow copy and assignment.
     AsynchronousSocketCloseMonitor(const AsynchronousSocketCloseMonitor&);
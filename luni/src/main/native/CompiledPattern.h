@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPILED_PATTERN_H_included
+#define COMPILED_PATTERN_H_included
+
+#include <stdint.h>
+#include <vector>
+
+#include "jni.h"
+#include "unicode/regex.h"
+
+/**
+ * A pattern simple enough to find without ICU's backtracking engine: a literal, an
+ * alternation of literals, or a run of white space. None of these has groups, anchors or
+ * empty matches, so a search only has to find the leftmost position where one of them
+ * matches, trying the alternatives in order as ICU would.
+ */
+struct FastPattern {
+    enum Kind {
+        NONE,
+        LITERALS,          // foo, foo|bar, \Q...\E
+        WHITESPACE,        // \s
+        WHITESPACE_RUN     // \s+
+    };
+
+    // Only searching for up to this many distinct first chars is vectorized.
+    static const size_t MAX_VECTOR_FIRST_CHARS = 4;
+
+    FastPattern() : kind(NONE) {
+    }
+
+    Kind kind;
+    // For LITERALS, the alternatives in the order they appear in the pattern. None is empty.
+    std::vector<std::vector<jchar> > literals;
+    // For LITERALS, the distinct first chars of the alternatives.
+    std::vector<jchar> firstChars;
+};
+
+/**
+ * A compiled ICU RegexPattern, shared by every java.util.regex.Pattern with the same regular
+ * expression and flags. The RegexPattern itself is read-only once compiled, so any number of
+ * threads can use it at once. Each Pattern and each Matcher holds a reference, as does the
+ * cache while the entry is in it; the last release deletes it.
+ *
+ * The entry also keeps a few idle RegexMatchers, so that short-lived Matchers (such as those
+ * created by String.split and String.matches) don't allocate a new one every time.
+ */
+class CompiledPattern {
+public:
+    // Takes ownership of 'pattern'. The new entry has a reference count of one.
+    CompiledPattern(RegexPattern* pattern, const FastPattern& fastPattern);
+
+    RegexPattern* pattern() {
+        return mPattern;
+    }
+
+    // ICU still compiles every pattern, for the operations the fast path doesn't handle.
+    const FastPattern& fastPattern() const {
+        return mFastPattern;
+    }
+
+    void retain();
+    void release();
+
+    // Returns a RegexMatcher for this pattern, reusing an idle one if possible, and retains
+    // this entry until the matcher is given back with recycleMatcher.
+    RegexMatcher* newMatcher(UErrorCode& status);
+    void recycleMatcher(RegexMatcher* matcher);
+
+private:
+    ~CompiledPattern();
+
+    RegexPattern* mPattern;
+    const FastPattern mFastPattern;
+    volatile int32_t mRefCount;
+    std::vector<RegexMatcher*> mIdleMatchers;
+
+    // Disallow copy and assignment.
+    CompiledPattern(const CompiledPattern&);
+    void operator=(const CompiledPattern&);
+};
+
+CompiledPattern* toCompiledPattern(jlong address);
+
+#endif  // COMPILED_PATTERN_H_included
@@ -16,14 +16,33 @@
 
 #include <stdio.h>  // For BUFSIZ
 
+#include "JniConstants.h"
 #include "JniException.h"
 #include "JNIHelp.h"
+#include "ScopedLocalRef.h"
 
 void jniThrowExceptionWithErrno(JNIEnv* env, const char* exceptionClassName, int error) {
     char buf[BUFSIZ];
     jniThrowException(env, exceptionClassName, jniStrError(error, buf, sizeof(buf)));
 }
 
+void jniThrowErrnoException(JNIEnv* env, const char* functionName, int error) {
+    static jmethodID ctor = env->GetMethodID(JniConstants::errnoExceptionClass,
+            "<init>", "(Ljava/lang/String;I)V");
+    ScopedLocalRef<jstring> detailMessage(env, env->NewStringUTF(functionName));
+    if (detailMessage.get() == NULL) {
+        // Not much we can do here. Carry on with a null message.
+        env->ExceptionClear();
+    }
+    jobject exception = env->NewObject(JniConstants::errnoExceptionClass, ctor, detailMessage.get(), error);
+    if (exception == NULL) {
+        // NewObject has already thrown, probably an OutOfMemoryError.
+        return;
+    }
+    env->Throw(reinterpret_cast<jthrowable>(exception));
+    env->DeleteLocalRef(exception);
+}
+
 void jniThrowOutOfMemoryError(JNIEnv* env, const char* message) {
     jniThrowException(env, "java/lang/OutOfMemoryError", message);
 }
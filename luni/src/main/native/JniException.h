@@ -21,6 +21,9 @@
 
 void jniThrowExceptionWithErrno(JNIEnv* env, const char* exceptionClassName, int error);
 
+// Throws a libcore.io.ErrnoException for a failure of 'functionName' with the given errno value.
+void jniThrowErrnoException(JNIEnv* env, const char* functionName, int error);
+
 void jniThrowOutOfMemoryError(JNIEnv* env, const char* message);
 void jniThrowSocketException(JNIEnv* env, int error);
 
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "NativeCounters"
+
+#include "NativeCounters.h"
+
+#include "JNIHelp.h"
+#include "JniConstants.h"
+#include "ScopedPrimitiveArray.h"
+#include "ScopedPthreadMutexLock.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Each thread's counts live in a ThreadSlots that only it writes. ThreadSlots are never freed:
+ * when a thread exits, its slots are marked unused and the next new thread takes them over,
+ * adding to the counts already there, since only the totals are ever reported. So the list only
+ * grows as far as the most threads that have counted something at once, and snapshots can walk
+ * it without a lock.
+ */
+struct ThreadSlots {
+    uint64_t counters[COUNTER_COUNT];
+    uint64_t histograms[HISTOGRAM_COUNT][NATIVE_HISTOGRAM_BUCKET_COUNT];
+    // Set before the slots are published, and never changed after.
+    ThreadSlots* next;
+    bool inUse;
+};
+
+static ThreadSlots* gSlotsList;
+static pthread_once_t gSlotsKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t gSlotsKey;
+
+static void releaseSlots(void* slots) {
+    __atomic_store_n(&static_cast<ThreadSlots*>(slots)->inUse, false, __ATOMIC_RELEASE);
+}
+
+static void initSlotsKey() {
+    pthread_key_create(&gSlotsKey, releaseSlots);
+}
+
+static ThreadSlots* threadSlots() {
+    pthread_once(&gSlotsKeyOnce, initSlotsKey);
+    ThreadSlots* slots = static_cast<ThreadSlots*>(pthread_getspecific(gSlotsKey));
+    if (slots != NULL) {
+        return slots;
+    }
+    for (slots = __atomic_load_n(&gSlotsList, __ATOMIC_ACQUIRE); slots != NULL;
+            slots = slots->next) {
+        bool expected = false;
+        if (__atomic_compare_exchange_n(&slots->inUse, &expected, true, false,
+                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    if (slots == NULL) {
+        slots = new ThreadSlots;
+        memset(slots, 0, sizeof(*slots));
+        slots->inUse = true;
+        slots->next = __atomic_load_n(&gSlotsList, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&gSlotsList, &slots->next, slots, true,
+                __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+    pthread_setspecific(gSlotsKey, slots);
+    return slots;
+}
+
+// Only the owning thread writes a slot, so this needn't be an atomic read-modify-write, but the
+// store mustn't tear under a concurrent snapshot.
+static inline void slotAdd(uint64_t* slot, uint64_t delta) {
+    __atomic_store_n(slot, __atomic_load_n(slot, __ATOMIC_RELAXED) + delta, __ATOMIC_RELAXED);
+}
+
+void nativeCounterAdd(NativeCounter counter, uint64_t delta) {
+    slotAdd(&threadSlots()->counters[counter], delta);
+}
+
+void nativeHistogramRecord(NativeHistogram histogram, uint64_t value) {
+    unsigned bucket = (value == 0) ? 0 : 64 - __builtin_clzll(value);
+    if (bucket >= NATIVE_HISTOGRAM_BUCKET_COUNT) {
+        bucket = NATIVE_HISTOGRAM_BUCKET_COUNT - 1;
+    }
+    slotAdd(&threadSlots()->histograms[histogram][bucket], 1);
+}
+
+int64_t nativeCountersNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * Trace markers are written to the kernel's trace_marker file in the format systrace
+ * understands. The file is opened the first time tracing is turned on and never closed, so
+ * that a thread still inside a traced scope can't write to a reused descriptor.
+ */
+static pthread_mutex_t gTraceMutex = PTHREAD_MUTEX_INITIALIZER;
+static int gTraceFd = -1;
+// Set with a release store after gTraceFd is opened, so an acquire load that sees it true
+// also sees the descriptor.
+static bool gTracing;
+
+bool nativeTraceBegin(const char* name) {
+    if (!__atomic_load_n(&gTracing, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    int savedErrno = errno;
+    char marker[128];
+    int length = snprintf(marker, sizeof(marker), "B|%d|%s", getpid(), name);
+    if (length >= static_cast<int>(sizeof(marker))) {
+        length = sizeof(marker) - 1;
+    }
+    TEMP_FAILURE_RETRY(write(gTraceFd, marker, length));
+    errno = savedErrno;
+    return true;
+}
+
+void nativeTraceEnd() {
+    // Traced scopes end between a system call and its caller's errno check.
+    int savedErrno = errno;
+    TEMP_FAILURE_RETRY(write(gTraceFd, "E", 1));
+    errno = savedErrno;
+}
+
+static jboolean NativeCounters_setTracingEnabled(JNIEnv*, jclass, jboolean enabled) {
+    ScopedPthreadMutexLock lock(&gTraceMutex);
+    if (enabled && gTraceFd == -1) {
+        static const char* const paths[] = {
+            "/sys/kernel/debug/tracing/trace_marker",
+            "/sys/kernel/tracing/trace_marker",
+        };
+        for (size_t i = 0; i < NELEM(paths) && gTraceFd == -1; ++i) {
+            gTraceFd = TEMP_FAILURE_RETRY(open(paths[i], O_WRONLY | O_CLOEXEC));
+        }
+    }
+    bool tracing = enabled && gTraceFd != -1;
+    __atomic_store_n(&gTracing, tracing, __ATOMIC_RELEASE);
+    return tracing;
+}
+
+static jlongArray NativeCounters_getSnapshot(JNIEnv* env, jclass) {
+    const size_t length = COUNTER_COUNT + HISTOGRAM_COUNT * NATIVE_HISTOGRAM_BUCKET_COUNT;
+    jlongArray result = env->NewLongArray(length);
+    if (result == NULL) {
+        return NULL;
+    }
+    ScopedLongArrayRW snapshot(env, result);
+    if (snapshot.get() == NULL) {
+        return NULL;
+    }
+    for (ThreadSlots* slots = __atomic_load_n(&gSlotsList, __ATOMIC_ACQUIRE); slots != NULL;
+            slots = slots->next) {
+        for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+            snapshot[i] += __atomic_load_n(&slots->counters[i], __ATOMIC_RELAXED);
+        }
+        for (size_t h = 0; h < HISTOGRAM_COUNT; ++h) {
+            for (size_t b = 0; b < NATIVE_HISTOGRAM_BUCKET_COUNT; ++b) {
+                snapshot[COUNTER_COUNT + h * NATIVE_HISTOGRAM_BUCKET_COUNT + b] +=
+                        __atomic_load_n(&slots->histograms[h][b], __ATOMIC_RELAXED);
+            }
+        }
+    }
+    return result;
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(NativeCounters, getSnapshot, "()[J"),
+    NATIVE_METHOD(NativeCounters, setTracingEnabled, "(Z)Z"),
+};
+void register_libcore_util_NativeCounters(JNIEnv* env) {
+    jniRegisterNativeMethods(env, "libcore/util/NativeCounters", gMethods, NELEM(gMethods));
+}
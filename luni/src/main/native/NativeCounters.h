@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NATIVE_COUNTERS_H_included
+#define NATIVE_COUNTERS_H_included
+
+#include <stdint.h>
+
+/**
+ * Counters and histograms for the hot paths of libcore's native I/O, for
+ * libcore.util.NativeCounters to report. Each thread updates slots of its own, so an update
+ * costs a thread-specific lookup and an add to memory no other thread writes. Snapshots sum
+ * every thread's slots without taking a lock.
+ *
+ * Keep these in sync with NativeCounters.java.
+ */
+enum NativeCounter {
+    // Posix system calls retried because they failed with EINTR.
+    COUNTER_EINTR_RETRIES,
+    // Returns from sslSelect's poll(2), and those where the socket wasn't ready after all
+    // because the wakeup was another thread's sslNotify or a signal.
+    COUNTER_SSL_SELECT_WAKEUPS,
+    COUNTER_SSL_SELECT_SPURIOUS_WAKEUPS,
+    // Bytes zlib consumed and produced for Inflater and Deflater.
+    COUNTER_INFLATER_BYTES_IN,
+    COUNTER_INFLATER_BYTES_OUT,
+    COUNTER_DEFLATER_BYTES_IN,
+    COUNTER_DEFLATER_BYTES_OUT,
+    COUNTER_COUNT
+};
+
+enum NativeHistogram {
+    // Microseconds threads spent blocked under an AsynchronousSocketCloseMonitor.
+    HISTOGRAM_BLOCKED_MICROS,
+    HISTOGRAM_COUNT
+};
+
+// Bucket 0 counts zeros, and bucket i counts values from 2^(i-1) up to 2^i. The last bucket
+// also counts everything bigger.
+static const unsigned NATIVE_HISTOGRAM_BUCKET_COUNT = 32;
+
+void nativeCounterAdd(NativeCounter counter, uint64_t delta);
+void nativeHistogramRecord(NativeHistogram histogram, uint64_t value);
+
+// The current CLOCK_MONOTONIC time in nanoseconds, for timing histogram values.
+int64_t nativeCountersNanos();
+
+bool nativeTraceBegin(const char* name);
+void nativeTraceEnd();
+
+/**
+ * Brackets a step with systrace begin and end markers while
+ * NativeCounters.setTracingEnabled(true) is in effect, and otherwise costs a load and a branch:
+ *
+ *   {
+ *     ScopedNativeTrace trace("inflate");
+ *     err = inflate(&stream, Z_SYNC_FLUSH);
+ *   }
+ *
+ * 'name' must be a string literal, or otherwise outlive the scope.
+ */
+class ScopedNativeTrace {
+public:
+    explicit ScopedNativeTrace(const char* name) : mTraced(nativeTraceBegin(name)) {
+    }
+
+    ~ScopedNativeTrace() {
+        if (mTraced) {
+            nativeTraceEnd();
+        }
+    }
+
+private:
+    bool mTraced;
+
+    // Disallow copy and assignment.
+    ScopedNativeTrace(const ScopedNativeTrace&);
+    void operator=(const ScopedNativeTrace&);
+};
+
+#endif  // NATIVE_COUNTERS_H_included
@@ -32,6 +32,7 @@
 
 // Mac OS has a 64-bit off_t and no 32-bit compatibility cruft.
 #define flock64 flock
+typedef off_t loff_t;
 #define ftruncate64 ftruncate
 #define isnanf __inline_isnanf
 #define lseek64 lseek
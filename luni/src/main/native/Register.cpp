@@ -17,12 +17,238 @@
 #define LOG_TAG "libcore" // We'll be next to "dalvikvm" in the log; make the distinction clear.
 
 #include "cutils/log.h"
+#include "JNIHelp.h"
 #include "JniConstants.h"
 #include "ScopedLocalFrame.h"
+#include "ScopedLocalRef.h"
+#include "ScopedPthreadMutexLock.h"
+#include "ScopedUtfChars.h"
+#include "StartupProfile.h"
 
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 
-// DalvikVM calls this on startup, so we can statically register all our native methods.
+typedef void (*RegisterFunction)(JNIEnv*);
+
+// A registration step, named for StartupProfile.
+struct RegisterStep {
+    const char* name;
+    RegisterFunction fn;
+};
+#define STEP(FN) { #FN, FN }
+
+#define DECLARE(FN) extern void FN(JNIEnv*);
+DECLARE(register_java_io_Console)
+DECLARE(register_java_io_File)
+DECLARE(register_java_io_ObjectStreamClass)
+DECLARE(register_java_lang_Character)
+DECLARE(register_java_lang_Double)
+DECLARE(register_java_lang_Float)
+DECLARE(register_java_lang_Math)
+DECLARE(register_java_lang_ProcessManager)
+DECLARE(register_java_lang_RealToString)
+DECLARE(register_java_lang_StrictMath)
+DECLARE(register_java_lang_StringToReal)
+DECLARE(register_java_lang_System)
+DECLARE(register_java_math_NativeBN)
+DECLARE(register_java_nio_ByteOrder)
+DECLARE(register_java_nio_charset_Charsets)
+DECLARE(register_java_text_Bidi)
+DECLARE(register_java_util_regex_Matcher)
+DECLARE(register_java_util_regex_Pattern)
+DECLARE(register_java_util_zip_Adler32)
+DECLARE(register_java_util_zip_CRC32)
+DECLARE(register_java_util_zip_Deflater)
+DECLARE(register_java_util_zip_Inflater)
+DECLARE(register_java_util_zip_ParallelDeflater)
+DECLARE(register_libcore_icu_AlphabeticIndex)
+DECLARE(register_libcore_icu_DateIntervalFormat)
+DECLARE(register_libcore_icu_ICU)
+DECLARE(register_libcore_icu_NativeBreakIterator)
+DECLARE(register_libcore_icu_NativeCollation)
+DECLARE(register_libcore_icu_NativeConverter)
+DECLARE(register_libcore_icu_NativeDecimalFormat)
+DECLARE(register_libcore_icu_NativeIDN)
+DECLARE(register_libcore_icu_NativeNormalizer)
+DECLARE(register_libcore_icu_NativePluralRules)
+DECLARE(register_libcore_icu_TimeZoneNames)
+DECLARE(register_libcore_icu_Transliterator)
+DECLARE(register_libcore_io_AsyncResolver)
+DECLARE(register_libcore_io_AsynchronousCloseMonitor)
+DECLARE(register_libcore_io_IoUring)
+DECLARE(register_libcore_io_Memory)
+DECLARE(register_libcore_io_OsConstants)
+DECLARE(register_libcore_io_Posix)
+DECLARE(register_libcore_net_RawSocket)
+DECLARE(register_libcore_util_ArrayMath)
+DECLARE(register_libcore_util_Clocks)
+DECLARE(register_libcore_util_NativeCounters)
+DECLARE(register_libcore_util_StartupProfile)
+DECLARE(register_org_apache_harmony_dalvik_NativeTestTarget)
+DECLARE(register_org_apache_harmony_xml_ExpatParser)
+DECLARE(register_sun_misc_Unsafe)
+#undef DECLARE
+extern void init_libcore_icu_data();
+
+// Everything the VM itself needs, or that nearly every process touches while starting up.
+static const RegisterStep gEagerFunctions[] = {
+    STEP(register_java_io_Console),
+    STEP(register_java_io_File),
+    STEP(register_java_io_ObjectStreamClass),
+    STEP(register_java_lang_Character),
+    STEP(register_java_lang_Double),
+    STEP(register_java_lang_Float),
+    STEP(register_java_lang_Math),
+    STEP(register_java_lang_ProcessManager),
+    STEP(register_java_lang_RealToString),
+    STEP(register_java_lang_StrictMath),
+    STEP(register_java_lang_StringToReal),
+    STEP(register_java_lang_System),
+    STEP(register_java_math_NativeBN),
+    STEP(register_java_nio_ByteOrder),
+    STEP(register_java_nio_charset_Charsets),
+    STEP(register_java_text_Bidi),
+    STEP(register_java_util_regex_Matcher),
+    STEP(register_java_util_regex_Pattern),
+    STEP(register_libcore_io_AsyncResolver),
+    STEP(register_libcore_io_AsynchronousCloseMonitor),
+    STEP(register_libcore_io_IoUring),
+    STEP(register_libcore_io_Memory),
+    STEP(register_libcore_io_OsConstants),
+    STEP(register_libcore_io_Posix),
+    STEP(register_libcore_util_ArrayMath),
+    STEP(register_libcore_util_Clocks),
+    STEP(register_libcore_util_NativeCounters),
+    STEP(register_org_apache_harmony_dalvik_NativeTestTarget),
+    STEP(register_sun_misc_Unsafe),
+    { NULL, NULL }
+};
+
+/*
+ * The lazily-registered groups. Every class with natives in a group calls
+ * LazyNatives.register with the group's name from its static initializer, which runs before
+ * any of its methods can be called.
+ */
+static const RegisterStep gIcuFunctions[] = {
+    STEP(register_libcore_icu_AlphabeticIndex),
+    STEP(register_libcore_icu_DateIntervalFormat),
+    STEP(register_libcore_icu_ICU),
+    STEP(register_libcore_icu_NativeBreakIterator),
+    STEP(register_libcore_icu_NativeCollation),
+    STEP(register_libcore_icu_NativeConverter),
+    STEP(register_libcore_icu_NativeDecimalFormat),
+    STEP(register_libcore_icu_NativeIDN),
+    STEP(register_libcore_icu_NativeNormalizer),
+    STEP(register_libcore_icu_NativePluralRules),
+    STEP(register_libcore_icu_TimeZoneNames),
+    STEP(register_libcore_icu_Transliterator),
+    { NULL, NULL }
+};
+static const RegisterStep gExpatFunctions[] = {
+    STEP(register_org_apache_harmony_xml_ExpatParser),
+    { NULL, NULL }
+};
+static const RegisterStep gRawSocketFunctions[] = {
+    STEP(register_libcore_net_RawSocket),
+    { NULL, NULL }
+};
+static const RegisterStep gZipFunctions[] = {
+    STEP(register_java_util_zip_Adler32),
+    STEP(register_java_util_zip_CRC32),
+    STEP(register_java_util_zip_Deflater),
+    STEP(register_java_util_zip_Inflater),
+    STEP(register_java_util_zip_ParallelDeflater),
+    { NULL, NULL }
+};
+
+struct NativeGroup {
+    const char* name;
+    const RegisterStep* steps;
+    // How long registration took, or -1 if it hasn't happened.
+    int64_t nanos;
+};
+
+// Guarded by gGroupsMutex, which is recursive in case registering one class initializes another.
+static NativeGroup gGroups[] = {
+    { "eager", gEagerFunctions, -1 },
+    { "expat", gExpatFunctions, -1 },
+    { "icu", gIcuFunctions, -1 },
+    { "rawsocket", gRawSocketFunctions, -1 },
+    { "zip", gZipFunctions, -1 },
+};
+static pthread_mutex_t gGroupsMutex;
+
+static void registerGroup(JNIEnv* env, NativeGroup& group) {
+    ScopedPthreadMutexLock lock(&gGroupsMutex);
+    if (group.nanos != -1) {
+        return;
+    }
+    // Mark the group first so a re-entrant call on this thread returns rather than recursing.
+    group.nanos = 0;
+    int64_t start = startupProfileNanos();
+    ScopedLocalFrame localFrame(env);
+    for (const RegisterStep* step = group.steps; step->fn != NULL; ++step) {
+        ScopedStartupEvent event(step->name);
+        step->fn(env);
+    }
+    group.nanos = startupProfileNanos() - start;
+}
+
+static void LazyNatives_register(JNIEnv* env, jclass, jstring javaGroup) {
+    ScopedUtfChars groupName(env, javaGroup);
+    if (groupName.c_str() == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < NELEM(gGroups); ++i) {
+        if (strcmp(gGroups[i].name, groupName.c_str()) == 0) {
+            registerGroup(env, gGroups[i]);
+            return;
+        }
+    }
+    jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException", "no native group '%s'",
+            groupName.c_str());
+}
+
+static jobjectArray LazyNatives_getGroupNames(JNIEnv* env, jclass) {
+    jobjectArray result = env->NewObjectArray(NELEM(gGroups), JniConstants::stringClass, NULL);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < NELEM(gGroups); ++i) {
+        ScopedLocalRef<jstring> name(env, env->NewStringUTF(gGroups[i].name));
+        if (name.get() == NULL) {
+            return NULL;
+        }
+        env->SetObjectArrayElement(result, i, name.get());
+    }
+    return result;
+}
+
+static jlongArray LazyNatives_getRegistrationNanos(JNIEnv* env, jclass) {
+    jlong nanos[NELEM(gGroups)];
+    {
+        ScopedPthreadMutexLock lock(&gGroupsMutex);
+        for (size_t i = 0; i < NELEM(gGroups); ++i) {
+            nanos[i] = gGroups[i].nanos;
+        }
+    }
+    jlongArray result = env->NewLongArray(NELEM(gGroups));
+    if (result != NULL) {
+        env->SetLongArrayRegion(result, 0, NELEM(gGroups), nanos);
+    }
+    return result;
+}
+
+static JNINativeMethod gLazyNativesMethods[] = {
+    NATIVE_METHOD(LazyNatives, getGroupNames, "()[Ljava/lang/String;"),
+    NATIVE_METHOD(LazyNatives, getRegistrationNanos, "()[J"),
+    NATIVE_METHOD(LazyNatives, register, "(Ljava/lang/String;)V"),
+};
+
+// DalvikVM calls this on startup, so we can statically register our native methods. Only the
+// "eager" group is registered here unless LIBCORE_EAGER_JNI is set in the environment, in which
+// case every group is, as they all used to be.
 int JNI_OnLoad(JavaVM* vm, void*) {
     JNIEnv* env;
     if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
@@ -30,51 +256,27 @@ int JNI_OnLoad(JavaVM* vm, void*) {
         abort();
     }
 
+    ScopedStartupEvent event("JNI_OnLoad");
     ScopedLocalFrame localFrame(env);
 
-#define REGISTER(FN) extern void FN(JNIEnv*); FN(env)
-    REGISTER(register_java_io_Console);
-    REGISTER(register_java_io_File);
-    REGISTER(register_java_io_ObjectStreamClass);
-    REGISTER(register_java_lang_Character);
-    REGISTER(register_java_lang_Double);
-    REGISTER(register_java_lang_Float);
-    REGISTER(register_java_lang_Math);
-    REGISTER(register_java_lang_ProcessManager);
-    REGISTER(register_java_lang_RealToString);
-    REGISTER(register_java_lang_StrictMath);
-    REGISTER(register_java_lang_StringToReal);
-    REGISTER(register_java_lang_System);
-    REGISTER(register_java_math_NativeBN);
-    REGISTER(register_java_nio_ByteOrder);
-    REGISTER(register_java_nio_charset_Charsets);
-    REGISTER(register_java_text_Bidi);
-    REGISTER(register_java_util_regex_Matcher);
-    REGISTER(register_java_util_regex_Pattern);
-    REGISTER(register_java_util_zip_Adler32);
-    REGISTER(register_java_util_zip_CRC32);
-    REGISTER(register_java_util_zip_Deflater);
-    REGISTER(register_java_util_zip_Inflater);
-    REGISTER(register_libcore_icu_AlphabeticIndex);
-    REGISTER(register_libcore_icu_DateIntervalFormat);
-    REGISTER(register_libcore_icu_ICU);
-    REGISTER(register_libcore_icu_NativeBreakIterator);
-    REGISTER(register_libcore_icu_NativeCollation);
-    REGISTER(register_libcore_icu_NativeConverter);
-    REGISTER(register_libcore_icu_NativeDecimalFormat);
-    REGISTER(register_libcore_icu_NativeIDN);
-    REGISTER(register_libcore_icu_NativeNormalizer);
-    REGISTER(register_libcore_icu_NativePluralRules);
-    REGISTER(register_libcore_icu_TimeZoneNames);
-    REGISTER(register_libcore_icu_Transliterator);
-    REGISTER(register_libcore_io_AsynchronousCloseMonitor);
-    REGISTER(register_libcore_io_Memory);
-    REGISTER(register_libcore_io_OsConstants);
-    REGISTER(register_libcore_io_Posix);
-    REGISTER(register_libcore_net_RawSocket);
-    REGISTER(register_org_apache_harmony_dalvik_NativeTestTarget);
-    REGISTER(register_org_apache_harmony_xml_ExpatParser);
-    REGISTER(register_sun_misc_Unsafe);
-#undef REGISTER
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&gGroupsMutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    {
+        ScopedStartupEvent icuEvent("init_libcore_icu_data");
+        init_libcore_icu_data();
+    }
+    jniRegisterNativeMethods(env, "libcore/util/LazyNatives", gLazyNativesMethods,
+            NELEM(gLazyNativesMethods));
+    register_libcore_util_StartupProfile(env);
+    bool eager = (getenv("LIBCORE_EAGER_JNI") != NULL);
+    for (size_t i = 0; i < NELEM(gGroups); ++i) {
+        if (i == 0 || eager) {
+            registerGroup(env, gGroups[i]);
+        }
+    }
     return JNI_VERSION_1_6;
 }
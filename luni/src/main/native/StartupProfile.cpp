@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "StartupProfile"
+
+#include "StartupProfile.h"
+
+#include "JNIHelp.h"
+#include "JniConstants.h"
+#include "ScopedLocalRef.h"
+#include "ScopedPthreadMutexLock.h"
+
+#include <malloc.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// The layout of each event in StartupProfile.getEvents. Keep in sync with StartupProfile.java.
+enum {
+    FIELD_START_NANOS,
+    FIELD_DURATION_NANOS,
+    FIELD_ALLOCATED_BYTES,
+    FIELD_TID,
+    FIELD_COUNT
+};
+
+struct StartupEvent {
+    const char* name;
+    int64_t fields[FIELD_COUNT];
+};
+
+// Events are only ever appended, so readers can copy a prefix and know it won't change.
+static StartupEvent gEvents[STARTUP_PROFILE_CAPACITY];
+static unsigned gEventCount;
+static pthread_mutex_t gEventsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Only touched atomically, so that dropping an event never takes gEventsMutex.
+static uint32_t gDroppedEventCount;
+// When the first event started, which opens the startup window.
+static int64_t gWindowStartNanos;
+// Set once gEvents is full or the startup window has passed, and read without the lock, so that
+// scopes opened after that pay for neither the clock nor mallinfo(3), which walks the heap in
+// dlmalloc.
+static bool gClosed;
+
+int64_t startupProfileNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+// mallinfo(3) is process-wide, so an event's allocations include any other threads' made at the
+// same time. During startup there usually aren't any.
+static int64_t allocatedBytes() {
+    return static_cast<int64_t>(mallinfo().uordblks);
+}
+
+ScopedStartupEvent::ScopedStartupEvent(const char* name)
+        : mName(name), mStartNanos(-1), mStartAllocatedBytes(0) {
+    if (__atomic_load_n(&gClosed, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    int64_t now = startupProfileNanos();
+    int64_t windowStart = 0;
+    if (!__atomic_compare_exchange_n(&gWindowStartNanos, &windowStart, now, false,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED) &&
+            now - windowStart > STARTUP_PROFILE_WINDOW_NANOS) {
+        __atomic_store_n(&gClosed, true, __ATOMIC_RELEASE);
+        return;
+    }
+    mStartAllocatedBytes = allocatedBytes();
+    mStartNanos = startupProfileNanos();
+}
+
+static void dropEvent() {
+    __atomic_add_fetch(&gDroppedEventCount, 1, __ATOMIC_RELAXED);
+}
+
+ScopedStartupEvent::~ScopedStartupEvent() {
+    if (mStartNanos == -1) {
+        dropEvent();
+        return;
+    }
+    int64_t endNanos = startupProfileNanos();
+    int64_t endAllocatedBytes = allocatedBytes();
+    ScopedPthreadMutexLock lock(&gEventsMutex);
+    if (gEventCount == STARTUP_PROFILE_CAPACITY) {
+        dropEvent();
+        return;
+    }
+    StartupEvent& event = gEvents[gEventCount++];
+    event.name = mName;
+    event.fields[FIELD_START_NANOS] = mStartNanos;
+    event.fields[FIELD_DURATION_NANOS] = endNanos - mStartNanos;
+    event.fields[FIELD_ALLOCATED_BYTES] = endAllocatedBytes - mStartAllocatedBytes;
+    event.fields[FIELD_TID] = syscall(__NR_gettid);
+    if (gEventCount == STARTUP_PROFILE_CAPACITY) {
+        __atomic_store_n(&gClosed, true, __ATOMIC_RELEASE);
+    }
+}
+
+static unsigned eventCount() {
+    ScopedPthreadMutexLock lock(&gEventsMutex);
+    return gEventCount;
+}
+
+static jint StartupProfile_getDroppedEventCount(JNIEnv*, jclass) {
+    return __atomic_load_n(&gDroppedEventCount, __ATOMIC_RELAXED);
+}
+
+static jobjectArray StartupProfile_getEventNames(JNIEnv* env, jclass) {
+    unsigned count = eventCount();
+    jobjectArray result = env->NewObjectArray(count, JniConstants::stringClass, NULL);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (unsigned i = 0; i < count; ++i) {
+        ScopedLocalRef<jstring> name(env, env->NewStringUTF(gEvents[i].name));
+        if (name.get() == NULL) {
+            return NULL;
+        }
+        env->SetObjectArrayElement(result, i, name.get());
+    }
+    return result;
+}
+
+static jlongArray StartupProfile_getEvents(JNIEnv* env, jclass) {
+    unsigned count = eventCount();
+    jlongArray result = env->NewLongArray(count * FIELD_COUNT);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (unsigned i = 0; i < count; ++i) {
+        env->SetLongArrayRegion(result, i * FIELD_COUNT, FIELD_COUNT,
+                reinterpret_cast<const jlong*>(gEvents[i].fields));
+    }
+    return result;
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(StartupProfile, getDroppedEventCount, "()I"),
+    NATIVE_METHOD(StartupProfile, getEventNames, "()[Ljava/lang/String;"),
+    NATIVE_METHOD(StartupProfile, getEvents, "()[J"),
+};
+void register_libcore_util_StartupProfile(JNIEnv* env) {
+    jniRegisterNativeMethods(env, "libcore/util/StartupProfile", gMethods, NELEM(gMethods));
+}
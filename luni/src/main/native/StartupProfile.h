@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STARTUP_PROFILE_H_included
+#define STARTUP_PROFILE_H_included
+
+#include <stdint.h>
+
+/**
+ * Records how long a step of libjavacore's startup took and how much it allocated, for
+ * libcore.util.StartupProfile to report. Wrap the step in a scope:
+ *
+ *   {
+ *     ScopedStartupEvent event("u_init");
+ *     u_init(&status);
+ *   }
+ *
+ * 'name' must be a string literal, or otherwise outlive the process. Only the first
+ * STARTUP_PROFILE_CAPACITY events that start within STARTUP_PROFILE_WINDOW_NANOS of the first
+ * are kept, so this is cheap enough to leave on: once the table is full or the window has
+ * passed, an event costs an atomic load and an atomic increment.
+ */
+class ScopedStartupEvent {
+public:
+    explicit ScopedStartupEvent(const char* name);
+    ~ScopedStartupEvent();
+
+private:
+    const char* mName;
+    int64_t mStartNanos;
+    int64_t mStartAllocatedBytes;
+
+    // Disallow copy and assignment.
+    ScopedStartupEvent(const ScopedStartupEvent&);
+    void operator=(const ScopedStartupEvent&);
+};
+
+static const unsigned STARTUP_PROFILE_CAPACITY = 256;
+static const int64_t STARTUP_PROFILE_WINDOW_NANOS = 10 * 1000000000LL;
+
+// The current CLOCK_MONOTONIC time, which is what event start times are measured with.
+int64_t startupProfileNanos();
+
+#endif  // STARTUP_PROFILE_H_included
@@ -17,9 +17,15 @@
 
 #include "JniConstants.h"
 #include "JniException.h"
+#include "ScopedPthreadMutexLock.h"
 #include "UniquePtr.h"
 #include "ZipUtilities.h"
 
+#include <map>
+#include <vector>
+
+#include <pthread.h>
+
 void throwExceptionForZlibError(JNIEnv* env, const char* exceptionClassName, int error,
     NativeZipStream* stream) {
   if (error == Z_MEM_ERROR) {
@@ -36,6 +42,10 @@ NativeZipStream::NativeZipStream() : input(NULL), inCap(0), mDict(NULL) {
   stream.opaque = Z_NULL;
   stream.zalloc = Z_NULL;
   stream.zfree = Z_NULL;
+  key.inflate = false;
+  key.noHeader = false;
+  key.level = 0;
+  key.strategy = 0;
 }
 
 NativeZipStream::~NativeZipStream() {
@@ -63,6 +73,10 @@ void NativeZipStream::setDictionary(JNIEnv* env, jbyteArray javaDictionary, int
   mDict.reset(dictionaryBytes.release());
 }
 
+void NativeZipStream::clearDictionary() {
+  mDict.reset();
+}
+
 void NativeZipStream::setInput(JNIEnv* env, jbyteArray buf, jint off, jint len) {
   input.reset(new jbyte[len]);
   if (input.get() == NULL) {
@@ -81,3 +95,77 @@ void NativeZipStream::setInput(JNIEnv* env, jbyteArray buf, jint off, jint len)
 NativeZipStream* toNativeZipStream(jlong address) {
   return reinterpret_cast<NativeZipStream*>(static_cast<uintptr_t>(address));
 }
+
+bool ZipStreamKey::operator<(const ZipStreamKey& rhs) const {
+  if (inflate != rhs.inflate) {
+    return inflate < rhs.inflate;
+  }
+  if (noHeader != rhs.noHeader) {
+    return noHeader < rhs.noHeader;
+  }
+  if (level != rhs.level) {
+    return level < rhs.level;
+  }
+  return strategy < rhs.strategy;
+}
+
+// Idle streams, so that code that creates and ends lots of short-lived Deflaters and Inflaters
+// doesn't pay each time for zlib to allocate (and us to free) its window and hash tables,
+// which is about 256KiB for a deflater. We bound the pool because each idle stream pins that
+// memory.
+static const size_t MAX_IDLE_STREAMS_PER_KEY = 4;
+static const size_t MAX_IDLE_STREAMS = 16;
+
+static pthread_mutex_t gIdleStreamsMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<ZipStreamKey, std::vector<NativeZipStream*> > gIdleStreams;
+static size_t gIdleStreamCount = 0;
+
+NativeZipStream* takeIdleZipStream(const ZipStreamKey& key) {
+  ScopedPthreadMutexLock lock(&gIdleStreamsMutex);
+  std::map<ZipStreamKey, std::vector<NativeZipStream*> >::iterator it = gIdleStreams.find(key);
+  if (it == gIdleStreams.end() || it->second.empty()) {
+    return NULL;
+  }
+  NativeZipStream* stream = it->second.back();
+  it->second.pop_back();
+  --gIdleStreamCount;
+  return stream;
+}
+
+// Returns 'stream' to the state it was in just after initialization for its key.
+static bool resetZipStream(NativeZipStream* stream) {
+  stream->clearDictionary();
+  stream->stream.next_in = NULL;
+  stream->stream.avail_in = 0;
+  stream->stream.next_out = NULL;
+  stream->stream.avail_out = 0;
+  if (stream->key.inflate) {
+    if (inflateReset(&stream->stream) != Z_OK) {
+      return false;
+    }
+    stream->stream.adler = 1;
+    return true;
+  }
+  // Deflater.setLevel and setStrategy may have changed the parameters since initialization.
+  // The stream has no pending output after a reset, so deflateParams won't need to flush.
+  return deflateReset(&stream->stream) == Z_OK &&
+      deflateParams(&stream->stream, stream->key.level, stream->key.strategy) == Z_OK;
+}
+
+void releaseZipStream(NativeZipStream* stream) {
+  if (resetZipStream(stream)) {
+    ScopedPthreadMutexLock lock(&gIdleStreamsMutex);
+    std::vector<NativeZipStream*>& idle = gIdleStreams[stream->key];
+    if (gIdleStreamCount < MAX_IDLE_STREAMS && idle.size() < MAX_IDLE_STREAMS_PER_KEY) {
+      idle.push_back(stream);
+      ++gIdleStreamCount;
+      return;
+    }
+  }
+  if (stream->key.inflate) {
+    inflateEnd(&stream->stream);
+  } else {
+    deflateEnd(&stream->stream);
+  }
+  delete stream;
+}
@@ -22,16 +22,28 @@
 #include "jni.h"
 #include "zlib.h"
 
+// What a z_stream was initialized for. Streams are only reused for the same purpose.
+struct ZipStreamKey {
+    bool inflate;
+    bool noHeader;
+    int level;
+    int strategy;
+
+    bool operator<(const ZipStreamKey& rhs) const;
+};
+
 class NativeZipStream {
 public:
     UniquePtr<jbyte[]> input;
     int inCap;
     z_stream stream;
+    ZipStreamKey key;
 
     NativeZipStream();
     ~NativeZipStream();
     void setDictionary(JNIEnv* env, jbyteArray javaDictionary, int off, int len, bool inflate);
     void setInput(JNIEnv* env, jbyteArray buf, jint off, jint len);
+    void clearDictionary();
 
 private:
     UniquePtr<jbyte[]> mDict;
@@ -43,6 +55,12 @@ private:
 
 NativeZipStream* toNativeZipStream(jlong address);
 
+// Returns an idle stream initialized for 'key', or NULL if there isn't one.
+NativeZipStream* takeIdleZipStream(const ZipStreamKey& key);
+
+// Resets 'stream' and keeps it for takeIdleZipStream if there's room, or ends and deletes it.
+void releaseZipStream(NativeZipStream* stream);
+
 void throwExceptionForZlibError(JNIEnv* env, const char* exceptionClassName, int error,
         NativeZipStream* stream);
 
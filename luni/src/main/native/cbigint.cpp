@@ -15,6 +15,8 @@
  *  limitations under the License.
  */
 
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
 #include "cbigint.h"
 
@@ -276,14 +278,77 @@ void simpleMultiplyAddHighPrecisionBigEndianFix(uint64_t* arg1, int32_t length,
 }
 #endif
 
+static void schoolbookMultiplyHighPrecision(uint64_t* arg1, int32_t length1, uint64_t* arg2, int32_t length2, uint64_t* result) {
+    /* Assumes length1 >= length2, and that result holds length1 + length2 words. */
+    uint32_t* resultIn32 = reinterpret_cast<uint32_t*>(result);
+    int32_t index = -1;
+
+    memset(result, 0, sizeof(uint64_t) * (length1 + length2));
+    for (int32_t count = 0; count < length2; ++count) {
+        simpleMultiplyAddHighPrecision(arg1, length1, LOW_IN_U64(arg2[count]), resultIn32 + (++index));
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+        simpleMultiplyAddHighPrecision(arg1, length1, HIGH_IN_U64(arg2[count]), resultIn32 + (++index));
+#else
+        simpleMultiplyAddHighPrecisionBigEndianFix(arg1, length1, HIGH_IN_U64(arg2[count]), resultIn32 + (++index));
+#endif
+    }
+}
+
+/* Below this many words in the shorter operand, Karatsuba's extra additions cost more than
+ * the multiplications they save. */
+#define KARATSUBA_THRESHOLD 16
+
+static void karatsubaMultiplyHighPrecision(uint64_t* arg1, int32_t length1, uint64_t* arg2, int32_t length2, uint64_t* result) {
+    /* Assumes length1 >= length2, and that result holds length1 + length2 words. Operands
+     * more than twice as long as each other gain little from splitting, so they just use
+     * the schoolbook method. */
+    if (length2 < KARATSUBA_THRESHOLD || length2 * 2 <= length1) {
+        schoolbookMultiplyHighPrecision(arg1, length1, arg2, length2, result);
+        return;
+    }
+
+    /* arg1 = high1 * B^half + low1, and likewise arg2. The product is
+     * z2 * B^(2 * half) + (z1 - z2 - z0) * B^half + z0, where z0 = low1 * low2,
+     * z2 = high1 * high2, and z1 = (high1 + low1) * (high2 + low2). */
+    int32_t half = length2 / 2;
+    int32_t highLength1 = length1 - half;
+    int32_t highLength2 = length2 - half;
+    int32_t sumLength1 = highLength1 + 1;
+    int32_t sumLength2 = highLength2 + 1;
+    int32_t middleLength = sumLength1 + sumLength2;
+    uint64_t* sum1 = reinterpret_cast<uint64_t*>(malloc(sizeof(uint64_t) * (sumLength1 + sumLength2 + middleLength)));
+    if (sum1 == NULL) {
+        schoolbookMultiplyHighPrecision(arg1, length1, arg2, length2, result);
+        return;
+    }
+    uint64_t* sum2 = sum1 + sumLength1;
+    uint64_t* middle = sum2 + sumLength2;
+
+    memcpy(sum1, arg1 + half, sizeof(uint64_t) * highLength1);
+    sum1[highLength1] = 0;
+    addHighPrecision(sum1, sumLength1, arg1, half);
+    memcpy(sum2, arg2 + half, sizeof(uint64_t) * highLength2);
+    sum2[highLength2] = 0;
+    addHighPrecision(sum2, sumLength2, arg2, half);
+    karatsubaMultiplyHighPrecision(sum1, sumLength1, sum2, sumLength2, middle);
+
+    /* z0 and z2 go straight into their places in the result. */
+    karatsubaMultiplyHighPrecision(arg1, half, arg2, half, result);
+    karatsubaMultiplyHighPrecision(arg1 + half, highLength1, arg2 + half, highLength2, result + 2 * half);
+
+    subtractHighPrecision(middle, middleLength, result, 2 * half);
+    subtractHighPrecision(middle, middleLength, result + 2 * half, highLength1 + highLength2);
+    addHighPrecision(result + half, length1 + length2 - half, middle, middleLength);
+    free(sum1);
+}
+
 void
 multiplyHighPrecision (uint64_t * arg1, int32_t length1, uint64_t * arg2, int32_t length2,
                        uint64_t * result, int32_t length)
 {
   /* assumes result is large enough to hold product */
   uint64_t* temp;
-  uint32_t* resultIn32;
-  int32_t count, index;
+  int32_t count;
 
   if (length1 < length2)
     {
@@ -298,18 +363,7 @@ multiplyHighPrecision (uint64_t * arg1, int32_t length1, uint64_t * arg2, int32_
   memset (result, 0, sizeof (uint64_t) * length);
 
   /* length1 > length2 */
-  resultIn32 = reinterpret_cast<uint32_t*>(result);
-  index = -1;
-  for (count = 0; count < length2; ++count)
-    {
-      simpleMultiplyAddHighPrecision (arg1, length1, LOW_IN_U64 (arg2[count]),
-                                      resultIn32 + (++index));
-#if __BYTE_ORDER == __LITTLE_ENDIAN
-      simpleMultiplyAddHighPrecision(arg1, length1, HIGH_IN_U64(arg2[count]), resultIn32 + (++index));
-#else
-      simpleMultiplyAddHighPrecisionBigEndianFix(arg1, length1, HIGH_IN_U64(arg2[count]), resultIn32 + (++index));
-#endif
-    }
+  karatsubaMultiplyHighPrecision (arg1, length1, arg2, length2, result);
 }
 
 uint32_t
@@ -335,6 +389,22 @@ simpleAppendDecimalDigitHighPrecision (uint64_t * arg1, int32_t length, uint64_t
   return HIGH_U32_FROM_VAR (digit);
 }
 
+static uint64_t simpleMultiplyHighPrecision64(uint64_t* arg1, int32_t length, uint64_t arg2);
+
+uint64_t simpleAppendDecimalDigitsHighPrecision(uint64_t* arg1, int32_t length, uint64_t digits, int32_t count) {
+    /* Appends the count (at most 19) decimal digits in digits in one pass rather than count
+     * passes, returning the overflow word. */
+    uint64_t tenToTheCount = 1;
+    for (int32_t i = 0; i < count; ++i) {
+        tenToTheCount *= 10;
+    }
+    uint64_t overflow = simpleMultiplyHighPrecision64(arg1, length, tenToTheCount);
+    /* (arg1 * 10^count + digits) < (arg1 + 1) * 10^count, so adding overflow's carry
+     * can't overflow it in turn. */
+    overflow += simpleAddHighPrecision(arg1, length, digits);
+    return overflow;
+}
+
 void
 simpleShiftLeftHighPrecision (uint64_t * arg1, int32_t length, int32_t arg2)
 {
@@ -671,7 +741,75 @@ toDoubleHighPrecision (uint64_t * arg, int32_t length)
   return result;
 }
 
-static uint64_t simpleMultiplyHighPrecision64(uint64_t* arg1, int32_t length, uint64_t arg2);
+/* 10^(19 * 2^k) for k < TEN_E19_POWERS, built on first use by repeated squaring. Entry k
+ * starts at tenE19Powers + tenE19PowerOffsets[k] and is tenE19PowerLengths[k] words long.
+ * Together they cover 10^e for any e < 19 * 2^TEN_E19_POWERS in at most TEN_E19_POWERS
+ * multiplications. */
+#define TEN_E19_POWERS 7
+#define TEN_E19_POWER_WORDS (1 + 2 + 4 + 8 + 16 + 32 + 64)
+static uint64_t tenE19Powers[TEN_E19_POWER_WORDS];
+static int32_t tenE19PowerOffsets[TEN_E19_POWERS];
+static int32_t tenE19PowerLengths[TEN_E19_POWERS];
+static pthread_once_t tenE19PowersOnce = PTHREAD_ONCE_INIT;
+
+static void initTenE19Powers() {
+    int32_t offset = 0;
+    tenE19Powers[0] = TEN_E19;
+    tenE19PowerOffsets[0] = 0;
+    tenE19PowerLengths[0] = 1;
+    for (int k = 1; k < TEN_E19_POWERS; ++k) {
+        uint64_t* previous = tenE19Powers + offset;
+        int32_t previousLength = tenE19PowerLengths[k - 1];
+        offset += 1 << (k - 1);
+        /* The square of an n-word number fits in 2n words, which is entry k's room. */
+        uint64_t* square = tenE19Powers + offset;
+        int32_t squareLength = 2 * previousLength;
+        multiplyHighPrecision(previous, previousLength, previous, previousLength, square, squareLength);
+        while (square[squareLength - 1] == 0) {
+            --squareLength;
+        }
+        tenE19PowerOffsets[k] = offset;
+        tenE19PowerLengths[k] = squareLength;
+    }
+}
+
+/* Multiplies the length words of result by 10^(19 * count) and returns the new length. */
+static int32_t multiplyByTenToThe19sHighPrecision(uint64_t* result, int32_t length, int32_t count) {
+    if (count == 0) {
+        return length;
+    }
+    pthread_once(&tenE19PowersOnce, initTenE19Powers);
+
+    int32_t largest = TEN_E19_POWERS - 1;
+    uint64_t* product = reinterpret_cast<uint64_t*>(malloc(sizeof(uint64_t) * (length + count + tenE19PowerLengths[largest])));
+    if (product == NULL) {
+        /* Fall back to one short multiplication at a time. */
+        while (count-- > 0) {
+            uint64_t overflow = simpleMultiplyHighPrecision64(result, length, TEN_E19);
+            if (overflow) {
+                result[length++] = overflow;
+            }
+        }
+        return length;
+    }
+
+    for (int k = largest; k >= 0; --k) {
+        /* Every power but the largest is needed at most once. */
+        while (count >= (1 << k)) {
+            uint64_t* power = tenE19Powers + tenE19PowerOffsets[k];
+            int32_t productLength = length + tenE19PowerLengths[k];
+            multiplyHighPrecision(result, length, power, tenE19PowerLengths[k], product, productLength);
+            while (productLength > 1 && product[productLength - 1] == 0) {
+                --productLength;
+            }
+            memcpy(result, product, sizeof(uint64_t) * productLength);
+            length = productLength;
+            count -= (1 << k);
+        }
+    }
+    free(product);
+    return length;
+}
 
 int32_t
 timesTenToTheEHighPrecision (uint64_t * result, int32_t length, jint e)
@@ -679,6 +817,7 @@ timesTenToTheEHighPrecision (uint64_t * result, int32_t length, jint e)
   /* assumes result can hold value */
   uint64_t overflow;
   int exp10 = e;
+  int32_t capacity = length;
 
   if (e == 0)
     return length;
@@ -700,13 +839,11 @@ timesTenToTheEHighPrecision (uint64_t * result, int32_t length, jint e)
    * simpleAappendDecimalDigit() so just pick 10e3 as that point for
    * now.
    */
-  while (exp10 >= 19)
-    {
-      overflow = simpleMultiplyHighPrecision64 (result, length, TEN_E19);
-      if (overflow)
-        result[length++] = overflow;
-      exp10 -= 19;
-    }
+  /* Only the words in use need multiplying; the rest of result is zero. */
+  while (length > 1 && result[length - 1] == 0)
+    --length;
+  length = multiplyByTenToThe19sHighPrecision (result, length, exp10 / 19);
+  exp10 %= 19;
   while (exp10 >= 9)
     {
       overflow = simpleMultiplyHighPrecision (result, length, TEN_E9);
@@ -715,7 +852,7 @@ timesTenToTheEHighPrecision (uint64_t * result, int32_t length, jint e)
       exp10 -= 9;
     }
   if (exp10 == 0)
-    return length;
+    return length > capacity ? length : capacity;
   else if (exp10 == 1)
     {
       overflow = simpleAppendDecimalDigitHighPrecision (result, length, 0);
@@ -767,7 +904,7 @@ timesTenToTheEHighPrecision (uint64_t * result, int32_t length, jint e)
       if (overflow)
         result[length++] = overflow;
     }
-  return length;
+  return length > capacity ? length : capacity;
 }
 
 uint64_t
@@ -88,6 +88,7 @@ union U64U32DBL {
 void multiplyHighPrecision(uint64_t* arg1, int32_t length1, uint64_t* arg2, int32_t length2,
         uint64_t* result, int32_t length);
 uint32_t simpleAppendDecimalDigitHighPrecision(uint64_t* arg1, int32_t length, uint64_t digit);
+uint64_t simpleAppendDecimalDigitsHighPrecision(uint64_t* arg1, int32_t length, uint64_t digits, int32_t count);
 jdouble toDoubleHighPrecision(uint64_t* arg, int32_t length);
 uint64_t doubleMantissa(jdouble z);
 int32_t compareHighPrecision(uint64_t* arg1, int32_t length1, uint64_t* arg2, int32_t length2);
@@ -20,20 +20,26 @@
 #include "JNIHelp.h"
 #include "JniConstants.h"
 #include "JniException.h"
+#include "ScopedLocalRef.h"
 #include "ScopedPrimitiveArray.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedUtfChars.h"
 #include "readlink.h"
-#include "toStringArray.h"
 
+#include <list>
+#include <map>
 #include <string>
 #include <vector>
 
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
@@ -53,21 +59,151 @@ static jstring File_readlink(JNIEnv* env, jclass, jstring javaPath) {
     return env->NewStringUTF(result.c_str());
 }
 
+extern bool realpath(const char* path, std::string& resolved);
+extern bool realpathFrom(const std::string& canonicalPrefix, const char* relative,
+                         std::string& resolved);
+
+// Class loading and resource lookup canonicalize paths in the same few deep directories over
+// and over, so we remember what the directory part of each path resolved to. A cached entry is
+// only used if the directory is still the same inode with the same modification time, and the
+// kernel's own name for it (via /proc/self/fd) is still the canonical path we cached: a rename,
+// a new symbolic link anywhere along the path, or a replaced directory all cause a fresh
+// resolution. Checking costs a handful of system calls however deep the path is.
+struct CachedDirectory {
+    std::string canonical;
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+};
+
+static const size_t MAX_CACHED_DIRECTORIES = 256;
+
+typedef std::list<std::pair<std::string, CachedDirectory> > CachedDirectoryList;
+static pthread_mutex_t gCachedDirectoriesLock = PTHREAD_MUTEX_INITIALIZER;
+static CachedDirectoryList gCachedDirectories;
+static std::map<std::string, CachedDirectoryList::iterator> gCachedDirectoriesByPath;
+
+// Fills in everything but 'canonical' for the directory 'path' as the kernel sees it now, and
+// returns the kernel's name for it in 'kernelPath'.
+static bool statCachedDirectory(const std::string& path, CachedDirectory& result,
+                                std::string& kernelPath) {
+#if defined(__linux__) && defined(O_PATH)
+    int fd = TEMP_FAILURE_RETRY(open(path.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC));
+    if (fd == -1) {
+        return false;
+    }
+    struct stat sb;
+    char procPath[32];
+    snprintf(procPath, sizeof(procPath), "/proc/self/fd/%d", fd);
+    bool ok = (fstat(fd, &sb) == 0) && readlink(procPath, kernelPath);
+    close(fd);
+    if (ok) {
+        result.dev = sb.st_dev;
+        result.ino = sb.st_ino;
+        result.mtime = sb.st_mtime;
+    }
+    return ok;
+#else
+    // Without a way to ask the kernel for a directory's name, we can't validate entries.
+    return false;
+#endif
+}
+
+static bool findCachedDirectory(const std::string& directory, std::string& canonical) {
+    CachedDirectory cached;
+    {
+        ScopedPthreadMutexLock lock(&gCachedDirectoriesLock);
+        std::map<std::string, CachedDirectoryList::iterator>::iterator it =
+                gCachedDirectoriesByPath.find(directory);
+        if (it == gCachedDirectoriesByPath.end()) {
+            return false;
+        }
+        gCachedDirectories.splice(gCachedDirectories.begin(), gCachedDirectories, it->second);
+        cached = it->second->second;
+    }
+
+    // Validate outside the lock; the file system may block.
+    CachedDirectory current;
+    std::string kernelPath;
+    if (statCachedDirectory(directory, current, kernelPath) && kernelPath == cached.canonical &&
+            current.dev == cached.dev && current.ino == cached.ino && current.mtime == cached.mtime) {
+        canonical = cached.canonical;
+        return true;
+    }
+
+    ScopedPthreadMutexLock lock(&gCachedDirectoriesLock);
+    std::map<std::string, CachedDirectoryList::iterator>::iterator it =
+            gCachedDirectoriesByPath.find(directory);
+    if (it != gCachedDirectoriesByPath.end()) {
+        gCachedDirectories.erase(it->second);
+        gCachedDirectoriesByPath.erase(it);
+    }
+    return false;
+}
+
+static void addCachedDirectory(const std::string& directory, const std::string& canonical) {
+    // Only cache directories that exist, and where our resolution agrees with the kernel's.
+    CachedDirectory cached;
+    std::string kernelPath;
+    if (!statCachedDirectory(directory, cached, kernelPath) || kernelPath != canonical) {
+        return;
+    }
+    cached.canonical = canonical;
+
+    ScopedPthreadMutexLock lock(&gCachedDirectoriesLock);
+    std::map<std::string, CachedDirectoryList::iterator>::iterator it =
+            gCachedDirectoriesByPath.find(directory);
+    if (it != gCachedDirectoriesByPath.end()) {
+        it->second->second = cached;
+        gCachedDirectories.splice(gCachedDirectories.begin(), gCachedDirectories, it->second);
+        return;
+    }
+    gCachedDirectories.push_front(std::make_pair(directory, cached));
+    gCachedDirectoriesByPath[directory] = gCachedDirectories.begin();
+    if (gCachedDirectories.size() > MAX_CACHED_DIRECTORIES) {
+        gCachedDirectoriesByPath.erase(gCachedDirectories.back().first);
+        gCachedDirectories.pop_back();
+    }
+}
+
+static bool cachedRealpath(const char* path, std::string& resolved) {
+    // Split off the last component. Paths directly under "/", or with a trailing slash, aren't
+    // worth caching.
+    const char* lastSlash = strrchr(path, '/');
+    if (lastSlash == NULL || lastSlash == path || lastSlash[1] == '\0') {
+        return realpath(path, resolved);
+    }
+    std::string directory(path, lastSlash - path);
+    std::string canonical;
+    if (!findCachedDirectory(directory, canonical)) {
+        if (!realpath(directory.c_str(), canonical)) {
+            return false;
+        }
+        addCachedDirectory(directory, canonical);
+    }
+    return realpathFrom(canonical, lastSlash + 1, resolved);
+}
+
 static jstring File_realpath(JNIEnv* env, jclass, jstring javaPath) {
     ScopedUtfChars path(env, javaPath);
     if (path.c_str() == NULL) {
         return NULL;
     }
 
-    extern bool realpath(const char* path, std::string& resolved);
     std::string result;
-    if (!realpath(path.c_str(), result)) {
+    if (!cachedRealpath(path.c_str(), result)) {
         jniThrowIOException(env, errno);
         return NULL;
     }
     return env->NewStringUTF(result.c_str());
 }
 
+static void File_clearRealpathCache(JNIEnv*, jclass) {
+    ScopedPthreadMutexLock lock(&gCachedDirectoriesLock);
+    gCachedDirectories.clear();
+    gCachedDirectoriesByPath.clear();
+}
+
 static jboolean File_setLastModifiedImpl(JNIEnv* env, jclass, jstring javaPath, jlong ms) {
     ScopedUtfChars path(env, javaPath);
     if (path.c_str() == NULL) {
@@ -87,28 +223,105 @@ static jboolean File_setLastModifiedImpl(JNIEnv* env, jclass, jstring javaPath,
     return (utime(path.c_str(), &times) == 0);
 }
 
-// Iterates over the filenames in the given directory.
-class ScopedReaddir {
+// Iterates over the entries in the given directory. On Linux we read with getdents64(2) straight
+// into a large buffer: readdir(3) in bionic has a buffer of only a few entries, so it costs a
+// system call per handful of names. Names point into the buffer and are only valid until the
+// next call to next().
+class ScopedDirectory {
 public:
-    ScopedReaddir(const char* path) {
-        mDirStream = opendir(path);
-        mIsBad = (mDirStream == NULL);
+    ScopedDirectory(const char* path) {
+        mFd = TEMP_FAILURE_RETRY(open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+        mIsBad = (mFd == -1);
+#if defined(__linux__)
+        // On the heap: this would be a large fraction of a thread's stack.
+        mBuffer = new char[kBufferSize];
+        mPosition = mLimit = 0;
+#else
+        mDirStream = mIsBad ? NULL : fdopendir(mFd);
+        if (!mIsBad && mDirStream == NULL) {
+            close(mFd);
+            mFd = -1;
+            mIsBad = true;
+        }
+#endif
     }
 
-    ~ScopedReaddir() {
+    ~ScopedDirectory() {
+#if defined(__linux__)
+        delete[] mBuffer;
+        if (mFd != -1) {
+            close(mFd);
+        }
+#else
         if (mDirStream != NULL) {
             closedir(mDirStream);
         }
+#endif
+    }
+
+    // Returns the next filename other than "." and "..", or NULL. Sets 'type' to the entry's
+    // d_type, which may be DT_UNKNOWN on file systems that don't record it.
+    const char* next(unsigned char& type) {
+        const char* name;
+        do {
+            name = nextEntry(type);
+        } while (name != NULL && name[0] == '.' &&
+                 (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')));
+        return name;
+    }
+
+    // Returns the directory's fd, for use with the *at(2) functions.
+    int fd() const {
+        return mFd;
+    }
+
+    // Has an error occurred on this stream?
+    bool isBad() const {
+        return mIsBad;
+    }
+
+private:
+#if defined(__linux__)
+    struct linux_dirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[];
+    };
+
+    const char* nextEntry(unsigned char& type) {
+        if (mIsBad) {
+            return NULL;
+        }
+        if (mPosition >= mLimit) {
+            long byteCount = TEMP_FAILURE_RETRY(syscall(__NR_getdents64, mFd, mBuffer, kBufferSize));
+            if (byteCount <= 0) {
+                mIsBad = (byteCount == -1);
+                return NULL;
+            }
+            mPosition = 0;
+            mLimit = byteCount;
+        }
+        linux_dirent64* entry = reinterpret_cast<linux_dirent64*>(mBuffer + mPosition);
+        mPosition += entry->d_reclen;
+        type = entry->d_type;
+        return entry->d_name;
     }
 
-    // Returns the next filename, or NULL.
-    const char* next() {
+    static const size_t kBufferSize = 64 * 1024;
+    char* mBuffer;
+    size_t mPosition;
+    size_t mLimit;
+#else
+    const char* nextEntry(unsigned char& type) {
         if (mIsBad) {
             return NULL;
         }
         errno = 0;
         dirent* result = readdir(mDirStream);
         if (result != NULL) {
+            type = result->d_type;
             return result->d_name;
         }
         if (errno != 0) {
@@ -117,52 +330,135 @@ public:
         return NULL;
     }
 
-    // Has an error occurred on this stream?
-    bool isBad() const {
-        return mIsBad;
-    }
-
-private:
     DIR* mDirStream;
+#endif
+    int mFd;
     bool mIsBad;
 
     // Disallow copy and assignment.
-    ScopedReaddir(const ScopedReaddir&);
-    void operator=(const ScopedReaddir&);
+    ScopedDirectory(const ScopedDirectory&);
+    void operator=(const ScopedDirectory&);
 };
 
-typedef std::vector<std::string> DirEntries;
+// The names from a directory, packed NUL-terminated into one buffer rather than one std::string
+// each, along with their d_type values and (optionally) what fstatat(2) says about them.
+struct DirEntries {
+    std::vector<char> names;
+    std::vector<size_t> offsets;
+    std::vector<jbyte> types;
+    // Three values per entry: mode, size, and modification time in milliseconds. The mode is 0
+    // for entries that vanished between the read and the fstatat(2).
+    std::vector<jlong> stats;
+
+    size_t size() const {
+        return offsets.size();
+    }
+
+    const char* name(size_t i) const {
+        return &names[offsets[i]];
+    }
+};
 
-// Reads the directory referred to by 'pathBytes', adding each directory entry
+// Reads the directory referred to by 'javaPath', adding each directory entry
 // to 'entries'.
-static bool readDirectory(JNIEnv* env, jstring javaPath, DirEntries& entries) {
+static bool readDirectory(JNIEnv* env, jstring javaPath, DirEntries& entries, bool withStats) {
     ScopedUtfChars path(env, javaPath);
     if (path.c_str() == NULL) {
         return false;
     }
 
-    ScopedReaddir dir(path.c_str());
+    ScopedDirectory dir(path.c_str());
     const char* filename;
-    while ((filename = dir.next()) != NULL) {
-        if (strcmp(filename, ".") != 0 && strcmp(filename, "..") != 0) {
-            // TODO: this hides allocation failures from us. Push directory iteration up into Java?
-            entries.push_back(filename);
+    unsigned char type;
+    while ((filename = dir.next(type)) != NULL) {
+        // TODO: this hides allocation failures from us. Push directory iteration up into Java?
+        entries.offsets.push_back(entries.names.size());
+        entries.names.insert(entries.names.end(), filename, filename + strlen(filename) + 1);
+        entries.types.push_back(type);
+        if (withStats) {
+            struct stat sb;
+            if (TEMP_FAILURE_RETRY(fstatat(dir.fd(), filename, &sb, 0)) == 0) {
+                entries.stats.push_back(sb.st_mode);
+                entries.stats.push_back(sb.st_size);
+                entries.stats.push_back(static_cast<jlong>(sb.st_mtime) * 1000);
+            } else {
+                entries.stats.insert(entries.stats.end(), 3, 0);
+            }
         }
     }
     return !dir.isBad();
 }
 
+static jobjectArray toStringArray(JNIEnv* env, const DirEntries& entries) {
+    jobjectArray result = env->NewObjectArray(entries.size(), JniConstants::stringClass, NULL);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        ScopedLocalRef<jstring> s(env, env->NewStringUTF(entries.name(i)));
+        if (env->ExceptionCheck()) {
+            return NULL;
+        }
+        env->SetObjectArrayElement(result, i, s.get());
+        if (env->ExceptionCheck()) {
+            return NULL;
+        }
+    }
+    return result;
+}
+
 static jobjectArray File_listImpl(JNIEnv* env, jclass, jstring javaPath) {
     // Read the directory entries into an intermediate form.
     DirEntries entries;
-    if (!readDirectory(env, javaPath, entries)) {
+    if (!readDirectory(env, javaPath, entries, false)) {
         return NULL;
     }
     // Translate the intermediate form into a Java String[].
     return toStringArray(env, entries);
 }
 
+// Returns { String[] names, byte[] types, long[] stats }, with stats null unless requested.
+static jobjectArray File_listEntriesImpl(JNIEnv* env, jclass, jstring javaPath, jboolean withStats) {
+    DirEntries entries;
+    if (!readDirectory(env, javaPath, entries, withStats)) {
+        return NULL;
+    }
+
+    ScopedLocalRef<jobjectArray> names(env, toStringArray(env, entries));
+    if (names.get() == NULL) {
+        return NULL;
+    }
+    ScopedLocalRef<jbyteArray> types(env, env->NewByteArray(entries.size()));
+    if (types.get() == NULL) {
+        return NULL;
+    }
+    if (entries.size() > 0) {
+        env->SetByteArrayRegion(types.get(), 0, entries.size(), &entries.types[0]);
+    }
+    ScopedLocalRef<jlongArray> stats(env, NULL);
+    if (withStats) {
+        stats.reset(env->NewLongArray(entries.stats.size()));
+        if (stats.get() == NULL) {
+            return NULL;
+        }
+        if (!entries.stats.empty()) {
+            env->SetLongArrayRegion(stats.get(), 0, entries.stats.size(), &entries.stats[0]);
+        }
+    }
+
+    jobjectArray result = env->NewObjectArray(3, JniConstants::objectClass, NULL);
+    if (result == NULL) {
+        return NULL;
+    }
+    env->SetObjectArrayElement(result, 0, names.get());
+    env->SetObjectArrayElement(result, 1, types.get());
+    env->SetObjectArrayElement(result, 2, stats.get());
+    return result;
+}
+
 static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(File, clearRealpathCache, "()V"),
+    NATIVE_METHOD(File, listEntriesImpl, "(Ljava/lang/String;Z)[Ljava/lang/Object;"),
     NATIVE_METHOD(File, listImpl, "(Ljava/lang/String;)[Ljava/lang/String;"),
     NATIVE_METHOD(File, readlink, "(Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(File, realpath, "(Ljava/lang/String;)Ljava/lang/String;"),
@@ -20,25 +20,35 @@
 #include "JNIHelp.h"
 #include "JniConstants.h"
 
-static jobject getSignature(JNIEnv* env, jclass c, jobject object) {
-    jmethodID mid = env->GetMethodID(c, "getSignature", "()Ljava/lang/String;");
-    if (!mid) {
-        return NULL;
+// The getSignature methods of Field, Method and Constructor, looked up on first use. Those
+// classes are never unloaded, so the IDs stay valid, and racing lookups store the same value.
+static jmethodID gFieldGetSignature;
+static jmethodID gMethodGetSignature;
+static jmethodID gConstructorGetSignature;
+
+static jobject getSignature(JNIEnv* env, jclass c, jmethodID* cachedMid, jobject object) {
+    jmethodID mid = *cachedMid;
+    if (mid == NULL) {
+        mid = env->GetMethodID(c, "getSignature", "()Ljava/lang/String;");
+        if (!mid) {
+            return NULL;
+        }
+        *cachedMid = mid;
     }
-    jclass objectClass = env->GetObjectClass(object);
-    return env->CallNonvirtualObjectMethod(object, objectClass, mid);
+    return env->CallNonvirtualObjectMethod(object, c, mid);
 }
 
 static jobject ObjectStreamClass_getFieldSignature(JNIEnv* env, jclass, jobject field) {
-    return getSignature(env, JniConstants::fieldClass, field);
+    return getSignature(env, JniConstants::fieldClass, &gFieldGetSignature, field);
 }
 
 static jobject ObjectStreamClass_getMethodSignature(JNIEnv* env, jclass, jobject method) {
-    return getSignature(env, JniConstants::methodClass, method);
+    return getSignature(env, JniConstants::methodClass, &gMethodGetSignature, method);
 }
 
 static jobject ObjectStreamClass_getConstructorSignature(JNIEnv* env, jclass, jobject constructor) {
-    return getSignature(env, JniConstants::constructorClass, constructor);
+    return getSignature(env, JniConstants::constructorClass, &gConstructorGetSignature,
+            constructor);
 }
 
 static jboolean ObjectStreamClass_hasClinit(JNIEnv * env, jclass, jclass targetClass) {
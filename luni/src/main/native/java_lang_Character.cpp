@@ -18,11 +18,15 @@
 
 #include "JNIHelp.h"
 #include "JniConstants.h"
+#include "JniException.h"
 #include "ScopedUtfChars.h"
 #include "unicode/uchar.h"
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h> // For BUFSIZ
 #include <stdlib.h>
+#include <string.h>
+#include <vector>
 
 static jint Character_digitImpl(JNIEnv*, jclass, jint codePoint, jint radix) {
     return u_digit(codePoint, radix);
@@ -136,26 +140,113 @@ static int Character_ofImpl(JNIEnv*, jclass, jint codePoint) {
     return ublock_getCode(codePoint);
 }
 
-static jboolean Character_isAlphabetic(JNIEnv*, jclass, jint codePoint) {
+static jboolean Character_isAlphabeticImpl(JNIEnv*, jclass, jint codePoint) {
   return u_hasBinaryProperty(codePoint, UCHAR_ALPHABETIC);
 }
 
-static jboolean Character_isIdeographic(JNIEnv*, jclass, jint codePoint) {
+static jboolean Character_isIdeographicImpl(JNIEnv*, jclass, jint codePoint) {
   return u_hasBinaryProperty(codePoint, UCHAR_IDEOGRAPHIC);
 }
 
+// The BMP property table is two-stage: the high bits of a char index a block offset, and the
+// block offset plus the low bits index a 16-bit property word. Identical blocks are shared, so
+// the whole BMP fits in a few tens of KiB. The layout (all values in native byte order) is:
+//
+//   jint     BMP_PROPERTIES_VERSION
+//   jint     ICU's Unicode version, packed as UVersionInfo
+//   jint     block count (65536 >> BMP_PROPERTIES_SHIFT)
+//   jint     property word count
+//   jchar    block offsets[block count]
+//   jchar    property words[property word count]
+//
+// Each property word holds the ICU general category in bits 0-4, the ICU directionality in bits
+// 5-9, and the mirrored, identifier ignorable, identifier start, identifier part, alphabetic and
+// ideographic flags in bits 10-15. Character.java knows this layout, so keep the two in sync and
+// bump the version if it changes. Everything else Character needs for BMP chars (letter, digit,
+// case, space, defined) is a function of the general category.
+static const jint BMP_PROPERTIES_VERSION = 1;
+static const int BMP_PROPERTIES_SHIFT = 6;
+static const int BMP_PROPERTIES_BLOCK_SIZE = 1 << BMP_PROPERTIES_SHIFT;
+static const int BMP_PROPERTIES_HEADER_SIZE = 4;
+
+static pthread_once_t gBmpPropertiesOnce = PTHREAD_ONCE_INIT;
+static jint* gBmpProperties = NULL;
+static size_t gBmpPropertiesByteCount = 0;
+
+static jchar bmpProperties(UChar32 ch) {
+    return u_charType(ch)
+            | (u_charDirection(ch) << 5)
+            | (u_isMirrored(ch) << 10)
+            | (u_isIDIgnorable(ch) << 11)
+            | (u_isIDStart(ch) << 12)
+            | (u_isIDPart(ch) << 13)
+            | (u_hasBinaryProperty(ch, UCHAR_ALPHABETIC) << 14)
+            | (u_hasBinaryProperty(ch, UCHAR_IDEOGRAPHIC) << 15);
+}
+
+static void buildBmpProperties() {
+    const size_t blockCount = 0x10000 >> BMP_PROPERTIES_SHIFT;
+    std::vector<jchar> offsets(blockCount);
+    std::vector<jchar> words;
+    jchar block[BMP_PROPERTIES_BLOCK_SIZE];
+    for (size_t i = 0; i < blockCount; ++i) {
+        UChar32 start = i << BMP_PROPERTIES_SHIFT;
+        for (int j = 0; j < BMP_PROPERTIES_BLOCK_SIZE; ++j) {
+            block[j] = bmpProperties(start + j);
+        }
+        // Most blocks repeat earlier ones (unassigned ranges, CJK, Hangul, private use).
+        size_t offset = 0;
+        while (offset < words.size() && memcmp(&words[offset], block, sizeof(block)) != 0) {
+            offset += BMP_PROPERTIES_BLOCK_SIZE;
+        }
+        if (offset == words.size()) {
+            words.insert(words.end(), block, block + BMP_PROPERTIES_BLOCK_SIZE);
+        }
+        offsets[i] = offset;
+    }
+
+    size_t byteCount = BMP_PROPERTIES_HEADER_SIZE * sizeof(jint)
+            + (offsets.size() + words.size()) * sizeof(jchar);
+    jint* table = reinterpret_cast<jint*>(malloc(byteCount));
+    if (table == NULL) {
+        return;
+    }
+    UVersionInfo unicodeVersion;
+    u_getUnicodeVersion(unicodeVersion);
+    table[0] = BMP_PROPERTIES_VERSION;
+    memcpy(&table[1], unicodeVersion, sizeof(jint));
+    table[2] = offsets.size();
+    table[3] = words.size();
+    jchar* dst = reinterpret_cast<jchar*>(&table[BMP_PROPERTIES_HEADER_SIZE]);
+    memcpy(dst, &offsets[0], offsets.size() * sizeof(jchar));
+    memcpy(dst + offsets.size(), &words[0], words.size() * sizeof(jchar));
+    gBmpProperties = table;
+    gBmpPropertiesByteCount = byteCount;
+}
+
+static jobject Character_getBmpPropertiesImpl(JNIEnv* env, jclass) {
+    // The table is built once per process and never freed, so the buffer can outlive any caller.
+    pthread_once(&gBmpPropertiesOnce, buildBmpProperties);
+    if (gBmpProperties == NULL) {
+        jniThrowOutOfMemoryError(env, NULL);
+        return NULL;
+    }
+    return env->NewDirectByteBuffer(gBmpProperties, gBmpPropertiesByteCount);
+}
+
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Character, digitImpl, "!(II)I"),
     NATIVE_METHOD(Character, forNameImpl, "(Ljava/lang/String;)I"),
+    NATIVE_METHOD(Character, getBmpPropertiesImpl, "()Ljava/nio/ByteBuffer;"),
     NATIVE_METHOD(Character, getDirectionalityImpl, "!(I)B"),
     NATIVE_METHOD(Character, getNameImpl, "(I)Ljava/lang/String;"),
     NATIVE_METHOD(Character, getNumericValueImpl, "!(I)I"),
     NATIVE_METHOD(Character, getTypeImpl, "!(I)I"),
-    NATIVE_METHOD(Character, isAlphabetic, "!(I)Z"),
+    NATIVE_METHOD(Character, isAlphabeticImpl, "!(I)Z"),
     NATIVE_METHOD(Character, isDefinedImpl, "!(I)Z"),
     NATIVE_METHOD(Character, isDigitImpl, "!(I)Z"),
     NATIVE_METHOD(Character, isIdentifierIgnorableImpl, "!(I)Z"),
-    NATIVE_METHOD(Character, isIdeographic, "!(I)Z"),
+    NATIVE_METHOD(Character, isIdeographicImpl, "!(I)Z"),
     NATIVE_METHOD(Character, isLetterImpl, "!(I)Z"),
     NATIVE_METHOD(Character, isLetterOrDigitImpl, "!(I)Z"),
     NATIVE_METHOD(Character, isLowerCaseImpl, "!(I)Z"),
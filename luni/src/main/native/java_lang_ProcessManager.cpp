@@ -16,16 +16,21 @@
 
 #define LOG_TAG "ProcessManager"
 
-#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <paths.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <string>
+#include <vector>
+
 #include "cutils/log.h"
 #include "jni.h"
 #include "ExecStrings.h"
@@ -35,35 +40,158 @@
 #include "ScopedLocalRef.h"
 #include "toStringArray.h"
 
-static void CloseNonStandardFds(int status_pipe_fd) {
-  // On Cygwin, Linux, and Solaris, the best way to close iterates over "/proc/self/fd/".
-  const char* fd_path = "/proc/self/fd";
-#ifdef __APPLE__
-  // On Mac OS, there's "/dev/fd/" which Linux seems to link to "/proc/self/fd/",
-  // but which on Solaris appears to be something quite different.
-  fd_path = "/dev/fd";
+#ifndef CLOSE_RANGE_CLOEXEC
+#define CLOSE_RANGE_CLOEXEC (1U << 2)
 #endif
 
-  // Keep track of the system properties fd so we don't close it.
-  int properties_fd = -1;
+// The child runs on the parent's stack and shares its memory until it execs or exits (see
+// ExecuteProcess), so anything that allocates -- the PATH search, the fd limit, the fallback
+// argument vector for scripts -- is worked out in the parent first, in a ChildPlan.
+struct ChildPlan {
+  char** argv;
+  char** envp;
+  const char* workingDirectory;
+  // Candidate paths for argv[0], in the order execvp(3) would try them.
+  std::vector<std::string> paths;
+  // argv for running a candidate through the shell if it turns out not to be an executable.
+  // Element 1 is filled in by the child.
+  std::vector<char*> shellArgv;
+  // The system properties fd, which the child must inherit.
+  int propertiesFd;
+  // Upper bound for the close loop when neither close_range(2) nor /proc is available.
+  int maxFd;
+};
+
+static void PlanChild(ChildPlan& plan, char** commands, char** environment,
+                      const char* workingDirectory) {
+  extern char** environ; // Standard, but not in any header file.
+  plan.argv = commands;
+  plan.envp = (environment != NULL) ? environment : environ;
+  plan.workingDirectory = workingDirectory;
+
+  // Like execvp(3), search the PATH of the environment the child will run with.
+  const char* file = commands[0];
+  if (file != NULL && *file != '\0') {
+    if (strchr(file, '/') != NULL) {
+      plan.paths.push_back(file);
+    } else {
+      const char* path = NULL;
+      for (char** e = plan.envp; e != NULL && *e != NULL; ++e) {
+        if (strncmp(*e, "PATH=", 5) == 0) {
+          path = *e + 5;
+          break;
+        }
+      }
+      if (path == NULL) {
+        path = _PATH_DEFPATH;
+      }
+      while (true) {
+        const char* colon = strchr(path, ':');
+        size_t length = (colon != NULL) ? colon - path : strlen(path);
+        // An empty PATH element means the current directory.
+        std::string candidate(path, length);
+        if (!candidate.empty()) {
+          candidate += '/';
+        }
+        plan.paths.push_back(candidate + file);
+        if (colon == NULL) {
+          break;
+        }
+        path = colon + 1;
+      }
+    }
+  }
+
+  plan.shellArgv.push_back(const_cast<char*>(_PATH_BSHELL));
+  plan.shellArgv.push_back(NULL);
+  for (char** arg = commands + 1; *commands != NULL && *arg != NULL; ++arg) {
+    plan.shellArgv.push_back(*arg);
+  }
+  plan.shellArgv.push_back(NULL);
+
+  plan.propertiesFd = -1;
   char* properties_fd_string = getenv("ANDROID_PROPERTY_WORKSPACE");
   if (properties_fd_string != NULL) {
-    properties_fd = atoi(properties_fd_string);
-  }
-
-  DIR* d = opendir(fd_path);
-  int dir_fd = dirfd(d);
-  dirent* e;
-  while ((e = readdir(d)) != NULL) {
-    char* end;
-    int fd = strtol(e->d_name, &end, 10);
-    if (!*end) {
-      if (fd > STDERR_FILENO && fd != dir_fd && fd != status_pipe_fd && fd != properties_fd) {
-        close(fd);
+    plan.propertiesFd = atoi(properties_fd_string);
+  }
+
+  rlimit rl;
+  plan.maxFd = (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY)
+      ? static_cast<int>(rl.rlim_cur) : 1024;
+}
+
+#if defined(__linux__)
+// The kernel's struct linux_dirent64, as filled in by getdents64(2).
+struct LinuxDirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[1];
+};
+
+/**
+ * Marks every fd listed in /proc/self/fd above stderr close-on-exec, so the cost is one call per
+ * open fd rather than one per possible fd. This reads the directory with getdents64(2) into a
+ * stack buffer, because opendir(3) would malloc(3). Returns false if /proc can't be read.
+ */
+static bool MarkOpenFdsCloseOnExec() {
+  int dirFd = open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dirFd == -1) {
+    return false;
+  }
+  uint64_t buffer[512];
+  while (true) {
+    long byteCount = syscall(__NR_getdents64, dirFd, buffer, sizeof(buffer));
+    if (byteCount <= 0) {
+      close(dirFd);
+      return byteCount == 0;
+    }
+    const char* entries = reinterpret_cast<const char*>(buffer);
+    for (long offset = 0; offset < byteCount; ) {
+      const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(entries + offset);
+      offset += entry->d_reclen;
+      // Skip "." and "..". Everything else is a decimal fd.
+      int fd = 0;
+      const char* digit = entry->d_name;
+      if (*digit < '0' || *digit > '9') {
+        continue;
+      }
+      for (; *digit >= '0' && *digit <= '9'; ++digit) {
+        fd = fd * 10 + (*digit - '0');
+      }
+      if (fd > STDERR_FILENO && fd != dirFd) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
       }
     }
   }
-  closedir(d);
+}
+#endif
+
+/**
+ * Arranges for every fd above stderr to be closed by execve(2), except the system properties fd.
+ * Marking fds close-on-exec means the status pipe survives until the exec itself, and lets us use
+ * a single close_range(2) where the kernel has it, and otherwise only touch the fds that are
+ * actually open.
+ */
+static void CloseNonStandardFdsOnExec(const ChildPlan& plan) {
+  bool done = false;
+#if defined(__linux__) && defined(__NR_close_range)
+  done = (syscall(__NR_close_range, STDERR_FILENO + 1, ~0U, CLOSE_RANGE_CLOEXEC) == 0);
+#endif
+#if defined(__linux__)
+  if (!done) {
+    done = MarkOpenFdsCloseOnExec();
+  }
+#endif
+  if (!done) {
+    for (int fd = STDERR_FILENO + 1; fd < plan.maxFd; ++fd) {
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+  }
+  if (plan.propertiesFd > STDERR_FILENO) {
+    fcntl(plan.propertiesFd, F_SETFD, 0);
+  }
 }
 
 #define PIPE_COUNT 4 // Number of pipes used to communicate with child.
@@ -84,6 +212,36 @@ static void AbortChild(int status_pipe_fd) {
   _exit(127);
 }
 
+/** Tries each candidate path in turn, as execvp(3) would. Only returns on failure. */
+static void ExecChild(ChildPlan& plan) {
+  bool sawEacces = false;
+  for (size_t i = 0; i < plan.paths.size(); ++i) {
+    const char* path = plan.paths[i].c_str();
+    execve(path, plan.argv, plan.envp);
+    switch (errno) {
+    case ENOEXEC:
+      // Not a binary and no #! line: run it as a shell script.
+      plan.shellArgv[1] = const_cast<char*>(path);
+      execve(_PATH_BSHELL, &plan.shellArgv[0], plan.envp);
+      return;
+    case EACCES:
+      sawEacces = true;
+      break;
+    case ENOENT:
+    case ENOTDIR:
+    case ELOOP:
+    case ENAMETOOLONG:
+    case ENODEV:
+    case ESTALE:
+    case ETIMEDOUT:
+      break;
+    default:
+      return;
+    }
+  }
+  errno = sawEacces ? EACCES : ENOENT;
+}
+
 /** Executes a command in a child process. */
 static pid_t ExecuteProcess(JNIEnv* env, char** commands, char** environment,
                             const char* workingDirectory, jobject inDescriptor,
@@ -108,9 +266,15 @@ static pid_t ExecuteProcess(JNIEnv* env, char** commands, char** environment,
   int statusIn = pipes[6];
   int statusOut = pipes[7];
 
-  pid_t childPid = fork();
+  ChildPlan plan;
+  PlanChild(plan, commands, environment, workingDirectory);
+
+  // vfork(2) rather than fork(2): copying the page tables of a process with a large heap made
+  // every exec cost tens of milliseconds and briefly doubled its commit charge. The parent thread
+  // is suspended until the child execs or exits.
+  pid_t childPid = vfork();
 
-  // If fork() failed...
+  // If vfork() failed...
   if (childPid == -1) {
     jniThrowIOException(env, errno);
     ClosePipes(pipes, -1);
@@ -119,9 +283,9 @@ static pid_t ExecuteProcess(JNIEnv* env, char** commands, char** environment,
 
   // If this is the child process...
   if (childPid == 0) {
-    // Note: We cannot malloc(3) or free(3) after this point!
-    // A thread in the parent that no longer exists in the child may have held the heap lock
-    // when we forked, so an attempt to malloc(3) or free(3) would result in deadlock.
+    // Note: We share the parent's memory until execve(2), so we mustn't malloc(3), free(3),
+    // return from this function, or touch anything the parent will use afterwards. Only the fd
+    // table and working directory are the child's own.
 
     // Replace stdin, out, and err with pipes.
     dup2(stdinIn, 0);
@@ -135,28 +299,19 @@ static pid_t ExecuteProcess(JNIEnv* env, char** commands, char** environment,
     // Close all but statusOut. This saves some work in the next step.
     ClosePipes(pipes, statusOut);
 
-    // Make statusOut automatically close if execvp() succeeds.
-    fcntl(statusOut, F_SETFD, FD_CLOEXEC);
-
-    // Close remaining unwanted open fds.
-    CloseNonStandardFds(statusOut);
+    // Everything else, statusOut included, goes away when execve() succeeds.
+    CloseNonStandardFdsOnExec(plan);
 
     // Switch to working directory.
-    if (workingDirectory != NULL) {
-      if (chdir(workingDirectory) == -1) {
+    if (plan.workingDirectory != NULL) {
+      if (chdir(plan.workingDirectory) == -1) {
         AbortChild(statusOut);
       }
     }
 
-    // Set up environment.
-    if (environment != NULL) {
-      extern char** environ; // Standard, but not in any header file.
-      environ = environment;
-    }
-
     // Execute process. By convention, the first argument in the arg array
     // should be the command itself.
-    execvp(commands[0], commands);
+    ExecChild(plan);
     AbortChild(statusOut);
   }
 
@@ -168,14 +323,14 @@ static pid_t ExecuteProcess(JNIEnv* env, char** commands, char** environment,
   close(stderrOut);
   close(statusOut);
 
-  // Check status pipe for an error code. If execvp(2) succeeds, the other
+  // Check status pipe for an error code. If execve(2) succeeds, the other
   // end of the pipe should automatically close, in which case, we'll read
   // nothing.
   int child_errno;
   ssize_t count = TEMP_FAILURE_RETRY(read(statusIn, &child_errno, sizeof(int)));
   close(statusIn);
   if (count > 0) {
-    // chdir(2) or execvp(2) in the child failed.
+    // chdir(2) or execve(2) in the child failed.
     // TODO: track which so we can be more specific in the detail message.
     jniThrowIOException(env, child_errno);
 
@@ -18,6 +18,7 @@
 
 #include "JNIHelp.h"
 #include "JniConstants.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedUtfChars.h"
 #include "cutils/log.h"
 #include "openssl/opensslv.h"
@@ -27,13 +28,285 @@
 #include <string>
 #include <vector>
 
+#include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
 
+/*
+ * System.log doesn't write to the log on the calling thread. Callers copy their message into a
+ * slot of a fixed-size ring, claiming it with a compare-and-swap, and a writer thread empties
+ * the ring, joining consecutive messages of the same priority into one log entry (logcat shows
+ * each line of an entry separately). If the ring is full the message is dropped, counted, and
+ * reported by the writer once it catches up. This is the bounded queue from Dmitry Vyukov's
+ * "Bounded MPMC queue", with a single consumer.
+ *
+ * Messages with an exception, and fatal messages, are written synchronously after flushing the
+ * ring, so they aren't lost and stay in order.
+ */
+
+// LOG_PRI truncated to 1023 bytes, so a record holds as much as a message used to.
+static const size_t LOG_RECORD_TEXT_SIZE = 1024;
+static const uint32_t LOG_RECORD_COUNT = 128; // Must be a power of two.
+// Comfortably less than liblog's limit on an entry's payload, which includes the tag.
+static const size_t LOG_BATCH_SIZE = 4000;
+
+struct LogRecord {
+    // LogRecord i is free for the producer claiming position p when sequence == p, and ready
+    // for the consumer at position p when sequence == p + 1.
+    uint32_t sequence;
+    int priority;
+    size_t length;
+    char text[LOG_RECORD_TEXT_SIZE];
+};
+
+static LogRecord gLogRecords[LOG_RECORD_COUNT];
+static uint32_t gLogEnqueuePosition;
+static uint32_t gLogDequeuePosition; // Only touched by the writer.
+static uint32_t gLogDroppedCount;
+
+// Set by the writer before it blocks reading gLogWakeFds[0], and cleared by whoever wakes it.
+static uint32_t gLogWriterSleeping;
+static int gLogWakeFds[2] = { -1, -1 };
+
+// Guards starting and stopping the writer; the writer itself never takes it.
+static pthread_mutex_t gLogWriterMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t gLogWriterThread;
+static bool gLogWriterRunning;
+static bool gLogWriterStopping;
+// Set by System.setLogWriterPaused: messages are still queued, but no writer empties the ring.
+static bool gLogWriterPaused;
+
+// Guards gLogWrittenPosition, so System.flushLog can wait for the writer to reach a position.
+static pthread_mutex_t gLogFlushMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gLogFlushCond = PTHREAD_COND_INITIALIZER;
+static uint32_t gLogWrittenPosition;
+
+static void resetLogRecords() {
+    for (uint32_t i = 0; i < LOG_RECORD_COUNT; ++i) {
+        gLogRecords[i].sequence = i;
+    }
+    gLogEnqueuePosition = gLogDequeuePosition = gLogWrittenPosition = 0;
+}
+
+static void wakeLogWriter() {
+    if (__atomic_exchange_n(&gLogWriterSleeping, 0, __ATOMIC_SEQ_CST) != 0) {
+        // The pipe is non-blocking: if it's full, the writer has plenty of wake-ups already.
+        char byte = 0;
+        TEMP_FAILURE_RETRY(write(gLogWakeFds[1], &byte, 1));
+    }
+}
+
+static LogRecord* readyLogRecord() {
+    LogRecord* record = &gLogRecords[gLogDequeuePosition & (LOG_RECORD_COUNT - 1)];
+    uint32_t sequence = __atomic_load_n(&record->sequence, __ATOMIC_SEQ_CST);
+    return (sequence == gLogDequeuePosition + 1) ? record : NULL;
+}
+
+static void writeLogBatch(int priority, char* batch, size_t& length) {
+    if (length > 0) {
+        batch[length] = '\0';
+        __android_log_write(priority, LOG_TAG, batch);
+        length = 0;
+    }
+}
+
+// Writes out everything in the ring, returning false if it was empty.
+static bool drainLogRecords() {
+    static char batch[LOG_BATCH_SIZE + 1];
+    size_t batchLength = 0;
+    int batchPriority = ANDROID_LOG_DEFAULT;
+    bool wroteAny = false;
+    LogRecord* record;
+    while ((record = readyLogRecord()) != NULL) {
+        if (record->priority != batchPriority ||
+                batchLength + 1 + record->length > LOG_BATCH_SIZE) {
+            writeLogBatch(batchPriority, batch, batchLength);
+            batchPriority = record->priority;
+        }
+        if (batchLength > 0) {
+            batch[batchLength++] = '\n';
+        }
+        memcpy(batch + batchLength, record->text, record->length);
+        batchLength += record->length;
+        __atomic_store_n(&record->sequence, gLogDequeuePosition + LOG_RECORD_COUNT,
+                __ATOMIC_RELEASE);
+        ++gLogDequeuePosition;
+        wroteAny = true;
+    }
+    writeLogBatch(batchPriority, batch, batchLength);
+    if (wroteAny) {
+        ScopedPthreadMutexLock lock(&gLogFlushMutex);
+        gLogWrittenPosition = gLogDequeuePosition;
+        pthread_cond_broadcast(&gLogFlushCond);
+    }
+    return wroteAny;
+}
+
+static void* logWriterMain(void*) {
+    uint32_t reportedDropCount = __atomic_load_n(&gLogDroppedCount, __ATOMIC_RELAXED);
+    while (true) {
+        drainLogRecords();
+        uint32_t dropCount = __atomic_load_n(&gLogDroppedCount, __ATOMIC_RELAXED);
+        if (dropCount != reportedDropCount) {
+            ALOGW("dropped %u log messages because the log buffer was full",
+                    dropCount - reportedDropCount);
+            reportedDropCount = dropCount;
+        }
+        if (__atomic_load_n(&gLogWriterStopping, __ATOMIC_SEQ_CST)) {
+            // Anything logged after this is written by the next writer.
+            if (!drainLogRecords()) {
+                return NULL;
+            }
+            continue;
+        }
+        // Producers and stop requests check gLogWriterSleeping after publishing, so one of us
+        // sees the other's write.
+        __atomic_store_n(&gLogWriterSleeping, 1, __ATOMIC_SEQ_CST);
+        if (readyLogRecord() != NULL || __atomic_load_n(&gLogWriterStopping, __ATOMIC_SEQ_CST)) {
+            __atomic_store_n(&gLogWriterSleeping, 0, __ATOMIC_SEQ_CST);
+            continue;
+        }
+        char bytes[64];
+        TEMP_FAILURE_RETRY(read(gLogWakeFds[0], bytes, sizeof(bytes)));
+    }
+}
+
+// Starts the writer if it isn't running. Returns false if it can't be started.
+static bool startLogWriter() {
+    ScopedPthreadMutexLock lock(&gLogWriterMutex);
+    if (gLogWriterRunning || gLogWriterPaused) {
+        return true;
+    }
+    if (gLogWakeFds[0] == -1) {
+        int fds[2];
+        if (pipe(fds) == -1) {
+            return false;
+        }
+        for (int i = 0; i < 2; ++i) {
+            fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+        }
+        fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+        gLogWakeFds[0] = fds[0];
+        gLogWakeFds[1] = fds[1];
+    }
+    __atomic_store_n(&gLogWriterStopping, false, __ATOMIC_SEQ_CST);
+    if (pthread_create(&gLogWriterThread, NULL, logWriterMain, NULL) != 0) {
+        return false;
+    }
+    __atomic_store_n(&gLogWriterRunning, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Called with gLogWriterMutex held.
+static void stopLogWriter() {
+    if (!gLogWriterRunning) {
+        return;
+    }
+    __atomic_store_n(&gLogWriterStopping, true, __ATOMIC_SEQ_CST);
+    wakeLogWriter();
+    pthread_join(gLogWriterThread, NULL);
+    ScopedPthreadMutexLock lock(&gLogFlushMutex);
+    __atomic_store_n(&gLogWriterRunning, false, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&gLogFlushCond);
+}
+
+// Queues a message for the writer. Returns false if the caller should write it itself.
+static bool logAsynchronously(int priority, const char* text) {
+    if (!__atomic_load_n(&gLogWriterRunning, __ATOMIC_ACQUIRE) && !startLogWriter()) {
+        return false;
+    }
+    uint32_t position = __atomic_load_n(&gLogEnqueuePosition, __ATOMIC_RELAXED);
+    LogRecord* record;
+    while (true) {
+        record = &gLogRecords[position & (LOG_RECORD_COUNT - 1)];
+        uint32_t sequence = __atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE);
+        int32_t difference = static_cast<int32_t>(sequence - position);
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&gLogEnqueuePosition, &position, position + 1,
+                    true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+            // The failed compare-and-swap updated position.
+        } else if (difference < 0) {
+            __atomic_add_fetch(&gLogDroppedCount, 1, __ATOMIC_RELAXED);
+            return true;
+        } else {
+            position = __atomic_load_n(&gLogEnqueuePosition, __ATOMIC_RELAXED);
+        }
+    }
+    size_t length = strlen(text);
+    if (length >= LOG_RECORD_TEXT_SIZE) {
+        length = LOG_RECORD_TEXT_SIZE - 1;
+    }
+    record->priority = priority;
+    record->length = length;
+    memcpy(record->text, text, length);
+    __atomic_store_n(&record->sequence, position + 1, __ATOMIC_SEQ_CST);
+    wakeLogWriter();
+    return true;
+}
+
+static void System_flushLog(JNIEnv*, jclass) {
+    if (!__atomic_load_n(&gLogWriterRunning, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    uint32_t target = __atomic_load_n(&gLogEnqueuePosition, __ATOMIC_ACQUIRE);
+    ScopedPthreadMutexLock lock(&gLogFlushMutex);
+    while (static_cast<int32_t>(gLogWrittenPosition - target) < 0 &&
+            __atomic_load_n(&gLogWriterRunning, __ATOMIC_ACQUIRE)) {
+        pthread_cond_wait(&gLogFlushCond, &gLogFlushMutex);
+    }
+}
+
+static jlong System_getDroppedLogCount(JNIEnv*, jclass) {
+    return __atomic_load_n(&gLogDroppedCount, __ATOMIC_RELAXED);
+}
+
+static void System_setLogWriterPaused(JNIEnv*, jclass, jboolean paused) {
+    {
+        ScopedPthreadMutexLock lock(&gLogWriterMutex);
+        gLogWriterPaused = paused;
+        if (paused) {
+            // Stopping the writer empties the ring first.
+            stopLogWriter();
+            return;
+        }
+    }
+    startLogWriter();
+}
+
+/*
+ * Threads don't survive fork, so the parent stops its writer (writing out what it has) while
+ * the fork happens, and both sides start a new one when they next log. The child also drops
+ * anything the parent logged meanwhile, so it isn't written twice.
+ */
+static void logBeforeFork() {
+    pthread_mutex_lock(&gLogWriterMutex);
+    stopLogWriter();
+}
+
+static void logAfterForkInParent() {
+    pthread_mutex_unlock(&gLogWriterMutex);
+}
+
+static void logAfterForkInChild() {
+    resetLogRecords();
+    gLogWriterSleeping = 0;
+    close(gLogWakeFds[0]);
+    close(gLogWakeFds[1]);
+    gLogWakeFds[0] = gLogWakeFds[1] = -1;
+    pthread_mutex_init(&gLogFlushMutex, NULL);
+    pthread_cond_init(&gLogFlushCond, NULL);
+    pthread_mutex_unlock(&gLogWriterMutex);
+}
+
 static void System_log(JNIEnv* env, jclass, jchar type, jstring javaMessage, jthrowable exception) {
     ScopedUtfChars message(env, javaMessage);
     if (message.c_str() == NULL) {
@@ -52,6 +325,11 @@ static void System_log(JNIEnv* env, jclass, jchar type, jstring javaMessage, jth
     case 'W': case 'w': priority = ANDROID_LOG_WARN;    break;
     default:            priority = ANDROID_LOG_DEFAULT; break;
     }
+    if (exception == NULL && priority != ANDROID_LOG_FATAL &&
+            logAsynchronously(priority, message.c_str())) {
+        return;
+    }
+    System_flushLog(env, NULL);
     LOG_PRI(priority, LOG_TAG, "%s", message.c_str());
     if (exception != NULL) {
         jniLogException(env, priority, LOG_TAG, exception);
@@ -112,12 +390,17 @@ static jstring System_mapLibraryName(JNIEnv* env, jclass, jstring javaName) {
 
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(System, currentTimeMillis, "()J"),
+    NATIVE_METHOD(System, flushLog, "()V"),
+    NATIVE_METHOD(System, getDroppedLogCount, "()J"),
     NATIVE_METHOD(System, log, "(CLjava/lang/String;Ljava/lang/Throwable;)V"),
     NATIVE_METHOD(System, mapLibraryName, "(Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(System, nanoTime, "()J"),
     NATIVE_METHOD(System, setFieldImpl, "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/Object;)V"),
+    NATIVE_METHOD(System, setLogWriterPaused, "(Z)V"),
     NATIVE_METHOD(System, specialProperties, "()[Ljava/lang/String;"),
 };
 void register_java_lang_System(JNIEnv* env) {
+    resetLogRecords();
+    pthread_atfork(logBeforeFork, logAfterForkInParent, logAfterForkInChild);
     jniRegisterNativeMethods(env, "java/lang/System", gMethods, NELEM(gMethods));
 }
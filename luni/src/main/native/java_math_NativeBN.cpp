@@ -20,6 +20,7 @@
 #include "JniConstants.h"
 #include "JniException.h"
 #include "ScopedPrimitiveArray.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedUtfChars.h"
 #include "StaticAssert.h"
 #include "UniquePtr.h"
@@ -27,7 +28,10 @@
 #include <openssl/bn.h>
 #include <openssl/crypto.h>
 #include <openssl/err.h>
+#include <algorithm>
+#include <pthread.h>
 #include <stdio.h>
+#include <vector>
 
 struct BN_CTX_Deleter {
   void operator()(BN_CTX* p) const {
@@ -36,6 +40,133 @@ struct BN_CTX_Deleter {
 };
 typedef UniquePtr<BN_CTX, BN_CTX_Deleter> Unique_BN_CTX;
 
+// A BN_CTX is only scratch space, so each thread keeps one for all its operations rather than
+// allocating a new one for every call.
+static pthread_key_t gThreadContextKey;
+static pthread_once_t gThreadContextOnce = PTHREAD_ONCE_INIT;
+
+static void freeThreadContext(void* ctx) {
+  BN_CTX_free(reinterpret_cast<BN_CTX*>(ctx));
+}
+
+static void createThreadContextKey() {
+  pthread_key_create(&gThreadContextKey, freeThreadContext);
+}
+
+static BN_CTX* threadContext(JNIEnv* env) {
+  pthread_once(&gThreadContextOnce, createThreadContextKey);
+  BN_CTX* ctx = reinterpret_cast<BN_CTX*>(pthread_getspecific(gThreadContextKey));
+  if (ctx == NULL) {
+    ctx = BN_CTX_new();
+    if (ctx == NULL) {
+      jniThrowOutOfMemoryError(env, "Unable to allocate BN_CTX");
+      return NULL;
+    }
+    pthread_setspecific(gThreadContextKey, ctx);
+  }
+  return ctx;
+}
+
+/*
+ * The Montgomery setup for an odd modulus, which BN_mod_exp would otherwise redo on every
+ * call. Repeated modPow with the same modulus (RSA and DSA keys, DH and SRP groups) is common,
+ * so we keep the most recently used few. Entries are found by the modulus' value rather than
+ * its handle, since a BigInteger with the same value usually has a different BIGNUM.
+ * Moduli marked BN_FLG_CONSTTIME are secret (RSA primes), so they are never cached, and
+ * evicted entries are cleared before they are freed.
+ */
+struct MontgomeryContext {
+  BIGNUM* modulus;
+  BN_MONT_CTX* mont;
+  // Guarded by gMontgomeryMutex. The cache holds one reference and each user another.
+  int refCount;
+};
+
+static const size_t MAX_MONTGOMERY_CONTEXTS = 8;
+
+static pthread_mutex_t gMontgomeryMutex = PTHREAD_MUTEX_INITIALIZER;
+// Most recently used first.
+static std::vector<MontgomeryContext*> gMontgomeryContexts;
+
+static void freeMontgomeryContext(MontgomeryContext* context) {
+  // BN_MONT_CTX_free clears its own copy of the modulus.
+  BN_MONT_CTX_free(context->mont);
+  BN_clear_free(context->modulus);
+  delete context;
+}
+
+static void releaseMontgomeryContext(MontgomeryContext* context) {
+  bool unused;
+  {
+    ScopedPthreadMutexLock lock(&gMontgomeryMutex);
+    unused = (--context->refCount == 0);
+  }
+  if (unused) {
+    freeMontgomeryContext(context);
+  }
+}
+
+// Returns the cached context for 'm', marked as most recently used, or NULL.
+// Call with gMontgomeryMutex held.
+static MontgomeryContext* findMontgomeryContextLocked(const BIGNUM* m) {
+  for (size_t i = 0; i < gMontgomeryContexts.size(); ++i) {
+    MontgomeryContext* context = gMontgomeryContexts[i];
+    if (BN_cmp(context->modulus, m) == 0) {
+      gMontgomeryContexts.erase(gMontgomeryContexts.begin() + i);
+      gMontgomeryContexts.insert(gMontgomeryContexts.begin(), context);
+      ++context->refCount;
+      return context;
+    }
+  }
+  return NULL;
+}
+
+// Returns a reference to the Montgomery context for the odd modulus 'm', which the caller
+// must release, or NULL with an OpenSSL error queued.
+static MontgomeryContext* getMontgomeryContext(const BIGNUM* m, BN_CTX* ctx) {
+  {
+    ScopedPthreadMutexLock lock(&gMontgomeryMutex);
+    MontgomeryContext* context = findMontgomeryContextLocked(m);
+    if (context != NULL) {
+      return context;
+    }
+  }
+
+  // Do the setup outside the lock; another thread might do the same, but only one copy is kept.
+  MontgomeryContext* context = new MontgomeryContext;
+  context->modulus = BN_dup(m);
+  context->mont = BN_MONT_CTX_new();
+  context->refCount = 2;
+  if (context->modulus == NULL || context->mont == NULL ||
+      !BN_MONT_CTX_set(context->mont, m, ctx)) {
+    freeMontgomeryContext(context);
+    return NULL;
+  }
+
+  MontgomeryContext* evicted = NULL;
+  {
+    ScopedPthreadMutexLock lock(&gMontgomeryMutex);
+    MontgomeryContext* existing = findMontgomeryContextLocked(m);
+    if (existing != NULL) {
+      evicted = context;
+      context = existing;
+    } else {
+      gMontgomeryContexts.insert(gMontgomeryContexts.begin(), context);
+      if (gMontgomeryContexts.size() > MAX_MONTGOMERY_CONTEXTS) {
+        MontgomeryContext* oldest = gMontgomeryContexts.back();
+        gMontgomeryContexts.pop_back();
+        if (--oldest->refCount == 0) {
+          evicted = oldest;
+        }
+      }
+    }
+  }
+  if (evicted != NULL) {
+    freeMontgomeryContext(evicted);
+  }
+  return context;
+}
+
 static BIGNUM* toBigNum(jlong address) {
   return reinterpret_cast<BIGNUM*>(static_cast<uintptr_t>(address));
 }
@@ -388,6 +519,52 @@ static jintArray NativeBN_bn2litEndInts(JNIEnv* env, jclass, jlong a0) {
   return result;
 }
 
+// Copies the big-endian magnitude of 'a' into dst at offset if it fits.
+// Returns the number of bytes in the magnitude either way.
+static jint NativeBN_BN_bn2binInto(JNIEnv* env, jclass, jlong a0, jbyteArray dst, jint offset) {
+  if (!oneValidHandle(env, a0)) return -1;
+  BIGNUM* a = toBigNum(a0);
+  ScopedByteArrayRW bytes(env, dst);
+  if (bytes.get() == NULL) {
+    return -1;
+  }
+  if (offset < 0 || static_cast<size_t>(offset) > bytes.size()) {
+    jniThrowExceptionFmt(env, "java/lang/ArrayIndexOutOfBoundsException",
+                         "length=%zu; offset=%d", bytes.size(), offset);
+    return -1;
+  }
+  jint len = BN_num_bytes(a);
+  if (static_cast<size_t>(len) <= bytes.size() - offset) {
+    BN_bn2bin(a, reinterpret_cast<unsigned char*>(bytes.get() + offset));
+  }
+  return len;
+}
+
+// Copies the little-endian int magnitude of 'a' into dst at offset if it fits.
+// Returns the number of ints in the magnitude either way; zero has none.
+static jint NativeBN_bn2litEndIntsInto(JNIEnv* env, jclass, jlong a0, jintArray dst, jint offset) {
+  if (!oneValidHandle(env, a0)) return -1;
+  BIGNUM* a = toBigNum(a0);
+  bn_check_top(a);
+  ScopedIntArrayRW ints(env, dst);
+  if (ints.get() == NULL) {
+    return -1;
+  }
+  if (offset < 0 || static_cast<size_t>(offset) > ints.size()) {
+    jniThrowExceptionFmt(env, "java/lang/ArrayIndexOutOfBoundsException",
+                         "length=%zu; offset=%d", ints.size(), offset);
+    return -1;
+  }
+  jint len = a->top;
+  if (static_cast<size_t>(len) <= ints.size() - offset) {
+    BN_ULONG* ulongs = reinterpret_cast<BN_ULONG*>(ints.get() + offset);
+    for (jint i = 0; i < len; ++i) {
+      ulongs[i] = a->d[i];
+    }
+  }
+  return len;
+}
+
 static int NativeBN_sign(JNIEnv* env, jclass, jlong a) {
   if (!oneValidHandle(env, a)) return -2;
   if (BN_is_zero(toBigNum(a))) {
@@ -472,53 +649,171 @@ static void NativeBN_BN_sub(JNIEnv* env, jclass, jlong r, jlong a, jlong b) {
 
 static void NativeBN_BN_gcd(JNIEnv* env, jclass, jlong r, jlong a, jlong b) {
   if (!threeValidHandles(env, r, a, b)) return;
-  Unique_BN_CTX ctx(BN_CTX_new());
-  BN_gcd(toBigNum(r), toBigNum(a), toBigNum(b), ctx.get());
+  BN_CTX* ctx = threadContext(env);
+  if (ctx == NULL) return;
+  BN_gcd(toBigNum(r), toBigNum(a), toBigNum(b), ctx);
   throwExceptionIfNecessary(env);
 }
 
 static void NativeBN_BN_mul(JNIEnv* env, jclass, jlong r, jlong a, jlong b) {
   if (!threeValidHandles(env, r, a, b)) return;
-  Unique_BN_CTX ctx(BN_CTX_new());
-  BN_mul(toBigNum(r), toBigNum(a), toBigNum(b), ctx.get());
+  BN_CTX* ctx = threadContext(env);
+  if (ctx == NULL) return;
+  BN_mul(toBigNum(r), toBigNum(a), toBigNum(b), ctx);
   throwExceptionIfNecessary(env);
 }
 
 static void NativeBN_BN_exp(JNIEnv* env, jclass, jlong r, jlong a, jlong p) {
   if (!threeValidHandles(env, r, a, p)) return;
-  Unique_BN_CTX ctx(BN_CTX_new());
-  BN_exp(toBigNum(r), toBigNum(a), toBigNum(p), ctx.get());
+  BN_CTX* ctx = threadContext(env);
+  if (ctx == NULL) return;
+  BN_exp(toBigNum(r), toBigNum(a), toBigNum(p), ctx);
   throwExceptionIfNecessary(env);
 }
 
 static void NativeBN_BN_div(JNIEnv* env, jclass, jlong dv, jlong rem, jlong m, jlong d) {
   if (!fourValidHandles(env, (rem ? rem : dv), (dv ? dv : rem), m, d)) return;
-  Unique_BN_CTX ctx(BN_CTX_new());
-  BN_div(toBigNum(dv), toBigNum(rem), toBigNum(m), toBigNum(d), ctx.get());
+  BN_CTX* ctx = threadContext(env);
+  if (ctx == NULL) return;
+  BN_div(toBigNum(dv), toBigNum(rem), toBigNum(m), toBigNum(d), ctx);
   throwExceptionIfNecessary(env);
 }
 
 static void NativeBN_BN_nnmod(JNIEnv* env, jclass, jlong r, jlong a, jlong m) {
   if (!threeValidHandles(env, r, a, m)) return;
-  Unique_BN_CTX ctx(BN_CTX_new());
-  BN_nnmod(toBigNum(r), toBigNum(a), toBigNum(m), ctx.get());
+  BN_CTX* ctx = threadContext(env);
+  if (ctx == NULL) return;
+  BN_nnmod(toBigNum(r), toBigNum(a), toBigNum(m), ctx);
   throwExceptionIfNecessary(env);
 }
 
+// Computes r = a^p mod m using the cached Montgomery context for an odd, non-negative modulus
+// that isn't marked constant-time.
+// Returns false if OpenSSL failed, leaving the error on the OpenSSL error queue.
+static bool modExp(BIGNUM* r, BIGNUM* a, BIGNUM* p, BIGNUM* m, BN_CTX* ctx) {
+  if (!BN_is_odd(m) || BN_is_negative(m) || BN_get_flags(m, BN_FLG_CONSTTIME) != 0) {
+    return BN_mod_exp(r, a, p, m, ctx);
+  }
+  MontgomeryContext* context = getMontgomeryContext(m, ctx);
+  if (context == NULL) {
+    return false;
+  }
+  // The same choice BN_mod_exp makes for an odd modulus.
+  int ok;
+  if (!BN_is_zero(a) && !BN_is_negative(a) && BN_num_bits(a) <= BN_BITS2 &&
+      BN_get_flags(p, BN_FLG_CONSTTIME) == 0) {
+    ok = BN_mod_exp_mont_word(r, BN_get_word(a), p, m, ctx, context->mont);
+  } else {
+    ok = BN_mod_exp_mont(r, a, p, m, ctx, context->mont);
+  }
+  releaseMontgomeryContext(context);
+  return ok;
+}
+
 static void NativeBN_BN_mod_exp(JNIEnv* env, jclass, jlong r, jlong a, jlong p, jlong m) {
   if (!fourValidHandles(env, r, a, p, m)) return;
-  Unique_BN_CTX ctx(BN_CTX_new());
-  BN_mod_exp(toBigNum(r), toBigNum(a), toBigNum(p), toBigNum(m), ctx.get());
+  BN_CTX* ctx = threadContext(env);
+  if (ctx == NULL) return;
+  modExp(toBigNum(r), toBigNum(a), toBigNum(p), toBigNum(m), ctx);
   throwExceptionIfNecessary(env);
 }
 
 static void NativeBN_BN_mod_inverse(JNIEnv* env, jclass, jlong ret, jlong a, jlong n) {
   if (!threeValidHandles(env, ret, a, n)) return;
-  Unique_BN_CTX ctx(BN_CTX_new());
-  BN_mod_inverse(toBigNum(ret), toBigNum(a), toBigNum(n), ctx.get());
+  BN_CTX* ctx = threadContext(env);
+  if (ctx == NULL) return;
+  BN_mod_inverse(toBigNum(ret), toBigNum(a), toBigNum(n), ctx);
   throwExceptionIfNecessary(env);
 }
 
+// Opcodes for NativeBN.runOps; these must match the OP_ constants in NativeBN.java.
+enum {
+  OP_ADD = 0,
+  OP_SUB = 1,
+  OP_MUL = 2,
+  OP_NNMOD = 3,
+  OP_MOD_ADD = 4,
+  OP_MOD_SUB = 5,
+  OP_MOD_MUL = 6,
+  OP_MOD_EXP = 7,
+};
+
+// Each op is OPS_PER_OP ints: the opcode and the register indexes of r, a, b and m.
+static const int OPS_PER_OP = 5;
+
+static void NativeBN_runOps(JNIEnv* env, jclass, jintArray javaOps, jint opCount,
+                            jlongArray javaRegisters) {
+  ScopedIntArrayRO ops(env, javaOps);
+  if (ops.get() == NULL) {
+    return;
+  }
+  ScopedLongArrayRO registers(env, javaRegisters);
+  if (registers.get() == NULL) {
+    return;
+  }
+  if (opCount < 0 || static_cast<size_t>(opCount) > ops.size() / OPS_PER_OP) {
+    jniThrowExceptionFmt(env, "java/lang/ArrayIndexOutOfBoundsException",
+                         "length=%zu; opCount=%d", ops.size(), opCount);
+    return;
+  }
+  for (size_t i = 0; i < registers.size(); ++i) {
+    if (!oneValidHandle(env, registers[i])) return;
+  }
+  BN_CTX* ctx = threadContext(env);
+  if (ctx == NULL) return;
+
+  const jint* op = ops.get();
+  for (jint i = 0; i < opCount; ++i, op += OPS_PER_OP) {
+    BIGNUM* operands[OPS_PER_OP - 1];
+    for (int j = 0; j < OPS_PER_OP - 1; ++j) {
+      jint index = op[j + 1];
+      if (index < 0 || static_cast<size_t>(index) >= registers.size()) {
+        jniThrowExceptionFmt(env, "java/lang/ArrayIndexOutOfBoundsException",
+                             "length=%zu; index=%d", registers.size(), index);
+        return;
+      }
+      operands[j] = toBigNum(registers[index]);
+    }
+    BIGNUM* r = operands[0];
+    BIGNUM* a = operands[1];
+    BIGNUM* b = operands[2];
+    BIGNUM* m = operands[3];
+    switch (op[0]) {
+    case OP_ADD:
+      BN_add(r, a, b);
+      break;
+    case OP_SUB:
+      BN_sub(r, a, b);
+      break;
+    case OP_MUL:
+      BN_mul(r, a, b, ctx);
+      break;
+    case OP_NNMOD:
+      BN_nnmod(r, a, m, ctx);
+      break;
+    case OP_MOD_ADD:
+      BN_mod_add(r, a, b, m, ctx);
+      break;
+    case OP_MOD_SUB:
+      BN_mod_sub(r, a, b, m, ctx);
+      break;
+    case OP_MOD_MUL:
+      BN_mod_mul(r, a, b, m, ctx);
+      break;
+    case OP_MOD_EXP:
+      modExp(r, a, b, m, ctx);
+      break;
+    default:
+      jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException", "unknown op %d", op[0]);
+      return;
+    }
+    // Stop at the first failure, leaving the remaining registers untouched.
+    if (throwExceptionIfNecessary(env)) {
+      return;
+    }
+  }
+}
+
 static void NativeBN_BN_generate_prime_ex(JNIEnv* env, jclass, jlong ret, int bits,
                                           jboolean safe, jlong add, jlong rem, jlong cb) {
   if (!oneValidHandle(env, ret)) return;
@@ -533,11 +828,246 @@ static jboolean NativeBN_BN_is_prime_ex(JNIEnv* env, jclass, jlong p, int ncheck
   return BN_is_prime_ex(toBigNum(p), nchecks, ctx.get(), reinterpret_cast<BN_GENCB*>(cb));
 }
 
+// Per-item status codes for the batch operations; these must match the BATCH_ constants in
+// NativeBN.java.
+enum {
+  BATCH_OK = 0,
+  BATCH_DIV_BY_ZERO = 1,
+  BATCH_NO_INVERSE = 2,
+  BATCH_OUT_OF_MEMORY = 3,
+  BATCH_FAILED = 4,
+};
+
+// Maps the first error on this thread's OpenSSL error queue to a batch status, and clears the
+// queue so the next item starts clean.
+static jint batchStatus() {
+  unsigned long error = ERR_get_error();
+  ERR_clear_error();
+  if (error == 0) {
+    return BATCH_FAILED;
+  }
+  int reason = ERR_GET_REASON(error);
+  if (reason == BN_R_DIV_BY_ZERO) {
+    return BATCH_DIV_BY_ZERO;
+  } else if (reason == BN_R_NO_INVERSE) {
+    return BATCH_NO_INVERSE;
+  } else if (reason == ERR_R_MALLOC_FAILURE) {
+    return BATCH_OUT_OF_MEMORY;
+  }
+  return BATCH_FAILED;
+}
+
+// The operands of a batch, copied out of the Java arrays before any worker starts. Workers
+// never touch the JNIEnv.
+struct BatchArgs {
+  const jlong* r;
+  const jlong* a;
+  const jlong* p;
+  const jlong* m;
+  int bits;
+  bool safe;
+  int nchecks;
+  jboolean* results;
+};
+
+// Runs one item of a batch, returning its status.
+typedef jint (*BatchFunction)(const BatchArgs& args, size_t index, BN_CTX* ctx);
+
+struct BatchQueue {
+  BatchFunction function;
+  const BatchArgs* args;
+  std::vector<jint>* status;
+  size_t next;
+  pthread_mutex_t mutex;
+};
+
+struct BatchWorkerArgs {
+  BatchQueue* queue;
+  BN_CTX* ctx;
+};
+
+static void* batchWorkerMain(void* rawArgs) {
+  BatchWorkerArgs* args = reinterpret_cast<BatchWorkerArgs*>(rawArgs);
+  BatchQueue* queue = args->queue;
+  // Started threads bring their own scratch space; the calling thread passes in its own.
+  Unique_BN_CTX ownContext(args->ctx == NULL ? BN_CTX_new() : NULL);
+  BN_CTX* ctx = (args->ctx != NULL) ? args->ctx : ownContext.get();
+  while (true) {
+    pthread_mutex_lock(&queue->mutex);
+    size_t index = queue->next++;
+    pthread_mutex_unlock(&queue->mutex);
+    if (index >= queue->status->size()) {
+      break;
+    }
+    (*queue->status)[index] = (ctx != NULL) ? queue->function(*queue->args, index, ctx)
+                                            : BATCH_OUT_OF_MEMORY;
+  }
+  if (args->ctx == NULL) {
+    // This thread is about to exit, so free its OpenSSL error state.
+    ERR_remove_state(0);
+  }
+  return NULL;
+}
+
+// Runs 'function' for every item on up to threadCount threads, the calling thread included,
+// and returns the per-item status as a new int[]. Like ParallelDeflater, the threads only
+// live for one call.
+static jintArray runBatch(JNIEnv* env, BatchFunction function, const BatchArgs& args,
+                          size_t count, jint threadCount) {
+  BN_CTX* ctx = threadContext(env);
+  if (ctx == NULL) return NULL;
+  // Don't let an earlier caller's leftover error be blamed on the first item.
+  ERR_clear_error();
+
+  std::vector<jint> status(count, BATCH_OK);
+  BatchQueue queue;
+  queue.function = function;
+  queue.args = &args;
+  queue.status = &status;
+  queue.next = 0;
+  pthread_mutex_init(&queue.mutex, NULL);
+
+  size_t workerCount = std::max<size_t>(1, std::min<size_t>(count, std::max(threadCount, 1)));
+  std::vector<BatchWorkerArgs> workerArgs(workerCount);
+  std::vector<pthread_t> threads;
+  for (size_t i = 0; i < workerCount; ++i) {
+    workerArgs[i].queue = &queue;
+    workerArgs[i].ctx = (i == 0) ? ctx : NULL;
+    if (i > 0) {
+      pthread_t thread;
+      if (pthread_create(&thread, NULL, batchWorkerMain, &workerArgs[i]) == 0) {
+        threads.push_back(thread);
+      }
+    }
+  }
+  batchWorkerMain(&workerArgs[0]);
+  for (size_t i = 0; i < threads.size(); ++i) {
+    pthread_join(threads[i], NULL);
+  }
+  pthread_mutex_destroy(&queue.mutex);
+
+  jintArray result = env->NewIntArray(count);
+  if (result != NULL && count > 0) {
+    env->SetIntArrayRegion(result, 0, count, &status[0]);
+  }
+  return result;
+}
+
+// Checks that every handle array given has 'count' non-null handles.
+static bool validBatchHandles(JNIEnv* env, const ScopedLongArrayRO& handles, size_t count) {
+  if (handles.size() != count) {
+    jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException",
+                         "length=%zu; expected %zu", handles.size(), count);
+    return false;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (!oneValidHandle(env, handles[i])) return false;
+  }
+  return true;
+}
+
+static jint modExpItem(const BatchArgs& args, size_t i, BN_CTX* ctx) {
+  if (!modExp(toBigNum(args.r[i]), toBigNum(args.a[i]), toBigNum(args.p[i]),
+              toBigNum(args.m[i]), ctx)) {
+    return batchStatus();
+  }
+  return BATCH_OK;
+}
+
+static jintArray NativeBN_BN_mod_exp_batch(JNIEnv* env, jclass, jlongArray javaR,
+                                           jlongArray javaA, jlongArray javaP, jlongArray javaM,
+                                           jint threadCount) {
+  ScopedLongArrayRO r(env, javaR);
+  ScopedLongArrayRO a(env, javaA);
+  ScopedLongArrayRO p(env, javaP);
+  ScopedLongArrayRO m(env, javaM);
+  if (r.get() == NULL || a.get() == NULL || p.get() == NULL || m.get() == NULL) {
+    return NULL;
+  }
+  size_t count = r.size();
+  if (!validBatchHandles(env, r, count) || !validBatchHandles(env, a, count) ||
+      !validBatchHandles(env, p, count) || !validBatchHandles(env, m, count)) {
+    return NULL;
+  }
+  BatchArgs args = BatchArgs();
+  args.r = r.get();
+  args.a = a.get();
+  args.p = p.get();
+  args.m = m.get();
+  return runBatch(env, modExpItem, args, count, threadCount);
+}
+
+static jint isPrimeItem(const BatchArgs& args, size_t i, BN_CTX* ctx) {
+  int result = BN_is_prime_ex(toBigNum(args.p[i]), args.nchecks, ctx, NULL);
+  if (result < 0) {
+    return batchStatus();
+  }
+  args.results[i] = (result == 1);
+  return BATCH_OK;
+}
+
+static jintArray NativeBN_BN_is_prime_ex_batch(JNIEnv* env, jclass, jlongArray javaP,
+                                               jint nchecks, jbooleanArray javaResults,
+                                               jint threadCount) {
+  ScopedLongArrayRO p(env, javaP);
+  if (p.get() == NULL) {
+    return NULL;
+  }
+  ScopedBooleanArrayRW results(env, javaResults);
+  if (results.get() == NULL) {
+    return NULL;
+  }
+  size_t count = p.size();
+  if (!validBatchHandles(env, p, count)) {
+    return NULL;
+  }
+  if (results.size() != count) {
+    jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException",
+                         "results.length=%zu; expected %zu", results.size(), count);
+    return NULL;
+  }
+  BatchArgs args = BatchArgs();
+  args.p = p.get();
+  args.nchecks = nchecks;
+  args.results = results.get();
+  return runBatch(env, isPrimeItem, args, count, threadCount);
+}
+
+static jint generatePrimeItem(const BatchArgs& args, size_t i, BN_CTX*) {
+  BIGNUM* r = toBigNum(args.r[i]);
+  // Retry until we get exactly the requested length, to work around the same OpenSSL bug
+  // the BigInteger constructor does; http://b/8588028.
+  do {
+    if (!BN_generate_prime_ex(r, args.bits, args.safe, NULL, NULL, NULL)) {
+      return batchStatus();
+    }
+  } while (BN_num_bits(r) != args.bits);
+  return BATCH_OK;
+}
+
+static jintArray NativeBN_BN_generate_prime_ex_batch(JNIEnv* env, jclass, jlongArray javaR,
+                                                     jint bits, jboolean safe, jint threadCount) {
+  ScopedLongArrayRO r(env, javaR);
+  if (r.get() == NULL) {
+    return NULL;
+  }
+  size_t count = r.size();
+  if (!validBatchHandles(env, r, count)) {
+    return NULL;
+  }
+  BatchArgs args = BatchArgs();
+  args.r = r.get();
+  args.bits = bits;
+  args.safe = safe;
+  return runBatch(env, generatePrimeItem, args, count, threadCount);
+}
+
 static JNINativeMethod gMethods[] = {
    NATIVE_METHOD(NativeBN, BN_add, "(JJJ)V"),
    NATIVE_METHOD(NativeBN, BN_add_word, "(JI)V"),
    NATIVE_METHOD(NativeBN, BN_bin2bn, "([BIZJ)V"),
    NATIVE_METHOD(NativeBN, BN_bn2bin, "(J)[B"),
+   NATIVE_METHOD(NativeBN, BN_bn2binInto, "(J[BI)I"),
    NATIVE_METHOD(NativeBN, BN_bn2dec, "(J)Ljava/lang/String;"),
    NATIVE_METHOD(NativeBN, BN_bn2hex, "(J)Ljava/lang/String;"),
    NATIVE_METHOD(NativeBN, BN_cmp, "(JJ)I"),
@@ -548,10 +1078,13 @@ static JNINativeMethod gMethods[] = {
    NATIVE_METHOD(NativeBN, BN_free, "(J)V"),
    NATIVE_METHOD(NativeBN, BN_gcd, "(JJJ)V"),
    NATIVE_METHOD(NativeBN, BN_generate_prime_ex, "(JIZJJJ)V"),
+   NATIVE_METHOD(NativeBN, BN_generate_prime_ex_batch, "([JIZI)[I"),
    NATIVE_METHOD(NativeBN, BN_hex2bn, "(JLjava/lang/String;)I"),
    NATIVE_METHOD(NativeBN, BN_is_bit_set, "(JI)Z"),
    NATIVE_METHOD(NativeBN, BN_is_prime_ex, "(JIJ)Z"),
+   NATIVE_METHOD(NativeBN, BN_is_prime_ex_batch, "([JI[ZI)[I"),
    NATIVE_METHOD(NativeBN, BN_mod_exp, "(JJJJ)V"),
+   NATIVE_METHOD(NativeBN, BN_mod_exp_batch, "([J[J[J[JI)[I"),
    NATIVE_METHOD(NativeBN, BN_mod_inverse, "(JJJ)V"),
    NATIVE_METHOD(NativeBN, BN_mod_word, "(JI)I"),
    NATIVE_METHOD(NativeBN, BN_mul, "(JJJ)V"),
@@ -563,10 +1096,12 @@ static JNINativeMethod gMethods[] = {
    NATIVE_METHOD(NativeBN, BN_sub, "(JJJ)V"),
    NATIVE_METHOD(NativeBN, bitLength, "(J)I"),
    NATIVE_METHOD(NativeBN, bn2litEndInts, "(J)[I"),
+   NATIVE_METHOD(NativeBN, bn2litEndIntsInto, "(J[II)I"),
    NATIVE_METHOD(NativeBN, litEndInts2bn, "([IIZJ)V"),
    NATIVE_METHOD(NativeBN, longInt, "(J)J"),
    NATIVE_METHOD(NativeBN, putLongInt, "(JJ)V"),
    NATIVE_METHOD(NativeBN, putULongInt, "(JJZ)V"),
+   NATIVE_METHOD(NativeBN, runOps, "([II[J)V"),
    NATIVE_METHOD(NativeBN, sign, "(J)I"),
    NATIVE_METHOD(NativeBN, twosComp2bn, "([BIJ)V"),
 };
@@ -24,87 +24,111 @@
 
 #include <string.h>
 
-/**
- * Approximates java.lang.UnsafeByteSequence so we don't have to pay the cost of calling back into
- * Java when converting a char[] to a UTF-8 byte[]. This lets us have UTF-8 conversions slightly
- * faster than ICU for large char[]s without paying for the NIO overhead with small char[]s.
- *
- * We could avoid this by keeping the UTF-8 bytes on the native heap until we're done and only
- * creating a byte[] on the Java heap when we know how big it needs to be, but one shouldn't lie
- * to the garbage collector (nor hide potentially large allocations from it).
- *
- * Because a call to append might require an allocation, it might fail. Callers should always
- * check the return value of append.
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Vector kernels for the single-byte charsets. Each one handles a 16-byte or 16-char chunk and
+ * returns false, having written nothing, if the chunk contains anything that needs the scalar
+ * code's replacement semantics. Without a vector unit they always return false.
  */
-class NativeUnsafeByteSequence {
-public:
-    NativeUnsafeByteSequence(JNIEnv* env)
-        : mEnv(env), mJavaArray(NULL), mRawArray(NULL), mSize(-1), mOffset(0)
-    {
-    }
+static const size_t CHUNK = 16;
 
-    ~NativeUnsafeByteSequence() {
-        // Release our pointer to the raw array, copying changes back to the Java heap.
-        if (mRawArray != NULL) {
-            mEnv->ReleaseByteArrayElements(mJavaArray, mRawArray, 0);
-        }
+// Widens 16 bytes to 16 chars if they're all ASCII.
+static inline bool asciiChunkToChars(const jbyte* src, jchar* dst) {
+#if defined(__SSE2__)
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    if (_mm_movemask_epi8(v) != 0) {
+        return false;
     }
-
-    bool append(jbyte b) {
-        if (mOffset == mSize && !resize(mSize * 2)) {
-            return false;
-        }
-        mRawArray[mOffset++] = b;
-        return true;
+    __m128i zero = _mm_setzero_si128();
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi8(v, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), _mm_unpackhi_epi8(v, zero));
+    return true;
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(src));
+    uint64x2_t high = vreinterpretq_u64_u8(vandq_u8(v, vdupq_n_u8(0x80)));
+    if ((vgetq_lane_u64(high, 0) | vgetq_lane_u64(high, 1)) != 0) {
+        return false;
     }
+    vst1q_u16(dst, vmovl_u8(vget_low_u8(v)));
+    vst1q_u16(dst + 8, vmovl_u8(vget_high_u8(v)));
+    return true;
+#else
+    (void) src;
+    (void) dst;
+    return false;
+#endif
+}
 
-    bool resize(int newSize) {
-        if (newSize == mSize) {
-            return true;
-        }
-
-        // Allocate a new array.
-        jbyteArray newJavaArray = mEnv->NewByteArray(newSize);
-        if (newJavaArray == NULL) {
-            return false;
-        }
-        jbyte* newRawArray = mEnv->GetByteArrayElements(newJavaArray, NULL);
-        if (newRawArray == NULL) {
-            return false;
-        }
+// Widens 16 bytes to 16 chars. Every byte is valid ISO-8859-1.
+static inline bool latin1ChunkToChars(const jbyte* src, jchar* dst) {
+#if defined(__SSE2__)
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i zero = _mm_setzero_si128();
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi8(v, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), _mm_unpackhi_epi8(v, zero));
+    return true;
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(src));
+    vst1q_u16(dst, vmovl_u8(vget_low_u8(v)));
+    vst1q_u16(dst + 8, vmovl_u8(vget_high_u8(v)));
+    return true;
+#else
+    (void) src;
+    (void) dst;
+    return false;
+#endif
+}
 
-        // Copy data out of the old array and then let go of it.
-        // Note that we may be trimming the array.
-        if (mRawArray != NULL) {
-            memcpy(newRawArray, mRawArray, mOffset);
-            mEnv->ReleaseByteArrayElements(mJavaArray, mRawArray, JNI_ABORT);
-            mEnv->DeleteLocalRef(mJavaArray);
-        }
+// Tests whether the next 16 chars are all ASCII.
+static inline bool isAsciiChunk(const jchar* src) {
+#if defined(__SSE2__)
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8));
+    __m128i invalid = _mm_and_si128(_mm_or_si128(lo, hi), _mm_set1_epi16(0xff80));
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(invalid, _mm_setzero_si128())) == 0xffff;
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+    uint16x8_t lo = vld1q_u16(src);
+    uint16x8_t hi = vld1q_u16(src + 8);
+    uint64x2_t invalid = vreinterpretq_u64_u16(vandq_u16(vorrq_u16(lo, hi), vdupq_n_u16(0xff80)));
+    return (vgetq_lane_u64(invalid, 0) | vgetq_lane_u64(invalid, 1)) == 0;
+#else
+    (void) src;
+    return false;
+#endif
+}
 
-        // Point ourselves at the new array.
-        mJavaArray = newJavaArray;
-        mRawArray = newRawArray;
-        mSize = newSize;
-        return true;
+// Narrows 16 chars to 16 bytes if none of them has any of the bits in 'invalidBits' set.
+static inline bool charChunkToBytes(const jchar* src, jbyte* dst, jchar invalidBits) {
+#if defined(__SSE2__)
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8));
+    __m128i invalid = _mm_and_si128(_mm_or_si128(lo, hi), _mm_set1_epi16(invalidBits));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(invalid, _mm_setzero_si128())) != 0xffff) {
+        return false;
     }
-
-    jbyteArray toByteArray() {
-        // Trim any unused space, if necessary.
-        bool okay = resize(mOffset);
-        return okay ? mJavaArray : NULL;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(lo, hi));
+    return true;
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+    uint16x8_t lo = vld1q_u16(src);
+    uint16x8_t hi = vld1q_u16(src + 8);
+    uint64x2_t invalid = vreinterpretq_u64_u16(vandq_u16(vorrq_u16(lo, hi), vdupq_n_u16(invalidBits)));
+    if ((vgetq_lane_u64(invalid, 0) | vgetq_lane_u64(invalid, 1)) != 0) {
+        return false;
     }
-
-private:
-    JNIEnv* mEnv;
-    jbyteArray mJavaArray;
-    jbyte* mRawArray;
-    jint mSize;
-    jint mOffset;
-
-    // Disallow copy and assignment.
-    NativeUnsafeByteSequence(const NativeUnsafeByteSequence&);
-    void operator=(const NativeUnsafeByteSequence&);
-};
+    vst1q_u8(reinterpret_cast<uint8_t*>(dst), vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+    return true;
+#else
+    (void) src;
+    (void) dst;
+    (void) invalidBits;
+    return false;
+#endif
+}
 
 static void Charsets_asciiBytesToChars(JNIEnv* env, jclass, jbyteArray javaBytes, jint offset, jint length, jcharArray javaChars) {
     ScopedByteArrayRO bytes(env, javaBytes);
@@ -119,9 +143,19 @@ static void Charsets_asciiBytesToChars(JNIEnv* env, jclass, jbyteArray javaBytes
     const jbyte* src = &bytes[offset];
     jchar* dst = &chars[0];
     static const jchar REPLACEMENT_CHAR = 0xfffd;
-    for (int i = length - 1; i >= 0; --i) {
-        jchar ch = static_cast<jchar>(*src++ & 0xff);
-        *dst++ = (ch <= 0x7f) ? ch : REPLACEMENT_CHAR;
+    const jbyte* end = src + length;
+    while (src != end) {
+        if (static_cast<size_t>(end - src) >= CHUNK && asciiChunkToChars(src, dst)) {
+            src += CHUNK;
+            dst += CHUNK;
+            continue;
+        }
+        // Do the rest of this chunk (or the final partial chunk) a char at a time.
+        const jbyte* chunkEnd = (static_cast<size_t>(end - src) >= CHUNK) ? src + CHUNK : end;
+        while (src != chunkEnd) {
+            jchar ch = static_cast<jchar>(*src++ & 0xff);
+            *dst++ = (ch <= 0x7f) ? ch : REPLACEMENT_CHAR;
+        }
     }
 }
 
@@ -137,11 +171,127 @@ static void Charsets_isoLatin1BytesToChars(JNIEnv* env, jclass, jbyteArray javaB
 
     const jbyte* src = &bytes[offset];
     jchar* dst = &chars[0];
-    for (int i = length - 1; i >= 0; --i) {
+    int i = length;
+    while (i >= static_cast<int>(CHUNK) && latin1ChunkToChars(src, dst)) {
+        src += CHUNK;
+        dst += CHUNK;
+        i -= CHUNK;
+    }
+    for (--i; i >= 0; --i) {
         *dst++ = static_cast<jchar>(*src++ & 0xff);
     }
 }
 
+/**
+ * Decodes UTF-8, replacing each maximal ill-formed subsequence with U+FFFD as recommended by
+ * the Unicode Standard (section 3.9). Overlong forms, surrogates and values above U+10FFFF are
+ * all ill-formed. 'dst' must have room for 'length' chars, which is always enough. Returns the
+ * number of chars written, and sets '*firstMalformed' to the index of the first ill-formed byte
+ * relative to 'src', or -1.
+ */
+static size_t decodeUtf8(const jbyte* src, size_t length, jchar* dst, jint* firstMalformed) {
+    static const jchar REPLACEMENT_CHAR = 0xfffd;
+    const uint8_t* begin = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* p = begin;
+    const uint8_t* end = begin + length;
+    jchar* out = dst;
+    *firstMalformed = -1;
+    while (p != end) {
+        // Skip through runs of ASCII a chunk at a time.
+        if (static_cast<size_t>(end - p) >= CHUNK && asciiChunkToChars(reinterpret_cast<const jbyte*>(p), out)) {
+            p += CHUNK;
+            out += CHUNK;
+            continue;
+        }
+        uint8_t b0 = *p;
+        if (b0 < 0x80) {
+            *out++ = b0;
+            ++p;
+            continue;
+        }
+
+        // Work out how many continuation bytes we need, and the valid range of the first one.
+        // (Only the first continuation byte can be further restricted.)
+        size_t needed;
+        uint32_t codePoint;
+        uint8_t low = 0x80;
+        uint8_t high = 0xbf;
+        if (b0 >= 0xc2 && b0 <= 0xdf) {
+            needed = 1;
+            codePoint = b0 & 0x1f;
+        } else if (b0 >= 0xe0 && b0 <= 0xef) {
+            needed = 2;
+            codePoint = b0 & 0x0f;
+            if (b0 == 0xe0) {
+                low = 0xa0; // Overlong.
+            } else if (b0 == 0xed) {
+                high = 0x9f; // Surrogates.
+            }
+        } else if (b0 >= 0xf0 && b0 <= 0xf4) {
+            needed = 3;
+            codePoint = b0 & 0x07;
+            if (b0 == 0xf0) {
+                low = 0x90; // Overlong.
+            } else if (b0 == 0xf4) {
+                high = 0x8f; // Above U+10FFFF.
+            }
+        } else {
+            // A stray continuation byte, or a lead byte that can never be valid.
+            if (*firstMalformed == -1) {
+                *firstMalformed = p - begin;
+            }
+            *out++ = REPLACEMENT_CHAR;
+            ++p;
+            continue;
+        }
+
+        const uint8_t* sequence = p++;
+        size_t i = 0;
+        for (; i < needed && p != end; ++i) {
+            uint8_t b = *p;
+            if (b < low || b > high) {
+                break;
+            }
+            low = 0x80;
+            high = 0xbf;
+            codePoint = (codePoint << 6) | (b & 0x3f);
+            ++p;
+        }
+        if (i != needed) {
+            // Replace the valid prefix we consumed; the byte that broke it starts afresh.
+            if (*firstMalformed == -1) {
+                *firstMalformed = sequence - begin;
+            }
+            *out++ = REPLACEMENT_CHAR;
+            continue;
+        }
+        if (codePoint < 0x10000) {
+            *out++ = codePoint;
+        } else {
+            *out++ = U16_LEAD(codePoint);
+            *out++ = U16_TRAIL(codePoint);
+        }
+    }
+    return out - dst;
+}
+
+static jint Charsets_utf8BytesToCharsImpl(JNIEnv* env, jclass, jbyteArray javaBytes, jint offset, jint length, jcharArray javaChars, jintArray javaFirstMalformed) {
+    ScopedByteArrayRO bytes(env, javaBytes);
+    if (bytes.get() == NULL) {
+        return -1;
+    }
+    ScopedCharArrayRW chars(env, javaChars);
+    if (chars.get() == NULL) {
+        return -1;
+    }
+    jint firstMalformed;
+    size_t charCount = decodeUtf8(&bytes[offset], length, chars.get(), &firstMalformed);
+    if (javaFirstMalformed != NULL) {
+        env->SetIntArrayRegion(javaFirstMalformed, 0, 1, &firstMalformed);
+    }
+    return charCount;
+}
+
 /**
  * Translates the given characters to US-ASCII or ISO-8859-1 bytes, using the fact that
  * Unicode code points between U+0000 and U+007f inclusive are identical to US-ASCII, while
@@ -161,12 +311,23 @@ static jbyteArray charsToBytes(JNIEnv* env, jcharArray javaChars, jint offset, j
 
     const jchar* src = &chars[offset];
     jbyte* dst = &bytes[0];
-    for (int i = length - 1; i >= 0; --i) {
-        jchar ch = *src++;
-        if (ch > maxValidChar) {
-            ch = '?';
+    const jchar* end = src + length;
+    // maxValidChar is 0x7f or 0xff, so anything with one of these bits set is out of range.
+    const jchar invalidBits = ~maxValidChar;
+    while (src != end) {
+        if (static_cast<size_t>(end - src) >= CHUNK && charChunkToBytes(src, dst, invalidBits)) {
+            src += CHUNK;
+            dst += CHUNK;
+            continue;
+        }
+        const jchar* chunkEnd = (static_cast<size_t>(end - src) >= CHUNK) ? src + CHUNK : end;
+        while (src != chunkEnd) {
+            jchar ch = *src++;
+            if (ch > maxValidChar) {
+                ch = '?';
+            }
+            *dst++ = static_cast<jbyte>(ch);
         }
-        *dst++ = static_cast<jbyte>(ch);
     }
 
     return javaBytes;
@@ -180,70 +341,149 @@ static jbyteArray Charsets_toIsoLatin1Bytes(JNIEnv* env, jclass, jcharArray java
     return charsToBytes(env, javaChars, offset, length, 0xff);
 }
 
-static jbyteArray Charsets_toUtf8Bytes(JNIEnv* env, jclass, jcharArray javaChars, jint offset, jint length) {
-    ScopedCharArrayRO chars(env, javaChars);
-    if (chars.get() == NULL) {
-        return NULL;
-    }
-
-    NativeUnsafeByteSequence out(env);
-    if (!out.resize(length)) {
-        return NULL;
+/**
+ * Returns the number of bytes needed to encode the given chars as UTF-8. Unpaired surrogates
+ * count as one byte, because they're replaced by '?'.
+ */
+static size_t utf8Length(const jchar* src, size_t length) {
+    const jchar* end = src + length;
+    size_t byteCount = 0;
+    while (src != end) {
+        if (static_cast<size_t>(end - src) >= CHUNK && isAsciiChunk(src)) {
+            src += CHUNK;
+            byteCount += CHUNK;
+            continue;
+        }
+        jchar ch = *src++;
+        if (ch < 0x80) {
+            byteCount += 1;
+        } else if (ch < 0x800) {
+            byteCount += 2;
+        } else if (U16_IS_SURROGATE(ch)) {
+            if (U16_IS_SURROGATE_LEAD(ch) && src != end && U16_IS_SURROGATE_TRAIL(*src)) {
+                ++src;
+                byteCount += 4;
+            } else {
+                byteCount += 1;
+            }
+        } else {
+            byteCount += 3;
+        }
     }
+    return byteCount;
+}
 
-    const int end = offset + length;
-    for (int i = offset; i < end; ++i) {
-        jint ch = chars[i];
+/**
+ * Encodes the given chars as UTF-8. 'dst' must have room for utf8Length(src, length) bytes;
+ * nothing is checked here.
+ */
+static void encodeUtf8(const jchar* src, size_t length, jbyte* dst) {
+    const jchar* end = src + length;
+    while (src != end) {
+        if (static_cast<size_t>(end - src) >= CHUNK && charChunkToBytes(src, dst, 0xff80)) {
+            src += CHUNK;
+            dst += CHUNK;
+            continue;
+        }
+        jint ch = *src++;
         if (ch < 0x80) {
             // One byte.
-            if (!out.append(ch)) {
-                return NULL;
-            }
+            *dst++ = ch;
         } else if (ch < 0x800) {
             // Two bytes.
-            if (!out.append((ch >> 6) | 0xc0) || !out.append((ch & 0x3f) | 0x80)) {
-                return NULL;
-            }
+            *dst++ = (ch >> 6) | 0xc0;
+            *dst++ = (ch & 0x3f) | 0x80;
         } else if (U16_IS_SURROGATE(ch)) {
             // A supplementary character.
             jchar high = (jchar) ch;
-            jchar low = (i + 1 != end) ? chars[i + 1] : 0;
+            jchar low = (src != end) ? *src : 0;
             if (!U16_IS_SURROGATE_LEAD(high) || !U16_IS_SURROGATE_TRAIL(low)) {
-                if (!out.append('?')) {
-                    return NULL;
-                }
+                *dst++ = '?';
                 continue;
             }
             // Now we know we have a *valid* surrogate pair, we can consume the low surrogate.
-            ++i;
+            ++src;
             ch = U16_GET_SUPPLEMENTARY(high, low);
             // Four bytes.
-            jbyte b1 = (ch >> 18) | 0xf0;
-            jbyte b2 = ((ch >> 12) & 0x3f) | 0x80;
-            jbyte b3 = ((ch >> 6) & 0x3f) | 0x80;
-            jbyte b4 = (ch & 0x3f) | 0x80;
-            if (!out.append(b1) || !out.append(b2) || !out.append(b3) || !out.append(b4)) {
-                return NULL;
-            }
+            *dst++ = (ch >> 18) | 0xf0;
+            *dst++ = ((ch >> 12) & 0x3f) | 0x80;
+            *dst++ = ((ch >> 6) & 0x3f) | 0x80;
+            *dst++ = (ch & 0x3f) | 0x80;
         } else {
             // Three bytes.
-            jbyte b1 = (ch >> 12) | 0xe0;
-            jbyte b2 = ((ch >> 6) & 0x3f) | 0x80;
-            jbyte b3 = (ch & 0x3f) | 0x80;
-            if (!out.append(b1) || !out.append(b2) || !out.append(b3)) {
-                return NULL;
-            }
+            *dst++ = (ch >> 12) | 0xe0;
+            *dst++ = ((ch >> 6) & 0x3f) | 0x80;
+            *dst++ = (ch & 0x3f) | 0x80;
         }
     }
-    return out.toByteArray();
+}
+
+static jbyteArray Charsets_toUtf8Bytes(JNIEnv* env, jclass, jcharArray javaChars, jint offset, jint length) {
+    ScopedCharArrayRO chars(env, javaChars);
+    if (chars.get() == NULL) {
+        return NULL;
+    }
+    // Measure first so we allocate exactly the right size once and never need to check for room.
+    const jchar* src = &chars[offset];
+    size_t byteCount = utf8Length(src, length);
+    jbyteArray javaBytes = env->NewByteArray(byteCount);
+    ScopedByteArrayRW bytes(env, javaBytes);
+    if (bytes.get() == NULL) {
+        return NULL;
+    }
+    encodeUtf8(src, length, bytes.get());
+    return javaBytes;
+}
+
+static jint Charsets_utf8LengthImpl(JNIEnv* env, jclass, jcharArray javaChars, jint offset, jint length) {
+    ScopedCharArrayRO chars(env, javaChars);
+    if (chars.get() == NULL) {
+        return -1;
+    }
+    return utf8Length(&chars[offset], length);
+}
+
+// Returns the number of bytes written, or -1 if they wouldn't fit in 'capacity' bytes at 'dst'.
+static jint encodeUtf8Checked(const jchar* src, jint length, jbyte* dst, jint capacity) {
+    size_t byteCount = utf8Length(src, length);
+    if (byteCount > static_cast<size_t>(capacity)) {
+        return -1;
+    }
+    encodeUtf8(src, length, dst);
+    return byteCount;
+}
+
+static jint Charsets_encodeUtf8Bytes(JNIEnv* env, jclass, jcharArray javaChars, jint offset, jint length, jbyteArray javaDst, jint dstOffset, jint capacity) {
+    ScopedCharArrayRO chars(env, javaChars);
+    if (chars.get() == NULL) {
+        return -1;
+    }
+    ScopedByteArrayRW dst(env, javaDst);
+    if (dst.get() == NULL) {
+        return -1;
+    }
+    return encodeUtf8Checked(&chars[offset], length, dst.get() + dstOffset, capacity);
+}
+
+static jint Charsets_encodeUtf8Address(JNIEnv* env, jclass, jcharArray javaChars, jint offset, jint length, jlong address, jint capacity) {
+    ScopedCharArrayRO chars(env, javaChars);
+    if (chars.get() == NULL) {
+        return -1;
+    }
+    jbyte* dst = reinterpret_cast<jbyte*>(static_cast<uintptr_t>(address));
+    return encodeUtf8Checked(&chars[offset], length, dst, capacity);
 }
 
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Charsets, asciiBytesToChars, "([BII[C)V"),
+    NATIVE_METHOD(Charsets, encodeUtf8Address, "([CIIJI)I"),
+    NATIVE_METHOD(Charsets, encodeUtf8Bytes, "([CII[BII)I"),
     NATIVE_METHOD(Charsets, isoLatin1BytesToChars, "([BII[C)V"),
     NATIVE_METHOD(Charsets, toAsciiBytes, "([CII)[B"),
     NATIVE_METHOD(Charsets, toIsoLatin1Bytes, "([CII)[B"),
     NATIVE_METHOD(Charsets, toUtf8Bytes, "([CII)[B"),
+    NATIVE_METHOD(Charsets, utf8BytesToCharsImpl, "([BII[C[I)I"),
+    NATIVE_METHOD(Charsets, utf8LengthImpl, "([CII)I"),
 };
 void register_java_nio_charset_Charsets(JNIEnv* env) {
     jniRegisterNativeMethods(env, "java/nio/charset/Charsets", gMethods, NELEM(gMethods));
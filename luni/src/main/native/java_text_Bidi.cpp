@@ -19,7 +19,6 @@
 
 #include "IcuUtilities.h"
 #include "JNIHelp.h"
-#include "JniConstants.h"
 #include "JniException.h"
 #include "ScopedPrimitiveArray.h"
 #include "UniquePtr.h"
@@ -116,48 +115,67 @@ static jbyte Bidi_ubidi_getParaLevel(JNIEnv*, jclass, jlong ptr) {
     return ubidi_getParaLevel(uBiDi(ptr));
 }
 
+// Returns null if every char is at the paragraph level, which is what unidirectional text
+// usually looks like, so that Bidi needn't keep a byte per char that tells it nothing.
 static jbyteArray Bidi_ubidi_getLevels(JNIEnv* env, jclass, jlong ptr) {
+    UBiDi* ubidi = uBiDi(ptr);
     UErrorCode status = U_ZERO_ERROR;
-    const UBiDiLevel* levels = ubidi_getLevels(uBiDi(ptr), &status);
+    const UBiDiLevel* levels = ubidi_getLevels(ubidi, &status);
     if (maybeThrowIcuException(env, "ubidi_getLevels", status)) {
         return NULL;
     }
-    int len = ubidi_getLength(uBiDi(ptr));
+    int len = ubidi_getLength(ubidi);
+    UBiDiLevel paraLevel = ubidi_getParaLevel(ubidi);
+    int i = 0;
+    while (i < len && levels[i] == paraLevel) {
+        ++i;
+    }
+    if (i == len) {
+        return NULL;
+    }
     jbyteArray result = env->NewByteArray(len);
-    env->SetByteArrayRegion(result, 0, len, reinterpret_cast<const jbyte*>(levels));
+    if (result != NULL) {
+        env->SetByteArrayRegion(result, 0, len, reinterpret_cast<const jbyte*>(levels));
+    }
     return result;
 }
 
-static jint Bidi_ubidi_countRuns(JNIEnv* env, jclass, jlong ptr) {
-    UErrorCode status = U_ZERO_ERROR;
-    int count = ubidi_countRuns(uBiDi(ptr), &status);
-    maybeThrowIcuException(env, "ubidi_countRuns", status);
-    return count;
-}
-
 /**
- * TODO: if we care about performance, we might just want to use an int[] instead of a Run[].
+ * Returns the logical runs as (start, limit, level) triples, or null if the text is a single
+ * run at the paragraph level (or there's no text). Unidirectional text, by far the most common
+ * case, is answered by ubidi_getDirection without ICU having to compute the runs at all.
  */
-static jobjectArray Bidi_ubidi_getRuns(JNIEnv* env, jclass, jlong ptr) {
+static jintArray Bidi_ubidi_getRuns(JNIEnv* env, jclass, jlong ptr) {
     UBiDi* ubidi = uBiDi(ptr);
+    if (ubidi_getDirection(ubidi) != UBIDI_MIXED) {
+        // ICU reports such text as one run at the paragraph level.
+        return NULL;
+    }
     UErrorCode status = U_ZERO_ERROR;
     int runCount = ubidi_countRuns(ubidi, &status);
     if (maybeThrowIcuException(env, "ubidi_countRuns", status)) {
         return NULL;
     }
-    static jmethodID bidiRunConstructor =
-            env->GetMethodID(JniConstants::bidiRunClass, "<init>", "(III)V");
-    jobjectArray runs = env->NewObjectArray(runCount, JniConstants::bidiRunClass, NULL);
+    UBiDiLevel paraLevel = ubidi_getParaLevel(ubidi);
+    UniquePtr<jint[]> runs(new jint[3 * runCount]);
     UBiDiLevel level = 0;
     int start = 0;
     int limit = 0;
     for (int i = 0; i < runCount; ++i) {
         ubidi_getLogicalRun(ubidi, start, &limit, &level);
-        jobject run = env->NewObject(JniConstants::bidiRunClass, bidiRunConstructor, start, limit, level);
-        env->SetObjectArrayElement(runs, i, run);
+        runs[3 * i] = start;
+        runs[3 * i + 1] = limit;
+        runs[3 * i + 2] = level;
         start = limit;
     }
-    return runs;
+    if (runCount <= 0 || (runCount == 1 && runs[2] == paraLevel)) {
+        return NULL;
+    }
+    jintArray result = env->NewIntArray(3 * runCount);
+    if (result != NULL) {
+        env->SetIntArrayRegion(result, 0, 3 * runCount, &runs[0]);
+    }
+    return result;
 }
 
 static jintArray Bidi_ubidi_reorderVisual(JNIEnv* env, jclass, jbyteArray javaLevels, jint length) {
@@ -178,12 +196,11 @@ static jintArray Bidi_ubidi_reorderVisual(JNIEnv* env, jclass, jbyteArray javaLe
 
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Bidi, ubidi_close, "(J)V"),
-    NATIVE_METHOD(Bidi, ubidi_countRuns, "(J)I"),
     NATIVE_METHOD(Bidi, ubidi_getDirection, "(J)I"),
     NATIVE_METHOD(Bidi, ubidi_getLength, "(J)I"),
     NATIVE_METHOD(Bidi, ubidi_getLevels, "(J)[B"),
     NATIVE_METHOD(Bidi, ubidi_getParaLevel, "(J)B"),
-    NATIVE_METHOD(Bidi, ubidi_getRuns, "(J)[Ljava/text/Bidi$Run;"),
+    NATIVE_METHOD(Bidi, ubidi_getRuns, "(J)[I"),
     NATIVE_METHOD(Bidi, ubidi_open, "()J"),
     NATIVE_METHOD(Bidi, ubidi_reorderVisual, "([BI)[I"),
     NATIVE_METHOD(Bidi, ubidi_setLine, "(JII)J"),
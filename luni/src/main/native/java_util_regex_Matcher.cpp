@@ -17,7 +17,10 @@
 #define LOG_TAG "Matcher"
 
 #include <stdlib.h>
+#include <string.h>
+#include <vector>
 
+#include "CompiledPattern.h"
 #include "IcuUtilities.h"
 #include "JNIHelp.h"
 #include "JniConstants.h"
@@ -27,188 +30,471 @@
 #include "jni.h"
 #include "unicode/parseerr.h"
 #include "unicode/regex.h"
+#include "unicode/uchar.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 // ICU documentation: http://icu-project.org/apiref/icu4c/classRegexMatcher.html
 
-static RegexMatcher* toRegexMatcher(jlong address) {
-    return reinterpret_cast<RegexMatcher*>(static_cast<uintptr_t>(address));
+/*
+ * Search kernels for FastPattern. Each returns the position of the first char in [begin, end)
+ * equal to one of the 'count' (at most FastPattern::MAX_VECTOR_FIRST_CHARS) chars in 'targets',
+ * or 'end' if there isn't one.
+ */
+static const jchar* findFirstOf(const jchar* begin, const jchar* end, const jchar* targets,
+        size_t count) {
+    const jchar* p = begin;
+#if defined(__SSE2__)
+    __m128i t[FastPattern::MAX_VECTOR_FIRST_CHARS];
+    for (size_t i = 0; i < count; ++i) {
+        t[i] = _mm_set1_epi16(targets[i]);
+    }
+    for (; end - p >= 8; p += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_cmpeq_epi16(v, t[0]);
+        for (size_t i = 1; i < count; ++i) {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi16(v, t[i]));
+        }
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask) / 2;
+        }
+    }
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+    uint16x8_t t[FastPattern::MAX_VECTOR_FIRST_CHARS];
+    for (size_t i = 0; i < count; ++i) {
+        t[i] = vdupq_n_u16(targets[i]);
+    }
+    for (; end - p >= 8; p += 8) {
+        uint16x8_t v = vld1q_u16(p);
+        uint16x8_t hits = vceqq_u16(v, t[0]);
+        for (size_t i = 1; i < count; ++i) {
+            hits = vorrq_u16(hits, vceqq_u16(v, t[i]));
+        }
+        uint64x2_t any = vreinterpretq_u64_u16(hits);
+        if ((vgetq_lane_u64(any, 0) | vgetq_lane_u64(any, 1)) != 0) {
+            break; // The scalar loop finds which one.
+        }
+    }
+#endif
+    for (; p < end; ++p) {
+        for (size_t i = 0; i < count; ++i) {
+            if (*p == targets[i]) {
+                return p;
+            }
+        }
+    }
+    return end;
+}
+
+// Matches ICU's \s, which is [\p{WhiteSpace}].
+static inline bool isRegexWhiteSpace(jchar ch) {
+    if (ch < 0x80) {
+        return ch == ' ' || (ch >= '\t' && ch <= '\r');
+    }
+    return u_isUWhiteSpace(ch);
+}
+
+/**
+ * Finds the leftmost match of 'pattern' in [begin, end), preferring earlier alternatives at the
+ * same position, as ICU does. Returns false if there isn't one.
+ */
+static bool fastFind(const FastPattern& pattern, const jchar* begin, const jchar* end,
+        const jchar*& matchStart, const jchar*& matchEnd) {
+    if (pattern.kind != FastPattern::LITERALS) {
+        const jchar* p = begin;
+        while (p < end && !isRegexWhiteSpace(*p)) {
+            ++p;
+        }
+        if (p == end) {
+            return false;
+        }
+        matchStart = p++;
+        if (pattern.kind == FastPattern::WHITESPACE_RUN) {
+            while (p < end && isRegexWhiteSpace(*p)) {
+                ++p;
+            }
+        }
+        matchEnd = p;
+        return true;
+    }
+
+    const std::vector<jchar>& firstChars(pattern.firstChars);
+    bool vectorize = firstChars.size() <= FastPattern::MAX_VECTOR_FIRST_CHARS;
+    for (const jchar* p = begin; p < end; ++p) {
+        if (vectorize) {
+            p = findFirstOf(p, end, &firstChars[0], firstChars.size());
+            if (p == end) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < pattern.literals.size(); ++i) {
+            const std::vector<jchar>& literal(pattern.literals[i]);
+            size_t length = literal.size();
+            if (static_cast<size_t>(end - p) >= length &&
+                    memcmp(p, &literal[0], length * sizeof(jchar)) == 0) {
+                matchStart = p;
+                matchEnd = p + length;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// RegexMatcher::find only reports errors through a UErrorCode from ICU 55. Before that, find()
+// records them internally and just returns false.
+static bool icuFind(RegexMatcher* matcher, UErrorCode& status) {
+#if U_ICU_VERSION_MAJOR_NUM >= 55
+    return matcher->find(status);
+#else
+    if (U_FAILURE(status)) {
+        return false;
+    }
+    return matcher->find();
+#endif
 }
 
 /**
  * We use ICU4C's RegexMatcher class, but our input is on the Java heap and potentially moving
- * around between calls. This wrapper class ensures that our RegexMatcher is always pointing at
- * the current location of the char[]. Earlier versions of Android simply copied the data to the
- * native heap, but that's wasteful and hides allocations from the garbage collector.
+ * around between calls. Rebinding the matcher to the current location of the char[] on every
+ * call means a GetStringChars/ReleaseStringChars pair (and possibly a copy) per match, which
+ * dominates a find() loop over a long input. Instead we copy the input to the native heap once
+ * in setInputImpl, and every other call works on that copy until the input changes again.
+ *
+ * For a FastPattern, find() doesn't use ICU at all. ICU's matcher is left where it was before
+ * the fast finds, and only brought up to date (by replaying the last find) if we need it for
+ * hitEnd or requireEnd. matches() and lookingAt() always use ICU, and subsequent finds continue
+ * from ICU's state until the next reset.
  */
-class MatcherAccessor {
+class NativeMatcher {
 public:
-    MatcherAccessor(JNIEnv* env, jlong address, jstring javaInput, bool reset) {
-        init(env, address);
+    NativeMatcher(CompiledPattern* pattern, RegexMatcher* matcher)
+            : mPattern(pattern), mMatcher(matcher), mChars(NULL), mCapacity(0), mLength(0),
+              mUText(NULL) {
+        resetFastState(0, 0);
+    }
 
-        mJavaInput = javaInput;
-        mChars = env->GetStringChars(mJavaInput, NULL);
-        if (mChars == NULL) {
-            return;
+    ~NativeMatcher() {
+        mPattern->recycleMatcher(mMatcher);
+        utext_close(mUText);
+        free(mChars);
+    }
+
+    RegexMatcher* operator->() {
+        return mMatcher;
+    }
+
+    /**
+     * Copies 'javaInput' and rebinds the matcher to the copy. Returns false with a pending
+     * exception if the copy couldn't be made.
+     */
+    bool setInput(JNIEnv* env, jstring javaInput, UErrorCode& status) {
+        jsize length = env->GetStringLength(javaInput);
+        // Always keep a buffer, so an empty input doesn't look like a missing one to ICU.
+        size_t capacity = (length > 0) ? length : 1;
+        if (capacity > mCapacity) {
+            jchar* chars = reinterpret_cast<jchar*>(realloc(mChars, capacity * sizeof(jchar)));
+            if (chars == NULL) {
+                jniThrowOutOfMemoryError(env, "regex input");
+                return false;
+            }
+            mChars = chars;
+            mCapacity = capacity;
+        }
+        env->GetStringRegion(javaInput, 0, length, mChars);
+        if (env->ExceptionCheck()) {
+            return false;
         }
+        mLength = length;
 
-        mUText = utext_openUChars(NULL, mChars, env->GetStringLength(mJavaInput), &mStatus);
+        // Reuse our UText rather than allocating a new one for every input.
+        mUText = utext_openUChars(mUText, mChars, length, &status);
         if (mUText == NULL) {
-            return;
+            return false;
         }
+        mMatcher->reset(mUText);
+        resetFastState(0, length);
+        return true;
+    }
 
-        if (reset) {
-            mMatcher->reset(mUText);
-        } else {
-            mMatcher->refreshInputText(mUText, mStatus);
-        }
+    void region(jint start, jint end, UErrorCode& status) {
+        mMatcher->region(start, end, status);
+        resetFastState(start, end);
     }
 
-    MatcherAccessor(JNIEnv* env, jlong address) {
-        init(env, address);
+    bool find(UErrorCode& status) {
+        if (!usingFastPath()) {
+            return icuFind(mMatcher, status);
+        }
+        if (mSearchStart == -1) {
+            // Like ICU's find(), keep failing until the next reset.
+            return false;
+        }
+        mReplayStart = mSearchStart;
+        const jchar* matchStart;
+        const jchar* matchEnd;
+        if (!fastFind(mPattern->fastPattern(), mChars + mSearchStart, mChars + mRegionEnd,
+                matchStart, matchEnd)) {
+            mMatchStart = mMatchEnd = mSearchStart = -1;
+            return false;
+        }
+        mMatchStart = matchStart - mChars;
+        mMatchEnd = mSearchStart = matchEnd - mChars;
+        return true;
     }
 
-    ~MatcherAccessor() {
-        utext_close(mUText);
-        if (mJavaInput) {
-            mEnv->ReleaseStringChars(mJavaInput, mChars);
+    bool find(jint startIndex, UErrorCode& status) {
+        if (mPattern->fastPattern().kind == FastPattern::NONE) {
+            return mMatcher->find(startIndex, status);
         }
-        maybeThrowIcuException(mEnv, "utext_close", mStatus);
+        // ICU's find(int) resets the matcher, region included, before it searches.
+        mMatcher->reset();
+        resetFastState(0, mLength);
+        mSearchStart = startIndex;
+        return find(status);
     }
 
-    RegexMatcher* operator->() {
-        return mMatcher;
+    bool lookingAt(UErrorCode& status) {
+        mIcuOwnsState = true;
+        return mMatcher->lookingAt(status);
+    }
+
+    bool matches(UErrorCode& status) {
+        mIcuOwnsState = true;
+        return mMatcher->matches(status);
+    }
+
+    bool hitEnd(UErrorCode& status) {
+        syncIcuState(status);
+        return mMatcher->hitEnd();
+    }
+
+    bool requireEnd(UErrorCode& status) {
+        syncIcuState(status);
+        return mMatcher->requireEnd();
+    }
+
+    jint start(UErrorCode& status) {
+        return usingFastPath() ? mMatchStart : mMatcher->start(status);
     }
 
-    UErrorCode& status() {
-        return mStatus;
+    jint end(UErrorCode& status) {
+        return usingFastPath() ? mMatchEnd : mMatcher->end(status);
     }
 
-    void updateOffsets(jintArray javaOffsets) {
-        ScopedIntArrayRW offsets(mEnv, javaOffsets);
+    void updateOffsets(JNIEnv* env, jintArray javaOffsets, UErrorCode& status) {
+        ScopedIntArrayRW offsets(env, javaOffsets);
         if (offsets.get() == NULL) {
             return;
         }
 
+        if (usingFastPath()) {
+            // Fast patterns have no groups.
+            offsets[0] = mMatchStart;
+            offsets[1] = mMatchEnd;
+            return;
+        }
         for (size_t i = 0, groupCount = mMatcher->groupCount(); i <= groupCount; ++i) {
-            offsets[2*i + 0] = mMatcher->start(i, mStatus);
-            offsets[2*i + 1] = mMatcher->end(i, mStatus);
+            offsets[2*i + 0] = mMatcher->start(i, status);
+            offsets[2*i + 1] = mMatcher->end(i, status);
         }
     }
 
 private:
-    void init(JNIEnv* env, jlong address) {
-        mEnv = env;
-        mJavaInput = NULL;
-        mMatcher = toRegexMatcher(address);
-        mChars = NULL;
-        mStatus = U_ZERO_ERROR;
-        mUText = NULL;
+    bool usingFastPath() const {
+        return mPattern->fastPattern().kind != FastPattern::NONE && !mIcuOwnsState;
+    }
+
+    // Called whenever ICU's matcher is reset, so the two agree again.
+    void resetFastState(jint regionStart, jint regionEnd) {
+        mRegionStart = mSearchStart = regionStart;
+        mRegionEnd = regionEnd;
+        mMatchStart = mMatchEnd = -1;
+        mReplayStart = -1;
+        mIcuOwnsState = false;
     }
 
-    JNIEnv* mEnv;
-    jstring mJavaInput;
+    // Repeats the last fast find with ICU, so ICU's state is what it would have been.
+    void syncIcuState(UErrorCode& status) {
+        if (!usingFastPath() || mReplayStart == -1) {
+            return;
+        }
+        mMatcher->region(mRegionStart, mRegionEnd, mReplayStart, status);
+        icuFind(mMatcher, status);
+        mReplayStart = -1;
+    }
+
+    CompiledPattern* mPattern;
     RegexMatcher* mMatcher;
-    const jchar* mChars;
-    UErrorCode mStatus;
+    jchar* mChars;
+    size_t mCapacity;
+    jint mLength;
     UText* mUText;
 
+    // Fast path state: the region, where the next find() starts (-1 after a failed find), the
+    // current match, and where the last find started (-1 if ICU doesn't need to replay it).
+    jint mRegionStart;
+    jint mRegionEnd;
+    jint mSearchStart;
+    jint mMatchStart;
+    jint mMatchEnd;
+    jint mReplayStart;
+    // True after lookingAt or matches, until the next reset: find() then continues from ICU's
+    // state instead of ours.
+    bool mIcuOwnsState;
+
     // Disallow copy and assignment.
-    MatcherAccessor(const MatcherAccessor&);
-    void operator=(const MatcherAccessor&);
+    NativeMatcher(const NativeMatcher&);
+    void operator=(const NativeMatcher&);
 };
 
+static NativeMatcher* toNativeMatcher(jlong address) {
+    return reinterpret_cast<NativeMatcher*>(static_cast<uintptr_t>(address));
+}
+
 static void Matcher_closeImpl(JNIEnv*, jclass, jlong address) {
-    delete toRegexMatcher(address);
+    delete toNativeMatcher(address);
 }
 
-static jint Matcher_findImpl(JNIEnv* env, jclass, jlong addr, jstring javaText, jint startIndex, jintArray offsets) {
-    MatcherAccessor matcher(env, addr, javaText, false);
-    UBool result = matcher->find(startIndex, matcher.status());
-    if (result) {
-        matcher.updateOffsets(offsets);
+static jintArray Matcher_findAllImpl(JNIEnv* env, jclass, jlong addr, jint maxCount) {
+    NativeMatcher& matcher = *toNativeMatcher(addr);
+    UErrorCode status = U_ZERO_ERROR;
+    std::vector<jint> offsets;
+    for (jint count = 0; count != maxCount && matcher.find(status); ++count) {
+        offsets.push_back(matcher.start(status));
+        offsets.push_back(matcher.end(status));
+    }
+    if (maybeThrowIcuException(env, "RegexMatcher::find", status)) {
+        return NULL;
+    }
+
+    jintArray result = env->NewIntArray(offsets.size());
+    if (result != NULL && !offsets.empty()) {
+        env->SetIntArrayRegion(result, 0, offsets.size(), &offsets[0]);
     }
     return result;
 }
 
-static jint Matcher_findNextImpl(JNIEnv* env, jclass, jlong addr, jstring javaText, jintArray offsets) {
-    MatcherAccessor matcher(env, addr, javaText, false);
-    if (matcher.status() != U_ZERO_ERROR) {
-        return -1;
+static jint Matcher_findImpl(JNIEnv* env, jclass, jlong addr, jint startIndex, jintArray offsets) {
+    NativeMatcher& matcher = *toNativeMatcher(addr);
+    UErrorCode status = U_ZERO_ERROR;
+    bool result = matcher.find(startIndex, status);
+    if (result) {
+        matcher.updateOffsets(env, offsets, status);
     }
-    UBool result = matcher->find();
+    maybeThrowIcuException(env, "RegexMatcher::find", status);
+    return result;
+}
+
+static jint Matcher_findNextImpl(JNIEnv* env, jclass, jlong addr, jintArray offsets) {
+    NativeMatcher& matcher = *toNativeMatcher(addr);
+    UErrorCode status = U_ZERO_ERROR;
+    bool result = matcher.find(status);
     if (result) {
-        matcher.updateOffsets(offsets);
+        matcher.updateOffsets(env, offsets, status);
     }
+    maybeThrowIcuException(env, "RegexMatcher::find", status);
     return result;
 }
 
-static jint Matcher_groupCountImpl(JNIEnv* env, jclass, jlong addr) {
-    MatcherAccessor matcher(env, addr);
+static jint Matcher_groupCountImpl(JNIEnv*, jclass, jlong addr) {
+    NativeMatcher& matcher = *toNativeMatcher(addr);
     return matcher->groupCount();
 }
 
 static jint Matcher_hitEndImpl(JNIEnv* env, jclass, jlong addr) {
-    MatcherAccessor matcher(env, addr);
-    return matcher->hitEnd();
+    NativeMatcher& matcher = *toNativeMatcher(addr);
+    UErrorCode status = U_ZERO_ERROR;
+    bool result = matcher.hitEnd(status);
+    maybeThrowIcuException(env, "RegexMatcher::region", status);
+    return result;
 }
 
-static jint Matcher_lookingAtImpl(JNIEnv* env, jclass, jlong addr, jstring javaText, jintArray offsets) {
-    MatcherAccessor matcher(env, addr, javaText, false);
-    UBool result = matcher->lookingAt(matcher.status());
+static jint Matcher_lookingAtImpl(JNIEnv* env, jclass, jlong addr, jintArray offsets) {
+    NativeMatcher& matcher = *toNativeMatcher(addr);
+    UErrorCode status = U_ZERO_ERROR;
+    bool result = matcher.lookingAt(status);
     if (result) {
-        matcher.updateOffsets(offsets);
+        matcher.updateOffsets(env, offsets, status);
     }
+    maybeThrowIcuException(env, "RegexMatcher::lookingAt", status);
     return result;
 }
 
-static jint Matcher_matchesImpl(JNIEnv* env, jclass, jlong addr, jstring javaText, jintArray offsets) {
-    MatcherAccessor matcher(env, addr, javaText, false);
-    UBool result = matcher->matches(matcher.status());
+static jint Matcher_matchesImpl(JNIEnv* env, jclass, jlong addr, jintArray offsets) {
+    NativeMatcher& matcher = *toNativeMatcher(addr);
+    UErrorCode status = U_ZERO_ERROR;
+    bool result = matcher.matches(status);
     if (result) {
-        matcher.updateOffsets(offsets);
+        matcher.updateOffsets(env, offsets, status);
     }
+    maybeThrowIcuException(env, "RegexMatcher::matches", status);
     return result;
 }
 
 static jlong Matcher_openImpl(JNIEnv* env, jclass, jlong patternAddr) {
-    RegexPattern* pattern = reinterpret_cast<RegexPattern*>(static_cast<uintptr_t>(patternAddr));
+    CompiledPattern* pattern = toCompiledPattern(patternAddr);
     UErrorCode status = U_ZERO_ERROR;
-    RegexMatcher* result = pattern->matcher(status);
-    maybeThrowIcuException(env, "RegexPattern::matcher", status);
-    return reinterpret_cast<uintptr_t>(result);
+    RegexMatcher* matcher = pattern->newMatcher(status);
+    if (maybeThrowIcuException(env, "RegexPattern::matcher", status)) {
+        return 0;
+    }
+    return reinterpret_cast<uintptr_t>(new NativeMatcher(pattern, matcher));
 }
 
 static jint Matcher_requireEndImpl(JNIEnv* env, jclass, jlong addr) {
-    MatcherAccessor matcher(env, addr);
-    return matcher->requireEnd();
+    NativeMatcher& matcher = *toNativeMatcher(addr);
+    UErrorCode status = U_ZERO_ERROR;
+    bool result = matcher.requireEnd(status);
+    maybeThrowIcuException(env, "RegexMatcher::region", status);
+    return result;
+}
+
+static void Matcher_setRegionImpl(JNIEnv* env, jclass, jlong addr, jint start, jint end) {
+    NativeMatcher& matcher = *toNativeMatcher(addr);
+    UErrorCode status = U_ZERO_ERROR;
+    // Resets the matcher, but keeps the input we already have.
+    matcher.region(start, end, status);
+    maybeThrowIcuException(env, "RegexMatcher::region", status);
 }
 
 static void Matcher_setInputImpl(JNIEnv* env, jclass, jlong addr, jstring javaText, jint start, jint end) {
-    MatcherAccessor matcher(env, addr, javaText, true);
-    matcher->region(start, end, matcher.status());
+    NativeMatcher& matcher = *toNativeMatcher(addr);
+    UErrorCode status = U_ZERO_ERROR;
+    if (matcher.setInput(env, javaText, status)) {
+        matcher.region(start, end, status);
+    }
+    maybeThrowIcuException(env, "RegexMatcher::region", status);
 }
 
-static void Matcher_useAnchoringBoundsImpl(JNIEnv* env, jclass, jlong addr, jboolean value) {
-    MatcherAccessor matcher(env, addr);
+static void Matcher_useAnchoringBoundsImpl(JNIEnv*, jclass, jlong addr, jboolean value) {
+    NativeMatcher& matcher = *toNativeMatcher(addr);
     matcher->useAnchoringBounds(value);
 }
 
-static void Matcher_useTransparentBoundsImpl(JNIEnv* env, jclass, jlong addr, jboolean value) {
-    MatcherAccessor matcher(env, addr);
+static void Matcher_useTransparentBoundsImpl(JNIEnv*, jclass, jlong addr, jboolean value) {
+    NativeMatcher& matcher = *toNativeMatcher(addr);
     matcher->useTransparentBounds(value);
 }
 
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Matcher, closeImpl, "(J)V"),
-    NATIVE_METHOD(Matcher, findImpl, "(JLjava/lang/String;I[I)Z"),
-    NATIVE_METHOD(Matcher, findNextImpl, "(JLjava/lang/String;[I)Z"),
+    NATIVE_METHOD(Matcher, findAllImpl, "(JI)[I"),
+    NATIVE_METHOD(Matcher, findImpl, "(JI[I)Z"),
+    NATIVE_METHOD(Matcher, findNextImpl, "(J[I)Z"),
     NATIVE_METHOD(Matcher, groupCountImpl, "(J)I"),
     NATIVE_METHOD(Matcher, hitEndImpl, "(J)Z"),
-    NATIVE_METHOD(Matcher, lookingAtImpl, "(JLjava/lang/String;[I)Z"),
-    NATIVE_METHOD(Matcher, matchesImpl, "(JLjava/lang/String;[I)Z"),
+    NATIVE_METHOD(Matcher, lookingAtImpl, "(J[I)Z"),
+    NATIVE_METHOD(Matcher, matchesImpl, "(J[I)Z"),
     NATIVE_METHOD(Matcher, openImpl, "(J)J"),
     NATIVE_METHOD(Matcher, requireEndImpl, "(J)Z"),
     NATIVE_METHOD(Matcher, setInputImpl, "(JLjava/lang/String;II)V"),
+    NATIVE_METHOD(Matcher, setRegionImpl, "(JII)V"),
     NATIVE_METHOD(Matcher, useAnchoringBoundsImpl, "(JZ)V"),
     NATIVE_METHOD(Matcher, useTransparentBoundsImpl, "(JZ)V"),
 };
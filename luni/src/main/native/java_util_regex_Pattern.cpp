@@ -16,19 +16,262 @@
 
 #define LOG_TAG "Pattern"
 
+#include <algorithm>
+#include <list>
+#include <map>
+#include <pthread.h>
 #include <stdlib.h>
 
+#include "CompiledPattern.h"
 #include "JNIHelp.h"
 #include "JniConstants.h"
 #include "ScopedJavaUnicodeString.h"
+#include "ScopedPthreadMutexLock.h"
 #include "jni.h"
 #include "unicode/parseerr.h"
 #include "unicode/regex.h"
 
 // ICU documentation: http://icu-project.org/apiref/icu4c/classRegexPattern.html
 
-static RegexPattern* toRegexPattern(jlong addr) {
-    return reinterpret_cast<RegexPattern*>(static_cast<uintptr_t>(addr));
+// How many idle RegexMatchers each pattern keeps. Matchers are mostly closed by the finalizer
+// thread rather than the thread that used them, so they're pooled per pattern, not per thread.
+static const size_t MAX_IDLE_MATCHERS = 4;
+
+// How many compiled patterns we keep around for reuse. Entries still used by a Pattern or
+// Matcher survive eviction; they just can't be found again.
+static const size_t MAX_CACHED_PATTERNS = 64;
+
+static pthread_mutex_t gIdleMatchersMutex = PTHREAD_MUTEX_INITIALIZER;
+
+CompiledPattern::CompiledPattern(RegexPattern* pattern, const FastPattern& fastPattern)
+        : mPattern(pattern), mFastPattern(fastPattern), mRefCount(1) {
+}
+
+CompiledPattern::~CompiledPattern() {
+    for (size_t i = 0; i < mIdleMatchers.size(); ++i) {
+        delete mIdleMatchers[i];
+    }
+    delete mPattern;
+}
+
+void CompiledPattern::retain() {
+    __sync_add_and_fetch(&mRefCount, 1);
+}
+
+void CompiledPattern::release() {
+    if (__sync_sub_and_fetch(&mRefCount, 1) == 0) {
+        delete this;
+    }
+}
+
+RegexMatcher* CompiledPattern::newMatcher(UErrorCode& status) {
+    RegexMatcher* matcher = NULL;
+    {
+        ScopedPthreadMutexLock lock(&gIdleMatchersMutex);
+        if (!mIdleMatchers.empty()) {
+            matcher = mIdleMatchers.back();
+            mIdleMatchers.pop_back();
+        }
+    }
+    if (matcher == NULL) {
+        matcher = mPattern->matcher(status);
+        if (U_FAILURE(status)) {
+            delete matcher;
+            return NULL;
+        }
+    }
+    retain();
+    return matcher;
+}
+
+void CompiledPattern::recycleMatcher(RegexMatcher* matcher) {
+    // Don't leave the matcher pointing at its last user's input, which is about to be freed.
+    static const UChar EMPTY[] = { 0 };
+    UErrorCode status = U_ZERO_ERROR;
+    UText empty = UTEXT_INITIALIZER;
+    utext_openUChars(&empty, EMPTY, 0, &status);
+    if (U_SUCCESS(status)) {
+        matcher->reset(&empty);
+        matcher->useAnchoringBounds(true);
+        matcher->useTransparentBounds(false);
+        utext_close(&empty);
+    }
+
+    bool kept = false;
+    if (U_SUCCESS(status)) {
+        ScopedPthreadMutexLock lock(&gIdleMatchersMutex);
+        if (mIdleMatchers.size() < MAX_IDLE_MATCHERS) {
+            mIdleMatchers.push_back(matcher);
+            kept = true;
+        }
+    }
+    if (!kept) {
+        delete matcher;
+    }
+    release();
+}
+
+CompiledPattern* toCompiledPattern(jlong address) {
+    return reinterpret_cast<CompiledPattern*>(static_cast<uintptr_t>(address));
+}
+
+// Alternations with more literals than this are left to ICU.
+static const size_t MAX_FAST_LITERALS = 16;
+
+static bool isAsciiAlphanumeric(UChar ch) {
+    return (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+}
+
+static bool isMetaChar(UChar ch) {
+    switch (ch) {
+    case '$': case '(': case ')': case '*': case '+': case '.': case '?':
+    case '[': case ']': case '^': case '{': case '|': case '}':
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Fills in 'result' if 'regex' (already successfully compiled by ICU) is one of the simple
+ * kinds of FastPattern. Anything we're not sure about is left to ICU.
+ */
+static void parseFastPattern(const UnicodeString& regex, int flags, FastPattern& result) {
+    if ((flags & UREGEX_COMMENTS) != 0) {
+        return;
+    }
+    if (regex == UNICODE_STRING_SIMPLE("\\s")) {
+        result.kind = FastPattern::WHITESPACE;
+        return;
+    }
+    if (regex == UNICODE_STRING_SIMPLE("\\s+")) {
+        result.kind = FastPattern::WHITESPACE_RUN;
+        return;
+    }
+
+    bool caseInsensitive = (flags & UREGEX_CASE_INSENSITIVE) != 0;
+    std::vector<std::vector<jchar> > literals;
+    std::vector<jchar> literal;
+    bool quoted = false;
+    for (int32_t i = 0, length = regex.length(); i < length; ++i) {
+        UChar ch = regex.charAt(i);
+        if (quoted) {
+            if (ch == '\\' && i + 1 < length && regex.charAt(i + 1) == 'E') {
+                quoted = false;
+                ++i;
+                continue;
+            }
+        } else if (ch == '\\') {
+            if (++i == length) {
+                return;
+            }
+            ch = regex.charAt(i);
+            if (ch == 'Q') {
+                quoted = true;
+                continue;
+            } else if (ch == 't') {
+                ch = '\t';
+            } else if (ch == 'n') {
+                ch = '\n';
+            } else if (ch == 'r') {
+                ch = '\r';
+            } else if (ch == 'f') {
+                ch = '\f';
+            } else if (ch >= 0x80 || isAsciiAlphanumeric(ch)) {
+                return;
+            }
+        } else if (ch == '|') {
+            if (literal.empty() || literals.size() == MAX_FAST_LITERALS) {
+                return;
+            }
+            literals.push_back(literal);
+            literal.clear();
+            continue;
+        } else if (isMetaChar(ch)) {
+            return;
+        }
+
+        // Matching code units is only the same as matching code points without surrogates,
+        // and only the same as matching case-insensitively for chars without case.
+        if (U16_IS_SURROGATE(ch) || (caseInsensitive && (ch >= 0x80 || isAsciiAlphanumeric(ch)))) {
+            return;
+        }
+        literal.push_back(ch);
+    }
+    if (literal.empty() || literals.size() == MAX_FAST_LITERALS) {
+        return;
+    }
+    literals.push_back(literal);
+
+    result.kind = FastPattern::LITERALS;
+    result.literals.swap(literals);
+    for (size_t i = 0; i < result.literals.size(); ++i) {
+        jchar first = result.literals[i][0];
+        if (std::find(result.firstChars.begin(), result.firstChars.end(), first) == result.firstChars.end()) {
+            result.firstChars.push_back(first);
+        }
+    }
+}
+
+typedef std::pair<UnicodeString, int> PatternKey;
+typedef std::list<std::pair<PatternKey, CompiledPattern*> > PatternLru;
+
+// The cache holds a reference to each of its entries. The most recently used entry is first.
+static pthread_mutex_t gPatternCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static PatternLru gPatternLru;
+static std::map<PatternKey, PatternLru::iterator> gPatternCache;
+static int64_t gPatternCacheHits = 0;
+static int64_t gPatternCacheMisses = 0;
+static int64_t gPatternCacheEvictions = 0;
+
+// Returns a new reference to the cached pattern for 'key', or NULL.
+static CompiledPattern* findCachedPattern(const PatternKey& key) {
+    ScopedPthreadMutexLock lock(&gPatternCacheMutex);
+    std::map<PatternKey, PatternLru::iterator>::iterator it = gPatternCache.find(key);
+    if (it == gPatternCache.end()) {
+        ++gPatternCacheMisses;
+        return NULL;
+    }
+    ++gPatternCacheHits;
+    gPatternLru.splice(gPatternLru.begin(), gPatternLru, it->second);
+    CompiledPattern* result = it->second->second;
+    result->retain();
+    return result;
+}
+
+// Adds 'pattern' to the cache, unless another thread beat us to it, and returns a new reference
+// to whichever entry is now cached. Consumes the caller's reference to 'pattern'.
+static CompiledPattern* addCachedPattern(const PatternKey& key, CompiledPattern* pattern) {
+    CompiledPattern* result = NULL;
+    CompiledPattern* evicted = NULL;
+    {
+        ScopedPthreadMutexLock lock(&gPatternCacheMutex);
+        std::map<PatternKey, PatternLru::iterator>::iterator it = gPatternCache.find(key);
+        if (it != gPatternCache.end()) {
+            result = it->second->second;
+            result->retain();
+        } else {
+            if (gPatternLru.size() >= MAX_CACHED_PATTERNS) {
+                evicted = gPatternLru.back().second;
+                gPatternCache.erase(gPatternLru.back().first);
+                gPatternLru.pop_back();
+                ++gPatternCacheEvictions;
+            }
+            gPatternLru.push_front(std::make_pair(key, pattern));
+            gPatternCache[key] = gPatternLru.begin();
+            // The cache keeps the caller's reference; the caller gets a new one.
+            pattern->retain();
+        }
+    }
+    // Release outside the lock, since this may delete the pattern.
+    if (evicted != NULL) {
+        evicted->release();
+    }
+    if (result != NULL) {
+        pattern->release();
+        return result;
+    }
+    return pattern;
 }
 
 static const char* regexDetailMessage(UErrorCode status) {
@@ -72,7 +315,7 @@ static void throwPatternSyntaxException(JNIEnv* env, UErrorCode status, jstring
 }
 
 static void Pattern_closeImpl(JNIEnv*, jclass, jlong addr) {
-    delete toRegexPattern(addr);
+    toCompiledPattern(addr)->release();
 }
 
 static jlong Pattern_compileImpl(JNIEnv* env, jclass, jstring javaRegex, jint flags) {
@@ -87,16 +330,44 @@ static jlong Pattern_compileImpl(JNIEnv* env, jclass, jstring javaRegex, jint fl
         return 0;
     }
     UnicodeString& regexString(regex.unicodeString());
-    RegexPattern* result = RegexPattern::compile(regexString, flags, error, status);
-    if (!U_SUCCESS(status)) {
-        throwPatternSyntaxException(env, status, javaRegex, error);
+    PatternKey key(regexString, flags);
+    CompiledPattern* result = findCachedPattern(key);
+    if (result == NULL) {
+        // Compile outside the lock; this can take a while for complicated patterns.
+        RegexPattern* pattern = RegexPattern::compile(regexString, flags, error, status);
+        if (!U_SUCCESS(status)) {
+            delete pattern;
+            throwPatternSyntaxException(env, status, javaRegex, error);
+            return 0;
+        }
+        FastPattern fastPattern;
+        parseFastPattern(regexString, flags, fastPattern);
+        result = addCachedPattern(key, new CompiledPattern(pattern, fastPattern));
     }
     return static_cast<jlong>(reinterpret_cast<uintptr_t>(result));
 }
 
+static jlongArray Pattern_getCacheCountersImpl(JNIEnv* env, jclass) {
+    jlong counters[4];
+    {
+        ScopedPthreadMutexLock lock(&gPatternCacheMutex);
+        counters[0] = gPatternCacheHits;
+        counters[1] = gPatternCacheMisses;
+        counters[2] = gPatternCacheEvictions;
+        counters[3] = gPatternLru.size();
+    }
+    jlongArray result = env->NewLongArray(4);
+    if (result == NULL) {
+        return NULL;
+    }
+    env->SetLongArrayRegion(result, 0, 4, counters);
+    return result;
+}
+
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Pattern, closeImpl, "(J)V"),
     NATIVE_METHOD(Pattern, compileImpl, "(Ljava/lang/String;I)J"),
+    NATIVE_METHOD(Pattern, getCacheCountersImpl, "()[J"),
 };
 void register_java_util_regex_Pattern(JNIEnv* env) {
     jniRegisterNativeMethods(env, "java/util/regex/Pattern", gMethods, NELEM(gMethods));
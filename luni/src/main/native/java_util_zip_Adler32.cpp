@@ -23,22 +23,127 @@
 #include "jni.h"
 #include "zlib.h"
 
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+static const uint32_t ADLER_BASE = 65521;
+
+// zlib's NMAX is 5552, the largest n for which 255n(n+1)/2 + (n+1)(ADLER_BASE-1) still fits in
+// 32 bits: that's the most s2 can reach after n bytes of 0xff, starting from s1 and s2 of at most
+// ADLER_BASE-1. A block is the largest multiple of 16 no larger than that, so the 16-byte chunks
+// never straddle a reduction.
+static const size_t ADLER_BLOCK = 5536;
+
+#if defined(__SSE2__) || defined(__ARM_NEON__) || defined(__aarch64__)
+
+#define HAVE_ADLER_KERNEL
+
+// Sums 16-byte chunks. For each chunk, s2 gains 16 * s1 plus the bytes weighted 16..1, and
+// s1 gains the plain sum. We accumulate the plain sums, the weighted sums, and the running
+// total of s1 before each chunk in vectors, and only reduce at the end of a block.
+static void adlerKernel(uint32_t* s1, uint32_t* s2, const uint8_t* src, size_t byteCount) {
+    while (byteCount > 0) {
+        size_t n = (byteCount < ADLER_BLOCK) ? byteCount : ADLER_BLOCK;
+        uint64_t sum1;
+        uint64_t weightedSum;
+        uint64_t prefixSum;
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i weightsHi = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+        const __m128i weightsLo = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+        __m128i vSum1 = zero;
+        __m128i vWeighted = zero;
+        __m128i vPrefix = zero;
+        for (size_t i = 0; i < n; i += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            vPrefix = _mm_add_epi32(vPrefix, vSum1);
+            vSum1 = _mm_add_epi32(vSum1, _mm_sad_epu8(chunk, zero));
+            vWeighted = _mm_add_epi32(vWeighted, _mm_madd_epi16(_mm_unpacklo_epi8(chunk, zero), weightsHi));
+            vWeighted = _mm_add_epi32(vWeighted, _mm_madd_epi16(_mm_unpackhi_epi8(chunk, zero), weightsLo));
+        }
+        uint32_t lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), vSum1);
+        sum1 = static_cast<uint64_t>(lanes[0]) + lanes[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), vPrefix);
+        prefixSum = static_cast<uint64_t>(lanes[0]) + lanes[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), vWeighted);
+        weightedSum = static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+#else
+        static const uint16_t weights[] = { 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1 };
+        const uint16x8_t weightsHi = vld1q_u16(weights);
+        const uint16x8_t weightsLo = vld1q_u16(weights + 8);
+        uint32x4_t vSum1 = vdupq_n_u32(0);
+        uint32x4_t vWeighted = vdupq_n_u32(0);
+        uint32x4_t vPrefix = vdupq_n_u32(0);
+        for (size_t i = 0; i < n; i += 16) {
+            uint8x16_t chunk = vld1q_u8(src + i);
+            vPrefix = vaddq_u32(vPrefix, vSum1);
+            vSum1 = vpadalq_u16(vSum1, vpaddlq_u8(chunk));
+            uint16x8_t hi = vmovl_u8(vget_low_u8(chunk));
+            uint16x8_t lo = vmovl_u8(vget_high_u8(chunk));
+            vWeighted = vmlal_u16(vWeighted, vget_low_u16(hi), vget_low_u16(weightsHi));
+            vWeighted = vmlal_u16(vWeighted, vget_high_u16(hi), vget_high_u16(weightsHi));
+            vWeighted = vmlal_u16(vWeighted, vget_low_u16(lo), vget_low_u16(weightsLo));
+            vWeighted = vmlal_u16(vWeighted, vget_high_u16(lo), vget_high_u16(weightsLo));
+        }
+        uint32_t lanes[4];
+        vst1q_u32(lanes, vSum1);
+        sum1 = static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+        vst1q_u32(lanes, vPrefix);
+        prefixSum = static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+        vst1q_u32(lanes, vWeighted);
+        weightedSum = static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+#endif
+        *s2 = (*s2 + static_cast<uint64_t>(*s1) * n + 16 * prefixSum + weightedSum) % ADLER_BASE;
+        *s1 = (*s1 + sum1) % ADLER_BASE;
+        src += n;
+        byteCount -= n;
+    }
+}
+
+#endif
+
+// Like zlib's adler32, but sums 16 bytes at a time where the CPU has a vector unit.
+static uLong updateAdler(uLong adler, const Bytef* src, size_t byteCount) {
+#if defined(HAVE_ADLER_KERNEL)
+    size_t kernelByteCount = byteCount & ~static_cast<size_t>(15);
+    if (kernelByteCount > 0) {
+        uint32_t s1 = adler & 0xffff;
+        uint32_t s2 = (adler >> 16) & 0xffff;
+        adlerKernel(&s1, &s2, src, kernelByteCount);
+        adler = (s2 << 16) | s1;
+        src += kernelByteCount;
+        byteCount -= kernelByteCount;
+    }
+#endif
+    return adler32(adler, src, byteCount);
+}
+
 static jlong Adler32_updateImpl(JNIEnv* env, jobject, jbyteArray byteArray, int off, int len, jlong crc) {
     ScopedByteArrayRO bytes(env, byteArray);
     if (bytes.get() == NULL) {
         return 0;
     }
-    return adler32(crc, reinterpret_cast<const Bytef*>(bytes.get() + off), len);
+    return updateAdler(crc, reinterpret_cast<const Bytef*>(bytes.get() + off), len);
+}
+
+static jlong Adler32_updateAddressImpl(JNIEnv*, jclass, jlong address, jint len, jlong adler) {
+    return updateAdler(adler, reinterpret_cast<const Bytef*>(static_cast<uintptr_t>(address)), len);
 }
 
-static jlong Adler32_updateByteImpl(JNIEnv*, jobject, jint val, jlong crc) {
-    Bytef bytefVal = val;
-    return adler32(crc, reinterpret_cast<const Bytef*>(&bytefVal), 1);
+static jlong Adler32_combine(JNIEnv*, jclass, jlong adler1, jlong adler2, jlong len2) {
+    return adler32_combine(adler1, adler2, len2);
 }
 
 static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(Adler32, combine, "(JJJ)J"),
+    NATIVE_METHOD(Adler32, updateAddressImpl, "(JIJ)J"),
     NATIVE_METHOD(Adler32, updateImpl, "([BIIJ)J"),
-    NATIVE_METHOD(Adler32, updateByteImpl, "(IJ)J"),
 };
 void register_java_util_zip_Adler32(JNIEnv* env) {
     jniRegisterNativeMethods(env, "java/util/zip/Adler32", gMethods, NELEM(gMethods));
@@ -23,23 +23,172 @@
 #include "jni.h"
 #include "zlib.h"
 
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#define HAVE_CRC_KERNEL
+
+static bool detectCrcInstructions() {
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) != 0 && (ecx & bit_SSE4_1) != 0;
+}
+
+// Folds 64 bytes at a time with carry-less multiplication, then Barrett-reduces to 32 bits, as
+// described in Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+// Instruction". The constants are for the bit-reflected zlib polynomial. Requires
+// byteCount >= 64 and a multiple of 16, and works on the non-inverted CRC.
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crcKernel(uint32_t crc, const uint8_t* src, size_t byteCount) {
+    static const uint64_t k1k2[] __attribute__((aligned(16))) = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+    static const uint64_t k3k4[] __attribute__((aligned(16))) = { 0x01751997d0ULL, 0x00ccaa009eULL };
+    static const uint64_t k5k0[] __attribute__((aligned(16))) = { 0x0163cd6124ULL, 0x0000000000ULL };
+    static const uint64_t poly[] __attribute__((aligned(16))) = { 0x01db710641ULL, 0x01f7011641ULL };
+
+    __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x00));
+    __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x10));
+    __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x20));
+    __m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+    __m128i k = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+    src += 64;
+    byteCount -= 64;
+
+    // Fold four lanes in parallel.
+    while (byteCount >= 64) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+        __m128i x6 = _mm_clmulepi64_si128(x2, k, 0x00);
+        __m128i x7 = _mm_clmulepi64_si128(x3, k, 0x00);
+        __m128i x8 = _mm_clmulepi64_si128(x4, k, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0x30)));
+        src += 64;
+        byteCount -= 64;
+    }
+
+    // Fold the four lanes into one, then fold in any remaining 16-byte blocks.
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+    __m128i lanes[] = { x2, x3, x4 };
+    for (size_t i = 0; i < 3; ++i) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, lanes[i]), x5);
+    }
+    while (byteCount >= 16) {
+        __m128i x5 = _mm_clmulepi64_si128(x1, k, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(src))), x5);
+        src += 16;
+        byteCount -= 16;
+    }
+
+    // Fold 128 bits down to 64.
+    __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+    x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+    k = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett-reduce to 32.
+    k = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10);
+    x2 = _mm_clmulepi64_si128(_mm_and_si128(x2, mask), k, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return _mm_extract_epi32(x1, 1);
+}
+
+static size_t crcKernelByteCount(size_t byteCount) {
+    return (byteCount >= 64) ? (byteCount & ~static_cast<size_t>(15)) : 0;
+}
+
+#elif defined(__aarch64__)
+
+#define HAVE_CRC_KERNEL
+
+static bool detectCrcInstructions() {
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+
+// ARMv8's CRC32X/CRC32B use the same polynomial as zlib. Requires byteCount to be a multiple
+// of 8, and works on the non-inverted CRC.
+__attribute__((target("+crc")))
+static uint32_t crcKernel(uint32_t crc, const uint8_t* src, size_t byteCount) {
+    for (; byteCount > 0; byteCount -= 8, src += 8) {
+        uint64_t word;
+        memcpy(&word, src, sizeof(word));
+        crc = __crc32d(crc, word);
+    }
+    return crc;
+}
+
+static size_t crcKernelByteCount(size_t byteCount) {
+    return byteCount & ~static_cast<size_t>(7);
+}
+
+#endif
+
+#if defined(HAVE_CRC_KERNEL)
+// Whether this CPU has the instructions crcKernel needs. We only find out at run time, so the
+// kernel is compiled for those instructions regardless of the build's target flags.
+static bool gHaveCrcInstructions = false;
+#endif
+
+// Like zlib's crc32, but uses the CPU's CRC instructions when it has them.
+static uLong updateCrc(uLong crc, const Bytef* src, size_t byteCount) {
+#if defined(HAVE_CRC_KERNEL)
+    size_t kernelByteCount = gHaveCrcInstructions ? crcKernelByteCount(byteCount) : 0;
+    if (kernelByteCount > 0) {
+        crc = ~crcKernel(~static_cast<uint32_t>(crc), src, kernelByteCount) & 0xffffffffUL;
+        src += kernelByteCount;
+        byteCount -= kernelByteCount;
+    }
+#endif
+    return crc32(crc, src, byteCount);
+}
+
 static jlong CRC32_updateImpl(JNIEnv* env, jobject, jbyteArray byteArray, int off, int len, jlong crc) {
     ScopedByteArrayRO bytes(env, byteArray);
     if (bytes.get() == NULL) {
         return 0;
     }
-    jlong result = crc32(crc, reinterpret_cast<const Bytef*>(bytes.get() + off), len);
-    return result;
+    return updateCrc(crc, reinterpret_cast<const Bytef*>(bytes.get() + off), len);
+}
+
+static jlong CRC32_updateAddressImpl(JNIEnv*, jclass, jlong address, jint len, jlong crc) {
+    return updateCrc(crc, reinterpret_cast<const Bytef*>(static_cast<uintptr_t>(address)), len);
 }
 
-static jlong CRC32_updateByteImpl(JNIEnv*, jobject, jbyte val, jlong crc) {
-    return crc32(crc, reinterpret_cast<const Bytef*>(&val), 1);
+static jlong CRC32_combine(JNIEnv*, jclass, jlong crc1, jlong crc2, jlong len2) {
+    return crc32_combine(crc1, crc2, len2);
 }
 
 static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(CRC32, combine, "(JJJ)J"),
+    NATIVE_METHOD(CRC32, updateAddressImpl, "(JIJ)J"),
     NATIVE_METHOD(CRC32, updateImpl, "([BIIJ)J"),
-    NATIVE_METHOD(CRC32, updateByteImpl, "(BJ)J"),
 };
 void register_java_util_zip_CRC32(JNIEnv* env) {
+#if defined(HAVE_CRC_KERNEL)
+    gHaveCrcInstructions = detectCrcInstructions();
+#endif
     jniRegisterNativeMethods(env, "java/util/zip/CRC32", gMethods, NELEM(gMethods));
 }
@@ -19,6 +19,7 @@
 
 #include "JniConstants.h"
 #include "JniException.h"
+#include "NativeCounters.h"
 #include "ScopedPrimitiveArray.h"
 #include "ZipUtilities.h"
 #include "zutil.h" // For DEF_WBITS and DEF_MEM_LEVEL.
@@ -40,11 +41,22 @@ static jint Deflater_getAdlerImpl(JNIEnv*, jobject, jlong handle) {
 }
 
 static jlong Deflater_createStream(JNIEnv * env, jobject, jint level, jint strategy, jboolean noHeader) {
+    ZipStreamKey key;
+    key.inflate = false;
+    key.noHeader = noHeader;
+    key.level = level;
+    key.strategy = strategy;
+    NativeZipStream* idle = takeIdleZipStream(key);
+    if (idle != NULL) {
+        return reinterpret_cast<uintptr_t>(idle);
+    }
+
     UniquePtr<NativeZipStream> jstream(new NativeZipStream);
     if (jstream.get() == NULL) {
         jniThrowOutOfMemoryError(env, NULL);
         return -1;
     }
+    jstream->key = key;
 
     /*
      * See zlib.h for documentation of the deflateInit2 windowBits and memLevel parameters.
@@ -68,19 +80,25 @@ static void Deflater_setInputImpl(JNIEnv* env, jobject, jbyteArray buf, jint off
     toNativeZipStream(handle)->setInput(env, buf, off, len);
 }
 
-static jint Deflater_deflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int off, int len, jlong handle, int flushStyle) {
+static void Deflater_setAddressInputImpl(JNIEnv*, jobject, jlong address, jint len, jlong handle) {
+    // Point zlib straight at the caller's memory rather than copying it.
     NativeZipStream* stream = toNativeZipStream(handle);
-    ScopedByteArrayRW out(env, buf);
-    if (out.get() == NULL) {
-        return -1;
-    }
-    stream->stream.next_out = reinterpret_cast<Bytef*>(out.get() + off);
+    stream->stream.next_in = reinterpret_cast<Bytef*>(static_cast<uintptr_t>(address));
+    stream->stream.avail_in = len;
+}
+
+static jint deflateInto(JNIEnv* env, jobject recv, NativeZipStream* stream, Bytef* dst, jint len, int flushStyle) {
+    stream->stream.next_out = dst;
     stream->stream.avail_out = len;
 
     Bytef* initialNextIn = stream->stream.next_in;
     Bytef* initialNextOut = stream->stream.next_out;
 
-    int err = deflate(&stream->stream, flushStyle);
+    int err;
+    {
+        ScopedNativeTrace trace("deflate");
+        err = deflate(&stream->stream, flushStyle);
+    }
     switch (err) {
     case Z_OK:
         break;
@@ -100,6 +118,8 @@ static jint Deflater_deflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int
 
     jint bytesRead = stream->stream.next_in - initialNextIn;
     jint bytesWritten = stream->stream.next_out - initialNextOut;
+    nativeCounterAdd(COUNTER_DEFLATER_BYTES_IN, bytesRead);
+    nativeCounterAdd(COUNTER_DEFLATER_BYTES_OUT, bytesWritten);
 
     static jfieldID inReadField = env->GetFieldID(JniConstants::deflaterClass, "inRead", "I");
     jint inReadValue = env->GetIntField(recv, inReadField);
@@ -108,10 +128,21 @@ static jint Deflater_deflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int
     return bytesWritten;
 }
 
+static jint Deflater_deflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int off, int len, jlong handle, int flushStyle) {
+    ScopedByteArrayRW out(env, buf);
+    if (out.get() == NULL) {
+        return -1;
+    }
+    return deflateInto(env, recv, toNativeZipStream(handle), reinterpret_cast<Bytef*>(out.get() + off), len, flushStyle);
+}
+
+static jint Deflater_deflateAddressImpl(JNIEnv* env, jobject recv, jlong address, int len, jlong handle, int flushStyle) {
+    Bytef* dst = reinterpret_cast<Bytef*>(static_cast<uintptr_t>(address));
+    return deflateInto(env, recv, toNativeZipStream(handle), dst, len, flushStyle);
+}
+
 static void Deflater_endImpl(JNIEnv*, jobject, jlong handle) {
-    NativeZipStream* stream = toNativeZipStream(handle);
-    deflateEnd(&stream->stream);
-    delete stream;
+    releaseZipStream(toNativeZipStream(handle));
 }
 
 static void Deflater_resetImpl(JNIEnv* env, jobject, jlong handle) {
@@ -138,12 +169,14 @@ static void Deflater_setLevelsImpl(JNIEnv* env, jobject, int level, int strategy
 
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Deflater, createStream, "(IIZ)J"),
+    NATIVE_METHOD(Deflater, deflateAddressImpl, "(JIJI)I"),
     NATIVE_METHOD(Deflater, deflateImpl, "([BIIJI)I"),
     NATIVE_METHOD(Deflater, endImpl, "(J)V"),
     NATIVE_METHOD(Deflater, getAdlerImpl, "(J)I"),
     NATIVE_METHOD(Deflater, getTotalInImpl, "(J)J"),
     NATIVE_METHOD(Deflater, getTotalOutImpl, "(J)J"),
     NATIVE_METHOD(Deflater, resetImpl, "(J)V"),
+    NATIVE_METHOD(Deflater, setAddressInputImpl, "(JIJ)V"),
     NATIVE_METHOD(Deflater, setDictionaryImpl, "([BIIJ)V"),
     NATIVE_METHOD(Deflater, setInputImpl, "([BIIJ)V"),
     NATIVE_METHOD(Deflater, setLevelsImpl, "(IIJ)V"),
@@ -19,17 +19,30 @@
 
 #include "JniConstants.h"
 #include "JniException.h"
+#include "NativeCounters.h"
 #include "ScopedPrimitiveArray.h"
 #include "ZipUtilities.h"
 #include "zutil.h" // For DEF_WBITS and DEF_MEM_LEVEL.
 #include <errno.h>
+#include <unistd.h>
 
 static jlong Inflater_createStream(JNIEnv* env, jobject, jboolean noHeader) {
+    ZipStreamKey key;
+    key.inflate = true;
+    key.noHeader = noHeader;
+    key.level = 0;
+    key.strategy = 0;
+    NativeZipStream* idle = takeIdleZipStream(key);
+    if (idle != NULL) {
+        return reinterpret_cast<uintptr_t>(idle);
+    }
+
     UniquePtr<NativeZipStream> jstream(new NativeZipStream);
     if (jstream.get() == NULL) {
         jniThrowOutOfMemoryError(env, NULL);
         return -1;
     }
+    jstream->key = key;
     jstream->stream.adler = 1;
 
     /*
@@ -56,7 +69,6 @@ static jint Inflater_setFileInputImpl(JNIEnv* env, jobject, jobject javaFileDesc
     NativeZipStream* stream = toNativeZipStream(handle);
 
     // We reuse the existing native buffer if it's large enough.
-    // TODO: benchmark.
     if (stream->inCap < len) {
         stream->setInput(env, NULL, 0, len);
     } else {
@@ -66,19 +78,15 @@ static jint Inflater_setFileInputImpl(JNIEnv* env, jobject, jobject javaFileDesc
 
     // As an Android-specific optimization, we read directly onto the native heap.
     // The original code used Java to read onto the Java heap and then called setInput(byte[]).
-    // TODO: benchmark.
+    // We use pread(2) so the file position (which the file's other users share) is left alone.
     int fd = jniGetFDFromFileDescriptor(env, javaFileDescriptor);
-    int rc = TEMP_FAILURE_RETRY(lseek(fd, off, SEEK_SET));
-    if (rc == -1) {
-        jniThrowIOException(env, errno);
-        return 0;
-    }
     jint totalByteCount = 0;
     Bytef* dst = reinterpret_cast<Bytef*>(&stream->input[0]);
-    ssize_t byteCount;
-    while ((byteCount = TEMP_FAILURE_RETRY(read(fd, dst, len))) > 0) {
+    ssize_t byteCount = 0;
+    while (len > 0 && (byteCount = TEMP_FAILURE_RETRY(pread64(fd, dst, len, off))) > 0) {
         dst += byteCount;
         len -= byteCount;
+        off += byteCount;
         totalByteCount += byteCount;
     }
     if (byteCount == -1) {
@@ -88,19 +96,26 @@ static jint Inflater_setFileInputImpl(JNIEnv* env, jobject, jobject javaFileDesc
     return totalByteCount;
 }
 
-static jint Inflater_inflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int off, int len, jlong handle) {
+static void Inflater_setAddressInputImpl(JNIEnv*, jobject, jlong address, jint len, jlong handle) {
+    // Point zlib straight at the caller's memory (an mmap(2)ed archive or a direct buffer, say).
+    // Our own buffer stays allocated for the next setFileInputImpl.
     NativeZipStream* stream = toNativeZipStream(handle);
-    ScopedByteArrayRW out(env, buf);
-    if (out.get() == NULL) {
-        return -1;
-    }
-    stream->stream.next_out = reinterpret_cast<Bytef*>(out.get() + off);
+    stream->stream.next_in = reinterpret_cast<Bytef*>(static_cast<uintptr_t>(address));
+    stream->stream.avail_in = len;
+}
+
+static jint inflateInto(JNIEnv* env, jobject recv, NativeZipStream* stream, Bytef* dst, jint len) {
+    stream->stream.next_out = dst;
     stream->stream.avail_out = len;
 
     Bytef* initialNextIn = stream->stream.next_in;
     Bytef* initialNextOut = stream->stream.next_out;
 
-    int err = inflate(&stream->stream, Z_SYNC_FLUSH);
+    int err;
+    {
+        ScopedNativeTrace trace("inflate");
+        err = inflate(&stream->stream, Z_SYNC_FLUSH);
+    }
     switch (err) {
     case Z_OK:
         break;
@@ -121,6 +136,8 @@ static jint Inflater_inflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int
 
     jint bytesRead = stream->stream.next_in - initialNextIn;
     jint bytesWritten = stream->stream.next_out - initialNextOut;
+    nativeCounterAdd(COUNTER_INFLATER_BYTES_IN, bytesRead);
+    nativeCounterAdd(COUNTER_INFLATER_BYTES_OUT, bytesWritten);
 
     static jfieldID inReadField = env->GetFieldID(JniConstants::inflaterClass, "inRead", "I");
     jint inReadValue = env->GetIntField(recv, inReadField);
@@ -129,14 +146,25 @@ static jint Inflater_inflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int
     return bytesWritten;
 }
 
+static jint Inflater_inflateImpl(JNIEnv* env, jobject recv, jbyteArray buf, int off, int len, jlong handle) {
+    ScopedByteArrayRW out(env, buf);
+    if (out.get() == NULL) {
+        return -1;
+    }
+    return inflateInto(env, recv, toNativeZipStream(handle), reinterpret_cast<Bytef*>(out.get() + off), len);
+}
+
+static jint Inflater_inflateAddressImpl(JNIEnv* env, jobject recv, jlong address, int len, jlong handle) {
+    Bytef* dst = reinterpret_cast<Bytef*>(static_cast<uintptr_t>(address));
+    return inflateInto(env, recv, toNativeZipStream(handle), dst, len);
+}
+
 static jint Inflater_getAdlerImpl(JNIEnv*, jobject, jlong handle) {
     return toNativeZipStream(handle)->stream.adler;
 }
 
 static void Inflater_endImpl(JNIEnv*, jobject, jlong handle) {
-    NativeZipStream* stream = toNativeZipStream(handle);
-    inflateEnd(&stream->stream);
-    delete stream;
+    releaseZipStream(toNativeZipStream(handle));
 }
 
 static void Inflater_setDictionaryImpl(JNIEnv* env, jobject, jbyteArray dict, int off, int len, jlong handle) {
@@ -165,8 +193,10 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Inflater, getAdlerImpl, "(J)I"),
     NATIVE_METHOD(Inflater, getTotalInImpl, "(J)J"),
     NATIVE_METHOD(Inflater, getTotalOutImpl, "(J)J"),
+    NATIVE_METHOD(Inflater, inflateAddressImpl, "(JIJ)I"),
     NATIVE_METHOD(Inflater, inflateImpl, "([BIIJ)I"),
     NATIVE_METHOD(Inflater, resetImpl, "(J)V"),
+    NATIVE_METHOD(Inflater, setAddressInputImpl, "(JIJ)V"),
     NATIVE_METHOD(Inflater, setDictionaryImpl, "([BIIJ)V"),
     NATIVE_METHOD(Inflater, setFileInputImpl, "(Ljava/io/FileDescriptor;JIJ)I"),
     NATIVE_METHOD(Inflater, setInputImpl, "([BIIJ)V"),
@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "ParallelDeflater"
+
+#include "JNIHelp.h"
+#include "JniConstants.h"
+#include "JniException.h"
+#include "ScopedPrimitiveArray.h"
+#include "UniquePtr.h"
+#include "ZipUtilities.h"
+#include "zutil.h" // For DEF_MEM_LEVEL.
+
+#include <algorithm>
+#include <vector>
+
+#include <pthread.h>
+#include <unistd.h>
+
+// Compresses input in independent blocks on several threads, pigz-style. Each block is
+// deflated by its own z_stream, primed with the 32KiB of input preceding it so the
+// compression ratio barely suffers, and ended with a sync flush so that the raw deflate
+// outputs can simply be concatenated. We write the zlib or gzip header and trailer ourselves,
+// combining the blocks' checksums with adler32_combine or crc32_combine.
+static const size_t BLOCK_SIZE = 128 * 1024;
+static const size_t WINDOW_SIZE = 32 * 1024;
+
+struct DeflateBlock {
+    const Bytef* input;
+    size_t length;
+    const Bytef* dictionary;
+    size_t dictionaryLength;
+    bool last;
+    std::vector<Bytef> output;
+    uLong checksum;
+    int error;
+};
+
+class ParallelDeflateStream {
+public:
+    ParallelDeflateStream(int level, bool gzip, int threadCount)
+            : level(level), gzip(gzip), threadCount(threadCount), headerWritten(false),
+              finished(false), totalIn(0), totalOut(0) {
+        checksum = gzip ? crc32(0L, Z_NULL, 0) : adler32(0L, Z_NULL, 0);
+    }
+
+    ~ParallelDeflateStream() {
+        for (size_t i = 0; i < workers.size(); ++i) {
+            deflateEnd(&workers[i]->stream);
+            delete workers[i];
+        }
+    }
+
+    // Creates the per-thread z_streams, returning a zlib error code.
+    int init() {
+        for (int i = 0; i < threadCount; ++i) {
+            UniquePtr<NativeZipStream> worker(new NativeZipStream);
+            int err = deflateInit2(&worker->stream, level, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL,
+                    Z_DEFAULT_STRATEGY);
+            if (err != Z_OK) {
+                return err;
+            }
+            workers.push_back(worker.release());
+        }
+        return Z_OK;
+    }
+
+    // Compresses 'length' bytes of 'input', appending the compressed bytes to 'out'. If 'last'
+    // is true, the stream is ended, and 'input' may be empty. Returns a zlib error code.
+    int deflateBlocks(const Bytef* input, size_t length, bool last, std::vector<Bytef>& out) {
+        size_t initialOutSize = out.size();
+        if (!headerWritten) {
+            writeHeader(out);
+            headerWritten = true;
+        }
+
+        size_t blockCount = (length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        if (blockCount == 0 && last) {
+            blockCount = 1;
+        }
+        std::vector<DeflateBlock> blocks(blockCount);
+        for (size_t i = 0; i < blockCount; ++i) {
+            DeflateBlock& block = blocks[i];
+            block.input = input + i * BLOCK_SIZE;
+            block.length = std::min(BLOCK_SIZE, length - i * BLOCK_SIZE);
+            if (i == 0) {
+                block.dictionary = window.empty() ? NULL : &window[0];
+                block.dictionaryLength = window.size();
+            } else {
+                block.dictionaryLength = std::min(WINDOW_SIZE, i * BLOCK_SIZE);
+                block.dictionary = block.input - block.dictionaryLength;
+            }
+            block.last = last && (i == blockCount - 1);
+            block.error = Z_OK;
+        }
+
+        runWorkers(blocks);
+
+        for (size_t i = 0; i < blockCount; ++i) {
+            const DeflateBlock& block = blocks[i];
+            if (block.error != Z_OK) {
+                return block.error;
+            }
+            out.insert(out.end(), block.output.begin(), block.output.end());
+            checksum = gzip ? crc32_combine(checksum, block.checksum, block.length)
+                            : adler32_combine(checksum, block.checksum, block.length);
+        }
+        totalIn += length;
+        rememberWindow(input, length);
+
+        if (last) {
+            writeTrailer(out);
+            finished = true;
+        }
+        totalOut += out.size() - initialOutSize;
+        return Z_OK;
+    }
+
+    const int level;
+    const bool gzip;
+    const int threadCount;
+    bool headerWritten;
+    bool finished;
+    uLong checksum;
+    jlong totalIn;
+    jlong totalOut;
+
+private:
+    struct WorkQueue {
+        ParallelDeflateStream* stream;
+        std::vector<DeflateBlock>* blocks;
+        size_t next;
+        pthread_mutex_t mutex;
+    };
+
+    struct WorkerArgs {
+        WorkQueue* queue;
+        NativeZipStream* worker;
+    };
+
+    void runWorkers(std::vector<DeflateBlock>& blocks) {
+        if (blocks.empty()) {
+            return;
+        }
+        WorkQueue queue;
+        queue.stream = this;
+        queue.blocks = &blocks;
+        queue.next = 0;
+        pthread_mutex_init(&queue.mutex, NULL);
+
+        // Threads only live for one call. The calling thread does its share of the blocks too,
+        // so we only start threads for the rest.
+        size_t workerCount = std::min(blocks.size(), workers.size());
+        std::vector<WorkerArgs> args(workerCount);
+        std::vector<pthread_t> threads;
+        for (size_t i = 0; i < workerCount; ++i) {
+            args[i].queue = &queue;
+            args[i].worker = workers[i];
+            if (i > 0) {
+                pthread_t thread;
+                if (pthread_create(&thread, NULL, workerMain, &args[i]) == 0) {
+                    threads.push_back(thread);
+                }
+            }
+        }
+        workerMain(&args[0]);
+        for (size_t i = 0; i < threads.size(); ++i) {
+            pthread_join(threads[i], NULL);
+        }
+        pthread_mutex_destroy(&queue.mutex);
+    }
+
+    static void* workerMain(void* rawArgs) {
+        WorkerArgs* args = reinterpret_cast<WorkerArgs*>(rawArgs);
+        WorkQueue* queue = args->queue;
+        while (true) {
+            pthread_mutex_lock(&queue->mutex);
+            size_t index = queue->next++;
+            pthread_mutex_unlock(&queue->mutex);
+            if (index >= queue->blocks->size()) {
+                return NULL;
+            }
+            queue->stream->deflateBlock(args->worker, (*queue->blocks)[index]);
+        }
+    }
+
+    void deflateBlock(NativeZipStream* worker, DeflateBlock& block) {
+        z_stream* stream = &worker->stream;
+        block.checksum = gzip ? crc32(0L, Z_NULL, 0) : adler32(0L, Z_NULL, 0);
+        block.checksum = gzip ? crc32(block.checksum, block.input, block.length)
+                              : adler32(block.checksum, block.input, block.length);
+
+        block.error = deflateReset(stream);
+        if (block.error == Z_OK && block.dictionaryLength > 0) {
+            block.error = deflateSetDictionary(stream, block.dictionary, block.dictionaryLength);
+        }
+        if (block.error != Z_OK) {
+            return;
+        }
+
+        int flush = block.last ? Z_FINISH : Z_SYNC_FLUSH;
+        stream->next_in = const_cast<Bytef*>(block.input);
+        stream->avail_in = block.length;
+        block.output.resize(deflateBound(stream, block.length) + 16);
+        size_t outLength = 0;
+        while (true) {
+            stream->next_out = &block.output[outLength];
+            stream->avail_out = block.output.size() - outLength;
+            int err = deflate(stream, flush);
+            outLength = block.output.size() - stream->avail_out;
+            if (err == Z_STREAM_END || (!block.last && err == Z_OK && stream->avail_out != 0)) {
+                break;
+            }
+            if (err != Z_OK && err != Z_BUF_ERROR) {
+                block.error = err;
+                return;
+            }
+            // Out of room (deflateBound doesn't allow for the sync flush); make more.
+            block.output.resize(block.output.size() * 2);
+        }
+        block.output.resize(outLength);
+    }
+
+    void writeHeader(std::vector<Bytef>& out) {
+        if (gzip) {
+            // No file name, no modification time, and an OS of "unknown".
+            const Bytef xfl = (level == Z_BEST_COMPRESSION) ? 2 : (level == Z_BEST_SPEED) ? 4 : 0;
+            const Bytef header[] = { 0x1f, 0x8b, Z_DEFLATED, 0, 0, 0, 0, 0, xfl, 0xff };
+            out.insert(out.end(), header, header + sizeof(header));
+        } else {
+            // See RFC 1950: a 32KiB window, and a compression level hint.
+            int levelFlags;
+            if (level == Z_DEFAULT_COMPRESSION || level == 6) {
+                levelFlags = 2;
+            } else if (level < 2) {
+                levelFlags = 0;
+            } else if (level < 6) {
+                levelFlags = 1;
+            } else {
+                levelFlags = 3;
+            }
+            int header = (0x78 << 8) | (levelFlags << 6);
+            header += 31 - (header % 31);
+            out.push_back(header >> 8);
+            out.push_back(header & 0xff);
+        }
+    }
+
+    void writeTrailer(std::vector<Bytef>& out) {
+        if (gzip) {
+            // The CRC and the input size modulo 2^32, both little-endian.
+            for (int i = 0; i < 4; ++i) {
+                out.push_back((checksum >> (8 * i)) & 0xff);
+            }
+            for (int i = 0; i < 4; ++i) {
+                out.push_back((totalIn >> (8 * i)) & 0xff);
+            }
+        } else {
+            // The Adler-32, big-endian.
+            for (int i = 3; i >= 0; --i) {
+                out.push_back((checksum >> (8 * i)) & 0xff);
+            }
+        }
+    }
+
+    // Keeps the last WINDOW_SIZE bytes of input to prime the next call's first block.
+    void rememberWindow(const Bytef* input, size_t length) {
+        if (length >= WINDOW_SIZE) {
+            window.assign(input + length - WINDOW_SIZE, input + length);
+        } else {
+            window.insert(window.end(), input, input + length);
+            if (window.size() > WINDOW_SIZE) {
+                window.erase(window.begin(), window.end() - WINDOW_SIZE);
+            }
+        }
+    }
+
+    std::vector<NativeZipStream*> workers;
+    std::vector<Bytef> window;
+
+    // Disallow copy and assignment.
+    ParallelDeflateStream(const ParallelDeflateStream&);
+    void operator=(const ParallelDeflateStream&);
+};
+
+static ParallelDeflateStream* toParallelDeflateStream(jlong address) {
+    return reinterpret_cast<ParallelDeflateStream*>(static_cast<uintptr_t>(address));
+}
+
+static jlong ParallelDeflater_createStream(JNIEnv* env, jclass, jint level, jboolean gzip, jint threadCount) {
+    // Each thread owns a zlib stream of a few hundred KiB, so never make more than can run at once.
+    long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+    threadCount = std::max(1, std::min<jint>(threadCount, std::max(cpuCount, 1L)));
+    UniquePtr<ParallelDeflateStream> stream(new ParallelDeflateStream(level, gzip, threadCount));
+    if (stream.get() == NULL) {
+        jniThrowOutOfMemoryError(env, NULL);
+        return -1;
+    }
+    int err = stream->init();
+    if (err != Z_OK) {
+        throwExceptionForZlibError(env, "java/lang/IllegalArgumentException", err, NULL);
+        return -1;
+    }
+    return reinterpret_cast<uintptr_t>(stream.release());
+}
+
+static jbyteArray ParallelDeflater_deflateImpl(JNIEnv* env, jclass, jbyteArray buf, jint off, jint len, jboolean last, jlong handle) {
+    ParallelDeflateStream* stream = toParallelDeflateStream(handle);
+    std::vector<Bytef> out;
+    int err;
+    {
+        ScopedByteArrayRO in(env, buf);
+        if (in.get() == NULL) {
+            return NULL;
+        }
+        err = stream->deflateBlocks(reinterpret_cast<const Bytef*>(in.get() + off), len, last, out);
+    }
+    if (err != Z_OK) {
+        throwExceptionForZlibError(env, "java/lang/IllegalStateException", err, NULL);
+        return NULL;
+    }
+    jbyteArray result = env->NewByteArray(out.size());
+    if (result != NULL && !out.empty()) {
+        env->SetByteArrayRegion(result, 0, out.size(), reinterpret_cast<const jbyte*>(&out[0]));
+    }
+    return result;
+}
+
+static void ParallelDeflater_endImpl(JNIEnv*, jclass, jlong handle) {
+    delete toParallelDeflateStream(handle);
+}
+
+static jint ParallelDeflater_getChecksumImpl(JNIEnv*, jclass, jlong handle) {
+    return toParallelDeflateStream(handle)->checksum;
+}
+
+static jlong ParallelDeflater_getTotalInImpl(JNIEnv*, jclass, jlong handle) {
+    return toParallelDeflateStream(handle)->totalIn;
+}
+
+static jlong ParallelDeflater_getTotalOutImpl(JNIEnv*, jclass, jlong handle) {
+    return toParallelDeflateStream(handle)->totalOut;
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(ParallelDeflater, createStream, "(IZI)J"),
+    NATIVE_METHOD(ParallelDeflater, deflateImpl, "([BIIZJ)[B"),
+    NATIVE_METHOD(ParallelDeflater, endImpl, "(J)V"),
+    NATIVE_METHOD(ParallelDeflater, getChecksumImpl, "(J)I"),
+    NATIVE_METHOD(ParallelDeflater, getTotalInImpl, "(J)J"),
+    NATIVE_METHOD(ParallelDeflater, getTotalOutImpl, "(J)J"),
+};
+void register_java_util_zip_ParallelDeflater(JNIEnv* env) {
+    jniRegisterNativeMethods(env, "java/util/zip/ParallelDeflater", gMethods, NELEM(gMethods));
+}
@@ -21,9 +21,13 @@
 #include "JniConstants.h"
 #include "JniException.h"
 #include "ScopedJavaUnicodeString.h"
+#include "ScopedLocalRef.h"
+#include "ScopedStringChars.h"
 #include "unicode/alphaindex.h"
 #include "unicode/uniset.h"
 
+#include <vector>
+
 static AlphabeticIndex* fromPeer(jlong peer) {
   return reinterpret_cast<AlphabeticIndex*>(static_cast<uintptr_t>(peer));
 }
@@ -92,6 +96,45 @@ static jint AlphabeticIndex_getBucketIndex(JNIEnv* env, jclass, jlong peer, jstr
   return result;
 }
 
+// Finds the bucket of each string in 'javaStrings' with one JNI call. 'T' is AlphabeticIndex or
+// AlphabeticIndex::ImmutableIndex, which have the same getBucketIndex. A null element gets -1.
+template <typename T>
+static jintArray getBucketIndices(JNIEnv* env, T* index, jobjectArray javaStrings, const char* function) {
+  if (javaStrings == NULL) {
+    jniThrowNullPointerException(env, NULL);
+    return NULL;
+  }
+  jsize count = env->GetArrayLength(javaStrings);
+  std::vector<jint> result(count, -1);
+  UnicodeString s;
+  for (jsize i = 0; i < count; ++i) {
+    ScopedLocalRef<jstring> javaString(env, reinterpret_cast<jstring>(env->GetObjectArrayElement(javaStrings, i)));
+    if (javaString.get() == NULL) {
+      continue;
+    }
+    ScopedStringChars chars(env, javaString.get());
+    if (chars.get() == NULL) {
+      return NULL;
+    }
+    // A read-only alias of the Java chars, rather than a copy.
+    s.setTo(false, chars.get(), chars.size());
+    UErrorCode status = U_ZERO_ERROR;
+    result[i] = index->getBucketIndex(s, status);
+    if (maybeThrowIcuException(env, function, status)) {
+      return NULL;
+    }
+  }
+  jintArray javaResult = env->NewIntArray(count);
+  if (javaResult != NULL && count > 0) {
+    env->SetIntArrayRegion(javaResult, 0, count, &result[0]);
+  }
+  return javaResult;
+}
+
+static jintArray AlphabeticIndex_getBucketIndices(JNIEnv* env, jclass, jlong peer, jobjectArray javaStrings) {
+  return getBucketIndices(env, fromPeer(peer), javaStrings, "AlphabeticIndex::getBucketIndex");
+}
+
 static jstring AlphabeticIndex_getBucketLabel(JNIEnv* env, jclass, jlong peer, jint index) {
   if (index < 0) {
     jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException", "Invalid index: %d", index);
@@ -138,6 +181,10 @@ static AlphabeticIndex::ImmutableIndex* immutableIndexFromPeer(jlong peer) {
   return reinterpret_cast<AlphabeticIndex::ImmutableIndex*>(static_cast<uintptr_t>(peer));
 }
 
+static void ImmutableIndex_destroy(JNIEnv*, jclass, jlong peer) {
+  delete immutableIndexFromPeer(peer);
+}
+
 static jint ImmutableIndex_getBucketCount(JNIEnv*, jclass, jlong peer) {
   AlphabeticIndex::ImmutableIndex* ii = immutableIndexFromPeer(peer);
   return ii->getBucketCount();
@@ -157,6 +204,11 @@ static jint ImmutableIndex_getBucketIndex(JNIEnv* env, jclass, jlong peer, jstri
   return result;
 }
 
+static jintArray ImmutableIndex_getBucketIndices(JNIEnv* env, jclass, jlong peer, jobjectArray javaStrings) {
+  return getBucketIndices(env, immutableIndexFromPeer(peer), javaStrings,
+                          "AlphabeticIndex::ImmutableIndex::getBucketIndex");
+}
+
 static jstring ImmutableIndex_getBucketLabel(JNIEnv* env, jclass, jlong peer, jint index) {
   AlphabeticIndex::ImmutableIndex* ii = immutableIndexFromPeer(peer);
   const AlphabeticIndex::Bucket* bucket = ii->getBucket(index);
@@ -183,12 +235,15 @@ static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(AlphabeticIndex, addLabelRange, "(JII)V"),
   NATIVE_METHOD(AlphabeticIndex, getBucketCount, "(J)I"),
   NATIVE_METHOD(AlphabeticIndex, getBucketIndex, "(JLjava/lang/String;)I"),
+  NATIVE_METHOD(AlphabeticIndex, getBucketIndices, "(J[Ljava/lang/String;)[I"),
   NATIVE_METHOD(AlphabeticIndex, getBucketLabel, "(JI)Ljava/lang/String;"),
   NATIVE_METHOD(AlphabeticIndex, buildImmutableIndex, "(J)J"),
 };
 static JNINativeMethod gImmutableIndexMethods[] = {
+  NATIVE_METHOD(ImmutableIndex, destroy, "(J)V"),
   NATIVE_METHOD(ImmutableIndex, getBucketCount, "(J)I"),
   NATIVE_METHOD(ImmutableIndex, getBucketIndex, "(JLjava/lang/String;)I"),
+  NATIVE_METHOD(ImmutableIndex, getBucketIndices, "(J[Ljava/lang/String;)[I"),
   NATIVE_METHOD(ImmutableIndex, getBucketLabel, "(JI)Ljava/lang/String;"),
 };
 void register_libcore_icu_AlphabeticIndex(JNIEnv* env) {
@@ -19,6 +19,7 @@
 #include "IcuUtilities.h"
 #include "JniConstants.h"
 #include "ScopedJavaUnicodeString.h"
+#include "StartupProfile.h"
 #include "UniquePtr.h"
 #include "cutils/log.h"
 #include "unicode/dtitvfmt.h"
@@ -32,6 +33,7 @@ static jlong DateIntervalFormat_createDateIntervalFormat(JNIEnv* env, jclass, js
   }
 
   UErrorCode status = U_ZERO_ERROR;
+  ScopedStartupEvent event("DateIntervalFormat::createInstance");
   DateIntervalFormat* formatter(DateIntervalFormat::createInstance(skeletonHolder.unicodeString(), locale, status));
   if (maybeThrowIcuException(env, "DateIntervalFormat::createInstance", status)) {
     return 0;
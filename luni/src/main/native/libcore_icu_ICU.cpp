@@ -23,7 +23,10 @@
 #include "ScopedFd.h"
 #include "ScopedJavaUnicodeString.h"
 #include "ScopedLocalRef.h"
+#include "ScopedPthreadMutexLock.h"
+#include "ScopedStringChars.h"
 #include "ScopedUtfChars.h"
+#include "StartupProfile.h"
 #include "UniquePtr.h"
 #include "cutils/log.h"
 #include "toStringArray.h"
@@ -51,6 +54,9 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <list>
+#include <map>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <string>
@@ -60,6 +66,7 @@
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
+#include <vector>
 
 // TODO: put this in a header file and use it everywhere!
 // DISALLOW_COPY_AND_ASSIGN disallows the copy and operator= functions.
@@ -94,7 +101,7 @@ class ScopedResourceBundle {
   DISALLOW_COPY_AND_ASSIGN(ScopedResourceBundle);
 };
 
-static jstring ICU_addLikelySubtags(JNIEnv* env, jclass, jstring javaLocale) {
+static jstring ICU_addLikelySubtagsNative(JNIEnv* env, jclass, jstring javaLocale) {
     UErrorCode status = U_ZERO_ERROR;
     ScopedUtfChars localeID(env, javaLocale);
     char maximizedLocaleID[ULOC_FULLNAME_CAPACITY];
@@ -105,7 +112,7 @@ static jstring ICU_addLikelySubtags(JNIEnv* env, jclass, jstring javaLocale) {
     return env->NewStringUTF(maximizedLocaleID);
 }
 
-static jstring ICU_getScript(JNIEnv* env, jclass, jstring javaLocale) {
+static jstring ICU_getScriptNative(JNIEnv* env, jclass, jstring javaLocale) {
     UErrorCode status = U_ZERO_ERROR;
     ScopedUtfChars localeID(env, javaLocale);
     char script[ULOC_SCRIPT_CAPACITY];
@@ -116,7 +123,7 @@ static jstring ICU_getScript(JNIEnv* env, jclass, jstring javaLocale) {
     return env->NewStringUTF(script);
 }
 
-static jint ICU_getCurrencyFractionDigits(JNIEnv* env, jclass, jstring javaCurrencyCode) {
+static jint ICU_getCurrencyFractionDigitsNative(JNIEnv* env, jclass, jstring javaCurrencyCode) {
   ScopedJavaUnicodeString currencyCode(env, javaCurrencyCode);
   if (!currencyCode.valid()) {
     return 0;
@@ -127,7 +134,7 @@ static jint ICU_getCurrencyFractionDigits(JNIEnv* env, jclass, jstring javaCurre
 }
 
 // TODO: rewrite this with int32_t ucurr_forLocale(const char* locale, UChar* buff, int32_t buffCapacity, UErrorCode* ec)...
-static jstring ICU_getCurrencyCode(JNIEnv* env, jclass, jstring javaCountryCode) {
+static jstring ICU_getCurrencyCodeNative(JNIEnv* env, jclass, jstring javaCountryCode) {
     UErrorCode status = U_ZERO_ERROR;
     ScopedResourceBundle supplData(ures_openDirect(U_ICUDATA_CURR, "supplementalData", &status));
     if (U_FAILURE(status)) {
@@ -275,20 +282,35 @@ static jobjectArray ICU_getAvailableNumberFormatLocalesNative(JNIEnv* env, jclas
     return toStringArray(env, unum_countAvailable, unum_getAvailable);
 }
 
+// initLocaleDataNative sets a few dozen LocaleData fields for every locale, so we look each
+// one up by name only once. Field names are always string literals, so the map is keyed by
+// their addresses; at worst a name has two entries.
+static pthread_mutex_t gLocaleDataFieldsMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<const char*, jfieldID> gLocaleDataFields;
+
+static jfieldID localeDataField(JNIEnv* env, const char* fieldName, const char* signature) {
+    ScopedPthreadMutexLock lock(&gLocaleDataFieldsMutex);
+    jfieldID& fid = gLocaleDataFields[fieldName];
+    if (fid == NULL) {
+        fid = env->GetFieldID(JniConstants::localeDataClass, fieldName, signature);
+    }
+    return fid;
+}
+
 static void setIntegerField(JNIEnv* env, jobject obj, const char* fieldName, int value) {
     ScopedLocalRef<jobject> integerValue(env, integerValueOf(env, value));
-    jfieldID fid = env->GetFieldID(JniConstants::localeDataClass, fieldName, "Ljava/lang/Integer;");
+    jfieldID fid = localeDataField(env, fieldName, "Ljava/lang/Integer;");
     env->SetObjectField(obj, fid, integerValue.get());
 }
 
 static void setStringField(JNIEnv* env, jobject obj, const char* fieldName, jstring value) {
-    jfieldID fid = env->GetFieldID(JniConstants::localeDataClass, fieldName, "Ljava/lang/String;");
+    jfieldID fid = localeDataField(env, fieldName, "Ljava/lang/String;");
     env->SetObjectField(obj, fid, value);
     env->DeleteLocalRef(value);
 }
 
 static void setStringArrayField(JNIEnv* env, jobject obj, const char* fieldName, jobjectArray value) {
-    jfieldID fid = env->GetFieldID(JniConstants::localeDataClass, fieldName, "[Ljava/lang/String;");
+    jfieldID fid = localeDataField(env, fieldName, "[Ljava/lang/String;");
     env->SetObjectField(obj, fid, value);
 }
 
@@ -333,7 +355,7 @@ static void setCharField(JNIEnv* env, jobject obj, const char* fieldName, const
     if (value.length() == 0) {
         return;
     }
-    jfieldID fid = env->GetFieldID(JniConstants::localeDataClass, fieldName, "C");
+    jfieldID fid = localeDataField(env, fieldName, "C");
     env->SetCharField(obj, fid, value.charAt(0));
 }
 
@@ -572,7 +594,7 @@ static jboolean ICU_initLocaleDataNative(JNIEnv* env, jclass, jstring javaLocale
     setDecimalFormatSymbolsData(env, localeData, locale);
 
     jstring countryCode = env->NewStringUTF(Locale::createFromName(localeName.c_str()).getCountry());
-    jstring internationalCurrencySymbol = ICU_getCurrencyCode(env, NULL, countryCode);
+    jstring internationalCurrencySymbol = ICU_getCurrencyCodeNative(env, NULL, countryCode);
     env->DeleteLocalRef(countryCode);
     countryCode = NULL;
 
@@ -592,26 +614,132 @@ static jboolean ICU_initLocaleDataNative(JNIEnv* env, jclass, jstring javaLocale
     return JNI_TRUE;
 }
 
-static jstring ICU_toLowerCase(JNIEnv* env, jclass, jstring javaString, jstring localeName) {
+// Turkish and Azeri map ASCII 'i' and 'I' to and from dotted and dotless forms outside ASCII.
+// No other locale's case mappings change an ASCII string's length or leave ASCII.
+static bool isLanguage(const char* localeName, const char* language) {
+  size_t length = strlen(language);
+  return strncmp(localeName, language, length) == 0 &&
+      (localeName[length] == '\0' || localeName[length] == '_' || localeName[length] == '-');
+}
+
+static bool hasAsciiCaseMapping(const char* localeName) {
+  return !isLanguage(localeName, "tr") && !isLanguage(localeName, "tur") &&
+      !isLanguage(localeName, "az") && !isLanguage(localeName, "aze");
+}
+
+// Returns the index of the first char whose ASCII case mapping differs from itself, 'length'
+// if there is none, or -1 if the string isn't pure ASCII.
+static jint findAsciiCaseChange(const jchar* chars, size_t length, bool upper) {
+  const jchar from = upper ? 'a' : 'A';
+  jint firstChange = length;
+  jchar nonAscii = 0;
+  for (size_t i = 0; i < length; ++i) {
+    jchar ch = chars[i];
+    nonAscii |= ch;
+    if (static_cast<jchar>(ch - from) < 26 && firstChange == static_cast<jint>(length)) {
+      firstChange = i;
+    }
+  }
+  return (nonAscii & ~0x7f) ? -1 : firstChange;
+}
+
+// Written without branches so the compiler can vectorize it.
+static void mapAsciiCase(const jchar* src, jchar* dst, size_t length, bool upper) {
+  const jchar from = upper ? 'a' : 'A';
+  for (size_t i = 0; i < length; ++i) {
+    jchar ch = src[i];
+    dst[i] = ch ^ ((static_cast<jchar>(ch - from) < 26) << 5);
+  }
+}
+
+static jstring caseMap(JNIEnv* env, jstring javaString, const Locale& locale, bool asciiSafe, bool upper) {
+  if (javaString == NULL) {
+    jniThrowNullPointerException(env, NULL);
+    return NULL;
+  }
+  if (asciiSafe) {
+    ScopedStringChars chars(env, javaString);
+    if (chars.get() == NULL) {
+      return NULL;
+    }
+    jint firstChange = findAsciiCaseChange(chars.get(), chars.size(), upper);
+    if (firstChange == static_cast<jint>(chars.size())) {
+      return javaString;
+    }
+    if (firstChange != -1) {
+      std::vector<jchar> result(chars.get(), chars.get() + chars.size());
+      mapAsciiCase(chars.get() + firstChange, &result[firstChange], chars.size() - firstChange, upper);
+      return env->NewString(&result[0], result.size());
+    }
+  }
+
   ScopedJavaUnicodeString scopedString(env, javaString);
   if (!scopedString.valid()) {
     return NULL;
   }
   UnicodeString& s(scopedString.unicodeString());
   UnicodeString original(s);
-  s.toLower(Locale::createFromName(ScopedUtfChars(env, localeName).c_str()));
+  if (upper) {
+    s.toUpper(locale);
+  } else {
+    s.toLower(locale);
+  }
   return s == original ? javaString : env->NewString(s.getBuffer(), s.length());
 }
 
+static void caseMapAll(JNIEnv* env, jobjectArray javaStrings, jstring localeName, bool upper) {
+  ScopedUtfChars localeChars(env, localeName);
+  if (localeChars.c_str() == NULL) {
+    return;
+  }
+  Locale locale(Locale::createFromName(localeChars.c_str()));
+  bool asciiSafe = hasAsciiCaseMapping(localeChars.c_str());
+  if (javaStrings == NULL) {
+    jniThrowNullPointerException(env, NULL);
+    return;
+  }
+  jsize count = env->GetArrayLength(javaStrings);
+  for (jsize i = 0; i < count; ++i) {
+    ScopedLocalRef<jstring> string(env, reinterpret_cast<jstring>(env->GetObjectArrayElement(javaStrings, i)));
+    if (string.get() == NULL) {
+      // Leave null elements alone, as a caller normalizing optional values would expect.
+      continue;
+    }
+    jstring result = caseMap(env, string.get(), locale, asciiSafe, upper);
+    if (result == NULL) {
+      return;
+    }
+    if (result != string.get()) {
+      env->SetObjectArrayElement(javaStrings, i, result);
+      env->DeleteLocalRef(result);
+    }
+  }
+}
+
+static jstring ICU_toLowerCase(JNIEnv* env, jclass, jstring javaString, jstring localeName) {
+  ScopedUtfChars localeChars(env, localeName);
+  if (localeChars.c_str() == NULL) {
+    return NULL;
+  }
+  return caseMap(env, javaString, Locale::createFromName(localeChars.c_str()),
+                 hasAsciiCaseMapping(localeChars.c_str()), false);
+}
+
 static jstring ICU_toUpperCase(JNIEnv* env, jclass, jstring javaString, jstring localeName) {
-  ScopedJavaUnicodeString scopedString(env, javaString);
-  if (!scopedString.valid()) {
+  ScopedUtfChars localeChars(env, localeName);
+  if (localeChars.c_str() == NULL) {
     return NULL;
   }
-  UnicodeString& s(scopedString.unicodeString());
-  UnicodeString original(s);
-  s.toUpper(Locale::createFromName(ScopedUtfChars(env, localeName).c_str()));
-  return s == original ? javaString : env->NewString(s.getBuffer(), s.length());
+  return caseMap(env, javaString, Locale::createFromName(localeChars.c_str()),
+                 hasAsciiCaseMapping(localeChars.c_str()), true);
+}
+
+static void ICU_toLowerCaseAll(JNIEnv* env, jclass, jobjectArray javaStrings, jstring localeName) {
+  caseMapAll(env, javaStrings, localeName, false);
+}
+
+static void ICU_toUpperCaseAll(JNIEnv* env, jclass, jobjectArray javaStrings, jstring localeName) {
+  caseMapAll(env, javaStrings, localeName, true);
 }
 
 static jstring versionString(JNIEnv* env, const UVersionInfo& version) {
@@ -645,19 +773,80 @@ static jobject ICU_getAvailableCurrencyCodes(JNIEnv* env, jclass) {
   return fromStringEnumeration(env, status, "ucurr_openISOCurrencies", &e);
 }
 
+// Creating a DateTimePatternGenerator loads and digests all of a locale's date formats, which
+// is far more work than the lookup itself. So we keep the generators for the most recently used
+// locales. getBestPattern isn't const, so a generator is only used with the lock held.
+typedef std::list<std::pair<std::string, DateTimePatternGenerator*> > GeneratorLru;
+
+static const size_t MAX_CACHED_GENERATORS = 4;
+
+// The most recently used entry is first.
+static pthread_mutex_t gGeneratorCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static GeneratorLru gGeneratorLru;
+
+// Moves the entry for 'localeName' to the front and returns true, or returns false.
+// Call with gGeneratorCacheMutex held.
+static bool findCachedGenerator(const std::string& localeName) {
+  for (GeneratorLru::iterator it = gGeneratorLru.begin(); it != gGeneratorLru.end(); ++it) {
+    if (it->first == localeName) {
+      gGeneratorLru.splice(gGeneratorLru.begin(), gGeneratorLru, it);
+      return true;
+    }
+  }
+  return false;
+}
+
 static jstring ICU_getBestDateTimePatternNative(JNIEnv* env, jclass, jstring javaSkeleton, jstring javaLocaleName) {
-  Locale locale = getLocale(env, javaLocaleName);
-  UErrorCode status = U_ZERO_ERROR;
-  UniquePtr<DateTimePatternGenerator> generator(DateTimePatternGenerator::createInstance(locale, status));
-  if (maybeThrowIcuException(env, "DateTimePatternGenerator::createInstance", status)) {
+  ScopedUtfChars localeName(env, javaLocaleName);
+  if (localeName.c_str() == NULL) {
     return NULL;
   }
-
   ScopedJavaUnicodeString skeletonHolder(env, javaSkeleton);
   if (!skeletonHolder.valid()) {
     return NULL;
   }
-  UnicodeString result(generator->getBestPattern(skeletonHolder.unicodeString(), status));
+  std::string key(localeName.c_str());
+  UErrorCode status = U_ZERO_ERROR;
+  UniquePtr<DateTimePatternGenerator> generator;
+  bool found;
+  {
+    ScopedPthreadMutexLock lock(&gGeneratorCacheMutex);
+    found = findCachedGenerator(key);
+  }
+  if (!found) {
+    // Create the generator outside the lock, since that takes a while.
+    Locale locale = Locale::createFromName(localeName.c_str());
+    generator.reset(DateTimePatternGenerator::createInstance(locale, status));
+    if (maybeThrowIcuException(env, "DateTimePatternGenerator::createInstance", status)) {
+      return NULL;
+    }
+  }
+
+  UnicodeString result;
+  DateTimePatternGenerator* evicted = NULL;
+  {
+    ScopedPthreadMutexLock lock(&gGeneratorCacheMutex);
+    // Another thread may have added or evicted this locale meanwhile.
+    if (!findCachedGenerator(key)) {
+      if (generator.get() == NULL) {
+        generator.reset(DateTimePatternGenerator::createInstance(Locale::createFromName(key.c_str()), status));
+        if (U_FAILURE(status)) {
+          generator.reset();
+        }
+      }
+      if (generator.get() != NULL) {
+        if (gGeneratorLru.size() >= MAX_CACHED_GENERATORS) {
+          evicted = gGeneratorLru.back().second;
+          gGeneratorLru.pop_back();
+        }
+        gGeneratorLru.push_front(std::make_pair(key, generator.release()));
+      }
+    }
+    if (U_SUCCESS(status)) {
+      result = gGeneratorLru.front().second->getBestPattern(skeletonHolder.unicodeString(), status);
+    }
+  }
+  delete evicted;
   if (maybeThrowIcuException(env, "DateTimePatternGenerator::getBestPattern", status)) {
     return NULL;
   }
@@ -666,7 +855,7 @@ static jstring ICU_getBestDateTimePatternNative(JNIEnv* env, jclass, jstring jav
 }
 
 static JNINativeMethod gMethods[] = {
-    NATIVE_METHOD(ICU, addLikelySubtags, "(Ljava/lang/String;)Ljava/lang/String;"),
+    NATIVE_METHOD(ICU, addLikelySubtagsNative, "(Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getAvailableBreakIteratorLocalesNative, "()[Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getAvailableCalendarLocalesNative, "()[Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getAvailableCollatorLocalesNative, "()[Ljava/lang/String;"),
@@ -676,9 +865,9 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(ICU, getAvailableNumberFormatLocalesNative, "()[Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getBestDateTimePatternNative, "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getCldrVersion, "()Ljava/lang/String;"),
-    NATIVE_METHOD(ICU, getCurrencyCode, "(Ljava/lang/String;)Ljava/lang/String;"),
+    NATIVE_METHOD(ICU, getCurrencyCodeNative, "(Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getCurrencyDisplayName, "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
-    NATIVE_METHOD(ICU, getCurrencyFractionDigits, "(Ljava/lang/String;)I"),
+    NATIVE_METHOD(ICU, getCurrencyFractionDigitsNative, "(Ljava/lang/String;)I"),
     NATIVE_METHOD(ICU, getCurrencySymbol, "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getDisplayCountryNative, "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getDisplayLanguageNative, "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
@@ -688,13 +877,17 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(ICU, getISOCountriesNative, "()[Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getISOLanguagesNative, "()[Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getIcuVersion, "()Ljava/lang/String;"),
-    NATIVE_METHOD(ICU, getScript, "(Ljava/lang/String;)Ljava/lang/String;"),
+    NATIVE_METHOD(ICU, getScriptNative, "(Ljava/lang/String;)Ljava/lang/String;"),
     NATIVE_METHOD(ICU, getUnicodeVersion, "()Ljava/lang/String;"),
     NATIVE_METHOD(ICU, initLocaleDataNative, "(Ljava/lang/String;Llibcore/icu/LocaleData;)Z"),
     NATIVE_METHOD(ICU, toLowerCase, "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
+    NATIVE_METHOD(ICU, toLowerCaseAll, "([Ljava/lang/String;Ljava/lang/String;)V"),
     NATIVE_METHOD(ICU, toUpperCase, "(Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
+    NATIVE_METHOD(ICU, toUpperCaseAll, "([Ljava/lang/String;Ljava/lang/String;)V"),
 };
-void register_libcore_icu_ICU(JNIEnv* env) {
+// Called from JNI_OnLoad, whether or not the ICU natives are registered lazily: other parts of
+// libcore, such as java.lang.Character and java.util.regex, use ICU directly.
+void init_libcore_icu_data() {
     std::string path;
     path = u_getDataDirectory();
     path += "/";
@@ -721,7 +914,11 @@ void register_libcore_icu_ICU(JNIEnv* env) {
     }
 
     // Map it.
-    void* data = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd.get(), 0);
+    void* data;
+    {
+        ScopedStartupEvent event("mmap " U_ICUDATA_NAME ".dat");
+        data = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd.get(), 0);
+    }
     if (data == MAP_FAILED) {
         FAIL_WITH_STRERROR("mmap");
     }
@@ -733,7 +930,10 @@ void register_libcore_icu_ICU(JNIEnv* env) {
 
     // Tell ICU to use our memory-mapped data.
     UErrorCode status = U_ZERO_ERROR;
-    udata_setCommonData(data, &status);
+    {
+        ScopedStartupEvent event("udata_setCommonData");
+        udata_setCommonData(data, &status);
+    }
     MAYBE_FAIL_WITH_ICU_ERROR("udata_setCommonData");
     // Tell ICU it can *only* use our memory-mapped data.
     udata_setFileAccess(UDATA_NO_FILES, &status);
@@ -742,7 +942,11 @@ void register_libcore_icu_ICU(JNIEnv* env) {
     // Failures to find the ICU data tend to be somewhat obscure because ICU loads its data on first
     // use, which can be anywhere. Force initialization up front so we can report a nice clear error
     // and bail.
+    ScopedStartupEvent event("u_init");
     u_init(&status);
     MAYBE_FAIL_WITH_ICU_ERROR("u_init");
+}
+
+void register_libcore_icu_ICU(JNIEnv* env) {
     jniRegisterNativeMethods(env, "libcore/icu/ICU", gMethods, NELEM(gMethods));
 }
@@ -21,9 +21,12 @@
 #include "JniConstants.h"
 #include "JniException.h"
 #include "ScopedUtfChars.h"
+#include "StartupProfile.h"
 #include "unicode/brkiter.h"
 #include "unicode/putil.h"
+#include "unicode/rbbi.h"
 #include <stdlib.h>
+#include <vector>
 
 // ICU documentation: http://icu-project.org/apiref/icu4c/classBreakIterator.html
 
@@ -113,6 +116,7 @@ class BreakIteratorAccessor {
     return 0; \
   } \
   Locale locale(Locale::createFromName(localeChars.c_str())); \
+  ScopedStartupEvent event(#F); \
   BreakIterator* it = F(locale, status); \
   if (maybeThrowIcuException(env, "ubrk_open", status)) { \
     return 0; \
@@ -143,6 +147,62 @@ static jint NativeBreakIterator_followingImpl(JNIEnv* env, jclass, jlong address
   return it->following(offset);
 }
 
+// Finds every boundary in 'javaInput' with a single string fetch, for callers that want to
+// tokenize a whole text. With 'ruleStatus', the result holds (offset, rule status) pairs.
+// The iterator is left with empty text, so it doesn't point into the released chars.
+static jintArray NativeBreakIterator_getBoundariesImpl(JNIEnv* env, jclass, jlong address,
+                                                       jstring javaInput, jboolean ruleStatus) {
+  if (javaInput == NULL) {
+    jniThrowNullPointerException(env, NULL);
+    return NULL;
+  }
+  BreakIterator* it = toBreakIterator(address);
+  std::vector<jint> result;
+  {
+    const jchar* chars = env->GetStringChars(javaInput, NULL);
+    if (chars == NULL) {
+      return NULL;
+    }
+    jsize length = env->GetStringLength(javaInput);
+    UErrorCode status = U_ZERO_ERROR;
+    UText* text = utext_openUChars(NULL, chars, length, &status);
+    if (U_SUCCESS(status)) {
+      it->setText(text, status);
+    }
+    if (U_SUCCESS(status)) {
+      // Most texts have a boundary every few chars; this avoids most regrowth.
+      result.reserve((ruleStatus ? 2 : 1) * (length / 4 + 2));
+      for (int32_t offset = it->first(); offset != BreakIterator::DONE; offset = it->next()) {
+        result.push_back(offset);
+        if (ruleStatus) {
+          // Every iterator we hand out comes from one of the create*Instance factories, which
+          // only make RuleBasedBreakIterators.
+          result.push_back(static_cast<RuleBasedBreakIterator*>(it)->getRuleStatus());
+        }
+      }
+    }
+    // RBBI keeps a shallow clone of the UText it's given, so the empty text it's left with has
+    // to outlive the call.
+    static const UChar EMPTY_TEXT[] = { 0 };
+    UErrorCode emptyStatus = U_ZERO_ERROR;
+    UText empty = UTEXT_INITIALIZER;
+    utext_openUChars(&empty, EMPTY_TEXT, 0, &emptyStatus);
+    it->setText(&empty, emptyStatus);
+    utext_close(&empty);
+    utext_close(text);
+    env->ReleaseStringChars(javaInput, chars);
+    if (maybeThrowIcuException(env, "BreakIterator::setText", status)) {
+      return NULL;
+    }
+  }
+
+  jintArray javaResult = env->NewIntArray(result.size());
+  if (javaResult != NULL && !result.empty()) {
+    env->SetIntArrayRegion(javaResult, 0, result.size(), &result[0]);
+  }
+  return javaResult;
+}
+
 static jint NativeBreakIterator_getCharacterInstanceImpl(JNIEnv* env, jclass, jstring javaLocale) {
   MAKE_BREAK_ITERATOR_INSTANCE(BreakIterator::createCharacterInstance);
 }
@@ -207,6 +267,7 @@ static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(NativeBreakIterator, currentImpl, "(JLjava/lang/String;)I"),
   NATIVE_METHOD(NativeBreakIterator, firstImpl, "(JLjava/lang/String;)I"),
   NATIVE_METHOD(NativeBreakIterator, followingImpl, "(JLjava/lang/String;I)I"),
+  NATIVE_METHOD(NativeBreakIterator, getBoundariesImpl, "(JLjava/lang/String;Z)[I"),
   NATIVE_METHOD(NativeBreakIterator, getCharacterInstanceImpl, "(Ljava/lang/String;)J"),
   NATIVE_METHOD(NativeBreakIterator, getLineInstanceImpl, "(Ljava/lang/String;)J"),
   NATIVE_METHOD(NativeBreakIterator, getSentenceInstanceImpl, "(Ljava/lang/String;)J"),
@@ -13,23 +13,277 @@
 #include "JNIHelp.h"
 #include "JniConstants.h"
 #include "JniException.h"
+#include "ScopedLocalRef.h"
+#include "ScopedPrimitiveArray.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedStringChars.h"
 #include "ScopedUtfChars.h"
+#include "StartupProfile.h"
 #include "UniquePtr.h"
 #include "ucol_imp.h"
 #include "unicode/ucol.h"
 #include "unicode/ucoleitr.h"
+#include "unicode/uiter.h"
+#include "unicode/uset.h"
+
+#include <algorithm>
+#include <limits.h>
+#include <list>
+#include <map>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+struct AsciiPrimaries;
+
+// What a Java collator's address points to: the ICU collator and its ASCII fast-path state.
+struct CollatorHandle {
+    explicit CollatorHandle(UCollator* collator)
+            : collator(collator), asciiPrimaries(NULL), asciiCompareCount(0),
+              asciiPrimariesGeneration(0) {
+        pthread_mutex_init(&asciiPrimariesMutex, NULL);
+    }
+
+    ~CollatorHandle();
+
+    UCollator* collator;
+    // Only ever set to a fully built table, with a release store under asciiPrimariesMutex, and
+    // read with an acquire load, so compare needs no lock.
+    AsciiPrimaries* asciiPrimaries;
+    uint32_t asciiCompareCount;
+    // Guards the fields below, and the publication of asciiPrimaries.
+    pthread_mutex_t asciiPrimariesMutex;
+    // Bumped by setAttribute, so a table built against the old attributes is never published.
+    uint32_t asciiPrimariesGeneration;
+    // Tables thrown away by setAttribute. A compare racing with setAttribute may still be
+    // reading one, so they're only freed along with the collator.
+    std::vector<AsciiPrimaries*> retiredAsciiPrimaries;
+};
+
+static CollatorHandle* toCollatorHandle(jlong address) {
+    return reinterpret_cast<CollatorHandle*>(static_cast<uintptr_t>(address));
+}
 
 static UCollator* toCollator(jlong address) {
-    return reinterpret_cast<UCollator*>(static_cast<uintptr_t>(address));
+    return toCollatorHandle(address)->collator;
+}
+
+// Takes ownership of 'collator'. Returns 0 if 'collator' is NULL.
+static jlong toAddress(UCollator* collator) {
+    if (collator == NULL) {
+        return 0;
+    }
+    return static_cast<jlong>(reinterpret_cast<uintptr_t>(new CollatorHandle(collator)));
 }
 
 static UCollationElements* toCollationElements(jlong address) {
     return reinterpret_cast<UCollationElements*>(static_cast<uintptr_t>(address));
 }
 
+/*
+ * Most strings we collate are ASCII identifiers, which ucol_strcoll handles no faster than
+ * anything else. Unless a tailoring has contractions among ASCII chars, each printable ASCII
+ * char maps to a single collation element, so two pure-ASCII strings whose primary weights
+ * differ are ordered by the first difference. Only if the primary weights are all equal do the
+ * secondary and tertiary levels (accents and case) matter, and then we let ICU decide.
+ *
+ * The table is built per collator, but only once a collator has been used for enough ASCII
+ * comparisons to pay for it: Collator.getInstance opens a new collator every time.
+ */
+struct AsciiPrimaries {
+    AsciiPrimaries() {
+        std::fill(weights, weights + 128, 0);
+    }
+
+    // The primary weight of each ASCII char, or 0 if the table can't order that char.
+    // Never changes once the table is published.
+    uint32_t weights[128];
+};
+
+CollatorHandle::~CollatorHandle() {
+    delete asciiPrimaries;
+    for (size_t i = 0; i < retiredAsciiPrimaries.size(); ++i) {
+        delete retiredAsciiPrimaries[i];
+    }
+    pthread_mutex_destroy(&asciiPrimariesMutex);
+    ucol_close(collator);
+}
+
+static const uint32_t ASCII_PRIMARIES_MIN_COMPARES = 32;
+
+static bool hasAsciiContraction(const UCollator* collator) {
+    UErrorCode status = U_ZERO_ERROR;
+    USet* contractions = uset_openEmpty();
+    ucol_getContractionsAndExpansions(collator, contractions, NULL, true, &status);
+    bool result = U_FAILURE(status);
+    UChar string[32];
+    for (int32_t i = 0; !result && i < uset_getItemCount(contractions); ++i) {
+        UChar32 start, end;
+        status = U_ZERO_ERROR;
+        int32_t length = uset_getItem(contractions, i, &start, &end, string, 32, &status);
+        if (length == 0) {
+            continue;  // A range of code points rather than a string.
+        }
+        if (U_FAILURE(status)) {
+            result = true;  // Too long to check, so assume the worst.
+            break;
+        }
+        result = true;
+        for (int32_t j = 0; j < length; ++j) {
+            if (string[j] >= 0x80) {
+                result = false;
+                break;
+            }
+        }
+    }
+    uset_close(contractions);
+    return result;
+}
+
+static bool byWeight(const std::pair<uint32_t, UChar>& lhs, const std::pair<uint32_t, UChar>& rhs) {
+    return lhs.first < rhs.first;
+}
+
+static void buildAsciiPrimaries(const UCollator* collator, AsciiPrimaries* table) {
+    // Shifted punctuation and numeric collation both change the primary weights.
+    // NativeCollation_setAttribute throws the table away, so it's rebuilt if they change.
+    UErrorCode status = U_ZERO_ERROR;
+    if (ucol_getAttribute(collator, UCOL_ALTERNATE_HANDLING, &status) != UCOL_NON_IGNORABLE ||
+            ucol_getAttribute(collator, UCOL_NUMERIC_COLLATION, &status) != UCOL_OFF ||
+            U_FAILURE(status) || hasAsciiContraction(collator)) {
+        return;
+    }
+    std::vector<std::pair<uint32_t, UChar> > sorted;
+    for (UChar ch = 0x20; ch < 0x7f; ++ch) {
+        UErrorCode status = U_ZERO_ERROR;
+        UCollationElements* elements = ucol_openElements(collator, &ch, 1, &status);
+        int32_t first = ucol_next(elements, &status);
+        int32_t second = ucol_next(elements, &status);
+        ucol_closeElements(elements);
+        if (U_SUCCESS(status) && first != UCOL_NULLORDER && second == UCOL_NULLORDER &&
+                ucol_primaryOrder(first) != 0) {
+            table->weights[ch] = ucol_primaryOrder(first);
+            sorted.push_back(std::make_pair(table->weights[ch], ch));
+        }
+    }
+    // Check the table against ICU before trusting it.
+    std::stable_sort(sorted.begin(), sorted.end(), byWeight);
+    for (size_t i = 1; i < sorted.size(); ++i) {
+        if (sorted[i - 1].first != sorted[i].first &&
+                ucol_strcoll(collator, &sorted[i - 1].second, 1, &sorted[i].second, 1) != UCOL_LESS) {
+            std::fill(table->weights, table->weights + 128, 0);
+            return;
+        }
+    }
+}
+
+// Returns the table for 'handle' if it has been built, or NULL if ICU should compare.
+static const AsciiPrimaries* asciiPrimariesFor(CollatorHandle* handle) {
+    AsciiPrimaries* table = __atomic_load_n(&handle->asciiPrimaries, __ATOMIC_ACQUIRE);
+    if (table != NULL) {
+        return table;
+    }
+    // Only the compare that reaches the threshold builds the table, outside the lock.
+    // The others carry on with ICU until it's published.
+    uint32_t count = __atomic_add_fetch(&handle->asciiCompareCount, 1, __ATOMIC_RELAXED);
+    if (count != ASCII_PRIMARIES_MIN_COMPARES) {
+        return NULL;
+    }
+    uint32_t generation;
+    {
+        ScopedPthreadMutexLock lock(&handle->asciiPrimariesMutex);
+        generation = handle->asciiPrimariesGeneration;
+    }
+    UniquePtr<AsciiPrimaries> built(new AsciiPrimaries);
+    buildAsciiPrimaries(handle->collator, built.get());
+
+    ScopedPthreadMutexLock lock(&handle->asciiPrimariesMutex);
+    table = handle->asciiPrimaries;
+    if (table == NULL && generation == handle->asciiPrimariesGeneration) {
+        // Every write to the table happens before this release store.
+        table = built.release();
+        __atomic_store_n(&handle->asciiPrimaries, table, __ATOMIC_RELEASE);
+    }
+    return table;
+}
+
+static const int ASCII_UNDECIDED = 2;
+
+// Returns the order of two different pure-ASCII strings if their primary weights decide it,
+// or ASCII_UNDECIDED.
+static int compareAsciiPrimaries(const AsciiPrimaries* table,
+        const jchar* lhs, size_t lhsLength, const jchar* rhs, size_t rhsLength) {
+    // The whole of both strings must be in the table, or a later char might form a
+    // contraction with, or reorder, an earlier one.
+    for (size_t i = 0; i < lhsLength; ++i) {
+        if (lhs[i] >= 0x80 || table->weights[lhs[i]] == 0) {
+            return ASCII_UNDECIDED;
+        }
+    }
+    for (size_t i = 0; i < rhsLength; ++i) {
+        if (rhs[i] >= 0x80 || table->weights[rhs[i]] == 0) {
+            return ASCII_UNDECIDED;
+        }
+    }
+    size_t length = std::min(lhsLength, rhsLength);
+    for (size_t i = 0; i < length; ++i) {
+        uint32_t lhsWeight = table->weights[lhs[i]];
+        uint32_t rhsWeight = table->weights[rhs[i]];
+        if (lhsWeight != rhsWeight) {
+            return (lhsWeight < rhsWeight) ? UCOL_LESS : UCOL_GREATER;
+        }
+    }
+    if (lhsLength != rhsLength) {
+        return (lhsLength < rhsLength) ? UCOL_LESS : UCOL_GREATER;
+    }
+    return ASCII_UNDECIDED;
+}
+
+static bool isAscii(const jchar* chars, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        if (chars[i] >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Tries to order 'lhs' and 'rhs' without ucol_strcoll. Returns ASCII_UNDECIDED if it can't.
+static int compareQuickly(CollatorHandle* handle,
+        const jchar* lhs, size_t lhsLength, const jchar* rhs, size_t rhsLength) {
+    // Identical strings are equal at every strength.
+    size_t prefix = 0;
+    size_t length = std::min(lhsLength, rhsLength);
+    while (prefix < length && lhs[prefix] == rhs[prefix]) {
+        ++prefix;
+    }
+    if (prefix == lhsLength && prefix == rhsLength) {
+        return UCOL_EQUAL;
+    }
+    if (!isAscii(lhs, lhsLength) || !isAscii(rhs, rhsLength)) {
+        return ASCII_UNDECIDED;
+    }
+    const AsciiPrimaries* table = asciiPrimariesFor(handle);
+    if (table == NULL) {
+        return ASCII_UNDECIDED;
+    }
+    // Without ASCII contractions, the common prefix contributes the same weights to both.
+    return compareAsciiPrimaries(table, lhs + prefix, lhsLength - prefix, rhs + prefix, rhsLength - prefix);
+}
+
+static void forgetAsciiPrimaries(CollatorHandle* handle) {
+    ScopedPthreadMutexLock lock(&handle->asciiPrimariesMutex);
+    ++handle->asciiPrimariesGeneration;
+    AsciiPrimaries* table = handle->asciiPrimaries;
+    __atomic_store_n(&handle->asciiPrimaries, NULL, __ATOMIC_RELEASE);
+    __atomic_store_n(&handle->asciiCompareCount, 0, __ATOMIC_RELAXED);
+    if (table != NULL) {
+        handle->retiredAsciiPrimaries.push_back(table);
+    }
+}
+
 static void NativeCollation_closeCollator(JNIEnv*, jclass, jlong address) {
-    ucol_close(toCollator(address));
+    delete toCollatorHandle(address);
 }
 
 static void NativeCollation_closeElements(JNIEnv*, jclass, jlong address) {
@@ -45,7 +299,13 @@ static jint NativeCollation_compare(JNIEnv* env, jclass, jlong address, jstring
     if (rhs.get() == NULL) {
         return 0;
     }
-    return ucol_strcoll(toCollator(address), lhs.get(), lhs.size(), rhs.get(), rhs.size());
+    CollatorHandle* handle = toCollatorHandle(address);
+    const UCollator* collator = handle->collator;
+    int result = compareQuickly(handle, lhs.get(), lhs.size(), rhs.get(), rhs.size());
+    if (result != ASCII_UNDECIDED) {
+        return result;
+    }
+    return ucol_strcoll(collator, lhs.get(), lhs.size(), rhs.get(), rhs.size());
 }
 
 static jint NativeCollation_getAttribute(JNIEnv* env, jclass, jlong address, jint type) {
@@ -104,6 +364,80 @@ static jbyteArray NativeCollation_getSortKey(JNIEnv* env, jclass, jlong address,
     return result;
 }
 
+// Appends the sort key of 'source' to 'keys'. If maxKeyLength > 0, only that many leading
+// bytes of the key are computed. Returns false with an exception pending on failure.
+static bool appendSortKey(JNIEnv* env, const UCollator* collator, const ScopedStringChars& source,
+        jint maxKeyLength, std::vector<uint8_t>& keys) {
+    size_t start = keys.size();
+    if (maxKeyLength > 0) {
+        // ucol_nextSortKeyPart stops after maxKeyLength bytes rather than computing the whole
+        // key, so long strings that differ early cost no more than short ones.
+        keys.resize(start + maxKeyLength);
+        UCharIterator iterator;
+        uiter_setString(&iterator, source.get(), source.size());
+        uint32_t state[2] = { 0, 0 };
+        UErrorCode status = U_ZERO_ERROR;
+        int32_t length = ucol_nextSortKeyPart(collator, &iterator, state, &keys[start], maxKeyLength, &status);
+        if (maybeThrowIcuException(env, "ucol_nextSortKeyPart", status)) {
+            return false;
+        }
+        keys.resize(start + length);
+        return true;
+    }
+    // Guess generously from the string length so that most keys need only one call. Like
+    // getSortKey, the key includes its terminating zero byte.
+    size_t guess = source.size() * 4 + 16;
+    keys.resize(start + guess);
+    size_t length = ucol_getSortKey(collator, source.get(), source.size(), &keys[start], guess);
+    if (length > guess) {
+        keys.resize(start + length);
+        length = ucol_getSortKey(collator, source.get(), source.size(), &keys[start], length);
+    }
+    keys.resize(start + length);
+    return true;
+}
+
+static jbyteArray NativeCollation_getSortKeys(JNIEnv* env, jclass, jlong address,
+        jobjectArray javaSources, jintArray javaOffsets, jint maxKeyLength) {
+    jsize count = env->GetArrayLength(javaSources);
+    ScopedIntArrayRW offsets(env, javaOffsets);
+    if (offsets.get() == NULL) {
+        return NULL;
+    }
+    if (offsets.size() != static_cast<size_t>(count) + 1) {
+        jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException",
+                "offsets.length=%zu; sources.length=%d", offsets.size(), count);
+        return NULL;
+    }
+    const UCollator* collator = toCollator(address);
+    std::vector<uint8_t> keys;
+    offsets[0] = 0;
+    for (jsize i = 0; i < count; ++i) {
+        ScopedLocalRef<jstring> javaSource(env,
+                reinterpret_cast<jstring>(env->GetObjectArrayElement(javaSources, i)));
+        // A null source gets an empty key, as a failed ucol_getSortKey would.
+        if (javaSource.get() != NULL) {
+            ScopedStringChars source(env, javaSource.get());
+            if (source.get() == NULL) {
+                return NULL;
+            }
+            if (!appendSortKey(env, collator, source, maxKeyLength, keys)) {
+                return NULL;
+            }
+        }
+        if (keys.size() > INT_MAX) {
+            jniThrowOutOfMemoryError(env, "sort keys too large for one array");
+            return NULL;
+        }
+        offsets[i + 1] = keys.size();
+    }
+    jbyteArray result = env->NewByteArray(keys.size());
+    if (result != NULL && !keys.empty()) {
+        env->SetByteArrayRegion(result, 0, keys.size(), reinterpret_cast<jbyte*>(&keys[0]));
+    }
+    return result;
+}
+
 static jint NativeCollation_next(JNIEnv* env, jclass, jlong address) {
     UErrorCode status = U_ZERO_ERROR;
     jint result = ucol_next(toCollationElements(address), &status);
@@ -111,15 +445,81 @@ static jint NativeCollation_next(JNIEnv* env, jclass, jlong address) {
     return result;
 }
 
+/*
+ * Collator.getInstance opens a new collator every time, and ucol_open loads and sets up the
+ * locale's tailoring. Instead we keep an untouched collator for each of the most recently
+ * opened locales and hand out clones, which share its tailoring. Nobody else ever sees the
+ * cached collators, so setAttribute and friends only ever change a caller's own clone.
+ */
+typedef std::list<std::pair<std::string, UCollator*> > CollatorLru;
+
+static const size_t MAX_CACHED_COLLATORS = 8;
+
+// The most recently used entry is first.
+static pthread_mutex_t gCollatorCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static CollatorLru gCollatorLru;
+static std::map<std::string, CollatorLru::iterator> gCollatorCache;
+
+static UCollator* cloneCollator(const UCollator* collator, UErrorCode& status) {
+    int32_t bufferSize = U_COL_SAFECLONE_BUFFERSIZE;
+    return ucol_safeClone(collator, NULL, &bufferSize, &status);
+}
+
+// Returns a clone of the cached collator for 'localeName', or NULL.
+static UCollator* cloneCachedCollator(const std::string& localeName, UErrorCode& status) {
+    ScopedPthreadMutexLock lock(&gCollatorCacheMutex);
+    std::map<std::string, CollatorLru::iterator>::iterator it = gCollatorCache.find(localeName);
+    if (it == gCollatorCache.end()) {
+        return NULL;
+    }
+    gCollatorLru.splice(gCollatorLru.begin(), gCollatorLru, it->second);
+    // Clone under the lock, so that the entry can't be evicted and closed meanwhile.
+    return cloneCollator(it->second->second, status);
+}
+
+// Takes ownership of 'collator', unless another thread has already cached that locale.
+static void addCachedCollator(const std::string& localeName, UCollator* collator) {
+    UCollator* unused = collator;
+    {
+        ScopedPthreadMutexLock lock(&gCollatorCacheMutex);
+        if (gCollatorCache.find(localeName) == gCollatorCache.end()) {
+            if (gCollatorLru.size() >= MAX_CACHED_COLLATORS) {
+                unused = gCollatorLru.back().second;
+                gCollatorCache.erase(gCollatorLru.back().first);
+                gCollatorLru.pop_back();
+            } else {
+                unused = NULL;
+            }
+            gCollatorLru.push_front(std::make_pair(localeName, collator));
+            gCollatorCache[localeName] = gCollatorLru.begin();
+        }
+    }
+    ucol_close(unused);
+}
+
 static jlong NativeCollation_openCollator(JNIEnv* env, jclass, jstring localeName) {
     ScopedUtfChars localeChars(env, localeName);
     if (localeChars.c_str() == NULL) {
         return 0;
     }
+    std::string key(localeChars.c_str());
     UErrorCode status = U_ZERO_ERROR;
-    UCollator* c = ucol_open(localeChars.c_str(), &status);
+    UCollator* c = cloneCachedCollator(key, status);
+    if (c == NULL && U_SUCCESS(status)) {
+        UCollator* prototype;
+        {
+            ScopedStartupEvent event("ucol_open");
+            prototype = ucol_open(localeChars.c_str(), &status);
+        }
+        if (U_SUCCESS(status)) {
+            c = cloneCollator(prototype, status);
+            addCachedCollator(key, prototype);
+        } else {
+            ucol_close(prototype);
+        }
+    }
     maybeThrowIcuException(env, "ucol_open", status);
-    return static_cast<jlong>(reinterpret_cast<uintptr_t>(c));
+    return toAddress(c);
 }
 
 static jlong NativeCollation_openCollatorFromRules(JNIEnv* env, jclass, jstring javaRules, jint mode, jint strength) {
@@ -131,7 +531,7 @@ static jlong NativeCollation_openCollatorFromRules(JNIEnv* env, jclass, jstring
     UCollator* c = ucol_openRules(rules.get(), rules.size(),
             UColAttributeValue(mode), UCollationStrength(strength), NULL, &status);
     maybeThrowIcuException(env, "ucol_openRules", status);
-    return static_cast<jlong>(reinterpret_cast<uintptr_t>(c));
+    return toAddress(c);
 }
 
 static jint NativeCollation_previous(JNIEnv* env, jclass, jlong address) {
@@ -147,15 +547,18 @@ static void NativeCollation_reset(JNIEnv*, jclass, jlong address) {
 
 static jlong NativeCollation_safeClone(JNIEnv* env, jclass, jlong address) {
     UErrorCode status = U_ZERO_ERROR;
-    jint bufferSize = U_COL_SAFECLONE_BUFFERSIZE;
-    UCollator* c = ucol_safeClone(toCollator(address), NULL, &bufferSize, &status);
+    UCollator* c = cloneCollator(toCollator(address), status);
     maybeThrowIcuException(env, "ucol_safeClone", status);
-    return static_cast<jlong>(reinterpret_cast<uintptr_t>(c));
+    return toAddress(c);
 }
 
 static void NativeCollation_setAttribute(JNIEnv* env, jclass, jlong address, jint type, jint value) {
+    // Before, so no compare uses the old table with the new attributes, and after, so a table
+    // whose build overlapped the change is never published.
+    forgetAsciiPrimaries(toCollatorHandle(address));
     UErrorCode status = U_ZERO_ERROR;
     ucol_setAttribute(toCollator(address), (UColAttribute)type, (UColAttributeValue)value, &status);
+    forgetAsciiPrimaries(toCollatorHandle(address));
     maybeThrowIcuException(env, "ucol_setAttribute", status);
 }
 
@@ -185,6 +588,7 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(NativeCollation, getOffset, "(J)I"),
     NATIVE_METHOD(NativeCollation, getRules, "(J)Ljava/lang/String;"),
     NATIVE_METHOD(NativeCollation, getSortKey, "(JLjava/lang/String;)[B"),
+    NATIVE_METHOD(NativeCollation, getSortKeys, "(J[Ljava/lang/String;[II)[B"),
     NATIVE_METHOD(NativeCollation, next, "(J)I"),
     NATIVE_METHOD(NativeCollation, openCollator, "(Ljava/lang/String;)J"),
     NATIVE_METHOD(NativeCollation, openCollatorFromRules, "(Ljava/lang/String;II)J"),
@@ -21,8 +21,10 @@
 #include "JniException.h"
 #include "ScopedLocalRef.h"
 #include "ScopedPrimitiveArray.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedStringChars.h"
 #include "ScopedUtfChars.h"
+#include "StartupProfile.h"
 #include "UniquePtr.h"
 #include "cutils/log.h"
 #include "toStringArray.h"
@@ -32,8 +34,11 @@
 #include "unicode/ustring.h"
 #include "unicode/utypes.h"
 
+#include <map>
+#include <string>
 #include <vector>
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -89,7 +94,7 @@ static bool collectStandardNames(JNIEnv* env, const char* canonicalName, const c
   return true;
 }
 
-static const char* getICUCanonicalName(const char* name) {
+static const char* lookUpICUCanonicalName(const char* name) {
   UErrorCode error = U_ZERO_ERROR;
   const char* canonicalName = NULL;
   if ((canonicalName = ucnv_getCanonicalName(name, "MIME", &error)) != NULL) {
@@ -112,6 +117,32 @@ static const char* getICUCanonicalName(const char* name) {
   return NULL;
 }
 
+// Alias resolution walks several ICU alias tables, so we remember the answers. The results are
+// either pointers into ICU's static alias data or suffixes of the name we were given, so we keep
+// our own copies. Any charset name the user tries ends up here, so we stop remembering at some
+// point rather than grow without bound.
+static pthread_mutex_t gCanonicalNamesMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<std::string, std::pair<bool, std::string> > gCanonicalNames;
+static const size_t MAX_CANONICAL_NAMES = 256;
+
+// Returns ICU's canonical name for 'name', or false if ICU doesn't know it.
+static bool getICUCanonicalName(const char* name, std::string& result) {
+  ScopedPthreadMutexLock lock(&gCanonicalNamesMutex);
+  std::map<std::string, std::pair<bool, std::string> >::const_iterator it = gCanonicalNames.find(name);
+  if (it != gCanonicalNames.end()) {
+    result = it->second.second;
+    return it->second.first;
+  }
+  const char* canonicalName = lookUpICUCanonicalName(name);
+  if (canonicalName != NULL) {
+    result = canonicalName;
+  }
+  if (gCanonicalNames.size() < MAX_CANONICAL_NAMES) {
+    gCanonicalNames[name] = std::make_pair(canonicalName != NULL, result);
+  }
+  return canonicalName != NULL;
+}
+
 // If a charset listed in the IANA Charset Registry is supported by an implementation
 // of the Java platform then its canonical name must be the name listed in the registry.
 // Many charsets are given more than one name in the registry, in which case the registry
@@ -156,21 +187,6 @@ static jstring getJavaCanonicalName(JNIEnv* env, const char* icuCanonicalName) {
   return env->NewStringUTF(&result[0]);
 }
 
-static jlong NativeConverter_openConverter(JNIEnv* env, jclass, jstring converterName) {
-    ScopedUtfChars converterNameChars(env, converterName);
-    if (converterNameChars.c_str() == NULL) {
-        return 0;
-    }
-    UErrorCode status = U_ZERO_ERROR;
-    UConverter* cnv = ucnv_open(converterNameChars.c_str(), &status);
-    maybeThrowIcuException(env, "ucnv_open", status);
-    return reinterpret_cast<uintptr_t>(cnv);
-}
-
-static void NativeConverter_closeConverter(JNIEnv*, jclass, jlong address) {
-    ucnv_close(toUConverter(address));
-}
-
 static bool shouldCodecThrow(jboolean flush, UErrorCode error) {
     if (flush) {
         return (error != U_BUFFER_OVERFLOW_ERROR && error != U_TRUNCATED_CHAR_FOUND);
@@ -179,6 +195,50 @@ static bool shouldCodecThrow(jboolean flush, UErrorCode error) {
     }
 }
 
+// Runs ucnv_fromUnicode, recording the length of any malformed or unmappable input that stopped
+// it in *invalidCharCount.
+static UErrorCode fromUnicode(UConverter* cnv, char** target, const char* targetLimit,
+        const UChar** source, const UChar* sourceLimit, jboolean flush, jint* invalidCharCount) {
+    UErrorCode errorCode = U_ZERO_ERROR;
+    ucnv_fromUnicode(cnv, target, targetLimit, source, sourceLimit, NULL, (UBool) flush, &errorCode);
+
+    // If there was an error, count the problematic characters.
+    if (errorCode == U_ILLEGAL_CHAR_FOUND || errorCode == U_INVALID_CHAR_FOUND) {
+        int8_t invalidUCharCount = 32;
+        UChar invalidUChars[32];
+        UErrorCode minorErrorCode = U_ZERO_ERROR;
+        ucnv_getInvalidUChars(cnv, invalidUChars, &invalidUCharCount, &minorErrorCode);
+        if (U_SUCCESS(minorErrorCode)) {
+            *invalidCharCount = invalidUCharCount;
+        }
+    }
+    return errorCode;
+}
+
+// Runs ucnv_toUnicode, recording the length of any malformed or unmappable input that stopped
+// it in *invalidByteCount.
+static UErrorCode toUnicode(UConverter* cnv, UChar** target, const UChar* targetLimit,
+        const char** source, const char* sourceLimit, jboolean flush, jint* invalidByteCount) {
+    UErrorCode errorCode = U_ZERO_ERROR;
+    ucnv_toUnicode(cnv, target, targetLimit, source, sourceLimit, NULL, flush, &errorCode);
+
+    // If there was an error, count the problematic bytes.
+    if (errorCode == U_ILLEGAL_CHAR_FOUND || errorCode == U_INVALID_CHAR_FOUND) {
+        int8_t invalidByteCount8 = 32;
+        char invalidBytes[32] = {'\0'};
+        UErrorCode minorErrorCode = U_ZERO_ERROR;
+        ucnv_getInvalidChars(cnv, invalidBytes, &invalidByteCount8, &minorErrorCode);
+        if (U_SUCCESS(minorErrorCode)) {
+            *invalidByteCount = invalidByteCount8;
+        }
+    }
+    return errorCode;
+}
+
+static char* toNativeBuffer(jlong address) {
+    return reinterpret_cast<char*>(static_cast<uintptr_t>(address));
+}
+
 static jint NativeConverter_encode(JNIEnv* env, jclass, jlong address,
         jcharArray source, jint sourceEnd, jbyteArray target, jint targetEnd,
         jintArray data, jboolean flush) {
@@ -211,23 +271,110 @@ static jint NativeConverter_encode(JNIEnv* env, jclass, jlong address,
     const UChar* mySourceLimit= uSource.get() + sourceEnd;
     char* cTarget = reinterpret_cast<char*>(uTarget.get() + *targetOffset);
     const char* cTargetLimit = reinterpret_cast<const char*>(uTarget.get() + targetEnd);
-    UErrorCode errorCode = U_ZERO_ERROR;
-    ucnv_fromUnicode(cnv , &cTarget, cTargetLimit, &mySource, mySourceLimit, NULL, (UBool) flush, &errorCode);
+    UErrorCode errorCode = fromUnicode(cnv, &cTarget, cTargetLimit, &mySource, mySourceLimit, flush, &myData[2]);
     *sourceOffset = (mySource - uSource.get()) - *sourceOffset;
     *targetOffset = (reinterpret_cast<jbyte*>(cTarget) - uTarget.get()) - *targetOffset;
 
-    // If there was an error, count the problematic characters.
-    if (errorCode == U_ILLEGAL_CHAR_FOUND || errorCode == U_INVALID_CHAR_FOUND) {
-        int8_t invalidUCharCount = 32;
-        UChar invalidUChars[32];
-        UErrorCode minorErrorCode = U_ZERO_ERROR;
-        ucnv_getInvalidUChars(cnv, invalidUChars, &invalidUCharCount, &minorErrorCode);
-        if (U_SUCCESS(minorErrorCode)) {
-            myData[2] = invalidUCharCount;
+    // Managed code handles some cases; throw all other errors.
+    if (shouldCodecThrow(flush, errorCode)) {
+        maybeThrowIcuException(env, "ucnv_fromUnicode", errorCode);
+    }
+    return errorCode;
+}
+
+static jint NativeConverter_encodeAddress(JNIEnv* env, jclass, jlong address,
+        jcharArray source, jint sourceEnd, jlong targetAddress, jint targetEnd,
+        jintArray data, jboolean flush) {
+    UConverter* cnv = toUConverter(address);
+    if (cnv == NULL) {
+        maybeThrowIcuException(env, "toUConverter", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedCharArrayRO uSource(env, source);
+    if (uSource.get() == NULL) {
+        maybeThrowIcuException(env, "uSource", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedIntArrayRW myData(env, data);
+    if (myData.get() == NULL) {
+        maybeThrowIcuException(env, "myData", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+
+    jint* sourceOffset = &myData[0];
+    jint* targetOffset = &myData[1];
+    char* target = toNativeBuffer(targetAddress);
+    const UChar* mySource = uSource.get() + *sourceOffset;
+    const UChar* mySourceLimit = uSource.get() + sourceEnd;
+    char* cTarget = target + *targetOffset;
+    UErrorCode errorCode = fromUnicode(cnv, &cTarget, target + targetEnd, &mySource, mySourceLimit, flush, &myData[2]);
+    *sourceOffset = (mySource - uSource.get()) - *sourceOffset;
+    *targetOffset = (cTarget - target) - *targetOffset;
+
+    if (shouldCodecThrow(flush, errorCode)) {
+        maybeThrowIcuException(env, "ucnv_fromUnicode", errorCode);
+    }
+    return errorCode;
+}
+
+// Checks that a buffer chain's parallel arrays match, throwing if not.
+static bool checkChain(JNIEnv* env, const ScopedLongArrayRO& addresses, const ScopedIntArrayRO& byteCounts) {
+    if (addresses.get() == NULL || byteCounts.get() == NULL) {
+        return false;
+    }
+    if (addresses.size() != byteCounts.size()) {
+        jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException",
+                "addresses.length=%d byteCounts.length=%d", addresses.size(), byteCounts.size());
+        return false;
+    }
+    return true;
+}
+
+static jint NativeConverter_encodeAddresses(JNIEnv* env, jclass, jlong address,
+        jcharArray source, jint sourceEnd, jlongArray targetAddresses, jintArray targetByteCounts,
+        jintArray data, jboolean flush) {
+    UConverter* cnv = toUConverter(address);
+    if (cnv == NULL) {
+        maybeThrowIcuException(env, "toUConverter", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedCharArrayRO uSource(env, source);
+    if (uSource.get() == NULL) {
+        maybeThrowIcuException(env, "uSource", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedLongArrayRO addresses(env, targetAddresses);
+    ScopedIntArrayRO byteCounts(env, targetByteCounts);
+    if (!checkChain(env, addresses, byteCounts)) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedIntArrayRW myData(env, data);
+    if (myData.get() == NULL) {
+        maybeThrowIcuException(env, "myData", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+
+    // Fill each buffer in turn, moving on whenever ICU runs out of room. ICU holds on to any
+    // partially-written character and finishes it at the start of the next buffer.
+    const UChar* mySource = uSource.get() + myData[0];
+    const UChar* mySourceLimit = uSource.get() + sourceEnd;
+    jint targetOffset = myData[1];
+    jint byteCount = 0;
+    UErrorCode errorCode = U_ZERO_ERROR;
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        char* target = toNativeBuffer(addresses[i]) + targetOffset;
+        char* cTarget = target;
+        errorCode = fromUnicode(cnv, &cTarget, target + byteCounts[i] - targetOffset,
+                &mySource, mySourceLimit, flush, &myData[2]);
+        byteCount += cTarget - target;
+        targetOffset = 0;
+        if (errorCode != U_BUFFER_OVERFLOW_ERROR) {
+            break;
         }
     }
+    myData[0] = (mySource - uSource.get()) - myData[0];
+    myData[1] = byteCount;
 
-    // Managed code handles some cases; throw all other errors.
     if (shouldCodecThrow(flush, errorCode)) {
         maybeThrowIcuException(env, "ucnv_fromUnicode", errorCode);
     }
@@ -266,23 +413,102 @@ static jint NativeConverter_decode(JNIEnv* env, jclass, jlong address,
     const char* mySourceLimit = reinterpret_cast<const char*>(uSource.get() + sourceEnd);
     UChar* cTarget = uTarget.get() + *targetOffset;
     const UChar* cTargetLimit = uTarget.get() + targetEnd;
-    UErrorCode errorCode = U_ZERO_ERROR;
-    ucnv_toUnicode(cnv, &cTarget, cTargetLimit, &mySource, mySourceLimit, NULL, flush, &errorCode);
+    UErrorCode errorCode = toUnicode(cnv, &cTarget, cTargetLimit, &mySource, mySourceLimit, flush, &myData[2]);
     *sourceOffset = mySource - reinterpret_cast<const char*>(uSource.get()) - *sourceOffset;
     *targetOffset = cTarget - uTarget.get() - *targetOffset;
 
-    // If there was an error, count the problematic bytes.
-    if (errorCode == U_ILLEGAL_CHAR_FOUND || errorCode == U_INVALID_CHAR_FOUND) {
-        int8_t invalidByteCount = 32;
-        char invalidBytes[32] = {'\0'};
-        UErrorCode minorErrorCode = U_ZERO_ERROR;
-        ucnv_getInvalidChars(cnv, invalidBytes, &invalidByteCount, &minorErrorCode);
-        if (U_SUCCESS(minorErrorCode)) {
-            myData[2] = invalidByteCount;
+    // Managed code handles some cases; throw all other errors.
+    if (shouldCodecThrow(flush, errorCode)) {
+        maybeThrowIcuException(env, "ucnv_toUnicode", errorCode);
+    }
+    return errorCode;
+}
+
+static jint NativeConverter_decodeAddress(JNIEnv* env, jclass, jlong address,
+        jlong sourceAddress, jint sourceEnd, jcharArray target, jint targetEnd,
+        jintArray data, jboolean flush) {
+    UConverter* cnv = toUConverter(address);
+    if (cnv == NULL) {
+        maybeThrowIcuException(env, "toUConverter", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedCharArrayRW uTarget(env, target);
+    if (uTarget.get() == NULL) {
+        maybeThrowIcuException(env, "uTarget", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedIntArrayRW myData(env, data);
+    if (myData.get() == NULL) {
+        maybeThrowIcuException(env, "myData", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+
+    jint* sourceOffset = &myData[0];
+    jint* targetOffset = &myData[1];
+    const char* source = toNativeBuffer(sourceAddress);
+    const char* mySource = source + *sourceOffset;
+    UChar* cTarget = uTarget.get() + *targetOffset;
+    const UChar* cTargetLimit = uTarget.get() + targetEnd;
+    UErrorCode errorCode = toUnicode(cnv, &cTarget, cTargetLimit, &mySource, source + sourceEnd, flush, &myData[2]);
+    *sourceOffset = (mySource - source) - *sourceOffset;
+    *targetOffset = cTarget - uTarget.get() - *targetOffset;
+
+    if (shouldCodecThrow(flush, errorCode)) {
+        maybeThrowIcuException(env, "ucnv_toUnicode", errorCode);
+    }
+    return errorCode;
+}
+
+static jint NativeConverter_decodeAddresses(JNIEnv* env, jclass, jlong address,
+        jlongArray sourceAddresses, jintArray sourceByteCounts, jcharArray target, jint targetEnd,
+        jintArray data, jboolean flush) {
+    UConverter* cnv = toUConverter(address);
+    if (cnv == NULL) {
+        maybeThrowIcuException(env, "toUConverter", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedLongArrayRO addresses(env, sourceAddresses);
+    ScopedIntArrayRO byteCounts(env, sourceByteCounts);
+    if (!checkChain(env, addresses, byteCounts)) {
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedCharArrayRW uTarget(env, target);
+    if (uTarget.get() == NULL) {
+        maybeThrowIcuException(env, "uTarget", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+    ScopedIntArrayRW myData(env, data);
+    if (myData.get() == NULL) {
+        maybeThrowIcuException(env, "myData", U_ILLEGAL_ARGUMENT_ERROR);
+        return U_ILLEGAL_ARGUMENT_ERROR;
+    }
+
+    // Drain each buffer in turn. ICU holds on to a character split across buffers and finishes
+    // it from the start of the next one, so we only ask it to flush at the end of the chain.
+    jint sourceOffset = myData[0];
+    jint byteCount = 0;
+    UChar* cTarget = uTarget.get() + myData[1];
+    const UChar* cTargetLimit = uTarget.get() + targetEnd;
+    UErrorCode errorCode = U_ZERO_ERROR;
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        const char* source = toNativeBuffer(addresses[i]) + sourceOffset;
+        const char* mySource = source;
+        bool last = (i == addresses.size() - 1);
+        errorCode = toUnicode(cnv, &cTarget, cTargetLimit, &mySource,
+                source + byteCounts[i] - sourceOffset, flush && last, &myData[2]);
+        byteCount += mySource - source;
+        sourceOffset = 0;
+        if (U_FAILURE(errorCode)) {
+            break;
         }
     }
+    if (addresses.size() == 0 && flush) {
+        const char* empty = "";
+        errorCode = toUnicode(cnv, &cTarget, cTargetLimit, &empty, empty, flush, &myData[2]);
+    }
+    myData[0] = byteCount;
+    myData[1] = cTarget - uTarget.get() - myData[1];
 
-    // Managed code handles some cases; throw all other errors.
     if (shouldCodecThrow(flush, errorCode)) {
         maybeThrowIcuException(env, "ucnv_toUnicode", errorCode);
     }
@@ -500,6 +726,154 @@ static void NativeConverter_setCallbackDecode(JNIEnv* env, jclass, jlong address
     maybeThrowIcuException(env, "ucnv_setToUCallBack", errorCode);
 }
 
+/**
+ * Recycles converters, because short-lived CharsetEncoders and CharsetDecoders would otherwise
+ * each pay for a ucnv_open. For each name we keep a prototype that's never handed out and is
+ * cloned when we run dry, plus up to MAX_IDLE_PER_NAME converters passed to closeConverter,
+ * which are reset to their just-opened state first.
+ */
+class ConverterPool {
+public:
+    ConverterPool() {
+        pthread_mutex_init(&mMutex, NULL);
+    }
+
+    UConverter* take(const char* name, UErrorCode* status) {
+        {
+            ScopedPthreadMutexLock lock(&mMutex);
+            Pool* pool = findOrCreate(name, status);
+            if (U_FAILURE(*status)) {
+                return NULL;
+            }
+            if (pool != NULL) {
+                if (!pool->idle.empty()) {
+                    UConverter* cnv = pool->idle.back();
+                    pool->idle.pop_back();
+                    return cnv;
+                }
+                int32_t bufferSize = U_CNV_SAFECLONE_BUFFERSIZE;
+                UConverter* cnv = ucnv_safeClone(pool->prototype, NULL, &bufferSize, status);
+                if (U_SUCCESS(*status)) {
+                    return cnv;
+                }
+                *status = U_ZERO_ERROR;
+            }
+        }
+        // We're not pooling this name (or couldn't clone), so just open a new converter.
+        ScopedStartupEvent event("ucnv_open");
+        return ucnv_open(name, status);
+    }
+
+    void give(UConverter* cnv) {
+        if (!reset(cnv)) {
+            ucnv_close(cnv);
+            return;
+        }
+        UErrorCode status = U_ZERO_ERROR;
+        const char* name = ucnv_getName(cnv, &status);
+        if (U_SUCCESS(status)) {
+            ScopedPthreadMutexLock lock(&mMutex);
+            std::map<std::string, Pool*>::iterator it = mByInternalName.find(name);
+            if (it != mByInternalName.end() && it->second->idle.size() < MAX_IDLE_PER_NAME) {
+                it->second->idle.push_back(cnv);
+                return;
+            }
+        }
+        ucnv_close(cnv);
+    }
+
+private:
+    struct Pool {
+        UConverter* prototype;
+        std::vector<UConverter*> idle;
+    };
+
+    static const size_t MAX_POOLS = 32;
+    static const size_t MAX_IDLE_PER_NAME = 4;
+
+    // Returns the pool for 'name', or NULL if we're not pooling it. Callers must hold mMutex.
+    Pool* findOrCreate(const char* name, UErrorCode* status) {
+        std::map<std::string, Pool*>::iterator it = mByName.find(name);
+        if (it != mByName.end()) {
+            return it->second;
+        }
+        if (mByName.size() >= MAX_POOLS) {
+            return NULL;
+        }
+        UConverter* prototype;
+        {
+            ScopedStartupEvent event("ucnv_open");
+            prototype = ucnv_open(name, status);
+        }
+        if (U_FAILURE(*status)) {
+            return NULL;
+        }
+        // Several names can resolve to the same converter, so they share a pool, keyed by the
+        // converter's own name, which is also how give finds it again.
+        const char* internalName = ucnv_getName(prototype, status);
+        if (U_FAILURE(*status)) {
+            ucnv_close(prototype);
+            return NULL;
+        }
+        Pool*& pool = mByInternalName[internalName];
+        if (pool == NULL) {
+            pool = new Pool;
+            pool->prototype = prototype;
+        } else {
+            ucnv_close(prototype);
+        }
+        mByName[name] = pool;
+        return pool;
+    }
+
+    // Resets 'cnv' to its just-opened state, freeing any callback context we gave it.
+    static bool reset(UConverter* cnv) {
+        ucnv_reset(cnv);
+        UErrorCode status = U_ZERO_ERROR;
+        UConverterToUCallback oldToU;
+        const void* oldToUContext;
+        ucnv_setToUCallBack(cnv, UCNV_TO_U_CALLBACK_SUBSTITUTE, NULL, &oldToU, &oldToUContext, &status);
+        if (U_SUCCESS(status) && oldToU == CHARSET_DECODER_CALLBACK) {
+            delete reinterpret_cast<const DecoderCallbackContext*>(oldToUContext);
+        }
+        UConverterFromUCallback oldFromU;
+        const void* oldFromUContext;
+        ucnv_setFromUCallBack(cnv, UCNV_FROM_U_CALLBACK_SUBSTITUTE, NULL, &oldFromU, &oldFromUContext, &status);
+        if (U_SUCCESS(status) && oldFromU == CHARSET_ENCODER_CALLBACK) {
+            delete reinterpret_cast<const EncoderCallbackContext*>(oldFromUContext);
+        }
+        return U_SUCCESS(status);
+    }
+
+    pthread_mutex_t mMutex;
+    std::map<std::string, Pool*> mByName;
+    std::map<std::string, Pool*> mByInternalName;
+
+    // Disallow copy and assignment.
+    ConverterPool(const ConverterPool&);
+    void operator=(const ConverterPool&);
+};
+
+static ConverterPool gConverterPool;
+
+static jlong NativeConverter_openConverter(JNIEnv* env, jclass, jstring converterName) {
+    ScopedUtfChars converterNameChars(env, converterName);
+    if (converterNameChars.c_str() == NULL) {
+        return 0;
+    }
+    UErrorCode status = U_ZERO_ERROR;
+    UConverter* cnv = gConverterPool.take(converterNameChars.c_str(), &status);
+    maybeThrowIcuException(env, "ucnv_open", status);
+    return reinterpret_cast<uintptr_t>(cnv);
+}
+
+static void NativeConverter_closeConverter(JNIEnv*, jclass, jlong address) {
+    UConverter* cnv = toUConverter(address);
+    if (cnv != NULL) {
+        gConverterPool.give(cnv);
+    }
+}
+
 static jfloat NativeConverter_getAveCharsPerByte(JNIEnv* env, jclass, jlong handle) {
     return (1 / (jfloat) NativeConverter_getMaxBytesPerChar(env, NULL, handle));
 }
@@ -553,10 +927,11 @@ static jobject NativeConverter_charsetForName(JNIEnv* env, jclass, jstring chars
     }
 
     // Get ICU's canonical name for this charset.
-    const char* icuCanonicalName = getICUCanonicalName(charsetNameChars.c_str());
-    if (icuCanonicalName == NULL) {
+    std::string icuCanonicalNameString;
+    if (!getICUCanonicalName(charsetNameChars.c_str(), icuCanonicalNameString)) {
         return NULL;
     }
+    const char* icuCanonicalName = icuCanonicalNameString.c_str();
 
     // Get Java's canonical name for this charset.
     jstring javaCanonicalName = getJavaCanonicalName(env, icuCanonicalName);
@@ -608,7 +983,11 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(NativeConverter, closeConverter, "(J)V"),
     NATIVE_METHOD(NativeConverter, contains, "(Ljava/lang/String;Ljava/lang/String;)Z"),
     NATIVE_METHOD(NativeConverter, decode, "(J[BI[CI[IZ)I"),
+    NATIVE_METHOD(NativeConverter, decodeAddress, "(JJI[CI[IZ)I"),
+    NATIVE_METHOD(NativeConverter, decodeAddresses, "(J[J[I[CI[IZ)I"),
     NATIVE_METHOD(NativeConverter, encode, "(J[CI[BI[IZ)I"),
+    NATIVE_METHOD(NativeConverter, encodeAddress, "(J[CIJI[IZ)I"),
+    NATIVE_METHOD(NativeConverter, encodeAddresses, "(J[CI[J[I[IZ)I"),
     NATIVE_METHOD(NativeConverter, getAvailableCharsetNames, "()[Ljava/lang/String;"),
     NATIVE_METHOD(NativeConverter, getAveBytesPerChar, "(J)F"),
     NATIVE_METHOD(NativeConverter, getAveCharsPerByte, "(J)F"),
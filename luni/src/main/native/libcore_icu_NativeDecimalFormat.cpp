@@ -22,8 +22,10 @@
 #include "JniException.h"
 #include "ScopedJavaUnicodeString.h"
 #include "ScopedPrimitiveArray.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedStringChars.h"
 #include "ScopedUtfChars.h"
+#include "StartupProfile.h"
 #include "UniquePtr.h"
 #include "cutils/log.h"
 #include "digitlst.h"
@@ -33,6 +35,9 @@
 #include "unicode/unum.h"
 #include "unicode/ustring.h"
 #include "valueOf.h"
+#include <list>
+#include <map>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -101,6 +106,61 @@ static void NativeDecimalFormat_setDecimalFormatSymbols(JNIEnv* env, jclass, jlo
     toDecimalFormat(addr)->adoptDecimalFormatSymbols(symbols);
 }
 
+/*
+ * Opening a DecimalFormat means parsing its pattern and building its DecimalFormatSymbols,
+ * and NumberFormat.getInstance opens the same few over and over. So we keep an untouched
+ * DecimalFormat for each of the most recently opened (pattern, symbols) and hand out clones.
+ * ICU won't let two threads use one DecimalFormat at once, so every caller needs its own copy
+ * anyway; since nobody else ever sees the cached formats, setAttribute, setSymbol and friends
+ * only ever change a caller's own clone.
+ */
+typedef std::list<std::pair<UnicodeString, DecimalFormat*> > FormatLru;
+
+static const size_t MAX_CACHED_FORMATS = 16;
+
+// The most recently used entry is first.
+static pthread_mutex_t gFormatCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static FormatLru gFormatLru;
+static std::map<UnicodeString, FormatLru::iterator> gFormatCache;
+
+// Appends 's' preceded by its length, so that different lists of strings never make the same key.
+static void appendKeyString(UnicodeString& key, const UnicodeString& s) {
+    key.append(static_cast<UChar>(s.length() >> 16)).append(static_cast<UChar>(s.length()));
+    key.append(s);
+}
+
+// Returns a clone of the cached format for 'key', or NULL.
+static DecimalFormat* cloneCachedFormat(const UnicodeString& key) {
+    ScopedPthreadMutexLock lock(&gFormatCacheMutex);
+    std::map<UnicodeString, FormatLru::iterator>::iterator it = gFormatCache.find(key);
+    if (it == gFormatCache.end()) {
+        return NULL;
+    }
+    gFormatLru.splice(gFormatLru.begin(), gFormatLru, it->second);
+    // Clone under the lock, so that the entry can't be evicted and deleted meanwhile.
+    return static_cast<DecimalFormat*>(it->second->second->clone());
+}
+
+// Takes ownership of 'fmt', unless another thread has already cached 'key'.
+static void addCachedFormat(const UnicodeString& key, DecimalFormat* fmt) {
+    DecimalFormat* unused = fmt;
+    {
+        ScopedPthreadMutexLock lock(&gFormatCacheMutex);
+        if (gFormatCache.find(key) == gFormatCache.end()) {
+            if (gFormatLru.size() >= MAX_CACHED_FORMATS) {
+                unused = gFormatLru.back().second;
+                gFormatCache.erase(gFormatLru.back().first);
+                gFormatLru.pop_back();
+            } else {
+                unused = NULL;
+            }
+            gFormatLru.push_front(std::make_pair(key, fmt));
+            gFormatCache[key] = gFormatLru.begin();
+        }
+    }
+    delete unused;
+}
+
 static jlong NativeDecimalFormat_open(JNIEnv* env, jclass, jstring pattern0,
         jstring currencySymbol, jchar decimalSeparator, jchar digit, jstring exponentSeparator,
         jchar groupingSeparator, jstring infinity,
@@ -113,16 +173,46 @@ static jlong NativeDecimalFormat_open(JNIEnv* env, jclass, jstring pattern0,
     if (!pattern.valid()) {
       return 0;
     }
+    UnicodeString key;
+    {
+        ScopedJavaUnicodeString currencySymbolString(env, currencySymbol);
+        ScopedJavaUnicodeString exponentSeparatorString(env, exponentSeparator);
+        ScopedJavaUnicodeString infinityString(env, infinity);
+        ScopedJavaUnicodeString internationalCurrencySymbolString(env, internationalCurrencySymbol);
+        ScopedJavaUnicodeString nanString(env, nan);
+        if (!currencySymbolString.valid() || !exponentSeparatorString.valid() ||
+                !infinityString.valid() || !internationalCurrencySymbolString.valid() ||
+                !nanString.valid()) {
+            return 0;
+        }
+        appendKeyString(key, pattern.unicodeString());
+        appendKeyString(key, currencySymbolString.unicodeString());
+        appendKeyString(key, exponentSeparatorString.unicodeString());
+        appendKeyString(key, infinityString.unicodeString());
+        appendKeyString(key, internationalCurrencySymbolString.unicodeString());
+        appendKeyString(key, nanString.unicodeString());
+        key.append(decimalSeparator).append(digit).append(groupingSeparator).append(minusSign);
+        key.append(monetaryDecimalSeparator).append(patternSeparator).append(percent);
+        key.append(perMill).append(zeroDigit);
+    }
+    DecimalFormat* fmt = cloneCachedFormat(key);
+    if (fmt != NULL) {
+        return reinterpret_cast<uintptr_t>(fmt);
+    }
+    ScopedStartupEvent event("DecimalFormat::DecimalFormat");
     DecimalFormatSymbols* symbols = makeDecimalFormatSymbols(env,
             currencySymbol, decimalSeparator, digit, exponentSeparator, groupingSeparator,
             infinity, internationalCurrencySymbol, minusSign,
             monetaryDecimalSeparator, nan, patternSeparator, percent, perMill,
             zeroDigit);
-    DecimalFormat* fmt = new DecimalFormat(pattern.unicodeString(), symbols, parseError, status);
+    fmt = new DecimalFormat(pattern.unicodeString(), symbols, parseError, status);
     if (fmt == NULL) {
         delete symbols;
     }
-    maybeThrowIcuException(env, "DecimalFormat::DecimalFormat", status);
+    if (maybeThrowIcuException(env, "DecimalFormat::DecimalFormat", status)) {
+        return reinterpret_cast<uintptr_t>(fmt);
+    }
+    addCachedFormat(key, static_cast<DecimalFormat*>(fmt->clone()));
     return reinterpret_cast<uintptr_t>(fmt);
 }
 
@@ -268,6 +358,37 @@ static jcharArray NativeDecimalFormat_formatDigitList(JNIEnv* env, jclass, jlong
     return format(env, addr, fpIter, sp);
 }
 
+// Formats straight into the caller's array, without field positions. The result is usually
+// short enough to stay in the UnicodeString's own buffer, so nothing is allocated.
+template <typename T>
+static jint formatInto(JNIEnv* env, jlong addr, T val, jcharArray javaDst, jint offset) {
+    jsize dstLength = env->GetArrayLength(javaDst);
+    if (offset < 0 || offset > dstLength) {
+        jniThrowExceptionFmt(env, "java/lang/ArrayIndexOutOfBoundsException",
+                "length=%d; offset=%d", dstLength, offset);
+        return 0;
+    }
+    UErrorCode status = U_ZERO_ERROR;
+    UnicodeString str;
+    toDecimalFormat(addr)->format(val, str, NULL, status);
+    if (maybeThrowIcuException(env, "DecimalFormat::format", status)) {
+        return 0;
+    }
+    // If it doesn't fit, the caller retries with an array of the returned length.
+    if (str.length() <= dstLength - offset) {
+        env->SetCharArrayRegion(javaDst, offset, str.length(), str.getBuffer());
+    }
+    return str.length();
+}
+
+static jint NativeDecimalFormat_formatLongInto(JNIEnv* env, jclass, jlong addr, jlong value, jcharArray dst, jint offset) {
+    return formatInto(env, addr, value, dst, offset);
+}
+
+static jint NativeDecimalFormat_formatDoubleInto(JNIEnv* env, jclass, jlong addr, jdouble value, jcharArray dst, jint offset) {
+    return formatInto(env, addr, value, dst, offset);
+}
+
 static jobject newBigDecimal(JNIEnv* env, const char* value, jsize len) {
     static jmethodID gBigDecimal_init = env->GetMethodID(JniConstants::bigDecimalClass, "<init>", "(Ljava/lang/String;)V");
 
@@ -346,7 +467,9 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(NativeDecimalFormat, cloneImpl, "(J)J"),
     NATIVE_METHOD(NativeDecimalFormat, close, "(J)V"),
     NATIVE_METHOD(NativeDecimalFormat, formatDouble, "(JDLlibcore/icu/NativeDecimalFormat$FieldPositionIterator;)[C"),
+    NATIVE_METHOD(NativeDecimalFormat, formatDoubleInto, "(JD[CI)I"),
     NATIVE_METHOD(NativeDecimalFormat, formatLong, "(JJLlibcore/icu/NativeDecimalFormat$FieldPositionIterator;)[C"),
+    NATIVE_METHOD(NativeDecimalFormat, formatLongInto, "(JJ[CI)I"),
     NATIVE_METHOD(NativeDecimalFormat, formatDigitList, "(JLjava/lang/String;Llibcore/icu/NativeDecimalFormat$FieldPositionIterator;)[C"),
     NATIVE_METHOD(NativeDecimalFormat, getAttribute, "(JI)I"),
     NATIVE_METHOD(NativeDecimalFormat, getTextAttribute, "(JI)Ljava/lang/String;"),
@@ -21,35 +21,140 @@
 #include "JniConstants.h"
 #include "JniException.h"
 #include "ScopedJavaUnicodeString.h"
+#include "ScopedLocalRef.h"
+#include "ScopedStringChars.h"
+#include "unicode/normalizer2.h"
 #include "unicode/normlzr.h"
 
-static jstring NativeNormalizer_normalizeImpl(JNIEnv* env, jclass, jstring s, jint intMode) {
-  ScopedJavaUnicodeString src(env, s);
-  if (!src.valid()) {
+// Maps the old UNormalizationMode values the Java side uses to the shared Normalizer2
+// instances, which have the quick-check and span API.
+static const Normalizer2* toNormalizer2(JNIEnv* env, jint intMode) {
+  UErrorCode status = U_ZERO_ERROR;
+  const Normalizer2* result = NULL;
+  switch (static_cast<UNormalizationMode>(intMode)) {
+  case UNORM_NFC:
+    result = Normalizer2::getInstance(NULL, "nfc", UNORM2_COMPOSE, status);
+    break;
+  case UNORM_NFD:
+    result = Normalizer2::getInstance(NULL, "nfc", UNORM2_DECOMPOSE, status);
+    break;
+  case UNORM_NFKC:
+    result = Normalizer2::getInstance(NULL, "nfkc", UNORM2_COMPOSE, status);
+    break;
+  case UNORM_NFKD:
+    result = Normalizer2::getInstance(NULL, "nfkc", UNORM2_DECOMPOSE, status);
+    break;
+  default:
+    jniThrowExceptionFmt(env, "java/lang/IllegalArgumentException", "mode=%d", intMode);
+    return NULL;
+  }
+  if (maybeThrowIcuException(env, "Normalizer2::getInstance", status)) {
+    return NULL;
+  }
+  return result;
+}
+
+// ASCII is unchanged by all four normalization forms.
+static bool isAscii(const jchar* chars, size_t length) {
+  jchar bits = 0;
+  for (size_t i = 0; i < length; ++i) {
+    bits |= chars[i];
+  }
+  return (bits & ~0x7f) == 0;
+}
+
+// Returns 'javaString' itself if it's already normalized. Otherwise only the part from the
+// first char that might need work onwards goes through the normalizer.
+static jstring normalize(JNIEnv* env, jstring javaString, const Normalizer2* normalizer) {
+  ScopedStringChars chars(env, javaString);
+  if (chars.get() == NULL) {
     return NULL;
   }
-  UNormalizationMode mode = static_cast<UNormalizationMode>(intMode);
+  if (isAscii(chars.get(), chars.size())) {
+    return javaString;
+  }
+  // A read-only alias of the Java chars, so nothing is copied until we know we need to.
+  const UnicodeString src(false, chars.get(), chars.size());
   UErrorCode status = U_ZERO_ERROR;
-  UnicodeString dst;
-  Normalizer::normalize(src.unicodeString(), mode, 0, dst, status);
-  maybeThrowIcuException(env, "Normalizer::normalize", status);
-  return dst.isBogus() ? NULL : env->NewString(dst.getBuffer(), dst.length());
+  int32_t spanEnd = normalizer->spanQuickCheckYes(src, status);
+  if (maybeThrowIcuException(env, "Normalizer2::spanQuickCheckYes", status)) {
+    return NULL;
+  }
+  if (spanEnd == src.length()) {
+    return javaString;
+  }
+  UnicodeString dst(src, 0, spanEnd);
+  normalizer->normalizeSecondAndAppend(dst, src.tempSubString(spanEnd), status);
+  if (maybeThrowIcuException(env, "Normalizer2::normalizeSecondAndAppend", status)) {
+    return NULL;
+  }
+  return dst == src ? javaString : env->NewString(dst.getBuffer(), dst.length());
+}
+
+static jstring NativeNormalizer_normalizeImpl(JNIEnv* env, jclass, jstring s, jint intMode) {
+  if (s == NULL) {
+    jniThrowNullPointerException(env, NULL);
+    return NULL;
+  }
+  const Normalizer2* normalizer = toNormalizer2(env, intMode);
+  if (normalizer == NULL) {
+    return NULL;
+  }
+  return normalize(env, s, normalizer);
+}
+
+static void NativeNormalizer_normalizeAllImpl(JNIEnv* env, jclass, jobjectArray javaStrings, jint intMode) {
+  if (javaStrings == NULL) {
+    jniThrowNullPointerException(env, NULL);
+    return;
+  }
+  const Normalizer2* normalizer = toNormalizer2(env, intMode);
+  if (normalizer == NULL) {
+    return;
+  }
+  jsize count = env->GetArrayLength(javaStrings);
+  for (jsize i = 0; i < count; ++i) {
+    ScopedLocalRef<jstring> string(env, reinterpret_cast<jstring>(env->GetObjectArrayElement(javaStrings, i)));
+    if (string.get() == NULL) {
+      continue;
+    }
+    jstring result = normalize(env, string.get(), normalizer);
+    if (result == NULL) {
+      return;
+    }
+    if (result != string.get()) {
+      env->SetObjectArrayElement(javaStrings, i, result);
+      env->DeleteLocalRef(result);
+    }
+  }
 }
 
 static jboolean NativeNormalizer_isNormalizedImpl(JNIEnv* env, jclass, jstring s, jint intMode) {
-  ScopedJavaUnicodeString src(env, s);
-  if (!src.valid()) {
+  if (s == NULL) {
+    jniThrowNullPointerException(env, NULL);
+    return JNI_FALSE;
+  }
+  const Normalizer2* normalizer = toNormalizer2(env, intMode);
+  if (normalizer == NULL) {
+    return JNI_FALSE;
+  }
+  ScopedStringChars chars(env, s);
+  if (chars.get() == NULL) {
     return JNI_FALSE;
   }
-  UNormalizationMode mode = static_cast<UNormalizationMode>(intMode);
+  if (isAscii(chars.get(), chars.size())) {
+    return JNI_TRUE;
+  }
+  const UnicodeString src(false, chars.get(), chars.size());
   UErrorCode status = U_ZERO_ERROR;
-  UBool result = Normalizer::isNormalized(src.unicodeString(), mode, status);
-  maybeThrowIcuException(env, "Normalizer::isNormalized", status);
+  UBool result = normalizer->isNormalized(src, status);
+  maybeThrowIcuException(env, "Normalizer2::isNormalized", status);
   return result;
 }
 
 static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(NativeNormalizer, normalizeImpl, "(Ljava/lang/String;I)Ljava/lang/String;"),
+  NATIVE_METHOD(NativeNormalizer, normalizeAllImpl, "([Ljava/lang/String;I)V"),
   NATIVE_METHOD(NativeNormalizer, isNormalizedImpl, "(Ljava/lang/String;I)Z"),
 };
 void register_libcore_icu_NativeNormalizer(JNIEnv* env) {
@@ -21,6 +21,7 @@
 #include "JniConstants.h"
 #include "JniException.h"
 #include "ScopedUtfChars.h"
+#include "StartupProfile.h"
 #include "unicode/plurrule.h"
 
 #include <string>
@@ -50,6 +51,7 @@ static jlong NativePluralRules_forLocaleImpl(JNIEnv* env, jclass, jstring javaLo
 
     Locale locale = Locale::createFromName(localeName.c_str());
     UErrorCode status = U_ZERO_ERROR;
+    ScopedStartupEvent event("PluralRules::forLocale");
     PluralRules* result = PluralRules::forLocale(locale, status);
     maybeThrowIcuException(env, "PluralRules::forLocale", status);
     return reinterpret_cast<uintptr_t>(result);
@@ -20,14 +20,30 @@
 #include "JNIHelp.h"
 #include "JniConstants.h"
 #include "JniException.h"
+#include "ScopedFd.h"
 #include "ScopedJavaUnicodeString.h"
 #include "ScopedLocalRef.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedUtfChars.h"
 #include "UniquePtr.h"
+#include "cutils/log.h"
 #include "unicode/calendar.h"
 #include "unicode/timezone.h"
 #include "unicode/tznames.h"
 
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
 static bool isUtc(const UnicodeString& id) {
   static const UnicodeString kEtcUct("Etc/UCT", 7, US_INV);
   static const UnicodeString kEtcUtc("Etc/UTC", 7, US_INV);
@@ -43,33 +59,291 @@ static bool isUtc(const UnicodeString& id) {
       id == kUct || id == kUtc || id == kUniversal || id == kZulu;
 }
 
-static void setStringArrayElement(JNIEnv* env, jobjectArray array, int i, const UnicodeString& s) {
-  // Fill in whatever we got. We don't use the display names if they're "GMT[+-]xx:xx"
-  // because icu4c doesn't use the up-to-date time zone transition data, so it gets these
-  // wrong. TimeZone.getDisplayName creates accurate names on demand.
-  // TODO: investigate whether it's worth doing that work once in the Java wrapper instead of on-demand.
+// ICU's display names for one zone, in the order of the columns after the id in the
+// DateFormatSymbols.getZoneStrings rows. A bogus name means there's nothing to fill in.
+struct ZoneNames {
+  UnicodeString names[4];
+};
+
+static const UTimeZoneNameType kNameTypes[4] = {
+  UTZNM_LONG_STANDARD, UTZNM_SHORT_STANDARD, UTZNM_LONG_DAYLIGHT, UTZNM_SHORT_DAYLIGHT
+};
+
+static void getZoneNames(const TimeZoneNames& names, const UnicodeString& zone_id, UDate now, ZoneNames& result) {
+  static const UnicodeString kUtc("UTC", 3, US_INV);
+  static const UnicodeString pacific_apia("Pacific/Apia", 12, US_INV);
   static const UnicodeString kGmt("GMT", 3, US_INV);
-  if (!s.isBogus() && !s.startsWith(kGmt)) {
-    ScopedLocalRef<jstring> javaString(env, env->NewString(s.getBuffer(), s.length()));
-    env->SetObjectArrayElement(array, i, javaString.get());
+
+  for (size_t i = 0; i < 4; ++i) {
+    names.getDisplayName(zone_id, kNameTypes[i], now, result.names[i]);
+  }
+  UnicodeString& long_dst(result.names[2]);
+
+  if (isUtc(zone_id)) {
+    // ICU doesn't have names for the UTC zones; it just says "GMT+00:00" for both
+    // long and short names. We don't want this. The best we can do is use "UTC"
+    // for everything (since we don't know how to say "Universal Coordinated Time" in
+    // every language).
+    // TODO: check CLDR doesn't actually have this somewhere.
+    for (size_t i = 0; i < 4; ++i) {
+      result.names[i] = kUtc;
+    }
+  } else if (zone_id == pacific_apia) {
+    // icu4c 50 doesn't know Samoa has DST yet. http://b/7955614
+    if (long_dst.isBogus()) {
+      long_dst = "Samoa Daylight Time";
+    }
+  }
+
+  // We don't use the display names if they're "GMT[+-]xx:xx" because icu4c doesn't use the
+  // up-to-date time zone transition data, so it gets these wrong. TimeZone.getDisplayName
+  // creates accurate names on demand.
+  // TODO: investigate whether it's worth doing that work once in the Java wrapper instead of on-demand.
+  for (size_t i = 0; i < 4; ++i) {
+    if (result.names[i].startsWith(kGmt)) {
+      result.names[i].setToBogus();
+    }
   }
 }
 
-static void TimeZoneNames_fillZoneStrings(JNIEnv* env, jclass, jstring localeName, jobjectArray result) {
-  Locale locale = getLocale(env, localeName);
+// Looking the names up is almost all of the cost of getZoneStrings, and each zone is
+// independent, so the lookups are shared between a few short-lived threads. Like
+// NativeBN's batches, the calling thread does its share of the work.
+static const size_t kZonesPerThread = 64;
+static const size_t kMaxThreads = 4;
+static const size_t kZonesPerChunk = 16;
+
+struct ZoneNamesQueue {
+  const Locale* locale;
+  UDate now;
+  const std::vector<UnicodeString>* ids;
+  std::vector<ZoneNames>* results;
+  pthread_mutex_t mutex;
+  size_t next;
+  UErrorCode status;
+};
 
+static void* zoneNamesWorkerMain(void* arg) {
+  ZoneNamesQueue* queue = reinterpret_cast<ZoneNamesQueue*>(arg);
+  // Each thread has its own TimeZoneNames; ICU shares the underlying data between them.
   UErrorCode status = U_ZERO_ERROR;
-  UniquePtr<TimeZoneNames> names(TimeZoneNames::createInstance(locale, status));
-  if (maybeThrowIcuException(env, "TimeZoneNames::createInstance", status)) {
+  UniquePtr<TimeZoneNames> names(TimeZoneNames::createInstance(*queue->locale, status));
+  while (true) {
+    size_t begin;
+    {
+      ScopedPthreadMutexLock lock(&queue->mutex);
+      if (U_FAILURE(status) && U_SUCCESS(queue->status)) {
+        queue->status = status;
+      }
+      if (U_FAILURE(queue->status) || queue->next >= queue->ids->size()) {
+        break;
+      }
+      begin = queue->next;
+      queue->next += kZonesPerChunk;
+    }
+    size_t end = std::min(begin + kZonesPerChunk, queue->ids->size());
+    for (size_t i = begin; i < end; ++i) {
+      getZoneNames(*names, (*queue->ids)[i], queue->now, (*queue->results)[i]);
+    }
+  }
+  return NULL;
+}
+
+static UErrorCode computeZoneNames(const Locale& locale, UDate now,
+                                   const std::vector<UnicodeString>& ids,
+                                   std::vector<ZoneNames>& results) {
+  ZoneNamesQueue queue;
+  queue.locale = &locale;
+  queue.now = now;
+  queue.ids = &ids;
+  queue.results = &results;
+  pthread_mutex_init(&queue.mutex, NULL);
+  queue.next = 0;
+  queue.status = U_ZERO_ERROR;
+
+  long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t threadCount = std::min(ids.size() / kZonesPerThread + 1, kMaxThreads);
+  threadCount = std::max<size_t>(1, std::min<size_t>(threadCount, cpuCount > 0 ? cpuCount : 1));
+  std::vector<pthread_t> threads;
+  for (size_t i = 1; i < threadCount; ++i) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, zoneNamesWorkerMain, &queue) == 0) {
+      threads.push_back(thread);
+    }
+  }
+  zoneNamesWorkerMain(&queue);
+  for (size_t i = 0; i < threads.size(); ++i) {
+    pthread_join(threads[i], NULL);
+  }
+  pthread_mutex_destroy(&queue.mutex);
+  return queue.status;
+}
+
+// The on-disk cache is a private, native-endian file: a header, then for each zone its id, its
+// metazone and its four names, each as a uint32_t length (kNoName if there is no name) and
+// that many UTF-16 chars, padded to a multiple of four bytes. It's only valid for the ICU data
+// that wrote it, so the Java side puts the ICU and CLDR versions and the locale in the file name.
+// The ids are stored too, so a tzdata update that changes the set of zones just means a miss.
+// Most names are really the names of the zone's metazone at the time of the lookup, so a zone
+// that has since moved to another metazone means a miss as well.
+static const char kCacheMagic[8] = { 'T', 'Z', 'N', 'A', 'M', 'E', 'S', '2' };
+static const uint32_t kNoName = 0xffffffff;
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t zoneCount;
+  uint32_t reserved;
+};
+
+static void appendCacheString(std::string& out, const UnicodeString& s) {
+  uint32_t length = s.isBogus() ? kNoName : s.length();
+  out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+  if (length != kNoName) {
+    out.append(reinterpret_cast<const char*>(s.getBuffer()), length * sizeof(UChar));
+    if (length % 2 != 0) {
+      out.append(sizeof(UChar), '\0');
+    }
+  }
+}
+
+static void writeCache(const std::string& path, const std::vector<UnicodeString>& ids,
+                       const std::vector<UnicodeString>& metaZones,
+                       const std::vector<ZoneNames>& results) {
+  std::string out;
+  CacheHeader header;
+  memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.zoneCount = ids.size();
+  header.reserved = 0;
+  out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (size_t i = 0; i < ids.size(); ++i) {
+    appendCacheString(out, ids[i]);
+    appendCacheString(out, metaZones[i]);
+    for (size_t j = 0; j < 4; ++j) {
+      appendCacheString(out, results[i].names[j]);
+    }
+  }
+
+  // Write to a private temporary file and rename it into place, so that a concurrent reader
+  // (another process starting up, say) sees either no file or a complete one.
+  char suffix[32];
+  snprintf(suffix, sizeof(suffix), ".%d.tmp", getpid());
+  std::string tmpPath(path + suffix);
+  ScopedFd fd(open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+  if (fd.get() == -1) {
+    ALOGW("Couldn't create time zone names cache '%s': %s", tmpPath.c_str(), strerror(errno));
     return;
   }
+  const char* p = out.data();
+  size_t remaining = out.size();
+  while (remaining > 0) {
+    ssize_t rc = TEMP_FAILURE_RETRY(write(fd.get(), p, remaining));
+    if (rc == -1) {
+      ALOGW("Couldn't write time zone names cache '%s': %s", tmpPath.c_str(), strerror(errno));
+      unlink(tmpPath.c_str());
+      return;
+    }
+    p += rc;
+    remaining -= rc;
+  }
+  if (rename(tmpPath.c_str(), path.c_str()) == -1) {
+    ALOGW("Couldn't rename time zone names cache '%s': %s", tmpPath.c_str(), strerror(errno));
+    unlink(tmpPath.c_str());
+  }
+}
 
-  const UDate now(Calendar::getNow());
+// Reads one length-prefixed string from the mapped cache, advancing 'p'. Returns false if the
+// file is truncated.
+static bool readCacheString(const char*& p, const char* end, const UChar*& chars, uint32_t& length) {
+  if (static_cast<size_t>(end - p) < sizeof(length)) {
+    return false;
+  }
+  memcpy(&length, p, sizeof(length));
+  p += sizeof(length);
+  if (length == kNoName) {
+    chars = NULL;
+    return true;
+  }
+  size_t byteCount = (length + (length % 2)) * sizeof(UChar);
+  if (static_cast<size_t>(end - p) < byteCount) {
+    return false;
+  }
+  chars = reinterpret_cast<const UChar*>(p);
+  p += byteCount;
+  return true;
+}
 
-  static const UnicodeString kUtc("UTC", 3, US_INV);
-  static const UnicodeString pacific_apia("Pacific/Apia", 12, US_INV);
+// Fills 'results' from the cache file at 'path' if it exists and has exactly the zones in 'ids',
+// each still in the metazone given by 'metaZones'.
+static bool readCache(const std::string& path, const std::vector<UnicodeString>& ids,
+                      const std::vector<UnicodeString>& metaZones,
+                      std::vector<ZoneNames>& results) {
+  ScopedFd fd(open(path.c_str(), O_RDONLY));
+  if (fd.get() == -1) {
+    return false;
+  }
+  struct stat sb;
+  if (fstat(fd.get(), &sb) == -1 || static_cast<size_t>(sb.st_size) < sizeof(CacheHeader)) {
+    return false;
+  }
+  void* data = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+
+  bool valid = true;
+  const char* p = reinterpret_cast<const char*>(data);
+  const char* end = p + sb.st_size;
+  CacheHeader header;
+  memcpy(&header, p, sizeof(header));
+  p += sizeof(header);
+  if (memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header.zoneCount != ids.size()) {
+    valid = false;
+  }
+  for (size_t i = 0; valid && i < ids.size(); ++i) {
+    const UChar* chars;
+    uint32_t length;
+    if (!readCacheString(p, end, chars, length) || chars == NULL ||
+        ids[i].compare(chars, length) != 0) {
+      valid = false;
+      break;
+    }
+    if (!readCacheString(p, end, chars, length) ||
+        (chars == NULL) != metaZones[i].isBogus() ||
+        (chars != NULL && metaZones[i].compare(chars, length) != 0)) {
+      valid = false;
+      break;
+    }
+    for (size_t j = 0; j < 4; ++j) {
+      if (!readCacheString(p, end, chars, length)) {
+        valid = false;
+        break;
+      }
+      if (chars == NULL) {
+        results[i].names[j].setToBogus();
+      } else {
+        results[i].names[j].setTo(chars, length);
+      }
+    }
+  }
+  munmap(data, sb.st_size);
+  return valid && p == end;
+}
+
+static void setStringArrayElement(JNIEnv* env, jobjectArray array, int i, const UnicodeString& s) {
+  // Fill in whatever we got.
+  if (!s.isBogus()) {
+    ScopedLocalRef<jstring> javaString(env, env->NewString(s.getBuffer(), s.length()));
+    env->SetObjectArrayElement(array, i, javaString.get());
+  }
+}
 
+static void TimeZoneNames_fillZoneStrings(JNIEnv* env, jclass, jstring localeName, jobjectArray result,
+                                          jstring javaCachePath) {
+  Locale locale = getLocale(env, localeName);
+
+  // Collect the ids up front, since the worker threads can't call JNI.
   size_t id_count = env->GetArrayLength(result);
+  std::vector<UnicodeString> ids(id_count);
   for (size_t i = 0; i < id_count; ++i) {
     ScopedLocalRef<jobjectArray> java_row(env,
                                           reinterpret_cast<jobjectArray>(env->GetObjectArrayElement(result, i)));
@@ -79,39 +353,53 @@ static void TimeZoneNames_fillZoneStrings(JNIEnv* env, jclass, jstring localeNam
     if (!zone_id.valid()) {
       return;
     }
+    ids[i] = zone_id.unicodeString();
+  }
+
+  std::string cachePath;
+  if (javaCachePath != NULL) {
+    ScopedUtfChars cachePathChars(env, javaCachePath);
+    if (cachePathChars.c_str() == NULL) {
+      return;
+    }
+    cachePath = cachePathChars.c_str();
+  }
 
-    UnicodeString long_std;
-    names->getDisplayName(zone_id.unicodeString(), UTZNM_LONG_STANDARD, now, long_std);
-    UnicodeString short_std;
-    names->getDisplayName(zone_id.unicodeString(), UTZNM_SHORT_STANDARD, now, short_std);
-    UnicodeString long_dst;
-    names->getDisplayName(zone_id.unicodeString(), UTZNM_LONG_DAYLIGHT, now, long_dst);
-    UnicodeString short_dst;
-    names->getDisplayName(zone_id.unicodeString(), UTZNM_SHORT_DAYLIGHT, now, short_dst);
-
-    if (isUtc(zone_id.unicodeString())) {
-      // ICU doesn't have names for the UTC zones; it just says "GMT+00:00" for both
-      // long and short names. We don't want this. The best we can do is use "UTC"
-      // for everything (since we don't know how to say "Universal Coordinated Time" in
-      // every language).
-      // TODO: check CLDR doesn't actually have this somewhere.
-      long_std = short_std = long_dst = short_dst = kUtc;
-    } else if (zone_id.unicodeString() == pacific_apia) {
-      // icu4c 50 doesn't know Samoa has DST yet. http://b/7955614
-      if (long_dst.isBogus()) {
-        long_dst = "Samoa Daylight Time";
-      }
+  const UDate now(Calendar::getNow());
+  std::vector<UnicodeString> metaZones(id_count);
+  if (!cachePath.empty()) {
+    UErrorCode status = U_ZERO_ERROR;
+    UniquePtr<TimeZoneNames> timeZoneNames(TimeZoneNames::createInstance(locale, status));
+    if (maybeThrowIcuException(env, "TimeZoneNames::createInstance", status)) {
+      return;
+    }
+    for (size_t i = 0; i < id_count; ++i) {
+      timeZoneNames->getMetaZoneID(ids[i], now, metaZones[i]);
+    }
+  }
+
+  std::vector<ZoneNames> names(id_count);
+  if (cachePath.empty() || !readCache(cachePath, ids, metaZones, names)) {
+    UErrorCode status = computeZoneNames(locale, now, ids, names);
+    if (maybeThrowIcuException(env, "TimeZoneNames::createInstance", status)) {
+      return;
     }
+    if (!cachePath.empty()) {
+      writeCache(cachePath, ids, metaZones, names);
+    }
+  }
 
-    setStringArrayElement(env, java_row.get(), 1, long_std);
-    setStringArrayElement(env, java_row.get(), 2, short_std);
-    setStringArrayElement(env, java_row.get(), 3, long_dst);
-    setStringArrayElement(env, java_row.get(), 4, short_dst);
+  for (size_t i = 0; i < id_count; ++i) {
+    ScopedLocalRef<jobjectArray> java_row(env,
+                                          reinterpret_cast<jobjectArray>(env->GetObjectArrayElement(result, i)));
+    for (size_t j = 0; j < 4; ++j) {
+      setStringArrayElement(env, java_row.get(), j + 1, names[i].names[j]);
+    }
   }
 }
 
 static JNINativeMethod gMethods[] = {
-  NATIVE_METHOD(TimeZoneNames, fillZoneStrings, "(Ljava/lang/String;[[Ljava/lang/String;)V"),
+  NATIVE_METHOD(TimeZoneNames, fillZoneStrings, "(Ljava/lang/String;[[Ljava/lang/String;Ljava/lang/String;)V"),
 };
 void register_libcore_icu_TimeZoneNames(JNIEnv* env) {
   jniRegisterNativeMethods(env, "libcore/icu/TimeZoneNames", gMethods, NELEM(gMethods));
@@ -20,21 +20,85 @@
 #include "JNIHelp.h"
 #include "JniConstants.h"
 #include "JniException.h"
-#include "ScopedJavaUnicodeString.h"
+#include "ScopedLocalRef.h"
+#include "ScopedPthreadMutexLock.h"
+#include "ScopedStringChars.h"
+#include "ScopedUtfChars.h"
 #include "unicode/translit.h"
 
+#include <list>
+#include <map>
+#include <pthread.h>
+#include <string>
+
 static Transliterator* fromPeer(jlong peer) {
   return reinterpret_cast<Transliterator*>(static_cast<uintptr_t>(peer));
 }
 
+// Building a rule-based transliterator such as Any-Latin means compiling its rules, which takes
+// milliseconds, but a clone shares the compiled data. So we keep the most recently used few by
+// id and only ever hand out clones; the cached instances themselves are never used to
+// transliterate, and so never change.
+typedef std::list<std::pair<std::string, Transliterator*> > TransliteratorLru;
+static const size_t MAX_CACHED_TRANSLITERATORS = 8;
+
+// The most recently used entry is first.
+static pthread_mutex_t gTransliteratorCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static TransliteratorLru gTransliteratorLru;
+static std::map<std::string, TransliteratorLru::iterator> gTransliteratorCache;
+
+// Returns a clone of the cached transliterator for 'id', or NULL.
+static Transliterator* cloneCachedTransliterator(const std::string& id) {
+  ScopedPthreadMutexLock lock(&gTransliteratorCacheMutex);
+  std::map<std::string, TransliteratorLru::iterator>::iterator it = gTransliteratorCache.find(id);
+  if (it == gTransliteratorCache.end()) {
+    return NULL;
+  }
+  gTransliteratorLru.splice(gTransliteratorLru.begin(), gTransliteratorLru, it->second);
+  // Clone under the lock, so that the entry can't be evicted and deleted meanwhile.
+  return it->second->second->clone();
+}
+
+// Takes ownership of 't', unless another thread has already cached that id.
+static void addCachedTransliterator(const std::string& id, Transliterator* t) {
+  Transliterator* unused = t;
+  {
+    ScopedPthreadMutexLock lock(&gTransliteratorCacheMutex);
+    if (gTransliteratorCache.find(id) == gTransliteratorCache.end()) {
+      if (gTransliteratorLru.size() >= MAX_CACHED_TRANSLITERATORS) {
+        unused = gTransliteratorLru.back().second;
+        gTransliteratorCache.erase(gTransliteratorLru.back().first);
+        gTransliteratorLru.pop_back();
+      } else {
+        unused = NULL;
+      }
+      gTransliteratorLru.push_front(std::make_pair(id, t));
+      gTransliteratorCache[id] = gTransliteratorLru.begin();
+    }
+  }
+  delete unused;
+}
+
 static jlong Transliterator_create(JNIEnv* env, jclass, jstring javaId) {
-  ScopedJavaUnicodeString id(env, javaId);
-  if (!id.valid()) {
+  ScopedUtfChars idChars(env, javaId);
+  if (idChars.c_str() == NULL) {
     return 0;
   }
-  UErrorCode status = U_ZERO_ERROR;
-  Transliterator* t = Transliterator::createInstance(id.unicodeString(), UTRANS_FORWARD, status);
-  if (maybeThrowIcuException(env, "Transliterator::createInstance", status)) {
+  std::string key(idChars.c_str());
+  Transliterator* t = cloneCachedTransliterator(key);
+  if (t == NULL) {
+    UErrorCode status = U_ZERO_ERROR;
+    UnicodeString id(UnicodeString::fromUTF8(key));
+    Transliterator* prototype = Transliterator::createInstance(id, UTRANS_FORWARD, status);
+    if (maybeThrowIcuException(env, "Transliterator::createInstance", status)) {
+      delete prototype;
+      return 0;
+    }
+    t = prototype->clone();
+    addCachedTransliterator(key, prototype);
+  }
+  if (t == NULL) {
+    jniThrowOutOfMemoryError(env, NULL);
     return 0;
   }
   return reinterpret_cast<uintptr_t>(t);
@@ -50,16 +114,52 @@ static jobjectArray Transliterator_getAvailableIDs(JNIEnv* env, jclass) {
   return fromStringEnumeration(env, status, "Transliterator::getAvailableIDs", e);
 }
 
+// Transliterates 'javaString' using 'buffer' as scratch space, and returns 'javaString' itself
+// if nothing changed.
+static jstring transliterate(JNIEnv* env, Transliterator* t, jstring javaString, UnicodeString& buffer) {
+  ScopedStringChars chars(env, javaString);
+  if (chars.get() == NULL) {
+    return NULL;
+  }
+  buffer.setTo(chars.get(), chars.size());
+  t->transliterate(buffer);
+  if (buffer.compare(chars.get(), chars.size()) == 0) {
+    return javaString;
+  }
+  return env->NewString(buffer.getBuffer(), buffer.length());
+}
+
 static jstring Transliterator_transliterate(JNIEnv* env, jclass, jlong peer, jstring javaString) {
-  Transliterator* t = fromPeer(peer);
-  ScopedJavaUnicodeString string(env, javaString);
-  if (!string.valid()) {
+  if (javaString == NULL) {
+    jniThrowNullPointerException(env, NULL);
     return NULL;
   }
+  UnicodeString buffer;
+  return transliterate(env, fromPeer(peer), javaString, buffer);
+}
 
-  UnicodeString& s(string.unicodeString());
-  t->transliterate(s);
-  return env->NewString(s.getBuffer(), s.length());
+static void Transliterator_transliterateAll(JNIEnv* env, jclass, jlong peer, jobjectArray javaStrings) {
+  if (javaStrings == NULL) {
+    jniThrowNullPointerException(env, NULL);
+    return;
+  }
+  Transliterator* t = fromPeer(peer);
+  UnicodeString buffer;
+  jsize count = env->GetArrayLength(javaStrings);
+  for (jsize i = 0; i < count; ++i) {
+    ScopedLocalRef<jstring> string(env, reinterpret_cast<jstring>(env->GetObjectArrayElement(javaStrings, i)));
+    if (string.get() == NULL) {
+      continue;
+    }
+    jstring result = transliterate(env, t, string.get(), buffer);
+    if (result == NULL) {
+      return;
+    }
+    if (result != string.get()) {
+      env->SetObjectArrayElement(javaStrings, i, result);
+      env->DeleteLocalRef(result);
+    }
+  }
 }
 
 static JNINativeMethod gMethods[] = {
@@ -67,6 +167,7 @@ static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(Transliterator, destroy, "(J)V"),
   NATIVE_METHOD(Transliterator, getAvailableIDs, "()[Ljava/lang/String;"),
   NATIVE_METHOD(Transliterator, transliterate, "(JLjava/lang/String;)Ljava/lang/String;"),
+  NATIVE_METHOD(Transliterator, transliterateAll, "(J[Ljava/lang/String;)V"),
 };
 void register_libcore_icu_Transliterator(JNIEnv* env) {
   jniRegisterNativeMethods(env, "libcore/icu/Transliterator", gMethods, NELEM(gMethods));
@@ -0,0 +1,583 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AsyncResolver"
+
+#include "AsynchronousSocketCloseMonitor.h"
+#include "cutils/log.h"
+#include "JNIHelp.h"
+#include "JniConstants.h"
+#include "JniException.h"
+#include "NetworkUtilities.h"
+#include "ScopedLocalRef.h"
+#include "ScopedPthreadMutexLock.h"
+#include "ScopedUtfChars.h"
+#include "UniquePtr.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <deque>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+// Lookups are slow because of the network, not the CPU, so a few threads go a long way.
+static const int MAX_RESOLVER_THREADS = 4;
+
+// How many distinct questions we remember answers to.
+static const size_t MAX_CACHE_ENTRIES = 64;
+
+/** What getaddrinfo(3) said: the addresses, or a non-zero EAI_ error and the errno it left. */
+struct Answer {
+    Answer() : error(0), sysErrno(0) {
+    }
+
+    std::vector<sockaddr_storage> addresses;
+    int error;
+    int sysErrno;
+};
+
+struct Waiter;
+
+/**
+ * One question being answered on the resolver threads, shared by every Waiter that asks it while
+ * it's in flight. An AF_UNSPEC question is split into AF_INET6 and AF_INET sub-queries that run
+ * in parallel and are merged when both have answered.
+ */
+struct Query {
+    std::string key;
+    std::string node;
+    addrinfo hints;
+    bool split;
+    // Sub-queries not yet answered, and how many of those haven't been started yet.
+    int pending;
+    int queued;
+    // Indexed by sub-query: AF_INET6 then AF_INET when split, otherwise just the one.
+    Answer answers[2];
+    std::list<Waiter*> waiters;
+};
+
+/**
+ * The native half of an AsyncResolver.Lookup. The pipe is only created if someone has to wait;
+ * it becomes readable when the lookup is answered or cancelled, and is never drained, so any
+ * number of threads can poll it.
+ */
+struct Waiter {
+    Waiter() : query(NULL), done(false), cancelled(false) {
+        pipeFds[0] = pipeFds[1] = -1;
+    }
+
+    ~Waiter() {
+        if (pipeFds[0] != -1) {
+            close(pipeFds[0]);
+            close(pipeFds[1]);
+        }
+    }
+
+    // The query we're waiting for, or NULL once we're done.
+    Query* query;
+    bool done;
+    bool cancelled;
+    Answer answer;
+    int pipeFds[2];
+};
+
+struct CacheEntry {
+    Answer answer;
+    int64_t expiryNanos;
+};
+
+typedef std::list<std::pair<std::string, CacheEntry> > CacheList;
+
+// Everything below is guarded by gResolverMutex.
+static pthread_mutex_t gResolverMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gWorkAvailable = PTHREAD_COND_INITIALIZER;
+static std::deque<std::pair<Query*, int> > gWork;
+static int gThreadCount = 0;
+static int gIdleThreadCount = 0;
+static std::map<std::string, Query*> gInFlight;
+// Most recently used first.
+static CacheList gCache;
+static std::map<std::string, CacheList::iterator> gCacheIndex;
+// getaddrinfo(3) doesn't tell us the records' TTLs, so these are fixed, like java.net's cache.
+static int64_t gPositiveTtlNanos = 2 * 1000000000LL;
+static int64_t gNegativeTtlNanos = 2 * 1000000000LL;
+
+static int64_t monotonicNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+static Waiter* toWaiter(jlong handle) {
+    return reinterpret_cast<Waiter*>(static_cast<uintptr_t>(handle));
+}
+
+static std::string cacheKey(const char* node, const addrinfo& hints) {
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), "|%d|%d|%d|%d",
+            hints.ai_flags, hints.ai_family, hints.ai_socktype, hints.ai_protocol);
+    return std::string(node) + suffix;
+}
+
+/**
+ * Returns true if 'answer' says something about the name rather than about us. Failures that
+ * may be transient (EAI_AGAIN, or a lookup we weren't allowed to make) aren't worth remembering.
+ */
+static bool isCacheable(const Answer& answer) {
+    if (answer.error == 0) {
+        return true;
+    }
+    bool noSuchName = (answer.error == EAI_NONAME);
+#if defined(EAI_NODATA)
+    noSuchName = noSuchName || (answer.error == EAI_NODATA);
+#endif
+    return noSuchName && answer.sysErrno != EACCES && answer.sysErrno != EPERM;
+}
+
+static void cachePutLocked(const std::string& key, const Answer& answer) {
+    std::map<std::string, CacheList::iterator>::iterator it = gCacheIndex.find(key);
+    if (it != gCacheIndex.end()) {
+        gCache.erase(it->second);
+        gCacheIndex.erase(it);
+    }
+    CacheEntry entry;
+    entry.answer = answer;
+    entry.expiryNanos = monotonicNanos() + (answer.error == 0 ? gPositiveTtlNanos : gNegativeTtlNanos);
+    gCache.push_front(std::make_pair(key, entry));
+    gCacheIndex[key] = gCache.begin();
+    if (gCache.size() > MAX_CACHE_ENTRIES) {
+        gCacheIndex.erase(gCache.back().first);
+        gCache.pop_back();
+    }
+}
+
+static bool cacheGetLocked(const std::string& key, Answer& answer) {
+    std::map<std::string, CacheList::iterator>::iterator it = gCacheIndex.find(key);
+    if (it == gCacheIndex.end()) {
+        return false;
+    }
+    if (it->second->second.expiryNanos < monotonicNanos()) {
+        gCache.erase(it->second);
+        gCacheIndex.erase(it);
+        return false;
+    }
+    gCache.splice(gCache.begin(), gCache, it->second);
+    answer = it->second->second.answer;
+    return true;
+}
+
+/** Marks 'w' as finished and wakes anyone polling it. */
+static void wakeLocked(Waiter* w) {
+    w->done = true;
+    w->query = NULL;
+    if (w->pipeFds[1] != -1) {
+        char ch = 0;
+        TEMP_FAILURE_RETRY(write(w->pipeFds[1], &ch, 1));
+    }
+}
+
+/**
+ * Stops 'w' waiting for its query. If nobody else wants the answer and no sub-query has started,
+ * the query's work is withdrawn; a getaddrinfo(3) that's already running can't be interrupted,
+ * but its answer still goes into the cache.
+ */
+static void detachLocked(Waiter* w) {
+    Query* q = w->query;
+    if (q == NULL) {
+        return;
+    }
+    w->query = NULL;
+    q->waiters.remove(w);
+    if (q->waiters.empty() && q->pending > 0 && q->queued == q->pending) {
+        for (std::deque<std::pair<Query*, int> >::iterator it = gWork.begin(); it != gWork.end(); ) {
+            it = (it->first == q) ? gWork.erase(it) : it + 1;
+        }
+        gInFlight.erase(q->key);
+        delete q;
+    }
+}
+
+static void resolve(const Query* q, int index, Answer& answer) {
+    addrinfo hints = q->hints;
+    if (q->split) {
+        hints.ai_family = (index == 0) ? AF_INET6 : AF_INET;
+    }
+    addrinfo* addressList = NULL;
+    errno = 0;
+    answer.error = getaddrinfo(q->node.c_str(), NULL, &hints, &addressList);
+    answer.sysErrno = errno;
+    for (addrinfo* ai = addressList; ai != NULL; ai = ai->ai_next) {
+        if (ai->ai_family != AF_INET && ai->ai_family != AF_INET6) {
+            ALOGE("getaddrinfo unexpected ai_family %i", ai->ai_family);
+            continue;
+        }
+        sockaddr_storage ss;
+        memset(&ss, 0, sizeof(ss));
+        memcpy(&ss, ai->ai_addr, std::min(static_cast<size_t>(ai->ai_addrlen), sizeof(ss)));
+        answer.addresses.push_back(ss);
+    }
+    if (addressList != NULL) { // bionic's freeaddrinfo(3) crashes when passed NULL.
+        freeaddrinfo(addressList);
+    }
+}
+
+/** Returns true if we have a route to 'ss'. Connecting a UDP socket sends nothing. */
+static bool isReachable(const sockaddr_storage& ss) {
+    int fd = socket(ss.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd == -1) {
+        return false;
+    }
+    socklen_t length = (ss.ss_family == AF_INET6) ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
+    int rc = TEMP_FAILURE_RETRY(connect(fd, reinterpret_cast<const sockaddr*>(&ss), length));
+    close(fd);
+    return rc == 0;
+}
+
+/**
+ * Combines the answers to a split query. getaddrinfo(3) would have sorted the two families
+ * together by RFC 6724; we approximate its first rule and only put IPv6 first if it's routable.
+ */
+static Answer merge(const Query* q) {
+    if (!q->split) {
+        return q->answers[0];
+    }
+    const Answer& v6 = q->answers[0];
+    const Answer& v4 = q->answers[1];
+    if (v6.error != 0 && v4.error != 0) {
+        // Report a failure that might be transient over one that says the name doesn't exist.
+        return isCacheable(v4) ? v6 : v4;
+    } else if (v6.error != 0) {
+        return v4;
+    } else if (v4.error != 0) {
+        return v6;
+    }
+    bool v6First = isReachable(v6.addresses[0]);
+    Answer result = v6First ? v6 : v4;
+    const Answer& rest = v6First ? v4 : v6;
+    result.addresses.insert(result.addresses.end(), rest.addresses.begin(), rest.addresses.end());
+    return result;
+}
+
+static void* resolverThreadMain(void*) {
+    while (true) {
+        pthread_mutex_lock(&gResolverMutex);
+        while (gWork.empty()) {
+            ++gIdleThreadCount;
+            pthread_cond_wait(&gWorkAvailable, &gResolverMutex);
+            --gIdleThreadCount;
+        }
+        Query* q = gWork.front().first;
+        int index = gWork.front().second;
+        gWork.pop_front();
+        --q->queued;
+        pthread_mutex_unlock(&gResolverMutex);
+
+        Answer answer;
+        resolve(q, index, answer);
+
+        pthread_mutex_lock(&gResolverMutex);
+        q->answers[index] = answer;
+        bool last = (--q->pending == 0);
+        pthread_mutex_unlock(&gResolverMutex);
+        if (!last) {
+            continue;
+        }
+
+        // Nobody else touches the answers once pending is 0, and detachLocked won't free q.
+        Answer merged = merge(q);
+        pthread_mutex_lock(&gResolverMutex);
+        if (isCacheable(merged)) {
+            cachePutLocked(q->key, merged);
+        }
+        for (std::list<Waiter*>::iterator it = q->waiters.begin(); it != q->waiters.end(); ++it) {
+            (*it)->answer = merged;
+            wakeLocked(*it);
+        }
+        gInFlight.erase(q->key);
+        pthread_mutex_unlock(&gResolverMutex);
+        delete q;
+    }
+    return NULL;
+}
+
+/** Queues 'q', starting another resolver thread if everyone's busy and we're below the limit. */
+static void enqueueLocked(Query* q) {
+    for (int i = 0; i < q->queued; ++i) {
+        gWork.push_back(std::make_pair(q, i));
+    }
+    pthread_cond_broadcast(&gWorkAvailable);
+    size_t available = gIdleThreadCount;
+    while (available < gWork.size() && gThreadCount < MAX_RESOLVER_THREADS) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        pthread_t thread;
+        int rc = pthread_create(&thread, &attr, resolverThreadMain, NULL);
+        pthread_attr_destroy(&attr);
+        if (rc != 0) {
+            ALOGE("couldn't start resolver thread: %s", strerror(rc));
+            break;
+        }
+        ++gThreadCount;
+        ++available;
+    }
+}
+
+static jlong AsyncResolver_lookupImpl(JNIEnv* env, jclass, jstring javaNode, jint flags,
+        jint family, jint socktype, jint protocol) {
+    ScopedUtfChars node(env, javaNode);
+    if (node.c_str() == NULL) {
+        return 0;
+    }
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_flags = flags;
+    hints.ai_family = family;
+    hints.ai_socktype = socktype;
+    hints.ai_protocol = protocol;
+    std::string key(cacheKey(node.c_str(), hints));
+
+    UniquePtr<Waiter> w(new Waiter);
+    ScopedPthreadMutexLock lock(&gResolverMutex);
+    if (cacheGetLocked(key, w->answer)) {
+        w->done = true;
+        return reinterpret_cast<uintptr_t>(w.release());
+    }
+    std::map<std::string, Query*>::iterator it = gInFlight.find(key);
+    Query* q;
+    if (it != gInFlight.end()) {
+        q = it->second;
+    } else {
+        q = new Query;
+        q->key = key;
+        q->node = node.c_str();
+        q->hints = hints;
+        q->split = (family == AF_UNSPEC);
+        q->pending = q->queued = q->split ? 2 : 1;
+        gInFlight[key] = q;
+        enqueueLocked(q);
+    }
+    q->waiters.push_back(w.get());
+    w->query = q;
+    return reinterpret_cast<uintptr_t>(w.release());
+}
+
+static jboolean AsyncResolver_isDoneImpl(JNIEnv*, jclass, jlong handle) {
+    ScopedPthreadMutexLock lock(&gResolverMutex);
+    return toWaiter(handle)->done;
+}
+
+static jboolean AsyncResolver_cancelImpl(JNIEnv*, jclass, jlong handle) {
+    Waiter* w = toWaiter(handle);
+    ScopedPthreadMutexLock lock(&gResolverMutex);
+    if (w->done) {
+        return JNI_FALSE;
+    }
+    detachLocked(w);
+    w->cancelled = true;
+    wakeLocked(w);
+    return JNI_TRUE;
+}
+
+/**
+ * Gives 'w' a pipe to poll if it doesn't have one. Returns false if the lookup is already done,
+ * or with a pending exception if we couldn't make a pipe.
+ */
+static bool ensurePipe(JNIEnv* env, Waiter* w) {
+    {
+        ScopedPthreadMutexLock lock(&gResolverMutex);
+        if (w->done || w->pipeFds[0] != -1) {
+            return !w->done;
+        }
+    }
+    int fds[2];
+    if (pipe(fds) == -1) {
+        jniThrowErrnoException(env, "pipe", errno);
+        return false;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    ScopedPthreadMutexLock lock(&gResolverMutex);
+    if (w->pipeFds[0] == -1) {
+        w->pipeFds[0] = fds[0];
+        w->pipeFds[1] = fds[1];
+    } else {
+        // Another thread got there first.
+        close(fds[0]);
+        close(fds[1]);
+    }
+    return !w->done;
+}
+
+/**
+ * Waits up to 'timeoutMs' (forever if negative) for the lookup to be answered or cancelled,
+ * returning whether it has been. If 'javaFd' is non-null, the wait is registered with the
+ * AsynchronousSocketCloseMonitor for it, so closing that socket abandons the lookup and makes
+ * this throw a SocketException, just as it would for a thread blocked reading it.
+ */
+static jboolean AsyncResolver_awaitImpl(JNIEnv* env, jclass, jlong handle, jobject javaFd, jint timeoutMs) {
+    Waiter* w = toWaiter(handle);
+    if (timeoutMs == 0) {
+        return AsyncResolver_isDoneImpl(env, NULL, handle);
+    } else if (!ensurePipe(env, w)) {
+        return !env->ExceptionCheck();
+    }
+    int64_t deadline = monotonicNanos() + static_cast<int64_t>(timeoutMs) * 1000000LL;
+    while (true) {
+        {
+            ScopedPthreadMutexLock lock(&gResolverMutex);
+            if (w->done) {
+                return JNI_TRUE;
+            }
+        }
+        int remainingMs = -1;
+        if (timeoutMs >= 0) {
+            int64_t remaining = deadline - monotonicNanos();
+            remainingMs = (remaining > 0) ? static_cast<int>((remaining + 999999) / 1000000) : 0;
+        }
+        pollfd pfd;
+        pfd.fd = w->pipeFds[0];
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int rc;
+        if (javaFd != NULL) {
+            int fd = jniGetFDFromFileDescriptor(env, javaFd);
+            if (fd == -1) {
+                rc = -1;
+            } else {
+                AsynchronousSocketCloseMonitor monitor(fd);
+                rc = poll(&pfd, 1, remainingMs);
+            }
+            if (rc == -1 && jniGetFDFromFileDescriptor(env, javaFd) == -1) {
+                AsyncResolver_cancelImpl(env, NULL, handle);
+                jniThrowException(env, "java/net/SocketException", "Socket closed");
+                return JNI_FALSE;
+            }
+        } else {
+            rc = poll(&pfd, 1, remainingMs);
+        }
+        if (rc == -1 && errno != EINTR) {
+            jniThrowErrnoException(env, "poll", errno);
+            return JNI_FALSE;
+        } else if (rc == 0) {
+            ScopedPthreadMutexLock lock(&gResolverMutex);
+            return w->done;
+        }
+    }
+}
+
+static void throwGaiException(JNIEnv* env, const Answer& answer) {
+    // Cache the methods ids before we throw, so we don't call GetMethodID with a pending exception.
+    static jmethodID ctor3 = env->GetMethodID(JniConstants::gaiExceptionClass, "<init>",
+            "(Ljava/lang/String;ILjava/lang/Throwable;)V");
+    static jmethodID ctor2 = env->GetMethodID(JniConstants::gaiExceptionClass, "<init>",
+            "(Ljava/lang/String;I)V");
+    ScopedLocalRef<jstring> functionName(env, env->NewStringUTF("getaddrinfo"));
+    if (functionName.get() == NULL) {
+        return;
+    }
+    jobject exception;
+    if (answer.sysErrno != 0) {
+        // As in Posix.getaddrinfo, errno may explain the failure better than the EAI_ error.
+        jniThrowErrnoException(env, "getaddrinfo", answer.sysErrno);
+        ScopedLocalRef<jthrowable> cause(env, env->ExceptionOccurred());
+        env->ExceptionClear();
+        exception = env->NewObject(JniConstants::gaiExceptionClass, ctor3,
+                functionName.get(), answer.error, cause.get());
+    } else {
+        exception = env->NewObject(JniConstants::gaiExceptionClass, ctor2,
+                functionName.get(), answer.error);
+    }
+    env->Throw(reinterpret_cast<jthrowable>(exception));
+}
+
+/** Returns the answer to a finished lookup, or NULL if it was cancelled. */
+static jobjectArray AsyncResolver_resultImpl(JNIEnv* env, jclass, jlong handle) {
+    Answer answer;
+    {
+        ScopedPthreadMutexLock lock(&gResolverMutex);
+        Waiter* w = toWaiter(handle);
+        if (w->cancelled) {
+            return NULL;
+        }
+        answer = w->answer;
+    }
+    if (answer.error != 0) {
+        throwGaiException(env, answer);
+        return NULL;
+    }
+    jobjectArray result = env->NewObjectArray(answer.addresses.size(),
+            JniConstants::inetAddressClass, NULL);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < answer.addresses.size(); ++i) {
+        ScopedLocalRef<jobject> inetAddress(env, sockaddrToInetAddress(env, answer.addresses[i], NULL));
+        if (inetAddress.get() == NULL) {
+            return NULL;
+        }
+        env->SetObjectArrayElement(result, i, inetAddress.get());
+    }
+    return result;
+}
+
+static void AsyncResolver_releaseImpl(JNIEnv*, jclass, jlong handle) {
+    Waiter* w = toWaiter(handle);
+    {
+        ScopedPthreadMutexLock lock(&gResolverMutex);
+        detachLocked(w);
+    }
+    delete w;
+}
+
+static void AsyncResolver_clearCache(JNIEnv*, jclass) {
+    ScopedPthreadMutexLock lock(&gResolverMutex);
+    gCache.clear();
+    gCacheIndex.clear();
+}
+
+static void AsyncResolver_setCacheTtls(JNIEnv*, jclass, jlong positiveMillis, jlong negativeMillis) {
+    ScopedPthreadMutexLock lock(&gResolverMutex);
+    gPositiveTtlNanos = positiveMillis * 1000000LL;
+    gNegativeTtlNanos = negativeMillis * 1000000LL;
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(AsyncResolver, awaitImpl, "(JLjava/io/FileDescriptor;I)Z"),
+    NATIVE_METHOD(AsyncResolver, cancelImpl, "(J)Z"),
+    NATIVE_METHOD(AsyncResolver, clearCache, "()V"),
+    NATIVE_METHOD(AsyncResolver, isDoneImpl, "(J)Z"),
+    NATIVE_METHOD(AsyncResolver, lookupImpl, "(Ljava/lang/String;IIII)J"),
+    NATIVE_METHOD(AsyncResolver, releaseImpl, "(J)V"),
+    NATIVE_METHOD(AsyncResolver, resultImpl, "(J)[Ljava/net/InetAddress;"),
+    NATIVE_METHOD(AsyncResolver, setCacheTtls, "(JJ)V"),
+};
+void register_libcore_io_AsyncResolver(JNIEnv* env) {
+    jniRegisterNativeMethods(env, "libcore/io/AsyncResolver", gMethods, NELEM(gMethods));
+}
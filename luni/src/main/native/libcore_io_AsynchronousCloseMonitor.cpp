@@ -19,6 +19,8 @@
 #include "AsynchronousSocketCloseMonitor.h"
 #include "JNIHelp.h"
 #include "JniConstants.h"
+#include "ScopedPrimitiveArray.h"
+#include "StartupProfile.h"
 #include "jni.h"
 
 static void AsynchronousCloseMonitor_signalBlockedThreads(JNIEnv* env, jclass, jobject javaFd) {
@@ -26,10 +28,31 @@ static void AsynchronousCloseMonitor_signalBlockedThreads(JNIEnv* env, jclass, j
     AsynchronousSocketCloseMonitor::signalBlockedThreads(fd);
 }
 
+static jlongArray AsynchronousCloseMonitor_getCounters(JNIEnv* env, jclass) {
+    uint64_t counters[AsynchronousSocketCloseMonitor::COUNTER_COUNT];
+    AsynchronousSocketCloseMonitor::getCounters(counters);
+    jlongArray result = env->NewLongArray(AsynchronousSocketCloseMonitor::COUNTER_COUNT);
+    if (result == NULL) {
+        return NULL;
+    }
+    ScopedLongArrayRW javaCounters(env, result);
+    if (javaCounters.get() == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < AsynchronousSocketCloseMonitor::COUNTER_COUNT; ++i) {
+        javaCounters[i] = counters[i];
+    }
+    return result;
+}
+
 static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(AsynchronousCloseMonitor, getCounters, "()[J"),
     NATIVE_METHOD(AsynchronousCloseMonitor, signalBlockedThreads, "(Ljava/io/FileDescriptor;)V"),
 };
 void register_libcore_io_AsynchronousCloseMonitor(JNIEnv* env) {
-    AsynchronousSocketCloseMonitor::init();
+    {
+        ScopedStartupEvent event("AsynchronousSocketCloseMonitor::init");
+        AsynchronousSocketCloseMonitor::init();
+    }
     jniRegisterNativeMethods(env, "libcore/io/AsynchronousCloseMonitor", gMethods, NELEM(gMethods));
 }
@@ -0,0 +1,606 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "IoUring"
+
+#include "AsynchronousSocketCloseMonitor.h"
+#include "JNIHelp.h"
+#include "JniConstants.h"
+#include "JniException.h"
+#include "NetworkUtilities.h"
+#include "ScopedPrimitiveArray.h"
+#include "UniquePtr.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Some headers define the system call numbers without shipping <linux/io_uring.h>.
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_LINUX_IO_URING_H 1
+#endif
+#endif
+
+#if defined(__NR_io_uring_setup) && defined(HAVE_LINUX_IO_URING_H)
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+// The user_data of cancellations we issue ourselves. harvest doesn't report their completions.
+static const uint64_t INTERNAL_USER_DATA = ~0ULL;
+
+// The kernel's user_data for an operation is its slot's index in the low 32 bits and the slot's
+// sequence number in the high 32, so that an IORING_OP_ASYNC_CANCEL that's only processed after
+// its operation completed and the slot was reused misses, rather than cancelling the new one.
+static uint64_t toKernelUserData(size_t slotIndex, uint32_t sequence) {
+    return (static_cast<uint64_t>(sequence) << 32) | slotIndex;
+}
+
+static size_t slotIndexOf(uint64_t kernelUserData) {
+    return static_cast<uint32_t>(kernelUserData);
+}
+
+template <typename T>
+static T* ringField(void* ring, uint32_t offset) {
+    return reinterpret_cast<T*>(reinterpret_cast<char*>(ring) + offset);
+}
+
+/**
+ * The state of one in-flight operation. The kernel reads iovecs and socket addresses
+ * asynchronously, so they have to live here rather than on the stack of the preparing call.
+ * The java.io.FileDescriptor is kept so we can tell when another thread has closed it.
+ */
+struct IoUringSlot {
+    IoUringSlot() : javaFd(NULL), fd(-1), cancelled(false), sequence(0), userData(0),
+            addressLength(0) {
+    }
+
+    // A global reference, or NULL if this slot is free.
+    jobject javaFd;
+    int fd;
+    bool cancelled;
+    // Bumped each time the slot is used, so a stale cancellation can't match a newer operation.
+    uint32_t sequence;
+    jlong userData;
+    sockaddr_storage address;
+    socklen_t addressLength;
+    std::vector<iovec> iov;
+};
+
+/**
+ * A submission/completion queue pair and its bookkeeping. Not thread-safe: the Java side
+ * confines each ring to one thread at a time, though any thread may close a file descriptor
+ * that has operations in flight.
+ */
+class IoUring {
+public:
+    IoUring() : mRingFd(-1), mSqRing(MAP_FAILED), mCqRing(MAP_FAILED), mSqes(MAP_FAILED),
+            mSqRingSize(0), mCqRingSize(0), mSqesSize(0), mSqTail(0), mToSubmit(0) {
+    }
+
+    ~IoUring() {
+        if (mSqes != MAP_FAILED) {
+            munmap(mSqes, mSqesSize);
+        }
+        if (mCqRing != MAP_FAILED && mCqRing != mSqRing) {
+            munmap(mCqRing, mCqRingSize);
+        }
+        if (mSqRing != MAP_FAILED) {
+            munmap(mSqRing, mSqRingSize);
+        }
+        if (mRingFd != -1) {
+            close(mRingFd);
+        }
+    }
+
+    bool init(JNIEnv* env, unsigned entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        mRingFd = syscall(__NR_io_uring_setup, entries, &params);
+        if (mRingFd == -1) {
+            jniThrowErrnoException(env, "io_uring_setup", errno);
+            return false;
+        }
+
+        mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap && mCqRingSize > mSqRingSize) {
+            mSqRingSize = mCqRingSize;
+        }
+        mSqRing = mmap(NULL, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                mRingFd, IORING_OFF_SQ_RING);
+        if (mSqRing == MAP_FAILED) {
+            jniThrowErrnoException(env, "mmap", errno);
+            return false;
+        }
+        if (singleMmap) {
+            mCqRing = mSqRing;
+        } else {
+            mCqRing = mmap(NULL, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    mRingFd, IORING_OFF_CQ_RING);
+            if (mCqRing == MAP_FAILED) {
+                jniThrowErrnoException(env, "mmap", errno);
+                return false;
+            }
+        }
+        mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        mSqes = mmap(NULL, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                mRingFd, IORING_OFF_SQES);
+        if (mSqes == MAP_FAILED) {
+            jniThrowErrnoException(env, "mmap", errno);
+            return false;
+        }
+
+        mSqHead = ringField<uint32_t>(mSqRing, params.sq_off.head);
+        mSqTailPtr = ringField<uint32_t>(mSqRing, params.sq_off.tail);
+        mSqMask = *ringField<uint32_t>(mSqRing, params.sq_off.ring_mask);
+        mSqEntries = *ringField<uint32_t>(mSqRing, params.sq_off.ring_entries);
+        mSqArray = ringField<uint32_t>(mSqRing, params.sq_off.array);
+        mCqHead = ringField<uint32_t>(mCqRing, params.cq_off.head);
+        mCqTail = ringField<uint32_t>(mCqRing, params.cq_off.tail);
+        mCqMask = *ringField<uint32_t>(mCqRing, params.cq_off.ring_mask);
+        mCqes = ringField<io_uring_cqe>(mCqRing, params.cq_off.cqes);
+        mSqTail = *mSqTailPtr;
+
+        // Each operation can produce two completions (its own, and a cancellation's), so
+        // limiting in-flight operations to half the completion queue means it can't overflow.
+        size_t slotCount = params.cq_entries / 2;
+        mSlots.resize(slotCount);
+        mFreeSlots.reserve(slotCount);
+        for (size_t i = slotCount; i > 0; --i) {
+            mFreeSlots.push_back(i - 1);
+        }
+        return true;
+    }
+
+    // Releases the global references held by in-flight operations.
+    void releaseSlots(JNIEnv* env) {
+        for (size_t i = 0; i < mSlots.size(); ++i) {
+            if (mSlots[i].javaFd != NULL) {
+                env->DeleteGlobalRef(mSlots[i].javaFd);
+                mSlots[i].javaFd = NULL;
+            }
+        }
+    }
+
+    /**
+     * Returns a zeroed submission queue entry for an operation on 'javaFd', or throws and
+     * returns NULL. The entry isn't visible to the kernel until it's passed to 'commit', so
+     * callers should do anything that can fail before calling this.
+     */
+    io_uring_sqe* prepare(JNIEnv* env, jobject javaFd, uint8_t opcode, jlong userData) {
+        int fd = jniGetFDFromFileDescriptor(env, javaFd);
+        if (fd == -1) {
+            jniThrowErrnoException(env, "io_uring_enter", EBADF);
+            return NULL;
+        }
+        if (mFreeSlots.empty()) {
+            jniThrowErrnoException(env, "io_uring_enter", EBUSY);
+            return NULL;
+        }
+        io_uring_sqe* sqe = nextSqe();
+        if (sqe == NULL) {
+            jniThrowErrnoException(env, "io_uring_enter", EBUSY);
+            return NULL;
+        }
+        size_t slotIndex = mFreeSlots.back();
+        IoUringSlot& slot = mSlots[slotIndex];
+        slot.javaFd = env->NewGlobalRef(javaFd);
+        if (slot.javaFd == NULL) {
+            return NULL;
+        }
+        mFreeSlots.pop_back();
+        slot.fd = fd;
+        slot.cancelled = false;
+        ++slot.sequence;
+        slot.userData = userData;
+        sqe->opcode = opcode;
+        sqe->fd = fd;
+        sqe->user_data = toKernelUserData(slotIndex, slot.sequence);
+        return sqe;
+    }
+
+    IoUringSlot& slotFor(io_uring_sqe* sqe) {
+        return mSlots[slotIndexOf(sqe->user_data)];
+    }
+
+    void commit(io_uring_sqe* sqe) {
+        uint32_t index = sqe - reinterpret_cast<io_uring_sqe*>(mSqes);
+        mSqArray[index] = index;
+        ++mSqTail;
+        ++mToSubmit;
+        __atomic_store_n(mSqTailPtr, mSqTail, __ATOMIC_RELEASE);
+    }
+
+    // Queues a cancellation of the in-flight operation with the given user data.
+    // Returns false if there's no such operation (it may already have completed).
+    bool cancel(JNIEnv* env, jlong userData) {
+        for (size_t i = 0; i < mSlots.size(); ++i) {
+            IoUringSlot& slot = mSlots[i];
+            if (slot.javaFd != NULL && slot.userData == userData) {
+                return cancelSlot(env, i);
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Cancels operations whose java.io.FileDescriptor was closed by another thread. The kernel
+     * holds its own reference to the file, so without this they'd never complete. Returns the
+     * number of cancellations queued.
+     */
+    size_t cancelClosed(JNIEnv* env) {
+        size_t count = 0;
+        for (size_t i = 0; i < mSlots.size(); ++i) {
+            IoUringSlot& slot = mSlots[i];
+            if (slot.javaFd != NULL && !slot.cancelled &&
+                    jniGetFDFromFileDescriptor(env, slot.javaFd) == -1) {
+                if (!cancelSlot(env, i)) {
+                    break;
+                }
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    int enter(uint32_t minCompletions) {
+        unsigned flags = (minCompletions > 0) ? IORING_ENTER_GETEVENTS : 0;
+        int rc = syscall(__NR_io_uring_enter, mRingFd, mToSubmit, minCompletions, flags, NULL, 0);
+        if (rc > 0) {
+            mToSubmit -= rc;
+        }
+        return rc;
+    }
+
+    // Copies up to 'count' completions out, returning how many were copied. The completion
+    // queue isn't handed to Java directly: its user_data is our slot tag rather than the
+    // caller's, and each completion has to release its slot's global reference here anyway.
+    size_t harvest(JNIEnv* env, jlong* userData, jint* results, size_t count) {
+        size_t harvested = 0;
+        uint32_t head = *mCqHead;
+        uint32_t tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+        while (head != tail && harvested < count) {
+            const io_uring_cqe& cqe = mCqes[head & mCqMask];
+            ++head;
+            if (cqe.user_data == INTERNAL_USER_DATA) {
+                continue;
+            }
+            size_t slotIndex = slotIndexOf(cqe.user_data);
+            IoUringSlot& slot = mSlots[slotIndex];
+            if (slot.javaFd == NULL || cqe.user_data != toKernelUserData(slotIndex, slot.sequence)) {
+                // Not the operation the slot holds now. Each slot only has one operation in
+                // flight, so this shouldn't happen, but it mustn't release someone else's slot.
+                continue;
+            }
+            userData[harvested] = slot.userData;
+            results[harvested] = cqe.res;
+            ++harvested;
+            releaseSlot(env, slotIndex);
+        }
+        __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+        return harvested;
+    }
+
+    const std::vector<IoUringSlot>& slots() const {
+        return mSlots;
+    }
+
+private:
+    io_uring_sqe* nextSqe() {
+        uint32_t head = __atomic_load_n(mSqHead, __ATOMIC_ACQUIRE);
+        if (mSqTail - head >= mSqEntries) {
+            return NULL;
+        }
+        io_uring_sqe* sqe = reinterpret_cast<io_uring_sqe*>(mSqes) + (mSqTail & mSqMask);
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    bool cancelSlot(JNIEnv* env, size_t slotIndex) {
+        IoUringSlot& slot = mSlots[slotIndex];
+        if (slot.cancelled) {
+            return true;
+        }
+        io_uring_sqe* sqe = nextSqe();
+        if (sqe == NULL) {
+            jniThrowErrnoException(env, "io_uring_enter", EBUSY);
+            return false;
+        }
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = toKernelUserData(slotIndex, slot.sequence);
+        sqe->user_data = INTERNAL_USER_DATA;
+        commit(sqe);
+        slot.cancelled = true;
+        return true;
+    }
+
+    void releaseSlot(JNIEnv* env, size_t slotIndex) {
+        IoUringSlot& slot = mSlots[slotIndex];
+        env->DeleteGlobalRef(slot.javaFd);
+        slot.javaFd = NULL;
+        mFreeSlots.push_back(slotIndex);
+    }
+
+    int mRingFd;
+    void* mSqRing;
+    void* mCqRing;
+    void* mSqes;
+    size_t mSqRingSize;
+    size_t mCqRingSize;
+    size_t mSqesSize;
+
+    uint32_t* mSqHead;
+    uint32_t* mSqTailPtr;
+    uint32_t mSqMask;
+    uint32_t mSqEntries;
+    uint32_t* mSqArray;
+    uint32_t* mCqHead;
+    uint32_t* mCqTail;
+    uint32_t mCqMask;
+    io_uring_cqe* mCqes;
+
+    // Our copy of the submission queue tail, and how many entries the kernel hasn't consumed.
+    uint32_t mSqTail;
+    uint32_t mToSubmit;
+
+    std::vector<IoUringSlot> mSlots;
+    std::vector<size_t> mFreeSlots;
+
+    // Disallow copy and assignment.
+    IoUring(const IoUring&);
+    void operator=(const IoUring&);
+};
+
+/**
+ * Registers the waiting thread with an AsynchronousSocketCloseMonitor for the fd of every
+ * in-flight operation, so that closing any of them interrupts io_uring_enter.
+ */
+class ScopedCloseMonitors {
+public:
+    ScopedCloseMonitors(const IoUring* ring) {
+        const std::vector<IoUringSlot>& slots = ring->slots();
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].javaFd != NULL && !slots[i].cancelled) {
+                mMonitors.push_back(new AsynchronousSocketCloseMonitor(slots[i].fd));
+            }
+        }
+    }
+
+    ~ScopedCloseMonitors() {
+        for (size_t i = 0; i < mMonitors.size(); ++i) {
+            delete mMonitors[i];
+        }
+    }
+
+private:
+    std::vector<AsynchronousSocketCloseMonitor*> mMonitors;
+
+    // Disallow copy and assignment.
+    ScopedCloseMonitors(const ScopedCloseMonitors&);
+    void operator=(const ScopedCloseMonitors&);
+};
+
+static IoUring* toIoUring(jlong handle) {
+    return reinterpret_cast<IoUring*>(static_cast<uintptr_t>(handle));
+}
+
+static jlong IoUring_create(JNIEnv* env, jclass, jint entries) {
+    UniquePtr<IoUring> ring(new IoUring);
+    if (!ring->init(env, entries)) {
+        return 0;
+    }
+    return static_cast<jlong>(reinterpret_cast<uintptr_t>(ring.release()));
+}
+
+static void IoUring_destroy(JNIEnv* env, jclass, jlong handle) {
+    IoUring* ring = toIoUring(handle);
+    ring->releaseSlots(env);
+    delete ring;
+}
+
+static void prepareRw(JNIEnv* env, IoUring* ring, jobject javaFd, uint8_t opcode,
+        jlong address, jint byteCount, jlong offset, jlong userData) {
+    io_uring_sqe* sqe = ring->prepare(env, javaFd, opcode, userData);
+    if (sqe == NULL) {
+        return;
+    }
+    IoUringSlot& slot = ring->slotFor(sqe);
+    slot.iov.resize(1);
+    slot.iov[0].iov_base = reinterpret_cast<void*>(static_cast<uintptr_t>(address));
+    slot.iov[0].iov_len = byteCount;
+    sqe->addr = reinterpret_cast<uintptr_t>(&slot.iov[0]);
+    sqe->len = 1;
+    sqe->off = offset;
+    ring->commit(sqe);
+}
+
+static void prepareRwv(JNIEnv* env, IoUring* ring, jobject javaFd, uint8_t opcode,
+        jlongArray javaAddresses, jintArray javaByteCounts, jlong offset, jlong userData) {
+    ScopedLongArrayRO addresses(env, javaAddresses);
+    if (addresses.get() == NULL) {
+        return;
+    }
+    ScopedIntArrayRO byteCounts(env, javaByteCounts);
+    if (byteCounts.get() == NULL) {
+        return;
+    }
+    io_uring_sqe* sqe = ring->prepare(env, javaFd, opcode, userData);
+    if (sqe == NULL) {
+        return;
+    }
+    IoUringSlot& slot = ring->slotFor(sqe);
+    slot.iov.resize(addresses.size());
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        slot.iov[i].iov_base = reinterpret_cast<void*>(static_cast<uintptr_t>(addresses[i]));
+        slot.iov[i].iov_len = byteCounts[i];
+    }
+    sqe->addr = slot.iov.empty() ? 0 : reinterpret_cast<uintptr_t>(&slot.iov[0]);
+    sqe->len = slot.iov.size();
+    sqe->off = offset;
+    ring->commit(sqe);
+}
+
+static void IoUring_prepareReadImpl(JNIEnv* env, jclass, jlong handle, jobject javaFd,
+        jlong address, jint byteCount, jlong offset, jlong userData) {
+    prepareRw(env, toIoUring(handle), javaFd, IORING_OP_READV, address, byteCount, offset, userData);
+}
+
+static void IoUring_prepareWriteImpl(JNIEnv* env, jclass, jlong handle, jobject javaFd,
+        jlong address, jint byteCount, jlong offset, jlong userData) {
+    prepareRw(env, toIoUring(handle), javaFd, IORING_OP_WRITEV, address, byteCount, offset, userData);
+}
+
+static void IoUring_prepareReadvImpl(JNIEnv* env, jclass, jlong handle, jobject javaFd,
+        jlongArray addresses, jintArray byteCounts, jlong offset, jlong userData) {
+    prepareRwv(env, toIoUring(handle), javaFd, IORING_OP_READV, addresses, byteCounts, offset, userData);
+}
+
+static void IoUring_prepareWritevImpl(JNIEnv* env, jclass, jlong handle, jobject javaFd,
+        jlongArray addresses, jintArray byteCounts, jlong offset, jlong userData) {
+    prepareRwv(env, toIoUring(handle), javaFd, IORING_OP_WRITEV, addresses, byteCounts, offset, userData);
+}
+
+static void IoUring_prepareAcceptImpl(JNIEnv* env, jclass, jlong handle, jobject javaFd, jlong userData) {
+    IoUring* ring = toIoUring(handle);
+    io_uring_sqe* sqe = ring->prepare(env, javaFd, IORING_OP_ACCEPT, userData);
+    if (sqe == NULL) {
+        return;
+    }
+    ring->commit(sqe);
+}
+
+static void IoUring_prepareConnectImpl(JNIEnv* env, jclass, jlong handle, jobject javaFd,
+        jobject javaAddress, jint port, jlong userData) {
+    sockaddr_storage ss;
+    socklen_t sa_len;
+    if (!inetAddressToSockaddr(env, javaAddress, port, ss, sa_len)) {
+        return;
+    }
+    IoUring* ring = toIoUring(handle);
+    io_uring_sqe* sqe = ring->prepare(env, javaFd, IORING_OP_CONNECT, userData);
+    if (sqe == NULL) {
+        return;
+    }
+    IoUringSlot& slot = ring->slotFor(sqe);
+    memcpy(&slot.address, &ss, sa_len);
+    slot.addressLength = sa_len;
+    sqe->addr = reinterpret_cast<uintptr_t>(&slot.address);
+    sqe->off = sa_len;
+    ring->commit(sqe);
+}
+
+static void IoUring_prepareFsyncImpl(JNIEnv* env, jclass, jlong handle, jobject javaFd,
+        jboolean dataOnly, jlong userData) {
+    IoUring* ring = toIoUring(handle);
+    io_uring_sqe* sqe = ring->prepare(env, javaFd, IORING_OP_FSYNC, userData);
+    if (sqe == NULL) {
+        return;
+    }
+    sqe->fsync_flags = dataOnly ? IORING_FSYNC_DATASYNC : 0;
+    ring->commit(sqe);
+}
+
+static jboolean IoUring_cancelImpl(JNIEnv* env, jclass, jlong handle, jlong userData) {
+    return toIoUring(handle)->cancel(env, userData);
+}
+
+static jint IoUring_submitImpl(JNIEnv* env, jclass, jlong handle, jint minCompletions) {
+    IoUring* ring = toIoUring(handle);
+    int submitted = 0;
+    while (true) {
+        int rc;
+        if (minCompletions > 0) {
+            ScopedCloseMonitors monitors(ring);
+            rc = ring->enter(minCompletions);
+        } else {
+            rc = ring->enter(0);
+        }
+        if (rc == -1 && errno != EINTR) {
+            jniThrowErrnoException(env, "io_uring_enter", errno);
+            return -1;
+        }
+        if (rc > 0) {
+            submitted += rc;
+        }
+        if (minCompletions == 0) {
+            return submitted;
+        }
+        // We may have been woken because another thread closed one of our fds. If so, submit
+        // the cancellations without waiting so the caller can harvest the ECANCELED results.
+        size_t cancelled = ring->cancelClosed(env);
+        if (env->ExceptionCheck()) {
+            return -1;
+        } else if (cancelled > 0) {
+            minCompletions = 0;
+        } else if (rc != -1) {
+            return submitted;
+        }
+    }
+}
+
+static jint IoUring_harvestImpl(JNIEnv* env, jclass, jlong handle, jlongArray javaUserData, jintArray javaResults) {
+    ScopedLongArrayRW userData(env, javaUserData);
+    if (userData.get() == NULL) {
+        return -1;
+    }
+    ScopedIntArrayRW results(env, javaResults);
+    if (results.get() == NULL) {
+        return -1;
+    }
+    size_t count = (userData.size() < results.size()) ? userData.size() : results.size();
+    return toIoUring(handle)->harvest(env, userData.get(), results.get(), count);
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(IoUring, cancelImpl, "(JJ)Z"),
+    NATIVE_METHOD(IoUring, create, "(I)J"),
+    NATIVE_METHOD(IoUring, destroy, "(J)V"),
+    NATIVE_METHOD(IoUring, harvestImpl, "(J[J[I)I"),
+    NATIVE_METHOD(IoUring, prepareAcceptImpl, "(JLjava/io/FileDescriptor;J)V"),
+    NATIVE_METHOD(IoUring, prepareConnectImpl, "(JLjava/io/FileDescriptor;Ljava/net/InetAddress;IJ)V"),
+    NATIVE_METHOD(IoUring, prepareFsyncImpl, "(JLjava/io/FileDescriptor;ZJ)V"),
+    NATIVE_METHOD(IoUring, prepareReadImpl, "(JLjava/io/FileDescriptor;JIJJ)V"),
+    NATIVE_METHOD(IoUring, prepareReadvImpl, "(JLjava/io/FileDescriptor;[J[IJJ)V"),
+    NATIVE_METHOD(IoUring, prepareWriteImpl, "(JLjava/io/FileDescriptor;JIJJ)V"),
+    NATIVE_METHOD(IoUring, prepareWritevImpl, "(JLjava/io/FileDescriptor;[J[IJJ)V"),
+    NATIVE_METHOD(IoUring, submitImpl, "(JI)I"),
+};
+
+#else
+
+// Without io_uring, only create is registered; it always fails, so nothing else is reachable.
+static jlong IoUring_create(JNIEnv* env, jclass, jint) {
+    jniThrowErrnoException(env, "io_uring_setup", ENOSYS);
+    return 0;
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(IoUring, create, "(I)J"),
+};
+
+#endif
+
+void register_libcore_io_IoUring(JNIEnv* env) {
+    jniRegisterNativeMethods(env, "libcore/io/IoUring", gMethods, NELEM(gMethods));
+}
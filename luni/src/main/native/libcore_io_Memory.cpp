@@ -18,6 +18,7 @@
 
 #include "JNIHelp.h"
 #include "JniConstants.h"
+#include "JniException.h"
 #include "Portability.h"
 #include "ScopedBytes.h"
 #include "ScopedPrimitiveArray.h"
@@ -27,6 +28,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#if defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 #if defined(__arm__)
 // 32-bit ARM has load/store alignment restrictions for longs.
@@ -78,7 +90,94 @@ static inline jint bswap_2x16(jint v) {
     return v;
 }
 
+// Vector kernels that byte-swap whole 16-byte blocks of WIDTH-byte elements. They use unaligned
+// loads and stores, so the same loop handles any alignment; callers only fall back to the
+// scalar code for the last few elements. Which kernel we get is decided by the ISA the target
+// is built for: x86 Android requires SSSE3 (and x86-64 always has SSE2), and the NEON variants
+// of the ARM targets define __ARM_NEON__. Each kernel returns the number of bytes it swapped.
+#if defined(__SSE2__)
+
+template <size_t WIDTH> static inline __m128i swapVector(__m128i v);
+
+#if defined(__SSSE3__)
+template <> inline __m128i swapVector<2>(__m128i v) {
+    return _mm_shuffle_epi8(v, _mm_set_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1));
+}
+template <> inline __m128i swapVector<4>(__m128i v) {
+    return _mm_shuffle_epi8(v, _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3));
+}
+template <> inline __m128i swapVector<8>(__m128i v) {
+    return _mm_shuffle_epi8(v, _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7));
+}
+#else
+// Plain SSE2 has no byte shuffle, so swap the bytes of each 16-bit lane with shifts, and then
+// reorder the lanes.
+static inline __m128i swapBytesInLanes(__m128i v) {
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+template <> inline __m128i swapVector<2>(__m128i v) {
+    return swapBytesInLanes(v);
+}
+template <> inline __m128i swapVector<4>(__m128i v) {
+    v = _mm_shufflelo_epi16(swapBytesInLanes(v), _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+}
+template <> inline __m128i swapVector<8>(__m128i v) {
+    v = _mm_shufflelo_epi16(swapBytesInLanes(v), _MM_SHUFFLE(0, 1, 2, 3));
+    return _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+#endif
+
+template <size_t WIDTH> static inline size_t swapBlocks(void* dst, const void* src, size_t byteCount) {
+    __m128i* d = reinterpret_cast<__m128i*>(dst);
+    const __m128i* s = reinterpret_cast<const __m128i*>(src);
+    size_t blockCount = byteCount / sizeof(__m128i);
+    for (size_t i = 0; i < blockCount; ++i) {
+        _mm_storeu_si128(d++, swapVector<WIDTH>(_mm_loadu_si128(s++)));
+    }
+    return blockCount * sizeof(__m128i);
+}
+
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+
+template <size_t WIDTH> static inline uint8x16_t swapVector(uint8x16_t v);
+template <> inline uint8x16_t swapVector<2>(uint8x16_t v) {
+    return vrev16q_u8(v);
+}
+template <> inline uint8x16_t swapVector<4>(uint8x16_t v) {
+    return vrev32q_u8(v);
+}
+template <> inline uint8x16_t swapVector<8>(uint8x16_t v) {
+    return vrev64q_u8(v);
+}
+
+template <size_t WIDTH> static inline size_t swapBlocks(void* dst, const void* src, size_t byteCount) {
+    uint8_t* d = reinterpret_cast<uint8_t*>(dst);
+    const uint8_t* s = reinterpret_cast<const uint8_t*>(src);
+    size_t blockCount = byteCount / 16;
+    for (size_t i = 0; i < blockCount; ++i) {
+        vst1q_u8(d, swapVector<WIDTH>(vld1q_u8(s)));
+        d += 16;
+        s += 16;
+    }
+    return blockCount * 16;
+}
+
+#else
+
+// No vector unit we know how to use; everything goes through the scalar loops.
+template <size_t WIDTH> static inline size_t swapBlocks(void*, const void*, size_t) {
+    return 0;
+}
+
+#endif
+
 static inline void swapShorts(jshort* dstShorts, const jshort* srcShorts, size_t count) {
+    size_t done = swapBlocks<2>(dstShorts, srcShorts, count * sizeof(jshort)) / sizeof(jshort);
+    dstShorts += done;
+    srcShorts += done;
+    count -= done;
+
     // Do 32-bit swaps as long as possible...
     jint* dst = reinterpret_cast<jint*>(dstShorts);
     const jint* src = reinterpret_cast<const jint*>(srcShorts);
@@ -107,6 +206,11 @@ static inline void swapShorts(jshort* dstShorts, const jshort* srcShorts, size_t
 }
 
 static inline void swapInts(jint* dstInts, const jint* srcInts, size_t count) {
+    size_t done = swapBlocks<4>(dstInts, srcInts, count * sizeof(jint)) / sizeof(jint);
+    dstInts += done;
+    srcInts += done;
+    count -= done;
+
     if ((reinterpret_cast<uintptr_t>(dstInts) & INT_ALIGNMENT_MASK) == 0 &&
         (reinterpret_cast<uintptr_t>(srcInts) & INT_ALIGNMENT_MASK) == 0) {
         for (size_t i = 0; i < count; ++i) {
@@ -122,6 +226,11 @@ static inline void swapInts(jint* dstInts, const jint* srcInts, size_t count) {
 }
 
 static inline void swapLongs(jlong* dstLongs, const jlong* srcLongs, size_t count) {
+    size_t done = swapBlocks<8>(dstLongs, srcLongs, count * sizeof(jlong)) / sizeof(jlong);
+    dstLongs += done;
+    srcLongs += done;
+    count -= done;
+
     jint* dst = reinterpret_cast<jint*>(dstLongs);
     const jint* src = reinterpret_cast<const jint*>(srcLongs);
     if ((reinterpret_cast<uintptr_t>(dstLongs) & INT_ALIGNMENT_MASK) == 0 &&
@@ -315,6 +424,33 @@ static void Memory_pokeLong(JNIEnv*, jclass, jlong dstAddress, jlong value, jboo
     }
 }
 
+// Added in Linux 5.14, to both the uapi headers and the kernel, so older headers need this
+// definition. Faults pages in for reading without touching them, and reports EFAULT instead of
+// raising SIGBUS for pages beyond the end of a truncated file.
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22
+#endif
+
+static void Memory_prefault(JNIEnv* env, jclass, jlong address, jlong byteCount) {
+    if (byteCount <= 0) {
+        return;
+    }
+    static const uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+    uintptr_t start = static_cast<uintptr_t>(address) & ~(pageSize - 1);
+    uintptr_t end = static_cast<uintptr_t>(address + byteCount);
+    if (madvise(reinterpret_cast<void*>(start), end - start, MADV_POPULATE_READ) == 0) {
+        return;
+    }
+    if (errno != EINVAL) {
+        jniThrowErrnoException(env, "madvise", errno);
+        return;
+    }
+    // Older kernels don't know MADV_POPULATE_READ, so read a byte from each page instead.
+    for (uintptr_t page = start; page < end; page += pageSize) {
+        (void) *reinterpret_cast<volatile const jbyte*>(page);
+    }
+}
+
 static void unsafeBulkCopy(jbyte* dst, const jbyte* src, jint byteCount,
         jint sizeofElement, jboolean swap) {
     if (!swap) {
@@ -395,6 +531,7 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Memory, pokeLongArray, "(J[JIIZ)V"),
     NATIVE_METHOD(Memory, pokeShort, "!(JSZ)V"),
     NATIVE_METHOD(Memory, pokeShortArray, "(J[SIIZ)V"),
+    NATIVE_METHOD(Memory, prefault, "(JJ)V"),
     NATIVE_METHOD(Memory, unsafeBulkGet, "(Ljava/lang/Object;II[BIIZ)V"),
     NATIVE_METHOD(Memory, unsafeBulkPut, "([BIILjava/lang/Object;IIZ)V"),
 };
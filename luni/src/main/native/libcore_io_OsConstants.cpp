@@ -28,6 +28,9 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <sys/capability.h>
+#if !defined(__APPLE__)
+#include <sys/epoll.h>
+#endif
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/socket.h>
@@ -172,6 +175,22 @@ static void OsConstants_initConstants(JNIEnv* env, jclass c) {
     initConstant(env, c, "EOVERFLOW", EOVERFLOW);
     initConstant(env, c, "EPERM", EPERM);
     initConstant(env, c, "EPIPE", EPIPE);
+#if defined(EPOLLIN)
+    initConstant(env, c, "EPOLLERR", EPOLLERR);
+    initConstant(env, c, "EPOLLET", EPOLLET);
+    initConstant(env, c, "EPOLLHUP", EPOLLHUP);
+    initConstant(env, c, "EPOLLIN", EPOLLIN);
+    initConstant(env, c, "EPOLLONESHOT", EPOLLONESHOT);
+    initConstant(env, c, "EPOLLOUT", EPOLLOUT);
+    initConstant(env, c, "EPOLLPRI", EPOLLPRI);
+#if defined(EPOLLRDHUP)
+    initConstant(env, c, "EPOLLRDHUP", EPOLLRDHUP);
+#endif
+    initConstant(env, c, "EPOLL_CLOEXEC", EPOLL_CLOEXEC);
+    initConstant(env, c, "EPOLL_CTL_ADD", EPOLL_CTL_ADD);
+    initConstant(env, c, "EPOLL_CTL_DEL", EPOLL_CTL_DEL);
+    initConstant(env, c, "EPOLL_CTL_MOD", EPOLL_CTL_MOD);
+#endif
     initConstant(env, c, "EPROTO", EPROTO);
     initConstant(env, c, "EPROTONOSUPPORT", EPROTONOSUPPORT);
     initConstant(env, c, "EPROTOTYPE", EPROTOTYPE);
@@ -279,7 +298,24 @@ static void OsConstants_initConstants(JNIEnv* env, jclass c) {
     initConstant(env, c, "IP_MULTICAST_TTL", IP_MULTICAST_TTL);
     initConstant(env, c, "IP_TOS", IP_TOS);
     initConstant(env, c, "IP_TTL", IP_TTL);
+    initConstant(env, c, "MADV_DONTNEED", MADV_DONTNEED);
+#if defined(MADV_HUGEPAGE)
+    initConstant(env, c, "MADV_HUGEPAGE", MADV_HUGEPAGE);
+#endif
+#if defined(MADV_NOHUGEPAGE)
+    initConstant(env, c, "MADV_NOHUGEPAGE", MADV_NOHUGEPAGE);
+#endif
+    initConstant(env, c, "MADV_NORMAL", MADV_NORMAL);
+    initConstant(env, c, "MADV_RANDOM", MADV_RANDOM);
+    initConstant(env, c, "MADV_SEQUENTIAL", MADV_SEQUENTIAL);
+    initConstant(env, c, "MADV_WILLNEED", MADV_WILLNEED);
     initConstant(env, c, "MAP_FIXED", MAP_FIXED);
+#if defined(MAP_HUGETLB)
+    initConstant(env, c, "MAP_HUGETLB", MAP_HUGETLB);
+#endif
+#if defined(MAP_POPULATE)
+    initConstant(env, c, "MAP_POPULATE", MAP_POPULATE);
+#endif
     initConstant(env, c, "MAP_PRIVATE", MAP_PRIVATE);
     initConstant(env, c, "MAP_SHARED", MAP_SHARED);
 #if defined(MCAST_JOIN_GROUP)
@@ -297,6 +333,9 @@ static void OsConstants_initConstants(JNIEnv* env, jclass c) {
     initConstant(env, c, "MSG_PEEK", MSG_PEEK);
     initConstant(env, c, "MSG_TRUNC", MSG_TRUNC);
     initConstant(env, c, "MSG_WAITALL", MSG_WAITALL);
+#if defined(MSG_WAITFORONE)
+    initConstant(env, c, "MSG_WAITFORONE", MSG_WAITFORONE);
+#endif
     initConstant(env, c, "MS_ASYNC", MS_ASYNC);
     initConstant(env, c, "MS_INVALIDATE", MS_INVALIDATE);
     initConstant(env, c, "MS_SYNC", MS_SYNC);
@@ -327,6 +366,12 @@ static void OsConstants_initConstants(JNIEnv* env, jclass c) {
     initConstant(env, c, "POLLRDNORM", POLLRDNORM);
     initConstant(env, c, "POLLWRBAND", POLLWRBAND);
     initConstant(env, c, "POLLWRNORM", POLLWRNORM);
+    initConstant(env, c, "POSIX_FADV_DONTNEED", POSIX_FADV_DONTNEED);
+    initConstant(env, c, "POSIX_FADV_NOREUSE", POSIX_FADV_NOREUSE);
+    initConstant(env, c, "POSIX_FADV_NORMAL", POSIX_FADV_NORMAL);
+    initConstant(env, c, "POSIX_FADV_RANDOM", POSIX_FADV_RANDOM);
+    initConstant(env, c, "POSIX_FADV_SEQUENTIAL", POSIX_FADV_SEQUENTIAL);
+    initConstant(env, c, "POSIX_FADV_WILLNEED", POSIX_FADV_WILLNEED);
     initConstant(env, c, "PROT_EXEC", PROT_EXEC);
     initConstant(env, c, "PROT_NONE", PROT_NONE);
     initConstant(env, c, "PROT_READ", PROT_READ);
@@ -408,6 +453,11 @@ static void OsConstants_initConstants(JNIEnv* env, jclass c) {
     initConstant(env, c, "SO_SNDLOWAT", SO_SNDLOWAT);
     initConstant(env, c, "SO_SNDTIMEO", SO_SNDTIMEO);
     initConstant(env, c, "SO_TYPE", SO_TYPE);
+#if defined(SPLICE_F_MOVE)
+    initConstant(env, c, "SPLICE_F_MORE", SPLICE_F_MORE);
+    initConstant(env, c, "SPLICE_F_MOVE", SPLICE_F_MOVE);
+    initConstant(env, c, "SPLICE_F_NONBLOCK", SPLICE_F_NONBLOCK);
+#endif
     initConstant(env, c, "STDERR_FILENO", STDERR_FILENO);
     initConstant(env, c, "STDIN_FILENO", STDIN_FILENO);
     initConstant(env, c, "STDOUT_FILENO", STDOUT_FILENO);
@@ -22,6 +22,8 @@
 #include "JNIHelp.h"
 #include "JniConstants.h"
 #include "JniException.h"
+#include "LocalArray.h"
+#include "NativeCounters.h"
 #include "NetworkUtilities.h"
 #include "Portability.h"
 #include "ScopedBytes.h"
@@ -42,11 +44,17 @@
 #include <pwd.h>
 #include <signal.h>
 #include <stdlib.h>
+#if !defined(__APPLE__)
+#include <sys/epoll.h>
+#endif
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
+#if defined(__linux__)
+#include <sys/sysmacros.h>
+#endif
 #include <sys/time.h>
 #include <sys/types.h>
 #include <sys/uio.h>
@@ -67,6 +75,17 @@ struct addrinfo_deleter {
     }
 };
 
+/**
+ * Like <unistd.h>'s TEMP_FAILURE_RETRY, but counts each retry for NativeCounters.
+ */
+#undef TEMP_FAILURE_RETRY
+#define TEMP_FAILURE_RETRY(exp) ({ \
+    __typeof__(exp) _rc; \
+    while ((_rc = (exp)) == -1 && errno == EINTR) { \
+        nativeCounterAdd(COUNTER_EINTR_RETRIES, 1); \
+    } \
+    _rc; })
+
 /**
  * Used to retry networking system calls that can return EINTR. Unlike TEMP_FAILURE_RETRY,
  * this also handles the case where the reason for failure is that another thread called
@@ -79,6 +98,7 @@ struct addrinfo_deleter {
     do { \
         { \
             int _fd = jniGetFDFromFileDescriptor(jni_env, java_fd); \
+            ScopedNativeTrace _trace(# syscall_name); \
             AsynchronousSocketCloseMonitor _monitor(_fd); \
             _rc = syscall_name(_fd, __VA_ARGS__); \
         } \
@@ -91,6 +111,7 @@ struct addrinfo_deleter {
                 throwErrnoException(jni_env, # syscall_name); \
                 break; \
             } \
+            nativeCounterAdd(COUNTER_EINTR_RETRIES, 1); \
         } \
     } while (_rc == -1); \
     _rc; })
@@ -212,6 +233,77 @@ private:
     std::vector<ScopedT*> mScopedBuffers;
 };
 
+/**
+ * Like IoVec, but for buffers whose native addresses the caller has already resolved (direct
+ * buffers or pooled native memory), so there's nothing to pin and no local references to keep.
+ * Small vectors don't touch the heap either.
+ */
+class AddressIoVec {
+public:
+    AddressIoVec(JNIEnv* env, jlongArray javaAddresses)
+            : mEnv(env), mJavaAddresses(javaAddresses),
+              mBufferCount(env->GetArrayLength(javaAddresses)),
+              mIoVec(mBufferCount * sizeof(iovec)) {
+    }
+
+    bool init(jintArray javaByteCounts) {
+        ScopedLongArrayRO addresses(mEnv, mJavaAddresses);
+        if (addresses.get() == NULL) {
+            return false;
+        }
+        ScopedIntArrayRO byteCounts(mEnv, javaByteCounts);
+        if (byteCounts.get() == NULL) {
+            return false;
+        }
+        if (byteCounts.size() != mBufferCount) {
+            jniThrowException(mEnv, "java/lang/IllegalArgumentException", "addresses.length != byteCounts.length");
+            return false;
+        }
+        iovec* iov = get();
+        for (size_t i = 0; i < mBufferCount; ++i) {
+            iov[i].iov_base = reinterpret_cast<void*>(static_cast<uintptr_t>(addresses[i]));
+            iov[i].iov_len = byteCounts[i];
+        }
+        return true;
+    }
+
+    iovec* get() {
+        return reinterpret_cast<iovec*>(&mIoVec[0]);
+    }
+
+    size_t size() {
+        return mBufferCount;
+    }
+
+private:
+    JNIEnv* mEnv;
+    jlongArray mJavaAddresses;
+    size_t mBufferCount;
+    LocalArray<16 * sizeof(iovec)> mIoVec;
+
+    // Disallow copy and assignment.
+    AddressIoVec(const AddressIoVec&);
+    void operator=(const AddressIoVec&);
+};
+
+#if !defined(__APPLE__)
+// Not every libc we build against has preadv(2) and pwritev(2), so we go straight to the kernel.
+// The syscalls take the offset as two longs, which works the same for 32- and 64-bit callers.
+static ssize_t preadvSyscall(int fd, const iovec* iov, int iovCount, int64_t offset) {
+    uint64_t position = offset;
+    unsigned long low = position;
+    unsigned long high = (position >> (sizeof(long) * 4)) >> (sizeof(long) * 4);
+    return syscall(__NR_preadv, fd, iov, iovCount, low, high);
+}
+
+static ssize_t pwritevSyscall(int fd, const iovec* iov, int iovCount, int64_t offset) {
+    uint64_t position = offset;
+    unsigned long low = position;
+    unsigned long high = (position >> (sizeof(long) * 4)) >> (sizeof(long) * 4);
+    return syscall(__NR_pwritev, fd, iov, iovCount, low, high);
+}
+#endif
+
 static jobject makeSocketAddress(JNIEnv* env, const sockaddr_storage& ss) {
     jint port;
     jobject inetAddress = sockaddrToInetAddress(env, ss, &port);
@@ -315,13 +407,14 @@ static bool fillInetSocketAddress(JNIEnv* env, jint rc, jobject javaInetSocketAd
     }
     // Fill out the passed-in InetSocketAddress with the sender's IP address and port number.
     jint port;
-    jobject sender = sockaddrToInetAddress(env, ss, &port);
-    if (sender == NULL) {
+    // recvmmsg calls this once per datagram, so don't leave a local reference behind each time.
+    ScopedLocalRef<jobject> sender(env, sockaddrToInetAddress(env, ss, &port));
+    if (sender.get() == NULL) {
         return false;
     }
     static jfieldID addressFid = env->GetFieldID(JniConstants::inetSocketAddressClass, "addr", "Ljava/net/InetAddress;");
     static jfieldID portFid = env->GetFieldID(JniConstants::inetSocketAddressClass, "port", "I");
-    env->SetObjectField(javaInetSocketAddress, addressFid, sender);
+    env->SetObjectField(javaInetSocketAddress, addressFid, sender.get());
     env->SetIntField(javaInetSocketAddress, portFid, port);
     return true;
 }
@@ -356,6 +449,45 @@ static jobject doGetSockName(JNIEnv* env, jobject javaFd, bool is_sockname) {
   return makeSocketAddress(env, ss);
 }
 
+/**
+ * Wraps an optional libcore.util.MutableLong file offset for the splice(2) family of calls.
+ * A NULL MutableLong means "use and update the fd's own file offset", which these calls
+ * express as a NULL pointer.
+ */
+class MutableLongOffset {
+public:
+    MutableLongOffset(JNIEnv* env, jobject javaOffset) : mEnv(env), mJavaOffset(javaOffset), mOffset(0) {
+        if (mJavaOffset != NULL) {
+            mOffset = mEnv->GetLongField(mJavaOffset, valueFid(mEnv));
+        }
+    }
+
+    loff_t* get() {
+        return (mJavaOffset != NULL) ? &mOffset : NULL;
+    }
+
+    // Writes the updated offset back. Only call this if the syscall succeeded.
+    void writeBack() {
+        if (mJavaOffset != NULL) {
+            mEnv->SetLongField(mJavaOffset, valueFid(mEnv), mOffset);
+        }
+    }
+
+private:
+    static jfieldID valueFid(JNIEnv* env) {
+        static jfieldID fid = env->GetFieldID(JniConstants::mutableLongClass, "value", "J");
+        return fid;
+    }
+
+    JNIEnv* mEnv;
+    jobject mJavaOffset;
+    loff_t mOffset;
+
+    // Disallow copy and assignment.
+    MutableLongOffset(const MutableLongOffset&);
+    void operator=(const MutableLongOffset&);
+};
+
 class Passwd {
 public:
     Passwd(JNIEnv* env) : mEnv(env), mResult(NULL) {
@@ -468,6 +600,29 @@ static void Posix_connect(JNIEnv* env, jobject, jobject javaFd, jobject javaAddr
     (void) NET_FAILURE_RETRY(env, int, connect, javaFd, sa, sa_len);
 }
 
+#if defined(__NR_copy_file_range)
+static jlong Posix_copy_file_range(JNIEnv* env, jobject, jobject javaFdIn, jobject javaInOffset, jobject javaFdOut, jobject javaOutOffset, jlong byteCount, jint flags) {
+    int fdIn = jniGetFDFromFileDescriptor(env, javaFdIn);
+    int fdOut = jniGetFDFromFileDescriptor(env, javaFdOut);
+    MutableLongOffset inOffset(env, javaInOffset);
+    MutableLongOffset outOffset(env, javaOutOffset);
+    // Neither bionic nor older glibc have a wrapper, so go straight to the kernel.
+    jlong result = throwIfMinusOne(env, "copy_file_range", TEMP_FAILURE_RETRY(syscall(__NR_copy_file_range,
+            fdIn, inOffset.get(), fdOut, outOffset.get(), static_cast<size_t>(byteCount), flags)));
+    if (result != -1) {
+        inOffset.writeBack();
+        outOffset.writeBack();
+    }
+    return result;
+}
+#else
+static jlong Posix_copy_file_range(JNIEnv* env, jobject, jobject, jobject, jobject, jobject, jlong, jint) {
+    errno = ENOSYS;
+    throwErrnoException(env, "copy_file_range");
+    return -1;
+}
+#endif
+
 static jobject Posix_dup(JNIEnv* env, jobject, jobject javaOldFd) {
     int oldFd = jniGetFDFromFileDescriptor(env, javaOldFd);
     int newFd = throwIfMinusOne(env, "dup", TEMP_FAILURE_RETRY(dup(oldFd)));
@@ -485,6 +640,69 @@ static jobjectArray Posix_environ(JNIEnv* env, jobject) {
     return toStringArray(env, environ);
 }
 
+#if defined(__APPLE__)
+static jobject Posix_epoll_create(JNIEnv*, jobject, jint) { abort(); }
+static void Posix_epoll_ctl(JNIEnv*, jobject, jobject, jint, jobject, jint, jlong) { abort(); }
+static jint Posix_epoll_waitBytes(JNIEnv*, jobject, jobject, jobject, jint, jint, jint) { abort(); }
+#else
+static jobject Posix_epoll_create(JNIEnv* env, jobject, jint flags) {
+    int fd = throwIfMinusOne(env, "epoll_create1", TEMP_FAILURE_RETRY(epoll_create1(flags)));
+    return fd != -1 ? jniCreateFileDescriptor(env, fd) : NULL;
+}
+
+static void Posix_epoll_ctl(JNIEnv* env, jobject, jobject javaEpFd, jint op, jobject javaFd, jint events, jlong data) {
+    int epFd = jniGetFDFromFileDescriptor(env, javaEpFd);
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    // EPOLL_CTL_DEL ignores the event, but kernels before 2.6.9 insist on a non-NULL pointer.
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = data;
+    throwIfMinusOne(env, "epoll_ctl", TEMP_FAILURE_RETRY(epoll_ctl(epFd, op, fd, &event)));
+}
+
+/*
+ * struct epoll_event is packed on x86 but not on ARM, so rather than expose either layout we
+ * copy the ready events into fixed 16-byte records (see Os.epoll_wait). Only ready events are
+ * copied, so the cost of a wakeup is independent of the number of registered fds.
+ */
+static jint Posix_epoll_waitBytes(JNIEnv* env, jobject, jobject javaEpFd, jobject javaBytes, jint byteOffset, jint maxEvents, jint timeoutMs) {
+    if (maxEvents <= 0) {
+        jniThrowException(env, "java/lang/IllegalArgumentException", "buffer too small for an event");
+        return -1;
+    }
+    ScopedBytesRW bytes(env, javaBytes);
+    if (bytes.get() == NULL) {
+        return -1;
+    }
+    LocalArray<64 * sizeof(epoll_event)> events(maxEvents * sizeof(epoll_event));
+    epoll_event* eventsPtr = reinterpret_cast<epoll_event*>(&events[0]);
+    int epFd = jniGetFDFromFileDescriptor(env, javaEpFd);
+    int rc;
+    {
+        // The fds in the set may be sockets, but we can only cheaply monitor the epoll fd itself.
+        // Closing a registered socket removes it from the set without waking us, so callers that
+        // need Socket.close semantics should close the epoll fd or use a wakeup pipe.
+        AsynchronousSocketCloseMonitor monitor(epFd);
+        rc = epoll_wait(epFd, eventsPtr, maxEvents, timeoutMs);
+    }
+    if (rc == -1) {
+        throwErrnoException(env, "epoll_wait");
+        return -1;
+    }
+    jbyte* dst = bytes.get() + byteOffset;
+    for (int i = 0; i < rc; ++i) {
+        jint readyEvents = eventsPtr[i].events;
+        jlong data = eventsPtr[i].data.u64;
+        memcpy(dst, &readyEvents, sizeof(readyEvents));
+        memset(dst + sizeof(readyEvents), 0, sizeof(jlong) - sizeof(readyEvents));
+        memcpy(dst + sizeof(jlong), &data, sizeof(data));
+        dst += 2 * sizeof(jlong);
+    }
+    return rc;
+}
+#endif
+
 static void Posix_execve(JNIEnv* env, jobject, jstring javaFilename, jobjectArray javaArgv, jobjectArray javaEnvp) {
     ScopedUtfChars path(env, javaFilename);
     if (path.c_str() == NULL) {
@@ -889,6 +1107,11 @@ static jobject Posix_lstat(JNIEnv* env, jobject, jstring javaPath) {
     return doStat(env, javaPath, true);
 }
 
+static void Posix_madvise(JNIEnv* env, jobject, jlong address, jlong byteCount, jint advice) {
+    void* ptr = reinterpret_cast<void*>(static_cast<uintptr_t>(address));
+    throwIfMinusOne(env, "madvise", TEMP_FAILURE_RETRY(madvise(ptr, byteCount, advice)));
+}
+
 static void Posix_mincore(JNIEnv* env, jobject, jlong address, jlong byteCount, jbyteArray javaVector) {
     ScopedByteArrayRW vector(env, javaVector);
     if (vector.get() == NULL) {
@@ -1016,6 +1239,49 @@ static jint Posix_poll(JNIEnv* env, jobject, jobjectArray javaStructs, jint time
     return rc;
 }
 
+#if defined(__APPLE__)
+static void Posix_posix_fadvise(JNIEnv*, jobject, jobject, jlong, jlong, jint) { abort(); }
+#else
+static void Posix_posix_fadvise(JNIEnv* env, jobject, jobject javaFd, jlong offset, jlong length, jint advice) {
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    // posix_fadvise(2) returns an error number rather than setting errno.
+    int rc = posix_fadvise64(fd, offset, length, advice);
+    if (rc != 0) {
+        errno = rc;
+        throwErrnoException(env, "posix_fadvise");
+    }
+}
+#endif
+
+static jint Posix_preadAddress(JNIEnv* env, jobject, jobject javaFd, jlong address, jint byteCount, jlong offset) {
+    void* ptr = reinterpret_cast<void*>(static_cast<uintptr_t>(address));
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    return throwIfMinusOne(env, "pread", TEMP_FAILURE_RETRY(pread64(fd, ptr, byteCount, offset)));
+}
+
+#if defined(__APPLE__)
+static jint Posix_preadv(JNIEnv*, jobject, jobject, jobjectArray, jintArray, jintArray, jlong) { abort(); }
+static jint Posix_preadvAddresses(JNIEnv*, jobject, jobject, jlongArray, jintArray, jlong) { abort(); }
+#else
+static jint Posix_preadv(JNIEnv* env, jobject, jobject javaFd, jobjectArray buffers, jintArray offsets, jintArray byteCounts, jlong offset) {
+    IoVec<ScopedBytesRW> ioVec(env, env->GetArrayLength(buffers));
+    if (!ioVec.init(buffers, offsets, byteCounts)) {
+        return -1;
+    }
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    return throwIfMinusOne(env, "preadv", TEMP_FAILURE_RETRY(preadvSyscall(fd, ioVec.get(), ioVec.size(), offset)));
+}
+
+static jint Posix_preadvAddresses(JNIEnv* env, jobject, jobject javaFd, jlongArray addresses, jintArray byteCounts, jlong offset) {
+    AddressIoVec ioVec(env, addresses);
+    if (!ioVec.init(byteCounts)) {
+        return -1;
+    }
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    return throwIfMinusOne(env, "preadv", TEMP_FAILURE_RETRY(preadvSyscall(fd, ioVec.get(), ioVec.size(), offset)));
+}
+#endif
+
 static jint Posix_preadBytes(JNIEnv* env, jobject, jobject javaFd, jobject javaBytes, jint byteOffset, jint byteCount, jlong offset) {
     ScopedBytesRW bytes(env, javaBytes);
     if (bytes.get() == NULL) {
@@ -1025,6 +1291,35 @@ static jint Posix_preadBytes(JNIEnv* env, jobject, jobject javaFd, jobject javaB
     return throwIfMinusOne(env, "pread", TEMP_FAILURE_RETRY(pread64(fd, bytes.get() + byteOffset, byteCount, offset)));
 }
 
+static jint Posix_pwriteAddress(JNIEnv* env, jobject, jobject javaFd, jlong address, jint byteCount, jlong offset) {
+    const void* ptr = reinterpret_cast<const void*>(static_cast<uintptr_t>(address));
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    return throwIfMinusOne(env, "pwrite", TEMP_FAILURE_RETRY(pwrite64(fd, ptr, byteCount, offset)));
+}
+
+#if defined(__APPLE__)
+static jint Posix_pwritev(JNIEnv*, jobject, jobject, jobjectArray, jintArray, jintArray, jlong) { abort(); }
+static jint Posix_pwritevAddresses(JNIEnv*, jobject, jobject, jlongArray, jintArray, jlong) { abort(); }
+#else
+static jint Posix_pwritev(JNIEnv* env, jobject, jobject javaFd, jobjectArray buffers, jintArray offsets, jintArray byteCounts, jlong offset) {
+    IoVec<ScopedBytesRO> ioVec(env, env->GetArrayLength(buffers));
+    if (!ioVec.init(buffers, offsets, byteCounts)) {
+        return -1;
+    }
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    return throwIfMinusOne(env, "pwritev", TEMP_FAILURE_RETRY(pwritevSyscall(fd, ioVec.get(), ioVec.size(), offset)));
+}
+
+static jint Posix_pwritevAddresses(JNIEnv* env, jobject, jobject javaFd, jlongArray addresses, jintArray byteCounts, jlong offset) {
+    AddressIoVec ioVec(env, addresses);
+    if (!ioVec.init(byteCounts)) {
+        return -1;
+    }
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    return throwIfMinusOne(env, "pwritev", TEMP_FAILURE_RETRY(pwritevSyscall(fd, ioVec.get(), ioVec.size(), offset)));
+}
+#endif
+
 static jint Posix_pwriteBytes(JNIEnv* env, jobject, jobject javaFd, jbyteArray javaBytes, jint byteOffset, jint byteCount, jlong offset) {
     ScopedBytesRO bytes(env, javaBytes);
     if (bytes.get() == NULL) {
@@ -1034,6 +1329,12 @@ static jint Posix_pwriteBytes(JNIEnv* env, jobject, jobject javaFd, jbyteArray j
     return throwIfMinusOne(env, "pwrite", TEMP_FAILURE_RETRY(pwrite64(fd, bytes.get() + byteOffset, byteCount, offset)));
 }
 
+static jint Posix_readAddress(JNIEnv* env, jobject, jobject javaFd, jlong address, jint byteCount) {
+    void* ptr = reinterpret_cast<void*>(static_cast<uintptr_t>(address));
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    return throwIfMinusOne(env, "read", TEMP_FAILURE_RETRY(read(fd, ptr, byteCount)));
+}
+
 static jint Posix_readBytes(JNIEnv* env, jobject, jobject javaFd, jobject javaBytes, jint byteOffset, jint byteCount) {
     ScopedBytesRW bytes(env, javaBytes);
     if (bytes.get() == NULL) {
@@ -1043,6 +1344,15 @@ static jint Posix_readBytes(JNIEnv* env, jobject, jobject javaFd, jobject javaBy
     return throwIfMinusOne(env, "read", TEMP_FAILURE_RETRY(read(fd, bytes.get() + byteOffset, byteCount)));
 }
 
+#if defined(__APPLE__)
+static void Posix_readahead(JNIEnv*, jobject, jobject, jlong, jlong) { abort(); }
+#else
+static void Posix_readahead(JNIEnv* env, jobject, jobject javaFd, jlong offset, jlong byteCount) {
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    throwIfMinusOne(env, "readahead", TEMP_FAILURE_RETRY(readahead(fd, offset, byteCount)));
+}
+#endif
+
 static jint Posix_readv(JNIEnv* env, jobject, jobject javaFd, jobjectArray buffers, jintArray offsets, jintArray byteCounts) {
     IoVec<ScopedBytesRW> ioVec(env, env->GetArrayLength(buffers));
     if (!ioVec.init(buffers, offsets, byteCounts)) {
@@ -1052,6 +1362,15 @@ static jint Posix_readv(JNIEnv* env, jobject, jobject javaFd, jobjectArray buffe
     return throwIfMinusOne(env, "readv", TEMP_FAILURE_RETRY(readv(fd, ioVec.get(), ioVec.size())));
 }
 
+static jint Posix_readvAddresses(JNIEnv* env, jobject, jobject javaFd, jlongArray addresses, jintArray byteCounts) {
+    AddressIoVec ioVec(env, addresses);
+    if (!ioVec.init(byteCounts)) {
+        return -1;
+    }
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    return throwIfMinusOne(env, "readv", TEMP_FAILURE_RETRY(readv(fd, ioVec.get(), ioVec.size())));
+}
+
 static jint Posix_recvfromBytes(JNIEnv* env, jobject, jobject javaFd, jobject javaBytes, jint byteOffset, jint byteCount, jint flags, jobject javaInetSocketAddress) {
     ScopedBytesRW bytes(env, javaBytes);
     if (bytes.get() == NULL) {
@@ -1067,6 +1386,52 @@ static jint Posix_recvfromBytes(JNIEnv* env, jobject, jobject javaFd, jobject ja
     return recvCount;
 }
 
+#if defined(__APPLE__)
+static jint Posix_recvmmsgBytes(JNIEnv*, jobject, jobject, jobject, jint, jint, jint, jint, jobjectArray, jintArray) { abort(); }
+#else
+static jint Posix_recvmmsgBytes(JNIEnv* env, jobject, jobject javaFd, jobject javaBytes, jint byteOffset, jint slotByteCount, jint messageCount, jint flags, jobjectArray javaSrcAddresses, jintArray javaResults) {
+    ScopedBytesRW bytes(env, javaBytes);
+    if (bytes.get() == NULL) {
+        return -1;
+    }
+    // One slot per message, all in the same pinned buffer.
+    std::vector<mmsghdr> msgs(messageCount);
+    std::vector<iovec> iovs(messageCount);
+    std::vector<sockaddr_storage> addresses(javaSrcAddresses != NULL ? messageCount : 0);
+    memset(&msgs[0], 0, sizeof(mmsghdr) * messageCount);
+    for (jint i = 0; i < messageCount; ++i) {
+        iovs[i].iov_base = bytes.get() + byteOffset + i * slotByteCount;
+        iovs[i].iov_len = slotByteCount;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        if (javaSrcAddresses != NULL) {
+            memset(&addresses[i], 0, sizeof(sockaddr_storage));
+            msgs[i].msg_hdr.msg_name = &addresses[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        }
+    }
+    int rc = NET_FAILURE_RETRY(env, int, recvmmsg, javaFd, &msgs[0], messageCount, flags, NULL);
+    if (rc == -1) {
+        return -1;
+    }
+    ScopedIntArrayRW results(env, javaResults);
+    if (results.get() == NULL) {
+        return -1;
+    }
+    for (int i = 0; i < rc; ++i) {
+        results[2 * i] = msgs[i].msg_len;
+        results[2 * i + 1] = msgs[i].msg_hdr.msg_flags;
+        if (javaSrcAddresses != NULL) {
+            ScopedLocalRef<jobject> srcAddress(env, env->GetObjectArrayElement(javaSrcAddresses, i));
+            if (!fillInetSocketAddress(env, rc, srcAddress.get(), addresses[i])) {
+                return -1;
+            }
+        }
+    }
+    return rc;
+}
+#endif
+
 static void Posix_remove(JNIEnv* env, jobject, jstring javaPath) {
     ScopedUtfChars path(env, javaPath);
     if (path.c_str() == NULL) {
@@ -1105,6 +1470,52 @@ static jlong Posix_sendfile(JNIEnv* env, jobject, jobject javaOutFd, jobject jav
     return result;
 }
 
+#if defined(__APPLE__)
+static jint Posix_sendmmsgBytes(JNIEnv*, jobject, jobject, jobject, jintArray, jintArray, jint, jint, jobjectArray, jintArray) { abort(); }
+#else
+static jint Posix_sendmmsgBytes(JNIEnv* env, jobject, jobject javaFd, jobject javaBytes, jintArray javaByteOffsets, jintArray javaByteCounts, jint messageCount, jint flags, jobjectArray javaInetAddresses, jintArray javaPorts) {
+    ScopedBytesRO bytes(env, javaBytes);
+    if (bytes.get() == NULL) {
+        return -1;
+    }
+    ScopedIntArrayRO byteOffsets(env, javaByteOffsets);
+    if (byteOffsets.get() == NULL) {
+        return -1;
+    }
+    ScopedIntArrayRO byteCounts(env, javaByteCounts);
+    if (byteCounts.get() == NULL) {
+        return -1;
+    }
+    UniquePtr<ScopedIntArrayRO> ports;
+    if (javaInetAddresses != NULL) {
+        ports.reset(new ScopedIntArrayRO(env, javaPorts));
+        if (ports->get() == NULL) {
+            return -1;
+        }
+    }
+    std::vector<mmsghdr> msgs(messageCount);
+    std::vector<iovec> iovs(messageCount);
+    std::vector<sockaddr_storage> addresses(javaInetAddresses != NULL ? messageCount : 0);
+    memset(&msgs[0], 0, sizeof(mmsghdr) * messageCount);
+    for (jint i = 0; i < messageCount; ++i) {
+        iovs[i].iov_base = const_cast<jbyte*>(bytes.get()) + byteOffsets[i];
+        iovs[i].iov_len = byteCounts[i];
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        if (javaInetAddresses != NULL) {
+            ScopedLocalRef<jobject> inetAddress(env, env->GetObjectArrayElement(javaInetAddresses, i));
+            socklen_t sa_len = 0;
+            if (!inetAddressToSockaddr(env, inetAddress.get(), (*ports)[i], addresses[i], sa_len)) {
+                return -1;
+            }
+            msgs[i].msg_hdr.msg_name = &addresses[i];
+            msgs[i].msg_hdr.msg_namelen = sa_len;
+        }
+    }
+    return NET_FAILURE_RETRY(env, int, sendmmsg, javaFd, &msgs[0], messageCount, flags);
+}
+#endif
+
 static jint Posix_sendtoBytes(JNIEnv* env, jobject, jobject javaFd, jobject javaBytes, jint byteOffset, jint byteCount, jint flags, jobject javaInetAddress, jint port) {
     ScopedBytesRO bytes(env, javaBytes);
     if (bytes.get() == NULL) {
@@ -1256,10 +1667,174 @@ static void Posix_socketpair(JNIEnv* env, jobject, jint domain, jint type, jint
     }
 }
 
+#if defined(__APPLE__)
+static jlong Posix_splice(JNIEnv*, jobject, jobject, jobject, jobject, jobject, jlong, jint) { abort(); }
+#else
+static jlong Posix_splice(JNIEnv* env, jobject, jobject javaFdIn, jobject javaInOffset, jobject javaFdOut, jobject javaOutOffset, jlong byteCount, jint flags) {
+    MutableLongOffset inOffset(env, javaInOffset);
+    MutableLongOffset outOffset(env, javaOutOffset);
+    // This is NET_FAILURE_RETRY for two fds: either end may be a socket that another thread
+    // closes while we're blocked.
+    ssize_t rc;
+    do {
+        {
+            int fdIn = jniGetFDFromFileDescriptor(env, javaFdIn);
+            int fdOut = jniGetFDFromFileDescriptor(env, javaFdOut);
+            AsynchronousSocketCloseMonitor inMonitor(fdIn);
+            AsynchronousSocketCloseMonitor outMonitor(fdOut);
+            rc = splice(fdIn, inOffset.get(), fdOut, outOffset.get(), byteCount, flags);
+        }
+        if (rc == -1) {
+            if (jniGetFDFromFileDescriptor(env, javaFdIn) == -1 ||
+                    jniGetFDFromFileDescriptor(env, javaFdOut) == -1) {
+                jniThrowException(env, "java/net/SocketException", "Socket closed");
+                return -1;
+            } else if (errno != EINTR) {
+                throwErrnoException(env, "splice");
+                return -1;
+            }
+        }
+    } while (rc == -1);
+    inOffset.writeBack();
+    outOffset.writeBack();
+    return rc;
+}
+#endif
+
 static jobject Posix_stat(JNIEnv* env, jobject, jstring javaPath) {
     return doStat(env, javaPath, false);
 }
 
+// The StructStat.FIELD_* bits, in the order statMany writes them.
+enum {
+    STAT_FIELD_DEV, STAT_FIELD_INO, STAT_FIELD_MODE, STAT_FIELD_NLINK, STAT_FIELD_UID,
+    STAT_FIELD_GID, STAT_FIELD_RDEV, STAT_FIELD_SIZE, STAT_FIELD_ATIME, STAT_FIELD_MTIME,
+    STAT_FIELD_CTIME, STAT_FIELD_BLKSIZE, STAT_FIELD_BLOCKS, STAT_FIELD_COUNT
+};
+
+#if defined(__linux__) && defined(__NR_statx) && defined(STATX_BASIC_STATS)
+// Set once the kernel has told us it has no statx(2), after which we go straight to fstatat(2).
+// Any thread may set it, so it's only accessed atomically; it guards no other data.
+static bool gStatxUnavailable = false;
+
+static unsigned statxMaskFor(jint fields) {
+    static const unsigned masks[STAT_FIELD_COUNT] = {
+        0, STATX_INO, STATX_TYPE | STATX_MODE, STATX_NLINK, STATX_UID,
+        STATX_GID, 0, STATX_SIZE, STATX_ATIME, STATX_MTIME,
+        STATX_CTIME, 0, STATX_BLOCKS
+    };
+    unsigned mask = 0;
+    for (int i = 0; i < STAT_FIELD_COUNT; ++i) {
+        if ((fields & (1 << i)) != 0) {
+            mask |= masks[i];
+        }
+    }
+    return mask;
+}
+
+// Returns 0 and fills 'out', -1 with errno set, or -2 if statx(2) isn't available.
+static int statxFields(int dirFd, const char* path, int flags, unsigned mask, jlong* out) {
+    if (__atomic_load_n(&gStatxUnavailable, __ATOMIC_RELAXED)) {
+        return -2;
+    }
+    struct statx sx;
+    int rc = TEMP_FAILURE_RETRY(syscall(__NR_statx, dirFd, path, flags, mask, &sx));
+    if (rc == -1) {
+        if (errno == ENOSYS) {
+            __atomic_store_n(&gStatxUnavailable, true, __ATOMIC_RELAXED);
+            return -2;
+        }
+        return -1;
+    }
+    out[STAT_FIELD_DEV] = static_cast<jlong>(makedev(sx.stx_dev_major, sx.stx_dev_minor));
+    out[STAT_FIELD_INO] = static_cast<jlong>(sx.stx_ino);
+    out[STAT_FIELD_MODE] = static_cast<jlong>(sx.stx_mode);
+    out[STAT_FIELD_NLINK] = static_cast<jlong>(sx.stx_nlink);
+    out[STAT_FIELD_UID] = static_cast<jlong>(sx.stx_uid);
+    out[STAT_FIELD_GID] = static_cast<jlong>(sx.stx_gid);
+    out[STAT_FIELD_RDEV] = static_cast<jlong>(makedev(sx.stx_rdev_major, sx.stx_rdev_minor));
+    out[STAT_FIELD_SIZE] = static_cast<jlong>(sx.stx_size);
+    out[STAT_FIELD_ATIME] = static_cast<jlong>(sx.stx_atime.tv_sec);
+    out[STAT_FIELD_MTIME] = static_cast<jlong>(sx.stx_mtime.tv_sec);
+    out[STAT_FIELD_CTIME] = static_cast<jlong>(sx.stx_ctime.tv_sec);
+    out[STAT_FIELD_BLKSIZE] = static_cast<jlong>(sx.stx_blksize);
+    out[STAT_FIELD_BLOCKS] = static_cast<jlong>(sx.stx_blocks);
+    return 0;
+}
+#endif
+
+static int fstatatFields(int dirFd, const char* path, int flags, jlong* out) {
+    struct stat sb;
+    int rc = TEMP_FAILURE_RETRY(fstatat(dirFd, path, &sb, flags));
+    if (rc == -1) {
+        return -1;
+    }
+    out[STAT_FIELD_DEV] = static_cast<jlong>(sb.st_dev);
+    out[STAT_FIELD_INO] = static_cast<jlong>(sb.st_ino);
+    out[STAT_FIELD_MODE] = static_cast<jlong>(sb.st_mode);
+    out[STAT_FIELD_NLINK] = static_cast<jlong>(sb.st_nlink);
+    out[STAT_FIELD_UID] = static_cast<jlong>(sb.st_uid);
+    out[STAT_FIELD_GID] = static_cast<jlong>(sb.st_gid);
+    out[STAT_FIELD_RDEV] = static_cast<jlong>(sb.st_rdev);
+    out[STAT_FIELD_SIZE] = static_cast<jlong>(sb.st_size);
+    out[STAT_FIELD_ATIME] = static_cast<jlong>(sb.st_atime);
+    out[STAT_FIELD_MTIME] = static_cast<jlong>(sb.st_mtime);
+    out[STAT_FIELD_CTIME] = static_cast<jlong>(sb.st_ctime);
+    out[STAT_FIELD_BLKSIZE] = static_cast<jlong>(sb.st_blksize);
+    out[STAT_FIELD_BLOCKS] = static_cast<jlong>(sb.st_blocks);
+    return 0;
+}
+
+/*
+ * Stats every path with one JNI transition, writing just the requested fields straight into
+ * 'javaValues' rather than allocating a StructStat per path. Where the kernel has statx(2), it's
+ * told which fields we want so that filesystems can skip work (such as fetching fresh attributes
+ * from a remote server) for the rest. The caller has checked the array lengths.
+ */
+static jint Posix_statMany(JNIEnv* env, jobject, jobject javaDirFd, jobjectArray javaPaths,
+        jboolean followLinks, jint fields, jlongArray javaValues, jintArray javaErrnos) {
+    int dirFd = (javaDirFd != NULL) ? jniGetFDFromFileDescriptor(env, javaDirFd) : AT_FDCWD;
+    int flags = followLinks ? 0 : AT_SYMLINK_NOFOLLOW;
+    fields &= (1 << STAT_FIELD_COUNT) - 1;
+#if defined(__linux__) && defined(__NR_statx) && defined(STATX_BASIC_STATS)
+    unsigned mask = statxMaskFor(fields);
+#endif
+    ScopedLongArrayRW values(env, javaValues);
+    ScopedIntArrayRW errnos(env, javaErrnos);
+    if (values.get() == NULL || errnos.get() == NULL) {
+        return -1;
+    }
+    jsize pathCount = env->GetArrayLength(javaPaths);
+    jint successCount = 0;
+    jlong* out = values.get();
+    for (jsize i = 0; i < pathCount; ++i) {
+        ScopedLocalRef<jstring> javaPath(env,
+                reinterpret_cast<jstring>(env->GetObjectArrayElement(javaPaths, i)));
+        ScopedUtfChars path(env, javaPath.get());
+        if (path.c_str() == NULL) {
+            return -1;
+        }
+        jlong all[STAT_FIELD_COUNT];
+        int rc = -2;
+#if defined(__linux__) && defined(__NR_statx) && defined(STATX_BASIC_STATS)
+        rc = statxFields(dirFd, path.c_str(), flags, mask, all);
+#endif
+        if (rc == -2) {
+            rc = fstatatFields(dirFd, path.c_str(), flags, all);
+        }
+        errnos[i] = (rc == 0) ? 0 : errno;
+        if (rc == 0) {
+            ++successCount;
+        }
+        for (int field = 0; field < STAT_FIELD_COUNT; ++field) {
+            if ((fields & (1 << field)) != 0) {
+                *out++ = (rc == 0) ? all[field] : 0;
+            }
+        }
+    }
+    return successCount;
+}
+
 static jobject Posix_statvfs(JNIEnv* env, jobject, jstring javaPath) {
     ScopedUtfChars path(env, javaPath);
     if (path.c_str() == NULL) {
@@ -1316,6 +1891,17 @@ static void Posix_tcsendbreak(JNIEnv* env, jobject, jobject javaFd, jint duratio
   throwIfMinusOne(env, "tcsendbreak", TEMP_FAILURE_RETRY(tcsendbreak(fd, duration)));
 }
 
+#if defined(__APPLE__)
+static jlong Posix_tee(JNIEnv*, jobject, jobject, jobject, jlong, jint) { abort(); }
+#else
+static jlong Posix_tee(JNIEnv* env, jobject, jobject javaFdIn, jobject javaFdOut, jlong byteCount, jint flags) {
+    // Both ends of tee(2) are pipes, so there's no socket to monitor.
+    int fdIn = jniGetFDFromFileDescriptor(env, javaFdIn);
+    int fdOut = jniGetFDFromFileDescriptor(env, javaFdOut);
+    return throwIfMinusOne(env, "tee", TEMP_FAILURE_RETRY(tee(fdIn, fdOut, byteCount, flags)));
+}
+#endif
+
 static jint Posix_umaskImpl(JNIEnv*, jobject, jint mask) {
     return umask(mask);
 }
@@ -1346,6 +1932,12 @@ static jint Posix_waitpid(JNIEnv* env, jobject, jint pid, jobject javaStatus, ji
     return rc;
 }
 
+static jint Posix_writeAddress(JNIEnv* env, jobject, jobject javaFd, jlong address, jint byteCount) {
+    const void* ptr = reinterpret_cast<const void*>(static_cast<uintptr_t>(address));
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    return throwIfMinusOne(env, "write", TEMP_FAILURE_RETRY(write(fd, ptr, byteCount)));
+}
+
 static jint Posix_writeBytes(JNIEnv* env, jobject, jobject javaFd, jbyteArray javaBytes, jint byteOffset, jint byteCount) {
     ScopedBytesRO bytes(env, javaBytes);
     if (bytes.get() == NULL) {
@@ -1364,6 +1956,15 @@ static jint Posix_writev(JNIEnv* env, jobject, jobject javaFd, jobjectArray buff
     return throwIfMinusOne(env, "writev", TEMP_FAILURE_RETRY(writev(fd, ioVec.get(), ioVec.size())));
 }
 
+static jint Posix_writevAddresses(JNIEnv* env, jobject, jobject javaFd, jlongArray addresses, jintArray byteCounts) {
+    AddressIoVec ioVec(env, addresses);
+    if (!ioVec.init(byteCounts)) {
+        return -1;
+    }
+    int fd = jniGetFDFromFileDescriptor(env, javaFd);
+    return throwIfMinusOne(env, "writev", TEMP_FAILURE_RETRY(writev(fd, ioVec.get(), ioVec.size())));
+}
+
 static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Posix, accept, "(Ljava/io/FileDescriptor;Ljava/net/InetSocketAddress;)Ljava/io/FileDescriptor;"),
     NATIVE_METHOD(Posix, access, "(Ljava/lang/String;I)Z"),
@@ -1372,9 +1973,13 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Posix, chown, "(Ljava/lang/String;II)V"),
     NATIVE_METHOD(Posix, close, "(Ljava/io/FileDescriptor;)V"),
     NATIVE_METHOD(Posix, connect, "(Ljava/io/FileDescriptor;Ljava/net/InetAddress;I)V"),
+    NATIVE_METHOD(Posix, copy_file_range, "(Ljava/io/FileDescriptor;Llibcore/util/MutableLong;Ljava/io/FileDescriptor;Llibcore/util/MutableLong;JI)J"),
     NATIVE_METHOD(Posix, dup, "(Ljava/io/FileDescriptor;)Ljava/io/FileDescriptor;"),
     NATIVE_METHOD(Posix, dup2, "(Ljava/io/FileDescriptor;I)Ljava/io/FileDescriptor;"),
     NATIVE_METHOD(Posix, environ, "()[Ljava/lang/String;"),
+    NATIVE_METHOD(Posix, epoll_create, "(I)Ljava/io/FileDescriptor;"),
+    NATIVE_METHOD(Posix, epoll_ctl, "(Ljava/io/FileDescriptor;ILjava/io/FileDescriptor;IJ)V"),
+    NATIVE_METHOD(Posix, epoll_waitBytes, "(Ljava/io/FileDescriptor;Ljava/lang/Object;III)I"),
     NATIVE_METHOD(Posix, execv, "(Ljava/lang/String;[Ljava/lang/String;)V"),
     NATIVE_METHOD(Posix, execve, "(Ljava/lang/String;[Ljava/lang/String;[Ljava/lang/String;)V"),
     NATIVE_METHOD(Posix, fchmod, "(Ljava/io/FileDescriptor;I)V"),
@@ -1418,6 +2023,7 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Posix, listen, "(Ljava/io/FileDescriptor;I)V"),
     NATIVE_METHOD(Posix, lseek, "(Ljava/io/FileDescriptor;JI)J"),
     NATIVE_METHOD(Posix, lstat, "(Ljava/lang/String;)Llibcore/io/StructStat;"),
+    NATIVE_METHOD(Posix, madvise, "(JJI)V"),
     NATIVE_METHOD(Posix, mincore, "(JJ[B)V"),
     NATIVE_METHOD(Posix, mkdir, "(Ljava/lang/String;I)V"),
     NATIVE_METHOD(Posix, mlock, "(JJ)V"),
@@ -1428,14 +2034,26 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Posix, open, "(Ljava/lang/String;II)Ljava/io/FileDescriptor;"),
     NATIVE_METHOD(Posix, pipe, "()[Ljava/io/FileDescriptor;"),
     NATIVE_METHOD(Posix, poll, "([Llibcore/io/StructPollfd;I)I"),
+    NATIVE_METHOD(Posix, posix_fadvise, "(Ljava/io/FileDescriptor;JJI)V"),
+    NATIVE_METHOD(Posix, preadAddress, "(Ljava/io/FileDescriptor;JIJ)I"),
     NATIVE_METHOD(Posix, preadBytes, "(Ljava/io/FileDescriptor;Ljava/lang/Object;IIJ)I"),
+    NATIVE_METHOD(Posix, preadv, "(Ljava/io/FileDescriptor;[Ljava/lang/Object;[I[IJ)I"),
+    NATIVE_METHOD(Posix, preadvAddresses, "(Ljava/io/FileDescriptor;[J[IJ)I"),
+    NATIVE_METHOD(Posix, pwriteAddress, "(Ljava/io/FileDescriptor;JIJ)I"),
     NATIVE_METHOD(Posix, pwriteBytes, "(Ljava/io/FileDescriptor;Ljava/lang/Object;IIJ)I"),
+    NATIVE_METHOD(Posix, pwritev, "(Ljava/io/FileDescriptor;[Ljava/lang/Object;[I[IJ)I"),
+    NATIVE_METHOD(Posix, pwritevAddresses, "(Ljava/io/FileDescriptor;[J[IJ)I"),
+    NATIVE_METHOD(Posix, readAddress, "(Ljava/io/FileDescriptor;JI)I"),
     NATIVE_METHOD(Posix, readBytes, "(Ljava/io/FileDescriptor;Ljava/lang/Object;II)I"),
+    NATIVE_METHOD(Posix, readahead, "(Ljava/io/FileDescriptor;JJ)V"),
     NATIVE_METHOD(Posix, readv, "(Ljava/io/FileDescriptor;[Ljava/lang/Object;[I[I)I"),
+    NATIVE_METHOD(Posix, readvAddresses, "(Ljava/io/FileDescriptor;[J[I)I"),
     NATIVE_METHOD(Posix, recvfromBytes, "(Ljava/io/FileDescriptor;Ljava/lang/Object;IIILjava/net/InetSocketAddress;)I"),
+    NATIVE_METHOD(Posix, recvmmsgBytes, "(Ljava/io/FileDescriptor;Ljava/lang/Object;IIII[Ljava/net/InetSocketAddress;[I)I"),
     NATIVE_METHOD(Posix, remove, "(Ljava/lang/String;)V"),
     NATIVE_METHOD(Posix, rename, "(Ljava/lang/String;Ljava/lang/String;)V"),
     NATIVE_METHOD(Posix, sendfile, "(Ljava/io/FileDescriptor;Ljava/io/FileDescriptor;Llibcore/util/MutableLong;J)J"),
+    NATIVE_METHOD(Posix, sendmmsgBytes, "(Ljava/io/FileDescriptor;Ljava/lang/Object;[I[III[Ljava/net/InetAddress;[I)I"),
     NATIVE_METHOD(Posix, sendtoBytes, "(Ljava/io/FileDescriptor;Ljava/lang/Object;IIILjava/net/InetAddress;I)I"),
     NATIVE_METHOD(Posix, setegid, "(I)V"),
     NATIVE_METHOD(Posix, setenv, "(Ljava/lang/String;Ljava/lang/String;Z)V"),
@@ -1453,7 +2071,9 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Posix, shutdown, "(Ljava/io/FileDescriptor;I)V"),
     NATIVE_METHOD(Posix, socket, "(III)Ljava/io/FileDescriptor;"),
     NATIVE_METHOD(Posix, socketpair, "(IIILjava/io/FileDescriptor;Ljava/io/FileDescriptor;)V"),
+    NATIVE_METHOD(Posix, splice, "(Ljava/io/FileDescriptor;Llibcore/util/MutableLong;Ljava/io/FileDescriptor;Llibcore/util/MutableLong;JI)J"),
     NATIVE_METHOD(Posix, stat, "(Ljava/lang/String;)Llibcore/io/StructStat;"),
+    NATIVE_METHOD(Posix, statMany, "(Ljava/io/FileDescriptor;[Ljava/lang/String;ZI[J[I)I"),
     NATIVE_METHOD(Posix, statvfs, "(Ljava/lang/String;)Llibcore/io/StructStatVfs;"),
     NATIVE_METHOD(Posix, strerror, "(I)Ljava/lang/String;"),
     NATIVE_METHOD(Posix, strsignal, "(I)Ljava/lang/String;"),
@@ -1461,12 +2081,15 @@ static JNINativeMethod gMethods[] = {
     NATIVE_METHOD(Posix, sysconf, "(I)J"),
     NATIVE_METHOD(Posix, tcdrain, "(Ljava/io/FileDescriptor;)V"),
     NATIVE_METHOD(Posix, tcsendbreak, "(Ljava/io/FileDescriptor;I)V"),
+    NATIVE_METHOD(Posix, tee, "(Ljava/io/FileDescriptor;Ljava/io/FileDescriptor;JI)J"),
     NATIVE_METHOD(Posix, umaskImpl, "(I)I"),
     NATIVE_METHOD(Posix, uname, "()Llibcore/io/StructUtsname;"),
     NATIVE_METHOD(Posix, unsetenv, "(Ljava/lang/String;)V"),
     NATIVE_METHOD(Posix, waitpid, "(ILlibcore/util/MutableInt;I)I"),
+    NATIVE_METHOD(Posix, writeAddress, "(Ljava/io/FileDescriptor;JI)I"),
     NATIVE_METHOD(Posix, writeBytes, "(Ljava/io/FileDescriptor;Ljava/lang/Object;II)I"),
     NATIVE_METHOD(Posix, writev, "(Ljava/io/FileDescriptor;[Ljava/lang/Object;[I[I)I"),
+    NATIVE_METHOD(Posix, writevAddresses, "(Ljava/io/FileDescriptor;[J[I)I"),
 };
 void register_libcore_io_Posix(JNIEnv* env) {
     jniRegisterNativeMethods(env, "libcore/io/Posix", gMethods, NELEM(gMethods));
@@ -41,6 +41,8 @@
 #include <netinet/ip.h>
 #include <linux/udp.h>
 
+#include <vector>
+
 union sockunion {
     sockaddr sa;
     sockaddr_ll sll;
@@ -143,6 +145,35 @@ static int RawSocket_sendPacket(JNIEnv* env, jclass, jobject fileDescriptor,
   return err;
 }
 
+/*
+ * Returns true if the size bytes at packetData are an IP packet we should
+ * hand back to the caller: any packet if port is -1, otherwise only a
+ * UDP packet destined for the given port.
+ */
+static bool isAcceptablePacket(const jbyte* packetData, unsigned int size, jint port)
+{
+  if (port == -1) {
+    return true;
+  }
+
+  // quick check for UDP type & UDP port
+  // the packet is an IP header, UDP header, and UDP payload
+  if ((size < (sizeof(struct iphdr) + sizeof(struct udphdr)))) {
+    return false;  // runt packet
+  }
+
+  u_int8_t ip_proto = ((const iphdr *) packetData)->protocol;
+  if (ip_proto != IPPROTO_UDP) {
+    return false;  // something other than UDP
+  }
+
+  __be16 destPort = htons((reinterpret_cast<const udphdr*>(packetData + sizeof(iphdr)))->dest);
+  if (destPort != port) {
+    return false; // something other than requested port
+  }
+  return true;
+}
+
 /*
  * Reads a network packet into the user-supplied buffer.  Return the
  * length of the packet, or a 0 if there was a timeout or an
@@ -187,31 +218,161 @@ static jint RawSocket_recvPacket(JNIEnv* env, jclass, jobject fileDescriptor,
     return 0;
   }
 
-  if (port != -1) {
-    // quick check for UDP type & UDP port
-    // the packet is an IP header, UDP header, and UDP payload
-    if ((size < (sizeof(struct iphdr) + sizeof(struct udphdr)))) {
-      return 0;  // runt packet
-    }
+  return isAcceptablePacket(packetData, size, port) ? size : 0;
+}
 
-    u_int8_t ip_proto = ((iphdr *) packetData)->protocol;
-    if (ip_proto != IPPROTO_UDP) {
-      return 0;  // something other than UDP
-    }
+/*
+ * Reads up to packetCount packets into consecutive slotByteCount-byte
+ * slots of the user-supplied buffer with a single recvmmsg(2).  For
+ * each packet, results[2 * i] receives the length (0 for a packet
+ * rejected by the port filter) and results[2 * i + 1] the MSG_ flags,
+ * so MSG_TRUNC reports a packet larger than its slot.  Returns the
+ * number of slots filled, or 0 on timeout.
+ *
+ * Assumes that the caller has validated the offset, slot and count values.
+ */
+static jint RawSocket_recvPackets(JNIEnv* env, jclass, jobject fileDescriptor,
+    jbyteArray packets, jint offset, jint slotByteCount, jint packetCount,
+    jint port, jint timeout_millis, jintArray javaResults)
+{
+  NetFd fd(env, fileDescriptor);
+  if (fd.isClosed()) {
+    return 0;
+  }
 
-    __be16 destPort = htons((reinterpret_cast<udphdr*>(packetData + sizeof(iphdr)))->dest);
-    if (destPort != port) {
-      return 0; // something other than requested port
-    }
+  ScopedByteArrayRW body(env, packets);
+  jbyte* packetData = body.get();
+  if (packetData == NULL) {
+    return 0;
   }
 
-  return size;
+  ScopedIntArrayRW results(env, javaResults);
+  if (results.get() == NULL) {
+    return 0;
+  }
+
+  packetData += offset;
+
+  pollfd fds[1];
+  fds[0].fd = fd.get();
+  fds[0].events = POLLIN;
+  int retval = poll(fds, 1, timeout_millis);
+  if (retval <= 0) {
+    return 0;
+  }
+
+  std::vector<mmsghdr> msgs(packetCount);
+  std::vector<iovec> iovs(packetCount);
+  memset(&msgs[0], 0, sizeof(mmsghdr) * packetCount);
+  for (jint i = 0; i < packetCount; ++i) {
+    iovs[i].iov_base = packetData + i * slotByteCount;
+    iovs[i].iov_len = slotByteCount;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  int count = 0;
+  {
+    int intFd = fd.get();
+    AsynchronousSocketCloseMonitor monitor(intFd);
+    // The socket is non-blocking, so this returns whatever is already queued.
+    count = NET_FAILURE_RETRY(fd, recvmmsg(intFd, &msgs[0], packetCount, 0, NULL));
+  }
+
+  if (env->ExceptionOccurred() || count <= 0) {
+    return 0;
+  }
+
+  for (int i = 0; i < count; ++i) {
+    unsigned int size = msgs[i].msg_len;
+    bool acceptable = isAcceptablePacket(packetData + i * slotByteCount, size, port);
+    results[2 * i] = acceptable ? size : 0;
+    results[2 * i + 1] = msgs[i].msg_hdr.msg_flags;
+  }
+  return count;
+}
+
+/*
+ * Writes packetCount L3 (IP) packets to the raw socket with a single
+ * sendmmsg(2), all addressed to the same destination MAC.  Packet i is
+ * the byteCounts[i] bytes starting at offsets[i].  Returns the number
+ * of packets sent.
+ *
+ * Assumes that the caller has validated the offset & byteCount values.
+ */
+static int RawSocket_sendPackets(JNIEnv* env, jclass, jobject fileDescriptor,
+    jstring interfaceName, jshort protocolType, jbyteArray destMac,
+    jbyteArray packets, jintArray javaOffsets, jintArray javaByteCounts,
+    jint packetCount)
+{
+  NetFd fd(env, fileDescriptor);
+
+  if (fd.isClosed()) {
+    return 0;
+  }
+
+  ScopedUtfChars ifname(env, interfaceName);
+  if (ifname.c_str() == NULL) {
+    return 0;
+  }
+
+  ScopedByteArrayRO byteArray(env, packets);
+  if (byteArray.get() == NULL) {
+    return 0;
+  }
+
+  ScopedIntArrayRO offsets(env, javaOffsets);
+  if (offsets.get() == NULL) {
+    return 0;
+  }
+
+  ScopedIntArrayRO byteCounts(env, javaByteCounts);
+  if (byteCounts.get() == NULL) {
+    return 0;
+  }
+
+  ScopedByteArrayRO mac(env, destMac);
+  if (mac.get() == NULL) {
+    return 0;
+  }
+
+  sockunion su;
+  memset(&su, 0, sizeof(su));
+  su.sll.sll_hatype = htons(1); // ARPHRD_ETHER
+  su.sll.sll_halen = mac.size();
+  memcpy(&su.sll.sll_addr, mac.get(), mac.size());
+  su.sll.sll_family = AF_PACKET;
+  su.sll.sll_protocol = htons(protocolType);
+  su.sll.sll_ifindex = if_nametoindex(ifname.c_str());
+
+  std::vector<mmsghdr> msgs(packetCount);
+  std::vector<iovec> iovs(packetCount);
+  memset(&msgs[0], 0, sizeof(mmsghdr) * packetCount);
+  for (jint i = 0; i < packetCount; ++i) {
+    iovs[i].iov_base = const_cast<jbyte*>(byteArray.get()) + offsets[i];
+    iovs[i].iov_len = byteCounts[i];
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = &su.sa;
+    msgs[i].msg_hdr.msg_namelen = sizeof(su);
+  }
+
+  int err;
+  {
+    int intFd = fd.get();
+    AsynchronousSocketCloseMonitor monitor(intFd);
+    err = NET_FAILURE_RETRY(fd, sendmmsg(intFd, &msgs[0], packetCount, 0));
+  }
+
+  return err;
 }
 
 static JNINativeMethod gRawMethods[] = {
   NATIVE_METHOD(RawSocket, create, "(Ljava/io/FileDescriptor;SLjava/lang/String;)V"),
   NATIVE_METHOD(RawSocket, sendPacket, "(Ljava/io/FileDescriptor;Ljava/lang/String;S[B[BII)I"),
   NATIVE_METHOD(RawSocket, recvPacket, "(Ljava/io/FileDescriptor;[BIIII)I"),
+  NATIVE_METHOD(RawSocket, sendPackets, "(Ljava/io/FileDescriptor;Ljava/lang/String;S[B[B[I[II)I"),
+  NATIVE_METHOD(RawSocket, recvPackets, "(Ljava/io/FileDescriptor;[BIIIII[I)I"),
 };
 
 void register_libcore_net_RawSocket(JNIEnv* env) {
@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "ArrayMath"
+
+#include "../../external/fdlibm/fdlibm.h"
+
+#include "jni.h"
+#include "JNIHelp.h"
+#include "JniConstants.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// The functions, numbered as in ArrayMath.java.
+enum Function {
+    FUNCTION_EXP,
+    FUNCTION_LOG,
+    FUNCTION_SQRT,
+    FUNCTION_SIN,
+    FUNCTION_COS,
+};
+
+// Elements are copied through a buffer this big, which lets the source and destination be the
+// same memory, converts floats to and from double, and keeps each pass over the data in cache.
+static const size_t BLOCK_SIZE = 256;
+
+static inline uint64_t doubleToBits(double d) {
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return bits;
+}
+
+static inline double bitsToDouble(uint64_t bits) {
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+/*
+ * The kernels below keep calls and data-dependent branches out of their main loops, which is
+ * what a compiler needs to vectorize them on targets with double-precision SIMD (ARMv7 NEON has
+ * none). Elements a kernel can't handle -- NaNs, infinities, and results that would overflow or
+ * be subnormal -- are worked out again with libm in a second pass.
+ */
+
+// Only x with |x| <= 708 takes the fast path, so 2^k below is always a normal double. The test
+// is done on the bits because the compiler won't vectorize floating-point comparisons, which may
+// trap.
+static const uint64_t EXP_LIMIT_BITS = 0x4086200000000000ULL; // 708.0
+
+static inline bool expInRange(double x) {
+    return (doubleToBits(x) & 0x7fffffffffffffffULL) <= EXP_LIMIT_BITS;
+}
+
+// exp(x) = 2^k * exp(r), with k = round(x / ln(2)) and |r| <= ln(2)/2. exp(r) is a degree 13
+// Taylor polynomial, whose truncation error is below 2^-57. ln(2) is split so that k * LN2_HI is
+// exact. Within 1 ulp of the correctly rounded result.
+static void fastExp(double* y, const double* x, size_t n) {
+    static const double LOG2_E = 1.44269504088896338700e+00;
+    static const double LN2_HI = 6.93147180369123816490e-01;
+    static const double LN2_LO = 1.90821492927058770002e-10;
+    // Adding this rounds a double of magnitude below 2^51 to an integer, left in the low bits.
+    static const double ROUNDER = 6755399441055744.0; // 0x1.8p52
+    for (size_t i = 0; i < n; ++i) {
+        double xi = expInRange(x[i]) ? x[i] : 0.0;
+        double t = xi * LOG2_E + ROUNDER;
+        double k = t - ROUNDER;
+        int64_t ki = static_cast<int64_t>(doubleToBits(t) - doubleToBits(ROUNDER));
+        double r = (xi - k * LN2_HI) - k * LN2_LO;
+        double q = 1.0 / 6227020800.0;
+        q = q * r + 1.0 / 479001600.0;
+        q = q * r + 1.0 / 39916800.0;
+        q = q * r + 1.0 / 3628800.0;
+        q = q * r + 1.0 / 362880.0;
+        q = q * r + 1.0 / 40320.0;
+        q = q * r + 1.0 / 5040.0;
+        q = q * r + 1.0 / 720.0;
+        q = q * r + 1.0 / 120.0;
+        q = q * r + 1.0 / 24.0;
+        q = q * r + 1.0 / 6.0;
+        q = q * r + 0.5;
+        double scale = bitsToDouble(static_cast<uint64_t>(ki + 1023) << 52);
+        y[i] = (1.0 + (r + r * r * q)) * scale;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (!expInRange(x[i])) {
+            y[i] = exp(x[i]);
+        }
+    }
+}
+
+// The bit patterns of the smallest normal double and of infinity.
+static const uint64_t LOG_MIN_BITS = 0x0010000000000000ULL;
+static const uint64_t LOG_MAX_BITS = 0x7ff0000000000000ULL;
+
+// log(x) = k * ln(2) + log(1 + f), with x = 2^k * (1 + f) and sqrt(2)/2 <= 1 + f < sqrt(2). This
+// is fdlibm's __ieee754_log, with the argument split done on the bits and without its special
+// cases for small f. Within 1 ulp of the correctly rounded result.
+static void fastLog(double* y, const double* x, size_t n) {
+    static const double LN2_HI = 6.93147180369123816490e-01;
+    static const double LN2_LO = 1.90821492927058770002e-10;
+    static const double LG1 = 6.666666666666735130e-01;
+    static const double LG2 = 3.999999999940941908e-01;
+    static const double LG3 = 2.857142874366239149e-01;
+    static const double LG4 = 2.222219843214978396e-01;
+    static const double LG5 = 1.818357216161805012e-01;
+    static const double LG6 = 1.531383769920937332e-01;
+    static const double LG7 = 1.479819860511658591e-01;
+    // The bits of sqrt(2)/2; offsetting by these puts 1 + f in the right range.
+    static const uint64_t SQRT_HALF_BITS = 0x3fe6a09e667f3bcdULL;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t bits = doubleToBits(x[i]);
+        bits = (bits - LOG_MIN_BITS < LOG_MAX_BITS - LOG_MIN_BITS) ? bits : doubleToBits(1.0);
+        uint64_t offset = bits - SQRT_HALF_BITS;
+        double k = static_cast<double>(static_cast<int64_t>(offset) >> 52);
+        double f = bitsToDouble(bits - (offset & 0xfff0000000000000ULL)) - 1.0;
+        double s = f / (2.0 + f);
+        double z = s * s;
+        double w = z * z;
+        double t1 = w * (LG2 + w * (LG4 + w * LG6));
+        double t2 = z * (LG1 + w * (LG3 + w * (LG5 + w * LG7)));
+        double r = t2 + t1;
+        double hfsq = 0.5 * f * f;
+        y[i] = k * LN2_HI - ((hfsq - (s * (hfsq + r) + k * LN2_LO)) - f);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t bits = doubleToBits(x[i]);
+        if (!(bits - LOG_MIN_BITS < LOG_MAX_BITS - LOG_MIN_BITS)) {
+            y[i] = log(x[i]);
+        }
+    }
+}
+
+// sqrt is correctly rounded in both libm and fdlibm, so this matches Math.sqrt exactly.
+static void loopSqrt(double* y, const double* x, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        y[i] = sqrt(x[i]);
+    }
+}
+
+static void loopSin(double* y, const double* x, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        y[i] = sin(x[i]);
+    }
+}
+
+static void loopCos(double* y, const double* x, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        y[i] = cos(x[i]);
+    }
+}
+
+// The StrictMath versions just call fdlibm for each element, which keeps them bit-exact.
+#define STRICT_LOOP(NAME, FN) \
+    static void NAME(double* y, const double* x, size_t n) { \
+        for (size_t i = 0; i < n; ++i) { \
+            y[i] = FN(x[i]); \
+        } \
+    }
+STRICT_LOOP(strictExp, ieee_exp)
+STRICT_LOOP(strictLog, ieee_log)
+STRICT_LOOP(strictSqrt, ieee_sqrt)
+STRICT_LOOP(strictSin, ieee_sin)
+STRICT_LOOP(strictCos, ieee_cos)
+#undef STRICT_LOOP
+
+typedef void (*Kernel)(double* y, const double* x, size_t n);
+
+static Kernel kernelFor(jint function, bool strict) {
+    switch (function) {
+    case FUNCTION_EXP:
+        return strict ? strictExp : fastExp;
+    case FUNCTION_LOG:
+        return strict ? strictLog : fastLog;
+    case FUNCTION_SQRT:
+        return strict ? strictSqrt : loopSqrt;
+    case FUNCTION_SIN:
+        return strict ? strictSin : loopSin;
+    case FUNCTION_COS:
+        return strict ? strictCos : loopCos;
+    }
+    return NULL;
+}
+
+// Applies 'kernel' to 'count' elements. 'dst' may be 'src', but mustn't otherwise overlap it.
+template <typename T>
+static void apply(Kernel kernel, const T* src, T* dst, size_t count) {
+    double x[BLOCK_SIZE];
+    double y[BLOCK_SIZE];
+    for (size_t done = 0; done < count; done += BLOCK_SIZE) {
+        size_t n = (count - done < BLOCK_SIZE) ? (count - done) : BLOCK_SIZE;
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = src[done + i];
+        }
+        kernel(y, x, n);
+        for (size_t i = 0; i < n; ++i) {
+            dst[done + i] = static_cast<T>(y[i]);
+        }
+    }
+}
+
+// The Java side has checked the function, the bounds and the overlap.
+template <typename T>
+static void applyToArrays(JNIEnv* env, jint function, bool strict, jarray javaSrc, jint srcOffset,
+        jarray javaDst, jint dstOffset, jint count) {
+    Kernel kernel = kernelFor(function, strict);
+    if (kernel == NULL || count == 0) {
+        return;
+    }
+    // Critical access avoids copying arrays that can be millions of elements long. We make no JNI
+    // calls until we release them.
+    T* src = static_cast<T*>(env->GetPrimitiveArrayCritical(javaSrc, NULL));
+    if (src == NULL) {
+        return;
+    }
+    T* dst = static_cast<T*>(env->GetPrimitiveArrayCritical(javaDst, NULL));
+    if (dst == NULL) {
+        env->ReleasePrimitiveArrayCritical(javaSrc, src, JNI_ABORT);
+        return;
+    }
+    apply(kernel, src + srcOffset, dst + dstOffset, count);
+    env->ReleasePrimitiveArrayCritical(javaDst, dst, 0);
+    env->ReleasePrimitiveArrayCritical(javaSrc, src, JNI_ABORT);
+}
+
+static void ArrayMath_applyDoubles(JNIEnv* env, jclass, jint function, jboolean strict,
+        jdoubleArray javaSrc, jint srcOffset, jdoubleArray javaDst, jint dstOffset, jint count) {
+    applyToArrays<jdouble>(env, function, strict, javaSrc, srcOffset, javaDst, dstOffset, count);
+}
+
+static void ArrayMath_applyFloats(JNIEnv* env, jclass, jint function, jfloatArray javaSrc,
+        jint srcOffset, jfloatArray javaDst, jint dstOffset, jint count) {
+    applyToArrays<jfloat>(env, function, false, javaSrc, srcOffset, javaDst, dstOffset, count);
+}
+
+static void ArrayMath_applyDirect(JNIEnv*, jclass, jint function, jboolean strict,
+        jboolean floats, jlong srcAddress, jlong dstAddress, jint count) {
+    Kernel kernel = kernelFor(function, strict);
+    if (kernel == NULL) {
+        return;
+    }
+    if (floats) {
+        apply(kernel, reinterpret_cast<const jfloat*>(srcAddress),
+                reinterpret_cast<jfloat*>(dstAddress), count);
+    } else {
+        apply(kernel, reinterpret_cast<const jdouble*>(srcAddress),
+                reinterpret_cast<jdouble*>(dstAddress), count);
+    }
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(ArrayMath, applyDirect, "(IZZJJI)V"),
+    NATIVE_METHOD(ArrayMath, applyDoubles, "(IZ[DI[DII)V"),
+    NATIVE_METHOD(ArrayMath, applyFloats, "(I[FI[FII)V"),
+};
+void register_libcore_util_ArrayMath(JNIEnv* env) {
+    jniRegisterNativeMethods(env, "libcore/util/ArrayMath", gMethods, NELEM(gMethods));
+}
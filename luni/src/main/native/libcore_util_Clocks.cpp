@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "Clocks"
+
+#include "JNIHelp.h"
+#include "JniConstants.h"
+#include "ScopedPthreadMutexLock.h"
+#include "cutils/log.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// Older headers don't have the coarse clocks, which Linux has had since 2.6.32.
+#ifndef CLOCK_REALTIME_COARSE
+#define CLOCK_REALTIME_COARSE 5
+#endif
+#ifndef CLOCK_MONOTONIC_COARSE
+#define CLOCK_MONOTONIC_COARSE 6
+#endif
+
+static int64_t clockNanos(clockid_t clock) {
+    timespec now;
+    clock_gettime(clock, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+// Whether this kernel has the coarse clocks. Written once, by register_libcore_util_Clocks.
+static bool gHaveCoarseClocks;
+
+static jlong Clocks_coarseCurrentTimeMillis(JNIEnv*, jclass) {
+    return clockNanos(gHaveCoarseClocks ? CLOCK_REALTIME_COARSE : CLOCK_REALTIME) / 1000000;
+}
+
+static jlong Clocks_coarseNanoTime(JNIEnv*, jclass) {
+    return clockNanos(gHaveCoarseClocks ? CLOCK_MONOTONIC_COARSE : CLOCK_MONOTONIC);
+}
+
+/*
+ * The cycle counter is the TSC on x86, if the CPU says it runs at a constant rate whatever the
+ * power state, and the generic timer's virtual count on arm64. ARMv7 only lets user space read
+ * its counters if the kernel has opted in, which we can't find out safely, and so uses
+ * CLOCK_MONOTONIC.
+ */
+#if defined(__i386__) || defined(__x86_64__)
+static inline uint64_t readCycleCounter() {
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+static void cpuid(uint32_t leaf, uint32_t* eax, uint32_t* edx) {
+    uint32_t ebx, ecx;
+#if defined(__i386__) && defined(__PIC__)
+    // ebx holds the GOT pointer.
+    __asm__ __volatile__("xchgl %%ebx, %1\n\tcpuid\n\txchgl %%ebx, %1"
+            : "=a"(*eax), "=r"(ebx), "=c"(ecx), "=d"(*edx) : "a"(leaf), "c"(0));
+#else
+    __asm__ __volatile__("cpuid" : "=a"(*eax), "=b"(ebx), "=c"(ecx), "=d"(*edx) : "a"(leaf), "c"(0));
+#endif
+}
+
+static bool haveCycleCounter() {
+    uint32_t eax, edx;
+    cpuid(0x80000000, &eax, &edx);
+    if (eax < 0x80000007) {
+        return false;
+    }
+    cpuid(0x80000007, &eax, &edx);
+    return (edx & (1 << 8)) != 0; // Invariant TSC.
+}
+#elif defined(__aarch64__)
+static inline uint64_t readCycleCounter() {
+    uint64_t count;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(count));
+    return count;
+}
+
+static bool haveCycleCounter() {
+    return true;
+}
+#else
+static inline uint64_t readCycleCounter() {
+    return clockNanos(CLOCK_MONOTONIC);
+}
+
+static bool haveCycleCounter() {
+    return false;
+}
+#endif
+
+// Written once, by register_libcore_util_Clocks.
+static bool gHaveCycleCounter;
+
+// Calibrating can take a while, so it's only done if someone asks for the frequency.
+static pthread_once_t gCycleCounterFrequencyOnce = PTHREAD_ONCE_INIT;
+static int64_t gCycleCounterFrequency;
+
+static void initCycleCounterFrequency() {
+    if (!gHaveCycleCounter) {
+        gCycleCounterFrequency = 1000000000LL;
+        return;
+    }
+#if defined(__aarch64__)
+    uint64_t frequency;
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(frequency));
+    gCycleCounterFrequency = frequency;
+#else
+    // The TSC's rate isn't reported anywhere we can read, so time it against CLOCK_MONOTONIC.
+    // 20ms is long enough that the error from the two reads not being simultaneous is a few
+    // parts per million.
+    int64_t startNanos = clockNanos(CLOCK_MONOTONIC);
+    uint64_t startCount = readCycleCounter();
+    timespec delay = { 0, 20000000 };
+    while (nanosleep(&delay, &delay) == -1 && errno == EINTR) {
+    }
+    int64_t endNanos = clockNanos(CLOCK_MONOTONIC);
+    uint64_t endCount = readCycleCounter();
+    gCycleCounterFrequency = static_cast<int64_t>(
+            static_cast<double>(endCount - startCount) * 1e9 / (endNanos - startNanos));
+#endif
+}
+
+static jlong Clocks_readCycleCounter(JNIEnv*, jclass) {
+    return gHaveCycleCounter ? readCycleCounter() : clockNanos(CLOCK_MONOTONIC);
+}
+
+static jlong Clocks_getCycleCounterFrequency(JNIEnv*, jclass) {
+    pthread_once(&gCycleCounterFrequencyOnce, initCycleCounterFrequency);
+    return gCycleCounterFrequency;
+}
+
+/*
+ * The ticker is a thread that copies the time into static fields of Clocks every period, so
+ * Java code can read it without a native call. It's attached to the VM so that it can set the
+ * fields, but spends nearly all its time asleep in native code, where it doesn't hold up GC.
+ */
+struct Ticker {
+    JavaVM* vm;
+    jclass clocksClass;
+    jfieldID millisField;
+    jfieldID nanosField;
+    int periodMs;
+    pthread_t thread;
+    bool running;
+    bool stopping;
+};
+
+// Guards starting and stopping gTicker; the ticker thread itself never takes it.
+static pthread_mutex_t gTickerMutex = PTHREAD_MUTEX_INITIALIZER;
+static Ticker gTicker;
+
+static void* tickerThreadMain(void*) {
+    JNIEnv* env;
+    JavaVMAttachArgs args = { JNI_VERSION_1_6, const_cast<char*>("ClockTicker"), NULL };
+    if (gTicker.vm->AttachCurrentThreadAsDaemon(&env, &args) != JNI_OK) {
+        ALOGE("couldn't attach the clock ticker thread");
+        return NULL;
+    }
+    timespec period = { gTicker.periodMs / 1000, (gTicker.periodMs % 1000) * 1000000L };
+    while (!__atomic_load_n(&gTicker.stopping, __ATOMIC_ACQUIRE)) {
+        env->SetStaticLongField(gTicker.clocksClass, gTicker.millisField,
+                clockNanos(CLOCK_REALTIME) / 1000000);
+        env->SetStaticLongField(gTicker.clocksClass, gTicker.nanosField,
+                clockNanos(CLOCK_MONOTONIC));
+        timespec remaining = period;
+        while (nanosleep(&remaining, &remaining) == -1 && errno == EINTR) {
+        }
+    }
+    gTicker.vm->DetachCurrentThread();
+    return NULL;
+}
+
+static void Clocks_startTickerImpl(JNIEnv* env, jclass clocksClass, jint periodMs) {
+    ScopedPthreadMutexLock lock(&gTickerMutex);
+    if (gTicker.running) {
+        return;
+    }
+    if (env->GetJavaVM(&gTicker.vm) != JNI_OK) {
+        return;
+    }
+    if (gTicker.clocksClass == NULL) {
+        gTicker.clocksClass = reinterpret_cast<jclass>(env->NewGlobalRef(clocksClass));
+        gTicker.millisField = env->GetStaticFieldID(clocksClass, "tickerMillis", "J");
+        gTicker.nanosField = env->GetStaticFieldID(clocksClass, "tickerNanos", "J");
+        if (gTicker.millisField == NULL || gTicker.nanosField == NULL) {
+            return;
+        }
+    }
+    gTicker.periodMs = periodMs;
+    gTicker.stopping = false;
+    int rc = pthread_create(&gTicker.thread, NULL, tickerThreadMain, NULL);
+    if (rc != 0) {
+        jniThrowExceptionFmt(env, "java/lang/IllegalStateException",
+                "couldn't start clock ticker: %s", strerror(rc));
+        return;
+    }
+    gTicker.running = true;
+}
+
+static void Clocks_stopTickerImpl(JNIEnv*, jclass) {
+    ScopedPthreadMutexLock lock(&gTickerMutex);
+    if (!gTicker.running) {
+        return;
+    }
+    __atomic_store_n(&gTicker.stopping, true, __ATOMIC_RELEASE);
+    pthread_join(gTicker.thread, NULL);
+    gTicker.running = false;
+}
+
+static JNINativeMethod gMethods[] = {
+    NATIVE_METHOD(Clocks, coarseCurrentTimeMillis, "!()J"),
+    NATIVE_METHOD(Clocks, coarseNanoTime, "!()J"),
+    NATIVE_METHOD(Clocks, getCycleCounterFrequency, "()J"),
+    NATIVE_METHOD(Clocks, readCycleCounter, "!()J"),
+    NATIVE_METHOD(Clocks, startTickerImpl, "(I)V"),
+    NATIVE_METHOD(Clocks, stopTickerImpl, "()V"),
+};
+void register_libcore_util_Clocks(JNIEnv* env) {
+    timespec ignored;
+    gHaveCoarseClocks = (clock_gettime(CLOCK_MONOTONIC_COARSE, &ignored) == 0);
+    gHaveCycleCounter = haveCycleCounter();
+    jniRegisterNativeMethods(env, "libcore/util/Clocks", gMethods, NELEM(gMethods));
+}
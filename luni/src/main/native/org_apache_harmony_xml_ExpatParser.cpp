@@ -22,27 +22,33 @@
 #include "LocalArray.h"
 #include "ScopedLocalRef.h"
 #include "ScopedPrimitiveArray.h"
+#include "ScopedPthreadMutexLock.h"
 #include "ScopedStringChars.h"
 #include "ScopedUtfChars.h"
 #include "UniquePtr.h"
 #include "jni.h"
 #include "cutils/log.h"
-#include "unicode/unistr.h"
 
+#include <algorithm>
+#include <new>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
+#include <vector>
 #include <libexpat/expat.h>
 
-#define BUCKET_COUNT 128
-
 /**
  * Wrapper around an interned string.
  */
 struct InternedString {
-    InternedString() : interned(NULL), bytes(NULL) {
+    InternedString() : interned(NULL), bytes(NULL), length(0), hash(0), owned(true), id(-1) {
     }
 
     ~InternedString() {
-        delete[] bytes;
+        if (owned) {
+            delete[] bytes;
+        }
     }
 
     /** The interned string itself. */
@@ -51,10 +57,148 @@ struct InternedString {
     /** UTF-8 equivalent of the interned string. */
     const char* bytes;
 
+    /** Length of bytes, not including the null terminator. */
+    size_t length;
+
     /** Hash code of the interned string. */
-    int hash;
+    uint32_t hash;
+
+    /**
+     * True if this wrapper owns 'interned' and 'bytes'. A parser's own table
+     * also caches borrowed entries from the shared table, which live forever.
+     */
+    bool owned;
+
+    /** Index into ParsingContext::names, or -1 if not yet queued in an event. */
+    jint id;
+};
+
+/**
+ * An open-addressed hash table of interned strings keyed by their UTF-8
+ * bytes. Not thread-safe; the shared table is guarded by gSharedInternMutex.
+ */
+class InternTable {
+public:
+    InternTable(size_t maxSize) : mSlots(NULL), mCapacity(0), mSize(0), mMaxSize(maxSize) {
+    }
+
+    ~InternTable() {
+        for (size_t i = 0; i < mCapacity; ++i) {
+            delete mSlots[i];
+        }
+        delete[] mSlots;
+    }
+
+    /** Frees the global references held by owned entries. */
+    void deleteGlobalRefs(JNIEnv* env) {
+        for (size_t i = 0; i < mCapacity; ++i) {
+            if (mSlots[i] != NULL && mSlots[i]->owned) {
+                env->DeleteGlobalRef(mSlots[i]->interned);
+                mSlots[i]->interned = NULL;
+            }
+        }
+    }
+
+    InternedString* find(const char* s, size_t length, uint32_t hash) const {
+        if (mCapacity == 0) {
+            return NULL;
+        }
+        size_t mask = mCapacity - 1;
+        for (size_t i = hash & mask; mSlots[i] != NULL; i = (i + 1) & mask) {
+            InternedString* current = mSlots[i];
+            if (current->hash == hash && current->length == length &&
+                    memcmp(s, current->bytes, length) == 0) {
+                return current;
+            }
+        }
+        return NULL;
+    }
+
+    bool isFull() const {
+        return mSize >= mMaxSize;
+    }
+
+    size_t size() const {
+        return mSize;
+    }
+
+    /**
+     * Takes ownership of 'entry', which must not already be present. Returns
+     * false, without taking ownership, if the table is full or out of memory.
+     */
+    bool add(InternedString* entry) {
+        if (isFull()) {
+            return false;
+        }
+        // Keep the load factor at or below 3/4 so probe sequences stay short.
+        if (4 * (mSize + 1) > 3 * mCapacity) {
+            size_t newCapacity = (mCapacity == 0) ? INITIAL_CAPACITY : 2 * mCapacity;
+            if (!resize(newCapacity)) {
+                return false;
+            }
+        }
+        insert(entry);
+        ++mSize;
+        return true;
+    }
+
+private:
+    static const size_t INITIAL_CAPACITY = 128;
+
+    bool resize(size_t newCapacity) {
+        InternedString** oldSlots = mSlots;
+        size_t oldCapacity = mCapacity;
+        mSlots = new (std::nothrow) InternedString*[newCapacity];
+        if (mSlots == NULL) {
+            mSlots = oldSlots;
+            return false;
+        }
+        memset(mSlots, 0, newCapacity * sizeof(InternedString*));
+        mCapacity = newCapacity;
+        for (size_t i = 0; i < oldCapacity; ++i) {
+            if (oldSlots[i] != NULL) {
+                insert(oldSlots[i]);
+            }
+        }
+        delete[] oldSlots;
+        return true;
+    }
+
+    void insert(InternedString* entry) {
+        size_t mask = mCapacity - 1;
+        size_t i = entry->hash & mask;
+        while (mSlots[i] != NULL) {
+            i = (i + 1) & mask;
+        }
+        mSlots[i] = entry;
+    }
+
+    InternedString** mSlots;
+    size_t mCapacity;
+    size_t mSize;
+    const size_t mMaxSize;
+
+    // Disallow copy and assignment.
+    InternTable(const InternTable&);
+    void operator=(const InternTable&);
 };
 
+/**
+ * The most names the shared table holds. Once it's full, parsers go back to
+ * interning new names in their own tables.
+ */
+static const size_t MAX_SHARED_INTERNED_STRINGS = 1024;
+
+/**
+ * Element and attribute names shared by all parsers created with shared
+ * interning enabled. Entries are never freed, so a parser can keep borrowed
+ * pointers to them without holding the lock.
+ */
+static InternTable gSharedInternTable(MAX_SHARED_INTERNED_STRINGS);
+static pthread_mutex_t gSharedInternMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t gSharedInternHits;
+static uint64_t gSharedInternMisses;
+
 /**
  * Keeps track of strings between start and end events.
  */
@@ -97,14 +241,100 @@ private:
     int size;
 };
 
+/**
+ * UTF-16 text from consecutive Expat character data callbacks, which we pass
+ * to Java as a single text event.
+ */
+class PendingText {
+public:
+    PendingText() : array(NULL), capacity(0), length(0) {
+    }
+
+    ~PendingText() {
+        delete[] array;
+    }
+
+    /**
+     * Returns space for at least 'count' more chars at the end of the text,
+     * or NULL if we're out of memory. Call commit() with the number used.
+     */
+    jchar* reserve(size_t count) {
+        if (length + count > capacity) {
+            size_t newCapacity = capacity * 2;
+            if (newCapacity < length + count) {
+                newCapacity = length + count;
+            }
+            jchar* newArray = new jchar[newCapacity];
+            if (newArray == NULL) {
+                return NULL;
+            }
+            memcpy(newArray, array, length * sizeof(jchar));
+
+            delete[] array;
+            array = newArray;
+            capacity = newCapacity;
+        }
+        return array + length;
+    }
+
+    void commit(size_t count) {
+        length += count;
+    }
+
+    void clear() {
+        length = 0;
+    }
+
+    const jchar* get() const {
+        return array;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+    jchar* array;
+    size_t capacity;
+    size_t length;
+
+    // Disallow copy and assignment.
+    PendingText(const PendingText&);
+    void operator=(const PendingText&);
+};
+
+/**
+ * Event types and layouts for batch mode. Each event is a run of ints in
+ * ParsingContext::events, starting with its type. Names are indexes into
+ * ParsingContext::names, and text is an offset and length into pendingText.
+ * Keep in sync with ExpatParser.java.
+ */
+enum {
+    // type, uri, localName, qName, attributeCount, then per attribute
+    // uri, localName, qName, valueOffset, valueLength.
+    EVENT_START_ELEMENT = 1,
+    // type, uri, localName, qName.
+    EVENT_END_ELEMENT = 2,
+    // type, offset, length.
+    EVENT_TEXT = 3,
+    // type, prefix, uri.
+    EVENT_START_NAMESPACE = 4,
+    // type, prefix.
+    EVENT_END_NAMESPACE = 5,
+};
+
+/**
+ * The number of ints of queued events we collect before passing them to Java.
+ */
+static const size_t MAX_QUEUED_EVENTS = 4096;
+
 /**
  * Data passed to parser handler method by the parser.
  */
 struct ParsingContext {
-    ParsingContext(jobject object) : env(NULL), object(object), buffer(NULL), bufferSize(-1) {
-        for (int i = 0; i < BUCKET_COUNT; i++) {
-            internedStrings[i] = NULL;
-        }
+    ParsingContext(jobject object) : env(NULL), object(object), buffer(NULL), bufferSize(-1),
+            batchEvents(false), textStart(0), namesSent(0), javaEvents(NULL), javaEventsSize(0),
+            javaNames(NULL), javaNamesSize(0), sharedInterning(false), internedStrings(SIZE_MAX) {
     }
 
     // Warning: 'env' must be valid on entry.
@@ -112,21 +342,14 @@ struct ParsingContext {
         freeBuffer();
 
         // Free interned string cache.
-        for (int i = 0; i < BUCKET_COUNT; i++) {
-            if (internedStrings[i]) {
-                InternedString** bucket = internedStrings[i];
-                InternedString* current;
-                while ((current = *(bucket++)) != NULL) {
-                    // Free the interned string reference.
-                    env->DeleteGlobalRef(current->interned);
-
-                    // Free the bucket.
-                    delete current;
-                }
-
-                // Free the buckets.
-                delete[] internedStrings[i];
-            }
+        internedStrings.deleteGlobalRefs(env);
+
+        // Free batch mode arrays.
+        if (javaEvents != NULL) {
+            env->DeleteGlobalRef(javaEvents);
+        }
+        if (javaNames != NULL) {
+            env->DeleteGlobalRef(javaNames);
         }
     }
 
@@ -188,8 +411,38 @@ public:
     /** Keep track of names. */
     StringStack stringStack;
 
+    /** Text not yet passed to Java. See flushText. */
+    PendingText pendingText;
+
+    /** True if events should be queued and passed to Java in batches. */
+    bool batchEvents;
+
+    /** Events queued in batch mode. See flushEvents. */
+    std::vector<jint> events;
+
+    /** The start of the text in pendingText not yet covered by an EVENT_TEXT. */
+    size_t textStart;
+
+    /** Names used by queued events, indexed by InternedString::id. */
+    std::vector<jstring> names;
+
+    /** Name ids for endElement and endNamespace, used instead of stringStack in batch mode. */
+    std::vector<jint> nameIdStack;
+
+    /** How many of 'names' have been copied into javaNames. */
+    size_t namesSent;
+
+    /** Java copies of 'events' and 'names', as global references. */
+    jintArray javaEvents;
+    size_t javaEventsSize;
+    jobjectArray javaNames;
+    size_t javaNamesSize;
+
+    /** True if names should be looked up in gSharedInternTable first. */
+    bool sharedInterning;
+
     /** Cache of interned strings. */
-    InternedString** internedStrings[BUCKET_COUNT];
+    InternTable internedStrings;
 };
 
 static ParsingContext* toParsingContext(void* data) {
@@ -213,6 +466,7 @@ static jmethodID endCdataMethod;
 static jmethodID endDtdMethod;
 static jmethodID endElementMethod;
 static jmethodID endNamespaceMethod;
+static jmethodID handleEventsMethod;
 static jmethodID handleExternalEntityMethod;
 static jmethodID internMethod;
 static jmethodID notationDeclMethod;
@@ -226,20 +480,27 @@ static jmethodID unparsedEntityDeclMethod;
 static jstring emptyString;
 
 /**
- * Calculates a hash code for a null-terminated string. This is *not* equivalent
- * to Java's String.hashCode(). This hashes the bytes while String.hashCode()
- * hashes UTF-16 chars.
+ * Calculates a hash code for a null-terminated string and finds its length.
+ * This is *not* equivalent to Java's String.hashCode(). This is FNV-1a over the
+ * bytes followed by a final mix, so that the low bits we use to pick a slot
+ * depend on every byte; a multiply-by-31 hash clusters badly for the short,
+ * similar names typical of XML.
  *
  * @param s null-terminated string to hash
+ * @param length receives the length of s
  * @returns hash code
  */
-static int hashString(const char* s) {
-    int hash = 0;
-    if (s) {
-        while (*s) {
-            hash = hash * 31 + *s++;
-        }
+static uint32_t hashString(const char* s, size_t* length) {
+    uint32_t hash = 2166136261u;
+    const char* p = s;
+    while (*p) {
+        hash ^= static_cast<uint8_t>(*p++);
+        hash *= 16777619u;
     }
+    *length = p - s;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
     return hash;
 }
 
@@ -248,10 +509,11 @@ static int hashString(const char* s) {
  * representing the given UTF-8 bytes.
  *
  * @param bytes null-terminated string to intern
+ * @param length of bytes
  * @param hash of bytes
  * @returns wrapper of interned Java string
  */
-static InternedString* newInternedString(JNIEnv* env, const char* bytes, int hash) {
+static InternedString* newInternedString(JNIEnv* env, const char* bytes, size_t length, uint32_t hash) {
     // Allocate a new wrapper.
     UniquePtr<InternedString> wrapper(new InternedString);
     if (wrapper.get() == NULL) {
@@ -260,14 +522,14 @@ static InternedString* newInternedString(JNIEnv* env, const char* bytes, int has
     }
 
     // Create a copy of the UTF-8 bytes.
-    // TODO: sometimes we already know the length. Reuse it if so.
-    char* copy = new char[strlen(bytes) + 1];
+    char* copy = new char[length + 1];
     if (copy == NULL) {
         jniThrowOutOfMemoryError(env, NULL);
         return NULL;
     }
-    strcpy(copy, bytes);
+    memcpy(copy, bytes, length + 1);
     wrapper->bytes = copy;
+    wrapper->length = length;
 
     // Save the hash.
     wrapper->hash = hash;
@@ -296,62 +558,99 @@ static InternedString* newInternedString(JNIEnv* env, const char* bytes, int has
 }
 
 /**
- * Allocates a new bucket with one entry.
+ * Adds 'entry' to 'table', freeing it and throwing if that fails.
  *
- * @param entry to store in the bucket
- * @returns a reference to the bucket
+ * @returns entry or NULL if an exception was thrown
  */
-static InternedString** newInternedStringBucket(InternedString* entry) {
-    InternedString** bucket = new InternedString*[2];
-    if (bucket != NULL) {
-        bucket[0] = entry;
-        bucket[1] = NULL;
+static InternedString* addInternedString(JNIEnv* env, InternTable& table, InternedString* entry) {
+    if (!table.add(entry)) {
+        if (entry->owned) {
+            env->DeleteGlobalRef(entry->interned);
+        }
+        delete entry;
+        jniThrowOutOfMemoryError(env, NULL);
+        return NULL;
     }
-    return bucket;
+    return entry;
 }
 
 /**
- * Expands an interned string bucket and adds the given entry. Frees the
- * provided bucket and returns a new one.
- *
- * @param existingBucket the bucket to replace
- * @param entry to add to the bucket
- * @returns a reference to the newly-allocated bucket containing the given entry
+ * Returns the shared table's entry for the given UTF-8 string, adding one if
+ * there's room. Returns NULL without throwing if the shared table is full.
  */
-static InternedString** expandInternedStringBucket(
-        InternedString** existingBucket, InternedString* entry) {
-    // Determine the size of the existing bucket.
-    int size = 0;
-    while (existingBucket[size]) size++;
-
-    // Allocate the new bucket with enough space for one more entry and
-    // a null terminator.
-    InternedString** newBucket = new InternedString*[size + 2];
-    if (newBucket == NULL) return NULL;
-
-    memcpy(newBucket, existingBucket, size * sizeof(InternedString*));
-    newBucket[size] = entry;
-    newBucket[size + 1] = NULL;
-    delete[] existingBucket;
-
-    return newBucket;
+static InternedString* findOrAddSharedInternedString(JNIEnv* env, const char* s, size_t length,
+        uint32_t hash) {
+    {
+        ScopedPthreadMutexLock lock(&gSharedInternMutex);
+        InternedString* found = gSharedInternTable.find(s, length, hash);
+        if (found != NULL) {
+            ++gSharedInternHits;
+            return found;
+        }
+        ++gSharedInternMisses;
+        if (gSharedInternTable.isFull()) {
+            return NULL;
+        }
+    }
+
+    // Call into Java without holding the lock, then check again in case
+    // another parser added the same name meanwhile.
+    UniquePtr<InternedString> entry(newInternedString(env, s, length, hash));
+    if (entry.get() == NULL) {
+        return NULL;
+    }
+    ScopedPthreadMutexLock lock(&gSharedInternMutex);
+    InternedString* found = gSharedInternTable.find(s, length, hash);
+    if (found == NULL && gSharedInternTable.add(entry.get())) {
+        return entry.release();
+    }
+    env->DeleteGlobalRef(entry->interned);
+    return found;
 }
 
 /**
- * Returns an interned string for the given UTF-8 string.
+ * Returns this parser's interned string entry for the given UTF-8 string.
  *
- * @param bucket to search for s
- * @param s null-terminated string to find
- * @param hash of s
- * @returns interned Java string equivalent of s or null if not found
+ * @param s null-terminated string to intern
+ * @returns entry for s or NULL if an exception was thrown
  */
-static jstring findInternedString(InternedString** bucket, const char* s, int hash) {
-    InternedString* current;
-    while ((current = *(bucket++)) != NULL) {
-        if (current->hash != hash) continue;
-        if (!strcmp(s, current->bytes)) return current->interned;
+static InternedString* internName(JNIEnv* env, ParsingContext* parsingContext, const char* s) {
+
+    size_t length;
+    uint32_t hash = hashString(s, &length);
+
+    InternTable& table = parsingContext->internedStrings;
+    InternedString* found = table.find(s, length, hash);
+    if (found != NULL) {
+        // We found it!
+        return found;
     }
-    return NULL;
+
+    if (parsingContext->sharedInterning) {
+        InternedString* shared = findOrAddSharedInternedString(env, s, length, hash);
+        if (env->ExceptionCheck()) {
+            return NULL;
+        }
+        if (shared != NULL) {
+            // Cache a borrowed copy so we don't take the lock for this name again.
+            InternedString* borrowed = new InternedString;
+            if (borrowed == NULL) {
+                jniThrowOutOfMemoryError(env, NULL);
+                return NULL;
+            }
+            borrowed->interned = shared->interned;
+            borrowed->bytes = shared->bytes;
+            borrowed->length = length;
+            borrowed->hash = hash;
+            borrowed->owned = false;
+            return addInternedString(env, table, borrowed);
+        }
+        // The shared table is full. Fall through and keep this name to ourselves.
+    }
+
+    InternedString* internedString = newInternedString(env, s, length, hash);
+    if (internedString == NULL) return NULL;
+    return addInternedString(env, table, internedString);
 }
 
 /**
@@ -363,59 +662,100 @@ static jstring findInternedString(InternedString** bucket, const char* s, int ha
 static jstring internString(JNIEnv* env, ParsingContext* parsingContext, const char* s) {
     if (s == NULL) return NULL;
 
-    int hash = hashString(s);
-    int bucketIndex = hash & (BUCKET_COUNT - 1);
+    InternedString* entry = internName(env, parsingContext, s);
+    return (entry != NULL) ? entry->interned : NULL;
+}
 
-    InternedString*** buckets = parsingContext->internedStrings;
-    InternedString** bucket = buckets[bucketIndex];
-    InternedString* internedString;
+static void jniThrowExpatException(JNIEnv* env, XML_Error error) {
+    const char* message = XML_ErrorString(error);
+    jniThrowException(env, "org/apache/harmony/xml/ExpatException", message);
+}
 
-    if (bucket) {
-        // We have a bucket already. Look for the given string.
-        jstring found = findInternedString(bucket, s, hash);
-        if (found) {
-            // We found it!
-            return found;
+/**
+ * Decodes 'byteCount' bytes of UTF-8 into 'dst', which must have room for
+ * 'byteCount' chars; no sequence decodes to more UTF-16 units than it has
+ * bytes. Expat has already validated its input, but any malformed sequence
+ * becomes U+FFFD, as ICU would have done.
+ *
+ * @returns number of UTF-16 characters written
+ */
+static size_t utf8ToUtf16(jchar* dst, const char* utf8, size_t byteCount) {
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(utf8);
+    const uint8_t* end = src + byteCount;
+    jchar* out = dst;
+    while (src < end) {
+        // Markup-heavy text is mostly ASCII, so widen eight bytes at a time
+        // while we can.
+        while (end - src >= 8) {
+            uint64_t word;
+            memcpy(&word, src, sizeof(word));
+            if ((word & 0x8080808080808080ULL) != 0) {
+                break;
+            }
+            for (size_t i = 0; i < 8; ++i) {
+                out[i] = src[i];
+            }
+            src += 8;
+            out += 8;
         }
-
-        // We didn't find it. :(
-        // Create a new entry.
-        internedString = newInternedString(env, s, hash);
-        if (internedString == NULL) return NULL;
-
-        // Expand the bucket.
-        bucket = expandInternedStringBucket(bucket, internedString);
-        if (bucket == NULL) {
-            delete internedString;
-            jniThrowOutOfMemoryError(env, NULL);
-            return NULL;
+        if (src == end) {
+            break;
         }
 
-        buckets[bucketIndex] = bucket;
-
-        return internedString->interned;
-    } else {
-        // We don't even have a bucket yet. Create an entry.
-        internedString = newInternedString(env, s, hash);
-        if (internedString == NULL) return NULL;
-
-        // Create a new bucket with one entry.
-        bucket = newInternedStringBucket(internedString);
-        if (bucket == NULL) {
-            delete internedString;
-            jniThrowOutOfMemoryError(env, NULL);
-            return NULL;
+        uint32_t c = *src++;
+        if (c < 0x80) {
+            *out++ = c;
+            continue;
         }
 
-        buckets[bucketIndex] = bucket;
-
-        return internedString->interned;
+        // Work out how many continuation bytes to expect and the smallest
+        // legal range for the second byte, to reject overlong forms and
+        // encoded surrogates.
+        size_t count;
+        uint8_t min = 0x80;
+        uint8_t max = 0xbf;
+        if (c >= 0xc2 && c <= 0xdf) {
+            count = 1;
+            c &= 0x1f;
+        } else if (c >= 0xe0 && c <= 0xef) {
+            count = 2;
+            if (c == 0xe0) min = 0xa0;
+            if (c == 0xed) max = 0x9f;
+            c &= 0x0f;
+        } else if (c >= 0xf0 && c <= 0xf4) {
+            count = 3;
+            if (c == 0xf0) min = 0x90;
+            if (c == 0xf4) max = 0x8f;
+            c &= 0x07;
+        } else {
+            *out++ = 0xfffd;
+            continue;
+        }
+        if (src == end || *src < min || *src > max) {
+            *out++ = 0xfffd;
+            continue;
+        }
+        size_t available = end - src;
+        size_t i = 0;
+        for (; i < count && i < available && (src[i] & 0xc0) == 0x80; ++i) {
+            c = (c << 6) | (src[i] & 0x3f);
+        }
+        if (i < count) {
+            // Consume the valid prefix as a single replacement character.
+            src += i;
+            *out++ = 0xfffd;
+            continue;
+        }
+        src += count;
+        if (c < 0x10000) {
+            *out++ = c;
+        } else {
+            c -= 0x10000;
+            *out++ = 0xd800 + (c >> 10);
+            *out++ = 0xdc00 + (c & 0x3ff);
+        }
     }
-}
-
-static void jniThrowExpatException(JNIEnv* env, XML_Error error) {
-    const char* message = XML_ErrorString(error);
-    jniThrowException(env, "org/apache/harmony/xml/ExpatException", message);
+    return out - dst;
 }
 
 /**
@@ -433,14 +773,176 @@ static size_t fillBuffer(ParsingContext* parsingContext, const char* utf8, int b
         return -1;
     }
 
-    // Decode UTF-8 characters into our char[].
+    // Decode UTF-8 characters straight into our char[].
     ScopedCharArrayRW chars(env, javaChars);
     if (chars.get() == NULL) {
         return -1;
     }
-    UErrorCode status = U_ZERO_ERROR;
-    UnicodeString utf16(UnicodeString::fromUTF8(StringPiece(utf8, byteCount)));
-    return utf16.extract(chars.get(), byteCount, status);
+    return utf8ToUtf16(chars.get(), utf8, byteCount);
+}
+
+/** The most chars of text we collect before passing them to Java. */
+static const size_t MAX_PENDING_TEXT = 64 * 1024;
+
+/**
+ * Passes any text collected by text() to the Java parser, or in batch mode
+ * queues it as an EVENT_TEXT. Every other handler calls this first so that
+ * Java sees events in document order.
+ *
+ * @param parsingContext whose pendingText to flush
+ */
+static void flushText(ParsingContext* parsingContext) {
+    PendingText& pendingText = parsingContext->pendingText;
+    size_t length = pendingText.size();
+    if (parsingContext->batchEvents) {
+        if (length > parsingContext->textStart) {
+            std::vector<jint>& events = parsingContext->events;
+            events.push_back(EVENT_TEXT);
+            events.push_back(parsingContext->textStart);
+            events.push_back(length - parsingContext->textStart);
+            parsingContext->textStart = length;
+        }
+        return;
+    }
+    if (length == 0) {
+        return;
+    }
+
+    JNIEnv* env = parsingContext->env;
+    jcharArray javaChars = parsingContext->ensureCapacity(length);
+    if (javaChars != NULL) {
+        env->SetCharArrayRegion(javaChars, 0, length, pendingText.get());
+        env->CallVoidMethod(parsingContext->object, textMethod, javaChars, length);
+    }
+    pendingText.clear();
+}
+
+/**
+ * Discards queued events and text, after they've been passed to Java or
+ * because Java threw.
+ */
+static void clearEvents(ParsingContext* parsingContext) {
+    parsingContext->pendingText.clear();
+    parsingContext->events.clear();
+    parsingContext->textStart = 0;
+}
+
+/**
+ * Copies 'events' and any new 'names' into their Java arrays, growing them if
+ * necessary.
+ *
+ * @returns false if an exception was thrown
+ */
+static bool copyEventsToJava(JNIEnv* env, ParsingContext* parsingContext) {
+    size_t eventCount = parsingContext->events.size();
+    if (parsingContext->javaEventsSize < eventCount) {
+        size_t newSize = std::max(eventCount, MAX_QUEUED_EVENTS + 64);
+        ScopedLocalRef<jintArray> newEvents(env, env->NewIntArray(newSize));
+        if (newEvents.get() == NULL) {
+            return false;
+        }
+        if (parsingContext->javaEvents != NULL) {
+            env->DeleteGlobalRef(parsingContext->javaEvents);
+        }
+        parsingContext->javaEvents = reinterpret_cast<jintArray>(env->NewGlobalRef(newEvents.get()));
+        if (parsingContext->javaEvents == NULL) {
+            parsingContext->javaEventsSize = 0;
+            return false;
+        }
+        parsingContext->javaEventsSize = newSize;
+    }
+    env->SetIntArrayRegion(parsingContext->javaEvents, 0, eventCount, &parsingContext->events[0]);
+
+    std::vector<jstring>& names = parsingContext->names;
+    if (parsingContext->javaNamesSize < names.size()) {
+        size_t newSize = std::max(names.size(), 2 * parsingContext->javaNamesSize);
+        ScopedLocalRef<jobjectArray> newNames(env,
+                env->NewObjectArray(newSize, JniConstants::stringClass, NULL));
+        if (newNames.get() == NULL) {
+            return false;
+        }
+        if (parsingContext->javaNames != NULL) {
+            env->DeleteGlobalRef(parsingContext->javaNames);
+        }
+        parsingContext->javaNames = reinterpret_cast<jobjectArray>(env->NewGlobalRef(newNames.get()));
+        if (parsingContext->javaNames == NULL) {
+            parsingContext->javaNamesSize = 0;
+            return false;
+        }
+        parsingContext->javaNamesSize = newSize;
+        parsingContext->namesSent = 0;
+    }
+    for (size_t i = parsingContext->namesSent; i < names.size(); ++i) {
+        env->SetObjectArrayElement(parsingContext->javaNames, i, names[i]);
+    }
+    parsingContext->namesSent = names.size();
+    return !env->ExceptionCheck();
+}
+
+/**
+ * Passes everything collected so far to the Java parser. In batch mode that's
+ * one call to handleEvents; otherwise it's just pending text. Handlers that
+ * call into Java themselves call this first so that Java sees events in
+ * document order.
+ *
+ * @param parsingContext whose events to flush
+ */
+static void flushEvents(ParsingContext* parsingContext) {
+    if (!parsingContext->batchEvents) {
+        flushText(parsingContext);
+        return;
+    }
+
+    flushText(parsingContext);
+    size_t eventCount = parsingContext->events.size();
+    if (eventCount == 0) {
+        clearEvents(parsingContext);
+        return;
+    }
+
+    JNIEnv* env = parsingContext->env;
+    size_t textLength = parsingContext->pendingText.size();
+    jcharArray javaChars = parsingContext->ensureCapacity(textLength);
+    if (javaChars != NULL && copyEventsToJava(env, parsingContext)) {
+        env->SetCharArrayRegion(javaChars, 0, textLength, parsingContext->pendingText.get());
+        env->CallVoidMethod(parsingContext->object, handleEventsMethod,
+                parsingContext->javaEvents, eventCount, parsingContext->javaNames, javaChars);
+    }
+    clearEvents(parsingContext);
+}
+
+/**
+ * Returns the batch mode id for 'entry', adding it to 'names' if necessary.
+ */
+static jint nameId(ParsingContext* parsingContext, InternedString* entry) {
+    if (entry->id == -1) {
+        entry->id = parsingContext->names.size();
+        parsingContext->names.push_back(entry->interned);
+    }
+    return entry->id;
+}
+
+/**
+ * Appends the batch mode id for 'entry' to the queued events.
+ *
+ * @returns false if 'entry' is NULL because an exception was thrown
+ */
+static bool queueName(ParsingContext* parsingContext, InternedString* entry) {
+    if (entry == NULL) {
+        return false;
+    }
+    parsingContext->events.push_back(nameId(parsingContext, entry));
+    return true;
+}
+
+/**
+ * Passes the queued events to Java if there are enough of them.
+ */
+static void flushEventsIfFull(ParsingContext* parsingContext) {
+    if (parsingContext->events.size() >= MAX_QUEUED_EVENTS
+            || parsingContext->pendingText.size() >= MAX_PENDING_TEXT) {
+        flushEvents(parsingContext);
+    }
 }
 
 /**
@@ -459,6 +961,9 @@ static void bufferAndInvoke(jmethodID method, void* data, const char* text, size
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushEvents(parsingContext);
+    if (env->ExceptionCheck()) return;
+
     // Buffer the element name.
     size_t utf16length = fillBuffer(parsingContext, text, length);
 
@@ -496,7 +1001,11 @@ public:
      * Possibly empty.
      */
     jstring uri() {
-        return internString(mEnv, mParsingContext, mUri);
+        return toJString(uriEntry());
+    }
+
+    InternedString* uriEntry() {
+        return internName(mEnv, mParsingContext, mUri);
     }
 
     /**
@@ -505,54 +1014,36 @@ public:
      * local name like "html:h1". In such cases, the qName will always be empty.
      */
     jstring localName() {
-        return internString(mEnv, mParsingContext, mLocalName);
+        return toJString(localNameEntry());
+    }
+
+    InternedString* localNameEntry() {
+        return internName(mEnv, mParsingContext, mLocalName);
     }
 
     /**
      * Returns the namespace prefix, like "html". Possibly empty.
      */
     jstring qName() {
+        return toJString(qNameEntry());
+    }
+
+    InternedString* qNameEntry() {
         if (*mPrefix == 0) {
-            return localName();
+            return localNameEntry();
         }
 
         // return prefix + ":" + localName
         ::LocalArray<1024> qName(strlen(mPrefix) + 1 + strlen(mLocalName) + 1);
         snprintf(&qName[0], qName.size(), "%s:%s", mPrefix, mLocalName);
-        return internString(mEnv, mParsingContext, &qName[0]);
-    }
-
-    /**
-     * Returns true if this expat name has the same URI and local name.
-     */
-    bool matches(const char* uri, const char* localName) {
-        return strcmp(uri, mUri) == 0 && strcmp(localName, mLocalName) == 0;
+        return internName(mEnv, mParsingContext, &qName[0]);
     }
 
-    /**
-     * Returns true if this expat name has the same qualified name.
-     */
-    bool matchesQName(const char* qName) {
-        const char* lastColon = strrchr(qName, ':');
-
-        // Compare local names only if either:
-        //  - the input qualified name doesn't have a colon (like "h1")
-        //  - this element doesn't have a prefix. Such is the case when it
-        //    doesn't belong to a namespace, or when this parser's namespace
-        //    processing is disabled. In the latter case, this element's local
-        //    name may still contain a colon (like "html:h1").
-        if (lastColon == NULL || *mPrefix == 0) {
-            return strcmp(qName, mLocalName) == 0;
-        }
-
-        // Otherwise compare both prefix and local name
-        size_t prefixLength = lastColon - qName;
-        return strlen(mPrefix) == prefixLength
-            && strncmp(qName, mPrefix, prefixLength) == 0
-            && strcmp(lastColon + 1, mLocalName) == 0;
+private:
+    static jstring toJString(InternedString* entry) {
+        return (entry != NULL) ? entry->interned : NULL;
     }
 
-private:
     JNIEnv* mEnv;
     ParsingContext* mParsingContext;
     char* mCopy;
@@ -597,6 +1088,55 @@ private:
     void operator=(const ExpatElementName&);
 };
 
+/**
+ * Queues an EVENT_START_ELEMENT, copying the attribute values into
+ * pendingText.
+ */
+static void queueStartElement(JNIEnv* env, ParsingContext* parsingContext,
+        const char* elementName, const char** attributes, int count) {
+    std::vector<jint>& events = parsingContext->events;
+    events.push_back(EVENT_START_ELEMENT);
+
+    ExpatElementName e(env, parsingContext, elementName);
+    size_t nameIndex = events.size();
+    if (parsingContext->processNamespaces) {
+        if (!queueName(parsingContext, e.uriEntry())) return;
+        if (!queueName(parsingContext, e.localNameEntry())) return;
+    } else {
+        // emptyString is always name 0.
+        events.push_back(0);
+        events.push_back(0);
+    }
+    if (!queueName(parsingContext, e.qNameEntry())) return;
+    parsingContext->nameIdStack.insert(parsingContext->nameIdStack.end(),
+            events.begin() + nameIndex, events.end());
+    events.push_back(count);
+
+    PendingText& pendingText = parsingContext->pendingText;
+    jlong attributePointer = reinterpret_cast<uintptr_t>(attributes);
+    for (int i = 0; i < count; ++i) {
+        ExpatElementName name(env, parsingContext, attributePointer, i);
+        if (!queueName(parsingContext, name.uriEntry())) return;
+        if (!queueName(parsingContext, name.localNameEntry())) return;
+        if (!queueName(parsingContext, name.qNameEntry())) return;
+
+        const char* value = attributes[i * 2 + 1];
+        size_t valueLength = strlen(value);
+        jchar* chars = pendingText.reserve(valueLength);
+        if (chars == NULL) {
+            jniThrowOutOfMemoryError(env, NULL);
+            return;
+        }
+        events.push_back(pendingText.size());
+        size_t utf16Length = utf8ToUtf16(chars, value, valueLength);
+        pendingText.commit(utf16Length);
+        events.push_back(utf16Length);
+    }
+    parsingContext->textStart = pendingText.size();
+
+    flushEventsIfFull(parsingContext);
+}
+
 /**
  * Called by Expat at the start of an element. Delegates to the same method
  * on the Java parser.
@@ -613,10 +1153,18 @@ static void startElement(void* data, const char* elementName, const char** attri
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushText(parsingContext);
+    if (env->ExceptionCheck()) return;
+
     // Count the number of attributes.
     int count = 0;
     while (attributes[count * 2]) count++;
 
+    if (parsingContext->batchEvents) {
+        queueStartElement(env, parsingContext, elementName, attributes, count);
+        return;
+    }
+
     // Make the attributes available for the duration of this call.
     parsingContext->attributes = attributes;
     parsingContext->attributeCount = count;
@@ -653,6 +1201,19 @@ static void endElement(void* data, const char* /*elementName*/) {
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushText(parsingContext);
+    if (env->ExceptionCheck()) return;
+
+    if (parsingContext->batchEvents) {
+        std::vector<jint>& nameIdStack = parsingContext->nameIdStack;
+        std::vector<jint>& events = parsingContext->events;
+        events.push_back(EVENT_END_ELEMENT);
+        events.insert(events.end(), nameIdStack.end() - 3, nameIdStack.end());
+        nameIdStack.resize(nameIdStack.size() - 3);
+        flushEventsIfFull(parsingContext);
+        return;
+    }
+
     jobject javaParser = parsingContext->object;
 
     jstring localName = parsingContext->stringStack.pop();
@@ -672,7 +1233,24 @@ static void endElement(void* data, const char* /*elementName*/) {
  * @param length number of characters in the buffer
  */
 static void text(void* data, const char* characters, int length) {
-    bufferAndInvoke(textMethod, data, characters, length);
+    ParsingContext* parsingContext = toParsingContext(data);
+    JNIEnv* env = parsingContext->env;
+
+    // Bail out if a previously called handler threw an exception.
+    if (env->ExceptionCheck()) return;
+
+    // Expat splits runs of text at line breaks, entity references and buffer
+    // boundaries. Collect the pieces and pass them to Java in one call.
+    PendingText& pendingText = parsingContext->pendingText;
+    jchar* chars = pendingText.reserve(length);
+    if (chars == NULL) {
+        jniThrowOutOfMemoryError(env, NULL);
+        return;
+    }
+    pendingText.commit(utf8ToUtf16(chars, characters, length));
+    if (pendingText.size() >= MAX_PENDING_TEXT) {
+        flushEvents(parsingContext);
+    }
 }
 
 /**
@@ -700,6 +1278,29 @@ static void startNamespace(void* data, const char* prefix, const char* uri) {
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushText(parsingContext);
+    if (env->ExceptionCheck()) return;
+
+    if (parsingContext->batchEvents) {
+        std::vector<jint>& events = parsingContext->events;
+        events.push_back(EVENT_START_NAMESPACE);
+        jint prefixId = 0;
+        if (prefix != NULL) {
+            InternedString* entry = internName(env, parsingContext, prefix);
+            if (entry == NULL) return;
+            prefixId = nameId(parsingContext, entry);
+        }
+        events.push_back(prefixId);
+        if (uri == NULL) {
+            events.push_back(0);
+        } else if (!queueName(parsingContext, internName(env, parsingContext, uri))) {
+            return;
+        }
+        parsingContext->nameIdStack.push_back(prefixId);
+        flushEventsIfFull(parsingContext);
+        return;
+    }
+
     jstring internedPrefix = emptyString;
     if (prefix != NULL) {
         internedPrefix = internString(env, parsingContext, prefix);
@@ -732,6 +1333,18 @@ static void endNamespace(void* data, const char* /*prefix*/) {
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushText(parsingContext);
+    if (env->ExceptionCheck()) return;
+
+    if (parsingContext->batchEvents) {
+        std::vector<jint>& events = parsingContext->events;
+        events.push_back(EVENT_END_NAMESPACE);
+        events.push_back(parsingContext->nameIdStack.back());
+        parsingContext->nameIdStack.pop_back();
+        flushEventsIfFull(parsingContext);
+        return;
+    }
+
     jstring internedPrefix = parsingContext->stringStack.pop();
 
     jobject javaParser = parsingContext->object;
@@ -750,6 +1363,9 @@ static void startCdata(void* data) {
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushEvents(parsingContext);
+    if (env->ExceptionCheck()) return;
+
     jobject javaParser = parsingContext->object;
     env->CallVoidMethod(javaParser, startCdataMethod);
 }
@@ -766,6 +1382,9 @@ static void endCdata(void* data) {
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushEvents(parsingContext);
+    if (env->ExceptionCheck()) return;
+
     jobject javaParser = parsingContext->object;
     env->CallVoidMethod(javaParser, endCdataMethod);
 }
@@ -782,6 +1401,9 @@ static void startDtd(void* data, const char* name,
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushEvents(parsingContext);
+    if (env->ExceptionCheck()) return;
+
     jstring javaName = internString(env, parsingContext, name);
     if (env->ExceptionCheck()) return;
 
@@ -808,6 +1430,9 @@ static void endDtd(void* data) {
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushEvents(parsingContext);
+    if (env->ExceptionCheck()) return;
+
     jobject javaParser = parsingContext->object;
     env->CallVoidMethod(javaParser, endDtdMethod);
 }
@@ -826,6 +1451,9 @@ static void processingInstruction(void* data, const char* target, const char* in
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushEvents(parsingContext);
+    if (env->ExceptionCheck()) return;
+
     jstring javaTarget = internString(env, parsingContext, target);
     if (env->ExceptionCheck()) return;
 
@@ -876,6 +1504,11 @@ static int handleExternalEntity(XML_Parser parser, const char* context,
         return XML_STATUS_ERROR;
     }
 
+    flushEvents(parsingContext);
+    if (env->ExceptionCheck()) {
+        return XML_STATUS_ERROR;
+    }
+
     ScopedLocalRef<jstring> javaSystemId(env, env->NewStringUTF(systemId));
     if (env->ExceptionCheck()) {
         return XML_STATUS_ERROR;
@@ -917,6 +1550,9 @@ static void unparsedEntityDecl(void* data, const char* name, const char* /*base*
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushEvents(parsingContext);
+    if (env->ExceptionCheck()) return;
+
     ScopedLocalRef<jstring> javaName(env, env->NewStringUTF(name));
     if (env->ExceptionCheck()) return;
     ScopedLocalRef<jstring> javaPublicId(env, env->NewStringUTF(publicId));
@@ -940,6 +1576,9 @@ static void notationDecl(void* data, const char* name, const char* /*base*/, con
     // Bail out if a previously called handler threw an exception.
     if (env->ExceptionCheck()) return;
 
+    flushEvents(parsingContext);
+    if (env->ExceptionCheck()) return;
+
     ScopedLocalRef<jstring> javaName(env, env->NewStringUTF(name));
     if (env->ExceptionCheck()) return;
     ScopedLocalRef<jstring> javaPublicId(env, env->NewStringUTF(publicId));
@@ -956,10 +1595,14 @@ static void notationDecl(void* data, const char* name, const char* /*base*/, con
  * @param object the Java ExpatParser instance
  * @param javaEncoding the character encoding name
  * @param processNamespaces true if the parser should handle namespaces
+ * @param sharedInterning true if names should be interned in the table shared
+ *  by all parsers
+ * @param batchEvents true if element, text and namespace events should be
+ *  passed to Java in batches
  * @returns the pointer to the C Expat parser
  */
 static jlong ExpatParser_initialize(JNIEnv* env, jobject object, jstring javaEncoding,
-        jboolean processNamespaces) {
+        jboolean processNamespaces, jboolean sharedInterning, jboolean batchEvents) {
     // Allocate parsing context.
     UniquePtr<ParsingContext> context(new ParsingContext(object));
     if (context.get() == NULL) {
@@ -968,6 +1611,12 @@ static jlong ExpatParser_initialize(JNIEnv* env, jobject object, jstring javaEnc
     }
 
     context->processNamespaces = processNamespaces;
+    context->sharedInterning = sharedInterning;
+    context->batchEvents = batchEvents;
+    if (batchEvents) {
+        // Name 0 is always "", standing in for missing URIs and prefixes.
+        context->names.push_back(emptyString);
+    }
 
     // Create a parser.
     XML_Parser parser;
@@ -1019,7 +1668,13 @@ static void append(JNIEnv* env, jobject object, jlong pointer,
     ParsingContext* context = toParsingContext(parser);
     context->env = env;
     context->object = object;
-    if (!XML_Parse(parser, bytes + byteOffset, byteCount, isFinal) && !env->ExceptionCheck()) {
+    bool ok = XML_Parse(parser, bytes + byteOffset, byteCount, isFinal);
+    // Don't hold events over to the next call; Java may be expecting them now.
+    if (!env->ExceptionCheck()) {
+        flushEvents(context);
+    }
+    clearEvents(context);
+    if (!ok && !env->ExceptionCheck()) {
         jniThrowExpatException(env, XML_GetErrorCode(parser));
     }
     context->object = NULL;
@@ -1060,6 +1715,23 @@ static void ExpatParser_appendString(JNIEnv* env, jobject object, jlong pointer,
     append(env, object, pointer, bytes, 0, byteCount, isFinal);
 }
 
+/**
+ * Parses 'byteCount' bytes of XML from native memory, such as a direct
+ * ByteBuffer or an mmapped file. Expat scans the bytes in place.
+ */
+static void ExpatParser_appendAddress(JNIEnv* env, jobject object, jlong pointer,
+        jlong address, jlong byteCount, jboolean isFinal) {
+    const char* bytes = reinterpret_cast<const char*>(static_cast<uintptr_t>(address));
+    // XML_Parse takes an int length, so very large inputs go in slices.
+    const jlong MAX_SLICE_SIZE = 1 << 30;
+    do {
+        jlong sliceSize = std::min(byteCount, MAX_SLICE_SIZE);
+        byteCount -= sliceSize;
+        append(env, object, pointer, bytes, 0, sliceSize, isFinal && byteCount == 0);
+        bytes += sliceSize;
+    } while (byteCount > 0 && !env->ExceptionCheck());
+}
+
 /**
  * Releases parser only.
  */
@@ -1088,45 +1760,6 @@ static int ExpatParser_column(JNIEnv*, jobject, jlong address) {
   return XML_GetCurrentColumnNumber(toXMLParser(address));
 }
 
-/**
- * Gets the URI of the attribute at the given index.
- *
- * @param attributePointer to the attribute array
- * @param index of the attribute
- * @returns interned Java string containing attribute's URI
- */
-static jstring ExpatAttributes_getURI(JNIEnv* env, jobject, jlong address,
-        jlong attributePointer, jint index) {
-  ParsingContext* context = toParsingContext(toXMLParser(address));
-  return ExpatElementName(env, context, attributePointer, index).uri();
-}
-
-/**
- * Gets the local name of the attribute at the given index.
- *
- * @param attributePointer to the attribute array
- * @param index of the attribute
- * @returns interned Java string containing attribute's local name
- */
-static jstring ExpatAttributes_getLocalName(JNIEnv* env, jobject, jlong address,
-        jlong attributePointer, jint index) {
-  ParsingContext* context = toParsingContext(toXMLParser(address));
-  return ExpatElementName(env, context, attributePointer, index).localName();
-}
-
-/**
- * Gets the qualified name of the attribute at the given index.
- *
- * @param attributePointer to the attribute array
- * @param index of the attribute
- * @returns interned Java string containing attribute's local name
- */
-static jstring ExpatAttributes_getQName(JNIEnv* env, jobject, jlong address,
-        jlong attributePointer, jint index) {
-  ParsingContext* context = toParsingContext(toXMLParser(address));
-  return ExpatElementName(env, context, attributePointer, index).qName();
-}
-
 /**
  * Gets the value of the attribute at the given index.
  *
@@ -1143,93 +1776,46 @@ static jstring ExpatAttributes_getValueByIndex(JNIEnv* env, jobject,
 }
 
 /**
- * Gets the index of the attribute with the given qualified name.
+ * Gets the interned qualified names of the first 'count' attributes.
  *
  * @param attributePointer to the attribute array
- * @param qName to look for
- * @returns index of attribute with the given uri and local name or -1 if not
- *  found
+ * @param qNames receives the names
  */
-static jint ExpatAttributes_getIndexForQName(JNIEnv* env, jobject,
-        jlong attributePointer, jstring qName) {
-    ScopedUtfChars qNameBytes(env, qName);
-    if (qNameBytes.c_str() == NULL) {
-        return -1;
-    }
-
-    const char** attributes = toAttributes(attributePointer);
-    int found = -1;
-    for (int index = 0; attributes[index * 2]; ++index) {
-        if (ExpatElementName(NULL, NULL, attributePointer, index).matchesQName(qNameBytes.c_str())) {
-            found = index;
-            break;
+static void ExpatAttributes_getQNames(JNIEnv* env, jobject, jlong address,
+        jlong attributePointer, jobjectArray qNames, jint count) {
+    ParsingContext* context = toParsingContext(toXMLParser(address));
+    for (jint i = 0; i < count; ++i) {
+        jstring qName = ExpatElementName(env, context, attributePointer, i).qName();
+        if (env->ExceptionCheck()) {
+            return;
         }
+        env->SetObjectArrayElement(qNames, i, qName);
     }
-
-    return found;
 }
 
 /**
- * Gets the index of the attribute with the given URI and name.
+ * Gets the interned URIs and local names of the first 'count' attributes.
  *
  * @param attributePointer to the attribute array
- * @param uri to look for
- * @param localName to look for
- * @returns index of attribute with the given uri and local name or -1 if not
- *  found
+ * @param uris receives the URIs
+ * @param localNames receives the local names
  */
-static jint ExpatAttributes_getIndex(JNIEnv* env, jobject, jlong attributePointer,
-        jstring uri, jstring localName) {
-    ScopedUtfChars uriBytes(env, uri);
-    if (uriBytes.c_str() == NULL) {
-        return -1;
-    }
-
-    ScopedUtfChars localNameBytes(env, localName);
-    if (localNameBytes.c_str() == NULL) {
-        return -1;
-    }
-
-    const char** attributes = toAttributes(attributePointer);
-    for (int index = 0; attributes[index * 2]; ++index) {
-        if (ExpatElementName(NULL, NULL, attributePointer, index).matches(uriBytes.c_str(),
-                localNameBytes.c_str())) {
-            return index;
+static void ExpatAttributes_getNames(JNIEnv* env, jobject, jlong address,
+        jlong attributePointer, jobjectArray uris, jobjectArray localNames, jint count) {
+    ParsingContext* context = toParsingContext(toXMLParser(address));
+    for (jint i = 0; i < count; ++i) {
+        ExpatElementName name(env, context, attributePointer, i);
+        jstring uri = name.uri();
+        if (env->ExceptionCheck()) {
+            return;
+        }
+        env->SetObjectArrayElement(uris, i, uri);
+        jstring localName = name.localName();
+        if (env->ExceptionCheck()) {
+            return;
         }
+        env->SetObjectArrayElement(localNames, i, localName);
     }
-    return -1;
-}
-
-/**
- * Gets the value of the attribute with the given qualified name.
- *
- * @param attributePointer to the attribute array
- * @param uri to look for
- * @param localName to look for
- * @returns value of attribute with the given uri and local name or NULL if not
- *  found
- */
-static jstring ExpatAttributes_getValueForQName(JNIEnv* env, jobject clazz,
-        jlong attributePointer, jstring qName) {
-    jint index = ExpatAttributes_getIndexForQName(env, clazz, attributePointer, qName);
-    return index == -1 ? NULL
-            : ExpatAttributes_getValueByIndex(env, clazz, attributePointer, index);
-}
-
-/**
- * Gets the value of the attribute with the given URI and name.
- *
- * @param attributePointer to the attribute array
- * @param uri to look for
- * @param localName to look for
- * @returns value of attribute with the given uri and local name or NULL if not
- *  found
- */
-static jstring ExpatAttributes_getValue(JNIEnv* env, jobject clazz,
-        jlong attributePointer, jstring uri, jstring localName) {
-    jint index = ExpatAttributes_getIndex(env, clazz, attributePointer, uri, localName);
-    return index == -1 ? NULL
-            : ExpatAttributes_getValueByIndex(env, clazz, attributePointer, index);
 }
 
 /**
@@ -1283,6 +1869,25 @@ static void ExpatAttributes_freeAttributes(JNIEnv*, jobject, jlong pointer) {
     delete[] reinterpret_cast<char*>(static_cast<uintptr_t>(pointer));
 }
 
+/**
+ * Returns the shared intern table's hit count, miss count and size.
+ */
+static jlongArray ExpatParser_getSharedInternCounters(JNIEnv* env, jclass) {
+    jlong counters[3];
+    {
+        ScopedPthreadMutexLock lock(&gSharedInternMutex);
+        counters[0] = gSharedInternHits;
+        counters[1] = gSharedInternMisses;
+        counters[2] = gSharedInternTable.size();
+    }
+    jlongArray result = env->NewLongArray(3);
+    if (result == NULL) {
+        return NULL;
+    }
+    env->SetLongArrayRegion(result, 0, 3, counters);
+    return result;
+}
+
 /**
  * Called when we initialize our Java parser class.
  *
@@ -1329,6 +1934,10 @@ static void ExpatParser_staticInitialize(JNIEnv* env, jobject classObject, jstri
         "processingInstruction", "(Ljava/lang/String;Ljava/lang/String;)V");
     if (processingInstructionMethod == NULL) return;
 
+    handleEventsMethod = env->GetMethodID(clazz, "handleEvents",
+        "([II[Ljava/lang/String;[C)V");
+    if (handleEventsMethod == NULL) return;
+
     handleExternalEntityMethod = env->GetMethodID(clazz,
         "handleExternalEntity",
         "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V");
@@ -1351,12 +1960,14 @@ static void ExpatParser_staticInitialize(JNIEnv* env, jobject classObject, jstri
 
 static JNINativeMethod parserMethods[] = {
     NATIVE_METHOD(ExpatParser, appendString, "(JLjava/lang/String;Z)V"),
+    NATIVE_METHOD(ExpatParser, appendAddress, "(JJJZ)V"),
     NATIVE_METHOD(ExpatParser, appendBytes, "(J[BII)V"),
     NATIVE_METHOD(ExpatParser, appendChars, "(J[CII)V"),
     NATIVE_METHOD(ExpatParser, cloneAttributes, "(JI)J"),
     NATIVE_METHOD(ExpatParser, column, "(J)I"),
     NATIVE_METHOD(ExpatParser, createEntityParser, "(JLjava/lang/String;)J"),
-    NATIVE_METHOD(ExpatParser, initialize, "(Ljava/lang/String;Z)J"),
+    NATIVE_METHOD(ExpatParser, getSharedInternCounters, "()[J"),
+    NATIVE_METHOD(ExpatParser, initialize, "(Ljava/lang/String;ZZZ)J"),
     NATIVE_METHOD(ExpatParser, line, "(J)I"),
     NATIVE_METHOD(ExpatParser, release, "(J)V"),
     NATIVE_METHOD(ExpatParser, releaseParser, "(J)V"),
@@ -1365,14 +1976,9 @@ static JNINativeMethod parserMethods[] = {
 
 static JNINativeMethod attributeMethods[] = {
     NATIVE_METHOD(ExpatAttributes, freeAttributes, "(J)V"),
-    NATIVE_METHOD(ExpatAttributes, getIndexForQName, "(JLjava/lang/String;)I"),
-    NATIVE_METHOD(ExpatAttributes, getIndex, "(JLjava/lang/String;Ljava/lang/String;)I"),
-    NATIVE_METHOD(ExpatAttributes, getLocalName, "(JJI)Ljava/lang/String;"),
-    NATIVE_METHOD(ExpatAttributes, getQName, "(JJI)Ljava/lang/String;"),
-    NATIVE_METHOD(ExpatAttributes, getURI, "(JJI)Ljava/lang/String;"),
+    NATIVE_METHOD(ExpatAttributes, getNames, "(JJ[Ljava/lang/String;[Ljava/lang/String;I)V"),
+    NATIVE_METHOD(ExpatAttributes, getQNames, "(JJ[Ljava/lang/String;I)V"),
     NATIVE_METHOD(ExpatAttributes, getValueByIndex, "(JI)Ljava/lang/String;"),
-    NATIVE_METHOD(ExpatAttributes, getValueForQName, "(JLjava/lang/String;)Ljava/lang/String;"),
-    NATIVE_METHOD(ExpatAttributes, getValue, "(JLjava/lang/String;Ljava/lang/String;)Ljava/lang/String;"),
 };
 void register_org_apache_harmony_xml_ExpatParser(JNIEnv* env) {
     jniRegisterNativeMethods(env, "org/apache/harmony/xml/ExpatParser", parserMethods, NELEM(parserMethods));
@@ -35,31 +35,19 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+// Removes the last path component from 'resolved', leaving "/" rather than "" for "/x".
+static void stripLastComponent(std::string& resolved) {
+    size_t lastSlash = resolved.rfind('/');
+    resolved.erase((lastSlash == 0) ? 1 : lastSlash);
+}
+
 /**
- * This differs from realpath(3) mainly in its behavior when a path element does not exist or can
- * not be searched. realpath(3) treats that as an error and gives up, but we have Java-compatible
- * behavior where we just assume the path element was not a symbolic link. This leads to a textual
- * treatment of ".." from that point in the path, which may actually lead us back to a path we
- * can resolve (as in "/tmp/does-not-exist/../blah.txt" which would be an error for realpath(3)
- * but "/tmp/blah.txt" under the traditional Java interpretation).
- *
- * This implementation also removes all the fixed-length buffers of the C original.
+ * Resolves the relative path 'left' against 'resolved', which must already be canonical. See
+ * realpath below.
  */
-bool realpath(const char* path, std::string& resolved) {
-    // 'path' must be an absolute path.
-    if (path[0] != '/') {
-        errno = EINVAL;
-        return false;
-    }
-
-    resolved = "/";
-    if (path[1] == '\0') {
-        return true;
-    }
-
+static bool resolve(std::string& resolved, std::string left) {
     // Iterate over path components in 'left'.
     int symlinkCount = 0;
-    std::string left(path + 1);
     while (!left.empty()) {
         // Extract the next path component.
         size_t nextSlash = left.find('/');
@@ -76,7 +64,7 @@ bool realpath(const char* path, std::string& resolved) {
         } else if (nextPathComponent == "..") {
             // Strip the last path component except when we have single "/".
             if (resolved.size() > 1) {
-                resolved.erase(resolved.rfind('/'));
+                stripLastComponent(resolved);
             }
             continue;
         }
@@ -105,7 +93,7 @@ bool realpath(const char* path, std::string& resolved) {
             } else if (resolved.size() > 1) {
                 // The symbolic link is relative, so we just lose the last path component (which
                 // was the link).
-                resolved.erase(resolved.rfind('/'));
+                stripLastComponent(resolved);
             }
 
             if (!left.empty()) {
@@ -123,3 +111,36 @@ bool realpath(const char* path, std::string& resolved) {
     }
     return true;
 }
+
+/**
+ * This differs from realpath(3) mainly in its behavior when a path element does not exist or can
+ * not be searched. realpath(3) treats that as an error and gives up, but we have Java-compatible
+ * behavior where we just assume the path element was not a symbolic link. This leads to a textual
+ * treatment of ".." from that point in the path, which may actually lead us back to a path we
+ * can resolve (as in "/tmp/does-not-exist/../blah.txt" which would be an error for realpath(3)
+ * but "/tmp/blah.txt" under the traditional Java interpretation).
+ *
+ * This implementation also removes all the fixed-length buffers of the C original.
+ */
+bool realpath(const char* path, std::string& resolved) {
+    // 'path' must be an absolute path.
+    if (path[0] != '/') {
+        errno = EINVAL;
+        return false;
+    }
+
+    resolved = "/";
+    if (path[1] == '\0') {
+        return true;
+    }
+    return resolve(resolved, path + 1);
+}
+
+/**
+ * Like realpath, for the path 'canonicalPrefix' + "/" + 'relative', where 'canonicalPrefix' is
+ * already the result of a realpath call. This lets callers reuse the resolution of a directory.
+ */
+bool realpathFrom(const std::string& canonicalPrefix, const char* relative, std::string& resolved) {
+    resolved = canonicalPrefix;
+    return resolve(resolved, relative);
+}
@@ -8,8 +8,10 @@ LOCAL_SRC_FILES := \
 	ExecStrings.cpp \
 	IcuUtilities.cpp \
 	JniException.cpp \
+	NativeCounters.cpp \
 	NetworkUtilities.cpp \
 	Register.cpp \
+	StartupProfile.cpp \
 	ZipUtilities.cpp \
 	cbigint.cpp \
 	java_io_Console.cpp \
@@ -34,6 +36,7 @@ LOCAL_SRC_FILES := \
 	java_util_zip_CRC32.cpp \
 	java_util_zip_Deflater.cpp \
 	java_util_zip_Inflater.cpp \
+	java_util_zip_ParallelDeflater.cpp \
 	libcore_icu_AlphabeticIndex.cpp \
 	libcore_icu_DateIntervalFormat.cpp \
 	libcore_icu_ICU.cpp \
@@ -46,11 +49,15 @@ LOCAL_SRC_FILES := \
 	libcore_icu_NativePluralRules.cpp \
 	libcore_icu_TimeZoneNames.cpp \
 	libcore_icu_Transliterator.cpp \
+	libcore_io_AsyncResolver.cpp \
 	libcore_io_AsynchronousCloseMonitor.cpp \
+	libcore_io_IoUring.cpp \
 	libcore_io_Memory.cpp \
 	libcore_io_OsConstants.cpp \
 	libcore_io_Posix.cpp \
 	libcore_net_RawSocket.cpp \
+	libcore_util_ArrayMath.cpp \
+	libcore_util_Clocks.cpp \
 	org_apache_harmony_xml_ExpatParser.cpp \
 	readlink.cpp \
 	realpath.cpp \
@@ -23,8 +23,35 @@ static jobject Unsafe_allocateInstance(JNIEnv* env, jclass, jclass c) {
   return env->AllocObject(c);
 }
 
+// Makes a whole batch of instances in one native call, for callers such as deserializers that
+// know how many they'll need.
+static jobjectArray Unsafe_allocateInstances(JNIEnv* env, jclass, jclass c, jint count) {
+  if (c == NULL) {
+    jniThrowNullPointerException(env, "c == null");
+    return NULL;
+  }
+  if (count < 0) {
+    jniThrowExceptionFmt(env, "java/lang/NegativeArraySizeException", "%d", count);
+    return NULL;
+  }
+  jobjectArray result = env->NewObjectArray(count, JniConstants::objectClass, NULL);
+  if (result == NULL) {
+    return NULL;
+  }
+  for (jint i = 0; i < count; ++i) {
+    jobject instance = env->AllocObject(c);
+    if (instance == NULL) {
+      return NULL;
+    }
+    env->SetObjectArrayElement(result, i, instance);
+    env->DeleteLocalRef(instance);
+  }
+  return result;
+}
+
 static JNINativeMethod gMethods[] = {
   NATIVE_METHOD(Unsafe, allocateInstance, "(Ljava/lang/Class;)Ljava/lang/Object;"),
+  NATIVE_METHOD(Unsafe, allocateInstances, "(Ljava/lang/Class;I)[Ljava/lang/Object;"),
 };
 void register_sun_misc_Unsafe(JNIEnv* env) {
   jniRegisterNativeMethods(env, "sun/misc/Unsafe", gMethods, NELEM(gMethods));
@@ -26,8 +26,42 @@ static jobject valueOf(JNIEnv* env, jclass c, const char* signature, const T& va
     return env->CallStaticObjectMethod(c, valueOfMethod, value);
 }
 
+/*
+ * Global references to the boxes valueOf returns for the values Java caches too: both Booleans,
+ * and Integers and Longs from -128 to 127. Each is filled in the first time it's asked for, after
+ * which boxing that value costs a NewLocalRef rather than a call into Java. Because they're the
+ * same cached instances, callers can't tell the difference.
+ */
+static const int BOX_CACHE_LOW = -128;
+static const int BOX_CACHE_HIGH = 127;
+static jobject gBooleanCache[2];
+static jobject gIntegerCache[BOX_CACHE_HIGH - BOX_CACHE_LOW + 1];
+static jobject gLongCache[BOX_CACHE_HIGH - BOX_CACHE_LOW + 1];
+
+template <typename T>
+static jobject cachedValueOf(JNIEnv* env, jobject* slot, jclass c, const char* signature,
+        const T& value) {
+    jobject cached = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (cached != NULL) {
+        return env->NewLocalRef(cached);
+    }
+    jobject boxed = valueOf(env, c, signature, value);
+    if (boxed == NULL) {
+        return NULL;
+    }
+    jobject global = env->NewGlobalRef(boxed);
+    jobject expected = NULL;
+    if (global != NULL && !__atomic_compare_exchange_n(slot, &expected, global, false,
+            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        // Another thread got there first.
+        env->DeleteGlobalRef(global);
+    }
+    return boxed;
+}
+
 jobject booleanValueOf(JNIEnv* env, jboolean value) {
-    return valueOf(env, JniConstants::booleanClass, "(Z)Ljava/lang/Boolean;", value);
+    return cachedValueOf(env, &gBooleanCache[value ? 1 : 0], JniConstants::booleanClass,
+            "(Z)Ljava/lang/Boolean;", value);
 }
 
 jobject doubleValueOf(JNIEnv* env, jdouble value) {
@@ -35,10 +69,18 @@ jobject doubleValueOf(JNIEnv* env, jdouble value) {
 }
 
 jobject integerValueOf(JNIEnv* env, jint value) {
+    if (value >= BOX_CACHE_LOW && value <= BOX_CACHE_HIGH) {
+        return cachedValueOf(env, &gIntegerCache[value - BOX_CACHE_LOW],
+                JniConstants::integerClass, "(I)Ljava/lang/Integer;", value);
+    }
     return valueOf(env, JniConstants::integerClass, "(I)Ljava/lang/Integer;", value);
 }
 
 jobject longValueOf(JNIEnv* env, jlong value) {
+    if (value >= BOX_CACHE_LOW && value <= BOX_CACHE_HIGH) {
+        return cachedValueOf(env, &gLongCache[value - BOX_CACHE_LOW],
+                JniConstants::longClass, "(J)Ljava/lang/Long;", value);
+    }
     return valueOf(env, JniConstants::longClass, "(J)Ljava/lang/Long;", value);
 }
 
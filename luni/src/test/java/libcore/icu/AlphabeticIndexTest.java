@@ -220,4 +220,29 @@ public class AlphabeticIndexTest extends junit.framework.TestCase {
     } catch (IllegalArgumentException expected) {
     }
   }
+
+  public void test_getBucketIndices() throws Exception {
+    String[] names = { "Allen", "bob", null, "\u30a2\u30ec\u30f3", "Zed", "" };
+    AlphabeticIndex.ImmutableIndex ja = createIndex(Locale.JAPANESE);
+    int[] indices = ja.getBucketIndices(names);
+    assertEquals(names.length, indices.length);
+    for (int i = 0; i < names.length; ++i) {
+      assertEquals(names[i] == null ? -1 : ja.getBucketIndex(names[i]), indices[i]);
+    }
+    AlphabeticIndex mutable = new AlphabeticIndex(Locale.JAPANESE).addLabels(Locale.US);
+    int[] mutableIndices = mutable.getBucketIndices(names);
+    for (int i = 0; i < names.length; ++i) {
+      assertEquals(names[i] == null ? -1 : mutable.getBucketIndex(names[i]), mutableIndices[i]);
+    }
+    assertEquals(0, ja.getBucketIndices(new String[0]).length);
+  }
+
+  public void test_getImmutableIndex_cached() throws Exception {
+    AlphabeticIndex.ImmutableIndex a = AlphabeticIndex.getImmutableIndex(99, Locale.JAPANESE, Locale.US);
+    assertSame(a, AlphabeticIndex.getImmutableIndex(99, Locale.JAPANESE, Locale.US));
+    assertNotSame(a, AlphabeticIndex.getImmutableIndex(10, Locale.JAPANESE, Locale.US));
+    assertNotSame(a, AlphabeticIndex.getImmutableIndex(99, Locale.US, Locale.JAPANESE));
+    assertHasLabel(a, "Allen", "A");
+    assertHasLabel(a, "\u30a2\u30ec\u30f3", "\u30a2");
+  }
 }
@@ -72,6 +72,51 @@ public class ICUTest extends junit.framework.TestCase {
     assertEquals("Hebr", ICU.getScript(ICU.addLikelySubtags("iw_IL")));
   }
 
+  public void test_cachedLookupsAreStable() throws Exception {
+    // Cycle through more locales than the native pattern generator cache holds, twice.
+    String[] locales = { "en_US", "de_DE", "fr_FR", "ja_JP", "he_IL", "ru_RU", "en_US" };
+    String[] patterns = new String[locales.length];
+    for (int round = 0; round < 2; ++round) {
+      for (int i = 0; i < locales.length; ++i) {
+        String pattern = ICU.getBestDateTimePattern("yMMMd", locales[i]);
+        if (round == 0) {
+          patterns[i] = pattern;
+        } else {
+          assertEquals(locales[i], patterns[i], pattern);
+        }
+      }
+      assertEquals("Latn", ICU.getScript(ICU.addLikelySubtags("en_US")));
+      assertEquals("Jpan", ICU.getScript(ICU.addLikelySubtags("ja")));
+      assertEquals("EUR", ICU.getCurrencyCode("DE"));
+      assertEquals(0, ICU.getCurrencyFractionDigits("JPY"));
+      assertEquals(2, ICU.getCurrencyFractionDigits("USD"));
+    }
+    assertEquals(patterns[0], patterns[locales.length - 1]);
+  }
+
+  public void test_toLowerCase_toUpperCase() throws Exception {
+    String lower = "content-type: text/html";
+    assertSame(lower, ICU.toLowerCase(lower, "en_US"));
+    assertEquals("CONTENT-TYPE: TEXT/HTML", ICU.toUpperCase(lower, "en_US"));
+    assertEquals("content-type", ICU.toLowerCase("Content-Type", "en_US"));
+    // Turkish maps ASCII 'I' and 'i' outside ASCII, so it mustn't take the ASCII path.
+    assertEquals("\u0131stanbul", ICU.toLowerCase("Istanbul", "tr_TR"));
+    assertEquals("\u0130STANBUL", ICU.toUpperCase("istanbul", "tr"));
+    assertEquals("STRASSE", ICU.toUpperCase("stra\u00dfe", "de_DE"));
+
+    String unchanged = "accept";
+    String[] strings = { "Accept", null, unchanged, "X-Forwarded-For", "" };
+    ICU.toLowerCaseAll(strings, "en_US");
+    assertEquals("accept", strings[0]);
+    assertNull(strings[1]);
+    assertSame(unchanged, strings[2]);
+    assertEquals("x-forwarded-for", strings[3]);
+    assertEquals("", strings[4]);
+    ICU.toUpperCaseAll(strings, "en_US");
+    assertEquals("ACCEPT", strings[0]);
+    assertEquals("X-FORWARDED-FOR", strings[3]);
+  }
+
   private String best(Locale l, String skeleton) {
     return ICU.getBestDateTimePattern(skeleton, l.toString());
   }
@@ -27,6 +27,18 @@ public class LocaleDataTest extends junit.framework.TestCase {
         }
     }
 
+    public void testPreload() throws Exception {
+        Locale[] locales = { new Locale("fr", "CA"), new Locale("ja", "JP"), new Locale("pt", "BR") };
+        LocaleData.preload(locales);
+        // Whether or not the background threads have finished, get returns complete data.
+        for (Locale l : locales) {
+            LocaleData d = LocaleData.get(l);
+            assertNotNull(l.toString(), d.longMonthNames);
+            assertNotNull(l.toString(), d.numberPattern);
+            assertSame(d, LocaleData.get(l));
+        }
+    }
+
     public void test_en_US() throws Exception {
         LocaleData l = LocaleData.get(Locale.US);
         assertEquals("AM", l.amPm[0]);
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.icu;
+
+import java.text.BreakIterator;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.Locale;
+
+public class NativeBreakIteratorTest extends junit.framework.TestCase {
+  private static final String TEXT = "The quick (\"brown\") fox can't jump 32.3 feet, right?\nNo.";
+
+  private static int[] boundaries(BreakIterator it, String text) {
+    it.setText(text);
+    List<Integer> result = new ArrayList<Integer>();
+    for (int i = it.first(); i != BreakIterator.DONE; i = it.next()) {
+      result.add(i);
+    }
+    int[] array = new int[result.size()];
+    for (int i = 0; i < array.length; ++i) {
+      array[i] = result.get(i);
+    }
+    return array;
+  }
+
+  public void test_getWordBoundaries() throws Exception {
+    int[] expected = boundaries(BreakIterator.getWordInstance(Locale.US), TEXT);
+    assertEquals(Arrays.toString(expected),
+        Arrays.toString(NativeBreakIterator.getWordBoundaries(Locale.US, TEXT, false)));
+
+    int[] withStatus = NativeBreakIterator.getWordBoundaries(Locale.US, TEXT, true);
+    assertEquals(2 * expected.length, withStatus.length);
+    for (int i = 0; i < expected.length; ++i) {
+      assertEquals(expected[i], withStatus[2 * i]);
+    }
+    // "quick" is letters, "32.3" is a number, and the space after it is neither.
+    int quickEnd = TEXT.indexOf("quick") + 5;
+    int numberEnd = TEXT.indexOf("32.3") + 4;
+    for (int i = 0; i < withStatus.length; i += 2) {
+      if (withStatus[i] == quickEnd) {
+        assertTrue(withStatus[i + 1] >= 200 && withStatus[i + 1] < 300);
+      } else if (withStatus[i] == numberEnd) {
+        assertTrue(withStatus[i + 1] >= 100 && withStatus[i + 1] < 200);
+      } else if (withStatus[i] == numberEnd + 1) {
+        assertEquals(0, withStatus[i + 1]);
+      }
+    }
+  }
+
+  public void test_getLineBoundaries() throws Exception {
+    int[] expected = boundaries(BreakIterator.getLineInstance(Locale.US), TEXT);
+    assertEquals(Arrays.toString(expected),
+        Arrays.toString(NativeBreakIterator.getLineBoundaries(Locale.US, TEXT, false)));
+    // The break after the newline is mandatory.
+    int[] withStatus = NativeBreakIterator.getLineBoundaries(Locale.US, TEXT, true);
+    int hardBreak = TEXT.indexOf('\n') + 1;
+    for (int i = 0; i < withStatus.length; i += 2) {
+      if (withStatus[i] == hardBreak) {
+        assertEquals(100, withStatus[i + 1]);
+      }
+    }
+  }
+
+  public void test_getBoundaries_empty() throws Exception {
+    assertEquals("[0]", Arrays.toString(NativeBreakIterator.getWordBoundaries(Locale.US, "", false)));
+    try {
+      NativeBreakIterator.getWordBoundaries(Locale.US, null, false);
+      fail();
+    } catch (NullPointerException expected) {
+    }
+  }
+
+  public void test_getBoundaries_threads() throws Exception {
+    final String expected = Arrays.toString(NativeBreakIterator.getWordBoundaries(Locale.US, TEXT, true));
+    final List<Throwable> failures = new ArrayList<Throwable>();
+    Thread[] threads = new Thread[4];
+    for (int i = 0; i < threads.length; ++i) {
+      threads[i] = new Thread() {
+        @Override public void run() {
+          try {
+            for (int j = 0; j < 500; ++j) {
+              assertEquals(expected,
+                  Arrays.toString(NativeBreakIterator.getWordBoundaries(Locale.US, TEXT, true)));
+            }
+          } catch (Throwable t) {
+            synchronized (failures) {
+              failures.add(t);
+            }
+          }
+        }
+      };
+      threads[i].start();
+    }
+    for (Thread t : threads) {
+      t.join();
+    }
+    assertEquals("[]", failures.toString());
+  }
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.icu;
+
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
+import java.nio.charset.Charset;
+
+public class NativeConverterTest extends junit.framework.TestCase {
+  private static ByteBuffer direct(byte... bytes) {
+    ByteBuffer result = ByteBuffer.allocateDirect(bytes.length);
+    result.put(bytes);
+    return result;
+  }
+
+  public void test_decodeAddresses() throws Exception {
+    long converter = NativeConverter.openConverter("UTF-8");
+    try {
+      // A snowman split across three buffers, the first of which we start part way into.
+      ByteBuffer b0 = direct((byte) 'x', (byte) 'a', (byte) 0xe2);
+      ByteBuffer b1 = direct((byte) 0x98);
+      ByteBuffer b2 = direct((byte) 0x83, (byte) 'b');
+      long[] addresses = { NioUtils.unsafeAddress(b0), NioUtils.unsafeAddress(b1), NioUtils.unsafeAddress(b2) };
+      int[] byteCounts = { 3, 1, 2 };
+      char[] chars = new char[8];
+      int[] data = { 1, 0, 0 };
+      int error = NativeConverter.decodeAddresses(converter, addresses, byteCounts, chars, chars.length, data, true);
+      assertFalse(ICU.U_FAILURE(error));
+      assertEquals(5, data[0]);
+      assertEquals(3, data[1]);
+      assertEquals("a\u2603b", new String(chars, 0, data[1]));
+    } finally {
+      NativeConverter.closeConverter(converter);
+    }
+  }
+
+  public void test_encodeAddresses() throws Exception {
+    long converter = NativeConverter.openConverter("UTF-8");
+    try {
+      ByteBuffer b0 = ByteBuffer.allocateDirect(2);
+      ByteBuffer b1 = ByteBuffer.allocateDirect(8);
+      long[] addresses = { NioUtils.unsafeAddress(b0), NioUtils.unsafeAddress(b1) };
+      int[] byteCounts = { 2, 8 };
+      char[] chars = "a\u2603b".toCharArray();
+      int[] data = { 0, 0, 0 };
+      int error = NativeConverter.encodeAddresses(converter, chars, chars.length, addresses, byteCounts, data, true);
+      assertFalse(ICU.U_FAILURE(error));
+      assertEquals(3, data[0]);
+      assertEquals(5, data[1]);
+      byte[] bytes = new byte[5];
+      b0.get(bytes, 0, 2);
+      b1.get(bytes, 2, 3);
+      assertEquals("a\u2603b", new String(bytes, Charset.forName("UTF-8")));
+    } finally {
+      NativeConverter.closeConverter(converter);
+    }
+  }
+}
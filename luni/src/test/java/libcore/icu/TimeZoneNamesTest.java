@@ -16,6 +16,8 @@
 
 package libcore.icu;
 
+import java.io.File;
+import java.io.FileOutputStream;
 import java.util.Arrays;
 import java.util.Locale;
 import java.util.HashSet;
@@ -59,4 +61,35 @@ public class TimeZoneNamesTest extends junit.framework.TestCase {
       assertTrue(TimeZoneNames.forLocale(l) != null);
     }
   }
+
+  public void test_diskCache() throws Exception {
+    File cacheDir = File.createTempFile("tznames", null);
+    assertTrue(cacheDir.delete());
+    assertTrue(cacheDir.mkdir());
+    String oldCacheDir = System.getProperty(TimeZoneNames.CACHE_DIR_PROPERTY);
+    System.setProperty(TimeZoneNames.CACHE_DIR_PROPERTY, cacheDir.getPath());
+    try {
+      Locale locale = new Locale("fr", "FR");
+      String[][] computed = new TimeZoneNames.ZoneStringsCache().get(locale);
+      File[] files = cacheDir.listFiles();
+      assertEquals(1, files.length);
+      String[][] loaded = new TimeZoneNames.ZoneStringsCache().get(locale);
+      assertNotSame(computed, loaded);
+      assertTrue(Arrays.deepEquals(computed, loaded));
+      // A corrupt cache file is ignored (and replaced).
+      new FileOutputStream(files[0]).close();
+      assertTrue(Arrays.deepEquals(computed, new TimeZoneNames.ZoneStringsCache().get(locale)));
+      assertTrue(files[0].length() > 0);
+    } finally {
+      if (oldCacheDir == null) {
+        System.clearProperty(TimeZoneNames.CACHE_DIR_PROPERTY);
+      } else {
+        System.setProperty(TimeZoneNames.CACHE_DIR_PROPERTY, oldCacheDir);
+      }
+      for (File file : cacheDir.listFiles()) {
+        file.delete();
+      }
+      cacheDir.delete();
+    }
+  }
 }
@@ -97,4 +97,23 @@ public class TransliteratorTest extends junit.framework.TestCase {
     assertEquals("SHEN", t.transliterate("\u700b"));
     assertEquals("JIA", t.transliterate("\u8d3e"));
   }
+
+  public void test_cachedInstancesAreIndependent() throws Exception {
+    Transliterator first = new Transliterator("Any-Upper");
+    Transliterator second = new Transliterator("Any-Upper");
+    assertEquals("HELLO", first.transliterate("hello"));
+    assertEquals("WORLD", second.transliterate("world"));
+    assertSame(Transliterator.getThreadInstance("Any-Upper"), Transliterator.getThreadInstance("Any-Upper"));
+    assertNotSame(first, Transliterator.getThreadInstance("Any-Upper"));
+  }
+
+  public void test_transliterateArray() throws Exception {
+    String unchanged = "Privet";
+    String[] strings = { "\u041f\u0440\u0438\u0432\u0435\u0442", null, unchanged, "" };
+    Transliterator.getThreadInstance("Any-Latin").transliterate(strings);
+    assertEquals("Privet", strings[0]);
+    assertNull(strings[1]);
+    assertSame(unchanged, strings[2]);
+    assertEquals("", strings[3]);
+  }
 }
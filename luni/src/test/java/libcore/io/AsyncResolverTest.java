@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+import java.io.FileDescriptor;
+import java.net.InetAddress;
+import java.net.SocketException;
+import java.util.Arrays;
+import java.util.Comparator;
+import java.util.concurrent.CancellationException;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.TimeUnit;
+import junit.framework.TestCase;
+
+import static libcore.io.OsConstants.*;
+
+public class AsyncResolverTest extends TestCase {
+  private static StructAddrinfo hints(int family) {
+    StructAddrinfo hints = new StructAddrinfo();
+    hints.ai_family = family;
+    hints.ai_socktype = SOCK_STREAM;
+    return hints;
+  }
+
+  private static String sorted(InetAddress[] addresses) {
+    Arrays.sort(addresses, new Comparator<InetAddress>() {
+      public int compare(InetAddress lhs, InetAddress rhs) {
+        return lhs.getHostAddress().compareTo(rhs.getHostAddress());
+      }
+    });
+    return Arrays.toString(addresses);
+  }
+
+  public void test_lookup_matchesGetaddrinfo() throws Exception {
+    for (int family : new int[] { AF_INET, AF_INET6, AF_UNSPEC }) {
+      String expected;
+      try {
+        expected = sorted(Libcore.os.getaddrinfo("localhost", hints(family)));
+      } catch (GaiException e) {
+        expected = "GaiException " + e.error;
+      }
+      AsyncResolver.Lookup lookup = AsyncResolver.lookup("localhost", hints(family));
+      String actual;
+      try {
+        // The two families are merged in our own order, so compare the sets.
+        actual = sorted(lookup.get(10, TimeUnit.SECONDS));
+      } catch (ExecutionException e) {
+        actual = "GaiException " + ((GaiException) e.getCause()).error;
+      }
+      assertEquals("family " + family, expected, actual);
+      assertTrue(lookup.isDone());
+      assertFalse(lookup.isCancelled());
+    }
+  }
+
+  public void test_lookup_literal() throws Exception {
+    AsyncResolver.Lookup lookup = AsyncResolver.lookup("127.0.0.1", hints(AF_INET));
+    assertEquals("[/127.0.0.1]", Arrays.toString(lookup.await(null, -1)));
+    // Answers can be collected more than once, and callers get their own arrays.
+    InetAddress[] addresses = lookup.get();
+    addresses[0] = null;
+    assertEquals("[/127.0.0.1]", Arrays.toString(lookup.get()));
+  }
+
+  public void test_lookup_failure() throws Exception {
+    AsyncResolver.Lookup lookup = AsyncResolver.lookup("does.not.exist.invalid", hints(AF_UNSPEC));
+    try {
+      lookup.get();
+      fail();
+    } catch (ExecutionException expected) {
+      assertTrue(expected.getCause() instanceof GaiException);
+    }
+    try {
+      lookup.await(null, -1);
+      fail();
+    } catch (GaiException expected) {
+    }
+  }
+
+  public void test_cancel() throws Exception {
+    AsyncResolver.clearCache();
+    AsyncResolver.Lookup lookup = AsyncResolver.lookup("localhost", hints(AF_UNSPEC));
+    if (lookup.cancel(false)) {
+      assertTrue(lookup.isCancelled());
+      assertTrue(lookup.isDone());
+      try {
+        lookup.get();
+        fail();
+      } catch (CancellationException expected) {
+      }
+    } else {
+      // We lost the race with the resolver.
+      assertNotNull(lookup.get());
+    }
+    assertFalse(lookup.cancel(false));
+  }
+
+  public void test_await_abandonedWhenSocketClosed() throws Exception {
+    FileDescriptor fd = Libcore.os.socket(AF_INET, SOCK_STREAM, 0);
+    // We can't make a lookup stay in flight, so close the socket before waiting rather than
+    // during the wait; either way the wait should be abandoned.
+    AsyncResolver.Lookup lookup = AsyncResolver.lookup("localhost", hints(AF_UNSPEC));
+    IoBridge.closeSocket(fd);
+    try {
+      lookup.await(fd, -1);
+      // The lookup finished before we got a chance to wait, which is fine too.
+    } catch (SocketException expected) {
+      assertTrue(lookup.isCancelled());
+    }
+  }
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+import java.io.FileDescriptor;
+import junit.framework.TestCase;
+
+import static libcore.io.OsConstants.*;
+
+public class AsynchronousCloseMonitorTest extends TestCase {
+  public void testGetCounters() throws Exception {
+    final FileDescriptor reader = new FileDescriptor();
+    final FileDescriptor writer = new FileDescriptor();
+    Libcore.os.socketpair(AF_UNIX, SOCK_STREAM, 0, reader, writer);
+    try {
+      long[] before = AsynchronousCloseMonitor.getCounters();
+      assertEquals(3, before.length);
+
+      final byte[] buffer = new byte[1];
+      final Exception[] failure = new Exception[1];
+      Thread blocked = new Thread(new Runnable() {
+        public void run() {
+          try {
+            Libcore.os.recvfrom(reader, buffer, 0, buffer.length, 0, null);
+          } catch (Exception e) {
+            failure[0] = e;
+          }
+        }
+      });
+      blocked.start();
+
+      // Signal until the blocked thread has been woken at least once. The fd is still open, so
+      // each wake-up just retries the recvfrom.
+      long deadline = System.currentTimeMillis() + 5000;
+      long[] after;
+      do {
+        assertTrue(System.currentTimeMillis() < deadline);
+        Thread.sleep(10);
+        AsynchronousCloseMonitor.signalBlockedThreads(reader);
+        after = AsynchronousCloseMonitor.getCounters();
+      } while (after[AsynchronousCloseMonitor.COUNTER_SIGNALS] ==
+               before[AsynchronousCloseMonitor.COUNTER_SIGNALS]);
+
+      Libcore.os.write(writer, new byte[] { 42 }, 0, 1);
+      blocked.join();
+      assertNull(failure[0]);
+      assertEquals(42, buffer[0]);
+
+      after = AsynchronousCloseMonitor.getCounters();
+      assertTrue(after[AsynchronousCloseMonitor.COUNTER_MONITORS] >
+                 before[AsynchronousCloseMonitor.COUNTER_MONITORS]);
+    } finally {
+      Libcore.os.close(reader);
+      Libcore.os.close(writer);
+    }
+  }
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.io;
+
+import java.io.FileDescriptor;
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
+import junit.framework.TestCase;
+
+import static libcore.io.OsConstants.*;
+
+public class IoUringTest extends TestCase {
+  private static IoUring newRing() throws Exception {
+    try {
+      return new IoUring(8);
+    } catch (ErrnoException e) {
+      // Kernels before 5.1 don't have io_uring.
+      assertEquals(ENOSYS, e.errno);
+      return null;
+    }
+  }
+
+  public void test_writeThenRead() throws Exception {
+    IoUring ring = newRing();
+    if (ring == null) {
+      return;
+    }
+    FileDescriptor[] pipe = Libcore.os.pipe();
+    try {
+      ByteBuffer out = ByteBuffer.allocateDirect(5);
+      out.put("hello".getBytes("UTF-8"));
+      ByteBuffer in = ByteBuffer.allocateDirect(5);
+
+      ring.prepareWrite(pipe[1], NioUtils.unsafeAddress(out), 5, 0, 1);
+      ring.prepareRead(pipe[0], NioUtils.unsafeAddress(in), 5, 0, 2);
+      assertEquals(2, ring.submit(2));
+
+      long[] userData = new long[4];
+      int[] results = new int[4];
+      int count = 0;
+      while (count < 2) {
+        count += ring.harvest(userData, results);
+        if (count < 2) {
+          ring.submit(1);
+        }
+      }
+      assertEquals(5, results[0]);
+      assertEquals(5, results[1]);
+      byte[] bytes = new byte[5];
+      in.get(bytes);
+      assertEquals("hello", new String(bytes, "UTF-8"));
+    } finally {
+      ring.close();
+      Libcore.os.close(pipe[0]);
+      Libcore.os.close(pipe[1]);
+    }
+  }
+
+  public void test_cancel() throws Exception {
+    IoUring ring = newRing();
+    if (ring == null) {
+      return;
+    }
+    FileDescriptor[] pipe = Libcore.os.pipe();
+    try {
+      ByteBuffer in = ByteBuffer.allocateDirect(1);
+      ring.prepareRead(pipe[0], NioUtils.unsafeAddress(in), 1, 0, 42);
+      ring.submit(0);
+      assertTrue(ring.cancel(42));
+      assertFalse(ring.cancel(43));
+      ring.submit(1);
+
+      long[] userData = new long[1];
+      int[] results = new int[1];
+      while (ring.harvest(userData, results) == 0) {
+        ring.submit(1);
+      }
+      assertEquals(42, userData[0]);
+      assertEquals(-ECANCELED, results[0]);
+    } finally {
+      ring.close();
+      Libcore.os.close(pipe[0]);
+      Libcore.os.close(pipe[1]);
+    }
+  }
+}
@@ -19,13 +19,19 @@ package libcore.io;
 import java.io.File;
 import java.io.FileDescriptor;
 import java.io.FileInputStream;
+import java.net.Inet4Address;
+import java.net.Inet6Address;
 import java.net.InetAddress;
 import java.net.InetSocketAddress;
 import java.net.InetUnixAddress;
 import java.net.ServerSocket;
 import java.net.SocketAddress;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.NioUtils;
 import java.util.Locale;
 import junit.framework.TestCase;
+import libcore.util.MutableLong;
 
 import static libcore.io.OsConstants.*;
 
@@ -131,6 +137,262 @@ public class OsTest extends TestCase {
     checkNoName(Libcore.os.getsockname(fd));
   }
 
+  public void test_epoll() throws Exception {
+    FileDescriptor epFd = Libcore.os.epoll_create(EPOLL_CLOEXEC);
+    FileDescriptor[] pipe = Libcore.os.pipe();
+    try {
+      Libcore.os.epoll_ctl(epFd, EPOLL_CTL_ADD, pipe[0], EPOLLIN, 0x123456789abcdefL);
+      ByteBuffer events = ByteBuffer.allocateDirect(4 * SizeOf.EPOLL_EVENT).order(ByteOrder.nativeOrder());
+      assertEquals(0, Libcore.os.epoll_wait(epFd, events, 0));
+
+      Libcore.os.write(pipe[1], new byte[] { 1 }, 0, 1);
+      assertEquals(1, Libcore.os.epoll_wait(epFd, events, 1000));
+      assertEquals(EPOLLIN, events.getInt(0) & EPOLLIN);
+      assertEquals(0x123456789abcdefL, events.getLong(8));
+
+      Libcore.os.epoll_ctl(epFd, EPOLL_CTL_DEL, pipe[0], 0, 0);
+      assertEquals(0, Libcore.os.epoll_wait(epFd, events, 0));
+    } finally {
+      Libcore.os.close(pipe[0]);
+      Libcore.os.close(pipe[1]);
+      Libcore.os.close(epFd);
+    }
+  }
+
+  public void test_recvmmsg_sendmmsg() throws Exception {
+    FileDescriptor recvFd = Libcore.os.socket(AF_INET6, SOCK_DGRAM, 0);
+    FileDescriptor sendFd = Libcore.os.socket(AF_INET6, SOCK_DGRAM, 0);
+    try {
+      Libcore.os.bind(recvFd, Inet6Address.ANY, 0);
+      int port = ((InetSocketAddress) Libcore.os.getsockname(recvFd)).getPort();
+
+      byte[] out = "onetwothree".getBytes("UTF-8");
+      int[] offsets = new int[] { 0, 3, 6 };
+      int[] byteCounts = new int[] { 3, 3, 5 };
+      InetAddress[] addresses = new InetAddress[] { Inet4Address.LOOPBACK, Inet4Address.LOOPBACK, Inet4Address.LOOPBACK };
+      int[] ports = new int[] { port, port, port };
+      assertEquals(3, Libcore.os.sendmmsg(sendFd, out, offsets, byteCounts, 3, 0, addresses, ports));
+
+      // Slots of 4 bytes, so the third datagram is truncated.
+      byte[] in = new byte[3 * 4];
+      InetSocketAddress[] srcAddresses = new InetSocketAddress[3];
+      for (int i = 0; i < srcAddresses.length; ++i) {
+        srcAddresses[i] = new InetSocketAddress();
+      }
+      int[] results = new int[2 * 3];
+      assertEquals(3, Libcore.os.recvmmsg(recvFd, in, 0, 4, 3, 0, srcAddresses, results));
+      assertEquals(3, results[0]);
+      assertEquals(0, results[1] & MSG_TRUNC);
+      assertEquals("one", new String(in, 0, 3, "UTF-8"));
+      assertEquals("two", new String(in, 4, 3, "UTF-8"));
+      assertEquals(MSG_TRUNC, results[5] & MSG_TRUNC);
+      assertEquals("thre", new String(in, 8, 4, "UTF-8"));
+      assertTrue(srcAddresses[0].getAddress().isLoopbackAddress());
+    } finally {
+      Libcore.os.close(recvFd);
+      Libcore.os.close(sendFd);
+    }
+  }
+
+  public void test_SplicePipe_and_copy_file_range() throws Exception {
+    File src = File.createTempFile("OsTest", "src");
+    File dst = File.createTempFile("OsTest", "dst");
+    byte[] content = "hello, splice!".getBytes("UTF-8");
+    FileDescriptor srcFd = Libcore.os.open(src.getPath(), O_RDWR, 0);
+    FileDescriptor dstFd = Libcore.os.open(dst.getPath(), O_RDWR, 0);
+    SplicePipe pipe = new SplicePipe();
+    try {
+      Libcore.os.write(srcFd, content, 0, content.length);
+      Libcore.os.lseek(srcFd, 0, SEEK_SET);
+      assertEquals(content.length, pipe.transfer(srcFd, dstFd, 1024));
+      assertEquals(0, pipe.pending());
+      assertEquals(-1, pipe.transfer(srcFd, dstFd, 1024));
+
+      byte[] copy = new byte[content.length];
+      assertEquals(content.length, Libcore.os.pread(dstFd, copy, 0, copy.length, 0));
+      assertEquals("hello, splice!", new String(copy, "UTF-8"));
+
+      // copy_file_range with explicit offsets leaves the fds' own offsets alone.
+      MutableLong inOffset = new MutableLong(7);
+      MutableLong outOffset = new MutableLong(0);
+      try {
+        assertEquals(7, Libcore.os.copy_file_range(srcFd, inOffset, dstFd, outOffset, 7, 0));
+        assertEquals(14, inOffset.value);
+        assertEquals(7, outOffset.value);
+        assertEquals(7, Libcore.os.pread(dstFd, copy, 0, 7, 0));
+        assertEquals("splice!", new String(copy, 0, 7, "UTF-8"));
+      } catch (ErrnoException e) {
+        // Kernels before 4.5 don't have copy_file_range.
+        assertEquals(ENOSYS, e.errno);
+      }
+    } finally {
+      pipe.close();
+      Libcore.os.close(srcFd);
+      Libcore.os.close(dstFd);
+      src.delete();
+      dst.delete();
+    }
+  }
+
+  public void test_directByteBuffer_readWrite() throws Exception {
+    File f = File.createTempFile("OsTest", "direct");
+    FileDescriptor fd = Libcore.os.open(f.getPath(), O_RDWR, 0);
+    try {
+      ByteBuffer out = ByteBuffer.allocateDirect(16);
+      out.put("xxhello".getBytes("UTF-8"));
+      out.flip();
+      out.position(2);
+      assertEquals(5, Libcore.os.write(fd, out));
+      out.position(2);
+      assertEquals(5, Libcore.os.pwrite(fd, out, 5));
+
+      ByteBuffer in = ByteBuffer.allocateDirect(16);
+      in.position(3);
+      in.limit(8);
+      assertEquals(5, Libcore.os.pread(fd, in, 5));
+      byte[] bytes = new byte[5];
+      in.position(3);
+      in.get(bytes);
+      assertEquals("hello", new String(bytes, "UTF-8"));
+
+      Libcore.os.lseek(fd, 0, SEEK_SET);
+      in.clear();
+      assertEquals(10, Libcore.os.read(fd, in));
+    } finally {
+      Libcore.os.close(fd);
+      f.delete();
+    }
+  }
+
+  public void test_preadv_pwritev() throws Exception {
+    File f = File.createTempFile("OsTest", "vector");
+    FileDescriptor fd = Libcore.os.open(f.getPath(), O_RDWR, 0);
+    try {
+      byte[] header = "head".getBytes("UTF-8");
+      byte[] body = "body!".getBytes("UTF-8");
+      assertEquals(9, Libcore.os.pwritev(fd, new Object[] { header, body }, new int[] { 0, 0 }, new int[] { 4, 5 }, 3));
+
+      ByteBuffer a = ByteBuffer.allocateDirect(4);
+      ByteBuffer b = ByteBuffer.allocateDirect(5);
+      long[] addresses = new long[] { NioUtils.unsafeAddress(a), NioUtils.unsafeAddress(b) };
+      assertEquals(9, Libcore.os.preadv(fd, addresses, new int[] { 4, 5 }, 3));
+      byte[] bytes = new byte[5];
+      b.get(bytes);
+      assertEquals("body!", new String(bytes, "UTF-8"));
+
+      // The positional variants don't move the file offset.
+      assertEquals(0, Libcore.os.lseek(fd, 0, SEEK_CUR));
+      assertEquals(9, Libcore.os.writev(fd, addresses, new int[] { 4, 5 }));
+      assertEquals(12, Libcore.os.fstat(fd).st_size);
+    } finally {
+      Libcore.os.close(fd);
+      f.delete();
+    }
+  }
+
+  public void test_stat_batch() throws Exception {
+    File dir = new File(System.getProperty("java.io.tmpdir"));
+    File f = File.createTempFile("OsTest", "stat");
+    try {
+      String[] paths = { f.getPath(), dir.getPath(), "/does/not/exist" };
+      int fields = StructStat.FIELD_INO | StructStat.FIELD_MODE | StructStat.FIELD_SIZE | StructStat.FIELD_MTIME;
+      long[] values = new long[4 * paths.length];
+      int[] errnos = new int[paths.length];
+      assertEquals(2, Libcore.os.stat(null, paths, true, fields, values, errnos));
+      for (int i = 0; i < 2; ++i) {
+        StructStat sb = Libcore.os.stat(paths[i]);
+        assertEquals(0, errnos[i]);
+        assertEquals(sb.st_ino, values[4 * i]);
+        assertEquals(sb.st_mode, values[4 * i + 1]);
+        assertEquals(sb.st_size, values[4 * i + 2]);
+        assertEquals(sb.st_mtime, values[4 * i + 3]);
+      }
+      assertEquals(ENOENT, errnos[2]);
+      assertEquals(0, values[8]);
+
+      // Names can be relative to a directory fd.
+      FileDescriptor dirFd = Libcore.os.open(dir.getPath(), O_RDONLY, 0);
+      try {
+        values = new long[1];
+        assertEquals(1, Libcore.os.stat(dirFd, new String[] { f.getName() }, false, StructStat.FIELD_INO, values, errnos));
+        assertEquals(Libcore.os.stat(f.getPath()).st_ino, values[0]);
+      } finally {
+        Libcore.os.close(dirFd);
+      }
+
+      try {
+        Libcore.os.stat(null, paths, true, fields, new long[4], errnos);
+        fail();
+      } catch (ArrayIndexOutOfBoundsException expected) {
+      }
+    } finally {
+      f.delete();
+    }
+  }
+
+  public void test_fadvise_readahead_madvise_prefault() throws Exception {
+    File f = File.createTempFile("OsTest", "prefault");
+    try {
+      // Big enough for MemoryMappedFile.prefault to split it between threads.
+      byte[] data = new byte[3 * 1024 * 1024 + 123];
+      for (int i = 0; i < data.length; ++i) {
+        data[i] = (byte) (i * 31);
+      }
+      FileDescriptor fd = Libcore.os.open(f.getPath(), O_RDWR, 0);
+      try {
+        assertEquals(data.length, Libcore.os.write(fd, data, 0, data.length));
+        Libcore.os.posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        Libcore.os.readahead(fd, 0, data.length);
+        try {
+          Libcore.os.posix_fadvise(fd, 0, 0, -1);
+          fail();
+        } catch (ErrnoException expected) {
+          assertEquals(EINVAL, expected.errno);
+        }
+      } finally {
+        Libcore.os.close(fd);
+      }
+
+      MemoryMappedFile mapped = MemoryMappedFile.mmapRO(f.getPath());
+      try {
+        mapped.advise(MADV_WILLNEED);
+        mapped.advise(MADV_RANDOM);
+        mapped.prefault(4);
+        BufferIterator it = mapped.littleEndianIterator();
+        it.seek(data.length - 1);
+        assertEquals(data[data.length - 1], it.readByte());
+      } finally {
+        mapped.close();
+      }
+      try {
+        mapped.prefault(1);
+        fail();
+      } catch (IllegalStateException expected) {
+      }
+
+      // MAP_POPULATE and Memory.prefault leave every page resident.
+      long pageSize = Libcore.os.sysconf(_SC_PAGESIZE);
+      byte[] vector = new byte[(int) ((data.length + pageSize - 1) / pageSize)];
+      fd = Libcore.os.open(f.getPath(), O_RDONLY, 0);
+      try {
+        long address = Libcore.os.mmap(0L, data.length, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+        try {
+          Memory.prefault(address, data.length);
+          Libcore.os.mincore(address, data.length, vector);
+          for (byte page : vector) {
+            assertEquals(1, page & 1);
+          }
+        } finally {
+          Libcore.os.munmap(address, data.length);
+        }
+      } finally {
+        Libcore.os.close(fd);
+      }
+    } finally {
+      f.delete();
+    }
+  }
+
   public void test_strsignal() throws Exception {
     assertEquals("Killed", Libcore.os.strsignal(9));
     assertEquals("Unknown signal -1", Libcore.os.strsignal(-1));
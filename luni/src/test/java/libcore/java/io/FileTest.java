@@ -19,9 +19,13 @@ package libcore.java.io;
 import java.io.BufferedReader;
 import java.io.File;
 import java.io.FileFilter;
+import java.io.FileOutputStream;
 import java.io.FilenameFilter;
 import java.io.InputStreamReader;
 import java.io.IOException;
+import java.util.Arrays;
+import java.util.HashSet;
+import java.util.Set;
 import java.util.UUID;
 import libcore.io.Libcore;
 
@@ -175,6 +179,40 @@ public class FileTest extends junit.framework.TestCase {
         assertEquals(target.getCanonicalPath(), linkName.getCanonicalPath());
     }
 
+    public void test_getCanonicalPath_seesChanges() throws Exception {
+        File base = createTemporaryDirectory().getCanonicalFile();
+        File a = new File(base, "a/deep/er");
+        File b = new File(base, "b/deep/er");
+        assertTrue(a.mkdirs());
+        assertTrue(b.mkdirs());
+        File link = new File(base, "link");
+        ln_s("a", link.toString());
+        File viaLink = new File(link, "deep/er/file");
+        for (int i = 0; i < 2; ++i) {
+            assertEquals(new File(a, "file").getPath(), viaLink.getCanonicalPath());
+        }
+
+        // Retarget the link.
+        assertTrue(link.delete());
+        ln_s("b", link.toString());
+        assertEquals(new File(b, "file").getPath(), viaLink.getCanonicalPath());
+
+        // Move the directory the link points to, and leave a link in its place.
+        File c = new File(base, "c");
+        assertTrue(new File(base, "b").renameTo(c));
+        ln_s("c", new File(base, "b").toString());
+        assertEquals(new File(c, "deep/er/file").getPath(), viaLink.getCanonicalPath());
+
+        File.clearRealpathCache();
+        assertEquals(new File(c, "deep/er/file").getPath(), viaLink.getCanonicalPath());
+    }
+
+    public void test_getCanonicalPath_parentOfTopLevel() throws Exception {
+        assertEquals("/", new File("/tmp/..").getCanonicalPath());
+        assertEquals("/", new File("/does-not-exist/..").getCanonicalPath());
+        assertEquals("/etc", new File("/does-not-exist/../etc").getCanonicalPath());
+    }
+
     private static void ln_s(File target, File linkName) throws Exception {
         ln_s(target.toString(), linkName.toString());
     }
@@ -266,4 +304,46 @@ public class FileTest extends junit.framework.TestCase {
         assertFalse(badParent.exists());
         assertFalse(badParent.mkdirs());
     }
+
+    public void test_listEntries() throws Exception {
+        File base = createTemporaryDirectory();
+        File dir = new File(base, "dir");
+        assertTrue(dir.mkdir());
+        File file = new File(base, "file");
+        FileOutputStream out = new FileOutputStream(file);
+        out.write(new byte[123]);
+        out.close();
+        ln_s(dir, new File(base, "link"));
+        File ghost = new File(base, "ghost");
+        ln_s(ghost, new File(base, "dangling"));
+        // Enough entries to need more than one read.
+        for (int i = 0; i < 2000; ++i) {
+            assertTrue(new File(base, "many-" + longString(64) + i).createNewFile());
+        }
+
+        for (boolean withStats : new boolean[] { false, true }) {
+            File.Listing listing = base.listEntries(withStats);
+            assertEquals(withStats, listing.hasStats());
+            String[] names = base.list();
+            assertEquals(names.length, listing.size());
+            Set<String> expected = new HashSet<String>(Arrays.asList(names));
+            for (int i = 0; i < listing.size(); ++i) {
+                String name = listing.getName(i);
+                assertTrue(name, expected.remove(name));
+                File f = listing.getFile(i);
+                assertEquals(name, f.isDirectory(), listing.isDirectory(i));
+                assertEquals(name, f.isFile(), listing.isFile(i));
+                assertEquals(name, f.length(), listing.length(i));
+                assertEquals(name, f.lastModified(), listing.lastModified(i));
+                if (name.equals("link") || name.equals("dangling")) {
+                    byte type = listing.getType(i);
+                    assertTrue(type == File.Listing.TYPE_SYMLINK || type == File.Listing.TYPE_UNKNOWN);
+                }
+            }
+            assertEquals(0, expected.size());
+        }
+
+        assertNull(file.listEntries(false));
+        assertNull(new File(base, "missing").listEntries(true));
+    }
 }
@@ -16,7 +16,9 @@
 
 package libcore.java.lang;
 
+import java.lang.reflect.Field;
 import java.lang.reflect.Method;
+import java.nio.ByteBuffer;
 
 public class CharacterTest extends junit.framework.TestCase {
   public void test_valueOfC() {
@@ -263,4 +265,65 @@ public class CharacterTest extends junit.framework.TestCase {
       assertEquals(m.invoke(null, i), Character.isWhitespace(i));
     }
   }
+
+  public void test_getType_against_icu4c() throws Exception {
+    Method m = Character.class.getDeclaredMethod("getTypeImpl", int.class);
+    m.setAccessible(true);
+    for (int i = 0; i <= 0xffff; ++i) {
+      int type = (Integer) m.invoke(null, i);
+      assertEquals(type <= Character.FORMAT ? type : type + 1, Character.getType(i));
+    }
+  }
+
+  public void test_getDirectionality_against_icu4c() throws Exception {
+    Method m = Character.class.getDeclaredMethod("getDirectionalityImpl", int.class);
+    m.setAccessible(true);
+    Field f = Character.class.getDeclaredField("DIRECTIONALITY");
+    f.setAccessible(true);
+    byte[] directionality = (byte[]) f.get(null);
+    for (int i = 0; i <= 0xffff; ++i) {
+      byte expected = Character.DIRECTIONALITY_UNDEFINED;
+      if (Character.getType(i) != Character.UNASSIGNED) {
+        expected = directionality[(Byte) m.invoke(null, i)];
+      }
+      assertEquals(expected, Character.getDirectionality(i));
+    }
+  }
+
+  private static void assertBooleanAgainstIcu4c(String name) throws Exception {
+    Method impl = Character.class.getDeclaredMethod(name + "Impl", int.class);
+    impl.setAccessible(true);
+    Method method = Character.class.getMethod(name, int.class);
+    for (int i = 0; i <= 0xffff; ++i) {
+      assertEquals(name + " " + i, impl.invoke(null, i), method.invoke(null, i));
+    }
+    // Supplementary code points still go to icu4c.
+    assertEquals(impl.invoke(null, 0x2f999), method.invoke(null, 0x2f999));
+  }
+
+  public void test_bmpTable_against_icu4c() throws Exception {
+    assertBooleanAgainstIcu4c("isAlphabetic");
+    assertBooleanAgainstIcu4c("isDefined");
+    assertBooleanAgainstIcu4c("isIdeographic");
+    assertBooleanAgainstIcu4c("isMirrored");
+    assertBooleanAgainstIcu4c("isTitleCase");
+    assertBooleanAgainstIcu4c("isUnicodeIdentifierPart");
+    assertBooleanAgainstIcu4c("isUnicodeIdentifierStart");
+  }
+
+  public void test_getBmpPropertiesTable() throws Exception {
+    ByteBuffer table = Character.getBmpPropertiesTable();
+    assertTrue(table.isDirect());
+    assertTrue(table.isReadOnly());
+    assertEquals(1, table.getInt(0));
+    int blockCount = table.getInt(8);
+    int wordCount = table.getInt(12);
+    assertEquals(1024, blockCount);
+    assertEquals(16 + 2 * (blockCount + wordCount), table.capacity());
+    // Look up 'A' by hand: an upper case, left-to-right letter.
+    int offset = table.getChar(16 + 2 * ('A' >> 6));
+    int properties = table.getChar(16 + 2 * blockCount + 2 * (offset + ('A' & 0x3f)));
+    assertEquals(Character.UPPERCASE_LETTER, properties & 0x1f);
+    assertEquals(Character.DIRECTIONALITY_LEFT_TO_RIGHT, (properties >> 5) & 0x1f);
+  }
 }
@@ -127,4 +127,137 @@ public class DoubleTest extends TestCase {
         assertEquals(2.2250738585072014E-308, Double.parseDouble("2.22507385850720129978001e-308"));
         assertEquals(-2.2250738585072014E-308, Double.parseDouble("-2.2250738585072012e-308"));
     }
+
+    public void testParseLongMantissa() {
+        StringBuilder ones = new StringBuilder("1");
+        StringBuilder threes = new StringBuilder("0.");
+        for (int i = 0; i < 400; ++i) {
+            ones.append('0');
+            threes.append('3');
+        }
+        ones.append('1');
+        assertEquals(1e100, Double.parseDouble(ones + "e-300"));
+        assertEquals(3.333333333333333e99, Double.parseDouble(threes + "e100"));
+        assertEquals(3.3333333333333333e-251, Double.parseDouble(threes + "e-250"));
+    }
+
+    private static double parseBytes(String s) throws Exception {
+        byte[] bytes = ("xx" + s + "yy").getBytes("ISO-8859-1");
+        return Double.parseDouble(bytes, 2, bytes.length - 4);
+    }
+
+    public void testParseDoubleFromBytes() throws Exception {
+        String[] inputs = {
+            "0", "-0", "0.0", "1", "-1.5", "+2.5e3", " 3.25 ", "1d", "1e-5f", ".5", "5.",
+            "0.1", "123456789012345678", "1234567890123456789012", "9007199254740993",
+            "2.2250738585072012e-308", "4.9e-324", "1.0e-400", "1.7976931348623159e308",
+            "0e2000", "1e99999999999", "NaN", "-Infinity", "0x1p3",
+        };
+        for (String input : inputs) {
+            assertEquals(input, Double.parseDouble(input), parseBytes(input));
+        }
+        String[] invalid = { "", " ", "-", ".", "e5", "1e", "1.2.3", "1x", "--1", "\u00e91" };
+        for (String input : invalid) {
+            try {
+                parseBytes(input);
+                fail(input);
+            } catch (NumberFormatException expected) {
+            }
+        }
+        try {
+            Double.parseDouble(new byte[4], 2, 3);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+    }
+
+    public void testToStringDigits() throws Exception {
+        // Values on either side of the old 64-bit/cbigint generator boundary, powers of two,
+        // and the cases the cbigint generator's comments called out.
+        assertEquals("1.0E23", Double.toString(1e23));
+        assertEquals("2.0769187434139308E34", Double.toString(2.0769187434139308E34));
+        assertEquals("1.2341234124312331E107", Double.toString(1.2341234124312331E107));
+        assertEquals("2.2250738585072014E-308", Double.toString(Double.MIN_NORMAL));
+        assertEquals("1.7976931348623157E308", Double.toString(Double.MAX_VALUE));
+        assertEquals("1.5E-323", Double.toString(3 * Double.MIN_VALUE));
+        assertEquals("4.9E-324", Double.toString(Double.MIN_VALUE));
+        assertEquals("0.0078125", Double.toString(0.0078125));
+        assertEquals("0.007814407348632813", Double.toString(0.0078125 * (1 + 1.0 / 4096)));
+        assertEquals("9.007199254740992E15", Double.toString(9007199254740992.0));
+        assertEquals("9999999.999999998", Double.toString(9999999.999999998));
+        assertEquals("9.999999999999998E-4", Double.toString(0.0009999999999999998));
+        assertEquals("0.6666666666666666", Double.toString(2.0 / 3));
+        assertEquals("-1.1", Double.toString(-1.1));
+        assertEquals("-0.0", Double.toString(-0.0));
+    }
+
+    public void testToChars() throws Exception {
+        double[] values = { 0.0, -1.5, 0.1, 1e7, -2.2250738585072014E-308, Double.NaN,
+                Double.NEGATIVE_INFINITY, 123456.789 };
+        char[] chars = new char[30];
+        byte[] bytes = new byte[30];
+        for (double value : values) {
+            String expected = Double.toString(value);
+            assertEquals(expected.length(), Double.toChars(value, chars, 3));
+            assertEquals(expected, new String(chars, 3, expected.length()));
+            assertEquals(expected.length(), Double.toBytes(value, bytes, 6));
+            assertEquals(expected, new String(bytes, 6, expected.length(), "ISO-8859-1"));
+        }
+        StringBuilder sb = new StringBuilder("x=");
+        sb.append(-1.5).append(1e-5);
+        assertEquals("x=-1.51.0E-5", sb.toString());
+        try {
+            Double.toChars(0.1, new char[4], 2);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+    }
+
+    public void testParseDoubles() throws Exception {
+        String input = "1.5, -2 ,3e2,NaN,0x1p3,1e400,0.1";
+        double[] expected = { 1.5, -2, 300, Double.NaN, 8, Double.POSITIVE_INFINITY, 0.1 };
+        double[] dst = new double[8];
+        byte[] bytes = input.getBytes("ISO-8859-1");
+        assertEquals(7, Double.parseDoubles(bytes, 0, bytes.length, ',', dst, 1));
+        for (int i = 0; i < expected.length; ++i) {
+            assertEquals(expected[i], dst[i + 1]);
+        }
+        char[] chars = input.toCharArray();
+        assertEquals(7, Double.parseDoubles(chars, 0, chars.length, ',', dst, 0));
+        for (int i = 0; i < expected.length; ++i) {
+            assertEquals(expected[i], dst[i]);
+        }
+        assertEquals(0, Double.parseDoubles(chars, 0, 0, ',', dst, 0));
+        try {
+            Double.parseDoubles(chars, 0, chars.length, ',', dst, 2);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+        try {
+            Double.parseDoubles("1,,2".toCharArray(), 0, 4, ',', dst, 0);
+            fail();
+        } catch (NumberFormatException expected) {
+        }
+    }
+
+    public void testToBytesBatch() throws Exception {
+        double[] values = { 1.5, -0.0, 1e-5, Double.NaN, 123456.789 };
+        byte[] dst = new byte[64];
+        int length = Double.toBytes(values, 1, 4, ',', dst, 2);
+        assertEquals("-0.0,1.0E-5,NaN,123456.789", new String(dst, 2, length, "ISO-8859-1"));
+        assertEquals(0, Double.toBytes(values, 0, 0, ',', dst, 0));
+
+        // Round trip.
+        double[] parsed = new double[5];
+        length = Double.toBytes(values, 0, 5, '\n', dst, 0);
+        assertEquals(5, Double.parseDoubles(dst, 0, length, '\n', parsed, 0));
+        for (int i = 0; i < values.length; ++i) {
+            assertEquals(values[i], parsed[i]);
+        }
+        try {
+            Double.toBytes(values, 0, 5, ',', new byte[10], 0);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+    }
 }
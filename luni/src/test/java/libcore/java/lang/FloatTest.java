@@ -121,4 +121,49 @@ public class FloatTest extends junit.framework.TestCase {
       }
       assertEquals(f1, 0f);
     }
+
+    public void testParseLongMantissa() {
+        StringBuilder threes = new StringBuilder("0.");
+        for (int i = 0; i < 400; ++i) {
+            threes.append('3');
+        }
+        assertEquals(3.3333333e-31f, Float.parseFloat(threes + "e-30"));
+        assertEquals(3.3333334e30f, Float.parseFloat(threes + "e31"));
+    }
+
+    public void testParseFloatFromBytes() throws Exception {
+        String[] inputs = {
+            "0", "-0.0", "1.5", "-2.5e3f", " 16777217 ", "3.4028235e38", "3.4028236e38", "1.4e-45",
+            "7e-46", "0.1", "1.00000005960464477539062499", "NaN", "0x1p3",
+        };
+        for (String input : inputs) {
+            byte[] bytes = input.getBytes("ISO-8859-1");
+            assertEquals(input, Float.parseFloat(input), Float.parseFloat(bytes, 0, bytes.length));
+        }
+        try {
+            Float.parseFloat(new byte[] { '1', 'x' }, 0, 2);
+            fail();
+        } catch (NumberFormatException expected) {
+        }
+    }
+
+    public void testToStringDigits() throws Exception {
+        assertEquals("1.0E10", Float.toString(1e10f));
+        assertEquals("3.4028235E38", Float.toString(Float.MAX_VALUE));
+        assertEquals("1.1754944E-38", Float.toString(Float.MIN_NORMAL));
+        assertEquals("1.4E-45", Float.toString(Float.MIN_VALUE));
+        assertEquals("3.0E-44", Float.toString(3.0e-44f));
+        assertEquals("8.6736174E-19", Float.toString(0x1p-60f));
+        assertEquals("1.7179869E10", Float.toString(0x1p34f));
+        assertEquals("1.6777216E7", Float.toString(0x1p24f));
+        assertEquals("0.33333334", Float.toString(1f / 3));
+        assertEquals("0.001", Float.toString(1e-3f));
+
+        char[] chars = new char[16];
+        assertEquals(11, Float.toChars(-0.33333334f, chars, 1));
+        assertEquals("-0.33333334", new String(chars, 1, 11));
+        byte[] bytes = new byte[16];
+        assertEquals(7, Float.toBytes(1.4e-45f, bytes, 0));
+        assertEquals("1.4E-45", new String(bytes, 0, 7, "ISO-8859-1"));
+    }
 }
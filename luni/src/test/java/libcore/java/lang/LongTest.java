@@ -39,4 +39,37 @@ public class LongTest extends junit.framework.TestCase {
         assertEquals(1, Long.signum(Long.MAX_VALUE));
         assertEquals(-1, Long.signum(Long.MIN_VALUE));
     }
+
+    public void testParseLongs() throws Exception {
+        String input = "9223372036854775807,-9223372036854775808, 12 ,0007,\u0663";
+        byte[] bytes = input.getBytes("UTF-8");
+        long[] dst = new long[6];
+        assertEquals(4, Long.parseLongs(bytes, 0, bytes.length - 3, ',', dst, 1));
+        assertEquals(Long.MAX_VALUE, dst[1]);
+        assertEquals(Long.MIN_VALUE, dst[2]);
+        assertEquals(12, dst[3]);
+        assertEquals(7, dst[4]);
+        assertEquals(0, Long.parseLongs(bytes, 0, 0, ',', dst, 0));
+
+        // Fields the native code doesn't handle still parse as Long.parseLong would.
+        char[] chars = "1;\u0663;00000000000000000000042".toCharArray();
+        assertEquals(3, Long.parseLongs(chars, 0, chars.length, ';', dst, 0));
+        assertEquals(1, dst[0]);
+        assertEquals(3, dst[1]);
+        assertEquals(42, dst[2]);
+
+        String[] invalid = { "1,", "1,+2", "9223372036854775808", "1,-", "1 2" };
+        for (String input : invalid) {
+            try {
+                Long.parseLongs(input.toCharArray(), 0, input.length(), ',', dst, 0);
+                fail(input);
+            } catch (NumberFormatException expected) {
+            }
+        }
+        try {
+            Long.parseLongs("1,2,3".toCharArray(), 0, 5, ',', new long[2], 0);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+    }
 }
@@ -16,9 +16,12 @@
 
 package libcore.java.lang;
 
+import java.io.BufferedReader;
 import java.io.File;
+import java.io.FileInputStream;
 import java.io.IOException;
 import java.io.InputStream;
+import java.io.InputStreamReader;
 import java.io.OutputStream;
 import java.util.HashMap;
 import java.util.Map;
@@ -110,4 +113,49 @@ public class ProcessBuilderTest extends junit.framework.TestCase {
         }
         assertEquals(before, environment);
     }
+
+    public void testDirectory() throws Exception {
+        File dir = new File(System.getProperty("java.io.tmpdir")).getCanonicalFile();
+        ProcessBuilder pb = new ProcessBuilder(shell(), "-c", "pwd");
+        pb.directory(dir);
+        execAndCheckOutput(pb, dir.getPath() + "\n", "");
+    }
+
+    public void testMissingCommandOrDirectoryThrows() throws Exception {
+        try {
+            new ProcessBuilder("does-not-exist-" + System.nanoTime()).start();
+            fail();
+        } catch (IOException expected) {
+        }
+        ProcessBuilder pb = new ProcessBuilder(shell(), "-c", "true");
+        pb.directory(new File("/does/not/exist"));
+        try {
+            pb.start();
+            fail();
+        } catch (IOException expected) {
+        }
+    }
+
+    public void testCommandIsFoundOnChildPath() throws Exception {
+        ProcessBuilder pb = new ProcessBuilder("sh", "-c", "echo found");
+        pb.environment().put("PATH", "/does/not/exist:" + new File(shell()).getParent());
+        execAndCheckOutput(pb, "found\n", "");
+    }
+
+    public void testChildDoesNotInheritFds() throws Exception {
+        // The child should see only its three standard streams, plus whatever fd the listing
+        // itself needs, however many files we have open.
+        InputStream held = new FileInputStream("/dev/null");
+        try {
+            ProcessBuilder pb = new ProcessBuilder(shell(), "-c", "ls /proc/self/fd | wc -l");
+            Process process = pb.start();
+            BufferedReader reader = new BufferedReader(
+                    new InputStreamReader(process.getInputStream()));
+            int count = Integer.parseInt(reader.readLine().trim());
+            process.waitFor();
+            assertTrue("child had " + count + " fds", count <= 5);
+        } finally {
+            held.close();
+        }
+    }
 }
@@ -172,6 +172,18 @@ public class StringTest extends TestCase {
         assertEquals("a\ufffdb", new String(new byte[] { 97, -2, 98 }, Charset.forName("US-ASCII")));
     }
 
+    public void test_singleByteCharsets_longStrings() throws Exception {
+        // Long enough to exercise the chunked fast paths, with a bad character in the second chunk.
+        String good = "0123456789abcdef0123456789abcdef0123";
+        String bad = "0123456789abcdef01234\u00e9\u0666789abcdef0123";
+        assertEquals(good, new String(good.getBytes("US-ASCII"), "US-ASCII"));
+        assertEquals(good, new String(good.getBytes("ISO-8859-1"), "ISO-8859-1"));
+        assertEquals("0123456789abcdef01234??789abcdef0123", new String(bad.getBytes("US-ASCII"), "US-ASCII"));
+        assertEquals("0123456789abcdef01234\u00e9?789abcdef0123", new String(bad.getBytes("ISO-8859-1"), "ISO-8859-1"));
+        byte[] latin1 = bad.getBytes("ISO-8859-1");
+        assertEquals("0123456789abcdef01234\ufffd?789abcdef0123", new String(latin1, "US-ASCII"));
+    }
+
     /**
      * Tests a widely assumed performance characteristic of String.substring():
      * that it reuses the original's backing array. Although behaviour should be
@@ -23,6 +23,7 @@ import java.io.ByteArrayOutputStream;
 import java.io.PrintStream;
 import java.io.PrintWriter;
 import java.io.StringWriter;
+import java.lang.reflect.Method;
 import java.util.Formatter;
 
 public class SystemTest extends TestCase {
@@ -118,4 +119,33 @@ public class SystemTest extends TestCase {
             assertEquals("dst == null", e.getMessage());
         }
     }
+
+    private static void setLogWriterPaused(boolean paused) throws Exception {
+        Method method = System.class.getDeclaredMethod("setLogWriterPaused", boolean.class);
+        method.setAccessible(true);
+        method.invoke(null, paused);
+    }
+
+    public void testLogAndFlush() throws Exception {
+        // The queue holds 128 messages. With the writer paused, nothing empties it.
+        setLogWriterPaused(true);
+        long dropped = System.getDroppedLogCount();
+        try {
+            for (int i = 0; i < 128 + 10; ++i) {
+                System.logI("SystemTest.testLogAndFlush " + i);
+            }
+            assertEquals(dropped + 10, System.getDroppedLogCount());
+        } finally {
+            setLogWriterPaused(false);
+        }
+        // flushLog returns only once the writer has emptied the queue, so it has room again.
+        System.flushLog();
+        dropped = System.getDroppedLogCount();
+        for (int i = 0; i < 128; ++i) {
+            System.logI("SystemTest.testLogAndFlush again " + i);
+        }
+        System.logW("SystemTest.testLogAndFlush", new Exception());
+        System.flushLog();
+        assertEquals(dropped, System.getDroppedLogCount());
+    }
 }
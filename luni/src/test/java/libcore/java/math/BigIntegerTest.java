@@ -17,6 +17,7 @@
 package libcore.java.math;
 
 import java.math.BigInteger;
+import java.util.Arrays;
 import java.util.Random;
 
 public class BigIntegerTest extends junit.framework.TestCase {
@@ -156,4 +157,152 @@ public class BigIntegerTest extends junit.framework.TestCase {
         assertTrue(b.isProbablePrime(100));
       }
     }
+
+    public void test_modPow_sameModulus() throws Exception {
+        // modPow caches the Montgomery setup for recently used odd moduli; make sure reusing
+        // and evicting it never changes the answer.
+        Random rand = new Random(0);
+        BigInteger[] moduli = new BigInteger[12];
+        for (int i = 0; i < moduli.length; ++i) {
+            moduli[i] = new BigInteger(64 + 32 * i, rand).setBit(0);
+        }
+        moduli[5] = moduli[5].clearBit(0); // Even moduli don't use Montgomery multiplication.
+        for (int rep = 0; rep < 5; ++rep) {
+            for (BigInteger m : moduli) {
+                // A BigInteger with the same value, but not the same native number.
+                BigInteger sameM = new BigInteger(m.toByteArray());
+                BigInteger[] bases = { BigInteger.valueOf(2), BigInteger.valueOf(-3),
+                        new BigInteger(m.bitLength() + 8, rand), BigInteger.ZERO };
+                for (BigInteger base : bases) {
+                    BigInteger exponent = new BigInteger(40, rand);
+                    BigInteger expected = slowModPow(base, exponent, m);
+                    assertEquals(expected, base.modPow(exponent, m));
+                    assertEquals(expected, base.modPow(exponent, sameM));
+                }
+            }
+        }
+    }
+
+    public void test_multiplyAddMod() throws Exception {
+        Random rand = new Random(0);
+        for (int i = 0; i < 100; ++i) {
+            BigInteger a = new BigInteger(200, rand);
+            BigInteger b = new BigInteger(150, rand);
+            BigInteger c = new BigInteger(100, rand);
+            BigInteger m = new BigInteger(120, rand).add(BigInteger.ONE);
+            if ((i & 1) != 0) {
+                a = a.negate();
+            }
+            if ((i & 2) != 0) {
+                c = c.negate();
+            }
+            assertEquals(a.multiply(b).add(c).mod(m), a.multiplyAddMod(b, c, m));
+        }
+        try {
+            BigInteger.ONE.multiplyAddMod(BigInteger.ONE, BigInteger.ONE, BigInteger.ZERO);
+            fail();
+        } catch (ArithmeticException expected) {
+        }
+    }
+
+    public void test_getMagnitude() throws Exception {
+        BigInteger b = new BigInteger("-123456789abcdef01", 16);
+        byte[] expected = b.negate().toByteArray();
+        byte[] dst = new byte[12];
+        assertEquals(9, b.getMagnitude(dst, 3));
+        assertTrue(Arrays.equals(expected, Arrays.copyOfRange(dst, 3, 12)));
+        // Too little room: the length comes back, and nothing is written.
+        byte[] small = new byte[9];
+        assertEquals(9, b.getMagnitude(small, 1));
+        assertTrue(Arrays.equals(new byte[9], small));
+        assertEquals(0, BigInteger.ZERO.getMagnitude(small, 9));
+        try {
+            b.getMagnitude(small, 10);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected2) {
+        }
+    }
+
+    public void test_getMagnitude_ints() throws Exception {
+        BigInteger b = new BigInteger("-123456789abcdef01", 16);
+        int[] dst = new int[5];
+        assertEquals(3, b.getMagnitude(dst, 2));
+        assertTrue(Arrays.equals(new int[] { 0, 0, 0xabcdef01, 0x23456789, 1 }, dst));
+        // Too little room: the length comes back, and nothing is written.
+        int[] small = new int[3];
+        assertEquals(3, b.getMagnitude(small, 1));
+        assertTrue(Arrays.equals(new int[3], small));
+        assertEquals(0, BigInteger.ZERO.getMagnitude(small, 3));
+        try {
+            b.getMagnitude(small, 4);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+    }
+
+    public void test_modPow_batch() throws Exception {
+        Random rand = new Random(0);
+        int count = 50;
+        BigInteger[] bases = new BigInteger[count];
+        BigInteger[] exponents = new BigInteger[count];
+        BigInteger[] moduli = new BigInteger[count];
+        for (int i = 0; i < count; ++i) {
+            bases[i] = new BigInteger(100, rand);
+            exponents[i] = new BigInteger(40, rand);
+            moduli[i] = new BigInteger(64 + i, rand).add(BigInteger.ONE);
+        }
+        exponents[3] = BigInteger.ZERO;
+        exponents[4] = BigInteger.valueOf(-5);
+        moduli[4] = BigInteger.valueOf(1000003); // Prime, so bases[4] is invertible.
+        moduli[5] = BigInteger.ZERO;
+        bases[6] = BigInteger.valueOf(6);
+        moduli[6] = BigInteger.valueOf(9);
+        exponents[6] = BigInteger.valueOf(-1); // 6 has no inverse mod 9.
+        BigInteger[] results = BigInteger.modPow(bases, exponents, moduli);
+        assertEquals(count, results.length);
+        for (int i = 0; i < count; ++i) {
+            if (i == 5 || i == 6) {
+                assertNull(results[i]);
+            } else {
+                assertEquals(bases[i].modPow(exponents[i], moduli[i]), results[i]);
+            }
+        }
+        assertEquals(0, BigInteger.modPow(new BigInteger[0], new BigInteger[0],
+                new BigInteger[0]).length);
+    }
+
+    public void test_isProbablePrime_batch() throws Exception {
+        BigInteger[] values = new BigInteger[64];
+        for (int i = 0; i < values.length; ++i) {
+            values[i] = BigInteger.valueOf(1000 + i);
+        }
+        boolean[] results = BigInteger.isProbablePrime(values, 100);
+        for (int i = 0; i < values.length; ++i) {
+            assertEquals(values[i].toString(), values[i].isProbablePrime(100), results[i]);
+        }
+    }
+
+    public void test_probablePrimes() throws Exception {
+        for (int bitLength : new int[] { 8, 64, 256 }) {
+            BigInteger[] primes = BigInteger.probablePrimes(bitLength, 8);
+            assertEquals(8, primes.length);
+            for (BigInteger p : primes) {
+                assertEquals(p.toString(), bitLength, p.bitLength());
+                assertTrue(p.isProbablePrime(100));
+            }
+        }
+        assertEquals(0, BigInteger.probablePrimes(64, 0).length);
+    }
+
+    private static BigInteger slowModPow(BigInteger base, BigInteger exponent, BigInteger m) {
+        BigInteger result = BigInteger.ONE.mod(m);
+        base = base.mod(m);
+        for (int i = exponent.bitLength() - 1; i >= 0; --i) {
+            result = result.multiply(result).mod(m);
+            if (exponent.testBit(i)) {
+                result = result.multiply(base).mod(m);
+            }
+        }
+        return result;
+    }
 }
@@ -37,4 +37,38 @@ public class IDNTest extends TestCase {
         String longInput = makePunyString(512);
         assertEquals(longInput, IDN.toUnicode(longInput));
     }
+
+    public void test_plainHostnames() {
+        String[] plain = { "www.Example.COM", "a.", "1.2.3.4", "ab--cd.example" };
+        for (String s : plain) {
+            assertSame(s, IDN.toASCII(s));
+            assertSame(s, IDN.toASCII(s, IDN.USE_STD3_ASCII_RULES));
+            assertSame(s, IDN.toUnicode(s));
+        }
+        // These aren't plain, so they still go to ICU, which rejects or converts them.
+        String[] invalid = { "a..b", ".a", "a..", "-a.com", "a_b.com" };
+        for (String s : invalid) {
+            try {
+                IDN.toASCII(s, IDN.USE_STD3_ASCII_RULES);
+                fail(s);
+            } catch (IllegalArgumentException expected) {
+            }
+        }
+        assertEquals("b\u00fccher.example", IDN.toUnicode("XN--bcher-kva.example"));
+        assertEquals("xn--bcher-kva.example", IDN.toASCII("xn--bcher-kva.example"));
+    }
+
+    public void test_repeatedConversions() {
+        for (int i = 0; i < 3; ++i) {
+            assertEquals("xn--bcher-kva.example", IDN.toASCII("b\u00fccher.example"));
+            assertEquals("b\u00fccher.example", IDN.toUnicode("xn--bcher-kva.example"));
+            // The cache is keyed by flags too.
+            try {
+                IDN.toASCII("b\u00fccher_.example", IDN.USE_STD3_ASCII_RULES);
+                fail();
+            } catch (IllegalArgumentException expected) {
+            }
+            assertEquals("xn--bcher_-3ya.example", IDN.toASCII("b\u00fccher_.example"));
+        }
+    }
 }
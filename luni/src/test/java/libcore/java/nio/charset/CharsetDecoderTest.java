@@ -105,4 +105,22 @@ public class CharsetDecoderTest extends junit.framework.TestCase {
         assertEquals(1, cb.position());
         assertEquals('\u2603', cb.get(0));
     }
+
+    public void testDirectBuffers() throws Exception {
+        CharsetDecoder decoder = Charset.forName("UTF-8").newDecoder();
+        CharBuffer cb = CharBuffer.allocate(128);
+        ByteBuffer in = ByteBuffer.allocateDirect(8);
+        in.put(new byte[] { 'a', (byte) 0xe2, (byte) 0x98 });
+        in.flip();
+        assertEquals(CoderResult.UNDERFLOW, decoder.decode(in, cb, false));
+        assertEquals(3, in.position());
+        in.clear();
+        in.put(new byte[] { (byte) 0x83, 'b' });
+        in.flip();
+        assertEquals(CoderResult.UNDERFLOW, decoder.decode(in, cb, true));
+        assertEquals(2, in.position());
+        assertEquals(CoderResult.UNDERFLOW, decoder.flush(cb));
+        cb.flip();
+        assertEquals("a\u2603b", cb.toString());
+    }
 }
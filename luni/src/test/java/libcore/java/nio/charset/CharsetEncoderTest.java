@@ -161,4 +161,17 @@ public class CharsetEncoderTest extends junit.framework.TestCase {
         assertEquals(CoderResult.UNDERFLOW, cr);
         assertEquals(8, bb.position());
     }
+
+    public void testDirectBuffers() throws Exception {
+        CharsetEncoder e = Charset.forName("UTF-16BE").newEncoder();
+        ByteBuffer bb = ByteBuffer.allocateDirect(3);
+        bb.put((byte) 0x7f);
+        CoderResult cr = e.encode(CharBuffer.wrap("ab"), bb, true);
+        assertEquals(CoderResult.OVERFLOW, cr);
+        assertEquals(3, bb.position());
+        bb.flip();
+        assertEquals(0x7f, bb.get());
+        assertEquals(0, bb.get());
+        assertEquals('a', bb.get());
+    }
 }
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.nio.charset;
+
+import java.nio.BufferOverflowException;
+import java.nio.ByteBuffer;
+import java.nio.charset.Charsets;
+import java.util.Arrays;
+import junit.framework.TestCase;
+
+public class CharsetsTest extends TestCase {
+  // Long enough to take the chunked ASCII path, with every UTF-8 length and an unpaired surrogate.
+  private static final String MIXED = "0123456789abcdef0123456789abcdef\u0666\u1234\ud800\udc00\ud800x0123456789abcdef";
+  // MIXED in UTF-8, written out rather than computed with String.getBytes, which uses the same
+  // encoder. The unpaired surrogate becomes '?'.
+  private static final byte[] MIXED_UTF8 = concat(ascii("0123456789abcdef0123456789abcdef"),
+      new byte[] { (byte) 0xd9, (byte) 0xa6, (byte) 0xe1, (byte) 0x88, (byte) 0xb4,
+                   (byte) 0xf0, (byte) 0x90, (byte) 0x80, (byte) 0x80, '?', 'x' },
+      ascii("0123456789abcdef"));
+
+  private static byte[] ascii(String s) {
+    byte[] result = new byte[s.length()];
+    for (int i = 0; i < result.length; ++i) {
+      result[i] = (byte) s.charAt(i);
+    }
+    return result;
+  }
+
+  private static byte[] concat(byte[]... arrays) {
+    int length = 0;
+    for (byte[] array : arrays) {
+      length += array.length;
+    }
+    byte[] result = new byte[length];
+    int offset = 0;
+    for (byte[] array : arrays) {
+      System.arraycopy(array, 0, result, offset, array.length);
+      offset += array.length;
+    }
+    return result;
+  }
+
+  public void test_toUtf8Bytes_long() throws Exception {
+    char[] chars = MIXED.toCharArray();
+    byte[] expected = MIXED_UTF8;
+    assertTrue(Arrays.equals(expected, Charsets.toUtf8Bytes(chars, 0, chars.length)));
+    assertEquals(expected.length, Charsets.utf8Length(chars, 0, chars.length));
+    assertEquals(4, Charsets.utf8Length(chars, 34, 2));
+    try {
+      Charsets.utf8Length(chars, 1, chars.length);
+      fail();
+    } catch (ArrayIndexOutOfBoundsException expectedException) {
+    }
+  }
+
+  public void test_encodeUtf8_array() throws Exception {
+    char[] chars = MIXED.toCharArray();
+    byte[] expected = MIXED_UTF8;
+    byte[] dst = new byte[expected.length + 2];
+    assertEquals(expected.length, Charsets.encodeUtf8(chars, 0, chars.length, dst, 2));
+    assertTrue(Arrays.equals(expected, Arrays.copyOfRange(dst, 2, dst.length)));
+    try {
+      Charsets.encodeUtf8(chars, 0, chars.length, dst, 3);
+      fail();
+    } catch (ArrayIndexOutOfBoundsException expectedException) {
+    }
+  }
+
+  public void test_encodeUtf8_ByteBuffer() throws Exception {
+    char[] chars = MIXED.toCharArray();
+    byte[] expected = MIXED_UTF8;
+    for (ByteBuffer dst : new ByteBuffer[] { ByteBuffer.allocate(128), ByteBuffer.allocateDirect(128) }) {
+      dst.position(1);
+      assertEquals(expected.length, Charsets.encodeUtf8(chars, 0, chars.length, dst));
+      assertEquals(1 + expected.length, dst.position());
+      byte[] actual = new byte[expected.length];
+      dst.position(1);
+      dst.get(actual);
+      assertTrue(Arrays.equals(expected, actual));
+
+      dst.limit(dst.position() + 1);
+      try {
+        Charsets.encodeUtf8(chars, 0, chars.length, dst);
+        fail();
+      } catch (BufferOverflowException expectedException) {
+      }
+      assertEquals(1 + expected.length, dst.position());
+    }
+  }
+
+  public void test_utf8BytesToChars() throws Exception {
+    byte[] bytes = MIXED_UTF8;
+    char[] chars = new char[bytes.length];
+    int[] firstMalformed = new int[1];
+    int count = Charsets.utf8BytesToChars(bytes, 0, bytes.length, chars, firstMalformed);
+    // The unpaired surrogate was encoded as '?', so the input is well-formed.
+    assertEquals(MIXED.replace('\ud800', '?').replace("?\udc00", "\ud800\udc00"), new String(chars, 0, count));
+    assertEquals(-1, firstMalformed[0]);
+
+    // An overlong NUL, an encoded surrogate, and a truncated sequence.
+    bytes = new byte[] { 'a', (byte) 0xc0, (byte) 0x80, 'b', (byte) 0xed, (byte) 0xa0, (byte) 0x80, (byte) 0xe2, (byte) 0x82 };
+    chars = new char[bytes.length];
+    count = Charsets.utf8BytesToChars(bytes, 0, bytes.length, chars, firstMalformed);
+    assertEquals("a\ufffd\ufffdb\ufffd\ufffd\ufffd\ufffd", new String(chars, 0, count));
+    assertEquals(1, firstMalformed[0]);
+  }
+}
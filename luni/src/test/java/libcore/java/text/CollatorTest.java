@@ -18,11 +18,14 @@ package libcore.java.text;
 
 import java.text.CharacterIterator;
 import java.text.CollationElementIterator;
+import java.text.CollationKey;
 import java.text.Collator;
 import java.text.ParseException;
 import java.text.RuleBasedCollator;
 import java.text.StringCharacterIterator;
+import java.util.Arrays;
 import java.util.Locale;
+import libcore.icu.RuleBasedCollatorICU;
 
 public class CollatorTest extends junit.framework.TestCase {
     public void test_setStrengthI() throws Exception {
@@ -77,6 +80,76 @@ public class CollatorTest extends junit.framework.TestCase {
         assertTrue("Collation keys should differ", foo.equals(bar));
     }
 
+    public void test_getCollationKeys() throws Exception {
+        RuleBasedCollator collator = (RuleBasedCollator) Collator.getInstance(Locale.GERMAN);
+        StringBuilder b = new StringBuilder();
+        for (int i = 0; i < 1024; i++) {
+            b.append("\u00c4pfel ");
+        }
+        String[] sources = { "Zebra", "", null, "\u00e4pfel", "apfel", b.toString(), "Stra\u00dfe" };
+        CollationKey[] keys = collator.getCollationKeys(sources);
+        assertEquals(sources.length, keys.length);
+        assertNull(keys[2]);
+        for (int i = 0; i < sources.length; i++) {
+            if (sources[i] != null) {
+                CollationKey expected = collator.getCollationKey(sources[i]);
+                assertEquals(sources[i], keys[i].getSourceString());
+                assertTrue(sources[i], Arrays.equals(expected.toByteArray(), keys[i].toByteArray()));
+            }
+        }
+        assertTrue(keys[4].compareTo(keys[3]) < 0);
+        assertTrue(keys[3].compareTo(keys[0]) < 0);
+    }
+
+    public void test_getSortKeysPrefix() throws Exception {
+        RuleBasedCollatorICU collator = new RuleBasedCollatorICU(Locale.GERMAN);
+        String[] sources = { "apfel", "Zebra", "a", "apfelsine" };
+        int[] offsets = new int[sources.length + 1];
+        byte[] keys = collator.getSortKeys(sources, offsets, 2);
+        assertEquals(0, offsets[0]);
+        assertEquals(keys.length, offsets[sources.length]);
+        for (int i = 0; i < sources.length; i++) {
+            byte[] full = collator.getCollationKey(sources[i]).toByteArray();
+            byte[] prefix = Arrays.copyOfRange(keys, offsets[i], offsets[i + 1]);
+            assertTrue(prefix.length <= 2);
+            assertTrue(sources[i], Arrays.equals(Arrays.copyOf(full, prefix.length), prefix));
+        }
+        try {
+            collator.getSortKeys(sources, new int[sources.length], 0);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+
+    public void test_compareAscii() throws Exception {
+        RuleBasedCollatorICU collator = new RuleBasedCollatorICU(Locale.US);
+        String[] strings = { "getFoo", "getfoo", "getFooBar", "get-foo", "get foo", "getFo", "a", "B", "", "get_foo" };
+        // Compare often enough for the native ASCII table to be built, and after changing an
+        // attribute that affects primary weights.
+        for (int round = 0; round < 4; round++) {
+            if (round == 2) {
+                collator.setAttribute(RuleBasedCollatorICU.ALTERNATE_HANDLING, RuleBasedCollatorICU.VALUE_SHIFTED);
+            }
+            for (String lhs : strings) {
+                for (String rhs : strings) {
+                    int expected = collator.getCollationKey(lhs).compareTo(collator.getCollationKey(rhs));
+                    assertEquals(lhs + " " + rhs, Integer.signum(expected), Integer.signum(collator.compare(lhs, rhs)));
+                }
+            }
+        }
+    }
+
+    public void test_instancesAreIndependent() throws Exception {
+        // Collator.getInstance hands out clones of a cached native collator.
+        Collator first = Collator.getInstance(Locale.US);
+        first.setStrength(Collator.PRIMARY);
+        assertEquals(0, first.compare("abc", "ABC"));
+        Collator second = Collator.getInstance(Locale.US);
+        assertEquals(Collator.TERTIARY, second.getStrength());
+        assertTrue(second.compare("abc", "ABC") != 0);
+        assertEquals(0, first.compare("abc", "ABC"));
+    }
+
     public void test_decompositionCompatibility() throws Exception {
         Collator myCollator = Collator.getInstance();
         myCollator.setDecomposition(Collator.NO_DECOMPOSITION);
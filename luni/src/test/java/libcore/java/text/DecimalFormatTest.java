@@ -21,6 +21,7 @@ import java.math.BigInteger;
 import java.math.RoundingMode;
 import java.text.DecimalFormat;
 import java.text.DecimalFormatSymbols;
+import java.text.FieldPosition;
 import java.text.NumberFormat;
 import java.util.Currency;
 import java.util.Locale;
@@ -197,4 +198,46 @@ public class DecimalFormatTest extends junit.framework.TestCase {
         df.setCurrency(Currency.getInstance("CHF"));
         df.setCurrency(Currency.getInstance("GBP"));
     }
+
+    public void testInstancesAreIndependent() throws Exception {
+        // NumberFormat.getInstance hands out clones of a cached native format. Changing one
+        // instance mustn't affect the cached format or instances created later.
+        DecimalFormat first = (DecimalFormat) NumberFormat.getInstance(Locale.US);
+        first.setMaximumFractionDigits(1);
+        first.setGroupingUsed(false);
+        DecimalFormatSymbols dfs = first.getDecimalFormatSymbols();
+        dfs.setDecimalSeparator('!');
+        first.setDecimalFormatSymbols(dfs);
+        assertEquals("1234!6", first.format(1234.56));
+
+        DecimalFormat second = (DecimalFormat) NumberFormat.getInstance(Locale.US);
+        assertEquals("1,234.56", second.format(1234.56));
+        assertEquals("1234!6", first.format(1234.56));
+
+        // A different pattern or different symbols must not share an entry.
+        assertEquals("1,234.56", new DecimalFormat("#,##0.00", new DecimalFormatSymbols(Locale.US)).format(1234.56));
+        assertEquals("1.234,56", new DecimalFormat("#,##0.00", new DecimalFormatSymbols(Locale.GERMANY)).format(1234.56));
+        assertEquals("1234.6", new DecimalFormat("0.0", new DecimalFormatSymbols(Locale.US)).format(1234.56));
+    }
+
+    public void testFormatWithoutFieldPosition() throws Exception {
+        DecimalFormat df = new DecimalFormat("#,##0.###", new DecimalFormatSymbols(Locale.US));
+        StringBuffer sb = new StringBuffer("x");
+        df.format(-1234.5678, sb, new FieldPosition(-1));
+        df.format(42L, sb, new FieldPosition(-1));
+        assertEquals("x-1,234.56842", sb.toString());
+
+        // Longer than the per-thread buffer starts out.
+        String max = df.format(Double.MAX_VALUE);
+        assertEquals(Double.MAX_VALUE, df.parse(max).doubleValue());
+        assertEquals(max, df.format(Double.MAX_VALUE, new StringBuffer(), new FieldPosition(0)).toString());
+
+        // Asking for a field position still fills it in.
+        FieldPosition fp = new FieldPosition(NumberFormat.INTEGER_FIELD);
+        sb = new StringBuffer();
+        df.format(1234567L, sb, fp);
+        assertEquals("1,234,567", sb.toString());
+        assertEquals(0, fp.getBeginIndex());
+        assertEquals(9, fp.getEndIndex());
+    }
 }
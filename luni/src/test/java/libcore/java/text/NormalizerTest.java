@@ -84,4 +84,23 @@ public class NormalizerTest extends junit.framework.TestCase {
             // pass
         }
     }
+
+    public void testNormalizeFastPaths() {
+        // ASCII and already-normalized input comes back as the same instance.
+        String ascii = "plain ASCII text";
+        assertSame(ascii, Normalizer.normalize(ascii, Normalizer.Form.NFKD));
+        String nfc = "caf\u00e9 \u00fcber";
+        assertSame(nfc, Normalizer.normalize(nfc, Normalizer.Form.NFC));
+        // Only the tail needs work, but the whole string must come back.
+        assertEquals("caf\u00e9 caf\u00e9", Normalizer.normalize("caf\u00e9 cafe\u0301", Normalizer.Form.NFC));
+        assertEquals("cafe\u0301 cafe\u0301", Normalizer.normalize("cafe\u0301 caf\u00e9", Normalizer.Form.NFD));
+
+        String[] strings = { "abc", null, "e\u0301", nfc, "\ufb01" };
+        libcore.icu.NativeNormalizer.normalizeAll(strings, Normalizer.Form.NFKC);
+        assertEquals("abc", strings[0]);
+        assertNull(strings[1]);
+        assertEquals("\u00e9", strings[2]);
+        assertSame(nfc, strings[3]);
+        assertEquals("fi", strings[4]);
+    }
 }
@@ -86,4 +86,41 @@ public class OldBidiTest extends TestCase {
             assertEquals(expectedRuns[i][0], bi.getRunStart(i));
         }
     }
+
+    public void testRunsAndLevels() {
+        // Unidirectional text keeps neither runs nor per-char levels, but must still answer.
+        Bidi ltr = new Bidi("plain text", Bidi.DIRECTION_LEFT_TO_RIGHT);
+        assertTrue(ltr.isLeftToRight());
+        assertEquals(1, ltr.getRunCount());
+        assertEquals(0, ltr.getRunStart(0));
+        assertEquals(10, ltr.getRunLimit(0));
+        assertEquals(0, ltr.getLevelAt(3));
+        assertEquals(0, ltr.getLevelAt(-1));
+        assertEquals(0, ltr.getLevelAt(100));
+        Bidi line = ltr.createLineBidi(2, 6);
+        assertEquals(4, line.getLength());
+        assertEquals(0, line.getLevelAt(1));
+
+        // Mixed text.
+        Bidi mixed = new Bidi("ab \u05d0\u05d1 cd", Bidi.DIRECTION_LEFT_TO_RIGHT);
+        assertTrue(mixed.isMixed());
+        assertEquals(3, mixed.getRunCount());
+        int[][] expected = { { 0, 3, 0 }, { 3, 5, 1 }, { 5, 8, 0 } };
+        for (int i = 0; i < expected.length; ++i) {
+            assertEquals(expected[i][0], mixed.getRunStart(i));
+            assertEquals(expected[i][1], mixed.getRunLimit(i));
+            assertEquals(expected[i][2], mixed.getRunLevel(i));
+        }
+        assertEquals(1, mixed.getLevelAt(4));
+        assertEquals(0, mixed.getLevelAt(6));
+        Bidi mixedLine = mixed.createLineBidi(3, 5);
+        assertTrue(mixedLine.isRightToLeft());
+        assertEquals(1, mixedLine.getLevelAt(0));
+
+        // Embedding levels on otherwise unidirectional text still show up.
+        byte[] embeddings = { 0, 2, 2, 0 };
+        Bidi embedded = new Bidi("abcd".toCharArray(), 0, embeddings, 0, 4, Bidi.DIRECTION_LEFT_TO_RIGHT);
+        assertEquals(2, embedded.getLevelAt(1));
+        assertEquals(0, embedded.getLevelAt(3));
+    }
 }
@@ -613,4 +613,104 @@ public class OldMatcherTest extends TestCase {
         String result = p.matcher("mama").region(2, 4).replaceFirst("mi");
         assertEquals("mima", result);
     }
+
+    public void testInputIsKeptAcrossCalls() throws Exception {
+        Matcher m = Pattern.compile("b+").matcher("abbcbd");
+        assertTrue(m.find());
+        assertEquals(1, m.start());
+        assertTrue(m.find());
+        assertEquals(4, m.start());
+        assertFalse(m.find());
+
+        // Resetting with the same input, or a region of it, starts over.
+        m.reset();
+        assertTrue(m.find());
+        assertEquals(1, m.start());
+        m.region(3, 6);
+        assertTrue(m.find());
+        assertEquals(4, m.start());
+
+        // A new input replaces the old one, even when it's shorter.
+        m.reset("xb");
+        assertTrue(m.find());
+        assertEquals(1, m.start());
+        assertFalse(m.find());
+        m.reset("");
+        assertFalse(m.find());
+        assertTrue(m.usePattern(Pattern.compile("x")).reset("axa").find());
+        assertEquals(1, m.start());
+    }
+
+    public void testSplitLongInput() throws Exception {
+        StringBuilder sb = new StringBuilder();
+        for (int i = 0; i < 10000; i++) {
+            sb.append(i).append(", ");
+        }
+        String[] parts = Pattern.compile(",\\s*").split(sb.toString());
+        assertEquals(10000, parts.length);
+        assertEquals("9999", parts[9999]);
+        assertEquals(3, Pattern.compile(",\\s*").split(sb.toString(), 3).length);
+        assertEquals("2", Pattern.compile(",\\s*").split(sb.toString(), 3)[2].substring(0, 1));
+    }
+
+    public void testPatternCache() throws Exception {
+        String regex = "cache-(\\d+)-" + System.nanoTime();
+        long[] before = Pattern.getCacheCounters();
+        Pattern p1 = Pattern.compile(regex);
+        Pattern p2 = Pattern.compile(regex);
+        long[] after = Pattern.getCacheCounters();
+        assertTrue(after[0] > before[0]);
+        assertTrue(after[1] > before[1]);
+
+        // Patterns sharing a compiled form, and matchers reusing pooled native matchers,
+        // must not see each other's state.
+        Matcher m1 = p1.matcher("cache-12-" + regex.substring(regex.lastIndexOf('-') + 1));
+        assertTrue(m1.find());
+        for (int i = 0; i < 10; i++) {
+            Matcher m2 = p2.matcher("none");
+            assertFalse(m2.find());
+        }
+        assertEquals("12", m1.group(1));
+
+        // Flags are part of the key.
+        assertTrue(Pattern.compile("ab", Pattern.CASE_INSENSITIVE).matcher("AB").matches());
+        assertFalse(Pattern.compile("ab").matcher("AB").matches());
+    }
+
+    public void testLiteralPatterns() throws Exception {
+        // Leftmost match wins, then the first alternative that matches there.
+        Matcher m = Pattern.compile("b|ab").matcher("xabab");
+        assertTrue(m.find());
+        assertEquals(1, m.start());
+        assertEquals(3, m.end());
+        assertTrue(m.find());
+        assertEquals(3, m.start());
+        assertFalse(m.find());
+        assertTrue(m.hitEnd());
+
+        m = Pattern.compile("\\s+").matcher("a \t\u3000b  c");
+        assertTrue(m.find());
+        assertEquals(1, m.start());
+        assertEquals(4, m.end());
+        // Matches are confined to the region.
+        m.region(6, 7);
+        assertTrue(m.find());
+        assertEquals(6, m.start());
+        assertEquals(7, m.end());
+        // find(int) ignores the region, and find() continues from there.
+        assertTrue(m.find(2));
+        assertEquals(2, m.start());
+        assertTrue(m.find());
+        assertEquals(5, m.start());
+        assertEquals(7, m.end());
+
+        // matches and lookingAt work alongside find.
+        m = Pattern.compile("\\Qa.b\\E").matcher("a.ba.b");
+        assertTrue(m.lookingAt());
+        assertTrue(m.find());
+        assertEquals(3, m.start());
+        assertFalse(m.matches());
+        assertTrue(Pattern.compile("a.b", Pattern.LITERAL).matcher("a.b").matches());
+        assertFalse(Pattern.compile("a.b", Pattern.LITERAL).matcher("axb").find());
+    }
 }
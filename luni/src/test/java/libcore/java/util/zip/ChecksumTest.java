@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.util.zip;
+
+import java.nio.ByteBuffer;
+import java.util.Random;
+import java.util.zip.Adler32;
+import java.util.zip.CRC32;
+import junit.framework.TestCase;
+
+public final class ChecksumTest extends TestCase {
+    private static byte[] randomBytes(int byteCount) {
+        byte[] result = new byte[byteCount];
+        new Random(0).nextBytes(result);
+        return result;
+    }
+
+    public void testCrc32KnownValue() throws Exception {
+        CRC32 crc = new CRC32();
+        crc.update("123456789".getBytes("US-ASCII"));
+        assertEquals(0xcbf43926L, crc.getValue());
+    }
+
+    public void testAdler32KnownValue() throws Exception {
+        Adler32 adler = new Adler32();
+        adler.update("Wikipedia".getBytes("US-ASCII"));
+        assertEquals(0x11e60398L, adler.getValue());
+    }
+
+    public void testCrc32SingleBytesMatchArrays() throws Exception {
+        byte[] bytes = randomBytes(1000);
+        CRC32 expected = new CRC32();
+        expected.update(bytes);
+        CRC32 actual = new CRC32();
+        for (byte b : bytes) {
+            actual.update(b);
+        }
+        assertEquals(expected.getValue(), actual.getValue());
+    }
+
+    public void testAdler32SingleBytesMatchArrays() throws Exception {
+        byte[] bytes = randomBytes(10000);
+        Adler32 expected = new Adler32();
+        expected.update(bytes);
+        Adler32 actual = new Adler32();
+        for (byte b : bytes) {
+            actual.update(b);
+        }
+        assertEquals(expected.getValue(), actual.getValue());
+    }
+
+    public void testDirectBuffers() throws Exception {
+        // Odd lengths and offsets exercise the vector kernels' tails.
+        byte[] bytes = randomBytes(100003);
+        ByteBuffer direct = ByteBuffer.allocateDirect(bytes.length);
+        direct.put(bytes);
+        direct.position(3);
+
+        CRC32 expectedCrc = new CRC32();
+        expectedCrc.update(bytes, 3, bytes.length - 3);
+        CRC32 actualCrc = new CRC32();
+        actualCrc.update(direct.duplicate());
+        assertEquals(expectedCrc.getValue(), actualCrc.getValue());
+
+        Adler32 expectedAdler = new Adler32();
+        expectedAdler.update(bytes, 3, bytes.length - 3);
+        Adler32 actualAdler = new Adler32();
+        actualAdler.update(direct);
+        assertEquals(expectedAdler.getValue(), actualAdler.getValue());
+        assertEquals(direct.limit(), direct.position());
+    }
+
+    public void testCombine() throws Exception {
+        byte[] bytes = randomBytes(70001);
+        int split = 12345;
+
+        CRC32 whole = new CRC32();
+        whole.update(bytes);
+        CRC32 a = new CRC32();
+        a.update(bytes, 0, split);
+        CRC32 b = new CRC32();
+        b.update(bytes, split, bytes.length - split);
+        assertEquals(whole.getValue(), CRC32.combine(a.getValue(), b.getValue(), bytes.length - split));
+
+        Adler32 wholeAdler = new Adler32();
+        wholeAdler.update(bytes);
+        Adler32 aAdler = new Adler32();
+        aAdler.update(bytes, 0, split);
+        Adler32 bAdler = new Adler32();
+        bAdler.update(bytes, split, bytes.length - split);
+        assertEquals(wholeAdler.getValue(),
+                Adler32.combine(aAdler.getValue(), bAdler.getValue(), bytes.length - split));
+    }
+}
@@ -16,6 +16,9 @@
 
 package libcore.java.util.zip;
 
+import java.nio.ByteBuffer;
+import java.nio.NioUtils;
+import java.util.Arrays;
 import java.util.zip.DataFormatException;
 import java.util.zip.Deflater;
 import java.util.zip.Inflater;
@@ -82,4 +85,68 @@ public class DeflaterTest extends TestCase {
         assertTrue(totalDeflated > 0); // the deflated form should be non-empty
         assertEquals(0, totalInflated);
     }
+
+    public void testDeflateAndInflateAddresses() throws Exception {
+        byte[] original = new byte[64 * 1024];
+        for (int i = 0; i < original.length; ++i) {
+            original[i] = (byte) (i % 17);
+        }
+        ByteBuffer in = ByteBuffer.allocateDirect(original.length);
+        in.put(original);
+        ByteBuffer compressed = ByteBuffer.allocateDirect(original.length);
+        ByteBuffer out = ByteBuffer.allocateDirect(original.length);
+
+        Deflater deflater = new Deflater();
+        deflater.setAddressInput(NioUtils.unsafeAddress(in), original.length);
+        deflater.finish();
+        int compressedLength = 0;
+        while (!deflater.finished()) {
+            compressedLength += deflater.deflateAddress(NioUtils.unsafeAddress(compressed) + compressedLength,
+                    compressed.capacity() - compressedLength);
+        }
+        assertEquals(original.length, deflater.getTotalIn());
+        deflater.end();
+
+        Inflater inflater = new Inflater();
+        inflater.setAddressInput(NioUtils.unsafeAddress(compressed), compressedLength);
+        int inflatedLength = 0;
+        while (!inflater.finished()) {
+            inflatedLength += inflater.inflateAddress(NioUtils.unsafeAddress(out) + inflatedLength,
+                    out.capacity() - inflatedLength);
+        }
+        inflater.end();
+
+        assertEquals(original.length, inflatedLength);
+        byte[] actual = new byte[inflatedLength];
+        out.get(actual);
+        assertTrue(Arrays.equals(original, actual));
+    }
+
+    public void testEndedDeflatersDontLeakSettings() throws Exception {
+        // Ended streams may be reused, so make sure nothing carries over.
+        byte[] input = new byte[32 * 1024];
+        for (int i = 0; i < input.length; ++i) {
+            input[i] = (byte) (i % 97);
+        }
+        byte[] expected = deflateFully(new Deflater(Deflater.BEST_SPEED), input);
+        for (int i = 0; i < 8; ++i) {
+            Deflater changed = new Deflater(Deflater.BEST_SPEED);
+            changed.setLevel(Deflater.BEST_COMPRESSION);
+            changed.setDictionary(new byte[] { 1, 2, 3 });
+            deflateFully(changed, input);
+            assertTrue(Arrays.equals(expected, deflateFully(new Deflater(Deflater.BEST_SPEED), input)));
+        }
+    }
+
+    private static byte[] deflateFully(Deflater deflater, byte[] input) {
+        deflater.setInput(input);
+        deflater.finish();
+        byte[] buf = new byte[input.length * 2];
+        int byteCount = 0;
+        while (!deflater.finished()) {
+            byteCount += deflater.deflate(buf, byteCount, buf.length - byteCount);
+        }
+        deflater.end();
+        return Arrays.copyOf(buf, byteCount);
+    }
 }
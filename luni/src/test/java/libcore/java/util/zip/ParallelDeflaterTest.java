@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.java.util.zip;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.util.Arrays;
+import java.util.Random;
+import java.util.zip.CRC32;
+import java.util.zip.Deflater;
+import java.util.zip.GZIPInputStream;
+import java.util.zip.InflaterInputStream;
+import java.util.zip.ParallelDeflater;
+import junit.framework.TestCase;
+import libcore.io.Streams;
+
+public final class ParallelDeflaterTest extends TestCase {
+    private static byte[] makeInput(int byteCount) {
+        // Compressible but not trivially so.
+        byte[] result = new byte[byteCount];
+        Random random = new Random(0);
+        for (int i = 0; i < byteCount; ++i) {
+            result[i] = (byte) ((i % 61) + (random.nextInt(8) == 0 ? random.nextInt() : 0));
+        }
+        return result;
+    }
+
+    private static byte[] deflate(ParallelDeflater deflater, byte[] input, int chunkSize) {
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+        for (int offset = 0; offset < input.length; offset += chunkSize) {
+            byte[] bytes = deflater.deflate(input, offset, Math.min(chunkSize, input.length - offset));
+            out.write(bytes, 0, bytes.length);
+        }
+        byte[] bytes = deflater.finish();
+        out.write(bytes, 0, bytes.length);
+        return out.toByteArray();
+    }
+
+    public void testGzip() throws Exception {
+        byte[] input = makeInput(1024 * 1024 + 17);
+        ParallelDeflater deflater = new ParallelDeflater(Deflater.DEFAULT_COMPRESSION, true, 4);
+        byte[] compressed = deflate(deflater, input, 300 * 1024);
+        CRC32 crc = new CRC32();
+        crc.update(input);
+        assertEquals((int) crc.getValue(), deflater.getChecksum());
+        assertEquals(input.length, deflater.getBytesRead());
+        assertEquals(compressed.length, deflater.getBytesWritten());
+        deflater.end();
+
+        byte[] actual = Streams.readFully(new GZIPInputStream(new ByteArrayInputStream(compressed)));
+        assertTrue(Arrays.equals(input, actual));
+    }
+
+    public void testZlib() throws Exception {
+        byte[] input = makeInput(512 * 1024);
+        ParallelDeflater deflater = new ParallelDeflater(Deflater.BEST_SPEED, false, 3);
+        byte[] compressed = deflate(deflater, input, input.length);
+        deflater.end();
+
+        byte[] actual = Streams.readFully(new InflaterInputStream(new ByteArrayInputStream(compressed)));
+        assertTrue(Arrays.equals(input, actual));
+    }
+
+    public void testHugeThreadCount() throws Exception {
+        byte[] input = makeInput(256 * 1024);
+        ParallelDeflater deflater = new ParallelDeflater(Deflater.BEST_SPEED, false, Integer.MAX_VALUE);
+        byte[] compressed = deflate(deflater, input, input.length);
+        deflater.end();
+
+        byte[] actual = Streams.readFully(new InflaterInputStream(new ByteArrayInputStream(compressed)));
+        assertTrue(Arrays.equals(input, actual));
+    }
+
+    public void testEmpty() throws Exception {
+        ParallelDeflater deflater = new ParallelDeflater(Deflater.DEFAULT_COMPRESSION, true, 2);
+        byte[] compressed = deflater.finish();
+        deflater.end();
+        byte[] actual = Streams.readFully(new GZIPInputStream(new ByteArrayInputStream(compressed)));
+        assertEquals(0, actual.length);
+    }
+
+    public void testUseAfterFinish() throws Exception {
+        ParallelDeflater deflater = new ParallelDeflater(Deflater.DEFAULT_COMPRESSION, false, 2);
+        deflater.finish();
+        try {
+            deflater.deflate(new byte[1], 0, 1);
+            fail();
+        } catch (IllegalStateException expected) {
+        }
+        deflater.end();
+    }
+}
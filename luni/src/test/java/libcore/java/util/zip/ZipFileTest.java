@@ -24,6 +24,7 @@ import java.io.FileOutputStream;
 import java.io.FileWriter;
 import java.io.IOException;
 import java.io.InputStream;
+import java.util.Arrays;
 import java.util.Enumeration;
 import java.util.Random;
 import java.util.zip.CRC32;
@@ -33,6 +34,7 @@ import java.util.zip.ZipFile;
 import java.util.zip.ZipInputStream;
 import java.util.zip.ZipOutputStream;
 import junit.framework.TestCase;
+import libcore.io.Streams;
 
 public final class ZipFileTest extends TestCase {
     /**
@@ -56,6 +58,29 @@ public final class ZipFileTest extends TestCase {
         zipFile.close();
     }
 
+    public void testInflatingFromMappedFile() throws IOException {
+        File f = createTemporaryZipFile();
+        ZipOutputStream out = createZipOutputStream(f);
+        byte[] expected = new byte[256 * 1024];
+        for (int i = 0; i < expected.length; ++i) {
+            expected[i] = (byte) (i % 251);
+        }
+        for (String name : new String[] { "a", "b" }) {
+            out.putNextEntry(new ZipEntry(name));
+            out.write(expected);
+            out.closeEntry();
+        }
+        out.close();
+
+        ZipFile zipFile = new ZipFile(f, ZipFile.OPEN_READ | ZipFile.OPEN_MMAP);
+        for (String name : new String[] { "a", "b" }) {
+            InputStream is = zipFile.getInputStream(zipFile.getEntry(name));
+            byte[] actual = Streams.readFully(is);
+            assertTrue(Arrays.equals(expected, actual));
+        }
+        zipFile.close();
+    }
+
     private static void replaceBytes(byte[] buffer, byte[] original, byte[] replacement) {
         // Gotcha here: original and replacement must be the same length
         assertEquals(original.length, replacement.length);
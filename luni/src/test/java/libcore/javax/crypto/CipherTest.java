@@ -2536,6 +2536,45 @@ public final class CipherTest extends TestCase {
         }
     }
 
+    public void testAES_CBC_ReinitWithNewIv() throws Exception {
+        for (String provider : AES_PROVIDERS) {
+            testAES_CBC_ReinitWithNewIv(provider);
+        }
+    }
+
+    private void testAES_CBC_ReinitWithNewIv(String provider) throws Exception {
+        SecretKey key = new SecretKeySpec(AES_128_KEY, "AES");
+        byte[] plaintext = new byte[40];
+        byte[][] ivs = new byte[3][16];
+        for (int i = 0; i < ivs.length; i++) {
+            Arrays.fill(ivs[i], (byte) i);
+        }
+
+        Cipher reused = Cipher.getInstance("AES/CBC/PKCS5Padding", provider);
+        for (byte[] iv : ivs) {
+            Cipher fresh = Cipher.getInstance("AES/CBC/PKCS5Padding", provider);
+            fresh.init(Cipher.ENCRYPT_MODE, key, new IvParameterSpec(iv));
+            byte[] expected = fresh.doFinal(plaintext);
+
+            reused.init(Cipher.ENCRYPT_MODE, key, new IvParameterSpec(iv));
+            assertEquals(Arrays.toString(expected), Arrays.toString(reused.doFinal(plaintext)));
+
+            // Changing direction with the same key needs the decryption schedule.
+            reused.init(Cipher.DECRYPT_MODE, key, new IvParameterSpec(iv));
+            assertEquals(Arrays.toString(plaintext), Arrays.toString(reused.doFinal(expected)));
+        }
+
+        // A different key of the same length must not be mistaken for the last one.
+        byte[] otherKeyBytes = AES_128_KEY.clone();
+        otherKeyBytes[0] ^= 1;
+        SecretKey otherKey = new SecretKeySpec(otherKeyBytes, "AES");
+        Cipher fresh = Cipher.getInstance("AES/CBC/PKCS5Padding", provider);
+        fresh.init(Cipher.ENCRYPT_MODE, otherKey, new IvParameterSpec(ivs[0]));
+        reused.init(Cipher.ENCRYPT_MODE, otherKey, new IvParameterSpec(ivs[0]));
+        assertEquals(Arrays.toString(fresh.doFinal(plaintext)),
+                Arrays.toString(reused.doFinal(plaintext)));
+    }
+
     public void testRC4_MultipleKeySizes() throws Exception {
         final int SMALLEST_KEY_SIZE = 40;
         final int LARGEST_KEY_SIZE = 1024;
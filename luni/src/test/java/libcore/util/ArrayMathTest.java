@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.DoubleBuffer;
+import java.util.Random;
+import junit.framework.TestCase;
+
+public final class ArrayMathTest extends TestCase {
+
+    private static final int[] FUNCTIONS = {
+        ArrayMath.EXP, ArrayMath.LOG, ArrayMath.SQRT, ArrayMath.SIN, ArrayMath.COS
+    };
+
+    // Includes the special cases and the edges of the kernels' fast paths, and enough elements
+    // to cover several of the native code's blocks.
+    private static double[] inputs() {
+        double[] special = {
+            Double.NaN, Double.POSITIVE_INFINITY, Double.NEGATIVE_INFINITY, 0.0, -0.0, 1.0, -1.0,
+            Double.MIN_VALUE, Double.MIN_NORMAL, Double.MAX_VALUE, 708.0, -708.0, 709.7, -745.0,
+            710.0, -746.0, Math.E, 0.5,
+        };
+        double[] result = new double[1000];
+        System.arraycopy(special, 0, result, 0, special.length);
+        Random random = new Random(0);
+        for (int i = special.length; i < result.length; ++i) {
+            result[i] = (random.nextDouble() - 0.5) * ((i % 2 == 0) ? 20 : 1400);
+        }
+        return result;
+    }
+
+    private static double expected(int function, double x, boolean strict) {
+        switch (function) {
+        case ArrayMath.EXP: return strict ? StrictMath.exp(x) : Math.exp(x);
+        case ArrayMath.LOG: return strict ? StrictMath.log(x) : Math.log(x);
+        case ArrayMath.SQRT: return strict ? StrictMath.sqrt(x) : Math.sqrt(x);
+        case ArrayMath.SIN: return strict ? StrictMath.sin(x) : Math.sin(x);
+        case ArrayMath.COS: return strict ? StrictMath.cos(x) : Math.cos(x);
+        }
+        throw new AssertionError();
+    }
+
+    // Math and ArrayMath may each be up to 1 ulp out, in different directions.
+    private static void assertWithinTwoUlps(String message, double expected, double actual) {
+        if (Double.isNaN(expected) || Double.isInfinite(expected) || expected == 0.0) {
+            assertEquals(message, expected, actual, 0.0);
+        } else {
+            assertEquals(message, expected, actual, 2 * Math.ulp(expected));
+        }
+    }
+
+    public void testDoubles() {
+        double[] src = inputs();
+        double[] dst = new double[src.length + 1];
+        for (int function : FUNCTIONS) {
+            ArrayMath.apply(function, src, 0, dst, 1, src.length);
+            for (int i = 0; i < src.length; ++i) {
+                String message = function + "(" + src[i] + ")";
+                if (function == ArrayMath.EXP || function == ArrayMath.LOG) {
+                    assertWithinTwoUlps(message, expected(function, src[i], false), dst[i + 1]);
+                } else {
+                    assertEquals(message, expected(function, src[i], false), dst[i + 1], 0.0);
+                }
+            }
+            assertEquals(0.0, dst[0], 0.0);
+        }
+    }
+
+    public void testStrictIsBitExact() {
+        double[] src = inputs();
+        double[] dst = new double[src.length];
+        for (int function : FUNCTIONS) {
+            ArrayMath.applyStrict(function, src, 0, dst, 0, src.length);
+            for (int i = 0; i < src.length; ++i) {
+                assertEquals(function + "(" + src[i] + ")",
+                        Double.doubleToRawLongBits(expected(function, src[i], true)),
+                        Double.doubleToRawLongBits(dst[i]));
+            }
+        }
+    }
+
+    public void testFloats() {
+        double[] inputs = inputs();
+        float[] src = new float[inputs.length];
+        for (int i = 0; i < src.length; ++i) {
+            src[i] = (float) inputs[i];
+        }
+        float[] dst = new float[src.length];
+        for (int function : FUNCTIONS) {
+            ArrayMath.apply(function, src, 0, dst, 0, src.length);
+            for (int i = 0; i < src.length; ++i) {
+                float expected = (float) expected(function, src[i], false);
+                String message = function + "(" + src[i] + ")";
+                if (Float.isNaN(expected) || Float.isInfinite(expected) || expected == 0.0f) {
+                    assertEquals(message, expected, dst[i], 0.0f);
+                } else {
+                    assertEquals(message, expected, dst[i], Math.ulp(expected));
+                }
+            }
+        }
+    }
+
+    public void testInPlace() {
+        double[] values = inputs();
+        double[] expected = values.clone();
+        ArrayMath.applyStrict(ArrayMath.SQRT, expected, 0, expected, 0, expected.length);
+        ArrayMath.apply(ArrayMath.SQRT, values, 0, values, 0, values.length);
+        for (int i = 0; i < values.length; ++i) {
+            assertEquals(expected[i], values[i], 0.0);
+        }
+    }
+
+    public void testDirectBuffers() {
+        double[] inputs = inputs();
+        DoubleBuffer src = ByteBuffer.allocateDirect(inputs.length * 8)
+                .order(ByteOrder.nativeOrder()).asDoubleBuffer();
+        src.put(inputs).position(10);
+        DoubleBuffer dst = ByteBuffer.allocateDirect(inputs.length * 8)
+                .order(ByteOrder.nativeOrder()).asDoubleBuffer();
+        ArrayMath.applyStrict(ArrayMath.EXP, src, dst, inputs.length - 10);
+        assertEquals(10, src.position());
+        assertEquals(0, dst.position());
+        for (int i = 10; i < inputs.length; ++i) {
+            assertEquals(StrictMath.exp(inputs[i]), dst.get(i - 10), 0.0);
+        }
+    }
+
+    public void testBadArguments() {
+        double[] array = new double[8];
+        try {
+            ArrayMath.apply(ArrayMath.EXP, array, 0, array, 1, 4);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+        try {
+            ArrayMath.apply(ArrayMath.EXP, array, 6, new double[8], 0, 4);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+        }
+        try {
+            ArrayMath.apply(-1, array, 0, new double[8], 0, 4);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+        try {
+            ArrayMath.apply(ArrayMath.EXP, DoubleBuffer.allocate(4), DoubleBuffer.allocate(4), 4);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+}
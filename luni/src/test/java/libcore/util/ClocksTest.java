@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+import junit.framework.TestCase;
+
+public final class ClocksTest extends TestCase {
+    // Generous, since the coarse clocks can lag by a tick and the ticker by a period.
+    private static final long SLACK_MILLIS = 100;
+
+    public void testCoarseClocks() {
+        assertEquals(System.currentTimeMillis(), Clocks.coarseCurrentTimeMillis(), SLACK_MILLIS);
+        assertEquals(System.nanoTime() / 1000000, Clocks.coarseNanoTime() / 1000000, SLACK_MILLIS);
+        long first = Clocks.coarseNanoTime();
+        assertTrue(Clocks.coarseNanoTime() >= first);
+    }
+
+    public void testCycleCounter() throws Exception {
+        long frequency = Clocks.getCycleCounterFrequency();
+        assertTrue(frequency > 0);
+        long startNanos = System.nanoTime();
+        long startCount = Clocks.readCycleCounter();
+        Thread.sleep(200);
+        long elapsedCount = Clocks.readCycleCounter() - startCount;
+        long elapsedNanos = System.nanoTime() - startNanos;
+        double countedNanos = elapsedCount * 1e9 / frequency;
+        assertEquals(elapsedNanos, countedNanos, elapsedNanos * 0.05);
+    }
+
+    public void testTicker() throws Exception {
+        Clocks.startTicker(5);
+        try {
+            Thread.sleep(50);
+            long first = Clocks.tickerNanoTime();
+            assertEquals(System.currentTimeMillis(), Clocks.tickerCurrentTimeMillis(),
+                    SLACK_MILLIS);
+            assertEquals(System.nanoTime() / 1000000, first / 1000000, SLACK_MILLIS);
+            Thread.sleep(50);
+            assertTrue(Clocks.tickerNanoTime() > first);
+        } finally {
+            Clocks.stopTicker();
+        }
+        // Once stopped, the ticker clocks are the system clocks again.
+        long before = System.nanoTime();
+        assertTrue(Clocks.tickerNanoTime() >= before);
+    }
+
+    public void testTickerPeriod() {
+        try {
+            Clocks.startTicker(0);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+import java.util.Arrays;
+import java.util.zip.CRC32;
+import junit.framework.TestCase;
+
+public final class LazyNativesTest extends TestCase {
+
+    private static int indexOf(String group) {
+        int index = Arrays.asList(LazyNatives.getGroupNames()).indexOf(group);
+        assertTrue(group, index >= 0);
+        return index;
+    }
+
+    public void testEagerGroupIsRegisteredAtLoad() {
+        assertEquals("eager", LazyNatives.getGroupNames()[0]);
+        assertTrue(LazyNatives.getRegistrationNanos()[indexOf("eager")] >= 0);
+    }
+
+    public void testGroupIsRegisteredByFirstUse() {
+        CRC32 crc = new CRC32();
+        crc.update(1);
+        assertTrue(LazyNatives.getRegistrationNanos()[indexOf("zip")] >= 0);
+        // Registering again is harmless.
+        LazyNatives.register("zip");
+        crc.update(2);
+    }
+
+    public void testUnknownGroup() {
+        try {
+            LazyNatives.register("no-such-group");
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+}
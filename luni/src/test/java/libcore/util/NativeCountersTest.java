@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+import java.util.zip.Deflater;
+import java.util.zip.Inflater;
+import junit.framework.TestCase;
+
+public final class NativeCountersTest extends TestCase {
+    public void testSnapshotLayout() {
+        long[] snapshot = NativeCounters.getSnapshot();
+        assertEquals(NativeCounters.COUNTER_COUNT
+                + NativeCounters.HISTOGRAM_COUNT * NativeCounters.HISTOGRAM_BUCKET_COUNT,
+                snapshot.length);
+        assertEquals(snapshot.length - 1, NativeCounters.histogramIndex(
+                NativeCounters.HISTOGRAM_COUNT - 1, NativeCounters.HISTOGRAM_BUCKET_COUNT - 1));
+        for (long count : snapshot) {
+            assertTrue(count >= 0);
+        }
+    }
+
+    public void testZipCounters() throws Exception {
+        byte[] input = new byte[64 * 1024];
+        for (int i = 0; i < input.length; ++i) {
+            input[i] = (byte) (i % 7);
+        }
+        long[] before = NativeCounters.getSnapshot();
+
+        Deflater deflater = new Deflater();
+        deflater.setInput(input);
+        deflater.finish();
+        byte[] compressed = new byte[input.length];
+        int compressedLength = deflater.deflate(compressed);
+        assertTrue(deflater.finished());
+        deflater.end();
+
+        Inflater inflater = new Inflater();
+        inflater.setInput(compressed, 0, compressedLength);
+        byte[] output = new byte[input.length];
+        assertEquals(input.length, inflater.inflate(output));
+        inflater.end();
+
+        // Other threads may be using zlib too, so the counts can only be bounded below.
+        long[] after = NativeCounters.getSnapshot();
+        assertTrue(after[NativeCounters.COUNTER_DEFLATER_BYTES_IN]
+                - before[NativeCounters.COUNTER_DEFLATER_BYTES_IN] >= input.length);
+        assertTrue(after[NativeCounters.COUNTER_DEFLATER_BYTES_OUT]
+                - before[NativeCounters.COUNTER_DEFLATER_BYTES_OUT] >= compressedLength);
+        assertTrue(after[NativeCounters.COUNTER_INFLATER_BYTES_IN]
+                - before[NativeCounters.COUNTER_INFLATER_BYTES_IN] >= compressedLength);
+        assertTrue(after[NativeCounters.COUNTER_INFLATER_BYTES_OUT]
+                - before[NativeCounters.COUNTER_INFLATER_BYTES_OUT] >= input.length);
+    }
+
+    public void testCountsSurviveThreadExit() throws Exception {
+        final byte[] input = new byte[4096];
+        long before = NativeCounters.getSnapshot()[NativeCounters.COUNTER_DEFLATER_BYTES_IN];
+        Thread thread = new Thread() {
+            @Override public void run() {
+                Deflater deflater = new Deflater();
+                deflater.setInput(input);
+                deflater.finish();
+                deflater.deflate(new byte[8192]);
+                deflater.end();
+            }
+        };
+        thread.start();
+        thread.join();
+        long after = NativeCounters.getSnapshot()[NativeCounters.COUNTER_DEFLATER_BYTES_IN];
+        assertTrue(after - before >= input.length);
+    }
+
+    public void testTracing() {
+        // Tracing needs access to the kernel's trace_marker, which tests may not have, but
+        // turning it off must always work.
+        NativeCounters.setTracingEnabled(true);
+        assertFalse(NativeCounters.setTracingEnabled(false));
+    }
+}
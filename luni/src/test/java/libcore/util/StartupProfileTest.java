@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2013 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package libcore.util;
+
+import java.util.Arrays;
+import java.util.List;
+import junit.framework.TestCase;
+
+public final class StartupProfileTest extends TestCase {
+
+    public void testLibraryLoadIsRecorded() {
+        List<String> names = Arrays.asList(StartupProfile.getEventNames());
+        assertTrue(names.toString(), names.contains("JNI_OnLoad"));
+        assertTrue(names.toString(), names.contains("register_libcore_io_Posix"));
+        assertTrue(names.toString(), names.contains("u_init"));
+    }
+
+    public void testEventsArePacked() {
+        String[] names = StartupProfile.getEventNames();
+        long[] events = StartupProfile.getEvents();
+        assertEquals(0, events.length % StartupProfile.FIELD_COUNT);
+        int count = Math.min(names.length, events.length / StartupProfile.FIELD_COUNT);
+        for (int i = 0; i < count; ++i) {
+            int base = i * StartupProfile.FIELD_COUNT;
+            assertTrue(names[i], events[base + StartupProfile.FIELD_START_NANOS] > 0);
+            assertTrue(names[i], events[base + StartupProfile.FIELD_DURATION_NANOS] >= 0);
+            assertTrue(names[i], events[base + StartupProfile.FIELD_TID] > 0);
+        }
+        assertTrue(StartupProfile.getDroppedEventCount() >= 0);
+    }
+
+    public void testNestedStepsEndFirst() {
+        List<String> names = Arrays.asList(StartupProfile.getEventNames());
+        int posix = names.indexOf("register_libcore_io_Posix");
+        int onLoad = names.indexOf("JNI_OnLoad");
+        assertTrue(posix != -1 && onLoad != -1);
+        assertTrue(posix < onLoad);
+    }
+}
@@ -19,10 +19,13 @@ package libcore.xml;
 import com.google.mockwebserver.MockResponse;
 import com.google.mockwebserver.MockWebServer;
 import java.io.ByteArrayInputStream;
+import java.io.File;
+import java.io.FileOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.Reader;
 import java.io.StringReader;
+import java.nio.ByteBuffer;
 import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.HashMap;
@@ -36,6 +39,7 @@ import org.xml.sax.ContentHandler;
 import org.xml.sax.InputSource;
 import org.xml.sax.Locator;
 import org.xml.sax.SAXException;
+import org.xml.sax.SAXNotSupportedException;
 import org.xml.sax.XMLReader;
 import org.xml.sax.ext.DefaultHandler2;
 import org.xml.sax.helpers.DefaultHandler;
@@ -57,6 +61,188 @@ public class ExpatSaxParserTest extends TestCase {
         parse(xml.toString(), new DefaultHandler());
     }
 
+    public void testSharedInterning() throws Exception {
+        final List<String> names = new ArrayList<String>();
+        DefaultHandler handler = new DefaultHandler() {
+            @Override public void startElement(String uri, String localName, String qName,
+                    Attributes attributes) {
+                names.add(localName);
+                names.add(attributes.getLocalName(0));
+            }
+        };
+        ExpatReader reader = new ExpatReader();
+        reader.setSharedInterningEnabled(true);
+        assertTrue(reader.isSharedInterningEnabled());
+        reader.setContentHandler(handler);
+        // The first parse may add these names to the shared table, so
+        // subsequent ones must find them there.
+        String xml = "<sharedInterningTest sharedInterningAttribute='a'/>";
+        reader.parse(new InputSource(new StringReader(xml)));
+        long[] before = ExpatReader.getSharedInternCounters();
+        reader.parse(new InputSource(new StringReader(xml)));
+        long[] after = ExpatReader.getSharedInternCounters();
+        assertTrue(after[0] >= before[0] + 2);
+        assertEquals(Arrays.asList("sharedInterningTest", "sharedInterningAttribute",
+                "sharedInterningTest", "sharedInterningAttribute"), names);
+        assertSame(names.get(0), names.get(2));
+        assertSame("sharedInterningTest", names.get(0));
+    }
+
+    public void testAdjacentTextIsCoalesced() throws Exception {
+        final List<String> chunks = new ArrayList<String>();
+        DefaultHandler handler = new DefaultHandler() {
+            @Override public void characters(char[] ch, int start, int length) {
+                chunks.add(new String(ch, start, length));
+            }
+        };
+        // Expat reports this text in pieces, split at the line break and the
+        // character references.
+        parse("<a>caf\u00e9\nand &amp; &#x1F600;!<b/>tail</a>", handler);
+        assertEquals(Arrays.asList("caf\u00e9\nand & \ud83d\ude00!", "tail"), chunks);
+    }
+
+    public void testAttributeLookups() throws Exception {
+        final List<String> results = new ArrayList<String>();
+        DefaultHandler handler = new DefaultHandler() {
+            @Override public void startElement(String uri, String localName, String qName,
+                    Attributes attributes) {
+                results.add(attributes.getValue("a") + "," + attributes.getValue("p:b")
+                        + "," + attributes.getValue("urn:p", "b") + "," + attributes.getIndex("b")
+                        + "," + attributes.getValue("missing"));
+                assertSame(attributes.getValue("a"), attributes.getValue(0));
+                assertSame(attributes.getQName(1), attributes.getQName(1));
+            }
+        };
+        parse("<e xmlns:p='urn:p' a='one' p:b='two'><e a='three' p:b='four'/></e>", handler);
+        assertEquals(Arrays.asList("one,two,two,1,null", "three,four,four,1,null"), results);
+    }
+
+    public void testEventBatching() throws Exception {
+        StringBuilder xml = new StringBuilder();
+        xml.append("<r xmlns='urn:d' xmlns:p='urn:p' a='1'>");
+        for (int i = 0; i < 2000; ++i) {
+            xml.append("<p:e" + (i % 7) + " p:k='" + i + "' v='caf\u00e9'>t" + i + " &amp;");
+            if (i % 100 == 0) {
+                xml.append("<!--c--><?pi x?>");
+            }
+            xml.append("</p:e" + (i % 7) + ">");
+        }
+        xml.append("</r>");
+
+        List<String> direct = recordEvents(xml.toString(), false);
+        List<String> batched = recordEvents(xml.toString(), true);
+        assertEquals(direct, batched);
+        assertEquals("startPrefixMapping ,urn:d", batched.get(0));
+    }
+
+    private static List<String> recordEvents(String xml, boolean batchEvents) throws Exception {
+        final List<String> events = new ArrayList<String>();
+        DefaultHandler2 handler = new DefaultHandler2() {
+            @Override public void startPrefixMapping(String prefix, String uri) {
+                events.add("startPrefixMapping " + prefix + "," + uri);
+            }
+            @Override public void endPrefixMapping(String prefix) {
+                events.add("endPrefixMapping " + prefix);
+            }
+            @Override public void startElement(String uri, String localName, String qName,
+                    Attributes attributes) {
+                StringBuilder event = new StringBuilder();
+                event.append("startElement ").append(uri).append(",").append(localName)
+                        .append(",").append(qName);
+                for (int i = 0; i < attributes.getLength(); i++) {
+                    event.append(" ").append(attributes.getURI(i)).append(",")
+                            .append(attributes.getLocalName(i)).append(",")
+                            .append(attributes.getQName(i)).append("=")
+                            .append(attributes.getValue(i));
+                }
+                event.append(" k=").append(attributes.getValue("urn:p", "k"));
+                event.append(" v=").append(attributes.getValue("v"));
+                events.add(event.toString());
+            }
+            @Override public void endElement(String uri, String localName, String qName) {
+                events.add("endElement " + uri + "," + localName + "," + qName);
+            }
+            @Override public void characters(char[] ch, int start, int length) {
+                events.add("characters " + new String(ch, start, length));
+            }
+            @Override public void comment(char[] ch, int start, int length) {
+                events.add("comment " + new String(ch, start, length));
+            }
+            @Override public void processingInstruction(String target, String data) {
+                events.add("processingInstruction " + target + " " + data);
+            }
+        };
+        ExpatReader reader = new ExpatReader();
+        reader.setEventBatchingEnabled(batchEvents);
+        reader.setContentHandler(handler);
+        reader.setLexicalHandler(handler);
+        reader.parse(new InputSource(new StringReader(xml)));
+        return events;
+    }
+
+    public void testParseDirectBufferAndMappedFile() throws Exception {
+        byte[] xml = "<a b='c'>d<e/>\u00e9</a>".getBytes("UTF-8");
+        ByteBuffer direct = ByteBuffer.allocateDirect(xml.length + 2);
+        direct.put((byte) ' ').put(xml).flip();
+        direct.position(1);
+        List<String> fromBuffer = recordSaxEvents(direct, null);
+        assertEquals(1, direct.position());
+        assertEquals(recordSaxEvents(ByteBuffer.wrap(xml), null), fromBuffer);
+
+        File file = File.createTempFile("ExpatSaxParserTest", ".xml");
+        try {
+            FileOutputStream out = new FileOutputStream(file);
+            out.write(xml);
+            out.close();
+            assertEquals(fromBuffer, recordSaxEvents(null, file));
+        } finally {
+            file.delete();
+        }
+    }
+
+    public void testNamespacePrefixesRejectedByEveryParse() throws Exception {
+        ExpatReader reader = new ExpatReader();
+        reader.setFeature("http://xml.org/sax/features/namespace-prefixes", true);
+        try {
+            reader.parse(new InputSource(new StringReader(SNIPPET)));
+            fail();
+        } catch (SAXNotSupportedException expected) {
+        }
+        try {
+            reader.parse(ByteBuffer.wrap(SNIPPET.getBytes("UTF-8")), null);
+            fail();
+        } catch (SAXNotSupportedException expected) {
+        }
+        try {
+            reader.parse(new File("/does/not/exist.xml"), null);
+            fail();
+        } catch (SAXNotSupportedException expected) {
+        }
+    }
+
+    private static List<String> recordSaxEvents(ByteBuffer buffer, File file) throws Exception {
+        final List<String> events = new ArrayList<String>();
+        ExpatReader reader = new ExpatReader();
+        reader.setContentHandler(new DefaultHandler() {
+            @Override public void startElement(String uri, String localName, String qName,
+                    Attributes attributes) {
+                events.add("<" + localName + " " + attributes.getValue("b"));
+            }
+            @Override public void endElement(String uri, String localName, String qName) {
+                events.add(">" + localName);
+            }
+            @Override public void characters(char[] ch, int start, int length) {
+                events.add(new String(ch, start, length));
+            }
+        });
+        if (file != null) {
+            reader.parse(file, null);
+        } else {
+            reader.parse(buffer, null);
+        }
+        return events;
+    }
+
     public void testExceptions() {
         // From startElement().
         ContentHandler contentHandler = new DefaultHandler() {
@@ -70,4 +70,29 @@ public class UnsafeTest extends TestCase {
         assertEquals(null, i.s);
         assertEquals(i, i.getThis());
     }
+
+    public void test_allocateInstances() throws Exception {
+        Object[] instances = getUnsafe().allocateInstances(AllocateInstanceTestClass.class, 3);
+        assertEquals(3, instances.length);
+        for (Object instance : instances) {
+            AllocateInstanceTestClass i = (AllocateInstanceTestClass) instance;
+            assertEquals(0, i.i);
+            assertEquals(null, i.s);
+        }
+        assertNotSame(instances[0], instances[1]);
+        assertEquals(0, getUnsafe().allocateInstances(AllocateInstanceTestClass.class, 0).length);
+
+        try {
+            getUnsafe().allocateInstances(AllocateInstanceTestClass.class, -1);
+            fail();
+        } catch (NegativeArraySizeException expected) {
+        }
+        try {
+            getUnsafe().allocateInstances(Runnable.class, 1);
+            fail();
+        } catch (Exception expected) {
+            // Checked, but not declared by the native method.
+            assertTrue(expected instanceof InstantiationException);
+        }
+    }
 }